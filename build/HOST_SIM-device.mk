@@ -0,0 +1,79 @@
+# This target makefile is maintained by hand, unlike the ones generated by mbedUpdater.
+#
+# HOST_SIM builds the mbed 2 library and the application with the host's own GCC into a native Linux executable.
+# The HAL in external/mbed-os/targets/TARGET_HOST_SIM runs interrupt handlers on a POSIX thread and backs the
+# peripherals with host timers, files and pipes so that drivers and samples can be profiled with perf or valgrind and
+# run in CI without hardware. There is no Ethernet MAC (DEVICE_EMAC), so the network stack and the loopback EMAC
+# aren't available.
+
+# Device for which the code should be built.
+MBED_DEVICE        := HOST_SIM
+
+# Can skip parsing of this makefile if user hasn't requested this device.
+ifeq "$(findstring $(MBED_DEVICE),$(DEVICES))" "$(MBED_DEVICE)"
+
+# There is no RTX port for the host so only the single threaded mbed 2 library can be used.
+ifneq "$(MBED_OS_ENABLE)" "0"
+$(error HOST_SIM only supports MBED_OS_ENABLE := 0)
+endif
+
+# Host tools used in place of the arm-none-eabi ones.
+HOST_GCC     ?= gcc
+HOST_GPP     ?= g++
+HOST_AR      ?= ar
+HOST_OBJDUMP ?= objdump
+HOST_SIZE    ?= size
+
+# Compiler flags which are specifc to this device.
+TARGETS_FOR_DEVICE := $(BUILD_TYPE_TARGET) TARGET_HOST_SIM
+FEATURES_FOR_DEVICE := FEATURE_STORAGE
+PERIPHERALS_FOR_DEVICE := DEVICE_FLASH DEVICE_I2C DEVICE_INTERRUPTIN DEVICE_LOWPOWERTIMER DEVICE_SERIAL DEVICE_SLEEP DEVICE_SPI DEVICE_STDIO_MESSAGES DEVICE_STORAGE DEVICE_TRNG
+GCC_DEFINES := $(patsubst %,-D%,$(TARGETS_FOR_DEVICE))
+GCC_DEFINES += $(patsubst %,-D%=1,$(FEATURES_FOR_DEVICE))
+GCC_DEFINES += $(patsubst %,-D%=1,$(PERIPHERALS_FOR_DEVICE))
+# cfstore persists KVs to the simulated storage with the record log backend, so that host runs measure incremental
+# flushes. Set to 0 to use the flash journal backend as the K64F does.
+HOST_SIM_CFSTORE_INCREMENTAL_FLUSH ?= 1
+GCC_DEFINES += -DCFSTORE_INCREMENTAL_FLUSH=$(HOST_SIM_CFSTORE_INCREMENTAL_FLUSH)
+
+# The HAL passes FlashIAP addresses and the drivers' handler ids as uint32_t, so the executable is linked at a fixed
+# address below 4GB rather than as a PIE. HOST_SIM_FLAGS can add -m32 where the host has 32-bit libraries.
+HOST_SIM_FLAGS ?=
+C_FLAGS   := $(HOST_SIM_FLAGS) -pthread -fno-pie
+ASM_FLAGS := $(HOST_SIM_FLAGS)
+LD_FLAGS  := $(HOST_SIM_FLAGS) -pthread -no-pie
+
+# Extra platform specific object files to link into file binary.
+DEVICE_OBJECTS :=
+
+# Version of MRI library to use for this device.
+DEVICE_MRI_LIB :=
+
+# Determine all mbed source folders which are a match for this device so that it only needs to be done once.
+DEVICE_MBED_DIRS := $(call filter_dirs,$(RAW_MBED_DIRS),$(TARGETS_FOR_DEVICE),$(FEATURES_FOR_DEVICE))
+
+# The host's own linker script and C runtime are used.
+DEVICE_NATIVE := 1
+
+include $(GCC4MBED_DIR)/build/device-common.mk
+
+# Tools are scoped to this device so that the ARM devices in the same build keep using arm-none-eabi.
+$(MBED_DEVICE): GCC     := $(HOST_GCC)
+$(MBED_DEVICE): GPP     := $(HOST_GPP)
+$(MBED_DEVICE): AR      := $(HOST_AR)
+$(MBED_DEVICE): LD      := $(HOST_GPP)
+$(MBED_DEVICE): OBJDUMP := $(HOST_OBJDUMP)
+$(MBED_DEVICE): SIZE    := $(HOST_SIZE)
+
+else
+# Have an empty rule for this device since it isn't supported.
+.PHONY: $(MBED_DEVICE)
+
+ifeq "$(OS)" "Windows_NT"
+$(MBED_DEVICE):
+	@REM >nul
+else
+$(MBED_DEVICE):
+	@#
+endif
+endif # ifeq "$(findstring $(MBED_DEVICE),$(DEVICES))"...
@@ -29,9 +29,11 @@ C_FLAGS += -Wall -Wextra -Wno-unused-parameter -Wno-missing-field-initializers -
 C_FLAGS += $(ALL_DEFINES)
 C_FLAGS += $(DEP_FLAGS)
 
+ifneq "$(DEVICE_NATIVE)" "1"
 ifeq "$(NEWLIB_NANO)" "1"
 C_FLAGS += -specs=nano.specs
 endif
+endif
 
 CPP_FLAGS := $(C_FLAGS) -fno-rtti -std=gnu++11 -Wvla
 C_FLAGS   += -std=gnu99
@@ -104,7 +106,10 @@ EXCL_OBJECTS := $(foreach e,$(EXCLUDE),$(call PAT_MATCH,$(e),$(OBJECTS)))
 OBJECTS := $(filter-out $(EXCL_OBJECTS),$(OBJECTS))
 
 # Add in the GCC4MBED stubs which allow hooking in the MRI debug monitor plus other GCC4MBED customization.
+# Native devices start up through the host's C runtime instead.
+ifneq "$(DEVICE_NATIVE)" "1"
 OBJECTS += $(OUTDIR)/gcc4mbed.o
+endif
 
 # Add in device specific object file(s).
 OBJECTS += $(DEVICE_OBJECTS)
@@ -119,8 +124,13 @@ INCLUDE_DIRS := $(patsubst %,-I%,$(INCDIRS) $(MAIN_DIRS) $(LIB_INCLUDES) $(GCC4M
 MAIN_DEFINES := $(DEFINES) -DMRI_ENABLE=$(DEVICE_MRI_ENABLE) -DMRI_INIT_PARAMETERS='"$(MRI_INIT_PARAMETERS)"'
 MAIN_DEFINES += -DMRI_BREAK_ON_INIT=$(MRI_BREAK_ON_INIT) -DMRI_SEMIHOST_STDIO=$(MRI_SEMIHOST_STDIO)
 
-# Libraries to be linked into final binary
-SYS_LIBS  := -lstdc++ -lsupc++ -lm -lgcc -lc -lgcc -lc -lnosys
+# Libraries to be linked into final binary, scoped to this device since native and cross compiled devices link
+# against different C libraries.
+ifeq "$(DEVICE_NATIVE)" "1"
+$(MBED_DEVICE): SYS_LIBS := -lm -lrt
+else
+$(MBED_DEVICE): SYS_LIBS := -lstdc++ -lsupc++ -lm -lgcc -lc -lgcc -lc -lnosys
+endif
 LIBS      := $(LIBS_PREFIX) $(USER_LIBS_FULL)
 
 # mbed library locations depend on build type.
@@ -160,6 +170,21 @@ GCC4MBED_WRAPS := ,--wrap=_isatty
 MBED_WRAPS := ,--wrap=_malloc_r,--wrap=_free_r,--wrap=_realloc_r,--wrap=_calloc_r,--wrap=main,--wrap=exit
 
 
+ifeq "$(DEVICE_NATIVE)" "1"
+# Native devices link against the host's C library so only main() is wrapped, to run mbed_main() and move thread mode
+# onto a stack below 4GB, along with fopen() so that Streams and mbed file systems can be opened.
+$(MBED_DEVICE): LD_FLAGS := $(LD_FLAGS) -Wl,-Map=$(OUTDIR)/$(PROJECT).map,--cref,--gc-sections,--wrap=main,--wrap=fopen
+
+.PHONY: $(MBED_DEVICE) $(MBED_DEVICE)-clean $(MBED_DEVICE)-size
+
+$(MBED_DEVICE): $(OUTDIR)/$(PROJECT).elf $(MBED_DEVICE)-size
+
+$(OUTDIR)/$(PROJECT).elf: $(OBJECTS) $(LIBS) $(MBED_EXTRA_LIBS)
+	@echo Linking $@
+	$(Q) $(MKDIR) $(call convert-slash,$(dir $@)) $(QUIET)
+	$(Q) $(LD) $(LD_FLAGS) $(call all_objs_from_mbed,$+) $(SYS_LIBS) -o $@
+
+else
 # Linker Options.
 $(MBED_DEVICE): LD_FLAGS := $(LD_FLAGS) -specs=$(GCC4MBED_DIR)/build/startfile.spec
 $(MBED_DEVICE): LD_FLAGS += -Wl,-Map=$(OUTDIR)/$(PROJECT).map,--cref,--gc-sections,-zmuldefs$(GCC4MBED_WRAPS)$(MBED_WRAPS)$(MRI_WRAPS)
@@ -201,6 +226,7 @@ $(OUTDIR)/$(PROJECT).ld: $(LSCRIPT)
 	@echo Preprocessing $<
 	$(Q) $(MKDIR) $(call convert-slash,$(dir $@)) $(QUIET)
 	$(Q) $(GCC) -E -P  $(ALL_DEFINES) -x c $< -o $@
+endif
 
 $(MBED_DEVICE)-size: $(OUTDIR)/$(PROJECT).elf
 	$(Q) $(SIZE) $<
@@ -337,3 +363,7 @@ $(MBED_DEVICE): MBED_INCLUDES := $(patsubst %,-I%,$(MBED_INCLUDES))
 
 # Do the same for the user libraries.
 $(MBED_DEVICE): LIB_INCLUDES  := $(patsubst %,-I%,$(LIB_INCLUDES))
+
+
+# The next device makefile starts out as a cross compiled one again.
+DEVICE_NATIVE :=
@@ -349,17 +349,17 @@ define build_mbed_lib #,libname,source_dirs,include_dirs
     $$(DEBUG_LIB): $$(DEBUG_OBJECTS)
 		@echo Linking debug library $$@
 		$(Q) $(MKDIR) $$(call convert-slash,$$(dir $$@)) $(QUIET)
-		$(Q) $(AR) -rc $$@ $$+
+		$(Q) $$(AR) -rc $$@ $$+
 
     $$(DEVELOP_LIB): $$(DEVELOP_OBJECTS)
 		@echo Linking develop library $$@
 		$(Q) $(MKDIR) $$(call convert-slash,$$(dir $$@)) $(QUIET)
-		$(Q) $(AR) -rc $$@ $$+
+		$(Q) $$(AR) -rc $$@ $$+
 
     $$(RELEASE_LIB): $$(RELEASE_OBJECTS)
 		@echo Linking release library $$@
 		$(Q) $(MKDIR) $$(call convert-slash,$$(dir $$@)) $(QUIET)
-		$(Q) $(AR) -rc $$@ $$+
+		$(Q) $$(AR) -rc $$@ $$+
 
 endef
 
@@ -415,17 +415,17 @@ define build_user_lib #,lib_dir
     $$(DEBUG_LIB): $$(DEBUG_OBJECTS)
 		@echo Linking debug library $$@
 		$(Q) $(MKDIR) $$(call convert-slash,$$(dir $$@)) $(QUIET)
-		$(Q) $(AR) -rc $$@ $$+
+		$(Q) $$(AR) -rc $$@ $$+
 
     $$(DEVELOP_LIB): $$(DEVELOP_OBJECTS)
 		@echo Linking develop library $$@
 		$(Q) $(MKDIR) $$(call convert-slash,$$(dir $$@)) $(QUIET)
-		$(Q) $(AR) -rc $$@ $$+
+		$(Q) $$(AR) -rc $$@ $$+
 
     $$(RELEASE_LIB): $$(RELEASE_OBJECTS)
 		@echo Linking release library $$@
 		$(Q) $(MKDIR) $$(call convert-slash,$$(dir $$@)) $(QUIET)
-		$(Q) $(AR) -rc $$@ $$+
+		$(Q) $$(AR) -rc $$@ $$+
 
     #########################################################################
     #  Default rules to compile c/c++/assembly language sources to objects.
@@ -0,0 +1,96 @@
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+
+using namespace utest::v1;
+
+
+// Function objects of one, two and three words, the last two of which
+// used to need boxing on the heap to be attached
+struct OneWord {
+    int *a;
+    int operator()() const { return *a; }
+};
+
+struct TwoWords {
+    int *a;
+    int *b;
+    int operator()(int x) const { return *a + *b + x; }
+};
+
+struct Counter {
+    int *a;
+    int *b;
+    int count;
+    int operator()(int x, int y) { return *a + *b + x + y + count++; }
+};
+
+static int static_func() { return 0x80; }
+
+
+void test_two_words() {
+    int a = 1, b = 2;
+    TwoWords f = { &a, &b };
+    Callback<int(int)> cb(f);
+    TEST_ASSERT_EQUAL(cb(4), 7);
+
+    a = 8;
+    TEST_ASSERT_EQUAL(cb(4), 14);
+}
+
+void test_member_sized() {
+    int a = 1, b = 2;
+    Counter f = { &a, &b, 0 };
+    Callback<int(int, int)> cb(f);
+    TEST_ASSERT_EQUAL(cb(4, 8), 15);
+    TEST_ASSERT_EQUAL(cb(4, 8), 16);
+
+    // A copy takes the state with it
+    Callback<int(int, int)> copy = cb;
+    TEST_ASSERT_EQUAL(copy(4, 8), 17);
+    TEST_ASSERT_EQUAL(cb(4, 8), 17);
+}
+
+void test_storage_size() {
+    TEST_ASSERT(sizeof(Callback<void()>) - sizeof(void*) >= sizeof(Counter));
+    TEST_ASSERT(sizeof(Callback<void()>) - sizeof(void*) >= MBED_CONF_PLATFORM_CALLBACK_INLINE_SIZE);
+}
+
+void test_equality() {
+    int a = 1, b = 2;
+    Callback<int()> s1(static_func), s2(static_func);
+    Callback<int()> n1, n2;
+    TEST_ASSERT(s1 == s2);
+    TEST_ASSERT(n1 == n2);
+    TEST_ASSERT(s1 != n1);
+
+    OneWord f = { &a };
+    Callback<int()> o1(f);
+    Callback<int()> o2 = o1;
+    TEST_ASSERT(o1 == o2);
+
+    OneWord g = { &b };
+    o2 = g;
+    TEST_ASSERT(o1 != o2);
+}
+
+
+// Test setup
+utest::v1::status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(10, "default_auto");
+    return verbose_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("Testing two word function objects", test_two_words),
+    Case("Testing member function sized function objects", test_member_sized),
+    Case("Testing callback storage size", test_storage_size),
+    Case("Testing callback equality", test_equality),
+};
+
+Specification specification(test_setup, cases);
+
+int main() {
+    return !Harness::run(specification);
+}
@@ -0,0 +1,174 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+
+#include "mbedtls_arena.h"
+
+#include <string.h>
+
+using namespace utest::v1;
+
+#define ARENA_SIZE 2048
+#define ARENA_BLOCKS 32
+
+static uint64_t arena_buffer[ARENA_SIZE / sizeof(uint64_t)];
+static mbedtls_arena arena;
+
+static size_t arena_largest_free()
+{
+    mbedtls_arena_stats stats;
+    mbedtls_arena_get_stats(&arena, &stats);
+    return stats.largest_free;
+}
+
+void test_arena_init()
+{
+    char small[8];
+    TEST_ASSERT_EQUAL(-1, mbedtls_arena_init(&arena, small, sizeof(small)));
+    TEST_ASSERT_EQUAL(NULL, mbedtls_arena_calloc(&arena, 1, 1));
+
+    TEST_ASSERT_EQUAL(0, mbedtls_arena_init(&arena, arena_buffer, sizeof(arena_buffer)));
+
+    mbedtls_arena_stats stats;
+    mbedtls_arena_get_stats(&arena, &stats);
+    TEST_ASSERT(stats.size > 0 && stats.size <= sizeof(arena_buffer));
+    TEST_ASSERT(stats.largest_free < stats.size);
+    TEST_ASSERT_EQUAL(0, stats.current);
+    TEST_ASSERT_EQUAL(0, stats.blocks);
+}
+
+void test_arena_calloc()
+{
+    memset(arena_buffer, 0xA5, sizeof(arena_buffer));
+    TEST_ASSERT_EQUAL(0, mbedtls_arena_init(&arena, arena_buffer, sizeof(arena_buffer)));
+
+    uint8_t *a = (uint8_t *)mbedtls_arena_calloc(&arena, 3, 7);
+    uint8_t *b = (uint8_t *)mbedtls_arena_calloc(&arena, 1, 100);
+    TEST_ASSERT_NOT_EQUAL(NULL, a);
+    TEST_ASSERT_NOT_EQUAL(NULL, b);
+    TEST_ASSERT_EQUAL(0, (uintptr_t)a & 7);
+    TEST_ASSERT_EQUAL(0, (uintptr_t)b & 7);
+    TEST_ASSERT(mbedtls_arena_owns(&arena, a));
+    TEST_ASSERT(mbedtls_arena_owns(&arena, b));
+    TEST_ASSERT(!mbedtls_arena_owns(&arena, &arena));
+
+    for (int i = 0; i < 21; i++) {
+        TEST_ASSERT_EQUAL(0, a[i]);
+    }
+    for (int i = 0; i < 100; i++) {
+        TEST_ASSERT_EQUAL(0, b[i]);
+    }
+
+    mbedtls_arena_stats stats;
+    mbedtls_arena_get_stats(&arena, &stats);
+    TEST_ASSERT_EQUAL(2, stats.blocks);
+    TEST_ASSERT(stats.current >= 121);
+    TEST_ASSERT_EQUAL(stats.current, stats.peak);
+
+    // Empty and overflowing requests
+    TEST_ASSERT_EQUAL(NULL, mbedtls_arena_calloc(&arena, 0, 16));
+    TEST_ASSERT_EQUAL(NULL, mbedtls_arena_calloc(&arena, SIZE_MAX / 2, 4));
+    TEST_ASSERT_EQUAL(NULL, mbedtls_arena_calloc(&arena, 1, ARENA_SIZE));
+    mbedtls_arena_get_stats(&arena, &stats);
+    TEST_ASSERT_EQUAL(2, stats.failures);
+
+    mbedtls_arena_free(&arena, a);
+    mbedtls_arena_free(&arena, b);
+    mbedtls_arena_get_stats(&arena, &stats);
+    TEST_ASSERT_EQUAL(0, stats.current);
+    TEST_ASSERT_EQUAL(0, stats.blocks);
+    TEST_ASSERT(stats.peak >= 121);
+}
+
+void test_arena_coalesce()
+{
+    TEST_ASSERT_EQUAL(0, mbedtls_arena_init(&arena, arena_buffer, sizeof(arena_buffer)));
+    size_t full = arena_largest_free();
+
+    // Fill the arena, then free every other block and the rest in reverse so
+    // that blocks are merged with both their neighbours
+    void *blocks[ARENA_BLOCKS];
+    for (int i = 0; i < ARENA_BLOCKS; i++) {
+        blocks[i] = mbedtls_arena_calloc(&arena, 1, 24 + 8 * (i % 4));
+        TEST_ASSERT_NOT_EQUAL(NULL, blocks[i]);
+    }
+    for (int i = 0; i < ARENA_BLOCKS; i += 2) {
+        mbedtls_arena_free(&arena, blocks[i]);
+    }
+    TEST_ASSERT(arena_largest_free() < full);
+    for (int i = ARENA_BLOCKS - 1; i > 0; i -= 2) {
+        mbedtls_arena_free(&arena, blocks[i]);
+    }
+    TEST_ASSERT_EQUAL(full, arena_largest_free());
+
+    // Freeing foreign memory is ignored
+    mbedtls_arena_free(&arena, &arena);
+    mbedtls_arena_free(&arena, NULL);
+    TEST_ASSERT_EQUAL(full, arena_largest_free());
+}
+
+void test_arena_reset()
+{
+    TEST_ASSERT_EQUAL(0, mbedtls_arena_init(&arena, arena_buffer, sizeof(arena_buffer)));
+    size_t full = arena_largest_free();
+
+    // Leaked blocks are all released in one go
+    for (int i = 0; i < ARENA_BLOCKS; i++) {
+        TEST_ASSERT_NOT_EQUAL(NULL, mbedtls_arena_calloc(&arena, 1, 40));
+    }
+
+    mbedtls_arena_stats stats;
+    mbedtls_arena_get_stats(&arena, &stats);
+    size_t peak = stats.peak;
+
+    mbedtls_arena_reset(&arena);
+    mbedtls_arena_get_stats(&arena, &stats);
+    TEST_ASSERT_EQUAL(0, stats.current);
+    TEST_ASSERT_EQUAL(0, stats.blocks);
+    TEST_ASSERT_EQUAL(peak, stats.peak);
+    TEST_ASSERT_EQUAL(full, stats.largest_free);
+
+    mbedtls_arena_reset_peak(&arena);
+    mbedtls_arena_get_stats(&arena, &stats);
+    TEST_ASSERT_EQUAL(0, stats.peak);
+
+    // The whole arena is available again
+    void *all = mbedtls_arena_calloc(&arena, 1, full);
+    TEST_ASSERT_NOT_EQUAL(NULL, all);
+    mbedtls_arena_free(&arena, all);
+}
+
+Case cases[] = {
+    Case("mbedtls_arena_init", test_arena_init),
+    Case("mbedtls_arena_calloc", test_arena_calloc),
+    Case("mbedtls_arena_coalesce", test_arena_coalesce),
+    Case("mbedtls_arena_reset", test_arena_reset),
+};
+
+utest::v1::status_t test_setup(const size_t num_cases) {
+    GREENTEA_SETUP(20, "default_auto");
+    return verbose_test_setup_handler(num_cases);
+}
+
+Specification specification(test_setup, cases);
+
+int main() {
+    return !Harness::run(specification);
+}
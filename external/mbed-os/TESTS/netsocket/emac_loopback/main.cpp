@@ -0,0 +1,203 @@
+#if !DEVICE_EMAC
+    #error [NOT_SUPPORTED] EMAC not supported for this target
+#endif
+
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+#include "emac_api.h"
+#include "emac_stack_mem.h"
+#include "emac_loopback.h"
+
+using namespace utest::v1;
+
+
+// Frames received on port 1
+static int received_frames;
+static uint32_t received_len;
+static uint8_t received_data[EMAC_LOOPBACK_MAX_MTU + EMAC_LOOPBACK_HEADER_SIZE];
+
+static void link_input(void *data, emac_stack_mem_chain_t *chain)
+{
+    emac_stack_mem_t *mem = emac_stack_mem_chain_dequeue(NULL, &chain);
+    received_len = emac_stack_mem_len(NULL, mem);
+    memcpy(received_data, emac_stack_mem_ptr(NULL, mem), received_len);
+    received_frames++;
+    emac_stack_mem_free(NULL, mem);
+}
+
+static bool send_frame(emac_interface_t *emac, uint32_t len, uint8_t fill)
+{
+    emac_stack_mem_t *mem = emac_stack_mem_alloc(NULL, len, 0);
+    TEST_ASSERT_NOT_NULL(mem);
+    memset(emac_stack_mem_ptr(NULL, mem), fill, len);
+    emac_stack_mem_set_len(NULL, mem, len);
+    bool ret = emac->ops.link_out(emac, mem);
+    emac_stack_mem_free(NULL, mem);
+    return ret;
+}
+
+static bool send_data(emac_interface_t *emac, const uint8_t *data, uint32_t len)
+{
+    emac_stack_mem_t *mem = emac_stack_mem_alloc(NULL, len, 0);
+    TEST_ASSERT_NOT_NULL(mem);
+    memcpy(emac_stack_mem_ptr(NULL, mem), data, len);
+    emac_stack_mem_set_len(NULL, mem, len);
+    bool ret = emac->ops.link_out(emac, mem);
+    emac_stack_mem_free(NULL, mem);
+    return ret;
+}
+
+static emac_interface_t *setup_link(const emac_loopback_config_t *config)
+{
+    emac_loopback_configure(config);
+    emac_loopback_reset();
+    received_frames = 0;
+    received_len = 0;
+
+    emac_interface_t *a = emac_loopback_get_interface(0);
+    emac_interface_t *b = emac_loopback_get_interface(1);
+    b->ops.set_link_input_cb(b, link_input, NULL);
+    TEST_ASSERT(a->ops.power_up(a));
+    TEST_ASSERT(b->ops.power_up(b));
+    return a;
+}
+
+
+// Test cases
+void test_loopback_delivery() {
+    emac_interface_t *a = setup_link(NULL);
+
+    TEST_ASSERT(send_frame(a, 60, 0xA5));
+    TEST_ASSERT_EQUAL(1, emac_loopback_poll());
+    TEST_ASSERT_EQUAL(1, received_frames);
+    TEST_ASSERT_EQUAL(60, received_len);
+    TEST_ASSERT_EQUAL_HEX8(0xA5, received_data[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xA5, received_data[59]);
+}
+
+void test_loopback_mtu() {
+    emac_loopback_config_t config = {576, 0, 0, 1};
+    emac_interface_t *a = setup_link(&config);
+
+    TEST_ASSERT_EQUAL(576, a->ops.get_mtu_size(a));
+    TEST_ASSERT(send_frame(a, 576 + EMAC_LOOPBACK_HEADER_SIZE, 0x11));
+    TEST_ASSERT(!send_frame(a, 577 + EMAC_LOOPBACK_HEADER_SIZE, 0x22));
+
+    emac_loopback_stats_t stats;
+    emac_loopback_get_stats(0, &stats);
+    TEST_ASSERT_EQUAL(1, stats.tx_frames);
+    TEST_ASSERT_EQUAL(1, stats.tx_oversize);
+}
+
+void test_loopback_latency() {
+    emac_loopback_config_t config = {EMAC_LOOPBACK_MAX_MTU, 20000, 0, 1};
+    emac_interface_t *a = setup_link(&config);
+
+    TEST_ASSERT(send_frame(a, 100, 0x33));
+    TEST_ASSERT_EQUAL(0, emac_loopback_poll());
+    wait_ms(25);
+    TEST_ASSERT_EQUAL(1, emac_loopback_poll());
+}
+
+void test_loopback_loss() {
+    emac_loopback_config_t config = {EMAC_LOOPBACK_MAX_MTU, 0, 250000, 0x12345678};
+    emac_interface_t *a = setup_link(&config);
+
+    for (int i = 0; i < 400; i++) {
+        send_frame(a, 64, i);
+        emac_loopback_poll();
+    }
+
+    emac_loopback_stats_t stats;
+    emac_loopback_get_stats(0, &stats);
+    TEST_ASSERT_EQUAL(400, stats.tx_frames + stats.tx_lost);
+    TEST_ASSERT_INT_WITHIN(50, 100, stats.tx_lost);
+    TEST_ASSERT_EQUAL(stats.tx_frames, received_frames);
+}
+
+void test_loopback_overflow() {
+    emac_interface_t *a = setup_link(NULL);
+
+    int sent = 0;
+    while (send_frame(a, 64, 0x44)) {
+        sent++;
+    }
+    TEST_ASSERT_EQUAL(EMAC_LOOPBACK_QUEUE_LEN - 1, sent);
+    TEST_ASSERT_EQUAL(sent, emac_loopback_poll());
+}
+
+void test_loopback_reflect() {
+    static const uint8_t port0_mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+    static const uint8_t port1_mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02};
+    static const uint8_t local_ip[4] = {10, 0, 0, 1};
+    static const uint8_t peer_ip[4] = {10, 0, 0, 2};
+    emac_interface_t *a = setup_link(NULL);
+    a->ops.set_link_input_cb(a, link_input, NULL);
+    emac_loopback_set_reflect(1, true);
+
+    // ARP request for the peer is answered with port 1's MAC
+    uint8_t arp[42] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+    memcpy(&arp[6], port0_mac, 6);
+    arp[12] = 0x08; arp[13] = 0x06;
+    arp[14] = 0x00; arp[15] = 0x01; arp[16] = 0x08; arp[17] = 0x00;
+    arp[18] = 6; arp[19] = 4; arp[20] = 0x00; arp[21] = 0x01;
+    memcpy(&arp[22], port0_mac, 6);
+    memcpy(&arp[28], local_ip, 4);
+    memcpy(&arp[38], peer_ip, 4);
+    TEST_ASSERT(send_data(a, arp, sizeof(arp)));
+    TEST_ASSERT_EQUAL(1, emac_loopback_poll());
+    TEST_ASSERT_EQUAL(1, emac_loopback_poll());
+    TEST_ASSERT_EQUAL(1, received_frames);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(port0_mac, &received_data[0], 6);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(port1_mac, &received_data[6], 6);
+    TEST_ASSERT_EQUAL_HEX8(0x02, received_data[21]);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(port1_mac, &received_data[22], 6);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(peer_ip, &received_data[28], 4);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(port0_mac, &received_data[32], 6);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(local_ip, &received_data[38], 4);
+
+    // IPv4 to the peer comes back from it, with the payload untouched
+    uint8_t ip[60] = {0};
+    memcpy(&ip[0], port1_mac, 6);
+    memcpy(&ip[6], port0_mac, 6);
+    ip[12] = 0x08; ip[13] = 0x00;
+    ip[14] = 0x45;
+    memcpy(&ip[26], local_ip, 4);
+    memcpy(&ip[30], peer_ip, 4);
+    ip[59] = 0x5A;
+    TEST_ASSERT(send_data(a, ip, sizeof(ip)));
+    emac_loopback_poll();
+    emac_loopback_poll();
+    TEST_ASSERT_EQUAL(2, received_frames);
+    TEST_ASSERT_EQUAL(sizeof(ip), received_len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(port0_mac, &received_data[0], 6);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(peer_ip, &received_data[26], 4);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(local_ip, &received_data[30], 4);
+    TEST_ASSERT_EQUAL_HEX8(0x5A, received_data[59]);
+
+    emac_loopback_set_reflect(1, false);
+}
+
+
+// Test setup
+utest::v1::status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(20, "default_auto");
+    return verbose_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("Loopback delivery", test_loopback_delivery),
+    Case("Loopback MTU", test_loopback_mtu),
+    Case("Loopback latency", test_loopback_latency),
+    Case("Loopback loss", test_loopback_loss),
+    Case("Loopback overflow", test_loopback_overflow),
+    Case("Loopback reflect", test_loopback_reflect),
+};
+
+Specification specification(test_setup, cases);
+
+int main() {
+    return !Harness::run(specification);
+}
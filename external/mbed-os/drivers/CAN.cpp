@@ -31,7 +31,7 @@ CAN::CAN(PinName rd, PinName td) : _can(), _irq() {
     }
 
     can_init(&_can, rd, td);
-    can_irq_init(&_can, (&CAN::_irq_handler), (uint32_t)this);
+    can_irq_init(&_can, (&CAN::_irq_handler), (uint32_t)(uintptr_t)this);
 }
 
 CAN::~CAN() {
@@ -114,7 +114,7 @@ void CAN::attach(Callback<void()> func, IrqType type) {
 }
 
 void CAN::_irq_handler(uint32_t id, CanIrqType type) {
-    CAN *handler = (CAN*)id;
+    CAN *handler = (CAN*)(uintptr_t)id;
     handler->_irq[type].call();
 }
 
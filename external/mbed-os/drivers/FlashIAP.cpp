@@ -76,7 +76,7 @@ int FlashIAP::deinit()
 int FlashIAP::read(void *buffer, uint32_t addr, uint32_t size)
 {
     _mutex->lock();
-    memcpy(buffer, (const void *)addr, size);
+    memcpy(buffer, (const void *)(uintptr_t)addr, size);
     _mutex->unlock();
     return 0;
 }
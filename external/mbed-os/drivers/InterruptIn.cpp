@@ -30,7 +30,7 @@ InterruptIn::InterruptIn(PinName pin) : gpio(),
     _rise = donothing;
     _fall = donothing;
 
-    gpio_irq_init(&gpio_irq, pin, (&InterruptIn::_irq_handler), (uint32_t)this);
+    gpio_irq_init(&gpio_irq, pin, (&InterruptIn::_irq_handler), (uint32_t)(uintptr_t)this);
     gpio_init_in(&gpio, pin);
 }
 
@@ -75,7 +75,7 @@ void InterruptIn::fall(Callback<void()> func) {
 }
 
 void InterruptIn::_irq_handler(uint32_t id, gpio_irq_event event) {
-    InterruptIn *handler = (InterruptIn*)id;
+    InterruptIn *handler = (InterruptIn*)(uintptr_t)id;
     switch (event) {
         case IRQ_RISE: handler->_rise(); break;
         case IRQ_FALL: handler->_fall(); break;
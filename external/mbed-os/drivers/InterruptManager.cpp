@@ -20,8 +20,6 @@
 #include "platform/mbed_critical.h"
 #include <string.h>
 
-#define CHAIN_INITIAL_SIZE    4
-
 namespace mbed {
 
 typedef void (*pvoidf)(void);
@@ -51,7 +49,7 @@ InterruptManager* InterruptManager::get() {
 
 InterruptManager::InterruptManager() {
     // No mutex needed in constructor
-    memset(_chains, 0, NVIC_NUM_VECTORS * sizeof(CallChain*));
+    memset(_chains, 0, NVIC_NUM_VECTORS * sizeof(IrqChain*));
 }
 
 void InterruptManager::destroy() {
@@ -76,8 +74,13 @@ bool InterruptManager::must_replace_vector(IRQn_Type irq) {
     int ret = false;
     int irq_pos = get_irq_index(irq);
     if (NULL == _chains[irq_pos]) {
-        _chains[irq_pos] = new CallChain(CHAIN_INITIAL_SIZE);
-        _chains[irq_pos]->add((pvoidf)NVIC_GetVector(irq));
+        _chains[irq_pos] = new IrqChain();
+    }
+    IrqChain *entry = _chains[irq_pos];
+    if (NULL == entry->chain.get(0)) {
+        entry->vector = NVIC_GetVector(irq);
+        entry->vector_link.cb = (pvoidf)entry->vector;
+        entry->chain.add(&entry->vector_link);
         ret = true;
     }
     unlock();
@@ -89,9 +92,21 @@ pFunctionPointer_t InterruptManager::add_common(void (*function)(void), IRQn_Typ
     int irq_pos = get_irq_index(irq);
     bool change = must_replace_vector(irq);
 
-    pFunctionPointer_t pf = front ? _chains[irq_pos]->add_front(function) : _chains[irq_pos]->add(function);
+    pFunctionPointer_t pf = front ? _chains[irq_pos]->chain.add_front(function) : _chains[irq_pos]->chain.add(function);
     if (change)
-        NVIC_SetVector(irq, (uint32_t)&InterruptManager::static_irq_helper);
+        NVIC_SetVector(irq, (uintptr_t)&InterruptManager::static_irq_helper);
+    unlock();
+    return pf;
+}
+
+pFunctionPointer_t InterruptManager::add_common(CallChainLink *link, IRQn_Type irq, bool front) {
+    lock();
+    int irq_pos = get_irq_index(irq);
+    bool change = must_replace_vector(irq);
+
+    pFunctionPointer_t pf = front ? _chains[irq_pos]->chain.add_front(link) : _chains[irq_pos]->chain.add(link);
+    if (change)
+        NVIC_SetVector(irq, (uintptr_t)&InterruptManager::static_irq_helper);
     unlock();
     return pf;
 }
@@ -101,8 +116,9 @@ bool InterruptManager::remove_handler(pFunctionPointer_t handler, IRQn_Type irq)
     bool ret = false;
 
     lock();
-    if (_chains[irq_pos] != NULL) {
-        if (_chains[irq_pos]->remove(handler)) {
+    if (_chains[irq_pos] != NULL && handler != &_chains[irq_pos]->vector_link.cb) {
+        if (_chains[irq_pos]->chain.remove(handler)) {
+            restore_vector(irq);
             ret = true;
         }
     }
@@ -111,8 +127,19 @@ bool InterruptManager::remove_handler(pFunctionPointer_t handler, IRQn_Type irq)
     return ret;
 }
 
+void InterruptManager::restore_vector(IRQn_Type irq) {
+    IrqChain *entry = _chains[get_irq_index(irq)];
+
+    // Nothing is left but the vector the chain replaced, so take the chain
+    // out of the way. The next handler added puts it back.
+    if (entry->chain.get(1) == NULL) {
+        NVIC_SetVector(irq, entry->vector);
+        entry->chain.remove(&entry->vector_link);
+    }
+}
+
 void InterruptManager::irq_helper() {
-    _chains[__get_IPSR()]->call();
+    _chains[__get_IPSR()]->chain.call();
 }
 
 int InterruptManager::get_irq_index(IRQn_Type irq) {
@@ -121,7 +148,8 @@ int InterruptManager::get_irq_index(IRQn_Type irq) {
 }
 
 void InterruptManager::static_irq_helper() {
-    InterruptManager::get()->irq_helper();
+    // Only installed once the instance exists
+    _instance->irq_helper();
 }
 
 void InterruptManager::lock() {
@@ -26,6 +26,10 @@ namespace mbed {
 /** @{*/
 
 /** Use this singleton if you need to chain interrupt handlers.
+ *
+ * The interrupt vector only points at the chain while it holds handlers added
+ * here. Once they have all been removed the handler which was in the vector
+ * before is put back, so that it is entered directly again.
  *
  * @Note Synchronization level: Thread safe
  *
@@ -119,6 +123,36 @@ public:
         return add_common(tptr, mptr, irq, true);
     }
 
+    /** Add a handler for an interrupt at the end of the handler list, in a
+     *  link provided by the caller so that nothing is allocated for it
+     *
+     *  @param link the link holding the handler, which must not already be in
+     *  a chain and must stay valid until it is removed
+     *  @param irq interrupt number
+     *
+     *  @returns
+     *  The function object in 'link'
+     */
+    pFunctionPointer_t add_handler(CallChainLink *link, IRQn_Type irq) {
+        // Underlying call is thread safe
+        return add_common(link, irq);
+    }
+
+    /** Add a handler for an interrupt at the beginning of the handler list, in
+     *  a link provided by the caller so that nothing is allocated for it
+     *
+     *  @param link the link holding the handler, which must not already be in
+     *  a chain and must stay valid until it is removed
+     *  @param irq interrupt number
+     *
+     *  @returns
+     *  The function object in 'link'
+     */
+    pFunctionPointer_t add_handler_front(CallChainLink *link, IRQn_Type irq) {
+        // Underlying call is thread safe
+        return add_common(link, irq, true);
+    }
+
     /** Remove a handler from an interrupt
      *
      *  @param handler the function object for the handler to remove
@@ -148,21 +182,32 @@ private:
         int irq_pos = get_irq_index(irq);
         bool change = must_replace_vector(irq);
 
-        pFunctionPointer_t pf = front ? _chains[irq_pos]->add_front(tptr, mptr) : _chains[irq_pos]->add(tptr, mptr);
+        CallChain *chain = &_chains[irq_pos]->chain;
+        pFunctionPointer_t pf = front ? chain->add_front(callback(tptr, mptr)) : chain->add(callback(tptr, mptr));
         if (change)
-            NVIC_SetVector(irq, (uint32_t)&InterruptManager::static_irq_helper);
+            NVIC_SetVector(irq, (uintptr_t)&InterruptManager::static_irq_helper);
         _mutex.unlock();
         return pf;
     }
 
     pFunctionPointer_t add_common(void (*function)(void), IRQn_Type irq, bool front=false);
+    pFunctionPointer_t add_common(CallChainLink *link, IRQn_Type irq, bool front=false);
     bool must_replace_vector(IRQn_Type irq);
+    void restore_vector(IRQn_Type irq);
     int get_irq_index(IRQn_Type irq);
     void irq_helper();
     void add_helper(void (*function)(void), IRQn_Type irq, bool front=false);
     static void static_irq_helper();
 
-    CallChain* _chains[NVIC_NUM_VECTORS];
+    // Handlers for an interrupt, starting with the vector they replaced,
+    // allocated together the first time a handler is added
+    struct IrqChain {
+        CallChainLink vector_link;
+        uintptr_t vector;
+        CallChain chain;
+    };
+
+    IrqChain* _chains[NVIC_NUM_VECTORS];
     static InterruptManager* _instance;
     PlatformMutex _mutex;
 };
@@ -16,6 +16,7 @@
 #include "drivers/RawSerial.h"
 #include "platform/mbed_wait_api.h"
 #include <cstdarg>
+#include <cstring>
 
 #if DEVICE_SERIAL
 
@@ -43,8 +44,7 @@ int RawSerial::putc(int c) {
 
 int RawSerial::puts(const char *str) {
     lock();
-    while (*str)
-        putc(*str ++);
+    _base_write(str, strlen(str));
     unlock();
     return 0;
 }
@@ -36,6 +36,16 @@ int Serial::_putc(int c) {
     return _base_putc(c);
 }
 
+ssize_t Serial::_write_block(const void* buffer, size_t length) {
+    // Mutex is already held
+    return _base_write(buffer, length);
+}
+
+ssize_t Serial::_read_block(void* buffer, size_t length) {
+    // Mutex is already held
+    return _base_read(buffer, length);
+}
+
 void Serial::lock() {
     _mutex.lock();
 }
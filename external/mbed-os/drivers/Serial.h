@@ -84,6 +84,8 @@ public:
 protected:
     virtual int _getc();
     virtual int _putc(int c);
+    virtual ssize_t _write_block(const void* buffer, size_t length);
+    virtual ssize_t _read_block(void* buffer, size_t length);
     virtual void lock();
     virtual void unlock();
 
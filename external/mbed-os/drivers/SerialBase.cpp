@@ -16,6 +16,7 @@
 #include "drivers/SerialBase.h"
 #include "platform/mbed_wait_api.h"
 #include "platform/mbed_critical.h"
+#include "platform/mbed_stdio_tx.h"
 
 #if DEVICE_SERIAL
 
@@ -35,9 +36,15 @@ SerialBase::SerialBase(PinName tx, PinName rx, int baud) :
         _irq[i] = donothing;
     }
 
+#if MBED_CONF_PLATFORM_STDIO_BUFFERED_SERIAL
+    // Our handler is about to replace the one sending buffered console output
+    if (tx == STDIO_UART_TX) {
+        mbed_stdio_tx_release_irq();
+    }
+#endif
     serial_init(&_serial, tx, rx);
     serial_baud(&_serial, _baud);
-    serial_irq_handler(&_serial, SerialBase::_irq_handler, (uint32_t)this);
+    serial_irq_handler(&_serial, SerialBase::_irq_handler, (uint32_t)(uintptr_t)this);
 }
 
 void SerialBase::baud(int baudrate) {
@@ -84,7 +91,7 @@ void SerialBase::attach(Callback<void()> func, IrqType type) {
 }
 
 void SerialBase::_irq_handler(uint32_t id, SerialIrq irq_type) {
-    SerialBase *handler = (SerialBase*)id;
+    SerialBase *handler = (SerialBase*)(uintptr_t)id;
     handler->_irq[irq_type]();
 }
 
@@ -99,6 +106,24 @@ int SerialBase::_base_putc(int c) {
     return c;
 }
 
+ssize_t SerialBase::_base_write(const void *buffer, size_t length) {
+    // Mutex is already held
+    const unsigned char *ptr = (const unsigned char *)buffer;
+    for (size_t i = 0; i < length; i++) {
+        serial_putc(&_serial, ptr[i]);
+    }
+    return length;
+}
+
+ssize_t SerialBase::_base_read(void *buffer, size_t length) {
+    // Mutex is already held
+    unsigned char *ptr = (unsigned char *)buffer;
+    for (size_t i = 0; i < length; i++) {
+        ptr[i] = serial_getc(&_serial);
+    }
+    return length;
+}
+
 void SerialBase::send_break() {
     lock();
   // Wait for 1.5 frames before clearing the break condition
@@ -238,6 +238,8 @@ protected:
 
     int _base_getc();
     int _base_putc(int c);
+    ssize_t _base_write(const void *buffer, size_t length);
+    ssize_t _base_read(void *buffer, size_t length);
 
 #if DEVICE_SERIAL_ASYNCH
     CThunk<SerialBase> _thunk_irq;
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 #include "drivers/Stream.h"
+#include <cstring>
 
 namespace mbed {
 
@@ -31,17 +32,18 @@ Stream::~Stream() {
     fclose(_file);
 }
 
+// _file is unbuffered, so nothing written through it can still be waiting
+// and putc() and puts() can skip it and go straight to the device
 int Stream::putc(int c) {
     lock();
-    fflush(_file);
-    int ret = std::fputc(c, _file);
+    int ret = _putc(c);
     unlock();
     return ret;
 }
 int Stream::puts(const char *s) {
     lock();
-    fflush(_file);
-    int ret = std::fputs(s, _file);
+    size_t length = std::strlen(s);
+    int ret = (_write_block(s, length) == (ssize_t)length) ? 0 : EOF;
     unlock();
     return ret;
 }
@@ -65,31 +67,42 @@ int Stream::close() {
 }
 
 ssize_t Stream::write(const void* buffer, size_t length) {
+    lock();
+    ssize_t ret = _write_block(buffer, length);
+    unlock();
+    return ret;
+}
+
+ssize_t Stream::read(void* buffer, size_t length) {
+    lock();
+    ssize_t ret = _read_block(buffer, length);
+    unlock();
+    return ret;
+}
+
+ssize_t Stream::_write_block(const void* buffer, size_t length) {
     const char* ptr = (const char*)buffer;
     const char* end = ptr + length;
 
-    lock();
     while (ptr != end) {
-        if (_putc(*ptr++) == EOF) {
+        if (_putc(*ptr) == EOF) {
             break;
         }
+        ptr++;
     }
-    unlock();
 
     return ptr - (const char*)buffer;
 }
 
-ssize_t Stream::read(void* buffer, size_t length) {
+ssize_t Stream::_read_block(void* buffer, size_t length) {
     char* ptr = (char*)buffer;
     char* end = ptr + length;
 
-    lock();
     while (ptr != end) {
         int c = _getc();
         if (c==EOF) break;
         *ptr++ = c;
     }
-    unlock();
 
     return ptr - (const char*)buffer;
 }
@@ -64,6 +64,27 @@ protected:
     virtual int _putc(int c) = 0;
     virtual int _getc() = 0;
 
+    /** Write a block of characters, called with the stream locked
+     *
+     *  The default calls _putc() for each character. Streams which can send
+     *  a block for less than that should override it.
+     *
+     *  @param buffer The characters to write
+     *  @param length The number of characters to write
+     *  @returns The number of characters written
+     */
+    virtual ssize_t _write_block(const void* buffer, size_t length);
+
+    /** Read a block of characters, called with the stream locked
+     *
+     *  The default calls _getc() for each character, stopping early at EOF.
+     *
+     *  @param buffer Where to store the characters read
+     *  @param length The number of characters to read
+     *  @returns The number of characters read
+     */
+    virtual ssize_t _read_block(void* buffer, size_t length);
+
     std::FILE *_file;
 
     /* disallow copy constructor and assignment operators */
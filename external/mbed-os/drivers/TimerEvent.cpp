@@ -31,7 +31,7 @@ TimerEvent::TimerEvent(const ticker_data_t *data) : event(), _ticker_data(data)
 }
 
 void TimerEvent::irq(uint32_t id) {
-    TimerEvent *timer_event = (TimerEvent*)id;
+    TimerEvent *timer_event = (TimerEvent*)(uintptr_t)id;
     timer_event->handler();
 }
 
@@ -41,7 +41,7 @@ TimerEvent::~TimerEvent() {
 
 // insert in to linked list
 void TimerEvent::insert(timestamp_t timestamp) {
-    ticker_insert_event(_ticker_data, &event, timestamp, (uint32_t)this);
+    ticker_insert_event(_ticker_data, &event, timestamp, (uint32_t)(uintptr_t)this);
 }
 
 void TimerEvent::remove() {
@@ -39,6 +39,7 @@
  * Activate with compiler flag: YOTTA_CFG_MBED_TRACE
  * Configure trace line buffer size with compiler flag: YOTTA_CFG_MBED_TRACE_LINE_LENGTH. Default length: 1024.
  * Limit the size of flash by setting MBED_TRACE_MAX_LEVEL value. Default is TRACE_LEVEL_DEBUG (all included)
+ * Record traces to a RAM ring instead of formatting them with MBED_CONF_MBED_TRACE_BINARY, see mbed_trace_binary_vrecord().
  *
  */
 #ifndef MBED_TRACE_H_
@@ -57,6 +58,7 @@ extern "C" {
 #endif
 
 #include <stdarg.h>
+#include <stdio.h>
 
 #ifndef YOTTA_CFG_MBED_TRACE
 #define YOTTA_CFG_MBED_TRACE 0
@@ -77,6 +79,10 @@ extern "C" {
 #define MBED_CONF_MBED_TRACE_FEA_IPV6 1
 #endif
 
+#ifndef MBED_CONF_MBED_TRACE_BINARY
+#define MBED_CONF_MBED_TRACE_BINARY 0
+#endif
+
 /** 3 upper bits are trace modes related,
     and 5 lower bits are trace level configuration */
 
@@ -366,6 +372,66 @@ char* mbed_trace_ipv6_prefix(const uint8_t *prefix, uint8_t prefix_len);
  */
 char* mbed_trace_array(const uint8_t* buf, uint16_t len);
 
+/** Marks the first word of every packet from mbed_trace_binary_drain(), "MTB1" read little endian */
+#define MBED_TRACE_BINARY_PACKET_MAGIC  0x3142544DUL
+/** Top byte of the first word of each binary trace record */
+#define MBED_TRACE_BINARY_RECORD_MARK   0xB5
+/** Set in the first word of a record whose arguments didn't all fit */
+#define MBED_TRACE_BINARY_TRUNCATED     0x8000
+
+/**
+ * Record a trace without formatting it. Used by mbed_vtracef() in place of
+ * printing when built with MBED_CONF_MBED_TRACE_BINARY, after the level and
+ * group filters have passed the trace.
+ *
+ * Stores a record of 32-bit words in a RAM ring, reserved without locking so
+ * that it can be called from any thread or interrupt:
+ *   word 0   MBED_TRACE_BINARY_RECORD_MARK << 24 | dlevel << 16 | flags | number of words
+ *   word 1   timestamp from the function set by mbed_trace_binary_time_function_set()
+ *   word 2   address of fmt
+ *   word 3   address of grp
+ *   word 4.. arguments in the order fmt takes them, one word each, two words
+ *            for 64-bit integers and floating point (stored as double), and
+ *            for %s the length followed by at most MBED_CONF_MBED_TRACE_BINARY_STRING_MAX
+ *            characters padded to a whole word
+ * fmt and grp must be in memory which outlives the trace, such as string
+ * literals, as only their addresses are kept. The text is put back together
+ * off target from the image which made the trace. When the ring is full the
+ * trace is dropped and counted.
+ *
+ * @param dlevel debug level
+ * @param grp    trace group
+ * @param fmt    trace format (like vprintf)
+ * @param ap     variable arguments list (like vprintf)
+ */
+void mbed_trace_binary_vrecord(uint8_t dlevel, const char *grp, const char *fmt, va_list ap);
+/**
+ * Set the function which timestamps binary trace records. Defaults to
+ * us_ticker_read() in mbed builds.
+ * @param time_f  function returning the time, or NULL to store 0
+ */
+void mbed_trace_binary_time_function_set(uint32_t (*time_f)(void));
+/**
+ * Take whole records out of the binary trace ring, oldest first.
+ * Only one caller at a time may read.
+ *
+ * @param buffer   where to copy the records
+ * @param words    size of buffer in words
+ * @param dropped  if not NULL, set to the number of traces dropped since the last call
+ * @return number of words copied
+ */
+size_t mbed_trace_binary_read(uint32_t *buffer, size_t words, uint32_t *dropped);
+/**
+ * Write the binary trace ring to a stream as packets of a four word header
+ * (MBED_TRACE_BINARY_PACKET_MAGIC, number of record words, traces dropped,
+ * sum of the record words) followed by the records, all little endian.
+ * Only one caller at a time may drain.
+ *
+ * @param stream  where to write, such as stdout or a file
+ * @return number of record words written, or -1 if the stream failed
+ */
+int mbed_trace_binary_drain(FILE *stream);
+
 #ifdef __cplusplus
 }
 #endif
@@ -404,6 +470,10 @@ char* mbed_trace_array(const uint8_t* buf, uint16_t len);
 #undef mbed_trace_ipv6
 #undef mbed_trace_ipv6_prefix
 #undef mbed_trace_array
+#undef mbed_trace_binary_vrecord
+#undef mbed_trace_binary_time_function_set
+#undef mbed_trace_binary_read
+#undef mbed_trace_binary_drain
 
 #elif !defined(MBED_TRACE_DUMMIES_DEFINED)
 // define dummies, hiding the real functions
@@ -426,6 +496,10 @@ char* mbed_trace_array(const uint8_t* buf, uint16_t len);
 #define mbed_trace_last(...)                        ((const char *) 0)
 #define mbed_tracef(...)                            ((void) 0)
 #define mbed_vtracef(...)                           ((void) 0)
+#define mbed_trace_binary_vrecord(...)              ((void) 0)
+#define mbed_trace_binary_time_function_set(...)    ((void) 0)
+#define mbed_trace_binary_read(...)                 ((size_t) 0)
+#define mbed_trace_binary_drain(...)                ((int) 0)
 /**
  * These helper functions accumulate strings in a buffer that is only flushed by actual trace calls. Using these
  * functions outside trace calls could cause the buffer to overflow.
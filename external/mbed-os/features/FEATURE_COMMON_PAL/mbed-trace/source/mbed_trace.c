@@ -330,6 +330,14 @@ void mbed_vtracef(uint8_t dlevel, const char* grp, const char *fmt, va_list ap)
         goto end;
     }
     if ((m_trace.trace_config & TRACE_MASK_LEVEL) &  dlevel) {
+#if MBED_CONF_MBED_TRACE_BINARY
+        if (dlevel != TRACE_LEVEL_CMD) {
+            //record without formatting, the text is rebuilt off target
+            mbed_trace_binary_vrecord(dlevel, grp, fmt, ap);
+            mbed_trace_reset_tmp();
+            goto end;
+        }
+#endif
         bool color = (m_trace.trace_config & TRACE_MODE_COLOR) != 0;
         bool plain = (m_trace.trace_config & TRACE_MODE_PLAIN) != 0;
         bool cr    = (m_trace.trace_config & TRACE_CARRIAGE_RETURN) != 0;
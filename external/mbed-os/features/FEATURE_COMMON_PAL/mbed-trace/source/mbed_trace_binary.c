@@ -0,0 +1,366 @@
+/*
+ * Copyright (c) 2017 ARM Limited. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+
+#ifdef MBED_CONF_MBED_TRACE_ENABLE
+#undef MBED_CONF_MBED_TRACE_ENABLE
+#endif
+#define MBED_CONF_MBED_TRACE_ENABLE 1
+
+#include "mbed-trace/mbed_trace.h"
+
+#if MBED_CONF_MBED_TRACE_BINARY
+
+#if defined(__MBED__)
+#include "cmsis.h"
+#include "platform/mbed_critical.h"
+#include "hal/us_ticker_api.h"
+#endif
+
+#ifdef MBED_CONF_MBED_TRACE_BINARY_BUFFER_SIZE
+#define TRACE_RING_SIZE         MBED_CONF_MBED_TRACE_BINARY_BUFFER_SIZE
+#else
+#define TRACE_RING_SIZE         1024
+#endif
+#define TRACE_RING_MASK         (TRACE_RING_SIZE - 1)
+
+#ifdef MBED_CONF_MBED_TRACE_BINARY_STRING_MAX
+#define TRACE_STRING_MAX        MBED_CONF_MBED_TRACE_BINARY_STRING_MAX
+#else
+#define TRACE_STRING_MAX        32
+#endif
+
+// Words of arguments a record can hold, enough for a few strings and numbers
+#define TRACE_ARGS_MAX          (4 * ((TRACE_STRING_MAX + 3) / 4 + 1))
+#define TRACE_HEADER_WORDS      4
+#define TRACE_DRAIN_WORDS       64
+
+#if TRACE_RING_SIZE < 2 || (TRACE_RING_SIZE & TRACE_RING_MASK)
+#error "mbed-trace.binary-buffer-size must be a power of two"
+#endif
+#if TRACE_RING_SIZE < TRACE_HEADER_WORDS + TRACE_ARGS_MAX || TRACE_DRAIN_WORDS < TRACE_HEADER_WORDS + TRACE_ARGS_MAX
+#error "mbed-trace.binary-buffer-size is too small for mbed-trace.binary-string-max"
+#endif
+
+#define TRACE_RECORD_HEADER(dlevel, flags, words) \
+    (((uint32_t)MBED_TRACE_BINARY_RECORD_MARK << 24) | ((uint32_t)(dlevel) << 16) | (flags) | (words))
+#define TRACE_RECORD_WORDS(header)  ((header) & 0x7FFF)
+#define TRACE_RECORD_LEVEL(header)  (((header) >> 16) & 0xFF)
+
+/* head and tail run freely and are only reduced to an index on access.
+ * Writers move head forward with compare and swap to reserve a record and
+ * write its first word last, so the reader stops at the first record which
+ * is reserved but not yet complete. A record which would run past the end
+ * of the ring is moved to the start, behind a level 0 record which fills
+ * the gap. */
+static uint32_t m_ring[TRACE_RING_SIZE];
+static volatile uint32_t m_head;
+static volatile uint32_t m_tail;
+static uint32_t m_dropped;
+#if defined(__MBED__)
+static uint32_t (*m_time_f)(void) = us_ticker_read;
+#else
+static uint32_t (*m_time_f)(void) = 0;
+#endif
+
+#if defined(__MBED__)
+#define trace_barrier()                 __DMB()
+#define trace_cas(ptr, expected, value) core_util_atomic_cas_u32((uint32_t *)(ptr), (expected), (value))
+#define trace_incr(ptr)                 core_util_atomic_incr_u32((ptr), 1)
+#else
+#define trace_barrier()                 __sync_synchronize()
+#define trace_cas(ptr, expected, value) __atomic_compare_exchange_n((ptr), (expected), (value), 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+#define trace_incr(ptr)                 __atomic_add_fetch((ptr), 1, __ATOMIC_SEQ_CST)
+#endif
+
+static int trace_put(uint32_t *args, int count, uint32_t value)
+{
+    if (count >= TRACE_ARGS_MAX) {
+        return -1;
+    }
+    args[count] = value;
+    return count + 1;
+}
+
+static int trace_put64(uint32_t *args, int count, const void *value)
+{
+    if (count + 2 > TRACE_ARGS_MAX) {
+        return -1;
+    }
+    memcpy(&args[count], value, 8);
+    return count + 2;
+}
+
+static int trace_put_string(uint32_t *args, int count, const char *str, int precision)
+{
+    int length = 0;
+    int limit = TRACE_STRING_MAX;
+
+    if (precision >= 0 && precision < limit) {
+        limit = precision;
+    }
+    if (str == NULL) {
+        str = "(null)";
+    }
+    while (length < limit && str[length] != '\0') {
+        length++;
+    }
+    if (count + 1 + (length + 3) / 4 > TRACE_ARGS_MAX) {
+        return -1;
+    }
+    args[count++] = length;
+    memcpy(&args[count], str, length);
+    memset((char *)&args[count] + length, 0, (4 - (length & 3)) & 3);
+    return count + (length + 3) / 4;
+}
+
+/* Walks fmt the way vsnprintf would, storing each argument instead of
+ * formatting it. Returns the number of words stored, and sets *truncated if
+ * some arguments didn't fit. */
+static int trace_args(uint32_t *args, const char *fmt, va_list ap, int *truncated)
+{
+    int count = 0;
+    int next;
+
+    *truncated = 0;
+    while (*fmt != '\0') {
+        int precision = -1;
+        int longs = 0;
+
+        if (*fmt++ != '%') {
+            continue;
+        }
+        while (*fmt == '-' || *fmt == '+' || *fmt == ' ' || *fmt == '#' || *fmt == '0') {
+            fmt++;
+        }
+        if (*fmt == '*') {
+            next = trace_put(args, count, va_arg(ap, int));
+            if (next < 0) {
+                goto full;
+            }
+            count = next;
+            fmt++;
+        }
+        while (*fmt >= '0' && *fmt <= '9') {
+            fmt++;
+        }
+        if (*fmt == '.') {
+            fmt++;
+            precision = 0;
+            if (*fmt == '*') {
+                precision = va_arg(ap, int);
+                next = trace_put(args, count, precision);
+                if (next < 0) {
+                    goto full;
+                }
+                count = next;
+                fmt++;
+            }
+            while (*fmt >= '0' && *fmt <= '9') {
+                precision = precision * 10 + *fmt++ - '0';
+            }
+        }
+        while (*fmt == 'h' || *fmt == 'l' || *fmt == 'L' || *fmt == 'j' || *fmt == 'z' || *fmt == 't') {
+            if (*fmt == 'l' || *fmt == 'L') {
+                longs++;
+            } else if (*fmt == 'j') {
+                longs = 2;
+            }
+            fmt++;
+        }
+
+        switch (*fmt) {
+            case 'd':
+            case 'i':
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+            case 'c':
+                if (longs >= 2) {
+                    long long value = va_arg(ap, long long);
+                    next = trace_put64(args, count, &value);
+                } else if (longs == 1) {
+                    next = trace_put(args, count, (uint32_t)va_arg(ap, long));
+                } else {
+                    next = trace_put(args, count, (uint32_t)va_arg(ap, int));
+                }
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A': {
+                double value;
+                if (longs && fmt[-1] == 'L') {
+                    value = (double)va_arg(ap, long double);
+                } else {
+                    value = va_arg(ap, double);
+                }
+                next = trace_put64(args, count, &value);
+                break;
+            }
+            case 's':
+                next = trace_put_string(args, count, va_arg(ap, const char *), precision);
+                break;
+            case 'p':
+            case 'n':
+                next = trace_put(args, count, (uint32_t)(uintptr_t)va_arg(ap, void *));
+                break;
+            case '\0':
+                return count;
+            default:
+                // '%%' or a conversion which takes nothing
+                next = count;
+                break;
+        }
+        if (next < 0) {
+            goto full;
+        }
+        count = next;
+        fmt++;
+    }
+    return count;
+
+full:
+    *truncated = 1;
+    return count;
+}
+
+void mbed_trace_binary_vrecord(uint8_t dlevel, const char *grp, const char *fmt, va_list ap)
+{
+    uint32_t args[TRACE_ARGS_MAX];
+    uint32_t timestamp = m_time_f ? m_time_f() : 0;
+    int truncated;
+    uint32_t count = trace_args(args, fmt, ap, &truncated);
+    uint32_t words = TRACE_HEADER_WORDS + count;
+    uint32_t head;
+    uint32_t index;
+    uint32_t pad;
+
+    do {
+        head = m_head;
+        index = head & TRACE_RING_MASK;
+        pad = (index + words > TRACE_RING_SIZE) ? TRACE_RING_SIZE - index : 0;
+        if (head + pad + words - m_tail > TRACE_RING_SIZE) {
+            trace_incr(&m_dropped);
+            return;
+        }
+    } while (!trace_cas(&m_head, &head, head + pad + words));
+
+    if (pad) {
+        // Nothing is read from a filler but its first word
+        trace_barrier();
+        m_ring[index] = TRACE_RECORD_HEADER(0, 0, pad);
+        index = 0;
+    }
+
+    m_ring[index + 1] = timestamp;
+    m_ring[index + 2] = (uint32_t)(uintptr_t)fmt;
+    m_ring[index + 3] = (uint32_t)(uintptr_t)grp;
+    memcpy(&m_ring[index + TRACE_HEADER_WORDS], args, count * sizeof(args[0]));
+    trace_barrier();
+    m_ring[index] = TRACE_RECORD_HEADER(dlevel, truncated ? MBED_TRACE_BINARY_TRUNCATED : 0, words);
+}
+
+void mbed_trace_binary_time_function_set(uint32_t (*time_f)(void))
+{
+    m_time_f = time_f;
+}
+
+size_t mbed_trace_binary_read(uint32_t *buffer, size_t words, uint32_t *dropped)
+{
+    uint32_t tail = m_tail;
+    uint32_t head;
+    size_t copied = 0;
+
+    while (tail != (head = m_head)) {
+        uint32_t index = tail & TRACE_RING_MASK;
+        uint32_t header = m_ring[index];
+        uint32_t length = TRACE_RECORD_WORDS(header);
+
+        if ((header >> 24) != MBED_TRACE_BINARY_RECORD_MARK) {
+            // Reserved but not written yet
+            break;
+        }
+        if (length == 0 || length > head - tail || index + length > TRACE_RING_SIZE) {
+            // Not a record the writers could have made, so stop rather than
+            // copy or free words which may still belong to someone else
+            break;
+        }
+        trace_barrier();
+        if (TRACE_RECORD_LEVEL(header) != 0) {
+            if (copied + length > words) {
+                break;
+            }
+            memcpy(&buffer[copied], &m_ring[index], length * sizeof(buffer[0]));
+            copied += length;
+        }
+        // Clear every word, as a later record may start anywhere in this
+        // one and its first word must not look written until it is
+        memset(&m_ring[index], 0, length * sizeof(m_ring[0]));
+        tail += length;
+        // The slots must be seen as empty before they are handed back to writers
+        trace_barrier();
+        m_tail = tail;
+    }
+
+    if (dropped != NULL) {
+        uint32_t count = m_dropped;
+        while (!trace_cas(&m_dropped, &count, 0)) {
+        }
+        *dropped = count;
+    }
+    return copied;
+}
+
+int mbed_trace_binary_drain(FILE *stream)
+{
+    uint32_t records[TRACE_DRAIN_WORDS];
+    uint32_t packet[4];
+    uint32_t dropped;
+    int written = 0;
+
+    for (;;) {
+        size_t count = mbed_trace_binary_read(records, TRACE_DRAIN_WORDS, &dropped);
+        if (count == 0 && dropped == 0) {
+            break;
+        }
+
+        packet[0] = MBED_TRACE_BINARY_PACKET_MAGIC;
+        packet[1] = count;
+        packet[2] = dropped;
+        packet[3] = 0;
+        for (size_t i = 0; i < count; i++) {
+            packet[3] += records[i];
+        }
+        if (fwrite(packet, sizeof(packet), 1, stream) != 1 ||
+                (count && fwrite(records, sizeof(records[0]), count, stream) != count)) {
+            return -1;
+        }
+        written += count;
+    }
+
+    return fflush(stream) == 0 ? written : -1;
+}
+
+#endif /* MBED_CONF_MBED_TRACE_BINARY */
+void dbg_state(void){ printf("head=%u tail=%u idx=%u hdr=%08x\n", m_head, m_tail, m_tail&TRACE_RING_MASK, m_ring[m_tail&TRACE_RING_MASK]); }
@@ -0,0 +1,192 @@
+#if !FEATURE_LWIP
+    #error [NOT_SUPPORTED] LWIP not supported for this target
+#endif
+
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+extern "C" {
+#include "lwip/inet_chksum.h"
+}
+
+#if !LWIP_CHECKSUM_ON_COPY
+    #error [NOT_SUPPORTED] LWIP_CHECKSUM_ON_COPY not enabled
+#endif
+
+using namespace utest::v1;
+
+#define MAX_LENGTH      1520
+#define GUARD_SIZE      8
+#define GUARD_BYTE      0xE5
+#define PERF_LENGTH     1460
+#define PERF_LOOPS      64
+
+static uint8_t src_buffer[MAX_LENGTH + GUARD_SIZE];
+static uint8_t dst_buffer[MAX_LENGTH + 2 * GUARD_SIZE + 4];
+static uint8_t ref_buffer[MAX_LENGTH + GUARD_SIZE];
+
+static void fill_random(uint8_t *buffer, size_t size, uint32_t seed)
+{
+    for (size_t i = 0; i < size; i++) {
+        seed = seed * 1664525 + 1013904223;
+        buffer[i] = seed >> 24;
+    }
+}
+
+// Copy len bytes from src_buffer + src_offset to dst_buffer + GUARD_SIZE + dst_offset
+// with LWIP_CHKSUM_COPY and check the copy and checksum against the C reference
+// and against lwIP's own checksum of the copied data.
+static void check_copy(int len, int src_offset, int dst_offset)
+{
+    uint8_t *src = src_buffer + src_offset;
+    uint8_t *dst = dst_buffer + GUARD_SIZE + dst_offset;
+
+    memset(dst_buffer, GUARD_BYTE, sizeof(dst_buffer));
+    u16_t sum = LWIP_CHKSUM_COPY(dst, src, len);
+    u16_t ref = generic_chksum_copy(ref_buffer, src, len);
+
+    TEST_ASSERT_EQUAL_HEX16(ref, sum);
+    TEST_ASSERT_EQUAL_HEX16((u16_t)~inet_chksum(src, len), sum);
+    if (len > 0) {
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(src, ref_buffer, len);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(src, dst, len);
+    }
+    for (int i = 0; i < GUARD_SIZE + dst_offset; i++) {
+        TEST_ASSERT_EQUAL_HEX8(GUARD_BYTE, dst_buffer[i]);
+    }
+    for (int i = 0; i < GUARD_SIZE; i++) {
+        TEST_ASSERT_EQUAL_HEX8(GUARD_BYTE, dst[len + i]);
+    }
+}
+
+
+// Test cases
+void test_chksum_copy_short() {
+    fill_random(src_buffer, sizeof(src_buffer), 1);
+    for (int len = 0; len <= 80; len++) {
+        for (int src_offset = 0; src_offset < 4; src_offset++) {
+            for (int dst_offset = 0; dst_offset < 4; dst_offset++) {
+                check_copy(len, src_offset, dst_offset);
+            }
+        }
+    }
+}
+
+void test_chksum_copy_long() {
+    static const int lengths[] = {511, 512, 513, 536, 1459, 1460, 1461, 1500, 1514, MAX_LENGTH};
+
+    fill_random(src_buffer, sizeof(src_buffer), 2);
+    for (unsigned i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        for (int src_offset = 0; src_offset < 4; src_offset++) {
+            for (int dst_offset = 0; dst_offset < 4; dst_offset++) {
+                check_copy(lengths[i], src_offset, dst_offset);
+            }
+        }
+    }
+}
+
+void test_chksum_copy_carries() {
+    // All ones maximises the carries out of every add
+    memset(src_buffer, 0xFF, sizeof(src_buffer));
+    check_copy(MAX_LENGTH, 0, 0);
+    check_copy(MAX_LENGTH - 1, 1, 3);
+
+    // All zeroes must sum to 0, not 0xFFFF
+    memset(src_buffer, 0x00, sizeof(src_buffer));
+    check_copy(MAX_LENGTH, 0, 0);
+    check_copy(7, 3, 1);
+
+    // Words which sum to exactly 0x10000
+    for (int i = 0; i < MAX_LENGTH; i += 4) {
+        src_buffer[i + 0] = 0xFF;
+        src_buffer[i + 1] = 0xFF;
+        src_buffer[i + 2] = 0x01;
+        src_buffer[i + 3] = 0x00;
+    }
+    check_copy(MAX_LENGTH, 0, 0);
+    check_copy(MAX_LENGTH - 2, 2, 1);
+}
+
+#if defined(DWT) && defined(CoreDebug)
+static uint32_t cycles_start() {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    return DWT->CYCCNT;
+}
+
+static uint32_t cycles_elapsed(uint32_t start) {
+    return DWT->CYCCNT - start;
+}
+#else
+// No cycle counter so fall back to microseconds scaled by the core clock
+static uint32_t cycles_start() {
+    return us_ticker_read();
+}
+
+static uint32_t cycles_elapsed(uint32_t start) {
+    return (us_ticker_read() - start) * (SystemCoreClock / 1000000);
+}
+#endif
+
+static void report(const char *name, uint32_t cycles) {
+    // Cycles per byte to two decimal places
+    uint32_t per_byte_x100 = (uint32_t)((uint64_t)cycles * 100 / ((uint64_t)PERF_LENGTH * PERF_LOOPS));
+    printf("%-24s %lu.%02lu cycles/byte\r\n", name,
+           (unsigned long)(per_byte_x100 / 100), (unsigned long)(per_byte_x100 % 100));
+}
+
+void test_chksum_copy_cycles() {
+    volatile u16_t sum = 0;
+    uint32_t start;
+
+    fill_random(src_buffer, sizeof(src_buffer), 3);
+
+    start = cycles_start();
+    for (int i = 0; i < PERF_LOOPS; i++) {
+        sum += LWIP_CHKSUM_COPY(dst_buffer, src_buffer, PERF_LENGTH);
+    }
+    uint32_t fused = cycles_elapsed(start);
+
+    start = cycles_start();
+    for (int i = 0; i < PERF_LOOPS; i++) {
+        MEMCPY(dst_buffer, src_buffer, PERF_LENGTH);
+        sum += inet_chksum(dst_buffer, PERF_LENGTH);
+    }
+    uint32_t separate = cycles_elapsed(start);
+
+    start = cycles_start();
+    for (int i = 0; i < PERF_LOOPS; i++) {
+        sum += generic_chksum_copy(dst_buffer, src_buffer, PERF_LENGTH);
+    }
+    uint32_t reference = cycles_elapsed(start);
+
+    report("LWIP_CHKSUM_COPY", fused);
+    report("MEMCPY + inet_chksum", separate);
+    report("generic_chksum_copy", reference);
+
+    // Only meaningful where the fused Thumb-2 version is in use
+#if defined(TOOLCHAIN_GCC) && defined(__thumb2__)
+    TEST_ASSERT(fused < separate);
+#endif
+}
+
+
+// Test setup
+utest::v1::status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(60, "default_auto");
+    return verbose_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("Checksum copy short lengths", test_chksum_copy_short),
+    Case("Checksum copy long lengths", test_chksum_copy_long),
+    Case("Checksum copy carries", test_chksum_copy_carries),
+    Case("Checksum copy cycles per byte", test_chksum_copy_cycles),
+};
+
+Specification specification(test_setup, cases);
+
+int main() {
+    return !Harness::run(specification);
+}
@@ -0,0 +1,188 @@
+#if !FEATURE_LWIP
+    #error [NOT_SUPPORTED] LWIP not supported for this target
+#endif
+#if !DEVICE_EMAC
+    #error [NOT_SUPPORTED] EMAC not supported for this target
+#endif
+
+#include "mbed.h"
+#include "LoopbackInterface.h"
+#include "TCPServer.h"
+#include "TCPSocket.h"
+#include "UDPSocket.h"
+#include "emac_loopback.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+
+using namespace utest::v1;
+
+#define ECHO_PORT       7
+#define SOCKET_TIMEOUT  2000
+#define UDP_LOOPS       16
+#define TCP_TOTAL       8192
+
+static LoopbackInterface net;
+
+static uint8_t tx_buffer[1024];
+static uint8_t rx_buffer[1024];
+static uint8_t echo_buffer[1024];
+
+static void fill_pattern(uint8_t *buffer, size_t size, uint32_t seed)
+{
+    for (size_t i = 0; i < size; i++) {
+        seed = seed * 1664525 + 1013904223;
+        buffer[i] = seed >> 24;
+    }
+}
+
+
+// Echo servers, running on the same stack as the clients
+static void udp_echo_server(UDPSocket *sock)
+{
+    SocketAddress from;
+
+    for (int i = 0; i < UDP_LOOPS; i++) {
+        nsapi_size_or_error_t len = sock->recvfrom(&from, echo_buffer, sizeof(echo_buffer));
+        if (len < 0) {
+            return;
+        }
+        sock->sendto(from, echo_buffer, len);
+    }
+}
+
+static void tcp_echo_server(TCPServer *server)
+{
+    TCPSocket sock;
+
+    if (server->accept(&sock) != NSAPI_ERROR_OK) {
+        return;
+    }
+    sock.set_timeout(SOCKET_TIMEOUT);
+
+    while (true) {
+        nsapi_size_or_error_t len = sock.recv(echo_buffer, sizeof(echo_buffer));
+        if (len <= 0) {
+            break;
+        }
+        for (nsapi_size_or_error_t sent = 0; sent < len; ) {
+            nsapi_size_or_error_t ret = sock.send(echo_buffer + sent, len - sent);
+            if (ret < 0) {
+                return;
+            }
+            sent += ret;
+        }
+    }
+    sock.close();
+}
+
+
+// Test cases
+void test_loopback_connect() {
+    emac_loopback_configure(NULL);
+    emac_loopback_reset();
+
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, net.connect());
+    TEST_ASSERT_EQUAL_STRING(LOOPBACK_INTERFACE_IP, net.get_ip_address());
+}
+
+void test_loopback_udp_echo() {
+    UDPSocket server;
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, server.open(&net));
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, server.bind(ECHO_PORT));
+    server.set_timeout(SOCKET_TIMEOUT);
+    Thread server_thread;
+    server_thread.start(callback(udp_echo_server, &server));
+
+    UDPSocket sock;
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, sock.open(&net));
+    sock.set_timeout(SOCKET_TIMEOUT);
+    SocketAddress peer(LOOPBACK_INTERFACE_PEER, ECHO_PORT);
+
+    for (int i = 0; i < UDP_LOOPS; i++) {
+        size_t size = 16 + i * (sizeof(tx_buffer) - 16) / (UDP_LOOPS - 1);
+        fill_pattern(tx_buffer, size, i);
+
+        TEST_ASSERT_EQUAL(size, sock.sendto(peer, tx_buffer, size));
+
+        SocketAddress from;
+        TEST_ASSERT_EQUAL(size, sock.recvfrom(&from, rx_buffer, sizeof(rx_buffer)));
+        TEST_ASSERT_EQUAL_STRING(LOOPBACK_INTERFACE_PEER, from.get_ip_address());
+        TEST_ASSERT_EQUAL(ECHO_PORT, from.get_port());
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(tx_buffer, rx_buffer, size);
+    }
+
+    sock.close();
+    server_thread.join();
+    server.close();
+}
+
+void test_loopback_tcp_echo() {
+    TCPServer server;
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, server.open(&net));
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, server.bind(ECHO_PORT));
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, server.listen());
+    server.set_timeout(SOCKET_TIMEOUT);
+    Thread server_thread;
+    server_thread.start(callback(tcp_echo_server, &server));
+
+    TCPSocket sock;
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, sock.open(&net));
+    sock.set_timeout(SOCKET_TIMEOUT);
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, sock.connect(SocketAddress(LOOPBACK_INTERFACE_PEER, ECHO_PORT)));
+
+    for (int total = 0, i = 0; total < TCP_TOTAL; total += sizeof(tx_buffer), i++) {
+        fill_pattern(tx_buffer, sizeof(tx_buffer), i);
+        TEST_ASSERT_EQUAL(sizeof(tx_buffer), sock.send(tx_buffer, sizeof(tx_buffer)));
+
+        size_t received = 0;
+        while (received < sizeof(tx_buffer)) {
+            nsapi_size_or_error_t len = sock.recv(rx_buffer + received, sizeof(rx_buffer) - received);
+            TEST_ASSERT(len > 0);
+            received += len;
+        }
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(tx_buffer, rx_buffer, sizeof(tx_buffer));
+    }
+
+    sock.close();
+    server_thread.join();
+    server.close();
+}
+
+void test_loopback_frames() {
+    emac_loopback_stats_t stack_port;
+    emac_loopback_stats_t reflect_port;
+    emac_loopback_get_stats(0, &stack_port);
+    emac_loopback_get_stats(1, &reflect_port);
+
+    printf("stack port: tx %lu frames %lu bytes, rx %lu frames %lu bytes, no mem %lu\r\n",
+           (unsigned long)stack_port.tx_frames, (unsigned long)stack_port.tx_bytes,
+           (unsigned long)stack_port.rx_frames, (unsigned long)stack_port.rx_bytes,
+           (unsigned long)stack_port.rx_no_mem);
+
+    // Both ends of each echo crossed the cable, closing handshakes may still be on it
+    TEST_ASSERT(stack_port.tx_bytes >= 2 * (UDP_LOOPS * 16 + TCP_TOTAL));
+    TEST_ASSERT(reflect_port.rx_frames > 0);
+    TEST_ASSERT(reflect_port.rx_frames <= stack_port.tx_frames);
+    TEST_ASSERT(stack_port.rx_frames > 0);
+}
+
+
+// Test setup
+utest::v1::status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(60, "default_auto");
+    return verbose_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("Loopback connect", test_loopback_connect),
+    Case("Loopback UDP echo", test_loopback_udp_echo),
+    Case("Loopback TCP echo", test_loopback_tcp_echo),
+    Case("Loopback frames", test_loopback_frames),
+};
+
+Specification specification(test_setup, cases);
+
+int main() {
+    return !Harness::run(specification);
+}
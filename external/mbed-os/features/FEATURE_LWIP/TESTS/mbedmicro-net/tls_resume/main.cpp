@@ -0,0 +1,182 @@
+#if !FEATURE_LWIP
+    #error [NOT_SUPPORTED] LWIP not supported for this target
+#endif
+#if DEVICE_EMAC
+    #error [NOT_SUPPORTED] Not supported for WiFi targets
+#endif
+
+#include "mbed.h"
+#include "EthernetInterface.h"
+#include "TLSSocket.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+
+#if !defined(MBEDTLS_SSL_CLI_C) || !defined(MBEDTLS_CERTS_C) || !defined(MBEDTLS_ECDSA_C)
+    #error [NOT_SUPPORTED] TLS client not enabled for this target
+#endif
+
+#include "mbedtls/certs.h"
+
+
+#ifndef MBED_CFG_TLS_RESUME_BUFFER_SIZE
+#define MBED_CFG_TLS_RESUME_BUFFER_SIZE 256
+#endif
+
+// Room for both record buffers, the certificates and the handshake
+#ifndef MBED_CFG_TLS_RESUME_ARENA_SIZE
+#define MBED_CFG_TLS_RESUME_ARENA_SIZE (48 * 1024)
+#endif
+
+// Common name of the mbed TLS test server certificate served by the host test
+#define TLS_RESUME_HOSTNAME "localhost"
+
+namespace {
+    char tx_buffer[MBED_CFG_TLS_RESUME_BUFFER_SIZE] = {0};
+    char rx_buffer[MBED_CFG_TLS_RESUME_BUFFER_SIZE] = {0};
+#if defined(MBEDTLS_PLATFORM_MEMORY)
+    uint64_t arena_buffer[MBED_CFG_TLS_RESUME_ARENA_SIZE / sizeof(uint64_t)];
+#endif
+}
+
+void prep_buffer(char *tx_buffer, size_t tx_size) {
+    for (size_t i=0; i<tx_size; ++i) {
+        tx_buffer[i] = (rand() % 10) + '0';
+    }
+}
+
+// Connect, echo one buffer through the host's TLS server and close
+bool tls_echo(TLSSocket &sock, EthernetInterface &eth, const SocketAddress &addr, bool blocking) {
+    TEST_ASSERT_EQUAL(0, sock.open(&eth));
+    sock.set_blocking(blocking);
+
+    nsapi_error_t err;
+    if (blocking) {
+        err = sock.connect(addr);
+    } else {
+        while ((err = sock.connect(addr)) == NSAPI_ERROR_IN_PROGRESS) {
+            Thread::wait(10);
+        }
+        TEST_ASSERT_EQUAL(0, err);
+        TEST_ASSERT_EQUAL(NSAPI_ERROR_IS_CONNECTED, sock.connect(addr));
+        sock.set_blocking(true);
+    }
+    TEST_ASSERT_EQUAL(0, err);
+
+    prep_buffer(tx_buffer, sizeof(tx_buffer));
+    TEST_ASSERT_EQUAL(sizeof(tx_buffer), sock.send(tx_buffer, sizeof(tx_buffer)));
+
+    size_t received = 0;
+    while (received < sizeof(rx_buffer)) {
+        int ret = sock.recv(rx_buffer + received, sizeof(rx_buffer) - received);
+        TEST_ASSERT(ret > 0);
+        received += ret;
+    }
+    TEST_ASSERT_EQUAL(0, memcmp(tx_buffer, rx_buffer, sizeof(tx_buffer)));
+
+    bool resumed = sock.is_resumed();
+    tls_socket_stats_t stats;
+    sock.get_stats(&stats);
+    printf("MBED: %s %s handshake %lu ms, mbed TLS heap peak %lu bytes\r\n",
+           blocking ? "blocking" : "non-blocking", resumed ? "resumed" : "full",
+           (unsigned long)stats.last_handshake_ms, (unsigned long)stats.last_heap_peak);
+
+    sock.close();
+    return resumed;
+}
+
+int main() {
+    GREENTEA_SETUP(120, "tls_echo");
+#if defined(MBEDTLS_PLATFORM_MEMORY)
+    TEST_ASSERT_EQUAL(0, TLSSocket::install_allocator());
+#endif
+
+    EthernetInterface eth;
+    eth.connect();
+
+    printf("MBED: TLSClient IP address is '%s'\n", eth.get_ip_address());
+    printf("MBED: TLSClient waiting for server IP and port...\n");
+
+    greentea_send_kv("target_ip", eth.get_ip_address());
+
+    char recv_key[] = "host_port";
+    char ipbuf[60] = {0};
+    char portbuf[16] = {0};
+    unsigned int port = 0;
+
+    greentea_send_kv("host_ip", " ");
+    greentea_parse_kv(recv_key, ipbuf, sizeof(recv_key), sizeof(ipbuf));
+
+    greentea_send_kv("host_port", " ");
+    greentea_parse_kv(recv_key, portbuf, sizeof(recv_key), sizeof(portbuf));
+    sscanf(portbuf, "%u", &port);
+
+    printf("MBED: Server IP address received: %s:%d \n", ipbuf, port);
+
+    TLSSocket sock;
+    SocketAddress tls_addr(ipbuf, port);
+    // Connecting before open has no stack to resolve or connect with
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_NO_SOCKET, sock.connect(TLS_RESUME_HOSTNAME, port));
+
+    TEST_ASSERT_EQUAL(0, sock.set_root_ca_cert(mbedtls_test_ca_crt_ec));
+    TEST_ASSERT_EQUAL(0, sock.set_hostname(TLS_RESUME_HOSTNAME));
+
+    // First connection has nothing to resume
+    TEST_ASSERT_EQUAL(false, tls_echo(sock, eth, tls_addr, true));
+    TEST_ASSERT_EQUAL(true, sock.has_session());
+    tls_socket_stats_t full;
+    sock.get_stats(&full);
+
+    // Reconnects offer the saved session, blocking and non-blocking
+    TEST_ASSERT_EQUAL(true, tls_echo(sock, eth, tls_addr, true));
+    tls_socket_stats_t resumed;
+    sock.get_stats(&resumed);
+    TEST_ASSERT_EQUAL(true, tls_echo(sock, eth, tls_addr, false));
+
+    // Forgetting the session forces a full handshake again
+    sock.clear_session();
+    TEST_ASSERT_EQUAL(false, tls_echo(sock, eth, tls_addr, true));
+
+    tls_socket_stats_t stats;
+    sock.get_stats(&stats);
+    printf("MBED: handshakes=%lu resumed=%lu failures=%lu total=%lu ms max heap peak=%lu bytes\r\n",
+           (unsigned long)stats.handshakes, (unsigned long)stats.resumed,
+           (unsigned long)stats.failures, (unsigned long)stats.total_handshake_ms,
+           (unsigned long)stats.max_heap_peak);
+
+    TEST_ASSERT_EQUAL(4, stats.handshakes);
+    TEST_ASSERT_EQUAL(2, stats.resumed);
+    TEST_ASSERT_EQUAL(0, stats.failures);
+    // Resumption skips the certificate verify and ECDHE, which dominate
+    TEST_ASSERT(resumed.last_handshake_ms < full.last_handshake_ms);
+#if defined(MBEDTLS_PLATFORM_MEMORY)
+    TEST_ASSERT(stats.max_heap_peak > 0);
+    TEST_ASSERT(resumed.last_heap_peak <= full.last_heap_peak);
+
+    // The same again with all of the socket's mbed TLS memory in an arena
+    TLSSocket arena_sock;
+    TEST_ASSERT_EQUAL(0, arena_sock.set_arena(arena_buffer, sizeof(arena_buffer)));
+    TEST_ASSERT_EQUAL(0, arena_sock.set_root_ca_cert(mbedtls_test_ca_crt_ec));
+    TEST_ASSERT_EQUAL(0, arena_sock.set_hostname(TLS_RESUME_HOSTNAME));
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_PARAMETER, arena_sock.set_arena(arena_buffer, sizeof(arena_buffer)));
+
+    TEST_ASSERT_EQUAL(false, tls_echo(arena_sock, eth, tls_addr, true));
+    TEST_ASSERT_EQUAL(true, tls_echo(arena_sock, eth, tls_addr, true));
+
+    mbedtls_arena_stats arena_stats;
+    arena_sock.get_arena_stats(&arena_stats);
+    printf("MBED: arena size=%lu current=%lu peak=%lu blocks=%lu largest free=%lu\r\n",
+           (unsigned long)arena_stats.size, (unsigned long)arena_stats.current,
+           (unsigned long)arena_stats.peak, (unsigned long)arena_stats.blocks,
+           (unsigned long)arena_stats.largest_free);
+    TEST_ASSERT_EQUAL(0, arena_stats.failures);
+    TEST_ASSERT(arena_stats.current > 0);
+
+    arena_sock.get_stats(&stats);
+    TEST_ASSERT_EQUAL(2, stats.handshakes);
+    TEST_ASSERT_EQUAL(1, stats.resumed);
+    TEST_ASSERT(stats.last_heap_peak <= arena_stats.size);
+#endif
+
+    eth.disconnect();
+    GREENTEA_TESTSUITE_RESULT(true);
+}
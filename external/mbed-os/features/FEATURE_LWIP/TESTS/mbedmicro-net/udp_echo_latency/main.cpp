@@ -0,0 +1,159 @@
+#if !FEATURE_LWIP
+    #error [NOT_SUPPORTED] LWIP not supported for this target
+#endif
+#if DEVICE_EMAC
+    #error [NOT_SUPPORTED] Not supported for WiFi targets
+#endif
+
+#include "mbed.h"
+#include "EthernetInterface.h"
+#include "UDPSocket.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+
+#ifndef MBED_CFG_UDP_CLIENT_LATENCY_BUFFER_SIZE
+#define MBED_CFG_UDP_CLIENT_LATENCY_BUFFER_SIZE 64
+#endif
+
+#ifndef MBED_CFG_UDP_CLIENT_LATENCY_TIMEOUT
+#define MBED_CFG_UDP_CLIENT_LATENCY_TIMEOUT 500
+#endif
+
+#ifndef MBED_CFG_UDP_CLIENT_LATENCY_LOOPS
+#define MBED_CFG_UDP_CLIENT_LATENCY_LOOPS 64
+#endif
+
+#ifndef MBED_CFG_UDP_CLIENT_LATENCY_BURST
+#define MBED_CFG_UDP_CLIENT_LATENCY_BURST 256
+#endif
+
+
+// Measures the cost of each socket call as seen by the calling thread.  Build
+// once with lwip.tcpip-core-locking set to false and once with it set to true
+// to compare the tcpip thread mbox round trip against direct core locked calls.
+namespace {
+    char tx_buffer[MBED_CFG_UDP_CLIENT_LATENCY_BUFFER_SIZE] = {0};
+    char rx_buffer[MBED_CFG_UDP_CLIENT_LATENCY_BUFFER_SIZE] = {0};
+}
+
+struct LatencyStats {
+    uint32_t count;
+    uint32_t total;
+    uint32_t min;
+    uint32_t max;
+
+    LatencyStats() : count(0), total(0), min(0xFFFFFFFF), max(0) {}
+
+    void add(uint32_t us) {
+        count++;
+        total += us;
+        if (us < min) {
+            min = us;
+        }
+        if (us > max) {
+            max = us;
+        }
+    }
+
+    void print(const char *name) {
+        printf("MBED: %-8s calls=%lu min=%luus avg=%luus max=%luus\r\n", name,
+               (unsigned long)count, (unsigned long)min,
+               (unsigned long)(count ? total / count : 0), (unsigned long)max);
+    }
+};
+
+int main() {
+    GREENTEA_SETUP(120, "udp_echo");
+
+    EthernetInterface eth;
+    eth.connect();
+    printf("UDP client IP Address is %s\n", eth.get_ip_address());
+    printf("MBED: LWIP_TCPIP_CORE_LOCKING=%d\r\n", MBED_CONF_LWIP_TCPIP_CORE_LOCKING);
+
+    greentea_send_kv("target_ip", eth.get_ip_address());
+
+    char recv_key[] = "host_port";
+    char ipbuf[60] = {0};
+    char portbuf[16] = {0};
+    unsigned int port = 0;
+
+    UDPSocket sock;
+    sock.open(&eth);
+    sock.set_timeout(MBED_CFG_UDP_CLIENT_LATENCY_TIMEOUT);
+
+    greentea_send_kv("host_ip", " ");
+    greentea_parse_kv(recv_key, ipbuf, sizeof(recv_key), sizeof(ipbuf));
+
+    greentea_send_kv("host_port", " ");
+    greentea_parse_kv(recv_key, portbuf, sizeof(recv_key), sizeof(portbuf));
+    sscanf(portbuf, "%u", &port);
+
+    printf("MBED: UDP Server IP address received: %s:%d \n", ipbuf, port);
+    SocketAddress udp_addr(ipbuf, port);
+
+    LatencyStats sendto_stats;
+    LatencyStats recvfrom_stats;
+    LatencyStats rtt_stats;
+    Timer timer;
+    timer.start();
+
+    int success = 0;
+    for (int i = 0; i < MBED_CFG_UDP_CLIENT_LATENCY_LOOPS; i++) {
+        memset(tx_buffer, '0' + (i % 10), sizeof(tx_buffer));
+
+        uint32_t start = timer.read_us();
+        const int sent = sock.sendto(udp_addr, tx_buffer, sizeof(tx_buffer));
+        uint32_t sent_at = timer.read_us();
+
+        SocketAddress temp_addr;
+        const int n = sock.recvfrom(&temp_addr, rx_buffer, sizeof(rx_buffer));
+        uint32_t received_at = timer.read_us();
+
+        if (sent != sizeof(tx_buffer) || n != sizeof(rx_buffer) ||
+            memcmp(rx_buffer, tx_buffer, sizeof(rx_buffer)) != 0) {
+            continue;
+        }
+
+        success++;
+        sendto_stats.add(sent_at - start);
+        rtt_stats.add(received_at - start);
+    }
+
+    // Time only the recvfrom() call itself by letting the echo arrive first.
+    for (int i = 0; i < MBED_CFG_UDP_CLIENT_LATENCY_LOOPS / 4; i++) {
+        sock.sendto(udp_addr, tx_buffer, sizeof(tx_buffer));
+        wait_ms(10);
+
+        SocketAddress temp_addr;
+        uint32_t start = timer.read_us();
+        const int n = sock.recvfrom(&temp_addr, rx_buffer, sizeof(rx_buffer));
+        if (n == sizeof(rx_buffer)) {
+            recvfrom_stats.add(timer.read_us() - start);
+        }
+    }
+
+    // Back to back sends give the per-call throughput ceiling of the API path.
+    sock.set_blocking(false);
+    uint32_t burst_start = timer.read_us();
+    int burst_sent = 0;
+    for (int i = 0; i < MBED_CFG_UDP_CLIENT_LATENCY_BURST; i++) {
+        if (sock.sendto(udp_addr, tx_buffer, sizeof(tx_buffer)) > 0) {
+            burst_sent++;
+        }
+    }
+    uint32_t burst_time = timer.read_us() - burst_start;
+
+    sendto_stats.print("sendto");
+    recvfrom_stats.print("recvfrom");
+    rtt_stats.print("rtt");
+    printf("MBED: burst %d/%d packets of %d bytes in %luus (%lu calls/s)\r\n",
+           burst_sent, MBED_CFG_UDP_CLIENT_LATENCY_BURST, (int)sizeof(tx_buffer),
+           (unsigned long)burst_time,
+           (unsigned long)(burst_time ? (uint64_t)burst_sent * 1000000 / burst_time : 0));
+
+    bool result = (success > 3*MBED_CFG_UDP_CLIENT_LATENCY_LOOPS/4);
+
+    sock.close();
+    eth.disconnect();
+    GREENTEA_TESTSUITE_RESULT(result);
+}
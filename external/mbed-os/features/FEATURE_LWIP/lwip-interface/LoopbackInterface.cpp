@@ -0,0 +1,59 @@
+/* LWIP implementation of NetworkInterfaceAPI
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if DEVICE_EMAC
+
+#include "LoopbackInterface.h"
+#include "lwip_stack.h"
+#include "emac_loopback.h"
+
+
+LoopbackInterface::LoopbackInterface()
+    : _attached(false)
+{
+    set_network(LOOPBACK_INTERFACE_IP, LOOPBACK_INTERFACE_NETMASK, LOOPBACK_INTERFACE_PEER);
+}
+
+nsapi_error_t LoopbackInterface::connect()
+{
+    if (!_attached) {
+        emac_loopback_set_reflect(1, true);
+
+        nsapi_error_t err = mbed_lwip_init(emac_loopback_get_interface(0));
+        if (err != NSAPI_ERROR_OK) {
+            return err;
+        }
+
+        if (_poll_thread.start(mbed::callback(this, &LoopbackInterface::poll)) != osOK) {
+            return NSAPI_ERROR_NO_MEMORY;
+        }
+        _attached = true;
+    }
+
+    return EthernetInterface::connect();
+}
+
+void LoopbackInterface::poll()
+{
+    while (true) {
+        // Keep the frames moving while there are any, then let the stack run
+        if (emac_loopback_poll() == 0) {
+            rtos::Thread::wait(1);
+        }
+    }
+}
+
+#endif /* DEVICE_EMAC */
@@ -0,0 +1,71 @@
+/* LWIP implementation of NetworkInterfaceAPI
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LOOPBACK_INTERFACE_H
+#define LOOPBACK_INTERFACE_H
+
+#if DEVICE_EMAC
+
+#include "EthernetInterface.h"
+
+/** Default local address of a LoopbackInterface */
+#define LOOPBACK_INTERFACE_IP       "10.0.0.1"
+#define LOOPBACK_INTERFACE_NETMASK  "255.255.255.0"
+
+/** Address on the far end of the loopback cable, any other address on the
+ *  subnet works as well */
+#define LOOPBACK_INTERFACE_PEER     "10.0.0.2"
+
+
+/** LoopbackInterface class
+ *  Runs LWIP over port 0 of the software loopback EMAC, with port 1 set to
+ *  reflect, so sockets can be tested without a network or Ethernet hardware.
+ *
+ *  Every packet sent to an address on the subnet other than the interface's
+ *  own goes out through the EMAC and comes back in as though that address had
+ *  sent it to the interface.  A TCPServer or bound UDPSocket on the interface
+ *  therefore answers clients which connect to LOOPBACK_INTERFACE_PEER, with
+ *  each segment crossing the EMAC, ARP and the full input path both ways.
+ *
+ *  The lwIP binding supports a single network interface so this must be the
+ *  only one brought up in the application.  Like the loopback EMAC it is only
+ *  built for targets which provide DEVICE_EMAC.
+ */
+class LoopbackInterface : public EthernetInterface
+{
+public:
+    /** LoopbackInterface lifetime
+     *  Starts with the static LOOPBACK_INTERFACE_IP address, there being no
+     *  DHCP server on the loopback cable.
+     */
+    LoopbackInterface();
+
+    /** Attach lwIP to the loopback EMAC, start the thread moving frames
+     *  along the cable and bring the interface up
+     *  @return             0 on success, negative on failure
+     */
+    virtual nsapi_error_t connect();
+
+protected:
+    void poll();
+
+    rtos::Thread _poll_thread;
+    bool _attached;
+};
+
+#endif /* DEVICE_EMAC */
+
+#endif
@@ -37,6 +37,7 @@
 #include "lpc17xx_emac.h"
 #include "eth_arch.h"
 #include "lpc_emac_config.h"
+#include "lpc_emac_stats.h"
 #include "lpc_phy.h"
 #include "sys_arch.h"
 
@@ -55,6 +56,14 @@
 #error LPC_NUM_BUFF_RXDESCS must be at least 3
 #endif
 
+#if LPC_NUM_RX_POOL_BUFFS < LPC_NUM_BUFF_RXDESCS
+#error LPC_NUM_RX_POOL_BUFFS must be at least LPC_NUM_BUFF_RXDESCS
+#endif
+
+#if !LWIP_SUPPORT_CUSTOM_PBUF
+#error LWIP_SUPPORT_CUSTOM_PBUF is needed for the RX buffer pool
+#endif
+
 /** @defgroup lwip17xx_emac_DRIVER	lpc17 EMAC driver for LWIP
  * @ingroup lwip_emac
  *
@@ -114,6 +123,18 @@ typedef struct
 	volatile u32_t statushashcrc; /**< RX hash CRC */
 } LPC_TXRX_STATUS_T;
 
+/** \brief  RX pool buffer
+ *
+ * Received frames are passed up to the stack in place. The pbuf_custom
+ * must come first so the stack's pbuf pointer can be cast back to this.
+ */
+struct lpc_rx_pbuf
+{
+	struct pbuf_custom pc;       /**< pbuf seen by the stack */
+	struct lpc_rx_pbuf *next;    /**< Next buffer on the free list */
+	u32_t data[EMAC_ETH_MAX_FLEN / sizeof(u32_t)]; /**< Frame buffer, word aligned for DMA */
+};
+
 /* LPC EMAC driver data structure */
 struct lpc_enetdata {
     /* prxs must be 8 byte aligned! */
@@ -126,7 +147,11 @@ struct lpc_enetdata {
 	u32_t rx_fill_desc_index; /**< RX descriptor next available index */
 	volatile u32_t rx_free_descs; /**< Count of free RX descriptors */
 	struct pbuf *txb[LPC_NUM_BUFF_TXDESCS]; /**< TX pbuf pointer list, zero-copy mode */
+	struct pbuf *txbounce[LPC_NUM_BUFF_TXDESCS]; /**< TX bounce buffer list, freed with the descriptor */
 	u32_t lpc_last_tx_idx; /**< TX last descriptor index, zero-copy mode */
+	struct lpc_rx_pbuf *rx_pool_free; /**< Free RX pool buffers */
+	u32_t rx_pool_count; /**< Number of buffers on rx_pool_free */
+	lpc_emac_stats_t stats; /**< Drop and starvation counters */
 #if NO_SYS == 0
 	sys_thread_t RxThread; /**< RX receive thread data object pointer */
 	sys_sem_t TxCleanSem; /**< TX cleanup thread wakeup semaphore */
@@ -157,6 +182,78 @@ struct lpc_enetdata {
  */
 ETHMEM_SECTION struct lpc_enetdata lpc_enetdata;
 
+/** \brief  RX buffer pool, must be DMA safe like the descriptors
+ */
+ETHMEM_SECTION static struct lpc_rx_pbuf lpc_rx_pool[LPC_NUM_RX_POOL_BUFFS];
+
+/** \brief  Returns an RX buffer to the pool once the stack frees it
+ *
+ *  \param[in] p  pbuf being freed, always one of the lpc_rx_pool entries
+ */
+static void lpc_rx_pool_free(struct pbuf *p)
+{
+	struct lpc_rx_pbuf *rb = (struct lpc_rx_pbuf *) p;
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	SYS_ARCH_PROTECT(lev);
+	rb->next = lpc_enetdata.rx_pool_free;
+	lpc_enetdata.rx_pool_free = rb;
+	lpc_enetdata.rx_pool_count++;
+	SYS_ARCH_UNPROTECT(lev);
+
+#if NO_SYS == 0
+	/* Let the receive task refill descriptors left empty by a shortage */
+	if (lpc_enetdata.rx_free_descs > 0)
+		osSignalSet(lpc_enetdata.RxThread->id, RX_SIGNAL);
+#endif
+}
+
+/** \brief  Takes a buffer from the RX pool
+ *
+ *  \param[in] lpc_enetif  Pointer to the driver data structure
+ *  \returns               A maximum sized pbuf, or NULL if the pool is empty
+ */
+static struct pbuf *lpc_rx_pool_alloc(struct lpc_enetdata *lpc_enetif)
+{
+	struct lpc_rx_pbuf *rb;
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	SYS_ARCH_PROTECT(lev);
+	rb = lpc_enetif->rx_pool_free;
+	if (rb != NULL) {
+		lpc_enetif->rx_pool_free = rb->next;
+		lpc_enetif->rx_pool_count--;
+		if (lpc_enetif->rx_pool_count < lpc_enetif->stats.rx_pool_low)
+			lpc_enetif->stats.rx_pool_low = lpc_enetif->rx_pool_count;
+	}
+	SYS_ARCH_UNPROTECT(lev);
+
+	if (rb == NULL)
+		return NULL;
+
+	/* PBUF_REF so the stack never tries to grow headers into the buffer */
+	rb->pc.custom_free_function = lpc_rx_pool_free;
+	return pbuf_alloced_custom(PBUF_RAW, (u16_t) EMAC_ETH_MAX_FLEN, PBUF_REF,
+		&rb->pc, rb->data, (u16_t) sizeof(rb->data));
+}
+
+/** \brief  Puts every RX pool buffer on the free list
+ *
+ *  \param[in] lpc_enetif  Pointer to the driver data structure
+ */
+static void lpc_rx_pool_init(struct lpc_enetdata *lpc_enetif)
+{
+	s32_t idx;
+
+	lpc_enetif->rx_pool_free = NULL;
+	for (idx = 0; idx < LPC_NUM_RX_POOL_BUFFS; idx++) {
+		lpc_rx_pool[idx].next = lpc_enetif->rx_pool_free;
+		lpc_enetif->rx_pool_free = &lpc_rx_pool[idx];
+	}
+	lpc_enetif->rx_pool_count = LPC_NUM_RX_POOL_BUFFS;
+	lpc_enetif->stats.rx_pool_low = LPC_NUM_RX_POOL_BUFFS;
+}
+
 /** \brief  Queues a pbuf into the RX descriptor list
  *
  *  \param[in] lpc_enetif Pointer to the drvier data structure
@@ -206,21 +303,17 @@ s32_t lpc_rx_queue(struct netif *netif)
 
 	/* Attempt to requeue as many packets as possible */
 	while (lpc_enetif->rx_free_descs > 0) {
-		/* Allocate a pbuf from the pool. We need to allocate at the
+		/* Take a buffer from the driver's RX pool. Pool buffers are
 		   maximum size as we don't know the size of the yet to be
 		   received packet. */
-		p = pbuf_alloc(PBUF_RAW, (u16_t) EMAC_ETH_MAX_FLEN, PBUF_RAM);
+		p = lpc_rx_pool_alloc(lpc_enetif);
 		if (p == NULL) {
 			LWIP_DEBUGF(UDP_LPC_EMAC | LWIP_DBG_TRACE,
-				("lpc_rx_queue: could not allocate RX pbuf (free desc=%d)\n",
+				("lpc_rx_queue: RX pool empty (free desc=%d)\n",
 				lpc_enetif->rx_free_descs));
 			return queued;
 		}
 
-		/* pbufs allocated from the RAM pool should be non-chained. */
-		LWIP_ASSERT("lpc_rx_queue: pbuf is not contiguous (chained)",
-			pbuf_clen(p) <= 1);
-
 		/* Queue packet */
 		lpc_rxqueue_pbuf(lpc_enetif, p);
 
@@ -282,6 +375,7 @@ static struct pbuf *lpc_low_level_input(struct netif *netif)
 	if (LPC_EMAC->IntStatus & EMAC_INT_RX_OVERRUN) {
 		LINK_STATS_INC(link.err);
 		LINK_STATS_INC(link.drop);
+		lpc_enetif->stats.rx_overruns++;
 
 		/* Temporarily disable RX */
 		LPC_EMAC->MAC1 &= ~EMAC_MAC1_REC_EN;
@@ -330,6 +424,7 @@ static struct pbuf *lpc_low_level_input(struct netif *netif)
 
 			/* Drop the frame */
 			LINK_STATS_INC(link.drop);
+			lpc_enetif->stats.rx_dropped_err++;
 
 			/* Re-queue the pbuf for receive */
 			lpc_enetif->rx_free_descs++;
@@ -357,8 +452,9 @@ static struct pbuf *lpc_low_level_input(struct netif *netif)
 
 			/* Attempt to queue new buffer(s) */
 			if (lpc_rx_queue(lpc_enetif->netif) == 0) {
-    			/* Drop the frame due to OOM. */
+    			/* Drop the frame, the stack is holding every pool buffer. */
     			LINK_STATS_INC(link.drop);
+    			lpc_enetif->stats.rx_dropped_starved++;
 
     			/* Re-queue the pbuf for receive */
     			p->len = origLength;
@@ -384,6 +480,7 @@ static struct pbuf *lpc_low_level_input(struct netif *netif)
 			/* Save size */
 			p->tot_len = (u16_t) length;
 			LINK_STATS_INC(link.recv);
+			lpc_enetif->stats.rx_frames++;
 		}
 	}
 
@@ -449,6 +546,8 @@ static err_t lpc_tx_setup(struct lpc_enetdata *lpc_enetif)
 	for (idx = 0; idx < LPC_NUM_BUFF_TXDESCS; idx++) {
 		lpc_enetif->ptxd[idx].control = 0;
 		lpc_enetif->ptxs[idx].statusinfo = 0xFFFFFFFF;
+		lpc_enetif->txb[idx] = NULL;
+		lpc_enetif->txbounce[idx] = NULL;
 	}
 
 	/* Setup pointers to TX structures */
@@ -482,6 +581,10 @@ static void lpc_tx_reclaim_st(struct lpc_enetdata *lpc_enetif, u32_t cidx)
 			pbuf_free(lpc_enetif->txb[lpc_enetif->lpc_last_tx_idx]);
 		 	lpc_enetif->txb[lpc_enetif->lpc_last_tx_idx] = NULL;
 		}
+		if (lpc_enetif->txbounce[lpc_enetif->lpc_last_tx_idx] != NULL) {
+			pbuf_free(lpc_enetif->txbounce[lpc_enetif->lpc_last_tx_idx]);
+			lpc_enetif->txbounce[lpc_enetif->lpc_last_tx_idx] = NULL;
+		}
 
 #if NO_SYS == 0
 		osSemaphoreRelease(lpc_enetif->xTXDCountSem.id);
@@ -545,10 +648,13 @@ static err_t lpc_low_level_output(struct netif *netif, struct pbuf *p)
 {
 	struct lpc_enetdata *lpc_enetif = netif->state;
 	struct pbuf *q;
-	u8_t *dst;
     u32_t idx, notdmasafe = 0;
-	struct pbuf *np;
+	struct pbuf *np = NULL;
 	s32_t dn;
+#if LPC_TX_PBUF_BOUNCE_EN==1
+	struct pbuf *bounce[LPC_NUM_BUFF_TXDESCS];
+	s32_t bn;
+#endif
 
 	/* Zero-copy TX buffers may be fragmented across mutliple payload
 	   chains. Determine the number of descriptors needed for the
@@ -562,36 +668,53 @@ static err_t lpc_low_level_output(struct netif *netif, struct pbuf *p)
 		notdmasafe += lpc_packet_addr_notsafe(q->payload);
 
 #if LPC_TX_PBUF_BOUNCE_EN==1
-	/* If the pbuf is not DMA safe, a new bounce buffer (pbuf) will be
-	   created that will be used instead. This requires an copy from the
-	   non-safe DMA region to the new pbuf */
-	if (notdmasafe) {
-		/* Allocate a pbuf in DMA memory */
+	if (dn >= LPC_NUM_BUFF_TXDESCS) {
+		/* The chain would never fit in the descriptor ring, so copy it
+		   into a single contiguous bounce buffer (pbuf) instead. */
 		np = pbuf_alloc(PBUF_RAW, p->tot_len, PBUF_RAM);
-		if (np == NULL)
+		if (np == NULL) {
+			lpc_enetif->stats.tx_dropped_nomem++;
 			return ERR_MEM;
+		}
 
 		/* This buffer better be contiguous! */
 		LWIP_ASSERT("lpc_low_level_output: New transmit pbuf is chained",
 			(pbuf_clen(np) == 1));
-
-		/* Copy to DMA safe pbuf */
-		dst = (u8_t *) np->payload;
-	 	for(q = p; q != NULL; q = q->next) {
-			/* Copy the buffer to the descriptor's buffer */
-	  		MEMCPY(dst, (u8_t *) q->payload, q->len);
-		  dst += q->len;
-		}
-		np->len = p->tot_len;
+		pbuf_copy(np, p);
+		lpc_enetif->stats.tx_bounced++;
+		lpc_enetif->stats.tx_bounced_bytes += p->tot_len;
 
 		LWIP_DEBUGF(UDP_LPC_EMAC | LWIP_DBG_TRACE,
 			("lpc_low_level_output: Switched to DMA safe buffer, old=%p, new=%p\n",
-			q, np));
+			p, np));
 
 		/* use the new buffer for descrptor queueing. The original pbuf will
 		   be de-allocated outsuide this driver. */
 		p = np;
 		dn = 1;
+		notdmasafe = 0;
+	} else if (notdmasafe) {
+		/* Only the pbufs that are not DMA safe get copied, each into its
+		   own bounce buffer. The rest of the chain is still sent straight
+		   from AHB SRAM. */
+		for (q = p, bn = 0; q != NULL; q = q->next, bn++) {
+			bounce[bn] = NULL;
+			if (!lpc_packet_addr_notsafe(q->payload))
+				continue;
+
+			bounce[bn] = pbuf_alloc(PBUF_RAW, q->len, PBUF_RAM);
+			if (bounce[bn] == NULL) {
+				while (bn-- > 0) {
+					if (bounce[bn] != NULL)
+						pbuf_free(bounce[bn]);
+				}
+				lpc_enetif->stats.tx_dropped_nomem++;
+				return ERR_MEM;
+			}
+			MEMCPY(bounce[bn]->payload, q->payload, q->len);
+			lpc_enetif->stats.tx_bounced++;
+			lpc_enetif->stats.tx_bounced_bytes += q->len;
+		}
 	}
 #else
 	if (notdmasafe)
@@ -601,6 +724,8 @@ static err_t lpc_low_level_output(struct netif *netif, struct pbuf *p)
 
 	/* Wait until enough descriptors are available for the transfer. */
 	/* THIS WILL BLOCK UNTIL THERE ARE ENOUGH DESCRIPTORS AVAILABLE */
+	if (dn > lpc_tx_ready(netif))
+		lpc_enetif->stats.tx_desc_starved++;
 	while (dn > lpc_tx_ready(netif))
 #if NO_SYS == 0
 	    osSemaphoreWait(lpc_enetif->xTXDCountSem.id, osWaitForever);
@@ -618,14 +743,29 @@ static err_t lpc_low_level_output(struct netif *netif, struct pbuf *p)
 
 	/* Prevent LWIP from de-allocating this pbuf. The driver will
 	   free it once it's been transmitted. */
-	if (!notdmasafe)
+	if (np == NULL)
 		pbuf_ref(p);
 
 	/* Setup transfers */
 	q = p;
+#if LPC_TX_PBUF_BOUNCE_EN==1
+	bn = 0;
+#endif
 	while (dn > 0) {
+		u8_t *payload = (u8_t *) q->payload;
+
 		dn--;
 
+		lpc_enetif->txbounce[idx] = NULL;
+#if LPC_TX_PBUF_BOUNCE_EN==1
+		if (notdmasafe && bounce[bn] != NULL) {
+			/* Bounce buffer is freed with its descriptor */
+			lpc_enetif->txbounce[idx] = bounce[bn];
+			payload = (u8_t *) bounce[bn]->payload;
+		}
+		bn++;
+#endif
+
 		/* Only save pointer to free on last descriptor */
 		if (dn == 0) {
 			/* Save size of packet and signal it's ready */
@@ -641,9 +781,9 @@ static err_t lpc_low_level_output(struct netif *netif, struct pbuf *p)
 
 		LWIP_DEBUGF(UDP_LPC_EMAC | LWIP_DBG_TRACE,
 			("lpc_low_level_output: pbuf packet(%p) sent, chain#=%d,"
-			" size = %d (index=%d)\n", q->payload, dn, q->len, idx));
+			" size = %d (index=%d)\n", payload, dn, q->len, idx));
 
-		lpc_enetif->ptxd[idx].packet = (u32_t) q->payload;
+		lpc_enetif->ptxd[idx].packet = (u32_t) payload;
 
 		q = q->next;
 
@@ -655,6 +795,7 @@ static err_t lpc_low_level_output(struct netif *netif, struct pbuf *p)
 	LPC_EMAC->TxProduceIndex = idx;
 
 	LINK_STATS_INC(link.xmit);
+	lpc_enetif->stats.tx_frames++;
 
 #if NO_SYS == 0
 	/* Restore access */
@@ -713,6 +854,10 @@ static void packet_rx(void* pvParameters) {
         /* Wait for receive task to wakeup */
         osSignalWait(RX_SIGNAL, osWaitForever);
 
+        /* Refill descriptors left empty while the RX pool was exhausted */
+        if (lpc_enetif->rx_free_descs > 0)
+            lpc_rx_queue(lpc_enetif->netif);
+
         /* Process packets until all empty */
         while (LPC_EMAC->RxConsumeIndex != LPC_EMAC->RxProduceIndex)
             lpc_enetif_input(lpc_enetif->netif);
@@ -741,6 +886,7 @@ static void packet_tx(void* pvParameters) {
         if (LPC_EMAC->IntStatus & EMAC_INT_TX_UNDERRUN) {
             LINK_STATS_INC(link.err);
             LINK_STATS_INC(link.drop);
+            lpc_enetif->stats.tx_underruns++;
 
 #if NO_SYS == 0
             /* Get exclusive access */
@@ -756,6 +902,10 @@ static void packet_tx(void* pvParameters) {
                     pbuf_free(lpc_enetif->txb[idx]);
                     lpc_enetif->txb[idx] = NULL;
                 }
+                if (lpc_enetif->txbounce[idx] != NULL) {
+                    pbuf_free(lpc_enetif->txbounce[idx]);
+                    lpc_enetif->txbounce[idx] = NULL;
+                }
             }
 
 #if NO_SYS == 0
@@ -854,6 +1004,8 @@ static err_t low_level_init(struct netif *netif)
 		(((u32_t) netif->hwaddr[5]) << 8);
 
 	/* Setup transmit and receive descriptors */
+	memset(&lpc_enetif->stats, 0, sizeof(lpc_enetif->stats));
+	lpc_rx_pool_init(lpc_enetif);
 	if (lpc_tx_setup(lpc_enetif) != ERR_OK)
 		return ERR_BUF;
 	if (lpc_rx_setup(lpc_enetif) != ERR_OK)
@@ -1054,6 +1206,25 @@ void eth_arch_disable_interrupts(void) {
     NVIC_DisableIRQ(ENET_IRQn);
 }
 
+void lpc_emac_get_stats(lpc_emac_stats_t *stats)
+{
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	SYS_ARCH_PROTECT(lev);
+	*stats = lpc_enetdata.stats;
+	SYS_ARCH_UNPROTECT(lev);
+}
+
+void lpc_emac_reset_stats(void)
+{
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	SYS_ARCH_PROTECT(lev);
+	memset(&lpc_enetdata.stats, 0, sizeof(lpc_enetdata.stats));
+	lpc_enetdata.stats.rx_pool_low = lpc_enetdata.rx_pool_count;
+	SYS_ARCH_UNPROTECT(lev);
+}
+
 /**
  * @}
  */
@@ -79,9 +79,23 @@ extern "C"
 #define LPC_EMAC_RMII 1         /**< Use the RMII or MII driver variant .*/
 
 /** \brief  Defines the number of descriptors used for RX. This
- *          must be a minimum value of 2.
+ *          must be a minimum value of 3.
  */
-#define LPC_NUM_BUFF_RXDESCS 3
+#ifndef LPC_NUM_BUFF_RXDESCS
+#define LPC_NUM_BUFF_RXDESCS 4
+#endif
+
+/** \brief  Defines the number of maximum sized RX buffers in the driver's
+ *          receive pool. Received frames are passed up to the stack in
+ *          these buffers without copying and each buffer is returned to
+ *          the pool when the stack frees it. Buffers beyond
+ *          LPC_NUM_BUFF_RXDESCS are what the stack can hold on to before
+ *          the descriptors run dry and frames start getting dropped. Must
+ *          be at least LPC_NUM_BUFF_RXDESCS.
+ */
+#ifndef LPC_NUM_RX_POOL_BUFFS
+#define LPC_NUM_RX_POOL_BUFFS (LPC_NUM_BUFF_RXDESCS + 2)
+#endif
 
 /** \brief  Defines the number of descriptors used for TX. Must
  *          be a minimum value of 2.
@@ -94,9 +108,12 @@ extern "C"
  *          cannot be used for transmit DMA operations. If this define is
  *          set to 1, an extra check will be made with the pbufs. If a buffer
  *          is determined to be non-usable for zero-copy, a temporary bounce
- *          buffer will be created and used instead.
+ *          buffer will be created for just that pbuf and the rest of the
+ *          chain is still sent directly from AHB SRAM.
  */
+#ifndef LPC_TX_PBUF_BOUNCE_EN
 #define LPC_TX_PBUF_BOUNCE_EN 1
+#endif
 
 /**		  
  * @}
@@ -0,0 +1,61 @@
+/**********************************************************************
+* @file		lpc_emac_stats.h
+* @brief	LPC17xx/40xx EMAC driver counters
+**********************************************************************/
+
+#ifndef __LPC_EMAC_STATS_H
+#define __LPC_EMAC_STATS_H
+
+#include "lwip/opt.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** @defgroup lwip_emac_stats	LWIP EMAC driver counters
+ * @ingroup lwip_emac
+ *
+ * Counters kept by the LPC EMAC driver for tuning LPC_NUM_BUFF_RXDESCS,
+ * LPC_NUM_RX_POOL_BUFFS and LPC_NUM_BUFF_TXDESCS in the field.
+ * @{
+ */
+
+/** \brief  Snapshot of the EMAC driver counters
+ */
+typedef struct
+{
+	u32_t rx_frames;          /**< Frames passed up to the stack */
+	u32_t rx_dropped_err;     /**< Frames dropped for CRC, symbol, alignment or length errors */
+	u32_t rx_dropped_starved; /**< Frames dropped because no pool buffer was free to refill the descriptor */
+	u32_t rx_overruns;        /**< RX overruns, each one resets the receive side */
+	u32_t rx_pool_low;        /**< Fewest free RX pool buffers seen since reset */
+	u32_t tx_frames;          /**< Frames queued to the EMAC */
+	u32_t tx_bounced;         /**< pbufs copied to a bounce buffer because they were not DMA safe */
+	u32_t tx_bounced_bytes;   /**< Bytes copied to bounce buffers */
+	u32_t tx_dropped_nomem;   /**< Frames dropped because a bounce buffer could not be allocated */
+	u32_t tx_desc_starved;    /**< Times a transmit had to wait for free TX descriptors */
+	u32_t tx_underruns;       /**< TX underruns, each one resets the transmit side */
+} lpc_emac_stats_t;
+
+/** \brief  Read the EMAC driver counters
+ *
+ *  \param[out] stats  Where to copy the counters
+ */
+void lpc_emac_get_stats(lpc_emac_stats_t *stats);
+
+/** \brief  Zero the EMAC driver counters
+ */
+void lpc_emac_reset_stats(void);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LPC_EMAC_STATS_H */
+
+/* --------------------------------- End Of File ------------------------------ */
@@ -27,4 +27,7 @@
 #define MEM_SIZE                      16362
 #endif
 
+// RX frames are handed to the stack in the EMAC driver's own pool buffers
+#define LWIP_SUPPORT_CUSTOM_PBUF      1
+
 #endif
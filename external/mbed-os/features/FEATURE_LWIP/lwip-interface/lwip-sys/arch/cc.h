@@ -70,16 +70,22 @@
     #define ALIGNED(n)  __attribute__((aligned (n)))
 #endif 
 
+/* Portable C copy with checksum, reference for the Thumb-2 version */
+uint16_t generic_chksum_copy(void* pDest, const void* pSource, int length);
+
 /* Provide Thumb-2 routines for GCC to improve performance */
 #if defined(TOOLCHAIN_GCC) && defined(__thumb2__)
     #define MEMCPY(dst,src,len)     thumb2_memcpy(dst,src,len)
     #define LWIP_CHKSUM             thumb2_checksum
+    /* Copy application data into pbufs and checksum it in one pass */
+    #define LWIP_CHKSUM_COPY(dst,src,len) thumb2_chksum_copy(dst,src,len)
     /* Set algorithm to 0 so that unused lwip_standard_chksum function
        doesn't generate compiler warning */
     #define LWIP_CHKSUM_ALGORITHM   0
 
     void* thumb2_memcpy(void* pDest, const void* pSource, size_t length);
     uint16_t thumb2_checksum(const void* pData, int length);
+    uint16_t thumb2_chksum_copy(void* pDest, const void* pSource, int length);
 #else
     /* Used with IP headers only */
     #define LWIP_CHKSUM_ALGORITHM   1
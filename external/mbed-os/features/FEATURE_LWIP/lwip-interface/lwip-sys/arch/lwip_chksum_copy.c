@@ -0,0 +1,165 @@
+/* Copyright (C) 2017 - Adam Green (https://github.com/adamgreen)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include <stdint.h>
+
+
+/* Portable C version of the copy with checksum used by lwIP when
+   LWIP_CHECKSUM_ON_COPY is enabled.  It copies one byte pair at a time and
+   sums each pair as a 16-bit word in native byte order, so it produces
+   exactly the same result as lwip_standard_chksum() run over the copied data.
+   It is the reference the Thumb-2 version below is tested against.
+
+   Returns:
+        16-bit 1's complement summation (not inversed).
+*/
+uint16_t generic_chksum_copy(void* pDest, const void* pSource, int length)
+{
+    uint8_t*       pDst = (uint8_t*)pDest;
+    const uint8_t* pSrc = (const uint8_t*)pSource;
+    uint32_t       sum = 0;
+    union
+    {
+        uint16_t u16;
+        uint8_t  u8[2];
+    } word;
+
+    while (length >= 2)
+    {
+        word.u8[0] = *pDst++ = *pSrc++;
+        word.u8[1] = *pDst++ = *pSrc++;
+        sum += word.u16;
+        length -= 2;
+    }
+    if (length > 0)
+    {
+        /* Trailing byte is summed as if it was followed by a zero pad byte. */
+        word.u8[0] = *pDst = *pSrc;
+        word.u8[1] = 0;
+        sum += word.u16;
+    }
+
+    sum = (sum >> 16) + (sum & 0xFFFF);
+    sum = (sum >> 16) + (sum & 0xFFFF);
+    return (uint16_t)sum;
+}
+
+
+#if defined(TOOLCHAIN_GCC) && defined(__thumb2__)
+
+/* This is a hand written Thumb-2 assembly language version of
+   generic_chksum_copy() which does the copy and the checksum in a single pass
+   over the data.  It merges the 32-bit at a time loads and stores of
+   thumb2_memcpy() with the 32-bit at a time end-around carry summation of
+   thumb2_checksum() and unrolls the loop to handle 16 bytes per iteration.
+
+   The summation is done relative to the start of the source buffer rather
+   than to an aligned address, so no byte swap is required at the end.  Each
+   32-bit word summed is the two 16-bit words the standard algorithm would
+   have summed and the 1's complement sum of either is the same once folded.
+   Source and destination may have any alignment since Cortex-M3/M4 LDR/STR
+   support unaligned accesses.
+
+   The carry chain already retires a full word per cycle so there is nothing
+   for the Cortex-M4 SIMD adds (UADD16/UADD8) to win here; they would need
+   extra instructions to recover the per lane carries.  The same code is
+   used for both cores.
+
+   Returns:
+        16-bit 1's complement summation (not inversed).
+
+   NOTE: This function does return a uint16_t from the assembly language code
+         but is marked as void so that GCC doesn't issue warning because it
+         doesn't know about this low level return.
+*/
+__attribute__((naked)) void /*uint16_t*/ thumb2_chksum_copy(void* pDest, const void* pSource, int length)
+{
+    __asm (
+        ".syntax unified\n"
+        ".thumb\n"
+
+        // Push non-volatile registers we use on stack.  Push link register too to
+        // keep stack 8-byte aligned and allow single pop to restore and return.
+        "    push    {r4-r6, lr}\n"
+        // Initialize sum, r3, to 0.
+        "    movs    r3, #0\n"
+
+        // Main loop which copies and sums 16 bytes at a time.
+        // Make sure that we have more than 15 bytes left to copy.
+        "1$:\n"
+        "    cmp     r2, #16\n"
+        "    blt     2$\n"
+        "    ldr     r4, [r1], #4\n"
+        "    ldr     r5, [r1], #4\n"
+        "    ldr     r6, [r1], #4\n"
+        "    ldr     r12, [r1], #4\n"
+        "    str     r4, [r0], #4\n"
+        "    str     r5, [r0], #4\n"
+        "    str     r6, [r0], #4\n"
+        "    str     r12, [r0], #4\n"
+        // Sum the four words, carrying from each add into the next and
+        // wrapping the final carry back around into the lower bits.
+        "    adds    r3, r3, r4\n"
+        "    adcs    r3, r3, r5\n"
+        "    adcs    r3, r3, r6\n"
+        "    adcs    r3, r3, r12\n"
+        "    adc     r3, r3, #0\n"
+        "    subs    r2, r2, #16\n"
+        "    b       1$\n"
+
+        // Copy and sum any remaining words.
+        "2$:\n"
+        "    cmp     r2, #4\n"
+        "    blt     3$\n"
+        "    ldr     r4, [r1], #4\n"
+        "    str     r4, [r0], #4\n"
+        "    adds    r3, r3, r4\n"
+        "    adc     r3, r3, #0\n"
+        "    subs    r2, r2, #4\n"
+        "    b       2$\n"
+
+        // Copy and sum remaining half-word, if it exists.
+        "3$:\n"
+        "    cmp     r2, #2\n"
+        "    blt     4$\n"
+        "    ldrh    r4, [r1], #2\n"
+        "    strh    r4, [r0], #2\n"
+        "    adds    r3, r3, r4\n"
+        "    adc     r3, r3, #0\n"
+        "    subs    r2, r2, #2\n"
+
+        // Handle trailing byte, if it exists.
+        "4$:\n"
+        "    cbz     r2, 5$\n"
+        "    ldrb    r4, [r1]\n"
+        "    strb    r4, [r0]\n"
+        "    adds    r3, r3, r4\n"
+        "    adc     r3, r3, #0\n"
+
+        // Fold 32-bit checksum into 16-bit checksum.
+        "5$:\n"
+        "    ubfx    r4, r3, #16, #16\n"
+        "    ubfx    r3, r3, #0, #16\n"
+        "    adds    r3, r4\n"
+        "    ubfx    r4, r3, #16, #16\n"
+        "    ubfx    r3, r3, #0, #16\n"
+        "    adds    r3, r4\n"
+
+        // Return final sum.
+        "    mov     r0, r3\n"
+        "    pop     {r4-r6, pc}\n"
+    );
+}
+
+#endif
@@ -343,6 +343,9 @@ err_t sys_mutex_new(sys_mutex_t *mutex) {
 }
 
 /** Lock a mutex
+ *  With LWIP_TCPIP_CORE_LOCKING this is the lwIP core lock taken around every
+ *  netconn API call, so it relies on the priority inheritance of RTX mutexes
+ *  to keep a low priority socket user from starving the tcpip thread.
  * @param mutex the mutex to lock */
 void sys_mutex_lock(sys_mutex_t *mutex) {
     if (osMutexWait(mutex->id, osWaitForever) != osOK)
@@ -358,7 +361,11 @@ void sys_mutex_unlock(sys_mutex_t *mutex) {
 
 /** Delete a mutex
  * @param mutex the mutex to delete */
-void sys_mutex_free(sys_mutex_t *mutex) {}
+void sys_mutex_free(sys_mutex_t *mutex) {
+    if (osMutexDelete(mutex->id) != osOK)
+        error("sys_mutex_free error\n");
+    sys_mutex_set_invalid(mutex);
+}
 
 /*---------------------------------------------------------------------------*
  * Routine:  sys_init
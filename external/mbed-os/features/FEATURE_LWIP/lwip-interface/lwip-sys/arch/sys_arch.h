@@ -50,6 +50,9 @@ typedef struct {
 #endif
 } sys_mutex_t;
 
+#define sys_mutex_valid(x)        (((*x).id == NULL) ? 0 : 1)
+#define sys_mutex_set_invalid(x)  ( (*x).id = NULL)
+
 // === MAIL BOX ===
 #define MB_SIZE      8
 
@@ -88,6 +88,19 @@
 
 #define TCPIP_THREAD_PRIO           (osPriorityNormal)
 
+// Execute netconn API calls in the caller's context while holding the core
+// mutex rather than round tripping each call through the tcpip thread's mbox.
+#if MBED_CONF_LWIP_TCPIP_CORE_LOCKING
+#define LWIP_TCPIP_CORE_LOCKING     1
+#else
+#define LWIP_TCPIP_CORE_LOCKING     0
+#endif
+#if MBED_CONF_LWIP_TCPIP_CORE_LOCKING && MBED_CONF_LWIP_TCPIP_CORE_LOCKING_INPUT
+#define LWIP_TCPIP_CORE_LOCKING_INPUT 1
+#else
+#define LWIP_TCPIP_CORE_LOCKING_INPUT 0
+#endif
+
 #ifdef LWIP_DEBUG
 #define DEFAULT_THREAD_STACKSIZE    512*2
 #else
@@ -105,10 +118,55 @@
 
 #define LWIP_RAM_HEAP_POINTER       lwip_ram_heap
 
+// Memory profiles selected through lwip.memory-profile.  Each one trades RAM
+// for throughput; individual values can still be overridden by a target's
+// lwipopts_conf.h.
+#define LWIP_MEMORY_PROFILE_SMALL       0
+#define LWIP_MEMORY_PROFILE_BALANCED    1
+#define LWIP_MEMORY_PROFILE_THROUGHPUT  2
+
+#ifndef MBED_CONF_LWIP_MEMORY_PROFILE
+#define MBED_CONF_LWIP_MEMORY_PROFILE   LWIP_MEMORY_PROFILE_SMALL
+#endif
+
+#if MBED_CONF_LWIP_MEMORY_PROFILE == LWIP_MEMORY_PROFILE_THROUGHPUT
+// Full sized segments so that each pool pbuf carries a whole Ethernet frame.
+// Each pool pbuf requires about 1530 bytes of RAM.
+#define LWIP_PROFILE_TCP_MSS            1460
+#define LWIP_PROFILE_PBUF_POOL_SIZE     8
+#define LWIP_PROFILE_MEMP_NUM_PBUF      16
+#define LWIP_PROFILE_TCP_WND            (4 * TCP_MSS)
+#define LWIP_PROFILE_TCP_SND_BUF        (4 * TCP_MSS)
+#define LWIP_PROFILE_TCP_QUEUE_OOSEQ    1
+#define LWIP_PROFILE_TCP_OVERSIZE       TCP_MSS
+#define LWIP_PROFILE_MEMP_NUM_TCP_SEG   TCP_SND_QUEUELEN
+#elif MBED_CONF_LWIP_MEMORY_PROFILE == LWIP_MEMORY_PROFILE_BALANCED
+// Default segment size with enough pool pbufs to keep six segments in flight.
+#define LWIP_PROFILE_TCP_MSS            536
+#define LWIP_PROFILE_PBUF_POOL_SIZE     8
+#define LWIP_PROFILE_MEMP_NUM_PBUF      12
+#define LWIP_PROFILE_TCP_WND            (6 * TCP_MSS)
+#define LWIP_PROFILE_TCP_SND_BUF        (4 * TCP_MSS)
+#define LWIP_PROFILE_TCP_QUEUE_OOSEQ    1
+#define LWIP_PROFILE_TCP_OVERSIZE       TCP_MSS
+#define LWIP_PROFILE_MEMP_NUM_TCP_SEG   TCP_SND_QUEUELEN
+#elif MBED_CONF_LWIP_MEMORY_PROFILE == LWIP_MEMORY_PROFILE_SMALL
+#define LWIP_PROFILE_TCP_MSS            536
+#define LWIP_PROFILE_PBUF_POOL_SIZE     5
+#define LWIP_PROFILE_MEMP_NUM_PBUF      8
+#define LWIP_PROFILE_TCP_WND            (4 * TCP_MSS)
+#define LWIP_PROFILE_TCP_SND_BUF        (2 * TCP_MSS)
+#define LWIP_PROFILE_TCP_QUEUE_OOSEQ    0
+#define LWIP_PROFILE_TCP_OVERSIZE       0
+#define LWIP_PROFILE_MEMP_NUM_TCP_SEG   16
+#else
+#error "lwip.memory-profile must be one of LWIP_MEMORY_PROFILE_SMALL, _BALANCED or _THROUGHPUT"
+#endif
+
 // Number of pool pbufs.
-// Each requires 684 bytes of RAM.
+// Each requires 684 bytes of RAM (about 1530 bytes with the throughput profile).
 #ifndef PBUF_POOL_SIZE
-#define PBUF_POOL_SIZE              5
+#define PBUF_POOL_SIZE              LWIP_PROFILE_PBUF_POOL_SIZE
 #endif
 
 // One tcp_pcb_listen is needed for each TCPServer.
@@ -138,7 +196,12 @@
 // Number of non-pool pbufs.
 // Each requires 92 bytes of RAM.
 #ifndef MEMP_NUM_PBUF
-#define MEMP_NUM_PBUF               8
+#define MEMP_NUM_PBUF               LWIP_PROFILE_MEMP_NUM_PBUF
+#endif
+
+// One tcp_seg is needed for each queued TCP segment, at least TCP_SND_QUEUELEN.
+#ifndef MEMP_NUM_TCP_SEG
+#define MEMP_NUM_TCP_SEG            LWIP_PROFILE_MEMP_NUM_TCP_SEG
 #endif
 
 // Each netbuf requires 64 bytes of RAM.
@@ -154,8 +217,13 @@
 #define MEMP_NUM_NETCONN            4
 #endif
 
-#define TCP_QUEUE_OOSEQ             0
-#define TCP_OVERSIZE                0
+#ifndef TCP_QUEUE_OOSEQ
+#define TCP_QUEUE_OOSEQ             LWIP_PROFILE_TCP_QUEUE_OOSEQ
+#endif
+
+#ifndef TCP_OVERSIZE
+#define TCP_OVERSIZE                LWIP_PROFILE_TCP_OVERSIZE
+#endif
 
 #define LWIP_DHCP                   LWIP_IPV4
 #define LWIP_DNS                    1
@@ -241,6 +309,18 @@
 
 #define LWIP_CHECKSUM_ON_COPY       1
 
+#ifndef TCP_MSS
+#define TCP_MSS                     LWIP_PROFILE_TCP_MSS
+#endif
+
+#ifndef TCP_WND
+#define TCP_WND                     LWIP_PROFILE_TCP_WND
+#endif
+
+#ifndef TCP_SND_BUF
+#define TCP_SND_BUF                 LWIP_PROFILE_TCP_SND_BUF
+#endif
+
 #define LWIP_NETIF_HOSTNAME         1
 #define LWIP_NETIF_STATUS_CALLBACK  1
 #define LWIP_NETIF_LINK_CALLBACK    1
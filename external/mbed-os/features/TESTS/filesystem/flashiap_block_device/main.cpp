@@ -0,0 +1,185 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#if !DEVICE_FLASH
+    #error [NOT_SUPPORTED] Flash API not supported for this target
+#endif
+
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+
+#include "FlashIAPBlockDevice.h"
+#include <stdlib.h>
+
+using namespace utest::v1;
+
+
+// Uses the last two sectors of the flash
+static uint32_t test_address(bd_size_t *size) {
+    FlashIAP flash;
+    flash.init();
+    uint32_t end = flash.get_flash_start() + flash.get_flash_size();
+    uint32_t sector_size = flash.get_sector_size(end - 1);
+    flash.deinit();
+
+    *size = 2*sector_size;
+    return end - 2*sector_size;
+}
+
+static uint8_t pattern(bd_addr_t addr) {
+    return 0xff & (addr*7 + (addr >> 8));
+}
+
+
+// Programs are made of whole flash pages
+void test_page_programs() {
+    bd_size_t size;
+    uint32_t address = test_address(&size);
+    FlashIAPBlockDevice bd(address, size);
+
+    int err = bd.init();
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT_EQUAL(size, bd.size());
+
+    FlashIAP flash;
+    flash.init();
+    bd_size_t page_size = flash.get_page_size();
+    flash.deinit();
+    TEST_ASSERT_EQUAL(page_size, bd.get_program_size());
+
+    err = bd.erase(0, bd.get_erase_size());
+    TEST_ASSERT_EQUAL(0, err);
+    bd.reset_counters();
+
+    // Program the first four pages one at a time
+    uint8_t *block = new uint8_t[page_size];
+    for (bd_addr_t page = 0; page < 4*page_size; page += page_size) {
+        for (bd_size_t i = 0; i < page_size; i++) {
+            block[i] = pattern(page + i);
+        }
+
+        err = bd.program(block, page, page_size);
+        TEST_ASSERT_EQUAL(0, err);
+    }
+    TEST_ASSERT_EQUAL(4, bd.get_program_count());
+
+    for (bd_addr_t page = 0; page < 5*page_size; page += page_size) {
+        err = bd.read(block, page, page_size);
+        TEST_ASSERT_EQUAL(0, err);
+        for (bd_size_t i = 0; i < page_size; i++) {
+            TEST_ASSERT_EQUAL(page < 4*page_size ? pattern(page + i) : 0xff, block[i]);
+        }
+    }
+    delete[] block;
+
+    err = bd.deinit();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+// Erasing blank sectors is skipped
+void test_blank_erase() {
+    bd_size_t size;
+    uint32_t address = test_address(&size);
+    FlashIAPBlockDevice bd(address, size);
+
+    int err = bd.init();
+    TEST_ASSERT_EQUAL(0, err);
+
+    // The first sector holds the data of the previous test
+    err = bd.erase(0, size);
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT(bd.get_erase_count() >= 1);
+    bd.reset_counters();
+
+    err = bd.erase(0, size);
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT_EQUAL(0, bd.get_erase_count());
+    TEST_ASSERT_EQUAL(size / bd.get_erase_size(), bd.get_erase_skip_count());
+
+    bd_size_t page_size = bd.get_program_size();
+    uint8_t *block = new uint8_t[page_size];
+    memset(block, 0x5a, page_size);
+    err = bd.program(block, size - page_size, page_size);
+    TEST_ASSERT_EQUAL(0, err);
+    delete[] block;
+    bd.reset_counters();
+
+    err = bd.erase(0, size);
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT_EQUAL(1, bd.get_erase_count());
+
+    err = bd.deinit();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+// Programs of many pages are counted a page at a time
+void test_whole_pages() {
+    bd_size_t size;
+    uint32_t address = test_address(&size);
+    FlashIAPBlockDevice bd(address, size);
+
+    int err = bd.init();
+    TEST_ASSERT_EQUAL(0, err);
+    bd.reset_counters();
+
+    bd_size_t sector_size = bd.get_erase_size();
+    uint8_t *block = new uint8_t[sector_size];
+    for (bd_size_t i = 0; i < sector_size; i++) {
+        block[i] = pattern(i);
+    }
+
+    err = bd.program(block, 0, sector_size);
+    TEST_ASSERT_EQUAL(0, err);
+
+    FlashIAP flash;
+    flash.init();
+    TEST_ASSERT_EQUAL(sector_size / flash.get_page_size(), bd.get_program_count());
+    flash.deinit();
+
+    memset(block, 0, sector_size);
+    err = bd.read(block, 0, sector_size);
+    TEST_ASSERT_EQUAL(0, err);
+    for (bd_size_t i = 0; i < sector_size; i++) {
+        TEST_ASSERT_EQUAL(pattern(i), block[i]);
+    }
+    delete[] block;
+
+    err = bd.erase(0, size);
+    TEST_ASSERT_EQUAL(0, err);
+
+    err = bd.deinit();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+
+// Test setup
+utest::v1::status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(30, "default_auto");
+    return verbose_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("Testing programs of single pages", test_page_programs),
+    Case("Testing erase of blank sectors", test_blank_erase),
+    Case("Testing programs of whole pages", test_whole_pages),
+};
+
+Specification specification(test_setup, cases);
+
+int main() {
+    return !Harness::run(specification);
+}
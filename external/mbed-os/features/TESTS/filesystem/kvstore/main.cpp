@@ -0,0 +1,251 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity.h"
+#include "utest.h"
+
+#include "HeapBlockDevice.h"
+#include "KVStore.h"
+#include <stdlib.h>
+
+using namespace utest::v1;
+
+#define TEST_BLOCK_SIZE 512
+#define TEST_BLOCK_DEVICE_SIZE 64*TEST_BLOCK_SIZE
+#define TEST_KEY_COUNT 20
+
+HeapBlockDevice bd(TEST_BLOCK_DEVICE_SIZE, TEST_BLOCK_SIZE);
+
+
+static void make_key(char *key, int i) {
+    sprintf(key, "key%03d", i);
+}
+
+static void fill_value(uint8_t *value, size_t size, int seed) {
+    for (size_t i = 0; i < size; i++) {
+        value[i] = 0xff & (seed*31 + i*7);
+    }
+}
+
+static void check_value(KVStore &kv, const char *key, size_t size, int seed) {
+    uint8_t expected[64];
+    uint8_t value[64];
+    fill_value(expected, size, seed);
+
+    int res = kv.get(key, value, sizeof(value));
+    TEST_ASSERT_EQUAL(size, res);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, value, size);
+}
+
+
+void test_format() {
+    int err = bd.init();
+    TEST_ASSERT_EQUAL(0, err);
+
+    err = KVStore::format(&bd);
+    TEST_ASSERT_EQUAL(0, err);
+
+    KVStore kv;
+    err = kv.mount(&bd);
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT(kv.capacity() > 0);
+    TEST_ASSERT_EQUAL(0, kv.used());
+
+    uint8_t value[4];
+    TEST_ASSERT_EQUAL(-ENOENT, kv.get("missing", value, sizeof(value)));
+    TEST_ASSERT_EQUAL(-ENOENT, kv.remove("missing"));
+    TEST_ASSERT_EQUAL(-EINVAL, kv.set("", value, sizeof(value)));
+
+    err = kv.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+void test_set_get() {
+    KVStore kv(&bd);
+    char key[16];
+    uint8_t value[64];
+
+    for (int i = 0; i < TEST_KEY_COUNT; i++) {
+        make_key(key, i);
+        fill_value(value, i + 1, i);
+        int err = kv.set(key, value, i + 1);
+        TEST_ASSERT_EQUAL(0, err);
+    }
+
+    for (int i = 0; i < TEST_KEY_COUNT; i++) {
+        make_key(key, i);
+        check_value(kv, key, i + 1, i);
+    }
+
+    // A short buffer gets the start of the value and its full size
+    make_key(key, 10);
+    TEST_ASSERT_EQUAL(11, kv.get(key, value, 4));
+
+    int err = kv.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+void test_overwrite_remove() {
+    KVStore kv(&bd);
+    char key[16];
+    uint8_t value[64];
+
+    for (int i = 0; i < TEST_KEY_COUNT; i += 2) {
+        make_key(key, i);
+        fill_value(value, 32, i + 100);
+        int err = kv.set(key, value, 32);
+        TEST_ASSERT_EQUAL(0, err);
+    }
+
+    for (int i = 1; i < TEST_KEY_COUNT; i += 4) {
+        make_key(key, i);
+        int err = kv.remove(key);
+        TEST_ASSERT_EQUAL(0, err);
+        TEST_ASSERT_EQUAL(-ENOENT, kv.get(key, value, sizeof(value)));
+    }
+
+    int err = kv.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+void test_remount() {
+    KVStore kv(&bd);
+    char key[16];
+    uint8_t value[64];
+
+    for (int i = 0; i < TEST_KEY_COUNT; i++) {
+        make_key(key, i);
+        if (i % 2 == 0) {
+            check_value(kv, key, 32, i + 100);
+        } else if (i % 4 == 1) {
+            TEST_ASSERT_EQUAL(-ENOENT, kv.get(key, value, sizeof(value)));
+        } else {
+            check_value(kv, key, i + 1, i);
+        }
+    }
+
+    int err = kv.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+void test_iterate() {
+    KVStore kv(&bd);
+    bool seen[TEST_KEY_COUNT] = {};
+    int count = 0;
+
+    kv_iterator_t it;
+    kv.iterator_rewind(&it);
+    char key[KVStore::MAX_KEY_SIZE+1];
+    int res;
+    while ((res = kv.iterator_next(&it, key, sizeof(key))) == 1) {
+        int i = atoi(key + 3);
+        TEST_ASSERT(i >= 0 && i < TEST_KEY_COUNT);
+        TEST_ASSERT(!seen[i]);
+        TEST_ASSERT(i % 4 != 1);
+        seen[i] = true;
+        count += 1;
+    }
+    TEST_ASSERT_EQUAL(0, res);
+    TEST_ASSERT_EQUAL(TEST_KEY_COUNT - TEST_KEY_COUNT/4, count);
+
+    int err = kv.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+// Rewrites the same keys many times over so the log wraps around the device
+void test_wrap_gc() {
+    KVStore kv(&bd);
+    char key[16];
+    uint8_t value[64];
+
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < TEST_KEY_COUNT; i += 2) {
+            make_key(key, i);
+            fill_value(value, 48, round*TEST_KEY_COUNT + i);
+            int err = kv.set(key, value, 48);
+            TEST_ASSERT_EQUAL(0, err);
+        }
+
+        if (round % 10 == 0) {
+            int res = kv.gc();
+            TEST_ASSERT(res >= 0);
+        }
+    }
+
+    int err = kv.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+
+    err = kv.mount(&bd);
+    TEST_ASSERT_EQUAL(0, err);
+    for (int i = 0; i < TEST_KEY_COUNT; i += 2) {
+        make_key(key, i);
+        check_value(kv, key, 48, 99*TEST_KEY_COUNT + i);
+    }
+
+    err = kv.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+void test_full() {
+    KVStore kv(&bd);
+    char key[16];
+    uint8_t value[64];
+    fill_value(value, sizeof(value), 0);
+
+    int i = 0;
+    int err;
+    while ((err = kv.set((sprintf(key, "fill%05d", i), key), value, sizeof(value))) == 0) {
+        i += 1;
+    }
+    TEST_ASSERT_EQUAL(-ENOSPC, err);
+    TEST_ASSERT(kv.used() <= kv.capacity());
+
+    // Removing a key makes room again
+    err = kv.remove("fill00000");
+    TEST_ASSERT_EQUAL(0, err);
+    err = kv.set("fill00000", value, sizeof(value));
+    TEST_ASSERT_EQUAL(0, err);
+
+    err = kv.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+
+    err = bd.deinit();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+
+// Test setup
+utest::v1::status_t test_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(60, "default_auto");
+    return verbose_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("Testing formatting", test_format),
+    Case("Testing set and get", test_set_get),
+    Case("Testing overwrite and remove", test_overwrite_remove),
+    Case("Testing persistence across mounts", test_remount),
+    Case("Testing iteration", test_iterate),
+    Case("Testing wrap around and gc", test_wrap_gc),
+    Case("Testing a full store", test_full),
+};
+
+Specification specification(test_setup, cases);
+
+int main() {
+    return !Harness::run(specification);
+}
@@ -0,0 +1,208 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "FlashIAPBlockDevice.h"
+#include "platform/mbed_assert.h"
+#include <string.h>
+
+#ifdef DEVICE_FLASH
+
+
+#define FLASHIAP_ERASE_VALUE    0xff
+
+
+FlashIAPBlockDevice::FlashIAPBlockDevice(uint32_t address, uint32_t size)
+    : _address(address), _size(size), _page_size(0), _sector_size(0)
+    , _programs(0), _erases(0), _erases_skipped(0)
+{
+}
+
+FlashIAPBlockDevice::~FlashIAPBlockDevice()
+{
+}
+
+int FlashIAPBlockDevice::init()
+{
+    if (_flash.init()) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+
+    uint32_t flash_end = _flash.get_flash_start() + _flash.get_flash_size();
+    if (!_size && _address < flash_end) {
+        _size = flash_end - _address;
+    }
+
+    // The region must be in flash and made of sectors of a single size
+    _page_size = _flash.get_page_size();
+    _sector_size = _flash.get_sector_size(_address);
+    bool valid = _address >= _flash.get_flash_start() &&
+                 _size && _size <= flash_end - _address &&
+                 _sector_size != MBED_FLASH_INVALID_SIZE &&
+                 _address % _sector_size == 0 && _size % _sector_size == 0 &&
+                 _sector_size % _page_size == 0;
+    for (uint32_t offset = 0; valid && offset < _size; offset += _sector_size) {
+        valid = _flash.get_sector_size(_address + offset) == _sector_size;
+    }
+
+    if (!valid) {
+        _flash.deinit();
+        return BD_ERROR_DEVICE_ERROR;
+    }
+
+    return BD_ERROR_OK;
+}
+
+int FlashIAPBlockDevice::deinit()
+{
+    return _flash.deinit() ? BD_ERROR_DEVICE_ERROR : BD_ERROR_OK;
+}
+
+int FlashIAPBlockDevice::read(void *b, bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_read(addr, size));
+
+    if (_flash.read(b, _address + addr, size)) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+
+    return BD_ERROR_OK;
+}
+
+int FlashIAPBlockDevice::program(const void *b, bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_program(addr, size));
+    const uint8_t *buffer = static_cast<const uint8_t*>(b);
+
+    while (size > 0) {
+        // FlashIAP programs pages within one sector at a time
+        bd_size_t chunk = _sector_size - addr % _sector_size;
+        if (chunk > size) {
+            chunk = size;
+        }
+
+        if (_flash.program(buffer, _address + addr, chunk)) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+
+        _programs += chunk / _page_size;
+        buffer += chunk;
+        addr += chunk;
+        size -= chunk;
+    }
+
+    return BD_ERROR_OK;
+}
+
+int FlashIAPBlockDevice::_is_blank(bd_addr_t addr, bd_size_t size)
+{
+    uint32_t chunk[16];
+
+    while (size > 0) {
+        bd_size_t count = (size < sizeof(chunk)) ? size : sizeof(chunk);
+        if (_flash.read(chunk, _address + addr, count)) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+
+        const uint8_t *data = reinterpret_cast<const uint8_t*>(chunk);
+        for (bd_size_t i = 0; i < count; i++) {
+            if (data[i] != FLASHIAP_ERASE_VALUE) {
+                return 0;
+            }
+        }
+
+        addr += count;
+        size -= count;
+    }
+
+    return 1;
+}
+
+int FlashIAPBlockDevice::erase(bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_erase(addr, size));
+
+    while (size > 0) {
+        int blank = _is_blank(addr, _sector_size);
+        if (blank < 0) {
+            return blank;
+        }
+
+        if (blank) {
+            _erases_skipped += 1;
+        } else {
+            if (_flash.erase(_address + addr, _sector_size)) {
+                return BD_ERROR_DEVICE_ERROR;
+            }
+            _erases += 1;
+        }
+
+        addr += _sector_size;
+        size -= _sector_size;
+    }
+
+    return BD_ERROR_OK;
+}
+
+bd_size_t FlashIAPBlockDevice::get_read_size() const
+{
+    return 1;
+}
+
+bd_size_t FlashIAPBlockDevice::get_program_size() const
+{
+    return _page_size;
+}
+
+bd_size_t FlashIAPBlockDevice::get_erase_size() const
+{
+    return _sector_size;
+}
+
+bd_size_t FlashIAPBlockDevice::size() const
+{
+    return _size;
+}
+
+uint32_t FlashIAPBlockDevice::get_program_count() const
+{
+    return _programs;
+}
+
+uint32_t FlashIAPBlockDevice::get_erase_count() const
+{
+    return _erases;
+}
+
+uint32_t FlashIAPBlockDevice::get_erase_skip_count() const
+{
+    return _erases_skipped;
+}
+
+void FlashIAPBlockDevice::reset_counters()
+{
+    _programs = 0;
+    _erases = 0;
+    _erases_skipped = 0;
+}
+
+
+#endif  /* DEVICE_FLASH */
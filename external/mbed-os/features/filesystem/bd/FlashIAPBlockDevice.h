@@ -0,0 +1,173 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef MBED_FLASHIAP_BLOCK_DEVICE_H
+#define MBED_FLASHIAP_BLOCK_DEVICE_H
+
+#include "BlockDevice.h"
+#include "drivers/FlashIAP.h"
+
+#ifdef DEVICE_FLASH
+
+
+/** Block device on a region of internal flash, through FlashIAP
+ *
+ * Programs are made of whole flash pages, the size get_program_size()
+ * reports, as flash with ECC or a program-once rule can't program part of a
+ * page and later the rest of it. Programs covering several pages go to the
+ * flash in one call for each sector they cover.
+ *
+ * Erases skip sectors that already read as erased (0xff), so reformatting
+ * or erase-before-write filesystems such as FAT don't wear out blank flash.
+ *
+ * @code
+ * #include "mbed.h"
+ * #include "FlashIAPBlockDevice.h"
+ *
+ * // The last 64KB of a 1MB flash
+ * FlashIAPBlockDevice bd(0xf0000, 0x10000);
+ *
+ * int main() {
+ *     bd.init();
+ *     uint8_t *page = (uint8_t *)malloc(bd.get_program_size());
+ *     memset(page, 0x42, bd.get_program_size());
+ *     bd.erase(0, bd.get_erase_size());
+ *     bd.program(page, 0, bd.get_program_size());
+ *     bd.deinit();
+ *     free(page);
+ * }
+ * @endcode
+ */
+class FlashIAPBlockDevice : public BlockDevice
+{
+public:
+
+    /** Lifetime of the flash block device
+     *
+     *  @param address  Flash address of the region, aligned to a sector
+     *  @param size     Size of the region, a multiple of its sector size.
+     *                  0 extends the region to the end of the flash.
+     */
+    FlashIAPBlockDevice(uint32_t address, uint32_t size = 0);
+    virtual ~FlashIAPBlockDevice();
+
+    /** Initialize a block device
+     *
+     *  Fails if the region is not in flash or its sectors differ in size.
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int init();
+
+    /** Deinitialize a block device
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int deinit();
+
+    /** Read blocks from a block device
+     *
+     *  @param buffer   Buffer to read blocks into
+     *  @param addr     Address of block to begin reading from
+     *  @param size     Size to read in bytes, must be a multiple of read block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size);
+
+    /** Program blocks to a block device
+     *
+     *  The blocks must have been erased prior to being programmed
+     *
+     *  @param buffer   Buffer of data to write to blocks
+     *  @param addr     Address of block to begin writing to
+     *  @param size     Size to write in bytes, must be a multiple of program block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size);
+
+    /** Erase blocks on a block device
+     *
+     *  The state of an erased block is undefined until it has been programmed
+     *
+     *  @param addr     Address of block to begin erasing
+     *  @param size     Size to erase in bytes, must be a multiple of erase block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int erase(bd_addr_t addr, bd_size_t size);
+
+    /** Get the size of a readable block
+     *
+     *  @return         Size of a readable block in bytes
+     */
+    virtual bd_size_t get_read_size() const;
+
+    /** Get the size of a programable block, the flash page size
+     *
+     *  @return         Size of a programable block in bytes
+     */
+    virtual bd_size_t get_program_size() const;
+
+    /** Get the size of a eraseable block
+     *
+     *  @return         Size of a eraseable block in bytes
+     */
+    virtual bd_size_t get_erase_size() const;
+
+    /** Get the total size of the underlying device
+     *
+     *  @return         Size of the underlying device in bytes
+     */
+    virtual bd_size_t size() const;
+
+    /** Get the number of flash pages programmed since the last reset_counters()
+     */
+    uint32_t get_program_count() const;
+
+    /** Get the number of sectors erased since the last reset_counters()
+     */
+    uint32_t get_erase_count() const;
+
+    /** Get the number of sector erases skipped as the sectors were blank
+     */
+    uint32_t get_erase_skip_count() const;
+
+    /** Reset the program and erase counters
+     */
+    void reset_counters();
+
+private:
+    int _is_blank(bd_addr_t addr, bd_size_t size);
+
+    mbed::FlashIAP _flash;
+    uint32_t _address;
+    uint32_t _size;
+    uint32_t _page_size;
+    uint32_t _sector_size;
+
+    uint32_t _programs;
+    uint32_t _erases;
+    uint32_t _erases_skipped;
+};
+
+
+#endif  /* DEVICE_FLASH */
+
+#endif
@@ -191,6 +191,8 @@ DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
         case CTRL_SYNC:
             if (_ffs[pdrv] == NULL) {
                 return RES_NOTRDY;
+            } else if (_ffs[pdrv]->sync()) {
+                return RES_ERROR;
             } else {
                 return RES_OK;
             }
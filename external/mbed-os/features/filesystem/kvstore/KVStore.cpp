@@ -0,0 +1,1550 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "KVStore.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+////// On-disk format //////
+//
+// Every segment starts with a header and ends with a footer, each padded to
+// the program size. Records are appended contiguously after the header:
+//
+//  | header | record | record | ... | <erased> | summary | footer |
+//
+// Sealing a segment writes the summary, one entry per live record, and then
+// the footer. Space for the summary is reserved as records are appended, so a
+// record never reaches the area the summary is programmed to.
+//
+// Sequence numbers tell segments in use from stale ones: every segment put
+// into use gets the next sequence number, and segments are used in order, so
+// the segments in use are those from the tail sequence recorded by the newest
+// segment up to the newest segment. The CRC of every record is xored with the
+// sequence of its segment, so records left over from an earlier use of the
+// segment are rejected even by block devices where erase is a no-op.
+
+#define KV_SEGMENT_MAGIC        0x4b565347  // "KVSG"
+#define KV_FOOTER_MAGIC         0x4b565346  // "KVSF"
+#define KV_RECORD_MAGIC         0x4b56      // "KV"
+#define KV_VERSION              1
+
+#define KV_DEFAULT_SEGMENT_SIZE 4096
+#define KV_MIN_SEGMENTS         4
+#define KV_MIN_BUFFER_SIZE      64
+#define KV_MIN_INDEX_SIZE       16
+
+#define KV_ADDR_NONE            0xffffffff
+#define KV_BUFFER_NONE          ((bd_addr_t)-1)
+#define KV_SUMMARY_DELETE       0x80000000
+
+enum kv_record_type {
+    KV_RECORD_SET       = 1,
+    KV_RECORD_DELETE    = 2,
+    KV_RECORD_PAD       = 3,    // fills the rest of a program unit on sync
+};
+
+struct kv_segment_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t segment_size;
+    uint32_t sequence;          // incremented every time a segment is put into use
+    uint32_t tail_sequence;     // oldest segment in use when this one was put into use
+    uint32_t crc;
+};
+
+struct kv_segment_footer {
+    uint32_t magic;
+    uint32_t sequence;          // tells the footer from one left by an earlier use
+    uint32_t tail_sequence;     // oldest segment in use when this one was sealed
+    uint32_t summary_offset;
+    uint32_t summary_count;
+    uint32_t summary_crc;
+    uint32_t crc;
+};
+
+struct kv_record {
+    uint16_t magic;
+    uint8_t  type;
+    uint8_t  key_size;
+    uint32_t value_size;
+    uint32_t crc;               // over type to value_size, key and value, xor segment sequence
+};
+
+struct kv_summary {
+    uint32_t hash;
+    uint32_t check;
+    uint32_t offset;
+    uint32_t size;              // footprint of the record, KV_SUMMARY_DELETE for removes
+};
+
+
+////// Helpers //////
+
+static const uint32_t crc_table[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+    0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+    0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+};
+
+// Standard CRC-32, chained by passing the result of one call to the next
+static uint32_t kv_crc32(uint32_t crc, const void *buffer, size_t size)
+{
+    const uint8_t *data = static_cast<const uint8_t*>(buffer);
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = (crc >> 4) ^ crc_table[(crc ^ data[i]) & 0xf];
+        crc = (crc >> 4) ^ crc_table[(crc ^ (data[i] >> 4)) & 0xf];
+    }
+    return ~crc;
+}
+
+// FNV-1a
+static uint32_t kv_hash(const char *key, size_t size)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ (uint8_t)key[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Second hash of a key, independent of kv_hash. Together they identify a key
+// well enough to replay summaries without reading the keys back
+static inline uint32_t kv_check(const char *key, size_t size)
+{
+    return kv_crc32(0, key, size);
+}
+
+static inline bd_size_t align_up(bd_size_t value, bd_size_t align)
+{
+    return (value + align - 1) / align * align;
+}
+
+static inline bd_size_t align_down(bd_size_t value, bd_size_t align)
+{
+    return value / align * align;
+}
+
+// Space a record takes in its segment
+static inline uint32_t kv_footprint(uint8_t key_size, uint32_t value_size)
+{
+    return (sizeof(kv_record) + key_size + value_size + 3) & ~3;
+}
+
+static inline uint32_t kv_record_crc(const kv_record *record)
+{
+    return kv_crc32(0, &record->type, sizeof(record->type) + sizeof(record->key_size) + sizeof(record->value_size));
+}
+
+
+////// Lifetime //////
+
+KVStore::KVStore(BlockDevice *bd)
+    : _bd(NULL), _segment_live(NULL), _read_buffer(NULL), _write_buffer(NULL), _index(NULL)
+{
+    if (bd) {
+        mount(bd);
+    }
+}
+
+KVStore::~KVStore()
+{
+    // nop if unmounted
+    unmount();
+}
+
+int KVStore::format(BlockDevice *bd, bd_size_t segment_size)
+{
+    KVStore kv;
+    kv.lock();
+    int err = kv._setup(bd, segment_size);
+    if (err) {
+        kv.unlock();
+        return err;
+    }
+
+    // Start above every sequence on the device, which leaves the segments of
+    // a previous store out of the new one without erasing them
+    uint32_t sequence = 0;
+    for (uint32_t i = 0; i < kv._segment_count; i++) {
+        kv_segment_header header;
+        err = kv._read_header(i, &header);
+        if (err < 0) {
+            break;
+        }
+
+        if (err && header.sequence > sequence) {
+            sequence = header.sequence;
+        }
+        err = 0;
+    }
+
+    if (!err) {
+        kv._head_sequence = sequence;
+        err = kv._open_segment();
+    }
+
+    kv._teardown();
+    kv.unlock();
+    return err;
+}
+
+int KVStore::mount(BlockDevice *bd, bd_size_t segment_size)
+{
+    lock();
+    if (_bd) {
+        unlock();
+        return -EINVAL;
+    }
+
+    int err = _setup(bd, segment_size);
+    if (!err) {
+        err = _load();
+        if (err) {
+            _teardown();
+        }
+    }
+
+    unlock();
+    return err;
+}
+
+int KVStore::unmount()
+{
+    lock();
+    if (!_bd) {
+        unlock();
+        return -EINVAL;
+    }
+
+    int err = _sync();
+    _teardown();
+    unlock();
+    return err;
+}
+
+int KVStore::_setup(BlockDevice *bd, bd_size_t segment_size)
+{
+    int err = bd->init();
+    if (err) {
+        return err;
+    }
+    _bd = bd;
+
+    bd_size_t read_size = bd->get_read_size();
+    bd_size_t erase_size = bd->get_erase_size();
+    _program_size = bd->get_program_size();
+
+    if (!segment_size) {
+        segment_size = erase_size;
+        while (segment_size < KV_DEFAULT_SEGMENT_SIZE) {
+            segment_size *= 2;
+        }
+    }
+
+    // Records are addressed in 4-byte units by 32-bit index entries
+    bd_size_t size = bd->size();
+    if (size > ((bd_size_t)1 << 34)) {
+        size = (bd_size_t)1 << 34;
+    }
+
+    _segment_size = segment_size;
+    _segment_count = size / segment_size;
+    _header_size = align_up(sizeof(kv_segment_header), _program_size);
+    _footer_offset = segment_size - align_up(sizeof(kv_segment_footer), _program_size);
+    if (segment_size % erase_size || segment_size > 0x80000000 ||
+        _footer_offset < _header_size + KV_MIN_BUFFER_SIZE) {
+        _teardown();
+        return -EINVAL;
+    }
+    if (_segment_count < KV_MIN_SEGMENTS) {
+        _teardown();
+        return -ENOSPC;
+    }
+
+    // One segment stays free to reclaim into and one more absorbs the
+    // space lost to records that don't fill their segment
+    _capacity = (bd_size_t)(_segment_count - 2) * (_footer_offset - _header_size);
+
+    _read_buffer_size = read_size;
+    while (_read_buffer_size < KV_MIN_BUFFER_SIZE && segment_size % (2*_read_buffer_size) == 0) {
+        _read_buffer_size *= 2;
+    }
+    _write_buffer_size = _program_size;
+    while (_write_buffer_size < KV_MIN_BUFFER_SIZE && segment_size % (2*_write_buffer_size) == 0) {
+        _write_buffer_size *= 2;
+    }
+
+    _index_size = KV_MIN_INDEX_SIZE;
+    _read_buffer = static_cast<uint8_t*>(malloc(_read_buffer_size));
+    _write_buffer = static_cast<uint8_t*>(malloc(_write_buffer_size));
+    _segment_live = static_cast<uint32_t*>(calloc(_segment_count, sizeof(uint32_t)));
+    _index = static_cast<entry*>(malloc(_index_size * sizeof(entry)));
+    if (!_read_buffer || !_write_buffer || !_segment_live || !_index) {
+        _teardown();
+        return -ENOMEM;
+    }
+
+    for (uint32_t i = 0; i < _index_size; i++) {
+        _index[i].addr = KV_ADDR_NONE;
+    }
+    _index_count = 0;
+    _read_buffer_addr = KV_BUFFER_NONE;
+    _write_buffer_addr = 0;
+    _write_buffer_fill = 0;
+
+    _head = _segment_count - 1;
+    _head_sequence = 0;
+    _head_offset = 0;
+    _head_count = 0;
+    _head_open = false;
+    _head_sealed = true;
+    _head_recovered = false;
+    _tail = 0;
+    _tail_sequence = 0;
+    _used = 0;
+    _live = 0;
+    return 0;
+}
+
+void KVStore::_teardown()
+{
+    free(_read_buffer);
+    free(_write_buffer);
+    free(_segment_live);
+    free(_index);
+    _read_buffer = NULL;
+    _write_buffer = NULL;
+    _segment_live = NULL;
+    _index = NULL;
+
+    if (_bd) {
+        _bd->deinit();
+        _bd = NULL;
+    }
+}
+
+void KVStore::lock()
+{
+    _mutex.lock();
+}
+
+void KVStore::unlock()
+{
+    _mutex.unlock();
+}
+
+
+////// Block device access //////
+
+bd_addr_t KVStore::_segment_addr(uint32_t segment) const
+{
+    return (bd_addr_t)segment * _segment_size;
+}
+
+uint32_t KVStore::_segment_sequence(bd_addr_t addr) const
+{
+    uint32_t segment = addr / _segment_size;
+    return _tail_sequence + (segment + _segment_count - _tail) % _segment_count;
+}
+
+// Offset of a summary of count entries
+uint32_t KVStore::_summary_offset(uint32_t count) const
+{
+    bd_size_t size = (bd_size_t)count * sizeof(kv_summary);
+    if (size > _footer_offset) {
+        return 0;
+    }
+    return align_down(_footer_offset - size, _program_size);
+}
+
+// Whether the head has room for a record and for its summary entry
+bool KVStore::_fits(uint32_t footprint) const
+{
+    return (bd_size_t)_head_offset + footprint <= _summary_offset(_head_count + 1);
+}
+
+// Reads through the read buffer, or the write buffer for data not yet programmed
+int KVStore::_read(bd_addr_t addr, void *buffer, bd_size_t size)
+{
+    uint8_t *data = static_cast<uint8_t*>(buffer);
+    bd_addr_t write_end = _write_buffer_addr + _write_buffer_fill;
+
+    while (size > 0) {
+        bd_size_t chunk;
+        if (addr >= _write_buffer_addr && addr < write_end) {
+            chunk = write_end - addr;
+            if (chunk > size) {
+                chunk = size;
+            }
+            memcpy(data, &_write_buffer[addr - _write_buffer_addr], chunk);
+        } else {
+            bd_addr_t block = align_down(addr, _read_buffer_size);
+            if (block != _read_buffer_addr) {
+                int err = _bd->read(_read_buffer, block, _read_buffer_size);
+                if (err) {
+                    _read_buffer_addr = KV_BUFFER_NONE;
+                    return err;
+                }
+                _read_buffer_addr = block;
+            }
+
+            chunk = block + _read_buffer_size - addr;
+            if (chunk > size) {
+                chunk = size;
+            }
+            if (addr < _write_buffer_addr && addr + chunk > _write_buffer_addr) {
+                chunk = _write_buffer_addr - addr;
+            }
+            memcpy(data, &_read_buffer[addr - block], chunk);
+        }
+
+        data += chunk;
+        addr += chunk;
+        size -= chunk;
+    }
+
+    return 0;
+}
+
+// Appends to the write buffer, programming it whenever it fills up.
+// A null buffer appends zeros.
+int KVStore::_write(const void *buffer, bd_size_t size)
+{
+    const uint8_t *data = static_cast<const uint8_t*>(buffer);
+
+    while (size > 0) {
+        bd_size_t chunk = _write_buffer_size - _write_buffer_fill;
+        if (chunk > size) {
+            chunk = size;
+        }
+
+        if (data) {
+            memcpy(&_write_buffer[_write_buffer_fill], data, chunk);
+            data += chunk;
+        } else {
+            memset(&_write_buffer[_write_buffer_fill], 0, chunk);
+        }
+        _write_buffer_fill += chunk;
+        size -= chunk;
+
+        if (_write_buffer_fill == _write_buffer_size) {
+            _read_buffer_addr = KV_BUFFER_NONE;
+            int err = _bd->program(_write_buffer, _write_buffer_addr, _write_buffer_size);
+            if (err) {
+                return err;
+            }
+            _write_buffer_addr += _write_buffer_size;
+            _write_buffer_fill = 0;
+        }
+    }
+
+    return 0;
+}
+
+// Programs the write buffer padded with zeros to the program size
+int KVStore::_flush()
+{
+    if (!_write_buffer_fill) {
+        return 0;
+    }
+
+    bd_size_t size = align_up(_write_buffer_fill, _program_size);
+    memset(&_write_buffer[_write_buffer_fill], 0, size - _write_buffer_fill);
+
+    _read_buffer_addr = KV_BUFFER_NONE;
+    int err = _bd->program(_write_buffer, _write_buffer_addr, size);
+    if (err) {
+        return err;
+    }
+    _write_buffer_addr += size;
+    _write_buffer_fill = 0;
+    return 0;
+}
+
+// Returns 1 if the area holds a single repeated byte, as it does if it was
+// erased and not programmed since, 0 if not
+int KVStore::_is_blank(bd_addr_t addr, bd_size_t size)
+{
+    uint8_t first;
+    int err = _read(addr, &first, 1);
+    if (err) {
+        return err;
+    }
+
+    while (size > 0) {
+        uint8_t chunk[32];
+        bd_size_t chunk_size = size < sizeof(chunk) ? size : sizeof(chunk);
+        err = _read(addr, chunk, chunk_size);
+        if (err) {
+            return err;
+        }
+
+        for (bd_size_t i = 0; i < chunk_size; i++) {
+            if (chunk[i] != first) {
+                return 0;
+            }
+        }
+        addr += chunk_size;
+        size -= chunk_size;
+    }
+
+    return 1;
+}
+
+// Returns 1 if the segment has a valid header, 0 if not
+int KVStore::_read_header(uint32_t segment, kv_segment_header *header)
+{
+    int err = _read(_segment_addr(segment), header, sizeof(*header));
+    if (err) {
+        return err;
+    }
+
+    return header->magic == KV_SEGMENT_MAGIC &&
+           header->version == KV_VERSION &&
+           header->segment_size == _segment_size &&
+           header->sequence != 0 &&
+           header->crc == kv_crc32(0, header, offsetof(kv_segment_header, crc));
+}
+
+// Returns 1 if the segment was sealed with a valid summary, 0 if not
+int KVStore::_read_footer(uint32_t segment, uint32_t sequence, kv_segment_footer *footer)
+{
+    bd_addr_t base = _segment_addr(segment);
+    int err = _read(base + _footer_offset, footer, sizeof(*footer));
+    if (err) {
+        return err;
+    }
+
+    if (footer->magic != KV_FOOTER_MAGIC ||
+        footer->sequence != sequence ||
+        footer->crc != kv_crc32(0, footer, offsetof(kv_segment_footer, crc)) ||
+        footer->summary_offset < _header_size ||
+        footer->summary_offset > _footer_offset ||
+        footer->summary_count > (_footer_offset - footer->summary_offset) / sizeof(kv_summary)) {
+        return 0;
+    }
+
+    uint32_t crc = 0;
+    for (uint32_t i = 0; i < footer->summary_count; i++) {
+        kv_summary summary;
+        err = _read(base + footer->summary_offset + i*sizeof(kv_summary), &summary, sizeof(summary));
+        if (err) {
+            return err;
+        }
+        crc = kv_crc32(crc, &summary, sizeof(summary));
+    }
+
+    return crc == footer->summary_crc;
+}
+
+// Reads the header and key of a record known to be intact
+int KVStore::_read_key(bd_addr_t addr, kv_record *record, char *key)
+{
+    int err = _read(addr, record, sizeof(*record));
+    if (err) {
+        return err;
+    }
+
+    return _read(addr + sizeof(*record), key, record->key_size);
+}
+
+// Reads and checks the record at addr, which must end before end.
+// Returns 1 if the record is intact, 0 if not.
+int KVStore::_check_record(bd_addr_t addr, bd_addr_t end, uint32_t sequence, kv_record *record, char *key)
+{
+    if (addr + sizeof(*record) > end) {
+        return 0;
+    }
+
+    int err = _read(addr, record, sizeof(*record));
+    if (err) {
+        return err;
+    }
+
+    if (record->magic != KV_RECORD_MAGIC ||
+        record->key_size > MAX_KEY_SIZE ||
+        record->value_size > end - addr ||
+        addr + kv_footprint(record->key_size, record->value_size) > end) {
+        return 0;
+    }
+
+    switch (record->type) {
+        case KV_RECORD_SET:
+            break;
+        case KV_RECORD_DELETE:
+            if (record->value_size) {
+                return 0;
+            }
+            break;
+        case KV_RECORD_PAD:
+            return record->key_size == 0 &&
+                   record->crc == (kv_record_crc(record) ^ sequence);
+        default:
+            return 0;
+    }
+
+    if (!record->key_size) {
+        return 0;
+    }
+
+    err = _read(addr + sizeof(*record), key, record->key_size);
+    if (err) {
+        return err;
+    }
+    uint32_t crc = kv_crc32(kv_record_crc(record), key, record->key_size);
+
+    bd_addr_t value = addr + sizeof(*record) + record->key_size;
+    uint32_t left = record->value_size;
+    while (left > 0) {
+        uint8_t chunk[32];
+        uint32_t size = left < sizeof(chunk) ? left : sizeof(chunk);
+        err = _read(value, chunk, size);
+        if (err) {
+            return err;
+        }
+
+        crc = kv_crc32(crc, chunk, size);
+        value += size;
+        left -= size;
+    }
+
+    return record->crc == (crc ^ sequence);
+}
+
+
+////// Index //////
+
+// Finds the entry of a key, comparing the key of every entry with the same hashes
+int KVStore::_lookup(const char *key, uint8_t key_size, uint32_t hash, uint32_t check, uint32_t *slot)
+{
+    uint32_t mask = _index_size - 1;
+    for (uint32_t i = hash & mask; _index[i].addr != KV_ADDR_NONE; i = (i + 1) & mask) {
+        if (_index[i].hash != hash || _index[i].check != check) {
+            continue;
+        }
+
+        kv_record record;
+        char other[MAX_KEY_SIZE];
+        int err = _read_key((bd_addr_t)_index[i].addr << 2, &record, other);
+        if (err) {
+            return err;
+        }
+
+        if (record.key_size == key_size && memcmp(key, other, key_size) == 0) {
+            *slot = i;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// Finds the entry pointing at a record, if it's live
+bool KVStore::_find(uint32_t hash, bd_addr_t addr, uint32_t *slot)
+{
+    uint32_t mask = _index_size - 1;
+    for (uint32_t i = hash & mask; _index[i].addr != KV_ADDR_NONE; i = (i + 1) & mask) {
+        if (_index[i].hash == hash && _index[i].addr == (uint32_t)(addr >> 2)) {
+            *slot = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int KVStore::_index_insert(uint32_t hash, uint32_t check, bd_addr_t addr, uint32_t size)
+{
+    // Keep the load factor under 3/4
+    if ((_index_count + 1) * 4 > _index_size * 3) {
+        uint32_t index_size = 2 * _index_size;
+        entry *index = static_cast<entry*>(malloc(index_size * sizeof(entry)));
+        if (!index) {
+            return -ENOMEM;
+        }
+
+        for (uint32_t i = 0; i < index_size; i++) {
+            index[i].addr = KV_ADDR_NONE;
+        }
+        for (uint32_t i = 0; i < _index_size; i++) {
+            if (_index[i].addr != KV_ADDR_NONE) {
+                uint32_t j = _index[i].hash & (index_size - 1);
+                while (index[j].addr != KV_ADDR_NONE) {
+                    j = (j + 1) & (index_size - 1);
+                }
+                index[j] = _index[i];
+            }
+        }
+
+        free(_index);
+        _index = index;
+        _index_size = index_size;
+    }
+
+    uint32_t mask = _index_size - 1;
+    uint32_t i = hash & mask;
+    while (_index[i].addr != KV_ADDR_NONE) {
+        i = (i + 1) & mask;
+    }
+
+    _index[i].hash = hash;
+    _index[i].check = check;
+    _index[i].addr = addr >> 2;
+    _index[i].size = size;
+    _index_count += 1;
+    _account(addr, size, true);
+    return 0;
+}
+
+// Removes an entry, shifting back the entries probed past it
+void KVStore::_index_remove(uint32_t slot)
+{
+    _account((bd_addr_t)_index[slot].addr << 2, _index[slot].size, false);
+
+    uint32_t mask = _index_size - 1;
+    uint32_t i = slot;
+    for (uint32_t j = (i + 1) & mask; _index[j].addr != KV_ADDR_NONE; j = (j + 1) & mask) {
+        uint32_t home = _index[j].hash & mask;
+        // Move the entry unless its home lies cyclically in (i, j]
+        bool stays = (i < j) ? (home > i && home <= j) : (home > i || home <= j);
+        if (!stays) {
+            _index[i] = _index[j];
+            i = j;
+        }
+    }
+
+    _index[i].addr = KV_ADDR_NONE;
+    _index_count -= 1;
+}
+
+void KVStore::_account(bd_addr_t addr, uint32_t size, bool add)
+{
+    uint32_t segment = addr / _segment_size;
+    uint32_t bytes = size + sizeof(kv_summary);
+    if (add) {
+        _segment_live[segment] += bytes;
+        _live += bytes;
+    } else {
+        _segment_live[segment] -= bytes;
+        _live -= bytes;
+    }
+}
+
+// Replays a record or summary entry. Keys are matched by their hashes alone,
+// so mount never reads a key back
+int KVStore::_apply(uint32_t hash, uint32_t check, bd_addr_t addr, uint32_t size, bool remove)
+{
+    uint32_t mask = _index_size - 1;
+    for (uint32_t i = hash & mask; _index[i].addr != KV_ADDR_NONE; i = (i + 1) & mask) {
+        if (_index[i].hash == hash && _index[i].check == check) {
+            _index_remove(i);
+            break;
+        }
+    }
+
+    if (!remove) {
+        return _index_insert(hash, check, addr, size);
+    }
+
+    return 0;
+}
+
+
+////// Mounting //////
+
+int KVStore::_load()
+{
+    // The newest segment holds the range of segments in use
+    uint32_t *sequences = static_cast<uint32_t*>(calloc(_segment_count, sizeof(uint32_t)));
+    if (!sequences) {
+        return -ENOMEM;
+    }
+
+    int err = 0;
+    bool found = false;
+    kv_segment_header head;
+    memset(&head, 0, sizeof(head));
+    for (uint32_t i = 0; i < _segment_count; i++) {
+        kv_segment_header header;
+        err = _read_header(i, &header);
+        if (err < 0) {
+            break;
+        }
+
+        if (err) {
+            sequences[i] = header.sequence;
+            if (!found || header.sequence > head.sequence) {
+                found = true;
+                head = header;
+                _head = i;
+            }
+        }
+        err = 0;
+    }
+
+    if (!err && !found) {
+        err = -ENOENT;
+    }
+
+    if (!err) {
+        // A sealed head records the tail as it was before any segment was
+        // erased to open the next head
+        kv_segment_footer footer;
+        err = _read_footer(_head, head.sequence, &footer);
+        if (err >= 0) {
+            _head_sequence = head.sequence;
+            _tail_sequence = err ? footer.tail_sequence : head.tail_sequence;
+            err = 0;
+
+            if (_tail_sequence > _head_sequence || _head_sequence - _tail_sequence >= _segment_count) {
+                err = -EILSEQ;
+            }
+        }
+    }
+
+    if (!err) {
+        _used = _head_sequence - _tail_sequence + 1;
+        _tail = (_head + _segment_count - (_used - 1)) % _segment_count;
+
+        // Segments reclaimed since the head was opened are still intact, and
+        // everything they hold is superseded by newer segments
+        for (uint32_t i = 0; i < _used; i++) {
+            uint32_t segment = (_tail + i) % _segment_count;
+            if (sequences[segment] == _tail_sequence + i) {
+                err = _load_segment(segment, _tail_sequence + i);
+                if (err) {
+                    break;
+                }
+            }
+        }
+    }
+
+    free(sequences);
+    return err;
+}
+
+int KVStore::_load_segment(uint32_t segment, uint32_t sequence)
+{
+    bd_addr_t base = _segment_addr(segment);
+
+    kv_segment_footer footer;
+    int err = _read_footer(segment, sequence, &footer);
+    if (err < 0) {
+        return err;
+    }
+
+    if (err) {
+        for (uint32_t i = 0; i < footer.summary_count; i++) {
+            kv_summary summary;
+            err = _read(base + footer.summary_offset + i*sizeof(kv_summary), &summary, sizeof(summary));
+            if (err) {
+                return err;
+            }
+
+            uint32_t size = summary.size & ~KV_SUMMARY_DELETE;
+            if (summary.offset < _header_size || summary.offset + size > _footer_offset) {
+                return -EILSEQ;
+            }
+
+            err = _apply(summary.hash, summary.check, base + summary.offset, size,
+                    summary.size & KV_SUMMARY_DELETE);
+            if (err) {
+                return err;
+            }
+        }
+
+        if (segment == _head) {
+            _head_sealed = true;
+        }
+        return 0;
+    }
+
+    // Never sealed, scan its records up to the first one that is not intact
+    uint32_t offset = _header_size;
+    uint32_t count = 0;
+    while (true) {
+        kv_record record;
+        char key[MAX_KEY_SIZE];
+        err = _check_record(base + offset, base + _footer_offset, sequence, &record, key);
+        if (err <= 0) {
+            break;
+        }
+
+        uint32_t size = kv_footprint(record.key_size, record.value_size);
+        if (record.type != KV_RECORD_PAD) {
+            err = _apply(kv_hash(key, record.key_size), kv_check(key, record.key_size),
+                    base + offset, size, record.type == KV_RECORD_DELETE);
+            if (err) {
+                return err;
+            }
+            count += 1;
+        }
+        offset += size;
+    }
+
+    if (err < 0) {
+        return err;
+    }
+
+    // What follows the last intact record may be a torn program, so the head
+    // is sealed rather than appended to
+    if (segment == _head) {
+        _head_offset = offset;
+        _head_count = count;
+        _head_sealed = false;
+        _head_recovered = true;
+    }
+    return 0;
+}
+
+
+////// Log //////
+
+int KVStore::_open_segment()
+{
+    uint32_t segment = (_head + 1) % _segment_count;
+    uint32_t sequence = _head_sequence + 1;
+
+    _read_buffer_addr = KV_BUFFER_NONE;
+    int err = _bd->erase(_segment_addr(segment), _segment_size);
+    if (err) {
+        return err;
+    }
+
+    if (!_used) {
+        _tail = segment;
+        _tail_sequence = sequence;
+    }
+
+    kv_segment_header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = KV_SEGMENT_MAGIC;
+    header.version = KV_VERSION;
+    header.segment_size = _segment_size;
+    header.sequence = sequence;
+    header.tail_sequence = _tail_sequence;
+    header.crc = kv_crc32(0, &header, offsetof(kv_segment_header, crc));
+
+    _write_buffer_addr = _segment_addr(segment);
+    _write_buffer_fill = 0;
+    err = _write(&header, sizeof(header));
+    if (!err) {
+        err = _flush();
+    }
+    if (err) {
+        return err;
+    }
+
+    _head = segment;
+    _head_sequence = sequence;
+    _head_offset = _header_size;
+    _head_count = 0;
+    _head_open = true;
+    _head_sealed = false;
+    _head_recovered = false;
+    _used += 1;
+    _segment_live[segment] = 0;
+    return 0;
+}
+
+// Writes the summary of the records of the head that are still live, and a
+// footer to find it by. Removes are kept while their key is absent since they
+// may hide records in older segments.
+int KVStore::_seal()
+{
+    int err = _flush();
+    if (err) {
+        return err;
+    }
+
+    bd_addr_t base = _segment_addr(_head);
+    uint32_t summary_offset = _summary_offset(_head_count);
+
+    // A seal cut short by a power failure leaves a partly programmed summary
+    // or footer, which must not be programmed again. mount() scans the records
+    // of a head left unsealed instead.
+    if (_head_recovered) {
+        err = _is_blank(base + summary_offset, _segment_size - summary_offset);
+        if (err <= 0) {
+            _head_open = false;
+            _head_sealed = true;
+            return err;
+        }
+    }
+    uint32_t count = 0;
+    uint32_t crc = 0;
+    _write_buffer_addr = base + summary_offset;
+
+    for (uint32_t offset = _header_size; offset < _head_offset; ) {
+        kv_record record;
+        char key[MAX_KEY_SIZE];
+        err = _read_key(base + offset, &record, key);
+        if (err) {
+            return err;
+        }
+
+        uint32_t size = kv_footprint(record.key_size, record.value_size);
+        if (record.type != KV_RECORD_PAD) {
+            uint32_t hash = kv_hash(key, record.key_size);
+            uint32_t check = kv_check(key, record.key_size);
+            uint32_t slot;
+            bool live;
+            if (record.type == KV_RECORD_SET) {
+                live = _find(hash, base + offset, &slot);
+            } else {
+                err = _lookup(key, record.key_size, hash, check, &slot);
+                if (err < 0) {
+                    return err;
+                }
+                live = !err;
+            }
+
+            if (live) {
+                kv_summary summary;
+                summary.hash = hash;
+                summary.check = check;
+                summary.offset = offset;
+                summary.size = size | (record.type == KV_RECORD_DELETE ? KV_SUMMARY_DELETE : 0);
+                err = _write(&summary, sizeof(summary));
+                if (err) {
+                    return err;
+                }
+                crc = kv_crc32(crc, &summary, sizeof(summary));
+                count += 1;
+            }
+        }
+        offset += size;
+    }
+
+    err = _flush();
+    if (err) {
+        return err;
+    }
+
+    kv_segment_footer footer;
+    footer.magic = KV_FOOTER_MAGIC;
+    footer.sequence = _head_sequence;
+    footer.tail_sequence = _tail_sequence;
+    footer.summary_offset = summary_offset;
+    footer.summary_count = count;
+    footer.summary_crc = crc;
+    footer.crc = kv_crc32(0, &footer, offsetof(kv_segment_footer, crc));
+
+    _write_buffer_addr = base + _footer_offset;
+    err = _write(&footer, sizeof(footer));
+    if (!err) {
+        err = _flush();
+    }
+    if (err) {
+        return err;
+    }
+
+    _head_open = false;
+    _head_sealed = true;
+    return 0;
+}
+
+// Makes sure the head can take a record, sealing it and opening the next
+// segment if it can't
+int KVStore::_ensure_head(uint32_t footprint)
+{
+    if (_head_open && _fits(footprint)) {
+        return 0;
+    }
+
+    if (!_head_sealed) {
+        int err = _seal();
+        if (err) {
+            return err;
+        }
+    }
+
+    if (_used >= _segment_count) {
+        return -ENOSPC;
+    }
+
+    return _open_segment();
+}
+
+// Reclaims segments until a record can be appended with a segment to spare,
+// which is what reclaiming the next segment may take
+int KVStore::_make_room(uint32_t footprint)
+{
+    for (uint32_t i = 0; ; i++) {
+        uint32_t needed = (_head_open && _fits(footprint)) ? 1 : 2;
+        if (_segment_count - _used >= needed) {
+            return 0;
+        }
+
+        if (_used <= 1 || i >= 2*_segment_count) {
+            return -ENOSPC;
+        }
+
+        int err = _reclaim();
+        if (err) {
+            return err;
+        }
+    }
+}
+
+int KVStore::_append(uint8_t type, const char *key, uint8_t key_size,
+        const void *value, uint32_t value_size, bd_addr_t *addr)
+{
+    uint32_t size = kv_footprint(key_size, value_size);
+    int err = _ensure_head(size);
+    if (err) {
+        return err;
+    }
+
+    kv_record record;
+    record.magic = KV_RECORD_MAGIC;
+    record.type = type;
+    record.key_size = key_size;
+    record.value_size = value_size;
+    uint32_t crc = kv_record_crc(&record);
+    crc = kv_crc32(crc, key, key_size);
+    crc = kv_crc32(crc, value, value_size);
+    record.crc = crc ^ _head_sequence;
+
+    err = _write(&record, sizeof(record));
+    if (!err) {
+        err = _write(key, key_size);
+    }
+    if (!err) {
+        err = _write(value, value_size);
+    }
+    if (!err) {
+        err = _write(NULL, size - sizeof(record) - key_size - value_size);
+    }
+    if (err) {
+        // Leave whatever made it to the device behind
+        _head_open = false;
+        return err;
+    }
+
+    *addr = _segment_addr(_head) + _head_offset;
+    _head_offset += size;
+    _head_count += 1;
+    return 0;
+}
+
+// Copies a live record to the head. Only the CRC changes, to match the
+// sequence of its new segment.
+int KVStore::_copy(uint32_t slot, uint32_t sequence)
+{
+    bd_addr_t src = (bd_addr_t)_index[slot].addr << 2;
+    uint32_t size = _index[slot].size;
+
+    kv_record record;
+    int err = _read(src, &record, sizeof(record));
+    if (err) {
+        return err;
+    }
+
+    err = _ensure_head(size);
+    if (err) {
+        return err;
+    }
+
+    bd_addr_t dst = _segment_addr(_head) + _head_offset;
+    record.crc ^= sequence ^ _head_sequence;
+    err = _write(&record, sizeof(record));
+
+    bd_addr_t addr = src + sizeof(record);
+    uint32_t left = size - sizeof(record);
+    while (!err && left > 0) {
+        uint8_t chunk[32];
+        uint32_t chunk_size = left < sizeof(chunk) ? left : sizeof(chunk);
+        err = _read(addr, chunk, chunk_size);
+        if (!err) {
+            err = _write(chunk, chunk_size);
+        }
+        addr += chunk_size;
+        left -= chunk_size;
+    }
+
+    if (err) {
+        _head_open = false;
+        return err;
+    }
+
+    _head_offset += size;
+    _head_count += 1;
+
+    _account(src, size, false);
+    _index[slot].addr = dst >> 2;
+    _account(dst, size, true);
+    return 0;
+}
+
+// Frees the oldest segment, copying its live records to the head
+int KVStore::_reclaim()
+{
+    uint32_t segment = _tail;
+    uint32_t sequence = _tail_sequence;
+    bd_addr_t base = _segment_addr(segment);
+
+    if (_segment_live[segment]) {
+        kv_segment_footer footer;
+        int err = _read_footer(segment, sequence, &footer);
+        if (err < 0) {
+            return err;
+        }
+
+        if (err) {
+            for (uint32_t i = 0; i < footer.summary_count; i++) {
+                kv_summary summary;
+                err = _read(base + footer.summary_offset + i*sizeof(kv_summary), &summary, sizeof(summary));
+                if (err) {
+                    return err;
+                }
+
+                uint32_t slot;
+                if (!(summary.size & KV_SUMMARY_DELETE) && _find(summary.hash, base + summary.offset, &slot)) {
+                    err = _copy(slot, sequence);
+                    if (err) {
+                        return err;
+                    }
+                }
+            }
+        } else {
+            uint32_t offset = _header_size;
+            while (_segment_live[segment]) {
+                kv_record record;
+                char key[MAX_KEY_SIZE];
+                err = _check_record(base + offset, base + _footer_offset, sequence, &record, key);
+                if (err < 0) {
+                    return err;
+                } else if (!err) {
+                    break;
+                }
+
+                uint32_t slot;
+                if (record.type == KV_RECORD_SET &&
+                    _find(kv_hash(key, record.key_size), base + offset, &slot)) {
+                    err = _copy(slot, sequence);
+                    if (err) {
+                        return err;
+                    }
+                }
+                offset += kv_footprint(record.key_size, record.value_size);
+            }
+        }
+    }
+
+    // Nothing may point into the segment once it's free
+    if (_segment_live[segment]) {
+        return -EILSEQ;
+    }
+
+    _tail = (_tail + 1) % _segment_count;
+    _tail_sequence += 1;
+    _used -= 1;
+    return 0;
+}
+
+int KVStore::_sync()
+{
+    if (_write_buffer_fill && _head_open) {
+        // Pad to the program size with a record the next one can follow
+        uint32_t pad = align_up(_write_buffer_fill, _program_size) - _write_buffer_fill;
+        if (pad) {
+            while (pad < sizeof(kv_record)) {
+                pad += _program_size;
+            }
+        }
+
+        if (pad && (bd_size_t)_head_offset + pad <= _summary_offset(_head_count)) {
+            kv_record record;
+            record.magic = KV_RECORD_MAGIC;
+            record.type = KV_RECORD_PAD;
+            record.key_size = 0;
+            record.value_size = pad - sizeof(record);
+            record.crc = kv_record_crc(&record) ^ _head_sequence;
+
+            int err = _write(&record, sizeof(record));
+            if (!err) {
+                err = _write(NULL, pad - sizeof(record));
+            }
+            if (err) {
+                _head_open = false;
+                return err;
+            }
+            _head_offset += pad;
+        } else if (pad) {
+            int err = _seal();
+            return err ? err : _bd->sync();
+        }
+    }
+
+    int err = _flush();
+    return err ? err : _bd->sync();
+}
+
+
+////// Key-value operations //////
+
+int KVStore::get(const char *key, void *buffer, size_t size)
+{
+    lock();
+    size_t key_size = strlen(key);
+    if (!_bd || key_size == 0 || key_size > MAX_KEY_SIZE) {
+        unlock();
+        return -EINVAL;
+    }
+
+    uint32_t hash = kv_hash(key, key_size);
+    uint32_t check = kv_check(key, key_size);
+    uint32_t slot;
+    int err = _lookup(key, key_size, hash, check, &slot);
+    if (err <= 0) {
+        unlock();
+        return err ? err : -ENOENT;
+    }
+
+    bd_addr_t addr = (bd_addr_t)_index[slot].addr << 2;
+    kv_record record;
+    err = _read(addr, &record, sizeof(record));
+    if (err) {
+        unlock();
+        return err;
+    }
+
+    // Check the CRC over the whole value, even the part that doesn't fit
+    uint32_t crc = kv_crc32(kv_record_crc(&record), key, key_size);
+    uint8_t *data = static_cast<uint8_t*>(buffer);
+    addr += sizeof(record) + key_size;
+    for (uint32_t offset = 0; offset < record.value_size; ) {
+        uint8_t chunk[32];
+        uint8_t *dst = chunk;
+        uint32_t chunk_size = record.value_size - offset;
+        if (offset < size) {
+            dst = data + offset;
+            if (chunk_size > size - offset) {
+                chunk_size = size - offset;
+            }
+        } else if (chunk_size > sizeof(chunk)) {
+            chunk_size = sizeof(chunk);
+        }
+
+        err = _read(addr + offset, dst, chunk_size);
+        if (err) {
+            unlock();
+            return err;
+        }
+        crc = kv_crc32(crc, dst, chunk_size);
+        offset += chunk_size;
+    }
+
+    unlock();
+    if (record.crc != (crc ^ _segment_sequence(addr))) {
+        return -EILSEQ;
+    }
+    return record.value_size;
+}
+
+int KVStore::set(const char *key, const void *buffer, size_t size)
+{
+    lock();
+    size_t key_size = strlen(key);
+    if (!_bd || key_size == 0 || key_size > MAX_KEY_SIZE) {
+        unlock();
+        return -EINVAL;
+    }
+
+    if (size > _segment_size ||
+        _header_size + kv_footprint(key_size, size) > _summary_offset(1)) {
+        unlock();
+        return -EFBIG;
+    }
+
+    uint32_t hash = kv_hash(key, key_size);
+    uint32_t check = kv_check(key, key_size);
+    uint32_t footprint = kv_footprint(key_size, size);
+    uint32_t slot;
+    int found = _lookup(key, key_size, hash, check, &slot);
+    if (found < 0) {
+        unlock();
+        return found;
+    }
+
+    bd_size_t replaced = found ? _index[slot].size + sizeof(kv_summary) : 0;
+    if (_live - replaced + footprint + sizeof(kv_summary) > _capacity) {
+        unlock();
+        return -ENOSPC;
+    }
+
+    bd_addr_t addr;
+    int err = _make_room(footprint);
+    if (!err) {
+        err = _append(KV_RECORD_SET, key, key_size, buffer, size, &addr);
+    }
+    if (err) {
+        unlock();
+        return err;
+    }
+
+    if (found) {
+        _account((bd_addr_t)_index[slot].addr << 2, _index[slot].size, false);
+        _index[slot].addr = addr >> 2;
+        _index[slot].size = footprint;
+        _account(addr, footprint, true);
+    } else {
+        err = _index_insert(hash, check, addr, footprint);
+    }
+
+    unlock();
+    return err;
+}
+
+int KVStore::remove(const char *key)
+{
+    lock();
+    size_t key_size = strlen(key);
+    if (!_bd || key_size == 0 || key_size > MAX_KEY_SIZE) {
+        unlock();
+        return -EINVAL;
+    }
+
+    uint32_t hash = kv_hash(key, key_size);
+    uint32_t check = kv_check(key, key_size);
+    uint32_t slot;
+    int err = _lookup(key, key_size, hash, check, &slot);
+    if (err <= 0) {
+        unlock();
+        return err ? err : -ENOENT;
+    }
+
+    bd_addr_t addr;
+    err = _make_room(kv_footprint(key_size, 0));
+    if (!err) {
+        err = _append(KV_RECORD_DELETE, key, key_size, NULL, 0, &addr);
+    }
+    if (!err) {
+        _index_remove(slot);
+    }
+
+    unlock();
+    return err;
+}
+
+int KVStore::sync()
+{
+    lock();
+    if (!_bd) {
+        unlock();
+        return -EINVAL;
+    }
+
+    int err = _sync();
+    unlock();
+    return err;
+}
+
+int KVStore::gc()
+{
+    lock();
+    if (!_bd) {
+        unlock();
+        return -EINVAL;
+    }
+
+    uint32_t threshold = _segment_count / 4;
+    if (threshold < 2) {
+        threshold = 2;
+    }
+
+    int reclaimed = 0;
+    while (_segment_count - _used < threshold && _used > 1 && (uint32_t)reclaimed < _segment_count) {
+        // Moving a mostly live segment gains little
+        if (_segment_live[_tail] > (_footer_offset - _header_size) / 4 * 3) {
+            break;
+        }
+
+        int err = _reclaim();
+        if (err) {
+            unlock();
+            return err;
+        }
+        reclaimed += 1;
+    }
+
+    unlock();
+    return reclaimed;
+}
+
+void KVStore::iterator_rewind(kv_iterator_t *it)
+{
+    it->slot = 0;
+}
+
+int KVStore::iterator_next(kv_iterator_t *it, char *key, size_t size)
+{
+    lock();
+    if (!_bd) {
+        unlock();
+        return -EINVAL;
+    }
+
+    for (; it->slot < _index_size; it->slot++) {
+        if (_index[it->slot].addr == KV_ADDR_NONE) {
+            continue;
+        }
+
+        kv_record record;
+        char other[MAX_KEY_SIZE];
+        int err = _read_key((bd_addr_t)_index[it->slot].addr << 2, &record, other);
+        if (err) {
+            unlock();
+            return err;
+        }
+
+        if ((size_t)record.key_size + 1 > size) {
+            unlock();
+            return -EINVAL;
+        }
+
+        memcpy(key, other, record.key_size);
+        key[record.key_size] = '\0';
+        it->slot += 1;
+        unlock();
+        return 1;
+    }
+
+    unlock();
+    return 0;
+}
+
+bd_size_t KVStore::capacity()
+{
+    lock();
+    bd_size_t capacity = _bd ? _capacity : 0;
+    unlock();
+    return capacity;
+}
+
+bd_size_t KVStore::used()
+{
+    lock();
+    bd_size_t used = _bd ? _live : 0;
+    unlock();
+    return used;
+}
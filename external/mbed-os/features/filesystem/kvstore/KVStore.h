@@ -0,0 +1,285 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_KVSTORE_H
+#define MBED_KVSTORE_H
+
+#include "BlockDevice.h"
+#include "PlatformMutex.h"
+#include <stddef.h>
+#include <stdint.h>
+
+
+/** Position of an iteration over the keys of a KVStore
+ */
+typedef struct kv_iterator {
+    uint32_t slot;
+} kv_iterator_t;
+
+struct kv_record;
+struct kv_segment_header;
+struct kv_segment_footer;
+
+
+/** Log-structured key-value store on top of a BlockDevice
+ *
+ *  The block device is divided into segments of one or more erase blocks,
+ *  which are used round-robin as an append-only log. Every set or remove
+ *  appends a record to the newest segment; nothing is ever rewritten in
+ *  place, so updates cost a program of the record and no more.
+ *
+ *  A full segment is sealed with a summary listing the records still live in
+ *  it. mount() rebuilds the in-RAM hash index from these summaries and scans
+ *  only the records of segments that were never sealed, usually just the
+ *  newest one, so its cost depends on the number of keys rather than on the
+ *  number of updates made since format(). Summaries carry two independent
+ *  32-bit hashes of each key, which mount() matches without reading the keys
+ *  back; get(), set() and remove() always compare the keys themselves.
+ *
+ *  Space is reclaimed from the oldest segment first by copying its live
+ *  records to the head of the log. set() and remove() reclaim inline when
+ *  they run short of free segments; calling gc() from an idle thread or an
+ *  EventQueue does the same work ahead of time and keeps their latency down.
+ *
+ *  Records are buffered in RAM up to the program size of the device. Call
+ *  sync() or unmount() to make them persistent. A power failure loses at most
+ *  the records set since the last sync() and never corrupts older ones.
+ *
+ *  @code
+ *  #include "mbed.h"
+ *  #include "HeapBlockDevice.h"
+ *  #include "KVStore.h"
+ *
+ *  HeapBlockDevice bd(64*512, 512);
+ *
+ *  int main() {
+ *      KVStore::format(&bd);
+ *      KVStore kv(&bd);
+ *
+ *      uint32_t boots = 0;
+ *      kv.get("boots", &boots, sizeof(boots));
+ *      boots += 1;
+ *      kv.set("boots", &boots, sizeof(boots));
+ *      kv.sync();
+ *  }
+ *  @endcode
+ */
+class KVStore {
+public:
+    /** Longest key accepted, not counting the terminating null
+     */
+    static const size_t MAX_KEY_SIZE = 64;
+
+    /** Lifetime of a KVStore
+     *
+     *  @param bd       BlockDevice to mount, may be passed instead to mount call
+     */
+    KVStore(BlockDevice *bd = NULL);
+    virtual ~KVStore();
+
+    /** Formats a block device with an empty store
+     *
+     *  @param bd           BlockDevice to format, must not be mounted
+     *  @param segment_size Size of the unit of allocation and reclamation, a
+     *                      multiple of the erase size. 0 selects the smallest
+     *                      multiple of the erase size of at least 4KB. The
+     *                      device must hold at least 4 segments.
+     *  @return             0 on success, negative error code on failure
+     */
+    static int format(BlockDevice *bd, bd_size_t segment_size = 0);
+
+    /** Mounts a store on a block device
+     *
+     *  @param bd           BlockDevice to mount to
+     *  @param segment_size Segment size given to format()
+     *  @return             0 on success, -ENOENT if the device holds no store,
+     *                      or another negative error code on failure
+     */
+    int mount(BlockDevice *bd, bd_size_t segment_size = 0);
+
+    /** Syncs and unmounts the store from the underlying block device
+     *
+     *  @return         0 on success, negative error code on failure
+     */
+    int unmount();
+
+    /** Read the value of a key
+     *
+     *  @param key      Null-terminated key
+     *  @param buffer   Buffer to write the value to
+     *  @param size     Size of the buffer; a longer value is truncated
+     *  @return         Size of the value, which may exceed size, -ENOENT if the
+     *                  key is not present, or another negative error code
+     */
+    int get(const char *key, void *buffer, size_t size);
+
+    /** Set the value of a key, replacing any previous value
+     *
+     *  @param key      Null-terminated key of 1 to MAX_KEY_SIZE characters
+     *  @param buffer   Value to store
+     *  @param size     Size of the value, which may be 0
+     *  @return         0 on success, -ENOSPC if the store is full, -EFBIG if
+     *                  the record doesn't fit in a segment, or another negative
+     *                  error code on failure
+     */
+    int set(const char *key, const void *buffer, size_t size);
+
+    /** Remove a key
+     *
+     *  @param key      Null-terminated key
+     *  @return         0 on success, -ENOENT if the key is not present, or
+     *                  another negative error code on failure
+     */
+    int remove(const char *key);
+
+    /** Make every set and remove so far persistent
+     *
+     *  Pads the buffered records out to the program size of the device, so
+     *  syncing after every record costs up to a program unit per record.
+     *
+     *  @return         0 on success, negative error code on failure
+     */
+    int sync();
+
+    /** Reclaim space ahead of time
+     *
+     *  Copies the live records of the oldest segments to the head of the log
+     *  until a quarter of the segments are free, stopping early if the oldest
+     *  segment is mostly live.
+     *
+     *  @return         Number of segments reclaimed, or a negative error code
+     */
+    int gc();
+
+    /** Start an iteration over the keys of the store
+     *
+     *  @param it       Iterator to reset
+     */
+    void iterator_rewind(kv_iterator_t *it);
+
+    /** Get the next key of an iteration
+     *
+     *  Keys are returned in no particular order. Keys set or removed during
+     *  the iteration may be skipped or returned twice.
+     *
+     *  @param it       Iterator started with iterator_rewind
+     *  @param key      Buffer to write the null-terminated key to
+     *  @param size     Size of the buffer, MAX_KEY_SIZE+1 fits every key
+     *  @return         1 on reading a key, 0 at the end of the iteration, or
+     *                  a negative error code on failure
+     */
+    int iterator_next(kv_iterator_t *it, char *key, size_t size);
+
+    /** Get the space available to live records
+     *
+     *  @return         Size in bytes, or 0 if not mounted
+     */
+    bd_size_t capacity();
+
+    /** Get the space taken by live records, including their overhead
+     *
+     *  @return         Size in bytes, or 0 if not mounted
+     */
+    bd_size_t used();
+
+protected:
+    virtual void lock();
+    virtual void unlock();
+
+private:
+    struct entry {
+        uint32_t hash;
+        uint32_t check; // second hash of the key
+        uint32_t addr;  // address of the record divided by 4, KV_ADDR_NONE if unused
+        uint32_t size;  // footprint of the record
+    };
+
+    int _setup(BlockDevice *bd, bd_size_t segment_size);
+    void _teardown();
+    int _load();
+    int _load_segment(uint32_t segment, uint32_t sequence);
+    int _sync();
+
+    bd_addr_t _segment_addr(uint32_t segment) const;
+    uint32_t _segment_sequence(bd_addr_t addr) const;
+    uint32_t _summary_offset(uint32_t count) const;
+    bool _fits(uint32_t footprint) const;
+
+    int _read(bd_addr_t addr, void *buffer, bd_size_t size);
+    int _write(const void *buffer, bd_size_t size);
+    int _flush();
+    int _is_blank(bd_addr_t addr, bd_size_t size);
+    int _read_header(uint32_t segment, kv_segment_header *header);
+    int _read_footer(uint32_t segment, uint32_t sequence, kv_segment_footer *footer);
+    int _read_key(bd_addr_t addr, kv_record *record, char *key);
+    int _check_record(bd_addr_t addr, bd_addr_t end, uint32_t sequence, kv_record *record, char *key);
+
+    int _lookup(const char *key, uint8_t key_size, uint32_t hash, uint32_t check, uint32_t *slot);
+    bool _find(uint32_t hash, bd_addr_t addr, uint32_t *slot);
+    int _index_insert(uint32_t hash, uint32_t check, bd_addr_t addr, uint32_t size);
+    void _index_remove(uint32_t slot);
+    void _account(bd_addr_t addr, uint32_t size, bool add);
+    int _apply(uint32_t hash, uint32_t check, bd_addr_t addr, uint32_t size, bool remove);
+
+    int _append(uint8_t type, const char *key, uint8_t key_size, const void *value, uint32_t value_size, bd_addr_t *addr);
+    int _copy(uint32_t slot, uint32_t sequence);
+    int _ensure_head(uint32_t footprint);
+    int _make_room(uint32_t footprint);
+    int _open_segment();
+    int _seal();
+    int _reclaim();
+
+    BlockDevice *_bd;
+    PlatformMutex _mutex;
+
+    // Geometry
+    bd_size_t _program_size;
+    uint32_t _segment_size;
+    uint32_t _segment_count;
+    uint32_t _header_size;      // space taken by the segment header
+    uint32_t _footer_offset;    // offset of the segment footer
+    bd_size_t _capacity;
+
+    // Log
+    uint32_t _head;             // segment being appended to
+    uint32_t _head_sequence;
+    uint32_t _head_offset;      // offset of the next record in the head
+    uint32_t _head_count;       // records in the head, each reserving a summary entry
+    bool _head_open;            // records may be appended to the head
+    bool _head_sealed;          // the head has a summary
+    bool _head_recovered;       // the head was found unsealed by mount
+    uint32_t _tail;             // oldest segment in use
+    uint32_t _tail_sequence;
+    uint32_t _used;             // segments in use, from tail to head
+    uint32_t *_segment_live;    // bytes of live records in each segment
+    bd_size_t _live;
+
+    // Buffers
+    uint8_t *_read_buffer;
+    bd_size_t _read_buffer_size;
+    bd_addr_t _read_buffer_addr;
+    uint8_t *_write_buffer;
+    bd_size_t _write_buffer_size;
+    bd_addr_t _write_buffer_addr;
+    bd_size_t _write_buffer_fill;
+
+    // Hash index of live records, open addressing with linear probing
+    entry *_index;
+    uint32_t _index_size;
+    uint32_t _index_count;
+};
+
+
+#endif
@@ -33,6 +33,10 @@
 #include "bd/ChainingBlockDevice.h"
 #include "bd/SlicingBlockDevice.h"
 #include "bd/HeapBlockDevice.h"
+#include "bd/FlashIAPBlockDevice.h"
+
+// Key-value store on a BlockDevice
+#include "kvstore/KVStore.h"
 
 
 /** @}*/
@@ -0,0 +1,211 @@
+#!/usr/bin/env python
+#
+#  Copyright (c) 2017, ARM Limited, All Rights Reserved
+#  SPDX-License-Identifier: Apache-2.0
+#
+#  Licensed under the Apache License, Version 2.0 (the "License"); you may
+#  not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+"""Generate the fixed-base comb tables used by ecp_mul_comb() when P == G.
+
+Reads the domain parameters of every short Weierstrass curve from
+ecp_curves.c and writes ecp_comb_tables.h next to it. For each curve the
+table holds exactly the points ecp_precompute_comb() would compute for the
+generator, in affine coordinates, so ecp_mul_comb() can use them from flash
+instead of building grp->T on the heap:
+
+    T[i] = ( 1 + sum of 2^(d * (l + 1)) for each bit l set in i ) * G
+
+with the comb width w and d = ceil(nbits / w) chosen as ecp_mul_comb() does
+for P == G with MBEDTLS_ECP_FIXED_POINT_OPTIM == 1. Each table is only
+compiled when MBEDTLS_ECP_FIXED_POINT_TABLES is 1 and MBEDTLS_ECP_WINDOW_SIZE
+allows that w.
+
+Run it again after importing a new mbed TLS release:
+
+    python gen_ecp_comb_tables.py [../src]
+"""
+import os
+import re
+import sys
+
+# Curve name in ecp_curves.c, config.h macro and whether the curve has an
+# explicit A (otherwise A = -3).
+CURVES = [
+    ('secp192r1',       'MBEDTLS_ECP_DP_SECP192R1_ENABLED', False),
+    ('secp224r1',       'MBEDTLS_ECP_DP_SECP224R1_ENABLED', False),
+    ('secp256r1',       'MBEDTLS_ECP_DP_SECP256R1_ENABLED', False),
+    ('secp384r1',       'MBEDTLS_ECP_DP_SECP384R1_ENABLED', False),
+    ('secp521r1',       'MBEDTLS_ECP_DP_SECP521R1_ENABLED', False),
+    ('secp192k1',       'MBEDTLS_ECP_DP_SECP192K1_ENABLED', True),
+    ('secp224k1',       'MBEDTLS_ECP_DP_SECP224K1_ENABLED', True),
+    ('secp256k1',       'MBEDTLS_ECP_DP_SECP256K1_ENABLED', True),
+    ('brainpoolP256r1', 'MBEDTLS_ECP_DP_BP256R1_ENABLED',   True),
+    ('brainpoolP384r1', 'MBEDTLS_ECP_DP_BP384R1_ENABLED',   True),
+    ('brainpoolP512r1', 'MBEDTLS_ECP_DP_BP512R1_ENABLED',   True),
+]
+
+# Default MBEDTLS_ECP_WINDOW_SIZE, which caps w
+WINDOW_SIZE = 6
+
+HEADER = """/*
+ *  Precomputed fixed-base comb tables for ecp_mul_comb()
+ *
+ *  Copyright (C) 2017, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * GENERATED by features/mbedtls/importer/gen_ecp_comb_tables.py - do not edit.
+ *
+ * Included by ecp_curves.c after the domain parameters. For each enabled
+ * curve <curve>_T holds the points ecp_precompute_comb() would compute for
+ * the generator, or is NULL when the table cannot be used with the current
+ * configuration.
+ */
+"""
+
+
+def parse_constants(source):
+    """Returns {name: int} for every embedded mbedtls_mpi_uint constant."""
+    constants = {}
+    pattern = re.compile(r'static const mbedtls_mpi_uint (\w+)\[\] = \{(.*?)\};', re.S)
+    for name, body in pattern.findall(source):
+        data = []
+        for group in re.findall(r'BYTES_TO_T_UINT_\d\(([^)]*)\)', body):
+            data.extend(int(b, 16) for b in group.split(','))
+        value = 0
+        for i, byte in enumerate(data):
+            value |= byte << (8 * i)
+        constants[name] = value
+    return constants
+
+
+def inverse(x, p):
+    return pow(x, p - 2, p)
+
+
+def add(P, Q, a, p):
+    """Affine point addition, None is the point at infinity."""
+    if P is None:
+        return Q
+    if Q is None:
+        return P
+    if P[0] == Q[0]:
+        if (P[1] + Q[1]) % p == 0:
+            return None
+        s = (3 * P[0] * P[0] + a) * inverse(2 * P[1], p) % p
+    else:
+        s = (Q[1] - P[1]) * inverse(Q[0] - P[0], p) % p
+    x = (s * s - P[0] - Q[0]) % p
+    return (x, (s * (P[0] - x) - P[1]) % p)
+
+
+def mul(k, P, a, p):
+    R = None
+    while k:
+        if k & 1:
+            R = add(R, P, a, p)
+        P = add(P, P, a, p)
+        k >>= 1
+    return R
+
+
+def comb_parameters(nbits):
+    """w and d as chosen by ecp_mul_comb() for P == G."""
+    w = (5 if nbits >= 384 else 4) + 1
+    if w > WINDOW_SIZE:
+        w = WINDOW_SIZE
+    d = (nbits + w - 1) // w
+    return w, d
+
+
+def mpi_lines(value, nbytes):
+    data = [(value >> (8 * i)) & 0xFF for i in range(nbytes)]
+    lines = []
+    for i in range(0, nbytes, 8):
+        lines.append('    BYTES_TO_T_UINT_8( %s ),' %
+                     ', '.join('0x%02X' % b for b in data[i:i + 8]))
+    return lines
+
+
+def generate_curve(name, macro, has_a, constants):
+    p = constants[name + '_p']
+    a = constants[name + '_a'] if has_a else p - 3
+    b = constants[name + '_b']
+    G = (constants[name + '_gx'], constants[name + '_gy'])
+    n = constants[name + '_n']
+    assert (G[1] * G[1] - (G[0] ** 3 + a * G[0] + b)) % p == 0, name + ': G not on curve'
+
+    nbits = n.bit_length()
+    w, d = comb_parameters(nbits)
+    pre_len = 1 << (w - 1)
+    # Whole 64-bit groups so the same bytes work for 32 and 64-bit limbs
+    nbytes = ((p.bit_length() + 63) // 64) * 8
+
+    out = []
+    out.append('#if defined(%s)' % macro)
+    out.append('/* w = %d, d = %d */' % (w, d))
+    out.append('#if MBEDTLS_ECP_FIXED_POINT_OPTIM == 1 && MBEDTLS_ECP_FIXED_POINT_TABLES == 1 && \\')
+    out.append('    MBEDTLS_ECP_WINDOW_SIZE >= %d' % w)
+    names = []
+    for i in range(pre_len):
+        k = 1
+        for l in range(w - 1):
+            if i & (1 << l):
+                k += 1 << (d * (l + 1))
+        X, Y = mul(k, G, a, p)
+        for coord, value in (('X', X), ('Y', Y)):
+            array = '%s_T_%d_%s' % (name, i, coord)
+            out.append('static const mbedtls_mpi_uint %s[] = {' % array)
+            out.extend(mpi_lines(value, nbytes))
+            out.append('};')
+        names.append(('%s_T_%d_X' % (name, i), '%s_T_%d_Y' % (name, i)))
+    out.append('static const mbedtls_ecp_point %s_T[%d] = {' % (name, pre_len))
+    for x, y in names:
+        out.append('    ECP_POINT_INIT_XY_Z1( %s, %s ),' % (x, y))
+    out.append('};')
+    out.append('#else')
+    out.append('#define %s_T NULL' % name)
+    out.append('#endif')
+    out.append('#endif /* %s */' % macro)
+    return '\n'.join(out)
+
+
+def main():
+    src = sys.argv[1] if len(sys.argv) > 1 else os.path.join(os.path.dirname(__file__), '..', 'src')
+    with open(os.path.join(src, 'ecp_curves.c')) as f:
+        constants = parse_constants(f.read())
+
+    sections = [HEADER.rstrip('\n')]
+    for name, macro, has_a in CURVES:
+        sections.append(generate_curve(name, macro, has_a, constants))
+
+    with open(os.path.join(src, 'ecp_comb_tables.h'), 'w') as f:
+        f.write('\n\n'.join(sections) + '\n')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
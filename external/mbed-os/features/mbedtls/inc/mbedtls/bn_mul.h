@@ -572,7 +572,65 @@
 #define MULADDC_CANNOT_USE_R7
 #endif
 
-#if defined(__arm__) && !defined(MULADDC_CANNOT_USE_R7)
+/*
+ * Thumb-2 (Cortex-M3/M4/M7). The registers are left to the compiler so,
+ * unlike the ARM version below, this doesn't need r7 and is also used in
+ * unoptimized builds.
+ *
+ * ARMv7E-M has UMAAL, which computes d + c + s * b in a single instruction,
+ * and MULADDC_HUIT processes two limbs per LDRD/STRD. ARMv7-M (Cortex-M3)
+ * only has UMLAL, so adds d in separately.
+ */
+#if defined(__arm__) && defined(__thumb2__)
+
+#define MULADDC_INIT                                    \
+{                                                       \
+    mbedtls_mpi_uint t0, t1, t2, t3;                    \
+    asm(
+
+#if defined(__ARM_ARCH_7EM__)
+
+#define MULADDC_CORE                                    \
+            "ldr    %[t0], [%[s]], #4           \n\t"   \
+            "ldr    %[t1], [%[d]]               \n\t"   \
+            "umaal  %[t1], %[c], %[b], %[t0]    \n\t"   \
+            "str    %[t1], [%[d]], #4           \n\t"
+
+#define MULADDC_CORE2                                   \
+            "ldrd   %[t0], %[t1], [%[s]], #8    \n\t"   \
+            "ldrd   %[t2], %[t3], [%[d]]        \n\t"   \
+            "umaal  %[t2], %[c], %[b], %[t0]    \n\t"   \
+            "umaal  %[t3], %[c], %[b], %[t1]    \n\t"   \
+            "strd   %[t2], %[t3], [%[d]], #8    \n\t"
+
+#define MULADDC_HUIT                                    \
+            MULADDC_CORE2   MULADDC_CORE2               \
+            MULADDC_CORE2   MULADDC_CORE2
+
+#else
+
+#define MULADDC_CORE                                    \
+            "ldr    %[t0], [%[s]], #4           \n\t"   \
+            "ldr    %[t1], [%[d]]               \n\t"   \
+            "mov    %[t2], #0                   \n\t"   \
+            "umlal  %[c], %[t2], %[b], %[t0]    \n\t"   \
+            "adds   %[t1], %[t1], %[c]          \n\t"   \
+            "adc    %[c], %[t2], #0             \n\t"   \
+            "str    %[t1], [%[d]], #4           \n\t"
+
+#endif /* ARMv7E-M */
+
+#define MULADDC_STOP                                    \
+         : [s] "+r" (s), [d] "+r" (d), [c] "+r" (c),    \
+           [t0] "=&r" (t0), [t1] "=&r" (t1),            \
+           [t2] "=&r" (t2), [t3] "=&r" (t3)             \
+         : [b] "r" (b)                                  \
+         : "memory", "cc"                               \
+         );                                             \
+    (void) t0; (void) t1; (void) t2; (void) t3;         \
+}
+
+#elif defined(__arm__) && !defined(MULADDC_CANNOT_USE_R7)
 
 #if defined(__thumb__) && !defined(__thumb2__)
 
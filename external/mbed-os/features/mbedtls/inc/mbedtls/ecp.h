@@ -218,6 +218,23 @@ mbedtls_ecp_keypair;
 #define MBEDTLS_ECP_FIXED_POINT_OPTIM  1   /**< Enable fixed-point speed-up */
 #endif /* MBEDTLS_ECP_FIXED_POINT_OPTIM */
 
+#if !defined(MBEDTLS_ECP_FIXED_POINT_TABLES)
+/*
+ * Use fixed-point tables for the generators of the well-known curves that
+ * were computed at build time and live in flash, instead of computing them
+ * on the heap the first time each group multiplies its generator.
+ *
+ * This removes the RAM cost of MBEDTLS_ECP_FIXED_POINT_OPTIM and the extra
+ * latency of the first signature or key generation after each group load,
+ * at a cost in flash of 2^(w-1) points per enabled curve: 1 KB for
+ * secp256r1, 3 KB for secp384r1.
+ *
+ * Only has an effect with MBEDTLS_ECP_FIXED_POINT_OPTIM == 1.
+ * Change this value to 0 to save flash.
+ */
+#define MBEDTLS_ECP_FIXED_POINT_TABLES  1   /**< Use precomputed fixed-point tables */
+#endif /* MBEDTLS_ECP_FIXED_POINT_TABLES */
+
 /* \} name SECTION: Module settings */
 
 /*
@@ -0,0 +1,142 @@
+/**
+ * \file mbedtls_arena.h
+ *
+ * \brief Fixed buffer allocator for keeping one connection's mbed TLS
+ *        allocations out of the system heap
+ *
+ *  Copyright (C) 2017, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#ifndef MBEDTLS_ARENA_H
+#define MBEDTLS_ARENA_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief          Arena usage counters. Sizes include the per-block
+ *                 header, so they add up to the arena size.
+ */
+typedef struct
+{
+    size_t size;            /*!< usable size of the arena                   */
+    size_t current;         /*!< bytes in use                               */
+    size_t peak;            /*!< highest current since init or reset_peak   */
+    size_t blocks;          /*!< blocks in use                              */
+    size_t largest_free;    /*!< largest block that could be allocated now  */
+    size_t failures;        /*!< allocations that did not fit               */
+}
+mbedtls_arena_stats;
+
+/**
+ * \brief          Arena allocator
+ *
+ *                 First fit from a free list over a caller-provided buffer,
+ *                 splitting blocks on allocation and merging neighbours on
+ *                 free. memory_buffer_alloc.c keeps a single buffer in file
+ *                 scope behind its own mutex and puts a header of about 32
+ *                 bytes on every block; an arena is a plain object, so each
+ *                 connection can have its own, and its headers are two words.
+ *
+ *                 An arena does no locking; callers that share one between
+ *                 threads serialize access themselves.
+ */
+typedef struct
+{
+    unsigned char *buf;     /*!< first block header                         */
+    size_t len;             /*!< bytes from buf to the end marker           */
+    void *first_free;       /*!< free list head                             */
+    size_t current;
+    size_t peak;
+    size_t blocks;
+    size_t failures;
+}
+mbedtls_arena;
+
+/**
+ * \brief          Initialize an arena over a buffer
+ *
+ * \param arena    arena to initialize
+ * \param buf      buffer the arena allocates from, which must outlive it
+ * \param len      size of buf in bytes
+ *
+ * \return         0 if successful, or -1 if buf is too small to hold any
+ *                 allocation
+ */
+int mbedtls_arena_init( mbedtls_arena *arena, void *buf, size_t len );
+
+/**
+ * \brief          Allocate zeroed memory, 8-byte aligned, from an arena
+ *
+ * \param arena    arena to allocate from
+ * \param n        number of elements
+ * \param size     size of each element
+ *
+ * \return         the allocation, or NULL if it does not fit or is empty
+ */
+void *mbedtls_arena_calloc( mbedtls_arena *arena, size_t n, size_t size );
+
+/**
+ * \brief          Return memory to an arena
+ *
+ * \param arena    arena ptr was allocated from
+ * \param ptr      allocation to release, or NULL
+ */
+void mbedtls_arena_free( mbedtls_arena *arena, void *ptr );
+
+/**
+ * \brief          Check if memory belongs to an arena
+ *
+ * \param arena    arena to check
+ * \param ptr      pointer to check
+ *
+ * \return         1 if ptr lies within the arena's buffer, 0 otherwise
+ */
+int mbedtls_arena_owns( const mbedtls_arena *arena, const void *ptr );
+
+/**
+ * \brief          Release every allocation in an arena at once
+ *
+ *                 Anything still pointing into the arena, such as an SSL
+ *                 context that was not freed, must not be used afterwards.
+ *                 The failure count and peak are kept.
+ *
+ * \param arena    arena to empty
+ */
+void mbedtls_arena_reset( mbedtls_arena *arena );
+
+/**
+ * \brief          Restart peak tracking from the current usage
+ *
+ * \param arena    arena to update
+ */
+void mbedtls_arena_reset_peak( mbedtls_arena *arena );
+
+/**
+ * \brief          Get the arena usage counters
+ *
+ * \param arena    arena to inspect
+ * \param stats    destination for the counters
+ */
+void mbedtls_arena_get_stats( const mbedtls_arena *arena, mbedtls_arena_stats *stats );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MBEDTLS_ARENA_H */
@@ -0,0 +1,65 @@
+/**
+ * \file mbedtls_heap_stats.h
+ *
+ * \brief Counts the heap that mbed TLS has allocated
+ *
+ *  Copyright (C) 2017, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#ifndef MBEDTLS_HEAP_STATS_H
+#define MBEDTLS_HEAP_STATS_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief          Start counting mbed TLS heap use
+ *
+ *                 Replaces the mbed TLS calloc and free with counting
+ *                 versions that pass every request on to the pair that was
+ *                 installed before. Later calls do nothing. Must be called
+ *                 before mbed TLS allocates anything, and before any other
+ *                 allocator that should sit on top of the counters.
+ *
+ * \return         0 if successful, or -1 if mbed TLS was built without
+ *                 MBEDTLS_PLATFORM_MEMORY or with fixed allocator macros
+ */
+int mbedtls_heap_stats_install( void );
+
+/**
+ * \brief          Get the mbed TLS heap counters
+ *
+ *                 Sizes are the bytes mbed TLS asked for, without the
+ *                 counters' own overhead or the underlying heap's.
+ *
+ * \param current  if not NULL, receives the bytes currently allocated
+ * \param peak     if not NULL, receives the most allocated at once since
+ *                 install or the last reset_peak
+ */
+void mbedtls_heap_stats_get( size_t *current, size_t *peak );
+
+/**
+ * \brief          Restart peak tracking from the current usage
+ */
+void mbedtls_heap_stats_reset_peak( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MBEDTLS_HEAP_STATS_H */
@@ -19,6 +19,12 @@
 
 #if defined(DEVICE_TRNG)
 #define MBEDTLS_ENTROPY_HARDWARE_ALT
+
+/* Allocate through mbedtls_platform_set_calloc_free() so that TLSSocket can
+ * account for the heap used by each handshake. */
+#if !defined(MBEDTLS_PLATFORM_MEMORY)
+#define MBEDTLS_PLATFORM_MEMORY
+#endif
 #endif
 
 #if defined(MBEDTLS_CONFIG_HW_SUPPORT)
@@ -0,0 +1,256 @@
+/*
+ *  Fixed buffer allocator for per-connection mbed TLS memory
+ *
+ *  Copyright (C) 2017, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "mbedtls_arena.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * The buffer is a run of blocks, each a header followed by its payload, and
+ * ends with a header-only marker that is always in use so that merging never
+ * runs off the end. Free blocks keep their free list links in the payload.
+ */
+typedef struct arena_block
+{
+    size_t size;            /* payload bytes, ARENA_USED set when allocated */
+    size_t prev_size;       /* payload bytes of the previous block, 0 if first */
+}
+arena_block;
+
+typedef struct
+{
+    arena_block *prev_free;
+    arena_block *next_free;
+}
+arena_links;
+
+#define ARENA_ALIGN         8
+#define ARENA_USED          ( (size_t) 1 )
+#define ARENA_HDR           sizeof( arena_block )
+#define ARENA_ROUND( x )    ( ( (x) + ARENA_ALIGN - 1 ) & ~(size_t) ( ARENA_ALIGN - 1 ) )
+#define ARENA_MIN           ARENA_ROUND( sizeof( arena_links ) )
+
+static size_t block_size( const arena_block *b )
+{
+    return( b->size & ~ARENA_USED );
+}
+
+static arena_block *block_next( arena_block *b )
+{
+    return( (arena_block *) ( (unsigned char *) ( b + 1 ) + block_size( b ) ) );
+}
+
+static arena_block *block_prev( arena_block *b )
+{
+    if( b->prev_size == 0 )
+        return( NULL );
+
+    return( (arena_block *) ( (unsigned char *) b - b->prev_size - ARENA_HDR ) );
+}
+
+static arena_links *block_links( arena_block *b )
+{
+    return( (arena_links *) ( b + 1 ) );
+}
+
+static void free_list_push( mbedtls_arena *arena, arena_block *b )
+{
+    arena_block *head = (arena_block *) arena->first_free;
+
+    block_links( b )->prev_free = NULL;
+    block_links( b )->next_free = head;
+    if( head != NULL )
+        block_links( head )->prev_free = b;
+    arena->first_free = b;
+}
+
+static void free_list_remove( mbedtls_arena *arena, arena_block *b )
+{
+    arena_links *links = block_links( b );
+
+    if( links->prev_free != NULL )
+        block_links( links->prev_free )->next_free = links->next_free;
+    else
+        arena->first_free = links->next_free;
+
+    if( links->next_free != NULL )
+        block_links( links->next_free )->prev_free = links->prev_free;
+}
+
+int mbedtls_arena_init( mbedtls_arena *arena, void *buf, size_t len )
+{
+    size_t skip = ARENA_ROUND( (uintptr_t) buf ) - (uintptr_t) buf;
+
+    memset( arena, 0, sizeof( mbedtls_arena ) );
+
+    if( buf == NULL || len < skip + 2 * ARENA_HDR + ARENA_MIN )
+        return( -1 );
+
+    arena->buf = (unsigned char *) buf + skip;
+    arena->len = ( len - skip ) & ~(size_t) ( ARENA_ALIGN - 1 );
+    mbedtls_arena_reset( arena );
+
+    return( 0 );
+}
+
+void *mbedtls_arena_calloc( mbedtls_arena *arena, size_t n, size_t size )
+{
+    arena_block *b, *rest;
+    size_t want;
+
+    if( n == 0 || size == 0 )
+        return( NULL );
+
+    if( n > ( SIZE_MAX - ARENA_ALIGN ) / size )
+    {
+        arena->failures++;
+        return( NULL );
+    }
+
+    want = ARENA_ROUND( n * size );
+    if( want < ARENA_MIN )
+        want = ARENA_MIN;
+
+    for( b = (arena_block *) arena->first_free; b != NULL; b = block_links( b )->next_free )
+    {
+        if( b->size >= want )
+            break;
+    }
+
+    if( b == NULL )
+    {
+        arena->failures++;
+        return( NULL );
+    }
+
+    free_list_remove( arena, b );
+
+    /* Split off the tail if it is big enough to be a block of its own */
+    if( b->size - want >= ARENA_HDR + ARENA_MIN )
+    {
+        rest = (arena_block *) ( (unsigned char *) ( b + 1 ) + want );
+        rest->size = b->size - want - ARENA_HDR;
+        rest->prev_size = want;
+        block_next( rest )->prev_size = rest->size;
+        b->size = want;
+        free_list_push( arena, rest );
+    }
+
+    b->size |= ARENA_USED;
+
+    arena->current += ARENA_HDR + block_size( b );
+    if( arena->current > arena->peak )
+        arena->peak = arena->current;
+    arena->blocks++;
+
+    memset( b + 1, 0, block_size( b ) );
+    return( b + 1 );
+}
+
+void mbedtls_arena_free( mbedtls_arena *arena, void *ptr )
+{
+    arena_block *b, *next, *prev;
+
+    if( ptr == NULL || !mbedtls_arena_owns( arena, ptr ) )
+        return;
+
+    b = (arena_block *) ptr - 1;
+    if( ( b->size & ARENA_USED ) == 0 )
+        return;
+
+    b->size &= ~ARENA_USED;
+    arena->current -= ARENA_HDR + b->size;
+    arena->blocks--;
+
+    next = block_next( b );
+    if( ( next->size & ARENA_USED ) == 0 )
+    {
+        free_list_remove( arena, next );
+        b->size += ARENA_HDR + next->size;
+        block_next( b )->prev_size = b->size;
+    }
+
+    prev = block_prev( b );
+    if( prev != NULL && ( prev->size & ARENA_USED ) == 0 )
+    {
+        /* prev is already on the free list, it just grows */
+        prev->size += ARENA_HDR + b->size;
+        block_next( prev )->prev_size = prev->size;
+    }
+    else
+    {
+        free_list_push( arena, b );
+    }
+}
+
+int mbedtls_arena_owns( const mbedtls_arena *arena, const void *ptr )
+{
+    const unsigned char *p = (const unsigned char *) ptr;
+
+    return( p >= arena->buf && p < arena->buf + arena->len );
+}
+
+void mbedtls_arena_reset( mbedtls_arena *arena )
+{
+    arena_block *first = (arena_block *) arena->buf;
+    arena_block *end;
+
+    if( first == NULL )
+        return;
+
+    first->size = arena->len - 2 * ARENA_HDR;
+    first->prev_size = 0;
+
+    end = block_next( first );
+    end->size = ARENA_USED;
+    end->prev_size = first->size;
+
+    arena->first_free = NULL;
+    free_list_push( arena, first );
+
+    arena->current = 0;
+    arena->blocks = 0;
+}
+
+void mbedtls_arena_reset_peak( mbedtls_arena *arena )
+{
+    arena->peak = arena->current;
+}
+
+void mbedtls_arena_get_stats( const mbedtls_arena *arena, mbedtls_arena_stats *stats )
+{
+    arena_block *b;
+
+    memset( stats, 0, sizeof( mbedtls_arena_stats ) );
+    if( arena->buf == NULL )
+        return;
+
+    stats->size = arena->len - ARENA_HDR;
+    stats->current = arena->current;
+    stats->peak = arena->peak;
+    stats->blocks = arena->blocks;
+    stats->failures = arena->failures;
+
+    for( b = (arena_block *) arena->first_free; b != NULL; b = block_links( b )->next_free )
+    {
+        if( b->size > stats->largest_free )
+            stats->largest_free = b->size;
+    }
+}
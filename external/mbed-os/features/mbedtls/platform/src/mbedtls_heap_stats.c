@@ -0,0 +1,151 @@
+/*
+ *  Counts the heap that mbed TLS has allocated
+ *
+ *  Copyright (C) 2017, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include "mbedtls/platform.h"
+#include "mbedtls_heap_stats.h"
+
+#include <stdint.h>
+
+#if defined(MBEDTLS_PLATFORM_MEMORY) && \
+    !defined(MBEDTLS_PLATFORM_CALLOC_MACRO) && \
+    !defined(MBEDTLS_PLATFORM_FREE_MACRO)
+
+#if defined(__MBED__)
+#include "platform/mbed_critical.h"
+#define HEAP_STATS_LOCK()       core_util_critical_section_enter()
+#define HEAP_STATS_UNLOCK()     core_util_critical_section_exit()
+#else
+#define HEAP_STATS_LOCK()
+#define HEAP_STATS_UNLOCK()
+#endif
+
+/*
+ * mbed TLS frees without saying how big the block was, so each block starts
+ * with its requested size. The header is a union with a 64-bit member so
+ * that the block handed back is aligned for any type, as the underlying
+ * calloc's was.
+ */
+typedef union
+{
+    size_t size;
+    uint64_t align;
+}
+heap_stats_header;
+
+static int heap_stats_installed;
+static size_t heap_stats_current;
+static size_t heap_stats_peak;
+static void *(*heap_stats_next_calloc)( size_t, size_t );
+static void (*heap_stats_next_free)( void * );
+
+static void *heap_stats_calloc( size_t n, size_t size )
+{
+    heap_stats_header *h;
+    size_t total;
+
+    if( size != 0 && n > ( SIZE_MAX - sizeof( heap_stats_header ) ) / size )
+        return( NULL );
+
+    total = n * size;
+    h = heap_stats_next_calloc( 1, sizeof( heap_stats_header ) + total );
+    if( h == NULL )
+        return( NULL );
+    h->size = total;
+
+    HEAP_STATS_LOCK();
+    heap_stats_current += total;
+    if( heap_stats_current > heap_stats_peak )
+        heap_stats_peak = heap_stats_current;
+    HEAP_STATS_UNLOCK();
+
+    return( h + 1 );
+}
+
+static void heap_stats_free( void *ptr )
+{
+    heap_stats_header *h;
+
+    if( ptr == NULL )
+        return;
+
+    h = (heap_stats_header *) ptr - 1;
+    HEAP_STATS_LOCK();
+    heap_stats_current -= h->size;
+    HEAP_STATS_UNLOCK();
+    heap_stats_next_free( h );
+}
+
+int mbedtls_heap_stats_install( void )
+{
+    HEAP_STATS_LOCK();
+    if( !heap_stats_installed )
+    {
+        heap_stats_next_calloc = mbedtls_calloc;
+        heap_stats_next_free = mbedtls_free;
+        mbedtls_platform_set_calloc_free( heap_stats_calloc, heap_stats_free );
+        heap_stats_installed = 1;
+    }
+    HEAP_STATS_UNLOCK();
+
+    return( 0 );
+}
+
+void mbedtls_heap_stats_get( size_t *current, size_t *peak )
+{
+    HEAP_STATS_LOCK();
+    if( current != NULL )
+        *current = heap_stats_current;
+    if( peak != NULL )
+        *peak = heap_stats_peak;
+    HEAP_STATS_UNLOCK();
+}
+
+void mbedtls_heap_stats_reset_peak( void )
+{
+    HEAP_STATS_LOCK();
+    heap_stats_peak = heap_stats_current;
+    HEAP_STATS_UNLOCK();
+}
+
+#else
+
+int mbedtls_heap_stats_install( void )
+{
+    return( -1 );
+}
+
+void mbedtls_heap_stats_get( size_t *current, size_t *peak )
+{
+    if( current != NULL )
+        *current = 0;
+    if( peak != NULL )
+        *peak = 0;
+}
+
+void mbedtls_heap_stats_reset_peak( void )
+{
+}
+
+#endif /* MBEDTLS_PLATFORM_MEMORY && !MBEDTLS_PLATFORM_*_MACRO */
@@ -334,7 +334,8 @@ void mbedtls_ecp_group_free( mbedtls_ecp_group *grp )
         mbedtls_mpi_free( &grp->N );
     }
 
-    if( grp->T != NULL )
+    /* T_size is 0 for the static tables loaded by mbedtls_ecp_group_load() */
+    if( grp->T != NULL && grp->T_size != 0 )
     {
         for( i = 0; i < grp->T_size; i++ )
             mbedtls_ecp_point_free( &grp->T[i] );
@@ -1362,6 +1363,8 @@ static int ecp_mul_comb( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
     /*
      * Prepare precomputed points: if P == G we want to
      * use grp->T if already initialized, or initialize it.
+     * grp->T may be a static table from ecp_comb_tables.h, which is only
+     * compiled in when it was generated for this same w.
      */
     T = p_eq_g ? grp->T : NULL;
 
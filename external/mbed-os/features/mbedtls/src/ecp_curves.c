@@ -547,6 +547,21 @@ static const mbedtls_mpi_uint brainpoolP512r1_n[] = {
 };
 #endif /* MBEDTLS_ECP_DP_BP512R1_ENABLED */
 
+/*
+ * Precomputed fixed-base comb tables for the generators, in flash, so that
+ * ecp_mul_comb() doesn't have to build grp->T on the heap when P == G.
+ * Regenerate ecp_comb_tables.h with importer/gen_ecp_comb_tables.py.
+ */
+static const mbedtls_mpi_uint ecp_mpi_one[] = { 1 };
+
+#define ECP_POINT_INIT_XY_Z1( x, y ) {                                          \
+    { 1, sizeof( x ) / sizeof( mbedtls_mpi_uint ), (mbedtls_mpi_uint *) x },    \
+    { 1, sizeof( y ) / sizeof( mbedtls_mpi_uint ), (mbedtls_mpi_uint *) y },    \
+    { 1, 1, (mbedtls_mpi_uint *) ecp_mpi_one }                                  \
+}
+
+#include "ecp_comb_tables.h"
+
 /*
  * Create an MPI from embedded constants
  * (assumes len is an exact multiple of sizeof mbedtls_mpi_uint)
@@ -578,7 +593,8 @@ static int ecp_group_load( mbedtls_ecp_group *grp,
                            const mbedtls_mpi_uint *b,  size_t blen,
                            const mbedtls_mpi_uint *gx, size_t gxlen,
                            const mbedtls_mpi_uint *gy, size_t gylen,
-                           const mbedtls_mpi_uint *n,  size_t nlen)
+                           const mbedtls_mpi_uint *n,  size_t nlen,
+                           const mbedtls_ecp_point *T)
 {
     ecp_mpi_load( &grp->P, p, plen );
     if( a != NULL )
@@ -595,6 +611,10 @@ static int ecp_group_load( mbedtls_ecp_group *grp,
 
     grp->h = 1;
 
+    /* T_size == 0 marks a static table that must not be freed */
+    grp->T = (mbedtls_ecp_point *) T;
+    grp->T_size = 0;
+
     return( 0 );
 }
 
@@ -641,7 +661,8 @@ static int ecp_mod_p256k1( mbedtls_mpi * );
                             G ## _b,  sizeof( G ## _b  ),   \
                             G ## _gx, sizeof( G ## _gx ),   \
                             G ## _gy, sizeof( G ## _gy ),   \
-                            G ## _n,  sizeof( G ## _n  ) )
+                            G ## _n,  sizeof( G ## _n  ),   \
+                            G ## _T )
 
 #define LOAD_GROUP( G )     ecp_group_load( grp,            \
                             G ## _p,  sizeof( G ## _p  ),   \
@@ -649,7 +670,8 @@ static int ecp_mod_p256k1( mbedtls_mpi * );
                             G ## _b,  sizeof( G ## _b  ),   \
                             G ## _gx, sizeof( G ## _gx ),   \
                             G ## _gy, sizeof( G ## _gy ),   \
-                            G ## _n,  sizeof( G ## _n  ) )
+                            G ## _n,  sizeof( G ## _n  ),   \
+                            G ## _T )
 
 #if defined(MBEDTLS_ECP_DP_CURVE25519_ENABLED)
 /*
@@ -0,0 +1,584 @@
+/* TLSSocket
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TLSSocket.h"
+
+#if defined(MBEDTLS_SSL_CLI_C)
+
+#include <stdlib.h>
+#include <string.h>
+#include "mbedtls/platform.h"
+#include "mbedtls_heap_stats.h"
+#include "platform/mbed_critical.h"
+#include "cmsis_os.h"
+
+#define TLS_DRBG_PERSONALIZATION "mbed TLSSocket"
+
+#if defined(MBEDTLS_PLATFORM_MEMORY) && !defined(MBEDTLS_PLATFORM_CALLOC_MACRO) && !defined(MBEDTLS_PLATFORM_FREE_MACRO)
+#define TLS_HEAP_STATS 1
+
+// The allocator that was in place when install_allocator() ran, which is
+// the heap counter from mbedtls_heap_stats or something stacked on it
+static bool tls_heap_installed;
+static void *(*tls_heap_calloc)(size_t, size_t);
+static void (*tls_heap_free)(void *);
+
+#ifndef MBED_CONF_NSAPI_TLS_ARENA_THREADS
+#define MBED_CONF_NSAPI_TLS_ARENA_THREADS 4
+#endif
+
+// While a socket with an arena is inside mbed TLS its thread owns a slot
+// naming the arena, and allocations made on that thread come from it. Other
+// threads, including ones running other arenas, carry on independently.
+typedef struct {
+    void *volatile thread;
+    mbedtls_arena *volatile arena;
+} tls_arena_slot_t;
+
+static tls_arena_slot_t tls_arena_slots[MBED_CONF_NSAPI_TLS_ARENA_THREADS];
+
+static tls_arena_slot_t *tls_arena_slot(void *thread)
+{
+    for (int i = 0; i < MBED_CONF_NSAPI_TLS_ARENA_THREADS; i++) {
+        if (tls_arena_slots[i].thread == thread) {
+            return &tls_arena_slots[i];
+        }
+    }
+    return NULL;
+}
+
+static mbedtls_arena *tls_arena_active()
+{
+    // Only the owning thread fills in or clears its slot, so a slot found
+    // here cannot change underneath us
+    tls_arena_slot_t *slot = tls_arena_slot(osThreadGetId());
+    return slot ? slot->arena : NULL;
+}
+
+static void tls_arena_enter(mbedtls_arena *arena)
+{
+    if (!arena) {
+        return;
+    }
+    void *self = osThreadGetId();
+    while (true) {
+        for (int i = 0; i < MBED_CONF_NSAPI_TLS_ARENA_THREADS; i++) {
+            void *expected = NULL;
+            if (core_util_atomic_cas_ptr((void **)&tls_arena_slots[i].thread, &expected, self)) {
+                tls_arena_slots[i].arena = arena;
+                return;
+            }
+        }
+        // More threads are inside mbed TLS with arenas than there are slots
+        osThreadYield();
+    }
+}
+
+static void tls_arena_exit(mbedtls_arena *arena)
+{
+    if (!arena) {
+        return;
+    }
+    tls_arena_slot_t *slot = tls_arena_slot(osThreadGetId());
+    slot->arena = NULL;
+    slot->thread = NULL;
+}
+
+static void *tls_calloc(size_t count, size_t size)
+{
+    mbedtls_arena *arena = tls_arena_active();
+    if (arena) {
+        return mbedtls_arena_calloc(arena, count, size);
+    }
+
+    return tls_heap_calloc(count, size);
+}
+
+static void tls_free(void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+
+    mbedtls_arena *arena = tls_arena_active();
+    if (arena && mbedtls_arena_owns(arena, ptr)) {
+        mbedtls_arena_free(arena, ptr);
+        return;
+    }
+
+    tls_heap_free(ptr);
+}
+
+#else
+
+static void tls_arena_enter(mbedtls_arena *arena)
+{
+}
+
+static void tls_arena_exit(mbedtls_arena *arena)
+{
+}
+
+#endif
+
+// Runs the enclosing block's mbed TLS calls out of a socket's arena
+class TLSArenaScope {
+public:
+    TLSArenaScope(mbedtls_arena *arena) : _arena(arena)
+    {
+        tls_arena_enter(_arena);
+    }
+
+    ~TLSArenaScope()
+    {
+        tls_arena_exit(_arena);
+    }
+
+private:
+    mbedtls_arena *_arena;
+};
+
+static nsapi_error_t tls_error(int ret)
+{
+    // Socket errors from the BIO callbacks are passed through by mbed TLS
+    if (ret <= NSAPI_ERROR_WOULD_BLOCK && ret >= NSAPI_ERROR_IS_CONNECTED) {
+        return ret;
+    }
+
+    switch (ret) {
+        case MBEDTLS_ERR_SSL_WANT_READ:
+        case MBEDTLS_ERR_SSL_WANT_WRITE:
+            return NSAPI_ERROR_WOULD_BLOCK;
+        case MBEDTLS_ERR_SSL_ALLOC_FAILED:
+            return NSAPI_ERROR_NO_MEMORY;
+        case MBEDTLS_ERR_X509_CERT_VERIFY_FAILED:
+            return NSAPI_ERROR_AUTH_FAILURE;
+        default:
+            return NSAPI_ERROR_DEVICE_ERROR;
+    }
+}
+
+TLSSocket::TLSSocket()
+{
+    init();
+}
+
+nsapi_error_t TLSSocket::install_allocator()
+{
+#if TLS_HEAP_STATS
+    core_util_critical_section_enter();
+    if (!tls_heap_installed) {
+        mbedtls_heap_stats_install();
+        tls_heap_calloc = mbedtls_calloc;
+        tls_heap_free = mbedtls_free;
+        mbedtls_platform_set_calloc_free(tls_calloc, tls_free);
+        tls_heap_installed = true;
+    }
+    core_util_critical_section_exit();
+    return NSAPI_ERROR_OK;
+#else
+    return NSAPI_ERROR_UNSUPPORTED;
+#endif
+}
+
+void TLSSocket::init()
+{
+    _stack = NULL;
+    _timeout = -1;
+    _tls_state = TLS_IDLE;
+    _setup_done = false;
+    _session_valid = false;
+    _resumed = false;
+    _hostname = NULL;
+    memset(&_stats, 0, sizeof(_stats));
+    _has_arena = false;
+    memset(&_arena, 0, sizeof(_arena));
+
+    mbedtls_entropy_init(&_entropy);
+    mbedtls_ctr_drbg_init(&_ctr_drbg);
+    mbedtls_x509_crt_init(&_cacert);
+    mbedtls_ssl_config_init(&_ssl_conf);
+    mbedtls_ssl_init(&_ssl);
+    mbedtls_ssl_session_init(&_session);
+}
+
+TLSSocket::~TLSSocket()
+{
+    close();
+
+    TLSArenaScope scope(arena());
+    mbedtls_ssl_session_free(&_session);
+    mbedtls_ssl_free(&_ssl);
+    mbedtls_ssl_config_free(&_ssl_conf);
+    mbedtls_x509_crt_free(&_cacert);
+    mbedtls_ctr_drbg_free(&_ctr_drbg);
+    mbedtls_entropy_free(&_entropy);
+    delete[] _hostname;
+}
+
+nsapi_error_t TLSSocket::open(NetworkStack *stack)
+{
+    nsapi_error_t err = _tcp.open(stack);
+    if (err == NSAPI_ERROR_OK) {
+        _stack = stack;
+    }
+    return err;
+}
+
+nsapi_error_t TLSSocket::set_root_ca_cert(const char *root_ca_pem)
+{
+    if (!root_ca_pem) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    // The PEM parser needs the terminating NULL included in the length
+    TLSArenaScope scope(arena());
+    int ret = mbedtls_x509_crt_parse(&_cacert, (const unsigned char *)root_ca_pem, strlen(root_ca_pem) + 1);
+    if (ret != 0) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_error_t TLSSocket::set_arena(void *buffer, nsapi_size_t size)
+{
+#if TLS_HEAP_STATS
+    if (!tls_heap_installed) {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+
+    // Anything already allocated came from the heap and has to go back there
+    if (_has_arena || _setup_done || _session_valid || _cacert.version != 0) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    if (mbedtls_arena_init(&_arena, buffer, size) != 0) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+    _has_arena = true;
+    return NSAPI_ERROR_OK;
+#else
+    return NSAPI_ERROR_UNSUPPORTED;
+#endif
+}
+
+mbedtls_arena *TLSSocket::arena()
+{
+    return _has_arena ? &_arena : NULL;
+}
+
+nsapi_error_t TLSSocket::set_hostname(const char *hostname)
+{
+    if (!hostname) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    char *copy = new char[strlen(hostname) + 1];
+    strcpy(copy, hostname);
+    delete[] _hostname;
+    _hostname = copy;
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_error_t TLSSocket::setup()
+{
+    if (_setup_done) {
+        return NSAPI_ERROR_OK;
+    }
+
+    int ret = mbedtls_ctr_drbg_seed(&_ctr_drbg, mbedtls_entropy_func, &_entropy,
+                                    (const unsigned char *)TLS_DRBG_PERSONALIZATION,
+                                    sizeof(TLS_DRBG_PERSONALIZATION) - 1);
+    if (ret != 0) {
+        return NSAPI_ERROR_DEVICE_ERROR;
+    }
+
+    ret = mbedtls_ssl_config_defaults(&_ssl_conf, MBEDTLS_SSL_IS_CLIENT,
+                                      MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret != 0) {
+        return tls_error(ret);
+    }
+
+    mbedtls_ssl_conf_authmode(&_ssl_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_ca_chain(&_ssl_conf, &_cacert, NULL);
+    mbedtls_ssl_conf_rng(&_ssl_conf, mbedtls_ctr_drbg_random, &_ctr_drbg);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&_ssl_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+
+    ret = mbedtls_ssl_setup(&_ssl, &_ssl_conf);
+    if (ret != 0) {
+        return tls_error(ret);
+    }
+
+    _setup_done = true;
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_error_t TLSSocket::connect(const char *host, uint16_t port)
+{
+    if (!_stack) {
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+
+    if (_tls_state == TLS_IDLE) {
+        nsapi_error_t err = set_hostname(host);
+        if (err) {
+            return err;
+        }
+    }
+
+    SocketAddress address;
+    nsapi_error_t err = _stack->gethostbyname(host, &address);
+    if (err) {
+        return NSAPI_ERROR_DNS_FAILURE;
+    }
+
+    address.set_port(port);
+    return connect(address);
+}
+
+nsapi_error_t TLSSocket::connect(const SocketAddress &address)
+{
+    nsapi_error_t ret;
+
+    if (!_stack) {
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+
+    if (_tls_state == TLS_CONNECTED) {
+        return NSAPI_ERROR_IS_CONNECTED;
+    }
+
+    if (_tls_state == TLS_IDLE) {
+        TLSArenaScope scope(arena());
+        ret = setup();
+        if (ret) {
+            return ret;
+        }
+
+        int err = mbedtls_ssl_session_reset(&_ssl);
+        if (err == 0 && _hostname) {
+            err = mbedtls_ssl_set_hostname(&_ssl, _hostname);
+        }
+        if (err == 0 && _session_valid) {
+            err = mbedtls_ssl_set_session(&_ssl, &_session);
+        }
+        if (err != 0) {
+            return tls_error(err);
+        }
+        mbedtls_ssl_set_bio(&_ssl, this, ssl_send, ssl_recv, NULL);
+        _resumed = false;
+        _tls_state = TLS_TCP_CONNECTING;
+    }
+
+    if (_tls_state == TLS_TCP_CONNECTING) {
+        ret = _tcp.connect(address);
+        if (ret == NSAPI_ERROR_IN_PROGRESS || ret == NSAPI_ERROR_ALREADY) {
+            return NSAPI_ERROR_IN_PROGRESS;
+        } else if (ret != NSAPI_ERROR_OK && ret != NSAPI_ERROR_IS_CONNECTED) {
+            _tls_state = TLS_IDLE;
+            return ret;
+        }
+
+        _tls_state = TLS_HANDSHAKING;
+#if TLS_HEAP_STATS
+        mbedtls_heap_stats_reset_peak();
+#endif
+        if (_has_arena) {
+            mbedtls_arena_reset_peak(&_arena);
+        }
+        _handshake_timer.reset();
+        _handshake_timer.start();
+    }
+
+    ret = handshake();
+    if (ret == NSAPI_ERROR_WOULD_BLOCK) {
+        // Blocking sockets only get here if the socket timeout expired
+        return (_timeout == 0) ? NSAPI_ERROR_IN_PROGRESS : NSAPI_ERROR_WOULD_BLOCK;
+    }
+    return ret;
+}
+
+nsapi_error_t TLSSocket::handshake()
+{
+    TLSArenaScope scope(arena());
+    int ret = mbedtls_ssl_handshake(&_ssl);
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        return NSAPI_ERROR_WOULD_BLOCK;
+    }
+
+    _handshake_timer.stop();
+    _stats.last_handshake_ms = _handshake_timer.read_ms();
+#if TLS_HEAP_STATS
+    size_t heap_peak;
+    mbedtls_heap_stats_get(NULL, &heap_peak);
+    _stats.last_heap_peak = _has_arena ? _arena.peak : heap_peak;
+    if (_stats.last_heap_peak > _stats.max_heap_peak) {
+        _stats.max_heap_peak = _stats.last_heap_peak;
+    }
+#endif
+
+    if (ret != 0) {
+        _stats.failures++;
+        _tls_state = TLS_IDLE;
+        _tcp.close();
+        _stack = NULL;
+        return tls_error(ret);
+    }
+
+    // A resumed session reuses the master secret of the one that was offered
+    _resumed = _session_valid &&
+               memcmp(_ssl.session->master, _session.master, sizeof(_session.master)) == 0;
+
+    // Keep the negotiated session, including any ticket the server sent,
+    // for the next connect
+    mbedtls_ssl_session_free(&_session);
+    mbedtls_ssl_session_init(&_session);
+    _session_valid = (mbedtls_ssl_get_session(&_ssl, &_session) == 0);
+
+    _stats.handshakes++;
+    if (_resumed) {
+        _stats.resumed++;
+    }
+    _stats.total_handshake_ms += _stats.last_handshake_ms;
+    _tls_state = TLS_CONNECTED;
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_size_or_error_t TLSSocket::send(const void *data, nsapi_size_t size)
+{
+    if (_tls_state != TLS_CONNECTED) {
+        return NSAPI_ERROR_NO_CONNECTION;
+    }
+
+    TLSArenaScope scope(arena());
+    int ret = mbedtls_ssl_write(&_ssl, (const unsigned char *)data, size);
+    if (ret < 0) {
+        return tls_error(ret);
+    }
+    return ret;
+}
+
+nsapi_size_or_error_t TLSSocket::recv(void *data, nsapi_size_t size)
+{
+    if (_tls_state != TLS_CONNECTED) {
+        return NSAPI_ERROR_NO_CONNECTION;
+    }
+
+    TLSArenaScope scope(arena());
+    int ret = mbedtls_ssl_read(&_ssl, (unsigned char *)data, size);
+    if (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY || ret == MBEDTLS_ERR_SSL_CONN_EOF) {
+        return 0;
+    } else if (ret < 0) {
+        return tls_error(ret);
+    }
+    return ret;
+}
+
+nsapi_error_t TLSSocket::close()
+{
+    if (_tls_state == TLS_CONNECTED) {
+        // Best effort, the server may already have gone
+        TLSArenaScope scope(arena());
+        mbedtls_ssl_close_notify(&_ssl);
+    }
+    _tls_state = TLS_IDLE;
+    _stack = NULL;
+
+    return _tcp.close();
+}
+
+void TLSSocket::set_blocking(bool blocking)
+{
+    set_timeout(blocking ? -1 : 0);
+}
+
+void TLSSocket::set_timeout(int timeout)
+{
+    _timeout = timeout;
+    _tcp.set_timeout(timeout);
+}
+
+void TLSSocket::sigio(mbed::Callback<void()> func)
+{
+    _tcp.sigio(func);
+}
+
+void TLSSocket::clear_session()
+{
+    TLSArenaScope scope(arena());
+    mbedtls_ssl_session_free(&_session);
+    mbedtls_ssl_session_init(&_session);
+    _session_valid = false;
+}
+
+bool TLSSocket::has_session() const
+{
+    return _session_valid;
+}
+
+bool TLSSocket::is_resumed() const
+{
+    return _resumed;
+}
+
+void TLSSocket::get_stats(tls_socket_stats_t *stats) const
+{
+    *stats = _stats;
+}
+
+void TLSSocket::reset_stats()
+{
+    memset(&_stats, 0, sizeof(_stats));
+    if (_has_arena) {
+        mbedtls_arena_reset_peak(&_arena);
+    }
+}
+
+void TLSSocket::get_arena_stats(mbedtls_arena_stats *stats) const
+{
+    mbedtls_arena_get_stats(&_arena, stats);
+}
+
+int TLSSocket::ssl_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    TLSSocket *socket = static_cast<TLSSocket *>(ctx);
+
+    // Give up the slot while this socket waits on the network
+    tls_arena_exit(socket->arena());
+    nsapi_size_or_error_t ret = socket->_tcp.send(buf, len);
+    tls_arena_enter(socket->arena());
+    if (ret == NSAPI_ERROR_WOULD_BLOCK) {
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+    }
+    return ret;
+}
+
+int TLSSocket::ssl_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    TLSSocket *socket = static_cast<TLSSocket *>(ctx);
+
+    tls_arena_exit(socket->arena());
+    nsapi_size_or_error_t ret = socket->_tcp.recv(buf, len);
+    tls_arena_enter(socket->arena());
+    if (ret == NSAPI_ERROR_WOULD_BLOCK) {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+    return ret;
+}
+
+#endif /* MBEDTLS_SSL_CLI_C */
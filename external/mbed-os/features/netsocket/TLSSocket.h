@@ -0,0 +1,335 @@
+
+/** \addtogroup netsocket */
+/** @{*/
+/* TLSSocket
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TLSSOCKET_H
+#define TLSSOCKET_H
+
+#include "netsocket/TCPSocket.h"
+#include "drivers/Timer.h"
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_SSL_CLI_C)
+
+#include "mbedtls/ssl.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls_arena.h"
+
+
+/** TLS handshake counters
+ */
+typedef struct tls_socket_stats {
+    uint32_t handshakes;          /**< Handshakes completed */
+    uint32_t resumed;             /**< Handshakes that resumed a saved session by ID or ticket */
+    uint32_t failures;            /**< Handshakes that failed */
+    uint32_t last_handshake_ms;   /**< Duration of the most recent handshake */
+    uint32_t total_handshake_ms;  /**< Sum of the durations of all completed handshakes */
+    uint32_t last_heap_peak;      /**< Peak mbed TLS memory in use during the most recent handshake, in the
+                                       socket's arena if it has one, otherwise on the heap by all connections */
+    uint32_t max_heap_peak;       /**< Highest last_heap_peak seen */
+} tls_socket_stats_t;
+
+/** TLS client socket connection
+ *
+ *  Runs mbed TLS over a TCPSocket that it owns. TLSSocket is deliberately
+ *  not a TCPSocket or a Socket, so it can never be handed to code expecting
+ *  one and have that code send and receive around the TLS session. The
+ *  session negotiated by a successful
+ *  handshake is kept across close() and offered again on the next connect(),
+ *  so reconnecting to the same server resumes by session ID or session
+ *  ticket instead of repeating the full public key handshake.
+ *
+ *  In non-blocking mode connect() drives both the TCP connection and the
+ *  handshake, returning NSAPI_ERROR_IN_PROGRESS until the handshake is done
+ *  and NSAPI_ERROR_IS_CONNECTED after that, like TCPSocket::connect.
+ *
+ *  Heap peaks are measured by routing mbed TLS allocations through a
+ *  counting allocator, which the application opts in to with
+ *  install_allocator(). It is only available when MBEDTLS_PLATFORM_MEMORY
+ *  is enabled (platform_mbed.h enables it along with the full TLS
+ *  configuration); otherwise the peaks read as zero.
+ *
+ *  set_arena, which also needs install_allocator(), gives the socket a buffer of its own that all of its mbed TLS
+ *  allocations, from certificate parsing to the record buffers, are drawn
+ *  from instead of the heap. Repeated connections then cannot fragment the
+ *  heap, and the arena counters show exactly how much RAM the connection
+ *  needs.
+ *
+ *  Unlike TCPSocket, send and recv must not be called concurrently from
+ *  different threads since both use the same TLS context.
+ */
+class TLSSocket {
+public:
+    /** Create an uninitialized socket
+     *
+     *  Must call open to initialize the socket on a network stack.
+     */
+    TLSSocket();
+
+    /** Create a socket on a network interface
+     *
+     *  Creates and opens a socket on the network stack of the given
+     *  network interface.
+     *
+     *  @param stack    Network stack as target for socket
+     */
+    template <typename S>
+    TLSSocket(S *stack)
+    {
+        init();
+        open(stack);
+    }
+
+    /** Destroy a socket
+     *
+     *  Closes socket if the socket is still open and releases the saved
+     *  session.
+     */
+    virtual ~TLSSocket();
+
+    /** Route mbed TLS allocations through TLSSocket's arena-aware allocator
+     *
+     *  Needed for the heap peaks in get_stats and for set_arena. Installs
+     *  the mbedtls_heap_stats counters underneath if they are not already
+     *  in, so it must be called before anything is allocated through mbed
+     *  TLS, ideally first thing in main. Heap blocks are still obtained from
+     *  the allocator that was installed before, so an application allocator
+     *  keeps serving them. Calling it again has no effect.
+     *
+     *  @return         0 on success, NSAPI_ERROR_UNSUPPORTED without
+     *                  MBEDTLS_PLATFORM_MEMORY
+     */
+    static nsapi_error_t install_allocator();
+
+    /** Opens a socket
+     *
+     *  Creates a network socket on the network stack of the given
+     *  network interface. Not needed if stack is passed to the
+     *  socket's constructor.
+     *
+     *  @param stack    Network stack as target for socket
+     *  @return         0 on success, negative error code on failure
+     */
+    nsapi_error_t open(NetworkStack *stack);
+
+    template <typename S>
+    nsapi_error_t open(S *stack)
+    {
+        return open(nsapi_create_stack(stack));
+    }
+
+    /** Set the root certificates used to verify the server
+     *
+     *  May be called more than once to add several certificates. Must be
+     *  called before connect.
+     *
+     *  @param root_ca_pem  NULL terminated PEM encoded certificate(s)
+     *  @return             0 on success, negative error code on failure
+     */
+    nsapi_error_t set_root_ca_cert(const char *root_ca_pem);
+
+    /** Give the socket its own memory for mbed TLS
+     *
+     *  All of the socket's mbed TLS state, including the parsed root
+     *  certificates and the saved session, is allocated from buffer rather
+     *  than the heap. Must be called before set_root_ca_cert and connect.
+     *  The buffer must outlive the socket.
+     *
+     *  Up to nsapi.tls-arena-threads threads can be inside mbed TLS with an
+     *  arena at once, not counting time spent waiting for the network; any
+     *  more wait for one of them. Sockets without an arena are not held up.
+     *
+     *  @param buffer   Memory for the arena, 8-byte aligned for best use
+     *  @param size     Size of buffer in bytes
+     *  @return         0 on success, NSAPI_ERROR_PARAMETER if the socket has
+     *                  already allocated or buffer is too small,
+     *                  NSAPI_ERROR_UNSUPPORTED without MBEDTLS_PLATFORM_MEMORY
+     *                  or before install_allocator
+     */
+    nsapi_error_t set_arena(void *buffer, nsapi_size_t size);
+
+    /** Set the name the server certificate is checked against
+     *
+     *  Also sent to the server as the SNI extension. connect(host, port)
+     *  sets this from host, so it is only needed when connecting by address.
+     *
+     *  @param hostname     NULL terminated host name, copied
+     *  @return             0 on success, negative error code on failure
+     */
+    nsapi_error_t set_hostname(const char *hostname);
+
+    /** Connects TLS socket to a remote host
+     *
+     *  Resolves host, connects the TCP socket and performs the TLS
+     *  handshake. host is also used to verify the server certificate.
+     *
+     *  @param host     Hostname of the remote host
+     *  @param port     Port of the remote host
+     *  @return         0 on success, negative error code on failure
+     */
+    nsapi_error_t connect(const char *host, uint16_t port);
+
+    /** Connects TLS socket to a remote host
+     *
+     *  Connects the TCP socket and performs the TLS handshake, resuming the
+     *  saved session if there is one.
+     *
+     *  @param address  The SocketAddress of the remote host
+     *  @return         0 on success, negative error code on failure
+     */
+    nsapi_error_t connect(const SocketAddress &address);
+
+    /** Send data over a TLS socket
+     *
+     *  @param data     Buffer of data to send to the host
+     *  @param size     Size of the buffer in bytes
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t send(const void *data, nsapi_size_t size);
+
+    /** Receive data over a TLS socket
+     *
+     *  @param data     Destination buffer for data received from the host
+     *  @param size     Size of the buffer in bytes
+     *  @return         Number of received bytes on success, 0 once the
+     *                  server has closed the connection, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t recv(void *data, nsapi_size_t size);
+
+    /** Close the socket
+     *
+     *  Sends a close_notify alert if connected and closes the TCP socket.
+     *  The saved session is kept for the next connect.
+     *
+     *  @return         0 on success, negative error code on failure
+     */
+    nsapi_error_t close();
+
+    /** Set blocking or non-blocking mode of the socket
+     *
+     *  See Socket::set_blocking, connect() and the TLS record calls follow
+     *  the mode of the underlying TCP socket.
+     *
+     *  @param blocking true for blocking mode, false for non-blocking mode.
+     */
+    void set_blocking(bool blocking);
+
+    /** Set timeout on blocking socket operations
+     *
+     *  See Socket::set_timeout.
+     *
+     *  @param timeout  Timeout in milliseconds
+     */
+    void set_timeout(int timeout);
+
+    /** Register a callback on state change of the socket
+     *
+     *  See Socket::sigio. The callback fires on TCP events, which may not
+     *  amount to a whole TLS record being available.
+     *
+     *  @param func     Function to call on state change
+     */
+    void sigio(mbed::Callback<void()> func);
+
+    /** Forget the saved session so the next handshake is a full one
+     */
+    void clear_session();
+
+    /** Check if a session is saved for resumption
+     *
+     *  @return         True after a successful handshake until clear_session
+     */
+    bool has_session() const;
+
+    /** Check if the last handshake resumed the saved session
+     *
+     *  @return         True if the last handshake was abbreviated
+     */
+    bool is_resumed() const;
+
+    /** Get the handshake counters
+     *
+     *  @param stats    Destination for a copy of the counters
+     */
+    void get_stats(tls_socket_stats_t *stats) const;
+
+    /** Zero the handshake counters
+     *
+     *  Also restarts the arena peak from its current usage.
+     */
+    void reset_stats();
+
+    /** Get the arena usage counters
+     *
+     *  @param stats    Destination for the counters, zeroed if the socket
+     *                  has no arena
+     */
+    void get_arena_stats(mbedtls_arena_stats *stats) const;
+
+protected:
+    enum tls_state {
+        TLS_IDLE,
+        TLS_TCP_CONNECTING,
+        TLS_HANDSHAKING,
+        TLS_CONNECTED,
+    };
+
+    void init();
+    nsapi_error_t setup();
+    nsapi_error_t handshake();
+
+    mbedtls_arena *arena();
+
+    static int ssl_send(void *ctx, const unsigned char *buf, size_t len);
+    static int ssl_recv(void *ctx, unsigned char *buf, size_t len);
+
+    TCPSocket _tcp;
+    NetworkStack *_stack;
+    int _timeout;
+    tls_state _tls_state;
+    bool _setup_done;
+    bool _session_valid;
+    bool _resumed;
+    char *_hostname;
+    mbed::Timer _handshake_timer;
+    tls_socket_stats_t _stats;
+    bool _has_arena;
+    mbedtls_arena _arena;
+
+    mbedtls_entropy_context _entropy;
+    mbedtls_ctr_drbg_context _ctr_drbg;
+    mbedtls_x509_crt _cacert;
+    mbedtls_ssl_config _ssl_conf;
+    mbedtls_ssl_context _ssl;
+    mbedtls_ssl_session _session;
+};
+
+#endif /* MBEDTLS_SSL_CLI_C */
+
+#endif
+
+/** @}*/
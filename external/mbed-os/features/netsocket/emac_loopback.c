@@ -0,0 +1,429 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if DEVICE_EMAC
+
+#include <string.h>
+#include "emac_loopback.h"
+#include "emac_stack_mem.h"
+#include "mbed_critical.h"
+#include "us_ticker_api.h"
+
+#define EMAC_LOOPBACK_FRAME_SIZE    (EMAC_LOOPBACK_MAX_MTU + EMAC_LOOPBACK_HEADER_SIZE)
+
+typedef struct {
+    uint32_t due;
+    uint32_t len;
+    uint8_t  data[EMAC_LOOPBACK_FRAME_SIZE];
+} emac_loopback_frame_t;
+
+// Frames queued for delivery to a port.  Each queue has a single producer
+// (link_out of the peer port) and a single consumer (emac_loopback_poll).
+typedef struct {
+    emac_loopback_frame_t frames[EMAC_LOOPBACK_QUEUE_LEN];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+} emac_loopback_queue_t;
+
+typedef struct {
+    emac_loopback_queue_t rx;
+    emac_link_input_fn input_cb;
+    void *input_data;
+    emac_link_state_change_fn state_cb;
+    void *state_data;
+    uint8_t hwaddr[6];
+    bool powered;
+    bool reflect;
+    emac_loopback_stats_t stats;
+} emac_loopback_port_t;
+
+static uint32_t loopback_get_mtu_size(emac_interface_t *emac);
+static void loopback_get_ifname(emac_interface_t *emac, char *name, uint8_t size);
+static uint8_t loopback_get_hwaddr_size(emac_interface_t *emac);
+static void loopback_get_hwaddr(emac_interface_t *emac, uint8_t *addr);
+static void loopback_set_hwaddr(emac_interface_t *emac, uint8_t *addr);
+static bool loopback_link_out(emac_interface_t *emac, emac_stack_mem_t *buf);
+static bool loopback_power_up(emac_interface_t *emac);
+static void loopback_power_down(emac_interface_t *emac);
+static void loopback_set_link_input_cb(emac_interface_t *emac, emac_link_input_fn input_cb, void *data);
+static void loopback_set_link_state_cb(emac_interface_t *emac, emac_link_state_change_fn state_cb, void *data);
+
+#define LOOPBACK_OPS {                              \
+    .get_mtu_size = loopback_get_mtu_size,          \
+    .get_ifname = loopback_get_ifname,              \
+    .get_hwaddr_size = loopback_get_hwaddr_size,    \
+    .get_hwaddr = loopback_get_hwaddr,              \
+    .set_hwaddr = loopback_set_hwaddr,              \
+    .link_out = loopback_link_out,                  \
+    .power_up = loopback_power_up,                  \
+    .power_down = loopback_power_down,              \
+    .set_link_input_cb = loopback_set_link_input_cb,\
+    .set_link_state_cb = loopback_set_link_state_cb \
+}
+
+static emac_loopback_port_t _ports[EMAC_LOOPBACK_PORTS] = {
+    { .hwaddr = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01} },
+    { .hwaddr = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02} },
+};
+
+static emac_interface_t _interfaces[EMAC_LOOPBACK_PORTS] = {
+    { LOOPBACK_OPS, &_ports[0] },
+    { LOOPBACK_OPS, &_ports[1] },
+};
+
+static const emac_loopback_config_t _default_config = {
+    .mtu = EMAC_LOOPBACK_MAX_MTU,
+    .latency_us = 0,
+    .loss_ppm = 0,
+    .seed = 0x6d626564,
+};
+
+static emac_loopback_config_t _config = {
+    .mtu = EMAC_LOOPBACK_MAX_MTU,
+    .latency_us = 0,
+    .loss_ppm = 0,
+    .seed = 0x6d626564,
+};
+static uint32_t _loss_state = 0x6d626564;
+
+static emac_loopback_port_t *loopback_port(emac_interface_t *emac)
+{
+    return (emac_loopback_port_t *)emac->hw;
+}
+
+static emac_loopback_port_t *loopback_peer(emac_loopback_port_t *port)
+{
+    return (port == &_ports[0]) ? &_ports[1] : &_ports[0];
+}
+
+// xorshift32, only ever advanced from link_out of either port
+static bool loopback_should_drop(void)
+{
+    if (_config.loss_ppm == 0) {
+        return false;
+    }
+
+    core_util_critical_section_enter();
+    uint32_t x = _loss_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    _loss_state = x;
+    core_util_critical_section_exit();
+
+    return (x % 1000000) < _config.loss_ppm;
+}
+
+static uint32_t loopback_get_mtu_size(emac_interface_t *emac)
+{
+    return _config.mtu;
+}
+
+static void loopback_get_ifname(emac_interface_t *emac, char *name, uint8_t size)
+{
+    static const char ifname[] = "lo";
+
+    memcpy(name, ifname, (size < sizeof(ifname)) ? size : sizeof(ifname));
+}
+
+static uint8_t loopback_get_hwaddr_size(emac_interface_t *emac)
+{
+    return sizeof(loopback_port(emac)->hwaddr);
+}
+
+static void loopback_get_hwaddr(emac_interface_t *emac, uint8_t *addr)
+{
+    memcpy(addr, loopback_port(emac)->hwaddr, sizeof(loopback_port(emac)->hwaddr));
+}
+
+static void loopback_set_hwaddr(emac_interface_t *emac, uint8_t *addr)
+{
+    memcpy(loopback_port(emac)->hwaddr, addr, sizeof(loopback_port(emac)->hwaddr));
+}
+
+// Checks a frame of len bytes about to be sent by port against the link
+// settings and claims a slot for it in the peer's queue.  Returns NULL, with
+// *sent set to what link_out should report, if the frame is not to be copied.
+static emac_loopback_frame_t *loopback_tx_begin(emac_loopback_port_t *port, uint32_t len, bool *sent)
+{
+    emac_loopback_queue_t *queue = &loopback_peer(port)->rx;
+
+    *sent = false;
+    if (len > _config.mtu + EMAC_LOOPBACK_HEADER_SIZE) {
+        port->stats.tx_oversize++;
+        return NULL;
+    }
+
+    if (loopback_should_drop()) {
+        // A lossy wire still accepts the frame, it just never arrives
+        port->stats.tx_lost++;
+        *sent = true;
+        return NULL;
+    }
+
+    uint32_t head = queue->head;
+    if ((head + 1) % EMAC_LOOPBACK_QUEUE_LEN == queue->tail) {
+        port->stats.tx_overflow++;
+        return NULL;
+    }
+
+    *sent = true;
+    return &queue->frames[head];
+}
+
+static void loopback_tx_commit(emac_loopback_port_t *port, emac_loopback_frame_t *frame, uint32_t len)
+{
+    emac_loopback_queue_t *queue = &loopback_peer(port)->rx;
+
+    frame->len = len;
+    frame->due = us_ticker_read() + _config.latency_us;
+
+    // Publish the frame only once it has been completely written
+    core_util_critical_section_enter();
+    queue->head = (queue->head + 1) % EMAC_LOOPBACK_QUEUE_LEN;
+    core_util_critical_section_exit();
+
+    port->stats.tx_frames++;
+    port->stats.tx_bytes += len;
+}
+
+static bool loopback_link_out(emac_interface_t *emac, emac_stack_mem_t *buf)
+{
+    emac_loopback_port_t *port = loopback_port(emac);
+    uint32_t len = emac_stack_mem_chain_len(NULL, buf);
+    bool sent;
+
+    if (!port->powered) {
+        return false;
+    }
+
+    emac_loopback_frame_t *frame = loopback_tx_begin(port, len, &sent);
+    if (frame == NULL) {
+        return sent;
+    }
+
+    emac_stack_mem_chain_t *chain = buf;
+    uint32_t offset = 0;
+    while (chain != NULL && offset < len) {
+        emac_stack_mem_t *mem = emac_stack_mem_chain_dequeue(NULL, &chain);
+        uint32_t mem_len = emac_stack_mem_len(NULL, mem);
+        memcpy(&frame->data[offset], emac_stack_mem_ptr(NULL, mem), mem_len);
+        offset += mem_len;
+    }
+    loopback_tx_commit(port, frame, offset);
+    return true;
+}
+
+static bool loopback_power_up(emac_interface_t *emac)
+{
+    emac_loopback_port_t *port = loopback_port(emac);
+
+    port->powered = true;
+    if (port->state_cb) {
+        port->state_cb(port->state_data, true);
+    }
+    return true;
+}
+
+static void loopback_power_down(emac_interface_t *emac)
+{
+    emac_loopback_port_t *port = loopback_port(emac);
+
+    port->powered = false;
+    if (port->state_cb) {
+        port->state_cb(port->state_data, false);
+    }
+}
+
+static void loopback_set_link_input_cb(emac_interface_t *emac, emac_link_input_fn input_cb, void *data)
+{
+    emac_loopback_port_t *port = loopback_port(emac);
+
+    port->input_cb = input_cb;
+    port->input_data = data;
+}
+
+static void loopback_set_link_state_cb(emac_interface_t *emac, emac_link_state_change_fn state_cb, void *data)
+{
+    emac_loopback_port_t *port = loopback_port(emac);
+
+    port->state_cb = state_cb;
+    port->state_data = data;
+}
+
+static void loopback_swap(uint8_t *a, uint8_t *b, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++) {
+        uint8_t t = a[i];
+        a[i] = b[i];
+        b[i] = t;
+    }
+}
+
+// Turns a frame received by a reflecting port around, in place.  ARP requests
+// are answered with the port's own MAC, so every other address on the subnet
+// resolves to it, and unicast IPv4 packets go back with their source and
+// destination addresses swapped.  The sending stack then receives its own
+// packet as if the far address had sent it, which lets a client and a server
+// on the one stack talk to each other across the wire.  A swap leaves the IPv4
+// header and TCP/UDP pseudo header sums unchanged so no checksum is touched.
+static bool loopback_reflect(emac_loopback_port_t *port, uint8_t *data, uint32_t len)
+{
+    uint8_t *eth_dst = &data[0];
+    uint8_t *eth_src = &data[6];
+    uint16_t type = (data[12] << 8) | data[13];
+    uint8_t *payload = &data[EMAC_LOOPBACK_HEADER_SIZE];
+
+    if (type == 0x0806 && len >= EMAC_LOOPBACK_HEADER_SIZE + 28) {
+        uint8_t *sha = &payload[8];
+        uint8_t *spa = &payload[14];
+        uint8_t *tha = &payload[18];
+        uint8_t *tpa = &payload[24];
+
+        // Only requests, and not the gratuitous ones a stack sends for itself
+        if (payload[6] != 0 || payload[7] != 1 || memcmp(spa, tpa, 4) == 0) {
+            return false;
+        }
+        payload[7] = 2;
+        memcpy(tha, sha, 6);
+        memcpy(sha, port->hwaddr, 6);
+        loopback_swap(spa, tpa, 4);
+    } else if (type == 0x0800 && len >= EMAC_LOOPBACK_HEADER_SIZE + 20) {
+        if (eth_dst[0] & 0x01) {
+            return false;
+        }
+        loopback_swap(&payload[12], &payload[16], 4);
+    } else {
+        return false;
+    }
+
+    memcpy(eth_dst, eth_src, 6);
+    memcpy(eth_src, port->hwaddr, 6);
+    return true;
+}
+
+static int loopback_deliver(emac_loopback_port_t *port, uint32_t now)
+{
+    emac_loopback_queue_t *queue = &port->rx;
+    int delivered = 0;
+
+    while (queue->tail != queue->head) {
+        emac_loopback_frame_t *frame = &queue->frames[queue->tail];
+        if ((int32_t)(now - frame->due) < 0) {
+            // Frames are queued in order so nothing behind this one is due either
+            break;
+        }
+
+        if (port->reflect) {
+            port->stats.rx_frames++;
+            port->stats.rx_bytes += frame->len;
+            if (loopback_reflect(port, frame->data, frame->len)) {
+                bool sent;
+                emac_loopback_frame_t *out = loopback_tx_begin(port, frame->len, &sent);
+                if (out != NULL) {
+                    memcpy(out->data, frame->data, frame->len);
+                    loopback_tx_commit(port, out, frame->len);
+                }
+            }
+            delivered++;
+        } else if (port->powered && port->input_cb) {
+            emac_stack_mem_t *mem = emac_stack_mem_alloc(NULL, frame->len, 0);
+            if (mem == NULL) {
+                port->stats.rx_no_mem++;
+            } else {
+                memcpy(emac_stack_mem_ptr(NULL, mem), frame->data, frame->len);
+                emac_stack_mem_set_len(NULL, mem, frame->len);
+                port->stats.rx_frames++;
+                port->stats.rx_bytes += frame->len;
+                port->input_cb(port->input_data, mem);
+                delivered++;
+            }
+        }
+
+        core_util_critical_section_enter();
+        queue->tail = (queue->tail + 1) % EMAC_LOOPBACK_QUEUE_LEN;
+        core_util_critical_section_exit();
+    }
+
+    return delivered;
+}
+
+emac_interface_t *emac_loopback_get_interface(int port)
+{
+    if (port < 0 || port >= EMAC_LOOPBACK_PORTS) {
+        return NULL;
+    }
+    return &_interfaces[port];
+}
+
+void emac_loopback_configure(const emac_loopback_config_t *config)
+{
+    if (config == NULL) {
+        config = &_default_config;
+    }
+
+    core_util_critical_section_enter();
+    _config = *config;
+    if (_config.mtu > EMAC_LOOPBACK_MAX_MTU) {
+        _config.mtu = EMAC_LOOPBACK_MAX_MTU;
+    }
+    _loss_state = _config.seed ? _config.seed : _default_config.seed;
+    core_util_critical_section_exit();
+}
+
+int emac_loopback_poll(void)
+{
+    uint32_t now = us_ticker_read();
+    int delivered = 0;
+
+    for (int i = 0; i < EMAC_LOOPBACK_PORTS; i++) {
+        delivered += loopback_deliver(&_ports[i], now);
+    }
+    return delivered;
+}
+
+void emac_loopback_get_stats(int port, emac_loopback_stats_t *stats)
+{
+    if (port < 0 || port >= EMAC_LOOPBACK_PORTS) {
+        return;
+    }
+
+    core_util_critical_section_enter();
+    *stats = _ports[port].stats;
+    core_util_critical_section_exit();
+}
+
+void emac_loopback_set_reflect(int port, bool reflect)
+{
+    if (port < 0 || port >= EMAC_LOOPBACK_PORTS) {
+        return;
+    }
+
+    _ports[port].reflect = reflect;
+}
+
+void emac_loopback_reset(void)
+{
+    core_util_critical_section_enter();
+    for (int i = 0; i < EMAC_LOOPBACK_PORTS; i++) {
+        memset(&_ports[i].stats, 0, sizeof(_ports[i].stats));
+        _ports[i].rx.head = 0;
+        _ports[i].rx.tail = 0;
+    }
+    core_util_critical_section_exit();
+}
+
+#endif /* DEVICE_EMAC */
@@ -0,0 +1,127 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_EMAC_LOOPBACK_H
+#define MBED_EMAC_LOOPBACK_H
+
+#if DEVICE_EMAC
+
+#include <stdint.h>
+#include "emac_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Loopback EMAC
+ * Two software only Ethernet ports wired back to back through in-process
+ * frame queues.  A frame sent with link_out on one port is delivered to the
+ * link input callback of the other port by emac_loopback_poll(), after the
+ * configured latency and subject to the configured loss rate.
+ *
+ * It needs no Ethernet hardware so the IP stack, netsocket and DNS code can be
+ * run and benchmarked without a network.  It is only built for targets which
+ * provide DEVICE_EMAC, which in this tree is UBLOX_EVK_ODIN_W2.  HOST_SIM has
+ * neither the RTOS nor lwIP so cannot run it.
+ */
+
+/** Number of frames which can be in flight in each direction */
+#ifndef EMAC_LOOPBACK_QUEUE_LEN
+#define EMAC_LOOPBACK_QUEUE_LEN     8
+#endif
+
+/** Largest MTU which can be configured, frame slots are sized for it */
+#ifndef EMAC_LOOPBACK_MAX_MTU
+#define EMAC_LOOPBACK_MAX_MTU       1500
+#endif
+
+/** Ethernet header (dst, src, type) preceding the MTU sized payload */
+#define EMAC_LOOPBACK_HEADER_SIZE   14
+
+#define EMAC_LOOPBACK_PORTS         2
+
+typedef struct {
+    uint32_t mtu;           /**< MTU reported to the stack, at most EMAC_LOOPBACK_MAX_MTU */
+    uint32_t latency_us;    /**< Minimum time a frame spends on the wire */
+    uint32_t loss_ppm;      /**< Frames dropped per million sent */
+    uint32_t seed;          /**< Seed for the loss generator, non-zero */
+} emac_loopback_config_t;
+
+typedef struct {
+    uint32_t tx_frames;     /**< Frames accepted by link_out */
+    uint32_t tx_bytes;
+    uint32_t tx_lost;       /**< Frames dropped by loss injection */
+    uint32_t tx_overflow;   /**< Frames dropped because the queue was full */
+    uint32_t tx_oversize;   /**< Frames dropped because they exceeded the MTU */
+    uint32_t rx_frames;     /**< Frames handed to the link input callback */
+    uint32_t rx_bytes;
+    uint32_t rx_no_mem;     /**< Frames dropped because stack memory ran out */
+} emac_loopback_stats_t;
+
+/**
+ * Return one end of the loopback cable
+ * @param port  0 or 1, frames sent on one are received on the other
+ * @return      Emac interface for the port, NULL if port is out of range
+ */
+emac_interface_t *emac_loopback_get_interface(int port);
+
+/**
+ * Change the link characteristics, applies to both directions
+ * Frames already queued keep the latency they were queued with.
+ * @param config New configuration, NULL restores the defaults
+ */
+void emac_loopback_configure(const emac_loopback_config_t *config);
+
+/**
+ * Deliver every queued frame whose latency has elapsed
+ * Must be called from thread context, typically by a dedicated receive thread
+ * or by the test loop driving the link.
+ * @return Number of frames delivered
+ */
+int emac_loopback_poll(void);
+
+/**
+ * Read the counters for a port
+ * @param port  0 or 1
+ * @param stats Where to copy the counters
+ */
+void emac_loopback_get_stats(int port, emac_loopback_stats_t *stats);
+
+/**
+ * Have a port answer whatever is sent to it in place of a second stack
+ * The port replies to ARP requests for any address other than the sender's
+ * own and returns unicast IPv4 packets with their source and destination
+ * addresses swapped, so a client on the stack attached to the other port
+ * reaches a server on that same stack.  Reflected frames cross the wire again
+ * with the configured latency and loss.  A reflecting port must not also be
+ * attached to a stack.
+ * @param port    0 or 1
+ * @param reflect True to reflect frames, false to pass them to link input
+ */
+void emac_loopback_set_reflect(int port, bool reflect);
+
+/**
+ * Zero the counters and discard any queued frames on both ports
+ */
+void emac_loopback_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEVICE_EMAC */
+
+#endif /* MBED_EMAC_LOOPBACK_H */
@@ -509,6 +509,119 @@ control_t cfstore_find_test_07_end(const size_t call_count)
 }
 
 
+#define CFSTORE_FIND_TEST_08_NUM_NAMESPACES     32
+#define CFSTORE_FIND_TEST_08_NUM_KEYS           8
+
+/* @brief   helper function to walk all the KVs matching key_name_query, returning the number found */
+static int32_t cfstore_find_test_08_walk(const char* key_name_query)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    int32_t find_count = 0;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+    ARM_CFSTORE_HANDLE_INIT(next);
+    ARM_CFSTORE_HANDLE_INIT(prev);
+
+    while((ret = drv->Find(key_name_query, prev, next)) == ARM_DRIVER_OK)
+    {
+        find_count++;
+        CFSTORE_HANDLE_SWAP(prev, next);
+    }
+    if(ret != ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND){
+        return ret;
+    }
+    return find_count;
+}
+
+/**
+ * @brief   test case to time Open() and Find() lookups in a store holding
+ *          many KVs, which use the key index when it is enabled.
+ *
+ * The KVs are created in CFSTORE_FIND_TEST_08_NUM_NAMESPACES namespaces of
+ * CFSTORE_FIND_TEST_08_NUM_KEYS each, interleaved so the KVs in a namespace
+ * are spread through the area. The timings are reported for comparing builds
+ * with and without CFSTORE_KEY_INDEX_DISABLE.
+ *
+ * @return on success returns CaseNext to continue to next test case, otherwise will assert on errors.
+ */
+control_t cfstore_find_test_08_end(const size_t call_count)
+{
+    char key_name[CFSTORE_KEY_NAME_MAX_LENGTH+1];
+    int32_t ret = ARM_DRIVER_ERROR;
+    int32_t i = 0;
+    int32_t j = 0;
+    int32_t total_us = 0;
+    ARM_CFSTORE_SIZE len = 0;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+    ARM_CFSTORE_KEYDESC kdesc;
+    ARM_CFSTORE_FMODE flags;
+    ARM_CFSTORE_HANDLE_INIT(hkey);
+    Timer timer;
+
+    (void) call_count;
+    for(j = 0; j < CFSTORE_FIND_TEST_08_NUM_KEYS; j++){
+        for(i = 0; i < CFSTORE_FIND_TEST_08_NUM_NAMESPACES; i++){
+            snprintf(key_name, sizeof(key_name), "com.arm.mbed.find08.ns%02d.key%02d", (int) i, (int) j);
+            memset(&kdesc, 0, sizeof(kdesc));
+            len = 2;
+            ret = cfstore_test_create(key_name, "v", &len, &kdesc);
+            CFSTORE_TEST_UTEST_MESSAGE(cfstore_find_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to create KV (key_name=%s, ret=%d).\n", __func__, key_name, (int) ret);
+            TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_find_utest_msg_g);
+        }
+    }
+
+    /* Open() every KV by name */
+    memset(&flags, 0, sizeof(flags));
+    timer.start();
+    for(j = 0; j < CFSTORE_FIND_TEST_08_NUM_KEYS; j++){
+        for(i = 0; i < CFSTORE_FIND_TEST_08_NUM_NAMESPACES; i++){
+            snprintf(key_name, sizeof(key_name), "com.arm.mbed.find08.ns%02d.key%02d", (int) i, (int) j);
+            ret = drv->Open(key_name, flags, hkey);
+            CFSTORE_TEST_UTEST_MESSAGE(cfstore_find_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to open KV (key_name=%s, ret=%d).\n", __func__, key_name, (int) ret);
+            TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_find_utest_msg_g);
+            drv->Close(hkey);
+        }
+    }
+    total_us = timer.read_us();
+    CFSTORE_LOG("%s:Open() of %d KVs took %d us (%d us per KV).\n", __func__, (int) (CFSTORE_FIND_TEST_08_NUM_KEYS * CFSTORE_FIND_TEST_08_NUM_NAMESPACES), (int) total_us, (int) (total_us / (CFSTORE_FIND_TEST_08_NUM_KEYS * CFSTORE_FIND_TEST_08_NUM_NAMESPACES)));
+
+    /* Find() a KV which doesnt exist */
+    timer.reset();
+    ret = cfstore_find_test_08_walk("com.arm.mbed.find08.ns99.key00");
+    total_us = timer.read_us();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_find_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: found KV which doesnt exist (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret == 0, cfstore_find_utest_msg_g);
+    CFSTORE_LOG("%s:Find() of missing KV took %d us.\n", __func__, (int) total_us);
+
+    /* Find() all the KVs in one namespace */
+    timer.reset();
+    for(i = 0; i < CFSTORE_FIND_TEST_08_NUM_NAMESPACES; i++){
+        snprintf(key_name, sizeof(key_name), "com.arm.mbed.find08.ns%02d.*", (int) i);
+        ret = cfstore_find_test_08_walk(key_name);
+        CFSTORE_TEST_UTEST_MESSAGE(cfstore_find_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: found %d KVs for %s.\n", __func__, (int) ret, key_name);
+        TEST_ASSERT_MESSAGE(ret == CFSTORE_FIND_TEST_08_NUM_KEYS, cfstore_find_utest_msg_g);
+    }
+    total_us = timer.read_us();
+    CFSTORE_LOG("%s:Find() walk of a namespace took %d us.\n", __func__, (int) (total_us / CFSTORE_FIND_TEST_08_NUM_NAMESPACES));
+
+    /* Find() all the KVs */
+    timer.reset();
+    ret = cfstore_find_test_08_walk("com.arm.mbed.find08.*");
+    total_us = timer.read_us();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_find_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: found %d KVs for all namespaces.\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret == CFSTORE_FIND_TEST_08_NUM_KEYS * CFSTORE_FIND_TEST_08_NUM_NAMESPACES, cfstore_find_utest_msg_g);
+    CFSTORE_LOG("%s:Find() walk of all KVs took %d us.\n", __func__, (int) total_us);
+
+    ret = cfstore_test_delete_all();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_find_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to delete all KVs (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_find_utest_msg_g);
+
+    ret = drv->Uninitialize();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_find_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: Uninitialize() call failed.\n", __func__);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_find_utest_msg_g);
+    return CaseNext;
+}
+
+
 /// @cond CFSTORE_DOXYGEN_DISABLE
 utest::v1::status_t greentea_setup(const size_t number_of_cases)
 {
@@ -531,6 +644,8 @@ Case cases[] = {
         Case("FIND_test_06_end", cfstore_find_test_06_end),
         Case("FIND_test_07_start", cfstore_utest_default_start),
         Case("FIND_test_07_end", cfstore_find_test_07_end),
+        Case("FIND_test_08_start", cfstore_utest_default_start),
+        Case("FIND_test_08_end", cfstore_find_test_08_end),
 };
 
 
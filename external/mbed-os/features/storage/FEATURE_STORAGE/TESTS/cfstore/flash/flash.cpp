@@ -86,7 +86,7 @@ UVISOR_BOX_CONFIG(cfstore_flash_box1, UVISOR_BOX_STACK_SIZE);
 char cfstore_flash_utest_msg_g[CFSTORE_FLASH_UTEST_MSG_BUF_SIZE];
 /// @endcond
 
-#ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
+#if defined CFSTORE_CONFIG_BACKEND_FLASH_ENABLED && !defined CFSTORE_CONFIG_BACKEND_LOG_ENABLED
 uint16_t cfstore_flash_mtd_async_ops_g = 0;
 extern ARM_DRIVER_STORAGE ARM_Driver_Storage_MTD_K64F;
 
@@ -650,7 +650,7 @@ static control_t cfstore_flash_journal_async_test_01(void)
     return CaseTimeout(CFSTORE_FLASH_CASE_TIMEOUT_MS);
 }
 
-#endif /* CFSTORE_CONFIG_BACKEND_FLASH_ENABLED */
+#endif /* CFSTORE_CONFIG_BACKEND_FLASH_ENABLED && !CFSTORE_CONFIG_BACKEND_LOG_ENABLED */
 
 
 /* report whether built/configured for flash sync or async mode */
@@ -665,6 +665,8 @@ static control_t cfstore_flash_test_00(const size_t call_count)
 
 #ifndef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
     CFSTORE_LOG("INITIALIZING: BACKEND=SRAM. Skipping flash test%s", "\n");
+#elif defined CFSTORE_CONFIG_BACKEND_LOG_ENABLED
+    CFSTORE_LOG("INITIALIZING: BACKEND=LOG. Skipping flash journal test%s", "\n");
 #endif
     return CaseNext;
 }
@@ -673,7 +675,7 @@ static control_t cfstore_flash_test_00(const size_t call_count)
 /* Specify all your test cases here */
 Case cases[] = {
         Case("flash_journal_async_test_00", cfstore_flash_test_00),
-#ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
+#if defined CFSTORE_CONFIG_BACKEND_FLASH_ENABLED && !defined CFSTORE_CONFIG_BACKEND_LOG_ENABLED
         Case("flash_journal_async_test_01", cfstore_flash_journal_async_test_01),
 #endif
 };
@@ -0,0 +1,326 @@
+/*
+ * mbed Microcontroller Library
+ * Copyright (c) 2006-2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file flush4.cpp Test cases to flush KVs in the CFSTORE using the record log backend.
+ *
+ * Please consult the documentation under the test-case functions for
+ * a description of the individual test case.
+ *
+ * The record log backend (configuration-store.incremental_flush) persists only
+ * the KVs created, written or deleted since the previous Flush(). These test
+ * cases check that the store read back after re-initialisation is the store
+ * that was flushed, for a mix of creates, writes and deletes and for a long
+ * run of flushes that each change a single KV.
+ */
+
+#include "mbed.h"
+#include "cfstore_config.h"
+#include "Driver_Common.h"
+#include "cfstore_debug.h"
+#include "cfstore_test.h"
+#include "configuration_store.h"
+#include "utest/utest.h"
+#include "unity/unity.h"
+#include "greentea-client/test_env.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace utest::v1;
+
+static char cfstore_flush4_utest_msg_g[CFSTORE_UTEST_MSG_BUF_SIZE];
+
+/// @cond CFSTORE_DOXYGEN_DISABLE
+#ifdef CFSTORE_DEBUG
+#define CFSTORE_FLUSH4_GREENTEA_TIMEOUT_S     1000
+#else
+#define CFSTORE_FLUSH4_GREENTEA_TIMEOUT_S     200
+#endif
+#define CFSTORE_FLUSH4_TEST_02_KV_COUNT       8
+#define CFSTORE_FLUSH4_TEST_02_FLUSH_COUNT    256
+/// @endcond
+
+#ifdef CFSTORE_CONFIG_BACKEND_LOG_ENABLED
+
+/* KV data for test_01 */
+static cfstore_kv_data_t cfstore_flush4_test_01_kv_data[] = {
+        { "com.arm.mbed.configurationstore.flush4.kv0", "value0"},
+        { "com.arm.mbed.configurationstore.flush4.kv1", "value1"},
+        { "com.arm.mbed.configurationstore.flush4.kv2", "value2"},
+        { "com.arm.mbed.configurationstore.flush4.kv3", "value3"},
+        { "com.arm.mbed.configurationstore.flush4.kv4", "value4"},
+        { "com.arm.mbed.configurationstore.flush4.kv5", "value5"},
+        { "com.arm.mbed.configurationstore.flush4.kv6", "value6"},
+        { "com.arm.mbed.configurationstore.flush4.kv7", "value7"},
+        { NULL, NULL},
+};
+
+/* KVs expected after the changes made in test_01 */
+static cfstore_kv_data_t cfstore_flush4_test_01_kv_data_changed[] = {
+        { "com.arm.mbed.configurationstore.flush4.kv0", "value0"},
+        { "com.arm.mbed.configurationstore.flush4.kv1", "VALUE1"},
+        { "com.arm.mbed.configurationstore.flush4.kv3", "value3"},
+        { "com.arm.mbed.configurationstore.flush4.kv4", "value4"},
+        { "com.arm.mbed.configurationstore.flush4.kv5", "a longer value5"},
+        { "com.arm.mbed.configurationstore.flush4.kv6", "value6"},
+        { "com.arm.mbed.configurationstore.flush4.kv7", "value7"},
+        { "com.arm.mbed.configurationstore.flush4.kv8", "value8"},
+        { NULL, NULL},
+};
+
+/* no KVs */
+static cfstore_kv_data_t cfstore_flush4_kv_data_empty[] = {
+        { NULL, NULL},
+};
+
+
+/* @brief   re-initialise cfstore so the KVs are read back from storage */
+static void cfstore_flush4_reinitialise(void)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+
+    ret = drv->Uninitialize();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to uninitialize CFSTORE (ret=%d)\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+
+    ret = drv->Initialize(NULL, NULL);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to initialize CFSTORE (ret=%d)\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+}
+
+
+/* @brief   check the store holds exactly the KVs in table */
+static void cfstore_flush4_check_table(const cfstore_kv_data_t* table)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    int32_t count = 0;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+    ARM_CFSTORE_HANDLE_INIT(next);
+    ARM_CFSTORE_HANDLE_INIT(prev);
+    const cfstore_kv_data_t* node = NULL;
+
+    for(node = table; node->key_name != NULL; node++){
+        ret = cfstore_test_check_node_correct(node);
+        CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: KV not correct after flush (key_name=\"%s\", ret=%d)\n", __func__, node->key_name, (int) ret);
+        TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+        count--;
+    }
+    while(drv->Find("com.arm.mbed.configurationstore.flush4.*", prev, next) == ARM_DRIVER_OK){
+        CFSTORE_HANDLE_SWAP(prev, next);
+        count++;
+    }
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: store holds %d more KVs than expected\n", __func__, (int) count);
+    TEST_ASSERT_MESSAGE(count == 0, cfstore_flush4_utest_msg_g);
+}
+
+
+/** @brief  test that creates, writes, grows and deletes are all persisted by
+ *          an incremental flush.
+ *
+ * @return on success returns CaseNext to continue to next test case, otherwise will assert on errors.
+ */
+control_t cfstore_flush4_test_01(const size_t call_count)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    ARM_CFSTORE_SIZE len = 0;
+    ARM_CFSTORE_KEYDESC kdesc;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+    ARM_CFSTORE_HANDLE_INIT(hkey);
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    (void) call_count;
+    memset(&kdesc, 0, sizeof(kdesc));
+    kdesc.drl = ARM_RETENTION_WHILE_DEVICE_ACTIVE;
+
+    ret = drv->Initialize(NULL, NULL);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to initialize CFSTORE (ret=%d)\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+
+    ret = cfstore_test_create_table(cfstore_flush4_test_01_kv_data);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to create KVs (ret=%d)\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+
+    ret = drv->Flush();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to flush CFSTORE (ret=%d)\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+    cfstore_flush4_reinitialise();
+    cfstore_flush4_check_table(cfstore_flush4_test_01_kv_data);
+
+    /* write kv1, delete kv2, grow kv5 and create kv8 */
+    len = strlen("VALUE1");
+    ret = cfstore_test_write("com.arm.mbed.configurationstore.flush4.kv1", "VALUE1", &len);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to write kv1 (ret=%d)\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+
+    ret = cfstore_test_delete("com.arm.mbed.configurationstore.flush4.kv2");
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to delete kv2 (ret=%d)\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+
+    len = strlen("a longer value5");
+    ret = drv->Create("com.arm.mbed.configurationstore.flush4.kv5", len, NULL, hkey);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to grow kv5 (ret=%d)\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+    ret = drv->Write(hkey, "a longer value5", &len);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to write kv5 (ret=%d)\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+    drv->Close(hkey);
+
+    len = strlen("value8");
+    ret = cfstore_test_create("com.arm.mbed.configurationstore.flush4.kv8", "value8", &len, &kdesc);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to create kv8 (ret=%d)\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+
+    ret = drv->Flush();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to flush CFSTORE (ret=%d)\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+    cfstore_flush4_reinitialise();
+    cfstore_flush4_check_table(cfstore_flush4_test_01_kv_data_changed);
+
+    /* a flush with no changes leaves the store as it was */
+    ret = drv->Flush();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to flush CFSTORE (ret=%d)\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+    cfstore_flush4_reinitialise();
+    cfstore_flush4_check_table(cfstore_flush4_test_01_kv_data_changed);
+
+    ret = drv->Uninitialize();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to uninitialize CFSTORE (ret=%d)\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+    return CaseNext;
+}
+
+
+/** @brief  test a long run of flushes each writing one KV, and that the
+ *          last value written is the one read back.
+ *
+ * @return on success returns CaseNext to continue to next test case, otherwise will assert on errors.
+ */
+control_t cfstore_flush4_test_02(const size_t call_count)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    int32_t i = 0;
+    ARM_CFSTORE_SIZE len = 0;
+    char key_name[CFSTORE_KEY_NAME_MAX_LENGTH+1];
+    char value[CFSTORE_KEY_NAME_MAX_LENGTH+1];
+    ARM_CFSTORE_KEYDESC kdesc;
+    ARM_CFSTORE_DRIVER* drv = &cfstore_driver;
+    cfstore_kv_data_t node;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    (void) call_count;
+    memset(&kdesc, 0, sizeof(kdesc));
+    kdesc.drl = ARM_RETENTION_WHILE_DEVICE_ACTIVE;
+
+    ret = drv->Initialize(NULL, NULL);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to initialize CFSTORE (ret=%d)\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+
+    /* the values written all have the same length so Write() replaces the whole value */
+    for(i = 0; i < CFSTORE_FLUSH4_TEST_02_KV_COUNT; i++){
+        snprintf(key_name, sizeof(key_name), "com.arm.mbed.configurationstore.flush4.log%d", (int) i);
+        snprintf(value, sizeof(value), "value%06d", 0);
+        len = strlen(value);
+        ret = cfstore_test_create(key_name, value, &len, &kdesc);
+        CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to create KV (i=%d, ret=%d)\n", __func__, (int) i, (int) ret);
+        TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+    }
+    for(i = 0; i < CFSTORE_FLUSH4_TEST_02_FLUSH_COUNT; i++){
+        snprintf(key_name, sizeof(key_name), "com.arm.mbed.configurationstore.flush4.log%d", (int) (i % CFSTORE_FLUSH4_TEST_02_KV_COUNT));
+        snprintf(value, sizeof(value), "value%06d", (int) i);
+        len = strlen(value);
+        ret = cfstore_test_write(key_name, value, &len);
+        CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to write KV (i=%d, ret=%d)\n", __func__, (int) i, (int) ret);
+        TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+
+        ret = drv->Flush();
+        CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to flush CFSTORE (i=%d, ret=%d)\n", __func__, (int) i, (int) ret);
+        TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+    }
+    cfstore_flush4_reinitialise();
+
+    /* the last value written to the last KV is persisted */
+    i = CFSTORE_FLUSH4_TEST_02_FLUSH_COUNT - 1;
+    snprintf(key_name, sizeof(key_name), "com.arm.mbed.configurationstore.flush4.log%d", (int) (i % CFSTORE_FLUSH4_TEST_02_KV_COUNT));
+    snprintf(value, sizeof(value), "value%06d", (int) i);
+    node.key_name = key_name;
+    node.value = value;
+    ret = cfstore_test_check_node_correct(&node);
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: last value written not read back (ret=%d)\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+
+    /* clean up */
+    ret = cfstore_test_delete_all();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to delete all KVs (ret=%d)\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+    ret = drv->Flush();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to flush CFSTORE (ret=%d)\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+    cfstore_flush4_reinitialise();
+    cfstore_flush4_check_table(cfstore_flush4_kv_data_empty);
+
+    ret = drv->Uninitialize();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to uninitialize CFSTORE (ret=%d)\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+    return CaseNext;
+}
+
+#endif /* CFSTORE_CONFIG_BACKEND_LOG_ENABLED */
+
+
+static control_t cfstore_flush4_test_00(const size_t call_count)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+
+    (void) call_count;
+#ifndef CFSTORE_CONFIG_BACKEND_LOG_ENABLED
+    CFSTORE_LOG("*** Skipping test as binary not built for the record log backend (configuration-store.incremental_flush)%s", "\n");
+    return CaseNext;
+#endif
+    ret = cfstore_test_startup();
+    CFSTORE_TEST_UTEST_MESSAGE(cfstore_flush4_utest_msg_g, CFSTORE_UTEST_MSG_BUF_SIZE, "%s:Error: failed to perform test startup (ret=%d).\n", __func__, (int) ret);
+    TEST_ASSERT_MESSAGE(ret >= ARM_DRIVER_OK, cfstore_flush4_utest_msg_g);
+    return CaseNext;
+}
+
+/// @cond CFSTORE_DOXYGEN_DISABLE
+utest::v1::status_t greentea_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(CFSTORE_FLUSH4_GREENTEA_TIMEOUT_S, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+           /*          1         2         3         4         5         6        7  */
+           /* 1234567890123456789012345678901234567890123456789012345678901234567890 */
+        Case("FLUSH4_test_00", cfstore_flush4_test_00),
+#ifdef CFSTORE_CONFIG_BACKEND_LOG_ENABLED
+        Case("FLUSH4_test_01", cfstore_flush4_test_01),
+        Case("FLUSH4_test_02", cfstore_flush4_test_02),
+#endif /* CFSTORE_CONFIG_BACKEND_LOG_ENABLED */
+};
+
+
+/* Declare your test specification with a custom setup handler */
+Specification specification(greentea_setup, cases);
+
+int main()
+{
+    return !Harness::run(specification);
+}
+/// @endcond
@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2006-2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef TARGET_LIKE_POSIX
+#define AVOID_GREENTEA
+#endif
+
+#ifndef AVOID_GREENTEA
+#include "greentea-client/test_env.h"
+#endif
+#include "utest/utest.h"
+#include "unity/unity.h"
+
+#include "flash-journal-strategy-log/flash_journal_log_crc.h"
+#include "flash-journal-strategy-log/flash_journal_strategy_log.h"
+#include "flash-journal-strategy-sequential/flash_journal_crc.h"
+#include <string.h>
+#include <inttypes.h>
+
+using namespace utest::v1;
+
+extern ARM_DRIVER_STORAGE ARM_Driver_Storage_MTD_K64F;
+ARM_DRIVER_STORAGE *drv = &ARM_Driver_Storage_MTD_K64F;
+
+FlashJournal_t      journal;
+
+static const size_t BUFFER_SIZE = 8192;
+static uint8_t      buffer[BUFFER_SIZE];
+static uint8_t      readBuffer[BUFFER_SIZE];
+
+void callbackHandler(int32_t status, FlashJournal_OpCode_t cmd_code)
+{
+    /* the log strategy completes all operations synchronously. */
+    TEST_FAIL_MESSAGE("unexpected callback");
+}
+
+static void fillPattern(uint8_t seed, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        buffer[i] = (uint8_t)(seed + i * 7 + (i >> 8));
+    }
+}
+
+static void initialize(void)
+{
+    int32_t rc = FlashJournal_initialize(&journal, drv, &FLASH_JOURNAL_STRATEGY_LOG, callbackHandler);
+    TEST_ASSERT_EQUAL(1, rc);
+}
+
+static void logAndCommit(uint8_t seed, size_t size, size_t chunk)
+{
+    fillPattern(seed, size);
+
+    size_t offset = 0;
+    while (offset < size) {
+        size_t xfer = ((size - offset) < chunk) ? (size - offset) : chunk;
+        int32_t rc = FlashJournal_log(&journal, buffer + offset, xfer);
+        TEST_ASSERT(rc > 0);
+        offset += rc;
+    }
+
+    TEST_ASSERT_EQUAL(1, FlashJournal_commit(&journal));
+}
+
+static void verify(uint8_t seed, size_t size, size_t chunk)
+{
+    FlashJournal_Info_t info;
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, FlashJournal_getInfo(&journal, &info));
+    TEST_ASSERT_EQUAL(size, info.sizeofJournaledBlob);
+
+    fillPattern(seed, size);
+
+    size_t offset = 0;
+    while (offset < size) {
+        int32_t rc = FlashJournal_read(&journal, readBuffer, chunk);
+        TEST_ASSERT(rc > 0);
+        TEST_ASSERT_EQUAL(0, memcmp(readBuffer, buffer + offset, rc));
+        offset += rc;
+    }
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_EMPTY, FlashJournal_read(&journal, readBuffer, chunk));
+}
+
+void test_format()
+{
+    ARM_STORAGE_INFO mtdInfo;
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, drv->GetInfo(&mtdInfo));
+    TEST_ASSERT(mtdInfo.total_storage > 0);
+
+    TEST_ASSERT_EQUAL(1, flashJournalStrategyLog_format(drv, callbackHandler));
+}
+
+void test_initialize()
+{
+    initialize();
+
+    FlashJournal_Info_t info;
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, FlashJournal_getInfo(&journal, &info));
+    TEST_ASSERT(info.capacity >= BUFFER_SIZE);
+    TEST_ASSERT_EQUAL(0, info.sizeofJournaledBlob);
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_EMPTY, FlashJournal_read(&journal, readBuffer, sizeof(readBuffer)));
+
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_BOUNDED_CAPACITY, FlashJournal_log(&journal, buffer, info.capacity + 1));
+    if (info.program_unit > 1) {
+        TEST_ASSERT_EQUAL(JOURNAL_STATUS_SMALL_LOG_REQUEST, FlashJournal_log(&journal, buffer, info.program_unit - 1));
+    }
+}
+
+void test_logSmallAndCommit()
+{
+    FlashJournal_Info_t info;
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, FlashJournal_getInfo(&journal, &info));
+
+    logAndCommit(0xAA, info.program_unit, info.program_unit);
+    verify(0xAA, info.program_unit, BUFFER_SIZE);
+
+    initialize();
+    verify(0xAA, info.program_unit, BUFFER_SIZE);
+}
+
+void test_logLargeInChunksAndCommit()
+{
+    logAndCommit(0x55, BUFFER_SIZE, 1000);
+    verify(0x55, BUFFER_SIZE, 255);
+
+    initialize();
+    verify(0x55, BUFFER_SIZE, 1021);
+}
+
+void test_readFrom()
+{
+    fillPattern(0x55, BUFFER_SIZE);
+
+    for (size_t offset = 0; offset < BUFFER_SIZE; offset += 1237) {
+        int32_t rc = FlashJournal_readFrom(&journal, offset, readBuffer, 511);
+        size_t expected = ((BUFFER_SIZE - offset) < 511) ? (BUFFER_SIZE - offset) : 511;
+        TEST_ASSERT_EQUAL(expected, rc);
+        TEST_ASSERT_EQUAL(0, memcmp(readBuffer, buffer + offset, rc));
+
+        /* a read() following readFrom() continues from where it left off */
+        if (offset + rc < BUFFER_SIZE) {
+            size_t next = offset + rc;
+            rc = FlashJournal_read(&journal, readBuffer, 100);
+            TEST_ASSERT(rc > 0);
+            TEST_ASSERT_EQUAL(0, memcmp(readBuffer, buffer + next, rc));
+        }
+    }
+}
+
+/* Commit enough blobs for the log to wrap around the storage several times.
+ * The most recent blob must survive every re-initialization. */
+void test_wrapAround()
+{
+    ARM_STORAGE_INFO mtdInfo;
+    TEST_ASSERT_EQUAL(ARM_DRIVER_OK, drv->GetInfo(&mtdInfo));
+    size_t commits = 3 * (mtdInfo.total_storage / BUFFER_SIZE);
+
+    for (size_t i = 0; i < commits; i++) {
+        size_t size = BUFFER_SIZE - (i % 5) * 1024;
+        logAndCommit((uint8_t)i, size, BUFFER_SIZE);
+        if ((i % 16) == 0) {
+            initialize();
+        }
+        verify((uint8_t)i, size, BUFFER_SIZE);
+    }
+}
+
+void test_logWithoutCommit()
+{
+    FlashJournal_Info_t info;
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, FlashJournal_getInfo(&journal, &info));
+    size_t committedSize = info.sizeofJournaledBlob;
+
+    memset(buffer, 0x11, BUFFER_SIZE);
+    TEST_ASSERT(FlashJournal_log(&journal, buffer, BUFFER_SIZE) > 0);
+
+    /* an uncommitted blob is dropped by re-initialization */
+    initialize();
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, FlashJournal_getInfo(&journal, &info));
+    TEST_ASSERT_EQUAL(committedSize, info.sizeofJournaledBlob);
+}
+
+void test_commitWithoutLogs()
+{
+    TEST_ASSERT_EQUAL(1, FlashJournal_commit(&journal));
+
+    initialize();
+    FlashJournal_Info_t info;
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_OK, FlashJournal_getInfo(&journal, &info));
+    TEST_ASSERT_EQUAL(0, info.sizeofJournaledBlob);
+}
+
+void test_reset()
+{
+    logAndCommit(0x22, BUFFER_SIZE, BUFFER_SIZE);
+    TEST_ASSERT_EQUAL(1, FlashJournal_reset(&journal));
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_EMPTY, FlashJournal_read(&journal, readBuffer, sizeof(readBuffer)));
+
+    initialize();
+    TEST_ASSERT_EQUAL(JOURNAL_STATUS_EMPTY, FlashJournal_read(&journal, readBuffer, sizeof(readBuffer)));
+}
+
+void test_crc32()
+{
+    const unsigned char checkMsg[] = "123456789";
+    TEST_ASSERT_EQUAL(0xCBF43926, flashJournalStrategyLog_crc32(0, checkMsg, 9));
+
+    /* agrees with the bytewise CRC of the sequential strategy for every length
+     * and alignment, and composes across split buffers */
+    fillPattern(0x5A, 64);
+    for (unsigned offset = 0; offset < 8; offset++) {
+        for (unsigned msgLen = 1; msgLen < 48; msgLen++) {
+            flashJournalCrcReset();
+            uint32_t expected = flashJournalCrcCummulative(buffer + offset, msgLen);
+            TEST_ASSERT_EQUAL(expected, flashJournalStrategyLog_crc32(0, buffer + offset, msgLen));
+
+            uint32_t crc = flashJournalStrategyLog_crc32(0, buffer + offset, msgLen / 3);
+            crc = flashJournalStrategyLog_crc32(crc, buffer + offset + msgLen / 3, msgLen - msgLen / 3);
+            TEST_ASSERT_EQUAL(expected, crc);
+        }
+    }
+}
+
+#ifndef AVOID_GREENTEA
+// Custom setup handler required for proper Greentea support
+utest::v1::status_t greentea_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(300, "default_auto");
+    // Call the default reporting function
+    return greentea_test_setup_handler(number_of_cases);
+}
+#else
+status_t default_setup(const size_t)
+{
+    return STATUS_CONTINUE;
+}
+#endif
+
+// Specify all your test cases here
+Case cases[] = {
+    Case("crc32",                                       test_crc32),
+    Case("format",                                      test_format),
+    Case("initialize",                                  test_initialize),
+    Case("log small item and commit",                   test_logSmallAndCommit),
+    Case("log large item in chunks and commit",         test_logLargeInChunksAndCommit),
+    Case("readFrom followed by sequential reads",       test_readFrom),
+    Case("log without commit",                          test_logWithoutCommit),
+    Case("wrap around the storage",                     test_wrapAround),
+    Case("commit without logs",                         test_commitWithoutLogs),
+    Case("reset",                                       test_reset),
+};
+
+// Declare your test specification with a custom setup handler
+#ifndef AVOID_GREENTEA
+Specification specification(greentea_setup, cases);
+#else
+Specification specification(default_setup, cases);
+#endif
+
+int main(int argc, char** argv)
+{
+    // Run the test specification
+    Harness::run(specification);
+}
@@ -152,15 +152,21 @@ typedef struct _ARM_CFSTORE_STATUS {
 #define CFSTORE_KEY_NAME_MAX_LENGTH     220         //!< The maximum length of the null terminated character
                                                     //!< string used as a key name string.
 #define CFSTORE_VALUE_SIZE_MAX          (1<<26)     //!< Max size of the KV value blob (currently 64MB)
+#if defined __SIZEOF_POINTER__ && __SIZEOF_POINTER__ == 8
+#define CFSTORE_HANDLE_BUFSIZE          40          //!< size of the buffer owned and supplied by client
+                                                    //!< to CFSTORE to hold internal data structures, referenced by the key handle.
+                                                    //!< The structures hold pointers so are larger on 64-bit hosts.
+#else
 #define CFSTORE_HANDLE_BUFSIZE          24          //!< size of the buffer owned and supplied by client
                                                     //!< to CFSTORE to hold internal data structures, referenced by the key handle.
+#endif
 
 /** @brief   Helper macro to declare handle and client owned buffer supplied
  *           to CFSTORE for storing opaque handle state
  */
 #define ARM_CFSTORE_HANDLE_INIT(__name)                                         \
     uint8_t (__name##_buf_cFsToRe)[CFSTORE_HANDLE_BUFSIZE];                     \
-    ARM_CFSTORE_HANDLE (__name) = (ARM_CFSTORE_HANDLE) (__name##_buf_cFsToRe);  \
+    ARM_CFSTORE_HANDLE __name = (ARM_CFSTORE_HANDLE) (__name##_buf_cFsToRe);    \
     memset((__name##_buf_cFsToRe), 0, CFSTORE_HANDLE_BUFSIZE)
 
 #if defined __MBED__ && defined TOOLCHAIN_GCC_ARM
@@ -56,6 +56,37 @@
 #define CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
 #endif
 
+/* CFSTORE_STORAGE_DRIVER
+ *   the storage driver instance that KVs are persisted to.
+ */
+#ifndef CFSTORE_STORAGE_DRIVER
+#if defined TARGET_HOST_SIM
+#define CFSTORE_STORAGE_DRIVER                      ARM_Driver_Storage_MTD_HOST_SIM
+#else
+#define CFSTORE_STORAGE_DRIVER                      ARM_Driver_Storage_MTD_K64F
+#endif
+#endif
+
+/* CFSTORE_KEY_INDEX_DISABLE
+ *   Disable the in-RAM key index used by Open(), Create() and Find(), so that
+ *   these walk the KV area instead. The index needs heap memory so is not
+ *   available when cfstore uses a client supplied sram slab.
+ */
+#if CFSTORE_KEY_INDEX_DISABLE==0 && !defined CFSTORE_YOTTA_CFG_CFSTORE_SRAM_ADDR
+#define CFSTORE_CONFIG_KEY_INDEX_ENABLED
+#endif
+
+/* CFSTORE_INCREMENTAL_FLUSH
+ *   Persist KVs to storage with an append-only record log (see cfstore_log.h)
+ *   rather than the flash journal, so that Flush() only writes the KVs
+ *   created, written or deleted since the previous flush. The storage format
+ *   differs from the flash journal format so KVs previously stored with the
+ *   flash journal are not loaded.
+ */
+#if defined CFSTORE_CONFIG_BACKEND_FLASH_ENABLED && CFSTORE_INCREMENTAL_FLUSH==1
+#define CFSTORE_CONFIG_BACKEND_LOG_ENABLED
+#endif
+
 #if defined STORAGE_CONFIG_HARDWARE_MTD_K64F_ASYNC_OPS
 #define CFSTORE_STORAGE_DRIVER_CONFIG_HARDWARE_MTD_ASYNC_OPS STORAGE_CONFIG_HARDWARE_MTD_K64F_ASYNC_OPS
 #endif
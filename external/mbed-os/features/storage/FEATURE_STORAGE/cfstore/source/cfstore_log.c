@@ -0,0 +1,677 @@
+/** @file cfstore_log.c
+ *
+ * mbed Microcontroller Library
+ * Copyright (c) 2006-2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Append-only record log used by cfstore to persist KVs incrementally.
+ * See cfstore_log.h for a description of the storage format.
+ */
+
+#include "cfstore_config.h"
+#include "cfstore_debug.h"
+#include "cfstore_log.h"
+#include "configuration_store.h"
+#include "flash_journal_crc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef CFSTORE_CONFIG_BACKEND_LOG_ENABLED
+
+/*
+ * Defines
+ *
+ * CFSTORE_LOG_MAGIC
+ *  region header magic number ("CFSL")
+ *
+ * CFSTORE_LOG_VERSION
+ *  version of the region format
+ *
+ * CFSTORE_LOG_RECORD_MAGIC
+ *  record header magic number
+ *
+ * CFSTORE_LOG_BUF_SIZE
+ *  minimum size of the staging buffer used to program and read records. The
+ *  buffer size is rounded up to a multiple of the program_unit.
+ *
+ * CFSTORE_LOG_CHECK_xxx
+ *  results of checking the record at an offset in a region
+ */
+#define CFSTORE_LOG_MAGIC                   0x4c534643
+#define CFSTORE_LOG_VERSION                 1
+#define CFSTORE_LOG_RECORD_MAGIC            0xcf5e
+#define CFSTORE_LOG_BUF_SIZE                64
+#define CFSTORE_LOG_CHECK_ERASED            0
+#define CFSTORE_LOG_CHECK_VALID             1
+#define CFSTORE_LOG_CHECK_INVALID           2
+
+
+/* @brief   region header, written at the start of a region once all the
+ *          records of a compaction have been written */
+typedef struct cfstore_log_region_header_t
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t generation;
+    uint32_t crc;
+} cfstore_log_region_header_t;
+
+
+/* @brief   completion state for asynchronous storage operations. The storage
+ *          callback has no context argument hence these are globals. */
+static volatile bool cfstore_log_done_g = false;
+static volatile int32_t cfstore_log_status_g = ARM_DRIVER_OK;
+
+static void cfstore_log_storage_callback(int32_t status, ARM_STORAGE_OPERATION operation)
+{
+    CFSTORE_FENTRYLOG("%s:entered: status=%d, operation=%d\n", __func__, (int) status, (int) operation);
+    (void) operation;
+    cfstore_log_status_g = status;
+    cfstore_log_done_g = true;
+}
+
+/* @brief   get the result of a storage operation, waiting for the completion
+ *          callback if the driver has started the operation asynchronously.
+ *
+ * @param   ret
+ *          value returned by the storage driver when starting the operation.
+ *          ARM_DRIVER_OK indicates the operation completes asynchronously.
+ */
+static int32_t cfstore_log_wait(int32_t ret)
+{
+    if(ret == ARM_DRIVER_OK){
+        while(!cfstore_log_done_g){
+            /* wait for cfstore_log_storage_callback() */
+        }
+        ret = cfstore_log_status_g;
+    }
+    return ret;
+}
+
+static int32_t cfstore_log_read(cfstore_log_t* log, uint64_t addr, void* data, uint32_t size)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+
+    cfstore_log_done_g = false;
+    ret = cfstore_log_wait(log->mtd->ReadData(addr, data, size));
+    if(ret != (int32_t) size){
+        CFSTORE_ERRLOG("%s:Error: ReadData() failed (addr=0x%lx, size=%d, ret=%d)\n", __func__, (unsigned long) addr, (int) size, (int) ret);
+        return ARM_CFSTORE_DRIVER_ERROR_JOURNAL_STATUS_STORAGE_IO_ERROR;
+    }
+    return ARM_DRIVER_OK;
+}
+
+static int32_t cfstore_log_program(cfstore_log_t* log, uint64_t addr, const void* data, uint32_t size)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+
+    cfstore_log_done_g = false;
+    ret = cfstore_log_wait(log->mtd->ProgramData(addr, data, size));
+    if(ret != (int32_t) size){
+        CFSTORE_ERRLOG("%s:Error: ProgramData() failed (addr=0x%lx, size=%d, ret=%d)\n", __func__, (unsigned long) addr, (int) size, (int) ret);
+        return ARM_CFSTORE_DRIVER_ERROR_JOURNAL_STATUS_STORAGE_IO_ERROR;
+    }
+    return ARM_DRIVER_OK;
+}
+
+static int32_t cfstore_log_erase(cfstore_log_t* log, uint64_t addr, uint32_t size)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+
+    cfstore_log_done_g = false;
+    ret = cfstore_log_wait(log->mtd->Erase(addr, size));
+    if(ret != (int32_t) size){
+        CFSTORE_ERRLOG("%s:Error: Erase() failed (addr=0x%lx, size=%d, ret=%d)\n", __func__, (unsigned long) addr, (int) size, (int) ret);
+        return ARM_CFSTORE_DRIVER_ERROR_JOURNAL_STATUS_STORAGE_IO_ERROR;
+    }
+    return ARM_DRIVER_OK;
+}
+
+static inline uint64_t cfstore_log_region_addr(cfstore_log_t* log, uint8_t region)
+{
+    return log->addr + (uint64_t) region * log->region_size;
+}
+
+/* @brief   round len up to a multiple of the program_unit */
+static inline uint32_t cfstore_log_round(cfstore_log_t* log, uint32_t len)
+{
+    return (len + log->program_unit - 1) / log->program_unit * log->program_unit;
+}
+
+static bool cfstore_log_is_erased(cfstore_log_t* log, const uint8_t* data, uint32_t len)
+{
+    while(len--){
+        if(*data++ != log->erased_value){
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/*
+ * Programming is done through the staging buffer so that the data of a record
+ * is programmed in multiples of the program_unit, whatever the length of the
+ * pieces it is made from.
+ */
+
+static void cfstore_log_stream_start(cfstore_log_t* log, uint64_t addr)
+{
+    log->buf_addr = addr;
+    log->buf_fill = 0;
+}
+
+static int32_t cfstore_log_stream_put(cfstore_log_t* log, const void* data, uint32_t len)
+{
+    int32_t ret = ARM_DRIVER_OK;
+    uint32_t n = 0;
+    const uint8_t* ptr = (const uint8_t*) data;
+
+    while(len > 0){
+        n = log->buf_size - log->buf_fill;
+        n = n < len ? n : len;
+        memcpy(log->buf + log->buf_fill, ptr, n);
+        log->buf_fill += n;
+        ptr += n;
+        len -= n;
+        if(log->buf_fill == log->buf_size){
+            ret = cfstore_log_program(log, log->buf_addr, log->buf, log->buf_size);
+            if(ret < ARM_DRIVER_OK){
+                return ret;
+            }
+            log->buf_addr += log->buf_size;
+            log->buf_fill = 0;
+        }
+    }
+    return ret;
+}
+
+/* @brief   program what remains in the staging buffer, padded to the program_unit */
+static int32_t cfstore_log_stream_end(cfstore_log_t* log)
+{
+    uint32_t len = 0;
+
+    if(log->buf_fill == 0){
+        return ARM_DRIVER_OK;
+    }
+    len = cfstore_log_round(log, log->buf_fill);
+    memset(log->buf + log->buf_fill, log->erased_value, len - log->buf_fill);
+    log->buf_fill = 0;
+    return cfstore_log_program(log, log->buf_addr, log->buf, len);
+}
+
+
+/*
+ * Record and region header support functions
+ */
+
+/* @brief   compute the CRC32 of a record from its header and payload pieces */
+static uint32_t cfstore_log_record_crc(const cfstore_log_record_t* rec, const void* hdr, uint32_t hdr_len, const void* data, uint32_t data_len)
+{
+    uint32_t crc = 0;
+    cfstore_log_record_t tmp;
+
+    tmp = *rec;
+    tmp.crc = 0;
+    flashJournalCrcReset();
+    crc = flashJournalCrcCummulative((const unsigned char*) &tmp, sizeof(tmp));
+    if(hdr_len > 0){
+        crc = flashJournalCrcCummulative((const unsigned char*) hdr, hdr_len);
+    }
+    if(data_len > 0){
+        crc = flashJournalCrcCummulative((const unsigned char*) data, data_len);
+    }
+    flashJournalCrcReset();
+    return crc;
+}
+
+static uint32_t cfstore_log_region_header_crc(const cfstore_log_region_header_t* head)
+{
+    uint32_t crc = 0;
+    cfstore_log_region_header_t tmp;
+
+    tmp = *head;
+    tmp.crc = 0;
+    flashJournalCrcReset();
+    crc = flashJournalCrcCummulative((const unsigned char*) &tmp, sizeof(tmp));
+    flashJournalCrcReset();
+    return crc;
+}
+
+/* @brief   read the region header of a region
+ *
+ * @return  1 if the header is valid, 0 if it is not, < 0 on storage error
+ */
+static int32_t cfstore_log_read_region_header(cfstore_log_t* log, uint8_t region, uint32_t* generation)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    cfstore_log_region_header_t head;
+
+    ret = cfstore_log_read(log, cfstore_log_region_addr(log, region), &head, sizeof(head));
+    if(ret < ARM_DRIVER_OK){
+        return ret;
+    }
+    if(head.magic != CFSTORE_LOG_MAGIC || head.version != CFSTORE_LOG_VERSION || head.crc != cfstore_log_region_header_crc(&head)){
+        CFSTORE_TP(CFSTORE_TP_INIT, "%s:region %d has no valid header\n", __func__, (int) region);
+        return 0;
+    }
+    *generation = head.generation;
+    return 1;
+}
+
+/* @brief   check the record at offset off of the region
+ *
+ * @param   seq
+ *          the expected sequence number of the record
+ * @param   rec
+ *          on return holds the record header
+ *
+ * @return  CFSTORE_LOG_CHECK_VALID if the record is complete and its CRC
+ *          matches, CFSTORE_LOG_CHECK_ERASED if the record header is erased
+ *          (end of log), CFSTORE_LOG_CHECK_INVALID otherwise, < 0 on storage
+ *          error.
+ */
+static int32_t cfstore_log_check_record(cfstore_log_t* log, uint8_t region, uint32_t off, uint32_t seq, cfstore_log_record_t* rec)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    uint32_t crc = 0;
+    uint32_t pos = 0;
+    uint32_t n = 0;
+    uint64_t addr = cfstore_log_region_addr(log, region) + off;
+    cfstore_log_record_t tmp;
+
+    ret = cfstore_log_read(log, addr, rec, sizeof(cfstore_log_record_t));
+    if(ret < ARM_DRIVER_OK){
+        return ret;
+    }
+    if(cfstore_log_is_erased(log, (const uint8_t*) rec, sizeof(cfstore_log_record_t))){
+        return CFSTORE_LOG_CHECK_ERASED;
+    }
+    if(rec->magic != CFSTORE_LOG_RECORD_MAGIC || rec->seq != seq
+       || rec->type < CFSTORE_LOG_RECORD_PUT || rec->type > CFSTORE_LOG_RECORD_COMMIT
+       || (rec->type == CFSTORE_LOG_RECORD_COMMIT && rec->length != 0)
+       || rec->length > log->region_size - off - sizeof(cfstore_log_record_t)
+       || cfstore_log_record_size(log, rec->length) > log->region_size - off){
+        CFSTORE_TP(CFSTORE_TP_INIT, "%s:invalid record header at offset %d\n", __func__, (int) off);
+        return CFSTORE_LOG_CHECK_INVALID;
+    }
+    tmp = *rec;
+    tmp.crc = 0;
+    flashJournalCrcReset();
+    crc = flashJournalCrcCummulative((const unsigned char*) &tmp, sizeof(tmp));
+    addr += sizeof(cfstore_log_record_t);
+    for(pos = 0; pos < rec->length; pos += n){
+        n = rec->length - pos < log->buf_size ? rec->length - pos : log->buf_size;
+        ret = cfstore_log_read(log, addr + pos, log->buf, n);
+        if(ret < ARM_DRIVER_OK){
+            flashJournalCrcReset();
+            return ret;
+        }
+        crc = flashJournalCrcCummulative(log->buf, n);
+    }
+    flashJournalCrcReset();
+    if(crc != rec->crc){
+        CFSTORE_TP(CFSTORE_TP_INIT, "%s:record CRC mismatch at offset %d\n", __func__, (int) off);
+        return CFSTORE_LOG_CHECK_INVALID;
+    }
+    return CFSTORE_LOG_CHECK_VALID;
+}
+
+/* @brief   scan the active region to find the end of the log and the last
+ *          commit. Sets need_compact if the space after the log cannot be
+ *          programmed (e.g. it holds the remains of a record programmed when
+ *          power was lost) or the log ends with records that were never
+ *          committed, which must not be committed by a later COMMIT record. */
+static int32_t cfstore_log_scan(cfstore_log_t* log)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    uint32_t off = log->header_size;
+    uint32_t seq = 0;
+    uint32_t n = 0;
+    uint32_t pos = 0;
+    cfstore_log_record_t rec;
+
+    log->committed = off;
+    while(off + sizeof(cfstore_log_record_t) <= log->region_size){
+        ret = cfstore_log_check_record(log, log->active, off, seq, &rec);
+        if(ret < ARM_DRIVER_OK){
+            return ret;
+        }
+        if(ret != CFSTORE_LOG_CHECK_VALID){
+            break;
+        }
+        off += cfstore_log_record_size(log, rec.length);
+        seq++;
+        if(rec.type == CFSTORE_LOG_RECORD_COMMIT){
+            log->committed = off;
+        }
+    }
+    log->region = log->active;
+    log->tail = off;
+    log->seq = seq;
+    if(ret == CFSTORE_LOG_CHECK_INVALID || log->committed != off){
+        CFSTORE_TP(CFSTORE_TP_INIT, "%s:log has an incomplete flush (tail=%d, committed=%d)\n", __func__, (int) off, (int) log->committed);
+        log->need_compact = true;
+        return ARM_DRIVER_OK;
+    }
+    /* check the rest of the region is erased */
+    for(pos = off; pos < log->region_size; pos += n){
+        n = log->region_size - pos < log->buf_size ? log->region_size - pos : log->buf_size;
+        ret = cfstore_log_read(log, cfstore_log_region_addr(log, log->active) + pos, log->buf, n);
+        if(ret < ARM_DRIVER_OK){
+            return ret;
+        }
+        if(!cfstore_log_is_erased(log, log->buf, n)){
+            CFSTORE_TP(CFSTORE_TP_INIT, "%s:region not erased after the log (offset=%d)\n", __func__, (int) pos);
+            log->need_compact = true;
+            break;
+        }
+    }
+    return ARM_DRIVER_OK;
+}
+
+
+/*
+ * Log API
+ */
+
+/* @brief   initialise the log on the storage, finding the active region and
+ *          the end of the log. The storage need not hold a log, in which case
+ *          the log is empty and the first flush compacts it. */
+int32_t cfstore_log_init(cfstore_log_t* log, ARM_DRIVER_STORAGE* mtd)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    int32_t valid[2] = { 0, 0 };
+    uint32_t generation[2] = { 0, 0 };
+    uint32_t erase_unit = 1;
+    uint8_t region = 0;
+    ARM_STORAGE_INFO info;
+    ARM_STORAGE_BLOCK block;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    memset(log, 0, sizeof(cfstore_log_t));
+    log->mtd = mtd;
+    log->active = CFSTORE_LOG_REGION_NONE;
+    log->region = CFSTORE_LOG_REGION_NONE;
+
+    cfstore_log_done_g = false;
+    ret = mtd->Initialize(cfstore_log_storage_callback);
+    ret = cfstore_log_wait(ret);
+    if(ret < ARM_DRIVER_OK){
+        CFSTORE_ERRLOG("%s:Error: failed to initialise storage (ret=%d)\n", __func__, (int) ret);
+        return ARM_CFSTORE_DRIVER_ERROR_JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+    if(mtd->GetInfo(&info) < ARM_DRIVER_OK || mtd->GetNextBlock(NULL, &block) < ARM_DRIVER_OK || !ARM_STORAGE_VALID_BLOCK(&block)){
+        CFSTORE_ERRLOG("%s:Error: failed to get storage info\n", __func__);
+        return ARM_CFSTORE_DRIVER_ERROR_JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+    if(block.attributes.erase_unit > 1){
+        erase_unit = block.attributes.erase_unit;
+    }
+    log->addr = block.addr;
+    log->program_unit = info.program_unit > 1 ? info.program_unit : 1;
+    log->erased_value = info.erased_value ? 0xff : 0x00;
+    log->region_size = (uint32_t) (info.total_storage / 2);
+    log->region_size -= log->region_size % erase_unit;
+    log->header_size = cfstore_log_round(log, sizeof(cfstore_log_region_header_t));
+    log->buf_size = cfstore_log_round(log, CFSTORE_LOG_BUF_SIZE);
+    if(log->region_size < log->header_size + 2 * cfstore_log_record_size(log, 0)){
+        CFSTORE_ERRLOG("%s:Error: storage too small for log (total_storage=%d)\n", __func__, (int) info.total_storage);
+        return ARM_CFSTORE_DRIVER_ERROR_JOURNAL_STATUS_PARAMETER;
+    }
+    log->buf = (uint8_t*) malloc(log->buf_size);
+    if(log->buf == NULL){
+        CFSTORE_ERRLOG("%s:Error: unable to allocate staging buffer\n", __func__);
+        return ARM_CFSTORE_DRIVER_ERROR_OUT_OF_MEMORY;
+    }
+    for(region = 0; region < 2; region++){
+        valid[region] = cfstore_log_read_region_header(log, region, &generation[region]);
+        if(valid[region] < ARM_DRIVER_OK){
+            ret = valid[region];
+            goto out0;
+        }
+    }
+    if(valid[0] && valid[1]){
+        /* the region with the later generation is the result of the last compaction */
+        log->active = (int32_t) (generation[1] - generation[0]) > 0 ? 1 : 0;
+    } else if(valid[0] || valid[1]){
+        log->active = valid[0] ? 0 : 1;
+    } else {
+        CFSTORE_TP(CFSTORE_TP_INIT, "%s:no log found in storage\n", __func__);
+        log->need_compact = true;
+        return ARM_DRIVER_OK;
+    }
+    log->generation = generation[log->active];
+    ret = cfstore_log_scan(log);
+    if(ret < ARM_DRIVER_OK){
+        goto out0;
+    }
+    CFSTORE_TP(CFSTORE_TP_INIT, "%s:active=%d, generation=%d, tail=%d, need_compact=%d\n", __func__, (int) log->active, (int) log->generation, (int) log->tail, (int) log->need_compact);
+    return ARM_DRIVER_OK;
+out0:
+    cfstore_log_deinit(log);
+    return ret;
+}
+
+void cfstore_log_deinit(cfstore_log_t* log)
+{
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    free(log->buf);
+    memset(log, 0, sizeof(cfstore_log_t));
+    log->active = CFSTORE_LOG_REGION_NONE;
+    log->region = CFSTORE_LOG_REGION_NONE;
+}
+
+/* @brief   invoke apply() for each committed PUT and DELETE record, oldest first */
+int32_t cfstore_log_replay(cfstore_log_t* log, cfstore_log_apply_t apply, void* context)
+{
+    int32_t ret = ARM_DRIVER_OK;
+    uint32_t off = log->header_size;
+    uint32_t data_size = 0;
+    uint8_t* data = NULL;
+    uint8_t* ptr = NULL;
+    uint64_t addr = 0;
+    cfstore_log_record_t rec;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    if(log->active == CFSTORE_LOG_REGION_NONE){
+        return ARM_DRIVER_OK;
+    }
+    addr = cfstore_log_region_addr(log, log->active);
+    while(off < log->committed){
+        ret = cfstore_log_read(log, addr + off, &rec, sizeof(rec));
+        if(ret < ARM_DRIVER_OK){
+            goto out0;
+        }
+        if(rec.type != CFSTORE_LOG_RECORD_COMMIT){
+            if(rec.length > data_size){
+                ptr = (uint8_t*) realloc(data, rec.length);
+                if(ptr == NULL){
+                    CFSTORE_ERRLOG("%s:Error: unable to allocate record buffer (size=%d)\n", __func__, (int) rec.length);
+                    ret = ARM_CFSTORE_DRIVER_ERROR_OUT_OF_MEMORY;
+                    goto out0;
+                }
+                data = ptr;
+                data_size = rec.length;
+            }
+            ret = cfstore_log_read(log, addr + off + sizeof(rec), data, rec.length);
+            if(ret < ARM_DRIVER_OK){
+                goto out0;
+            }
+            ret = apply(context, rec.type, data, rec.length);
+            if(ret < ARM_DRIVER_OK){
+                goto out0;
+            }
+        }
+        off += cfstore_log_record_size(log, rec.length);
+    }
+    ret = ARM_DRIVER_OK;
+out0:
+    free(data);
+    return ret;
+}
+
+/* @brief   get the number of bytes a record with a len byte payload uses in storage */
+uint32_t cfstore_log_record_size(cfstore_log_t* log, uint32_t len)
+{
+    return cfstore_log_round(log, sizeof(cfstore_log_record_t) + len);
+}
+
+/* @brief   get the number of bytes that can be appended to the active region
+ *          and still leave space for a COMMIT record. Returns 0 if the log must
+ *          be compacted before records can be appended. */
+uint32_t cfstore_log_space(cfstore_log_t* log)
+{
+    uint32_t used = 0;
+
+    if(log->active == CFSTORE_LOG_REGION_NONE || log->need_compact || log->region != log->active){
+        return 0;
+    }
+    used = log->tail + cfstore_log_record_size(log, 0);
+    return used < log->region_size ? log->region_size - used : 0;
+}
+
+/* @brief   get the number of bytes of records a compaction can write, leaving
+ *          space for the COMMIT record */
+uint32_t cfstore_log_capacity(cfstore_log_t* log)
+{
+    return log->region_size - log->header_size - cfstore_log_record_size(log, 0);
+}
+
+/* @brief   append a record to the region being written. The payload is the
+ *          concatenation of hdr and data, either of which may be empty. */
+int32_t cfstore_log_append(cfstore_log_t* log, uint8_t type, const void* hdr, uint32_t hdr_len, const void* data, uint32_t data_len)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    uint32_t size = cfstore_log_record_size(log, hdr_len + data_len);
+    cfstore_log_record_t rec;
+
+    CFSTORE_FENTRYLOG("%s:entered: type=%d, len=%d\n", __func__, (int) type, (int) (hdr_len + data_len));
+    if(log->region == CFSTORE_LOG_REGION_NONE || (log->need_compact && log->region == log->active)){
+        CFSTORE_ERRLOG("%s:Error: log must be compacted before appending records\n", __func__);
+        return ARM_CFSTORE_DRIVER_ERROR_INTERNAL;
+    }
+    if(size > log->region_size - log->tail){
+        CFSTORE_ERRLOG("%s:Error: no space for record (tail=%d, size=%d)\n", __func__, (int) log->tail, (int) size);
+        return ARM_CFSTORE_DRIVER_ERROR_JOURNAL_STATUS_BOUNDED_CAPACITY;
+    }
+    memset(&rec, 0, sizeof(rec));
+    rec.magic = CFSTORE_LOG_RECORD_MAGIC;
+    rec.type = type;
+    rec.length = hdr_len + data_len;
+    rec.seq = log->seq;
+    rec.crc = cfstore_log_record_crc(&rec, hdr, hdr_len, data, data_len);
+
+    /* the record header is programmed first so a record cut short by power
+     * loss is always detected by its CRC */
+    cfstore_log_stream_start(log, cfstore_log_region_addr(log, log->region) + log->tail);
+    ret = cfstore_log_stream_put(log, &rec, sizeof(rec));
+    if(ret < ARM_DRIVER_OK){
+        goto out0;
+    }
+    ret = cfstore_log_stream_put(log, hdr, hdr_len);
+    if(ret < ARM_DRIVER_OK){
+        goto out0;
+    }
+    ret = cfstore_log_stream_put(log, data, data_len);
+    if(ret < ARM_DRIVER_OK){
+        goto out0;
+    }
+    ret = cfstore_log_stream_end(log);
+    if(ret < ARM_DRIVER_OK){
+        goto out0;
+    }
+    log->tail += size;
+    log->seq++;
+    return ARM_DRIVER_OK;
+out0:
+    /* the region now holds a partial record so nothing more can be appended */
+    log->need_compact = true;
+    return ret;
+}
+
+/* @brief   append a COMMIT record to the active region, committing the
+ *          records appended since the last COMMIT record */
+int32_t cfstore_log_commit(cfstore_log_t* log)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    ret = cfstore_log_append(log, CFSTORE_LOG_RECORD_COMMIT, NULL, 0, NULL, 0);
+    if(ret < ARM_DRIVER_OK){
+        return ret;
+    }
+    log->committed = log->tail;
+    return ARM_DRIVER_OK;
+}
+
+/* @brief   start a compaction by erasing the inactive region. The records
+ *          appended until cfstore_log_compact_end() is called are written to
+ *          the inactive region and must hold the whole store. */
+int32_t cfstore_log_compact_begin(cfstore_log_t* log)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    uint8_t region = log->active == CFSTORE_LOG_REGION_NONE ? 0 : log->active ^ 1;
+
+    CFSTORE_FENTRYLOG("%s:entered: region=%d\n", __func__, (int) region);
+    /* until compaction ends the active region cannot be appended to */
+    log->need_compact = true;
+    log->region = CFSTORE_LOG_REGION_NONE;
+    ret = cfstore_log_erase(log, cfstore_log_region_addr(log, region), log->region_size);
+    if(ret < ARM_DRIVER_OK){
+        return ret;
+    }
+    log->region = region;
+    log->tail = log->header_size;
+    log->seq = 0;
+    return ARM_DRIVER_OK;
+}
+
+/* @brief   complete a compaction by committing the records and writing the
+ *          region header, which makes the new region the active one */
+int32_t cfstore_log_compact_end(cfstore_log_t* log)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    cfstore_log_region_header_t head;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    ret = cfstore_log_append(log, CFSTORE_LOG_RECORD_COMMIT, NULL, 0, NULL, 0);
+    if(ret < ARM_DRIVER_OK){
+        return ret;
+    }
+    memset(&head, 0, sizeof(head));
+    head.magic = CFSTORE_LOG_MAGIC;
+    head.version = CFSTORE_LOG_VERSION;
+    head.generation = log->generation + 1;
+    head.crc = cfstore_log_region_header_crc(&head);
+    cfstore_log_stream_start(log, cfstore_log_region_addr(log, log->region));
+    ret = cfstore_log_stream_put(log, &head, sizeof(head));
+    if(ret < ARM_DRIVER_OK){
+        return ret;
+    }
+    ret = cfstore_log_stream_end(log);
+    if(ret < ARM_DRIVER_OK){
+        return ret;
+    }
+    log->active = log->region;
+    log->generation = head.generation;
+    log->committed = log->tail;
+    log->need_compact = false;
+    CFSTORE_TP(CFSTORE_TP_FLUSH, "%s:compacted log: active=%d, generation=%d, tail=%d\n", __func__, (int) log->active, (int) log->generation, (int) log->tail);
+    return ARM_DRIVER_OK;
+}
+
+#endif /* CFSTORE_CONFIG_BACKEND_LOG_ENABLED */
@@ -0,0 +1,149 @@
+/** @file cfstore_log.h
+ *
+ * mbed Microcontroller Library
+ * Copyright (c) 2006-2016 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Append-only record log used by cfstore to persist KVs incrementally.
+ */
+#ifndef __CFSTORE_LOG_H
+#define __CFSTORE_LOG_H
+
+#include <Driver_Storage.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The storage is split into 2 regions of equal size. One region is active and
+ * holds the log: a region header followed by records, each starting on a
+ * program_unit boundary:
+ *
+ *   | region header | rec 0 | rec 1 | ... | COMMIT | rec n | ... | COMMIT | erased |
+ *
+ * A record is a cfstore_log_record_t followed by its payload. The CRC32 of a
+ * record covers its header (with the crc field 0) and its payload, so a record
+ * which was being programmed when power was lost is detected. Only records up
+ * to the last COMMIT record are replayed, so the records of a flush are
+ * applied all together or not at all.
+ *
+ * When the active region is full the log is compacted: the other region is
+ * erased, a snapshot of the store is written into it, followed by a COMMIT
+ * record and last of all the region header with the next generation number.
+ * Until the region header is written the old region remains the active one.
+ * When both regions have a valid header the one with the higher generation is
+ * used.
+ *
+ * The log uses the storage driver synchronously. If the driver completes an
+ * operation asynchronously the log waits for the completion callback.
+ */
+
+/* record types */
+#define CFSTORE_LOG_RECORD_PUT          0x01    /* payload is a KV */
+#define CFSTORE_LOG_RECORD_DELETE       0x02    /* payload is a key name */
+#define CFSTORE_LOG_RECORD_COMMIT       0x03    /* no payload */
+
+#define CFSTORE_LOG_REGION_NONE         0xff
+
+/* @brief   record header */
+typedef struct cfstore_log_record_t
+{
+    uint16_t magic;
+    uint8_t type;
+    uint8_t reserved;
+    uint32_t length;
+    uint32_t seq;
+    uint32_t crc;
+} cfstore_log_record_t;
+
+/* @brief   log instance
+ *
+ * @param   mtd
+ *          storage driver, used synchronously.
+ * @param   addr
+ *          storage address of region 0. Region 1 follows it.
+ * @param   region_size
+ *          size of each region, a multiple of the erase unit.
+ * @param   program_unit
+ *          storage program unit. Records are padded to a multiple of it.
+ * @param   erased_value
+ *          value of erased bytes, 0x00 or 0xff.
+ * @param   header_size
+ *          size of the region header padded to a multiple of program_unit.
+ * @param   active
+ *          index of the region holding the log, or CFSTORE_LOG_REGION_NONE
+ *          when the storage holds no valid log.
+ * @param   generation
+ *          generation number of the active region.
+ * @param   region
+ *          index of the region being written. It is the active region when
+ *          appending records and the other region while compacting.
+ * @param   tail
+ *          offset in region at which the next record is written.
+ * @param   committed
+ *          offset in the active region after the last COMMIT record.
+ * @param   seq
+ *          sequence number of the next record. The records in a region are
+ *          numbered from 0.
+ * @param   need_compact
+ *          set when records can no longer be appended to the active region,
+ *          e.g. because the region holds a record which was not completely
+ *          programmed. The next flush must compact the log.
+ * @param   buf
+ *          staging buffer of buf_size bytes used to program and read records.
+ */
+typedef struct cfstore_log_t
+{
+    ARM_DRIVER_STORAGE* mtd;
+    uint64_t addr;
+    uint32_t region_size;
+    uint32_t program_unit;
+    uint8_t erased_value;
+    uint32_t header_size;
+    uint8_t active;
+    uint32_t generation;
+    uint8_t region;
+    uint32_t tail;
+    uint32_t committed;
+    uint32_t seq;
+    bool need_compact;
+    uint8_t* buf;
+    uint32_t buf_size;
+    uint32_t buf_fill;
+    uint64_t buf_addr;
+} cfstore_log_t;
+
+/* @brief   callback invoked by cfstore_log_replay() for each committed
+ *          PUT or DELETE record. Returns < 0 to stop the replay. */
+typedef int32_t (*cfstore_log_apply_t)(void* context, uint8_t type, const uint8_t* data, uint32_t len);
+
+int32_t cfstore_log_init(cfstore_log_t* log, ARM_DRIVER_STORAGE* mtd);
+void cfstore_log_deinit(cfstore_log_t* log);
+int32_t cfstore_log_replay(cfstore_log_t* log, cfstore_log_apply_t apply, void* context);
+uint32_t cfstore_log_record_size(cfstore_log_t* log, uint32_t len);
+uint32_t cfstore_log_space(cfstore_log_t* log);
+uint32_t cfstore_log_capacity(cfstore_log_t* log);
+int32_t cfstore_log_append(cfstore_log_t* log, uint8_t type, const void* hdr, uint32_t hdr_len, const void* data, uint32_t data_len);
+int32_t cfstore_log_commit(cfstore_log_t* log);
+int32_t cfstore_log_compact_begin(cfstore_log_t* log);
+int32_t cfstore_log_compact_end(cfstore_log_t* log);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CFSTORE_LOG_H */
@@ -38,8 +38,8 @@
 #endif
 
 #ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
-extern ARM_DRIVER_STORAGE ARM_Driver_Storage_MTD_K64F;
-static ARM_DRIVER_STORAGE *cfstore_svm_storage_drv = &ARM_Driver_Storage_MTD_K64F;
+extern ARM_DRIVER_STORAGE CFSTORE_STORAGE_DRIVER;
+static ARM_DRIVER_STORAGE *cfstore_svm_storage_drv = &CFSTORE_STORAGE_DRIVER;
 
 /* the storage volume manager instance used to generate virtual mtd descriptors */
 StorageVolumeManager volumeManager;
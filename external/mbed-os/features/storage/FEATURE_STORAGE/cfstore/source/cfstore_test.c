@@ -248,17 +248,30 @@ int32_t cfstore_test_startup(void)
         CFSTORE_ERRLOG("%s:Error: failed to dump CFSTORE (ret=%d)\n", __func__, (int) ret);
         return ARM_DRIVER_ERROR;
     }
+#ifdef CFSTORE_CONFIG_BACKEND_LOG_ENABLED
+    /* the record log is not a flash journal so empty the store through the API */
+    ret = cfstore_test_delete_all();
+    if(ret < ARM_DRIVER_OK){
+        CFSTORE_ERRLOG("%s:Error: failed to delete all KVs (ret=%d)\n", __func__, (int) ret);
+        return ARM_DRIVER_ERROR;
+    }
+    ret = cfstore_drv->Flush();
+    if(ret < ARM_DRIVER_OK){
+        CFSTORE_ERRLOG("%s:Error: failed to flush CFSTORE (ret=%d)\n", __func__, (int) ret);
+        return ARM_DRIVER_ERROR;
+    }
+#endif /* CFSTORE_CONFIG_BACKEND_LOG_ENABLED */
     ret = cfstore_drv->Uninitialize();
     if(ret < ARM_DRIVER_OK){
         CFSTORE_ERRLOG("%s:Error: failed to uninitialize CFSTORE (ret=%d)\n", __func__, (int) ret);
         return ARM_DRIVER_ERROR;
     }
 
-#ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
+#if defined CFSTORE_CONFIG_BACKEND_FLASH_ENABLED && !defined CFSTORE_CONFIG_BACKEND_LOG_ENABLED
 
     static FlashJournal_t jrnl;
-    extern ARM_DRIVER_STORAGE ARM_Driver_Storage_MTD_K64F;
-    const ARM_DRIVER_STORAGE *drv = &ARM_Driver_Storage_MTD_K64F;
+    extern ARM_DRIVER_STORAGE CFSTORE_STORAGE_DRIVER;
+    const ARM_DRIVER_STORAGE *drv = &CFSTORE_STORAGE_DRIVER;
 
     ret = FlashJournal_initialize(&jrnl, drv, &FLASH_JOURNAL_STRATEGY_SEQUENTIAL, NULL);
     if(ret < JOURNAL_STATUS_OK){
@@ -271,7 +284,7 @@ int32_t cfstore_test_startup(void)
         return ARM_DRIVER_ERROR;
     }
 
-#endif /*  CFSTORE_CONFIG_BACKEND_FLASH_ENABLED */
+#endif /*  CFSTORE_CONFIG_BACKEND_FLASH_ENABLED && !CFSTORE_CONFIG_BACKEND_LOG_ENABLED */
 
     return ARM_DRIVER_OK;
 }
@@ -37,6 +37,10 @@
 #include "Driver_Common.h"
 #endif /* CFSTORE_CONFIG_BACKEND_FLASH_ENABLED */
 
+#ifdef CFSTORE_CONFIG_BACKEND_LOG_ENABLED
+#include "cfstore_log.h"
+#endif /* CFSTORE_CONFIG_BACKEND_LOG_ENABLED */
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -55,8 +59,8 @@ uint32_t cfstore_optLogTracepoint_g = CFSTORE_TP_NONE; /*CFSTORE_TP_NONE|CFSTORE
  * Externs
  */
 #ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
-extern ARM_DRIVER_STORAGE ARM_Driver_Storage_MTD_K64F;
-ARM_DRIVER_STORAGE *cfstore_storage_drv = &ARM_Driver_Storage_MTD_K64F;
+extern ARM_DRIVER_STORAGE CFSTORE_STORAGE_DRIVER;
+ARM_DRIVER_STORAGE *cfstore_storage_drv = &CFSTORE_STORAGE_DRIVER;
 #endif /* CFSTORE_CONFIG_BACKEND_FLASH_ENABLED */
 
 struct _ARM_DRIVER_STORAGE cfstore_journal_mtd;
@@ -129,6 +133,9 @@ struct _ARM_DRIVER_STORAGE cfstore_journal_mtd;
  *
  * @param   delete
  *          indicates this KV is being deleted
+ * @param   dirty
+ *          indicates this KV has been created or written since the last
+ *          flush. Only used with the record log backend.
  */
 typedef struct cfstore_area_header_t
 {
@@ -144,7 +151,8 @@ typedef struct cfstore_area_header_t
     uint8_t refcount;
     struct flags_t {
         uint8_t delete : 1;
-        uint8_t reserved : 7;
+        uint8_t dirty : 1;
+        uint8_t reserved : 6;
     } flags ;
 } cfstore_area_header_t;
 
@@ -159,6 +167,48 @@ typedef struct cfstore_area_hkvt_t
 } cfstore_area_hkvt_t;
 
 
+#ifdef CFSTORE_CONFIG_KEY_INDEX_ENABLED
+/* @brief   in-RAM index of the KVs in the sram area, so that Open(), Create()
+ *          and Find() do not have to walk the whole area.
+ *
+ * The index holds KV offsets from area_0_head, which remain correct when
+ * realloc() moves the area. Offsets are updated with cfstore_index_shift()
+ * when KVs are moved within the area.
+ *
+ * @param   slots
+ *          open addressing hash table of (KV offset + 1) keyed on the hash
+ *          of the key name. CFSTORE_INDEX_SLOT_EMPTY marks a slot which has
+ *          never been used and CFSTORE_INDEX_SLOT_REMOVED a slot whose KV has
+ *          been deleted.
+ * @param   sorted
+ *          KV offsets ordered by key name, and by offset for equal names.
+ *          Used to find the KVs matching the literal prefix of a Find() query.
+ * @param   num_slots
+ *          number of slots, a power of 2.
+ * @param   num_slots_used
+ *          number of slots which are not empty, including removed slots.
+ * @param   count
+ *          number of KVs in the index.
+ * @param   size
+ *          number of entries allocated for sorted.
+ * @param   valid
+ *          set when the index matches the area. When clear (e.g. after the
+ *          index could not be allocated) lookups walk the area and the index
+ *          is rebuilt when the next KV is created.
+ */
+typedef struct cfstore_index_t
+{
+    uint32_t *slots;
+    uint32_t *sorted;
+    uint32_t num_slots;
+    uint32_t num_slots_used;
+    uint32_t count;
+    uint32_t size;
+    bool valid;
+} cfstore_index_t;
+#endif /* CFSTORE_CONFIG_KEY_INDEX_ENABLED */
+
+
 /* helper struct */
 typedef struct cfstore_client_notify_data_t
 {
@@ -203,7 +253,7 @@ typedef struct cfstore_fsm_t
 
 
 #ifdef CFSTORE_DEBUG
-#ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
+#if defined CFSTORE_CONFIG_BACKEND_FLASH_ENABLED && !defined CFSTORE_CONFIG_BACKEND_LOG_ENABLED
 /* strings used for debug trace */
 static const char* cfstore_flash_opcode_str[] =
 {
@@ -247,7 +297,7 @@ static const char* cfstore_flash_event_str[] =
 /*
  * Forward decl
  */
-#ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
+#if defined CFSTORE_CONFIG_BACKEND_FLASH_ENABLED && !defined CFSTORE_CONFIG_BACKEND_LOG_ENABLED
 static int32_t cfstore_fsm_state_handle_event(cfstore_fsm_t* fsm, cfstore_fsm_event_t event, void* context);
 static int32_t cfstore_fsm_state_set(cfstore_fsm_t* fsm, cfstore_fsm_state_t new_state, void* ctx);
 #endif  /* CFSTORE_CONFIG_BACKEND_FLASH_ENABLED */
@@ -363,6 +413,19 @@ static int32_t cfstore_get_key_name_ex(cfstore_area_hkvt_t *hkvt, char* key_name
  *          flag indicating that the area has been written and therefore is
  *          dirty with respect to the data persisted to flash.
  *
+ * @param   index
+ *          key index of the KVs in area_0, see cfstore_index_t.
+ *
+ * @param   log
+ *          record log the KVs are persisted to when using the record log
+ *          backend, see cfstore_log.h.
+ *
+ * @param   deleted
+ *          key names of the KVs deleted since the last flush, each preceded
+ *          by its length, for writing DELETE records on the next flush.
+ * @param   deleted_len
+ *          number of bytes used in deleted.
+ *
  * @expected_blob_size  expected_blob_size = area_0_tail - area_0_head + pad
  *          In the case of reading from flash into sram, this will be be size
  *          of the flash blob (rounded to a multiple program_unit if not
@@ -394,7 +457,16 @@ typedef struct cfstore_ctx_t
     uint32_t area_dirty_flag : 1;
     uint32_t f_reserved0 : 30;
 
-#ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
+#ifdef CFSTORE_CONFIG_KEY_INDEX_ENABLED
+    cfstore_index_t index;
+#endif /* CFSTORE_CONFIG_KEY_INDEX_ENABLED */
+
+#if defined CFSTORE_CONFIG_BACKEND_LOG_ENABLED
+    /* record log related data */
+    cfstore_log_t log;
+    uint8_t *deleted;
+    uint32_t deleted_len;
+#elif defined CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
     /* flash journal related data */
     FlashJournal_t jrnl;
     FlashJournal_Info_t info;
@@ -622,10 +694,11 @@ static ARM_CFSTORE_SIZE cfstore_ctx_get_kv_total_len(void)
 static inline uint32_t cfstore_ctx_get_program_unit(cfstore_ctx_t* ctx)
 {
     CFSTORE_ASSERT(ctx!= NULL);
-#ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
+#if defined CFSTORE_CONFIG_BACKEND_FLASH_ENABLED && !defined CFSTORE_CONFIG_BACKEND_LOG_ENABLED
     return ctx->info.program_unit;
 #else
-    /* the program unit is 1 so byte aligned when no flash backend present */
+    /* the program unit is 1 so byte aligned when no flash backend present, or
+     * when using the record log which pads each record itself */
     (void) ctx;
     return 1;
 #endif /* CFSTORE_CONFIG_BACKEND_FLASH_ENABLED */
@@ -1305,12 +1378,380 @@ static int32_t cfstore_get_next_hkvt(cfstore_area_hkvt_t* prev, cfstore_area_hkv
 }
 
 
+#ifdef CFSTORE_CONFIG_KEY_INDEX_ENABLED
+
+/*
+ * Key index functions
+ */
+
+#define CFSTORE_INDEX_SLOT_EMPTY        0
+#define CFSTORE_INDEX_SLOT_REMOVED      0xffffffff
+#define CFSTORE_INDEX_SLOTS_MIN         16
+#define CFSTORE_INDEX_OFFSET_NONE       0xffffffff
+
+/* @brief   helper function to compute the FNV-1a hash of a key name */
+static uint32_t cfstore_index_hash(const char* key_name, size_t len)
+{
+    uint32_t hash = 2166136261UL;
+
+    while(len--){
+        hash ^= (uint8_t) *key_name++;
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+
+/* @brief   helper function to get the header of the KV at offset in the area */
+static CFSTORE_INLINE cfstore_area_header_t* cfstore_index_get_hdr(cfstore_ctx_t* ctx, uint32_t offset)
+{
+    return (cfstore_area_header_t*) (ctx->area_0_head + offset);
+}
+
+
+/* @brief   helper function to compare the key name of the KV at offset with
+ *          the first len chars of key_name, ordering as strcmp() would for
+ *          null terminated names.
+ *
+ * @param   prefix
+ *          if set, KVs whose key name starts with key_name compare equal.
+ */
+static int cfstore_index_cmp(cfstore_ctx_t* ctx, uint32_t offset, const char* key_name, size_t len, bool prefix)
+{
+    int cmp;
+    cfstore_area_header_t* hdr = cfstore_index_get_hdr(ctx, offset);
+    size_t klength = hdr->klength;
+
+    cmp = memcmp((uint8_t*) hdr + sizeof(cfstore_area_header_t), key_name, klength < len ? klength : len);
+    if(cmp == 0){
+        if(klength < len){
+            cmp = -1;
+        } else if(klength > len && !prefix){
+            cmp = 1;
+        }
+    }
+    return cmp;
+}
+
+
+/* @brief   qsort() compare function ordering offsets in cfstore_index_t::sorted */
+static int cfstore_index_sort_cmp(const void* a, const void* b)
+{
+    int cmp;
+    cfstore_ctx_t* ctx = cfstore_ctx_get();
+    uint32_t offset_a = *(const uint32_t*) a;
+    uint32_t offset_b = *(const uint32_t*) b;
+    cfstore_area_header_t* hdr = cfstore_index_get_hdr(ctx, offset_b);
+
+    cmp = cfstore_index_cmp(ctx, offset_a, (const char*) hdr + sizeof(cfstore_area_header_t), hdr->klength, false);
+    if(cmp == 0){
+        cmp = offset_a < offset_b ? -1 : (offset_a > offset_b ? 1 : 0);
+    }
+    return cmp;
+}
+
+
+/* @brief   helper function to find the position in cfstore_index_t::sorted of
+ *          the first KV that compares greater than (or equal to, if bias is 0)
+ *          key_name.
+ */
+static uint32_t cfstore_index_bound(cfstore_ctx_t* ctx, const char* key_name, size_t len, bool prefix, int bias)
+{
+    uint32_t lo = 0;
+    uint32_t hi = ctx->index.count;
+    uint32_t mid;
+
+    while(lo < hi){
+        mid = lo + (hi - lo) / 2;
+        if(cfstore_index_cmp(ctx, ctx->index.sorted[mid], key_name, len, prefix) < bias){
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+
+/* @brief   helper function to add the KV at offset to the hash table */
+static void cfstore_index_slot_insert(cfstore_ctx_t* ctx, uint32_t offset)
+{
+    cfstore_index_t* index = &ctx->index;
+    cfstore_area_header_t* hdr = cfstore_index_get_hdr(ctx, offset);
+    uint32_t mask = index->num_slots - 1;
+    uint32_t i;
+
+    i = cfstore_index_hash((const char*) hdr + sizeof(cfstore_area_header_t), hdr->klength) & mask;
+    while(index->slots[i] != CFSTORE_INDEX_SLOT_EMPTY && index->slots[i] != CFSTORE_INDEX_SLOT_REMOVED){
+        i = (i + 1) & mask;
+    }
+    if(index->slots[i] == CFSTORE_INDEX_SLOT_EMPTY){
+        index->num_slots_used++;
+    }
+    index->slots[i] = offset + 1;
+}
+
+
+/* @brief   free the key index memory */
+static void cfstore_index_free(cfstore_ctx_t* ctx)
+{
+    CFSTORE_FREE(ctx->index.slots);
+    CFSTORE_FREE(ctx->index.sorted);
+    memset(&ctx->index, 0, sizeof(cfstore_index_t));
+}
+
+
+/* @brief   build the key index from the KVs in the area.
+ *
+ * The index is sized so that the area can grow by about as many KVs again
+ * before the index has to be rebuilt.
+ *
+ * @return  ARM_DRIVER_OK on success, otherwise ARM_CFSTORE_DRIVER_ERROR_OUT_OF_MEMORY
+ *          in which case the index is left invalid and lookups walk the area.
+ */
+static int32_t cfstore_index_rebuild(cfstore_ctx_t* ctx)
+{
+    uint8_t* ptr = NULL;
+    uint32_t count = 0;
+    uint32_t num_slots = CFSTORE_INDEX_SLOTS_MIN;
+    cfstore_index_t* index = &ctx->index;
+    cfstore_area_hkvt_t hkvt;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    cfstore_index_free(ctx);
+    for(ptr = ctx->area_0_head; ptr != NULL && ptr < ctx->area_0_tail; ptr = hkvt.tail){
+        hkvt = cfstore_get_hkvt_from_head_ptr(ptr);
+        count++;
+    }
+    while(num_slots < 2 * (count + 1)){
+        num_slots <<= 1;
+    }
+    index->slots = (uint32_t*) CFSTORE_MALLOC(num_slots * sizeof(uint32_t));
+    index->sorted = (uint32_t*) CFSTORE_MALLOC((num_slots / 2) * sizeof(uint32_t));
+    if(index->slots == NULL || index->sorted == NULL){
+        CFSTORE_ERRLOG("%s:Error: unable to allocate key index (count=%d)\n", __func__, (int) count);
+        cfstore_index_free(ctx);
+        return ARM_CFSTORE_DRIVER_ERROR_OUT_OF_MEMORY;
+    }
+    memset(index->slots, 0, num_slots * sizeof(uint32_t));
+    index->num_slots = num_slots;
+    index->size = num_slots / 2;
+    for(ptr = ctx->area_0_head; ptr != NULL && ptr < ctx->area_0_tail; ptr = hkvt.tail){
+        hkvt = cfstore_get_hkvt_from_head_ptr(ptr);
+        cfstore_index_slot_insert(ctx, (uint32_t) (ptr - ctx->area_0_head));
+        index->sorted[index->count++] = (uint32_t) (ptr - ctx->area_0_head);
+    }
+    qsort(index->sorted, index->count, sizeof(uint32_t), cfstore_index_sort_cmp);
+    index->valid = true;
+    CFSTORE_TP(CFSTORE_TP_MEM, "%s:count=%d, num_slots=%d\n", __func__, (int) index->count, (int) index->num_slots);
+    return ARM_DRIVER_OK;
+}
+
+
+/* @brief   add a newly created KV to the key index.
+ *
+ * @param   head
+ *          head of the KV, which must already be in the area.
+ */
+static void cfstore_index_insert(cfstore_ctx_t* ctx, uint8_t* head)
+{
+    uint32_t pos;
+    uint32_t offset = (uint32_t) (head - ctx->area_0_head);
+    cfstore_index_t* index = &ctx->index;
+
+    if(!index->valid || index->count == index->size || 4 * (index->num_slots_used + 1) > 3 * index->num_slots){
+        /* the rebuilt index includes the new KV */
+        cfstore_index_rebuild(ctx);
+        return;
+    }
+    cfstore_index_slot_insert(ctx, offset);
+    pos = cfstore_index_bound(ctx, (const char*) head + sizeof(cfstore_area_header_t), ((cfstore_area_header_t*) head)->klength, false, 0);
+    /* KVs with the same name are ordered by offset */
+    while(pos < index->count && cfstore_index_sort_cmp(&index->sorted[pos], &offset) < 0){
+        pos++;
+    }
+    memmove(&index->sorted[pos + 1], &index->sorted[pos], (index->count - pos) * sizeof(uint32_t));
+    index->sorted[pos] = offset;
+    index->count++;
+}
+
+
+/* @brief   remove a KV from the key index before it is deleted from the area */
+static void cfstore_index_remove(cfstore_ctx_t* ctx, uint8_t* head)
+{
+    uint32_t i;
+    uint32_t mask;
+    uint32_t pos;
+    uint32_t offset = (uint32_t) (head - ctx->area_0_head);
+    cfstore_index_t* index = &ctx->index;
+    cfstore_area_header_t* hdr = (cfstore_area_header_t*) head;
+    const char* key = (const char*) head + sizeof(cfstore_area_header_t);
+
+    if(!index->valid){
+        return;
+    }
+    mask = index->num_slots - 1;
+    i = cfstore_index_hash(key, hdr->klength) & mask;
+    while(index->slots[i] != CFSTORE_INDEX_SLOT_EMPTY && index->slots[i] != offset + 1){
+        i = (i + 1) & mask;
+    }
+    pos = cfstore_index_bound(ctx, key, hdr->klength, false, 0);
+    while(pos < index->count && index->sorted[pos] != offset && cfstore_index_cmp(ctx, index->sorted[pos], key, hdr->klength, false) == 0){
+        pos++;
+    }
+    if(index->slots[i] == CFSTORE_INDEX_SLOT_EMPTY || pos == index->count || index->sorted[pos] != offset){
+        CFSTORE_ERRLOG("%s:Error: KV not found in key index (offset=%d)\n", __func__, (int) offset);
+        index->valid = false;
+        return;
+    }
+    index->slots[i] = CFSTORE_INDEX_SLOT_REMOVED;
+    memmove(&index->sorted[pos], &index->sorted[pos + 1], (index->count - pos - 1) * sizeof(uint32_t));
+    index->count--;
+}
+
+
+/* @brief   update the key index after the KVs following head have been moved
+ *          size_diff bytes within the area (see cfstore_file_update()).
+ */
+static void cfstore_index_shift(cfstore_ctx_t* ctx, uint8_t* head, int32_t size_diff)
+{
+    uint32_t i;
+    uint32_t offset = (uint32_t) (head - ctx->area_0_head);
+    cfstore_index_t* index = &ctx->index;
+
+    if(!index->valid){
+        return;
+    }
+    for(i = 0; i < index->num_slots; i++){
+        if(index->slots[i] != CFSTORE_INDEX_SLOT_EMPTY && index->slots[i] != CFSTORE_INDEX_SLOT_REMOVED && index->slots[i] - 1 > offset){
+            index->slots[i] += size_diff;
+        }
+    }
+    /* moving all the later KVs by the same amount doesnt change the sort order */
+    for(i = 0; i < index->count; i++){
+        if(index->sorted[i] > offset){
+            index->sorted[i] += size_diff;
+        }
+    }
+}
+
+
+/* @brief   helper function to check if the KV at offset can be returned by cfstore_find_ex() */
+static bool cfstore_index_is_findable(cfstore_ctx_t* ctx, uint32_t offset, cfstore_area_hkvt_t* hkvt)
+{
+    *hkvt = cfstore_get_hkvt_from_head_ptr(ctx->area_0_head + offset);
+    return !cfstore_hkvt_get_flags_delete(hkvt) && cfstore_is_kv_client_readable(hkvt);
+}
+
+
+/* @brief   find the next KV after prev matching a query using the key index.
+ *
+ * The KV returned is the same one the walk in cfstore_find_ex() would find
+ * i.e. the first matching KV in the area after prev.
+ * - A query without wildcards is looked up in the hash table.
+ * - A query starting with literal chars only checks the KVs whose names start
+ *   with those chars. This takes time proportional to the number of such KVs
+ *   for every call whereas walking the area from prev takes time proportional
+ *   to the number of KVs between matches, so the index is only used for
+ *   prefixes matching fewer than sqrt(count) KVs.
+ *
+ * @return  true if the query was handled using the index, with *ret set as
+ *          cfstore_find_ex() would set it, otherwise false.
+ */
+static bool cfstore_index_find(cfstore_ctx_t* ctx, const char* key_name_query, cfstore_area_hkvt_t* prev, cfstore_area_hkvt_t* next, int32_t* ret)
+{
+    uint32_t i;
+    uint32_t lo;
+    uint32_t hi;
+    uint32_t mask;
+    uint32_t offset;
+    uint32_t start = 0;
+    uint32_t found = CFSTORE_INDEX_OFFSET_NONE;
+    int32_t fnm_ret;
+    uint8_t key_len;
+    size_t prefix_len = strcspn(key_name_query, "*");
+    size_t query_len = strlen(key_name_query);
+    char key_name[CFSTORE_KEY_NAME_MAX_LENGTH+1];
+    cfstore_index_t* index = &ctx->index;
+    cfstore_area_hkvt_t hkvt;
+
+    if(!index->valid || prefix_len == 0){
+        return false;
+    }
+    if(prev != NULL){
+        /* only KVs after prev are candidates */
+        start = (uint32_t) (prev->tail - ctx->area_0_head);
+    }
+    if(prefix_len == query_len){
+        mask = index->num_slots - 1;
+        i = cfstore_index_hash(key_name_query, query_len) & mask;
+        for( ; index->slots[i] != CFSTORE_INDEX_SLOT_EMPTY; i = (i + 1) & mask){
+            offset = index->slots[i] - 1;
+            if(index->slots[i] == CFSTORE_INDEX_SLOT_REMOVED || offset < start || offset >= found){
+                continue;
+            }
+            if(cfstore_index_cmp(ctx, offset, key_name_query, query_len, false) == 0 && cfstore_index_is_findable(ctx, offset, &hkvt)){
+                found = offset;
+            }
+        }
+    } else {
+        lo = cfstore_index_bound(ctx, key_name_query, prefix_len, true, 0);
+        hi = cfstore_index_bound(ctx, key_name_query, prefix_len, true, 1);
+        if((hi - lo) * (hi - lo) > index->count){
+            return false;
+        }
+        for(i = lo; i < hi; i++){
+            offset = index->sorted[i];
+            if(offset < start || offset >= found || !cfstore_index_is_findable(ctx, offset, &hkvt)){
+                continue;
+            }
+            key_len = CFSTORE_KEY_NAME_MAX_LENGTH+1;
+            cfstore_get_key_name_ex(&hkvt, key_name, &key_len);
+            fnm_ret = cfstore_fnmatch(key_name_query, key_name, 0);
+            if(fnm_ret == 0){
+                found = offset;
+            } else if(fnm_ret != CFSTORE_FNM_NOMATCH){
+                CFSTORE_ERRLOG("%s:Error: cfstore_fnmatch() error (ret=%d).\n", __func__, (int) fnm_ret);
+                *ret = ARM_DRIVER_ERROR;
+                return true;
+            }
+        }
+    }
+    if(found == CFSTORE_INDEX_OFFSET_NONE){
+        CFSTORE_TP(CFSTORE_TP_FIND, "%s:No more KVs found\n", __func__);
+        memset((void*) next, 0, sizeof(cfstore_area_hkvt_t));
+        *ret = ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND;
+        return true;
+    }
+    *next = cfstore_get_hkvt_from_head_ptr(ctx->area_0_head + found);
+    CFSTORE_TP(CFSTORE_TP_FIND, "%s:Found matching key (key_name_query = \"%s\", offset=%d)\n", __func__, key_name_query, (int) found);
+    *ret = ARM_DRIVER_OK;
+    return true;
+}
+
+#else
+
+static CFSTORE_INLINE int32_t cfstore_index_rebuild(cfstore_ctx_t* ctx) { (void) ctx; return ARM_DRIVER_OK; }
+static CFSTORE_INLINE void cfstore_index_free(cfstore_ctx_t* ctx) { (void) ctx; }
+static CFSTORE_INLINE void cfstore_index_insert(cfstore_ctx_t* ctx, uint8_t* head) { (void) ctx; (void) head; }
+static CFSTORE_INLINE void cfstore_index_remove(cfstore_ctx_t* ctx, uint8_t* head) { (void) ctx; (void) head; }
+static CFSTORE_INLINE void cfstore_index_shift(cfstore_ctx_t* ctx, uint8_t* head, int32_t size_diff) { (void) ctx; (void) head; (void) size_diff; }
+static CFSTORE_INLINE bool cfstore_index_find(cfstore_ctx_t* ctx, const char* key_name_query, cfstore_area_hkvt_t* prev, cfstore_area_hkvt_t* next, int32_t* ret)
+{
+    (void) ctx; (void) key_name_query; (void) prev; (void) next; (void) ret;
+    return false;
+}
+
+#endif /* CFSTORE_CONFIG_KEY_INDEX_ENABLED */
+
+
 /*
  * Flash support functions
  */
 
 static CFSTORE_INLINE void cfstore_hkvt_dump(cfstore_area_hkvt_t* hkvt, const char* tag);
 
+#ifndef CFSTORE_CONFIG_BACKEND_LOG_ENABLED
 /** @brief  Set the context tail pointer area_0_tail to point to the end of the
  *          last KV in the memory area.
  *
@@ -1377,6 +1818,7 @@ static int32_t cfstore_flash_set_tail(void)
     }
     return ret;
 }
+#endif /* !CFSTORE_CONFIG_BACKEND_LOG_ENABLED */
 
 
 /** @brief  Function to realloc the SRAM area used to store KVs.
@@ -1459,8 +1901,7 @@ static int32_t cfstore_realloc_ex(ARM_CFSTORE_SIZE size, uint64_t *allocated_siz
             node = file_list->next;
             while(node != file_list){
                 file = (cfstore_file_t*) node;
-                file->head = (uint8_t *) (file->head - ctx->area_0_head);
-                file->head = (uint8_t *) ((int32_t) file->head + (int32_t) ptr);
+                file->head = ptr + (file->head - ctx->area_0_head);
                 node = node->next;
             }
             ctx->area_0_head = ptr;
@@ -1496,7 +1937,294 @@ static int32_t cfstore_realloc_ex(ARM_CFSTORE_SIZE size, uint64_t *allocated_siz
 }
 
 
-#ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
+#ifdef CFSTORE_CONFIG_BACKEND_LOG_ENABLED
+
+/*
+ * record log dirty tracking
+ *
+ * Create(), Write() and Delete() record which KVs they change so that Flush()
+ * only has to append records for those KVs to the log.
+ */
+
+/* @brief   mark a KV as created or written since the last flush */
+static void cfstore_log_mark_dirty(cfstore_ctx_t* ctx, cfstore_area_hkvt_t* hkvt)
+{
+    (void) ctx;
+    ((cfstore_area_header_t*) hkvt->head)->flags.dirty = true;
+}
+
+/* @brief   record the key name of a KV being deleted, for writing a DELETE
+ *          record on the next flush. If the name cannot be recorded, the
+ *          next flush compacts the log, which does not need it. */
+static void cfstore_log_mark_deleted(cfstore_ctx_t* ctx, cfstore_area_hkvt_t* hkvt)
+{
+    uint8_t klength = cfstore_hkvt_get_key_len(hkvt);
+    uint8_t* ptr = NULL;
+
+    ptr = (uint8_t*) CFSTORE_REALLOC(ctx->deleted, ctx->deleted_len + klength + 1);
+    if(ptr == NULL){
+        CFSTORE_ERRLOG("%s:Error: unable to record deleted key. The next flush will compact the log.\n", __func__);
+        ctx->log.need_compact = true;
+        return;
+    }
+    ptr[ctx->deleted_len] = klength;
+    memcpy(ptr + ctx->deleted_len + 1, hkvt->key, klength);
+    ctx->deleted = ptr;
+    ctx->deleted_len += klength + 1;
+}
+
+#else
+
+static inline void cfstore_log_mark_dirty(cfstore_ctx_t* ctx, cfstore_area_hkvt_t* hkvt) { (void) ctx; (void) hkvt; }
+static inline void cfstore_log_mark_deleted(cfstore_ctx_t* ctx, cfstore_area_hkvt_t* hkvt) { (void) ctx; (void) hkvt; }
+
+#endif /* CFSTORE_CONFIG_BACKEND_LOG_ENABLED */
+
+
+#if defined CFSTORE_CONFIG_BACKEND_LOG_ENABLED
+
+/*
+ * record log backend
+ *
+ * Flush() appends a DELETE record for each KV deleted and a PUT record for
+ * each KV created or written since the last flush, followed by a COMMIT record.
+ * When these records do not fit in the log, the log is compacted instead by
+ * writing a PUT record for every KV. Either way only the KVs which are not
+ * being deleted are written. All storage operations complete before Flush()
+ * returns.
+ */
+
+/* @brief   append a PUT record for a KV. The header is written as it would be
+ *          for a KV with no open handles. */
+static int32_t cfstore_log_put_kv(cfstore_ctx_t* ctx, cfstore_area_hkvt_t* hkvt)
+{
+    cfstore_area_header_t hdr;
+
+    memcpy(&hdr, hkvt->head, sizeof(hdr));
+    hdr.refcount = 0;
+    hdr.flags.delete = false;
+    hdr.flags.dirty = false;
+    return cfstore_log_append(&ctx->log, CFSTORE_LOG_RECORD_PUT, &hdr, sizeof(hdr), hkvt->key, (uint32_t) (hkvt->tail - hkvt->key));
+}
+
+/* @brief   persist the changes made since the last flush */
+static int32_t cfstore_log_flush(cfstore_ctx_t* ctx)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    uint32_t pos = 0;
+    uint32_t kv_size = 0;
+    uint32_t delta_size = 0;
+    uint32_t snapshot_size = 0;
+    uint8_t* ptr = NULL;
+    cfstore_area_hkvt_t hkvt;
+
+    CFSTORE_FENTRYLOG("%s:entered\n", __func__);
+    /* size the records for both an incremental flush and a compaction */
+    for(pos = 0; pos < ctx->deleted_len; pos += ctx->deleted[pos] + 1){
+        delta_size += cfstore_log_record_size(&ctx->log, ctx->deleted[pos]);
+    }
+    for(ptr = ctx->area_0_head; ptr < ctx->area_0_tail; ptr = hkvt.tail){
+        hkvt = cfstore_get_hkvt_from_head_ptr(ptr);
+        if(cfstore_hkvt_get_flags_delete(&hkvt)){
+            continue;
+        }
+        kv_size = cfstore_log_record_size(&ctx->log, cfstore_hkvt_get_size(&hkvt));
+        snapshot_size += kv_size;
+        if(((cfstore_area_header_t*) hkvt.head)->flags.dirty){
+            delta_size += kv_size;
+        }
+    }
+
+    if(delta_size == 0 && !ctx->log.need_compact){
+        /* nothing which is persisted has changed */
+        CFSTORE_TP(CFSTORE_TP_FLUSH, "%s:no records to write\n", __func__);
+        ret = ARM_DRIVER_OK;
+        goto out0;
+    }
+    if(delta_size > 0 && delta_size <= cfstore_log_space(&ctx->log)){
+        CFSTORE_TP(CFSTORE_TP_FLUSH, "%s:appending %d bytes of records\n", __func__, (int) delta_size);
+        for(pos = 0; pos < ctx->deleted_len; pos += ctx->deleted[pos] + 1){
+            ret = cfstore_log_append(&ctx->log, CFSTORE_LOG_RECORD_DELETE, ctx->deleted + pos + 1, ctx->deleted[pos], NULL, 0);
+            if(ret < ARM_DRIVER_OK){
+                goto out1;
+            }
+        }
+        for(ptr = ctx->area_0_head; ptr < ctx->area_0_tail; ptr = hkvt.tail){
+            hkvt = cfstore_get_hkvt_from_head_ptr(ptr);
+            if(!cfstore_hkvt_get_flags_delete(&hkvt) && ((cfstore_area_header_t*) hkvt.head)->flags.dirty){
+                ret = cfstore_log_put_kv(ctx, &hkvt);
+                if(ret < ARM_DRIVER_OK){
+                    goto out1;
+                }
+            }
+        }
+        ret = cfstore_log_commit(&ctx->log);
+        if(ret < ARM_DRIVER_OK){
+            goto out1;
+        }
+    } else {
+        CFSTORE_TP(CFSTORE_TP_FLUSH, "%s:compacting log, writing %d bytes of records\n", __func__, (int) snapshot_size);
+        if(snapshot_size > cfstore_log_capacity(&ctx->log)){
+            CFSTORE_ERRLOG("%s:Error: KVs do not fit in storage (size=%d, capacity=%d)\n", __func__, (int) snapshot_size, (int) cfstore_log_capacity(&ctx->log));
+            ret = ARM_CFSTORE_DRIVER_ERROR_JOURNAL_STATUS_BOUNDED_CAPACITY;
+            goto out0;
+        }
+        ret = cfstore_log_compact_begin(&ctx->log);
+        if(ret < ARM_DRIVER_OK){
+            goto out1;
+        }
+        for(ptr = ctx->area_0_head; ptr < ctx->area_0_tail; ptr = hkvt.tail){
+            hkvt = cfstore_get_hkvt_from_head_ptr(ptr);
+            if(!cfstore_hkvt_get_flags_delete(&hkvt)){
+                ret = cfstore_log_put_kv(ctx, &hkvt);
+                if(ret < ARM_DRIVER_OK){
+                    goto out1;
+                }
+            }
+        }
+        ret = cfstore_log_compact_end(&ctx->log);
+        if(ret < ARM_DRIVER_OK){
+            goto out1;
+        }
+    }
+    /* the changes are persisted so clear the dirty state */
+    for(ptr = ctx->area_0_head; ptr < ctx->area_0_tail; ptr = hkvt.tail){
+        hkvt = cfstore_get_hkvt_from_head_ptr(ptr);
+        ((cfstore_area_header_t*) hkvt.head)->flags.dirty = false;
+    }
+    ret = ARM_DRIVER_OK;
+out0:
+    if(ret >= ARM_DRIVER_OK){
+        CFSTORE_FREE(ctx->deleted);
+        ctx->deleted = NULL;
+        ctx->deleted_len = 0;
+    }
+    return ret;
+out1:
+    CFSTORE_ERRLOG("%s:Error: failed to write records (ret=%d)\n", __func__, (int) ret);
+    return ret;
+}
+
+/* @brief   apply a record replayed from the log to the area. A PUT record
+ *          replaces any existing KV with the same name. */
+static int32_t cfstore_log_apply(void* context, uint8_t type, const uint8_t* data, uint32_t len)
+{
+    int32_t ret = ARM_DRIVER_OK;
+    uint8_t klength = 0;
+    const uint8_t* key = NULL;
+    uint8_t* ptr = NULL;
+    ARM_CFSTORE_SIZE area_size = 0;
+    ARM_CFSTORE_SIZE kv_size = 0;
+    cfstore_ctx_t* ctx = (cfstore_ctx_t*) context;
+    const cfstore_area_header_t* hdr = (const cfstore_area_header_t*) data;
+    cfstore_area_hkvt_t hkvt;
+
+    if(type == CFSTORE_LOG_RECORD_PUT){
+        if(len < sizeof(cfstore_area_header_t) || len != sizeof(cfstore_area_header_t) + hdr->klength + hdr->vlength){
+            CFSTORE_ERRLOG("%s:Error: invalid PUT record (len=%d)\n", __func__, (int) len);
+            return ARM_CFSTORE_DRIVER_ERROR_INTERNAL;
+        }
+        klength = hdr->klength;
+        key = data + sizeof(cfstore_area_header_t);
+    } else {
+        if(len > CFSTORE_KEY_NAME_MAX_LENGTH){
+            CFSTORE_ERRLOG("%s:Error: invalid DELETE record (len=%d)\n", __func__, (int) len);
+            return ARM_CFSTORE_DRIVER_ERROR_INTERNAL;
+        }
+        klength = (uint8_t) len;
+        key = data;
+    }
+    /* remove the previous version of the KV. There are no open handles to update */
+    for(ptr = ctx->area_0_head; ptr < ctx->area_0_tail; ptr = hkvt.tail){
+        hkvt = cfstore_get_hkvt_from_head_ptr(ptr);
+        if(cfstore_hkvt_get_key_len(&hkvt) == klength && memcmp(hkvt.key, key, klength) == 0){
+            kv_size = cfstore_hkvt_get_size(&hkvt);
+            area_size = cfstore_ctx_get_kv_total_len();
+            memmove(hkvt.head, hkvt.tail, ctx->area_0_tail - hkvt.tail);
+            ret = cfstore_realloc_ex(area_size - kv_size, NULL);
+            if(ret < ARM_DRIVER_OK){
+                return ret;
+            }
+            break;
+        }
+    }
+    if(type == CFSTORE_LOG_RECORD_PUT){
+        area_size = cfstore_ctx_get_kv_total_len();
+        ret = cfstore_realloc_ex(area_size + len, NULL);
+        if(ret < ARM_DRIVER_OK){
+            return ret;
+        }
+        memcpy(ctx->area_0_head + area_size, data, len);
+    }
+    return ret;
+}
+
+static bool cfstore_flash_journal_is_async_op_pending(cfstore_ctx_t* ctx) { CFSTORE_FENTRYLOG("%s:LOG:entered:\n", __func__); (void) ctx; return false; }
+
+/* @brief   load the KVs from the log and generate the CFSTORE_OPCODE_INITIALIZE callback notification */
+static int32_t cfstore_flash_init(void)
+{
+    int32_t ret = ARM_DRIVER_ERROR;
+    cfstore_client_notify_data_t notify_data;
+    cfstore_ctx_t* ctx = cfstore_ctx_get();
+
+    CFSTORE_FENTRYLOG("%s:LOG:entered:\n", __func__);
+    ctx->deleted = NULL;
+    ctx->deleted_len = 0;
+    ret = cfstore_svm_init(&cfstore_journal_mtd);
+    if(ret < ARM_DRIVER_OK){
+        CFSTORE_ERRLOG("%s:Error: Unable to initialize storage volume manager (ret=%d)\n", __func__, (int) ret);
+        goto out0;
+    }
+    ret = cfstore_log_init(&ctx->log, (ARM_DRIVER_STORAGE *) &cfstore_journal_mtd);
+    if(ret < ARM_DRIVER_OK){
+        CFSTORE_ERRLOG("%s:Error: failed to initialize record log (ret=%d)\n", __func__, (int) ret);
+        goto out0;
+    }
+    ret = cfstore_log_replay(&ctx->log, cfstore_log_apply, ctx);
+    if(ret < ARM_DRIVER_OK){
+        CFSTORE_ERRLOG("%s:Error: failed to load KVs from record log (ret=%d)\n", __func__, (int) ret);
+        goto out0;
+    }
+    /* failing to build the index is not an error, lookups walk the area instead */
+    cfstore_index_rebuild(ctx);
+    ret = ARM_DRIVER_OK;
+out0:
+    cfstore_client_notify_data_init(&notify_data, CFSTORE_OPCODE_INITIALIZE, ret, NULL);
+    cfstore_ctx_client_notify(ctx, &notify_data);
+    return ret;
+}
+
+static int32_t cfstore_flash_deinit(void)
+{
+    cfstore_ctx_t* ctx = cfstore_ctx_get();
+
+    CFSTORE_FENTRYLOG("%s:LOG:entered:\n", __func__);
+    cfstore_log_deinit(&ctx->log);
+    CFSTORE_FREE(ctx->deleted);
+    ctx->deleted = NULL;
+    ctx->deleted_len = 0;
+    return ARM_DRIVER_OK;
+}
+
+static int32_t cfstore_flash_flush(cfstore_ctx_t* ctx)
+{
+    int32_t ret = ARM_DRIVER_OK;
+    cfstore_client_notify_data_t notify_data;
+
+    CFSTORE_FENTRYLOG("%s:LOG:entered:\n", __func__);
+    if(ctx->area_dirty_flag == true){
+        ret = cfstore_log_flush(ctx);
+        if(ret >= ARM_DRIVER_OK){
+            ctx->area_dirty_flag = false;
+        }
+    }
+    cfstore_client_notify_data_init(&notify_data, CFSTORE_OPCODE_FLUSH, ret, NULL);
+    cfstore_ctx_client_notify(ctx, &notify_data);
+    return ret;
+}
+
+#elif defined CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
 
 /*
  * flash helper functions
@@ -1778,6 +2506,8 @@ static int32_t cfstore_fsm_reading(void* context)
                     memset(&ctx->info, 0, sizeof(ctx->info));
                     goto out;
                 }
+                /* failing to build the index is not an error, lookups walk the area instead */
+                cfstore_index_rebuild(ctx);
                 ret = cfstore_fsm_state_set(&ctx->fsm, cfstore_fsm_state_ready, ctx);
                 if(ret < ARM_DRIVER_OK){
                     CFSTORE_ERRLOG("%s:Error: cfstore_fsm_state_set() failed (ret=%d)\n", __func__, (int) ret);
@@ -2380,6 +3110,7 @@ static int32_t cfstore_delete_ex(cfstore_area_hkvt_t* hkvt)
      *     need to be updated. cfstore_realloc() can only do this starting from a set of correct
      *     cfstore_file_t::head pointers i.e. after 1. has been completed.
      */
+    cfstore_index_remove(ctx, hkvt->head);
     memmove(hkvt->head, hkvt->tail, ctx->area_0_tail - hkvt->tail);
     /* zero the deleted KV memory */
     memset(ctx->area_0_tail-kv_size, 0, kv_size);
@@ -2390,6 +3121,7 @@ static int32_t cfstore_delete_ex(cfstore_area_hkvt_t* hkvt)
         CFSTORE_ERRLOG("%s:Error:file update failed\n", __func__);
         goto out0;
     }
+    cfstore_index_shift(ctx, hkvt->head, -1 * kv_size);
 
     /* setup the reallocation memory size. */
     realloc_size = kv_total_size - kv_size;
@@ -3103,6 +3835,7 @@ static int32_t cfstore_delete(ARM_CFSTORE_HANDLE hkey)
     /* set the delete flag so the delete occurs when the file is closed
      * no further handles will be returned to this key */
     cfstore_hkvt_set_flags_delete(&hkvt, true);
+    cfstore_log_mark_deleted(ctx, &hkvt);
 
     /* set the dirty flag so the changes are persisted to backing store when flushed */
     ctx->area_dirty_flag = true;
@@ -3133,10 +3866,14 @@ static int32_t cfstore_find_ex(const char* key_name_query, cfstore_area_hkvt_t *
 {
     int32_t ret = ARM_DRIVER_ERROR;
     uint8_t next_key_len;
+    size_t prefix_len = strcspn(key_name_query, "*");
     char key_name[CFSTORE_KEY_NAME_MAX_LENGTH+1];
     cfstore_ctx_t* ctx = cfstore_ctx_get();
 
     CFSTORE_TP((CFSTORE_TP_FIND|CFSTORE_TP_FENTRY), "%s:entered: key_name_query=\"%s\", prev=%p, next=%p\n", __func__, key_name_query, prev, next);
+    if(cfstore_index_find(ctx, key_name_query, prev, next, &ret)){
+        return ret;
+    }
     if(prev == NULL){
         ret = cfstore_get_head_hkvt(next);
         /* CFSTORE_TP(CFSTORE_TP_FIND, "%s:next->head=%p, next->key=%p, next->value=%p, next->tail=%p, \n", __func__, next->head, next->key, next->value, next->tail); */
@@ -3194,8 +3931,17 @@ static int32_t cfstore_find_ex(const char* key_name_query, cfstore_area_hkvt_t *
             }
             continue;
         }
-        /* check if this key_name matches the query */
+        /* if this key_name doesnt start with the literal chars of the query then proceed to the next item */
         next_key_len = cfstore_hkvt_get_key_len(next);
+        if(next_key_len < prefix_len || memcmp(next->key, key_name_query, prefix_len) != 0){
+            ret = cfstore_get_next_hkvt(next, next);
+            if(ret == ARM_CFSTORE_DRIVER_ERROR_KEY_NOT_FOUND) {
+                CFSTORE_TP(CFSTORE_TP_FIND, "%s:No more KVs found\n", __func__);
+                return ret;
+            }
+            continue;
+        }
+        /* check if this key_name matches the query */
         next_key_len++;
         cfstore_get_key_name_ex(next, key_name, &next_key_len);
         ret = cfstore_fnmatch(key_name_query, key_name, 0);
@@ -3372,6 +4118,7 @@ static int32_t cfstore_recreate(const char* key_name, ARM_CFSTORE_SIZE value_len
             CFSTORE_ERRLOG("%s:Error:file update failed\n", __func__);
             goto out0;
         }
+        cfstore_index_shift(ctx, hkvt->head, kv_size_diff);
     }
 
     ret = cfstore_realloc_ex(area_size + kv_size_diff, NULL);
@@ -3395,6 +4142,7 @@ static int32_t cfstore_recreate(const char* key_name, ARM_CFSTORE_SIZE value_len
             CFSTORE_ERRLOG("%s:Error:file update failed\n", __func__);
             goto out0;
         }
+        cfstore_index_shift(ctx, hkvt->head, kv_size_diff);
     }
     /* hkvt->head, hkvt->key and hkvt->value remain unchanged but hkvt->tail has moved. Update it.*/
     hkvt->tail = hkvt->tail + kv_size_diff;
@@ -3402,6 +4150,7 @@ static int32_t cfstore_recreate(const char* key_name, ARM_CFSTORE_SIZE value_len
     /* set the new value length in the header */
     cfstore_hkvt_set_value_len(hkvt, value_len);
     cfstore_file_create(hkvt, flags, hkey, &ctx->file_list);
+    cfstore_log_mark_dirty(ctx, hkvt);
     ctx->area_dirty_flag = true;
 
 #ifdef CFSTORE_DEBUG
@@ -3535,6 +4284,7 @@ static int32_t cfstore_create(const char* key_name, ARM_CFSTORE_SIZE value_len,
     hdr->perm_other_execute = kdesc->acl.perm_other_execute;
     strncpy((char*)hdr + sizeof(cfstore_area_header_t), key_name, strlen(key_name));
     hkvt = cfstore_get_hkvt_from_head_ptr((uint8_t*) hdr);
+    cfstore_index_insert(ctx, hkvt.head);
     if(cfstore_flags_is_default(kdesc->flags)){
         /* set as read-only by default default */
         flags.read = true;
@@ -3544,6 +4294,7 @@ static int32_t cfstore_create(const char* key_name, ARM_CFSTORE_SIZE value_len,
         flags.write = kdesc->flags.write;
     }
     cfstore_file_create(&hkvt, flags, hkey, &ctx->file_list);
+    cfstore_log_mark_dirty(ctx, &hkvt);
     ctx->area_dirty_flag = true;
     ret = ARM_DRIVER_OK;
 out1:
@@ -3833,6 +4584,7 @@ static int32_t cfstore_write(ARM_CFSTORE_HANDLE hkey, const char* data, ARM_CFST
     memcpy(hkvt.value + file->wlocation, data, *len);
     file->wlocation += *len;
     cfstore_hkvt_dump(&hkvt, __func__);
+    cfstore_log_mark_dirty(ctx, &hkvt);
     ctx->area_dirty_flag = true;
     ret = *len;
 out0:
@@ -3955,6 +4707,9 @@ static int32_t cfstore_initialise(ARM_CFSTORE_CALLBACK callback, void* client_co
         /* ctx->rw_area0_lock initialisation is not required here as the lock is statically initialised to 0 */
         ctx->area_0_head = NULL;
         ctx->area_0_tail = NULL;
+#ifdef CFSTORE_CONFIG_KEY_INDEX_ENABLED
+        memset(&ctx->index, 0, sizeof(ctx->index));
+#endif /* CFSTORE_CONFIG_KEY_INDEX_ENABLED */
 
         CFSTORE_ASSERT(sizeof(cfstore_file_t) == CFSTORE_HANDLE_BUFSIZE);
         if(sizeof(cfstore_file_t) != CFSTORE_HANDLE_BUFSIZE){
@@ -3971,7 +4726,11 @@ static int32_t cfstore_initialise(ARM_CFSTORE_CALLBACK callback, void* client_co
         ctx->power_state = ARM_POWER_FULL;
         ctx->status = ARM_DRIVER_OK;
 
-#ifdef CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
+#if defined CFSTORE_CONFIG_BACKEND_LOG_ENABLED
+        /* the record log completes storage operations before returning */
+        (void) storage_caps;
+        cfstore_caps_g.asynchronous_ops = 0;
+#elif defined CFSTORE_CONFIG_BACKEND_FLASH_ENABLED
         /* set the cfstore async flag according to the storage driver mode */
         storage_caps = cfstore_storage_drv->GetCapabilities();
         cfstore_caps_g.asynchronous_ops = storage_caps.asynchronous_ops;
@@ -4048,6 +4807,7 @@ static int32_t cfstore_uninitialise(void)
             CFSTORE_ERRLOG("%s:Error: failed to uninitialise flash journal layer.\n", __func__);
             goto out;
         }
+        cfstore_index_free(ctx);
         if(ctx->area_0_head){
             CFSTORE_FREE(ctx->area_0_head);
             ctx->area_0_head = NULL;
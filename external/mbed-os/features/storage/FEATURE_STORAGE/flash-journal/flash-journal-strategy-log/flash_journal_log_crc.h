@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2006-2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __FLASH_JOURNAL_LOG_CRC_H__
+#define __FLASH_JOURNAL_LOG_CRC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * Compute the standard CRC-32 (the one used by Ethernet and zlib; check value
+ * 0xCBF43926 for "123456789") over a buffer.
+ *
+ * Unlike flashJournalCrcCummulative() the running value is passed in and
+ * returned, so several computations may be interleaved. Start with a crc of 0
+ * and feed the result of one call into the next to extend a CRC over
+ * discontiguous data.
+ *
+ * The default implementation is table driven and processes 8 bytes per
+ * iteration (slice-by-8). Targets with a CRC peripheral may define
+ * FLASH_JOURNAL_LOG_CRC32_ALT and provide their own flashJournalStrategyLog_crc32().
+ *
+ * @param[in] crc
+ *              CRC of the data preceding 'data', or 0.
+ * @param[in] data
+ *              data to be added to the CRC.
+ * @param[in] size
+ *              number of bytes at 'data'.
+ *
+ * @return the CRC of the preceding data extended over 'data'.
+ */
+uint32_t flashJournalStrategyLog_crc32(uint32_t crc, const void *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif /* __FLASH_JOURNAL_LOG_CRC_H__ */
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2006-2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __FLASH_JOURNAL_LOG_PRIVATE_H__
+#define __FLASH_JOURNAL_LOG_PRIVATE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "flash-journal/flash_journal.h"
+
+static const uint32_t LOG_FLASH_JOURNAL_HEADER_MAGIC   = 0xCEA10C6EUL;
+static const uint32_t LOG_FLASH_JOURNAL_HEADER_VERSION = 1;
+static const uint32_t LOG_FLASH_JOURNAL_SECTOR_MAGIC   = 0xCE5EC70AUL;
+static const uint32_t LOG_FLASH_JOURNAL_RECORD_MAGIC   = 0xCE7EC0D0UL;
+static const uint32_t LOG_FLASH_JOURNAL_VERSION        = 1;
+
+#define LOG_FLASH_JOURNAL_MIN_SECTORS       5   /**< sectors needed besides the one holding the journal header */
+#define LOG_FLASH_JOURNAL_MAX_PROGRAM_UNIT  128 /**< metadata is staged in buffers of this size */
+#define LOG_FLASH_JOURNAL_INVALID_SECTOR    0xFFFFFFFFUL
+
+typedef enum {
+    LOG_JOURNAL_STATE_NOT_INITIALIZED,
+    LOG_JOURNAL_STATE_INITIALIZED,
+    LOG_JOURNAL_STATE_LOGGING,
+} LogFlashJournalState_t;
+
+typedef enum {
+    LOG_JOURNAL_RECORD_DATA   = 1, /**< payload is a chunk of the blob being logged. */
+    LOG_JOURNAL_RECORD_COMMIT = 2, /**< payload is the LogFlashJournalSummary_t of the blob being committed. */
+} LogFlashJournalRecordType_t;
+
+/**
+ * Header placed in the first sector of the journal, written once by format().
+ */
+typedef struct _LogFlashJournalHeader {
+    FlashJournalHeader_t genericHeader; /** Generic meta-data placed at the head of a Journal; common to all journal types. */
+    uint32_t             magic;         /** Log journal header specific magic code. */
+    uint32_t             version;       /** Revision number for this log journal header. */
+    uint32_t             numSectors;    /** Number of sectors following the journal header. */
+    uint32_t             sizeofSector;  /** Sector size; a multiple of the erase unit of every storage block. */
+} LogFlashJournalHeader_t;
+
+/**
+ * Location of a committed blob. A blob is a run of DATA records followed by a
+ * COMMIT record. The sectors holding it carry consecutive sequence numbers,
+ * from 'startSequence' to 'endSequence'.
+ */
+typedef struct _LogFlashJournalSummary {
+    uint32_t blobSequence;  /**< sequence number of the blob; incremented by every commit. */
+    uint32_t sizeofBlob;    /**< size of the blob; 0 if the journal is empty. */
+    uint32_t startSector;   /**< index of the sector holding the first DATA record. */
+    uint32_t startOffset;   /**< offset of the first DATA record within its sector. */
+    uint32_t startSequence; /**< sequence number of the sector holding the first DATA record. */
+    uint32_t endSequence;   /**< sequence number of the sector holding the COMMIT record. */
+} LogFlashJournalSummary_t;
+
+/**
+ * Meta-data placed at the start of every sector. It is written when the sector
+ * is put into use, right after it is erased.
+ */
+typedef struct _LogFlashJournalSectorHeader {
+    uint32_t                 magic;
+    uint32_t                 version;
+    uint32_t                 sequenceNumber; /**< incremented every time a sector is put into use. */
+    LogFlashJournalSummary_t summary;        /**< the committed blob at the time the sector was put into use. */
+    uint32_t                 crc32;          /**< CRC over the header; taken to be 0 for the purpose of computing the CRC. */
+} LogFlashJournalSectorHeader_t;
+
+/**
+ * Meta-data placed at the start of every record. The header is padded to
+ * program_unit so that the payload which follows it can be programmed straight
+ * from the caller's buffer.
+ *
+ * @note headerCrc32 only covers the header. A record whose header checks out
+ *     but whose payload was cut short by a power failure is skipped over; what
+ *     follows it is still erased and can be appended to.
+ */
+typedef struct _LogFlashJournalRecordHeader {
+    uint32_t magic;
+    uint16_t type;          /**< one of LogFlashJournalRecordType_t. */
+    uint16_t reserved;
+    uint32_t blobSequence;  /**< the blob this record belongs to. */
+    uint32_t size;          /**< size of the payload. */
+    uint32_t payloadCrc32;  /**< CRC over the payload. */
+    uint32_t headerCrc32;   /**< CRC over the preceding fields of the header. */
+} LogFlashJournalRecordHeader_t;
+
+typedef struct _LogFlashJournal_t {
+    FlashJournal_Ops_t        ops;                /**< the mandatory OPS table defining the strategy. */
+    FlashJournal_Callback_t   callback;           /**< command completion callback. */
+    FlashJournal_Info_t       info;               /**< the info structure returned from GetInfo(). */
+    ARM_DRIVER_STORAGE       *mtd;                /**< The underlying Memory-Technology-Device. */
+    uint64_t                  firstSectorOffset;  /**< storage address of the first sector. */
+    uint32_t                  sizeofSector;       /**< sector size; a multiple of the erase unit. */
+    uint32_t                  numSectors;         /**< number of sectors in the log. */
+    uint8_t                   erasedValue;        /**< value of erased bytes. */
+    LogFlashJournalState_t    state;              /**< state of the journal. LOG_JOURNAL_STATE_INITIALIZED being the default. */
+    FlashJournal_OpCode_t     prevCommand;        /**< the last command issued to the journal. */
+    LogFlashJournalSummary_t  committed;          /**< location of the most recently committed blob. */
+    uint32_t                  headSector;         /**< index of the sector being appended to; LOG_FLASH_JOURNAL_INVALID_SECTOR if none. */
+    uint32_t                  headSequence;       /**< sequence number of the head sector. */
+    uint32_t                  tail;               /**< offset within the head sector at which the next record is written. */
+
+    /**
+     * The following is a union of sub-structures meant to keep state relevant
+     * to the commands during their execution.
+     */
+    union {
+        /** state relevant to logging of data. The blob is located by a summary
+         *  which becomes the committed one upon commit(). */
+        LogFlashJournalSummary_t log;
+
+        /** state relevant to read-back of data. */
+        struct {
+            uint32_t sector;             /**< index of the sector being read. */
+            uint32_t sequence;           /**< sequence number of the sector being read. */
+            uint32_t offset;             /**< offset within the sector from which the next read occurs. */
+            uint32_t amountLeftInRecord; /**< payload left in the current DATA record. */
+            uint32_t payloadCrc32;       /**< expected CRC over the payload of the current DATA record. */
+            uint32_t crc32;              /**< CRC over the payload of the current DATA record read so far. */
+            size_t   logicalOffset;      /**< the logical offset within the blob at which the next read will occur. */
+        } read;
+    };
+} LogFlashJournal_t;
+
+/**<
+ * A static assert to ensure that the size of LogFlashJournal_t is smaller than
+ * FlashJournal_t. The caller will only allocate a FlashJournal_t and expect the
+ * Log Strategy to reuse that space for a LogFlashJournal_t.
+ */
+typedef char AssertLogJournalSizeLessThanOrEqualToGenericJournal[sizeof(LogFlashJournal_t)<=sizeof(FlashJournal_t)?1:-1];
+
+#define LOG_SECTOR_ADDRESS(JOURNAL, INDEX) ((JOURNAL)->firstSectorOffset + ((uint64_t)(INDEX) * (JOURNAL)->sizeofSector))
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif /* __FLASH_JOURNAL_LOG_PRIVATE_H__ */
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2006-2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __FLASH_JOURNAL_STRATEGY_LOG_H__
+#define __FLASH_JOURNAL_STRATEGY_LOG_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "flash-journal/flash_journal.h"
+
+/**
+ * Create/format a log-structured flash journal spanning a storage device.
+ *
+ * This function must be called *once* for each incarnation of a log
+ * journal. It erases the entire storage.
+ *
+ * The first erase-sector of the storage holds the journal header. The
+ * remaining sectors are used round-robin as an append-only log of records.
+ * Every sector starts with a small header carrying a sequence number and a
+ * summary of the most recently committed blob; initialization reads only these
+ * sector headers and the records of the newest sector, so its cost doesn't
+ * grow with the size of the journaled blob. Sectors are recycled oldest first,
+ * skipping those which still hold the committed blob, which spreads erases
+ * evenly across the storage.
+ *
+ *     +-------------------------------+    ^
+ *     |                               |    |
+ *     |  Journal header               |    |
+ *     |                               |    |
+ *     +-------------------------------+    |
+ *     | sector header (seq, summary)  |    |
+ *     | DATA record | DATA record ... |    |
+ *     | COMMIT record | <erased>      |    |
+ *     +-------------------------------+    |
+ *     | sector header (seq, summary)  |    |
+ *     | DATA record | COMMIT record   |    |
+ *     | DATA record | <erased>        |    | MTD total_storage
+ *     +-------------------------------+    |
+ *     |                               |    |
+ *     |            ...                |    |
+ *     |                               |    |
+ *     +-------------------------------+    V
+ *
+ * @param[in] mtd
+ *              The underlying Storage driver. The storage must span at least
+ *              6 erase-sectors.
+ *
+ * @param[in] callback
+ *                Caller-defined callback. The log strategy drives the
+ *                storage synchronously, waiting for the completion of
+ *                asynchronous storage operations, so this callback is never
+ *                invoked. It is accepted for symmetry with other strategies.
+ *
+ * @return
+ *   1 upon successful (synchronous) completion, or an appropriate error code.
+ *
+ * @note The operations of FLASH_JOURNAL_STRATEGY_LOG also always complete
+ *     synchronously: they return 1 (or the amount of data transferred) upon
+ *     success and never rely on the completion callback.
+ */
+int32_t flashJournalStrategyLog_format(ARM_DRIVER_STORAGE      *mtd,
+                                       FlashJournal_Callback_t  callback);
+
+int32_t               flashJournalStrategyLog_initialize(FlashJournal_t           *journal,
+                                                         ARM_DRIVER_STORAGE       *mtd,
+                                                         const FlashJournal_Ops_t *ops,
+                                                         FlashJournal_Callback_t   callback);
+FlashJournal_Status_t flashJournalStrategyLog_getInfo(FlashJournal_t *journal, FlashJournal_Info_t *info);
+int32_t               flashJournalStrategyLog_read(FlashJournal_t *journal, void *blob, size_t n);
+int32_t               flashJournalStrategyLog_readFrom(FlashJournal_t *journal, size_t offset, void *blob, size_t n);
+int32_t               flashJournalStrategyLog_log(FlashJournal_t *journal, const void *blob, size_t n);
+int32_t               flashJournalStrategyLog_commit(FlashJournal_t *journal);
+int32_t               flashJournalStrategyLog_reset(FlashJournal_t *journal);
+
+static const FlashJournal_Ops_t FLASH_JOURNAL_STRATEGY_LOG = {
+    flashJournalStrategyLog_initialize,
+    flashJournalStrategyLog_getInfo,
+    flashJournalStrategyLog_read,
+    flashJournalStrategyLog_readFrom,
+    flashJournalStrategyLog_log,
+    flashJournalStrategyLog_commit,
+    flashJournalStrategyLog_reset
+};
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif /* __FLASH_JOURNAL_STRATEGY_LOG_H__ */
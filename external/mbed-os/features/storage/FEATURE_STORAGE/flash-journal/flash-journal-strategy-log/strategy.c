@@ -0,0 +1,974 @@
+/*
+ * Copyright (c) 2006-2016, ARM Limited, All Rights Reserved
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flash-journal-strategy-log/flash_journal_log_crc.h"
+#include "flash-journal-strategy-log/flash_journal_log_private.h"
+#include "flash-journal-strategy-log/flash_journal_strategy_log.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * The log strategy drives the MTD synchronously. When the MTD completes an
+ * operation asynchronously we wait for its completion callback, which records
+ * the outcome here.
+ */
+static volatile int32_t  mtdCompletionStatus;
+static volatile uint32_t mtdCompletionPending;
+
+/*
+ * forward declarations of static-inline helper functions.
+ */
+static inline uint32_t logRoundUp_uint32(uint32_t N, uint32_t BOUNDARY);
+static inline uint32_t logRoundDown_uint32(uint32_t N, uint32_t BOUNDARY);
+static inline uint32_t sizeofSectorHeader(const LogFlashJournal_t *journal);
+static inline uint32_t sizeofRecordHeader(const LogFlashJournal_t *journal);
+static inline uint32_t sizeofCommitRecord(const LogFlashJournal_t *journal);
+static inline int32_t flashJournalStrategyLog_format_sanityChecks(ARM_DRIVER_STORAGE *mtd, uint64_t *mtdAddrP, uint32_t *sizeofSectorP);
+static inline int32_t flashJournalStrategyLog_read_sanityChecks(LogFlashJournal_t *journal, const void *blob, size_t sizeofBlob);
+static inline int32_t flashJournalStrategyLog_log_sanityChecks(LogFlashJournal_t *journal, const void *blob, size_t sizeofBlob);
+
+static void logMtdHandler(int32_t status, ARM_STORAGE_OPERATION operation)
+{
+    (void)operation;
+
+    mtdCompletionStatus  = status;
+    mtdCompletionPending = 0;
+}
+
+/**
+ * Turn the return value of an MTD operation into its final outcome, waiting
+ * for the completion callback if the operation went asynchronous.
+ * mtdCompletionPending must have been set before the operation was issued.
+ */
+static int32_t mtdWait(ARM_DRIVER_STORAGE *mtd, int32_t rc)
+{
+    if ((rc == ARM_DRIVER_OK) && mtd->GetCapabilities().asynchronous_ops) {
+        while (mtdCompletionPending) {
+            /* wait for logMtdHandler() */
+        }
+        rc = mtdCompletionStatus;
+    }
+
+    return rc;
+}
+
+static int32_t mtdStatusToJournalStatus(int32_t rc)
+{
+    if (rc == ARM_STORAGE_ERROR_RUNTIME_OR_INTEGRITY_FAILURE) {
+        return JOURNAL_STATUS_STORAGE_RUNTIME_OR_INTEGRITY_FAILURE;
+    }
+    return JOURNAL_STATUS_STORAGE_IO_ERROR;
+}
+
+static int32_t mtdInitialize(ARM_DRIVER_STORAGE *mtd)
+{
+    mtdCompletionPending = 1;
+    int32_t rc = mtdWait(mtd, mtd->Initialize(logMtdHandler));
+    if (rc < ARM_DRIVER_OK) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+static int32_t mtdReadData(ARM_DRIVER_STORAGE *mtd, uint64_t addr, void *data, uint32_t size)
+{
+    uint8_t *dst = (uint8_t *)data;
+
+    while (size) {
+        mtdCompletionPending = 1;
+        int32_t rc = mtdWait(mtd, mtd->ReadData(addr, dst, size));
+        if (rc <= ARM_DRIVER_OK) {
+            return mtdStatusToJournalStatus(rc);
+        }
+
+        addr += rc;
+        dst  += rc;
+        size -= rc;
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+static int32_t mtdProgramData(ARM_DRIVER_STORAGE *mtd, uint64_t addr, const void *data, uint32_t size)
+{
+    const uint8_t *src = (const uint8_t *)data;
+
+    while (size) {
+        mtdCompletionPending = 1;
+        int32_t rc = mtdWait(mtd, mtd->ProgramData(addr, src, size));
+        if (rc <= ARM_DRIVER_OK) {
+            return mtdStatusToJournalStatus(rc);
+        }
+
+        addr += rc;
+        src  += rc;
+        size -= rc;
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+static int32_t mtdErase(ARM_DRIVER_STORAGE *mtd, uint64_t addr, uint32_t size)
+{
+    while (size) {
+        mtdCompletionPending = 1;
+        int32_t rc = mtdWait(mtd, mtd->Erase(addr, size));
+        if (rc <= ARM_DRIVER_OK) {
+            return mtdStatusToJournalStatus(rc);
+        }
+
+        addr += rc;
+        size -= rc;
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+static int32_t mtdGetStartAddress(ARM_DRIVER_STORAGE *mtd, uint64_t *startAddrP)
+{
+    ARM_STORAGE_BLOCK mtdBlock;
+    if ((mtd->GetNextBlock(NULL, &mtdBlock)) != ARM_DRIVER_OK) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+    if (!ARM_STORAGE_VALID_BLOCK(&mtdBlock)) {
+        return JOURNAL_STATUS_ERROR;
+    }
+
+    *startAddrP = mtdBlock.addr;
+    return JOURNAL_STATUS_OK;
+}
+
+static bool isErased(const LogFlashJournal_t *journal, const void *data, size_t size)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    while (size--) {
+        if (*p++ != journal->erasedValue) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Program 'size' bytes of metadata, padded with the erased value to a multiple
+ * of program_unit.
+ */
+static int32_t programPadded(LogFlashJournal_t *journal, uint64_t addr, const void *data, uint32_t size)
+{
+    uint8_t buffer[LOG_FLASH_JOURNAL_MAX_PROGRAM_UNIT];
+
+    memset(buffer, journal->erasedValue, sizeof(buffer));
+    memcpy(buffer, data, size);
+    return mtdProgramData(journal->mtd, addr, buffer, logRoundUp_uint32(size, journal->info.program_unit));
+}
+
+/**
+ * Read the header of a sector.
+ *
+ * @return 1 if the sector holds a valid header, 0 if it doesn't (the sector is
+ *     unused or was being put into use when power was lost), or an error.
+ */
+static int32_t readSectorHeader(LogFlashJournal_t *journal, uint32_t index, LogFlashJournalSectorHeader_t *headerP)
+{
+    int32_t rc;
+    if ((rc = mtdReadData(journal->mtd, LOG_SECTOR_ADDRESS(journal, index), headerP, sizeof(LogFlashJournalSectorHeader_t))) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    if ((headerP->magic != LOG_FLASH_JOURNAL_SECTOR_MAGIC) || (headerP->version != LOG_FLASH_JOURNAL_VERSION)) {
+        return 0;
+    }
+    if (flashJournalStrategyLog_crc32(0, headerP, offsetof(LogFlashJournalSectorHeader_t, crc32)) != headerP->crc32) {
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Check whether the sector with the given sequence number holds data which
+ * must be preserved: the committed blob, or the blob being logged.
+ */
+static bool sectorIsLive(const LogFlashJournal_t *journal, uint32_t sequenceNumber)
+{
+    if ((journal->committed.sizeofBlob != 0) &&
+        (sequenceNumber >= journal->committed.startSequence) &&
+        (sequenceNumber <= journal->committed.endSequence)) {
+        return true;
+    }
+    if ((journal->state == LOG_JOURNAL_STATE_LOGGING) &&
+        (journal->log.startSector != LOG_FLASH_JOURNAL_INVALID_SECTOR) &&
+        (sequenceNumber >= journal->log.startSequence)) {
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * Put a new sector into use as the head of the log. The sector is chosen
+ * round-robin: an unused sector if there is one, otherwise the one which was
+ * put into use least recently and doesn't hold live data.
+ */
+static int32_t putNextSectorIntoUse(LogFlashJournal_t *journal)
+{
+    int32_t rc;
+    LogFlashJournalSectorHeader_t header;
+    uint32_t chosenSector   = LOG_FLASH_JOURNAL_INVALID_SECTOR;
+    uint32_t chosenSequence = 0;
+
+    for (uint32_t i = 0; i < journal->numSectors; i++) {
+        uint32_t index = (journal->headSector == LOG_FLASH_JOURNAL_INVALID_SECTOR) ? i : (journal->headSector + 1 + i) % journal->numSectors;
+        if (index == journal->headSector) {
+            continue;
+        }
+
+        if ((rc = readSectorHeader(journal, index, &header)) < JOURNAL_STATUS_OK) {
+            return rc;
+        }
+        if (rc == 0) {
+            chosenSector = index; /* unused */
+            break;
+        }
+        if (sectorIsLive(journal, header.sequenceNumber)) {
+            continue;
+        }
+        if ((chosenSector == LOG_FLASH_JOURNAL_INVALID_SECTOR) || (header.sequenceNumber < chosenSequence)) {
+            chosenSector   = index;
+            chosenSequence = header.sequenceNumber;
+        }
+    }
+    if (chosenSector == LOG_FLASH_JOURNAL_INVALID_SECTOR) {
+        return JOURNAL_STATUS_BOUNDED_CAPACITY; /* every other sector holds live data. */
+    }
+
+    if ((rc = mtdErase(journal->mtd, LOG_SECTOR_ADDRESS(journal, chosenSector), journal->sizeofSector)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.magic          = LOG_FLASH_JOURNAL_SECTOR_MAGIC;
+    header.version        = LOG_FLASH_JOURNAL_VERSION;
+    header.sequenceNumber = journal->headSequence + 1;
+    header.summary        = journal->committed;
+    header.crc32          = flashJournalStrategyLog_crc32(0, &header, offsetof(LogFlashJournalSectorHeader_t, crc32));
+    if ((rc = programPadded(journal, LOG_SECTOR_ADDRESS(journal, chosenSector), &header, sizeof(header))) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    journal->headSector   = chosenSector;
+    journal->headSequence = header.sequenceNumber;
+    journal->tail         = sizeofSectorHeader(journal);
+    return JOURNAL_STATUS_OK;
+}
+
+/**
+ * Append a record at the tail of the head sector, which must have room for it.
+ * The header goes first so that a payload cut short by a power failure is
+ * caught by its CRC.
+ */
+static int32_t appendRecord(LogFlashJournal_t *journal, uint16_t type, uint32_t blobSequence, const void *payload, uint32_t size)
+{
+    int32_t rc;
+    uint64_t addr = LOG_SECTOR_ADDRESS(journal, journal->headSector) + journal->tail;
+    uint32_t programUnit = journal->info.program_unit;
+    LogFlashJournalRecordHeader_t header;
+
+    header.magic        = LOG_FLASH_JOURNAL_RECORD_MAGIC;
+    header.type         = type;
+    header.reserved     = 0;
+    header.blobSequence = blobSequence;
+    header.size         = size;
+    header.payloadCrc32 = flashJournalStrategyLog_crc32(0, payload, size);
+    header.headerCrc32  = flashJournalStrategyLog_crc32(0, &header, offsetof(LogFlashJournalRecordHeader_t, headerCrc32));
+
+    /* Whatever happens from here on, the space up to the end of the record is
+     * no longer erased. If programming fails the sector is closed. */
+    uint32_t tail = journal->tail + sizeofRecordHeader(journal) + logRoundUp_uint32(size, programUnit);
+    journal->tail = journal->sizeofSector;
+
+    if ((rc = programPadded(journal, addr, &header, sizeof(header))) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+    addr += sizeofRecordHeader(journal);
+
+    uint32_t aligned = logRoundDown_uint32(size, programUnit);
+    if (aligned && ((rc = mtdProgramData(journal->mtd, addr, payload, aligned)) != JOURNAL_STATUS_OK)) {
+        return rc;
+    }
+    if ((size > aligned) &&
+        ((rc = programPadded(journal, addr + aligned, (const uint8_t *)payload + aligned, size - aligned)) != JOURNAL_STATUS_OK)) {
+        return rc;
+    }
+
+    journal->tail = tail;
+    return JOURNAL_STATUS_OK;
+}
+
+/**
+ * Locate the head of the log and the most recently committed blob.
+ *
+ * The head is the sector with the highest sequence number. Its header holds
+ * the summary of the blob committed when it was put into use; any later
+ * commit has a COMMIT record in the head sector itself. Only the record
+ * headers of the head sector are read, and the payload of COMMIT records.
+ */
+static int32_t mount(LogFlashJournal_t *journal)
+{
+    int32_t rc;
+    LogFlashJournalSectorHeader_t sectorHeader;
+
+    journal->headSector   = LOG_FLASH_JOURNAL_INVALID_SECTOR;
+    journal->headSequence = 0;
+    memset(&journal->committed, 0, sizeof(LogFlashJournalSummary_t));
+    journal->committed.startSector = LOG_FLASH_JOURNAL_INVALID_SECTOR;
+
+    for (uint32_t index = 0; index < journal->numSectors; index++) {
+        if ((rc = readSectorHeader(journal, index, &sectorHeader)) < JOURNAL_STATUS_OK) {
+            return rc;
+        }
+        if ((rc == 1) &&
+            ((journal->headSector == LOG_FLASH_JOURNAL_INVALID_SECTOR) || (sectorHeader.sequenceNumber > journal->headSequence))) {
+            journal->headSector   = index;
+            journal->headSequence = sectorHeader.sequenceNumber;
+            journal->committed    = sectorHeader.summary;
+        }
+    }
+
+    if (journal->headSector == LOG_FLASH_JOURNAL_INVALID_SECTOR) {
+        /* freshly formatted; the first log() or commit() will put a sector into use. */
+        journal->tail = journal->sizeofSector;
+        journal->info.sizeofJournaledBlob = 0;
+        return JOURNAL_STATUS_OK;
+    }
+
+    /* scan the records of the head sector */
+    uint64_t sectorAddr = LOG_SECTOR_ADDRESS(journal, journal->headSector);
+    journal->tail = sizeofSectorHeader(journal);
+    while (journal->tail + sizeofRecordHeader(journal) <= journal->sizeofSector) {
+        LogFlashJournalRecordHeader_t header;
+        if ((rc = mtdReadData(journal->mtd, sectorAddr + journal->tail, &header, sizeof(header))) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+        if (isErased(journal, &header, sizeof(header))) {
+            break; /* end of the log */
+        }
+
+        uint32_t next = journal->tail + sizeofRecordHeader(journal) + logRoundUp_uint32(header.size, journal->info.program_unit);
+        if ((header.magic != LOG_FLASH_JOURNAL_RECORD_MAGIC) ||
+            (flashJournalStrategyLog_crc32(0, &header, offsetof(LogFlashJournalRecordHeader_t, headerCrc32)) != header.headerCrc32) ||
+            (header.size > journal->sizeofSector) ||
+            (next > journal->sizeofSector)) {
+            /* A record header was being programmed when power was lost. Close
+             * the sector; the next record goes into a fresh one. */
+            journal->tail = journal->sizeofSector;
+            break;
+        }
+
+        if ((header.type == LOG_JOURNAL_RECORD_COMMIT) && (header.size == sizeof(LogFlashJournalSummary_t))) {
+            LogFlashJournalSummary_t summary;
+            if ((rc = mtdReadData(journal->mtd, sectorAddr + journal->tail + sizeofRecordHeader(journal), &summary, sizeof(summary))) != JOURNAL_STATUS_OK) {
+                return rc;
+            }
+            if ((flashJournalStrategyLog_crc32(0, &summary, sizeof(summary)) == header.payloadCrc32) &&
+                (summary.blobSequence == header.blobSequence)) {
+                journal->committed = summary;
+            }
+        }
+
+        journal->tail = next;
+    }
+
+    journal->info.sizeofJournaledBlob = journal->committed.sizeofBlob;
+    return JOURNAL_STATUS_OK;
+}
+
+/**
+ * Advance the read position to the next DATA record of the committed blob,
+ * moving on to the sector put into use after the current one when the current
+ * one holds no further records.
+ */
+static int32_t readNextRecord(LogFlashJournal_t *journal)
+{
+    int32_t rc;
+    LogFlashJournalRecordHeader_t header;
+
+    while (true) {
+        if (journal->read.offset + sizeofRecordHeader(journal) + journal->info.program_unit <= journal->sizeofSector) {
+            if ((rc = mtdReadData(journal->mtd,
+                                  LOG_SECTOR_ADDRESS(journal, journal->read.sector) + journal->read.offset,
+                                  &header,
+                                  sizeof(header))) != JOURNAL_STATUS_OK) {
+                return rc;
+            }
+            if (!isErased(journal, &header, sizeof(header))) {
+                if ((header.magic        != LOG_FLASH_JOURNAL_RECORD_MAGIC)       ||
+                    (flashJournalStrategyLog_crc32(0, &header, offsetof(LogFlashJournalRecordHeader_t, headerCrc32)) != header.headerCrc32) ||
+                    (header.type         != LOG_JOURNAL_RECORD_DATA)              ||
+                    (header.blobSequence != journal->committed.blobSequence)      ||
+                    (header.size         == 0)                                    ||
+                    (header.size          > journal->sizeofSector - journal->read.offset - sizeofRecordHeader(journal))) {
+                    return JOURNAL_STATUS_STORAGE_RUNTIME_OR_INTEGRITY_FAILURE;
+                }
+
+                journal->read.offset            += sizeofRecordHeader(journal);
+                journal->read.amountLeftInRecord = header.size;
+                journal->read.payloadCrc32       = header.payloadCrc32;
+                journal->read.crc32              = 0;
+                return JOURNAL_STATUS_OK;
+            }
+        }
+
+        /* The blob continues in the sector with the next sequence number. */
+        if (journal->read.sequence >= journal->committed.endSequence) {
+            return JOURNAL_STATUS_STORAGE_RUNTIME_OR_INTEGRITY_FAILURE;
+        }
+
+        LogFlashJournalSectorHeader_t sectorHeader;
+        uint32_t index;
+        for (index = 0; index < journal->numSectors; index++) {
+            if ((rc = readSectorHeader(journal, index, &sectorHeader)) < JOURNAL_STATUS_OK) {
+                return rc;
+            }
+            if ((rc == 1) && (sectorHeader.sequenceNumber == journal->read.sequence + 1)) {
+                break;
+            }
+        }
+        if (index == journal->numSectors) {
+            return JOURNAL_STATUS_STORAGE_RUNTIME_OR_INTEGRITY_FAILURE;
+        }
+
+        journal->read.sector   = index;
+        journal->read.sequence = sectorHeader.sequenceNumber;
+        journal->read.offset   = sizeofSectorHeader(journal);
+    }
+}
+
+/**
+ * Position the read state at a logical offset within the committed blob.
+ * Whole records preceding the offset are skipped over; the part of the record
+ * holding the offset which precedes it is read so that the CRC of the record
+ * can still be checked.
+ */
+static int32_t readSeek(LogFlashJournal_t *journal, size_t offset)
+{
+    int32_t rc;
+
+    journal->read.sector             = journal->committed.startSector;
+    journal->read.sequence           = journal->committed.startSequence;
+    journal->read.offset             = journal->committed.startOffset;
+    journal->read.amountLeftInRecord = 0;
+    journal->read.logicalOffset      = 0;
+
+    while (true) {
+        if ((rc = readNextRecord(journal)) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+
+        if (offset - journal->read.logicalOffset < journal->read.amountLeftInRecord) {
+            break;
+        }
+        journal->read.logicalOffset      += journal->read.amountLeftInRecord;
+        journal->read.offset             += journal->read.amountLeftInRecord;
+        journal->read.amountLeftInRecord  = 0;
+    }
+
+    uint8_t buffer[64];
+    uint32_t skip = offset - journal->read.logicalOffset;
+    while (skip) {
+        uint32_t xfer = (skip < sizeof(buffer)) ? skip : sizeof(buffer);
+        if ((rc = mtdReadData(journal->mtd,
+                              LOG_SECTOR_ADDRESS(journal, journal->read.sector) + journal->read.offset,
+                              buffer,
+                              xfer)) != JOURNAL_STATUS_OK) {
+            return rc;
+        }
+        journal->read.crc32               = flashJournalStrategyLog_crc32(journal->read.crc32, buffer, xfer);
+        journal->read.offset             += xfer;
+        journal->read.amountLeftInRecord -= xfer;
+        journal->read.logicalOffset      += xfer;
+        skip                             -= xfer;
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+static int32_t readProgress(LogFlashJournal_t *journal, void *blob, size_t sizeofBlob)
+{
+    int32_t rc;
+    uint8_t *dataBeingRead = (uint8_t *)blob;
+    size_t amountLeftToRead = journal->info.sizeofJournaledBlob - journal->read.logicalOffset;
+    if (amountLeftToRead > sizeofBlob) {
+        amountLeftToRead = sizeofBlob;
+    }
+
+    while (amountLeftToRead) {
+        if ((journal->read.amountLeftInRecord == 0) && ((rc = readNextRecord(journal)) != JOURNAL_STATUS_OK)) {
+            journal->read.logicalOffset = 0;
+            return rc;
+        }
+
+        uint32_t xfer = (amountLeftToRead < journal->read.amountLeftInRecord) ? amountLeftToRead : journal->read.amountLeftInRecord;
+        if ((rc = mtdReadData(journal->mtd,
+                              LOG_SECTOR_ADDRESS(journal, journal->read.sector) + journal->read.offset,
+                              dataBeingRead,
+                              xfer)) != JOURNAL_STATUS_OK) {
+            journal->read.logicalOffset = 0;
+            return rc;
+        }
+        journal->read.crc32               = flashJournalStrategyLog_crc32(journal->read.crc32, dataBeingRead, xfer);
+        journal->read.offset             += xfer;
+        journal->read.amountLeftInRecord -= xfer;
+        journal->read.logicalOffset      += xfer;
+        dataBeingRead                    += xfer;
+        amountLeftToRead                 -= xfer;
+
+        if ((journal->read.amountLeftInRecord == 0) && (journal->read.crc32 != journal->read.payloadCrc32)) {
+            journal->read.logicalOffset = 0;
+            return JOURNAL_STATUS_STORAGE_RUNTIME_OR_INTEGRITY_FAILURE;
+        }
+    }
+
+    return (dataBeingRead - (uint8_t *)blob);
+}
+
+int32_t flashJournalStrategyLog_format(ARM_DRIVER_STORAGE      *mtd,
+                                       FlashJournal_Callback_t  callback)
+{
+    (void)callback; /* format always completes synchronously. */
+
+    int32_t rc;
+    uint64_t mtdAddr;
+    uint32_t sizeofSector;
+    if ((rc = flashJournalStrategyLog_format_sanityChecks(mtd, &mtdAddr, &sizeofSector)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    ARM_STORAGE_INFO mtdInfo;
+    if (mtd->GetInfo(&mtdInfo) < ARM_DRIVER_OK) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+    uint32_t numSectors = (uint32_t)(mtdInfo.total_storage / sizeofSector);
+
+    if ((rc = mtdInitialize(mtd)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+    if ((rc = mtdErase(mtd, mtdAddr, numSectors * sizeofSector)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    uint8_t buffer[LOG_FLASH_JOURNAL_MAX_PROGRAM_UNIT];
+    LogFlashJournalHeader_t header;
+    memset(&header, 0, sizeof(header));
+    header.genericHeader.magic         = FLASH_JOURNAL_HEADER_MAGIC;
+    header.genericHeader.version       = FLASH_JOURNAL_HEADER_VERSION;
+    header.genericHeader.totalSize     = (uint64_t)numSectors * sizeofSector;
+    header.genericHeader.sizeofHeader  = sizeof(LogFlashJournalHeader_t);
+    header.genericHeader.journalOffset = sizeofSector;
+    header.magic                       = LOG_FLASH_JOURNAL_HEADER_MAGIC;
+    header.version                     = LOG_FLASH_JOURNAL_HEADER_VERSION;
+    header.numSectors                  = numSectors - 1;
+    header.sizeofSector                = sizeofSector;
+    header.genericHeader.checksum      = flashJournalStrategyLog_crc32(0, &header, sizeof(header));
+
+    memset(buffer, mtdInfo.erased_value ? 0xFF : 0x00, sizeof(buffer));
+    memcpy(buffer, &header, sizeof(header));
+    if ((rc = mtdProgramData(mtd, mtdAddr, buffer, logRoundUp_uint32(sizeof(header), mtdInfo.program_unit))) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    return 1; /* synchronous completion */
+}
+
+int32_t flashJournalStrategyLog_initialize(FlashJournal_t           *_journal,
+                                           ARM_DRIVER_STORAGE       *mtd,
+                                           const FlashJournal_Ops_t *ops,
+                                           FlashJournal_Callback_t   callback)
+{
+    int32_t rc;
+    LogFlashJournal_t *journal = (LogFlashJournal_t *)_journal;
+
+    memset(journal, 0, sizeof(LogFlashJournal_t));
+    journal->state = LOG_JOURNAL_STATE_NOT_INITIALIZED;
+
+    /* initialize MTD */
+    if ((rc = mtdInitialize(mtd)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+    journal->mtd = mtd;
+
+    uint64_t mtdAddr;
+    if ((rc = mtdGetStartAddress(mtd, &mtdAddr)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+    ARM_STORAGE_INFO mtdInfo;
+    if (mtd->GetInfo(&mtdInfo) != ARM_DRIVER_OK) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+
+    LogFlashJournalHeader_t header;
+    if ((rc = mtdReadData(mtd, mtdAddr, &header, sizeof(header))) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+    if ((header.genericHeader.magic        != FLASH_JOURNAL_HEADER_MAGIC)       ||
+        (header.genericHeader.version      != FLASH_JOURNAL_HEADER_VERSION)     ||
+        (header.genericHeader.sizeofHeader != sizeof(LogFlashJournalHeader_t))  ||
+        (header.magic                      != LOG_FLASH_JOURNAL_HEADER_MAGIC)   ||
+        (header.version                    != LOG_FLASH_JOURNAL_HEADER_VERSION)) {
+        return JOURNAL_STATUS_NOT_FORMATTED;
+    }
+    uint32_t expectedCRC = header.genericHeader.checksum;
+    header.genericHeader.checksum = 0;
+    if (flashJournalStrategyLog_crc32(0, &header, sizeof(header)) != expectedCRC) {
+        return JOURNAL_STATUS_METADATA_ERROR;
+    }
+    if ((header.numSectors < LOG_FLASH_JOURNAL_MIN_SECTORS) ||
+        (header.genericHeader.journalOffset != header.sizeofSector) ||
+        ((uint64_t)(header.numSectors + 1) * header.sizeofSector > mtdInfo.total_storage)) {
+        return JOURNAL_STATUS_METADATA_ERROR;
+    }
+
+    /* initialize the journal structure */
+    memcpy(&journal->ops, ops, sizeof(FlashJournal_Ops_t));
+    journal->callback          = callback;
+    journal->firstSectorOffset = mtdAddr + header.genericHeader.journalOffset;
+    journal->sizeofSector      = header.sizeofSector;
+    journal->numSectors        = header.numSectors;
+    journal->erasedValue       = mtdInfo.erased_value ? 0xFF : 0x00;
+    journal->info.program_unit = mtdInfo.program_unit;
+
+    /* Effective capacity. A blob may need as many sectors as the previous one,
+     * plus the one in which it starts, so each gets (numSectors - 1) / 2 of them.
+     * Every sector holds a DATA record and the last one also a COMMIT record. */
+    uint32_t sectorsPerBlob    = (journal->numSectors - 1) / 2;
+    uint32_t dataPerSector     = logRoundDown_uint32(journal->sizeofSector - sizeofSectorHeader(journal) - sizeofRecordHeader(journal),
+                                                     journal->info.program_unit);
+    journal->info.capacity     = (uint64_t)(sectorsPerBlob - 1) * dataPerSector - sizeofCommitRecord(journal);
+
+    if ((rc = mount(journal)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    journal->state       = LOG_JOURNAL_STATE_INITIALIZED;
+    journal->prevCommand = FLASH_JOURNAL_OPCODE_INITIALIZE;
+    return 1; /* synchronous completion */
+}
+
+FlashJournal_Status_t flashJournalStrategyLog_getInfo(FlashJournal_t *_journal, FlashJournal_Info_t *infoP)
+{
+    LogFlashJournal_t *journal = (LogFlashJournal_t *)_journal;
+
+    memcpy(infoP, &journal->info, sizeof(FlashJournal_Info_t));
+    return JOURNAL_STATUS_OK;
+}
+
+int32_t flashJournalStrategyLog_read(FlashJournal_t *_journal, void *blob, size_t sizeofBlob)
+{
+    LogFlashJournal_t *journal = (LogFlashJournal_t *)_journal;
+
+    if (journal->prevCommand != FLASH_JOURNAL_OPCODE_READ_BLOB) {
+        journal->read.logicalOffset = 0;
+    }
+
+    int32_t rc;
+    if ((rc = flashJournalStrategyLog_read_sanityChecks(journal, blob, sizeofBlob)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    journal->prevCommand = FLASH_JOURNAL_OPCODE_READ_BLOB;
+    if ((journal->read.logicalOffset == 0) && ((rc = readSeek(journal, 0)) != JOURNAL_STATUS_OK)) {
+        return rc;
+    }
+
+    return readProgress(journal, blob, sizeofBlob);
+}
+
+int32_t flashJournalStrategyLog_readFrom(FlashJournal_t *_journal, size_t offset, void *blob, size_t sizeofBlob)
+{
+    LogFlashJournal_t *journal = (LogFlashJournal_t *)_journal;
+
+    journal->read.logicalOffset = offset;
+    int32_t rc;
+    if ((rc = flashJournalStrategyLog_read_sanityChecks(journal, blob, sizeofBlob)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    journal->prevCommand = FLASH_JOURNAL_OPCODE_READ_BLOB;
+    if ((rc = readSeek(journal, offset)) != JOURNAL_STATUS_OK) {
+        journal->read.logicalOffset = 0;
+        return rc;
+    }
+
+    return readProgress(journal, blob, sizeofBlob);
+}
+
+int32_t flashJournalStrategyLog_log(FlashJournal_t *_journal, const void *blob, size_t size)
+{
+    LogFlashJournal_t *journal = (LogFlashJournal_t *)_journal;
+
+    int32_t rc;
+    if ((rc = flashJournalStrategyLog_log_sanityChecks(journal, blob, size)) != JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    if (journal->state != LOG_JOURNAL_STATE_LOGGING) {
+        /* This is the first log in the sequence. The blob starts with the first record written below. */
+        journal->log.blobSequence  = journal->committed.blobSequence + 1;
+        journal->log.sizeofBlob    = 0;
+        journal->log.startSector   = LOG_FLASH_JOURNAL_INVALID_SECTOR;
+        journal->log.startOffset   = 0;
+        journal->log.startSequence = 0;
+        journal->log.endSequence   = 0;
+        journal->state             = LOG_JOURNAL_STATE_LOGGING;
+    }
+    journal->prevCommand = FLASH_JOURNAL_OPCODE_LOG_BLOB;
+
+    const uint8_t *dataBeingLogged = (const uint8_t *)blob;
+    uint32_t amountLeftToLog = logRoundDown_uint32(size, journal->info.program_unit);
+    while (amountLeftToLog) {
+        if ((journal->headSector == LOG_FLASH_JOURNAL_INVALID_SECTOR) ||
+            (journal->tail + sizeofRecordHeader(journal) + journal->info.program_unit > journal->sizeofSector)) {
+            if ((rc = putNextSectorIntoUse(journal)) != JOURNAL_STATUS_OK) {
+                journal->state = LOG_JOURNAL_STATE_INITIALIZED; /* abandon the blob being logged */
+                return rc;
+            }
+        }
+
+        uint32_t room = logRoundDown_uint32(journal->sizeofSector - journal->tail - sizeofRecordHeader(journal), journal->info.program_unit);
+        uint32_t xfer = (amountLeftToLog < room) ? amountLeftToLog : room;
+
+        if (journal->log.startSector == LOG_FLASH_JOURNAL_INVALID_SECTOR) {
+            journal->log.startSector   = journal->headSector;
+            journal->log.startOffset   = journal->tail;
+            journal->log.startSequence = journal->headSequence;
+        }
+        if ((rc = appendRecord(journal, LOG_JOURNAL_RECORD_DATA, journal->log.blobSequence, dataBeingLogged, xfer)) != JOURNAL_STATUS_OK) {
+            journal->state = LOG_JOURNAL_STATE_INITIALIZED; /* abandon the blob being logged */
+            return rc;
+        }
+
+        journal->log.sizeofBlob += xfer;
+        dataBeingLogged         += xfer;
+        amountLeftToLog         -= xfer;
+    }
+
+    return (dataBeingLogged - (const uint8_t *)blob);
+}
+
+int32_t flashJournalStrategyLog_commit(FlashJournal_t *_journal)
+{
+    LogFlashJournal_t *journal = (LogFlashJournal_t *)_journal;
+
+    if (journal == NULL) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+    if (journal->state == LOG_JOURNAL_STATE_NOT_INITIALIZED) {
+        return JOURNAL_STATUS_NOT_INITIALIZED;
+    }
+
+    LogFlashJournalSummary_t summary;
+    if (journal->state == LOG_JOURNAL_STATE_LOGGING) {
+        summary = journal->log;
+    } else {
+        /* commit() without any preceding log() operations commits an empty blob. */
+        memset(&summary, 0, sizeof(summary));
+        summary.blobSequence = journal->committed.blobSequence + 1;
+        summary.startSector  = LOG_FLASH_JOURNAL_INVALID_SECTOR;
+    }
+
+    int32_t rc;
+    if ((journal->headSector == LOG_FLASH_JOURNAL_INVALID_SECTOR) ||
+        (journal->tail + sizeofCommitRecord(journal) > journal->sizeofSector)) {
+        if ((rc = putNextSectorIntoUse(journal)) != JOURNAL_STATUS_OK) {
+            journal->state = LOG_JOURNAL_STATE_INITIALIZED;
+            return rc;
+        }
+    }
+
+    summary.endSequence = journal->headSequence;
+    if ((rc = appendRecord(journal, LOG_JOURNAL_RECORD_COMMIT, summary.blobSequence, &summary, sizeof(summary))) != JOURNAL_STATUS_OK) {
+        journal->state = LOG_JOURNAL_STATE_INITIALIZED;
+        return rc;
+    }
+
+    journal->committed                = summary;
+    journal->info.sizeofJournaledBlob = summary.sizeofBlob;
+    journal->state                    = LOG_JOURNAL_STATE_INITIALIZED;
+    journal->prevCommand              = FLASH_JOURNAL_OPCODE_COMMIT;
+    return 1; /* commit returns 1 upon completion. */
+}
+
+int32_t flashJournalStrategyLog_reset(FlashJournal_t *_journal)
+{
+    LogFlashJournal_t *journal = (LogFlashJournal_t *)_journal;
+
+    if (journal == NULL) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+    if (journal->state == LOG_JOURNAL_STATE_NOT_INITIALIZED) {
+        return JOURNAL_STATUS_NOT_INITIALIZED;
+    }
+
+    /* Any blob being logged is abandoned, and an empty blob is committed in
+     * place of the current one. This takes effect atomically; the sectors
+     * holding older blobs are erased as the log comes round to them. */
+    journal->state = LOG_JOURNAL_STATE_INITIALIZED;
+
+    int32_t rc;
+    if ((rc = flashJournalStrategyLog_commit(_journal)) < JOURNAL_STATUS_OK) {
+        return rc;
+    }
+
+    journal->prevCommand = FLASH_JOURNAL_OPCODE_RESET;
+    return 1;
+}
+
+uint32_t logRoundUp_uint32(uint32_t N, uint32_t BOUNDARY)
+{
+    return ((((N) + (BOUNDARY) - 1) / (BOUNDARY)) * (BOUNDARY));
+}
+
+uint32_t logRoundDown_uint32(uint32_t N, uint32_t BOUNDARY)
+{
+    return (((N) / (BOUNDARY)) * (BOUNDARY));
+}
+
+uint32_t sizeofSectorHeader(const LogFlashJournal_t *journal)
+{
+    return logRoundUp_uint32(sizeof(LogFlashJournalSectorHeader_t), journal->info.program_unit);
+}
+
+uint32_t sizeofRecordHeader(const LogFlashJournal_t *journal)
+{
+    return logRoundUp_uint32(sizeof(LogFlashJournalRecordHeader_t), journal->info.program_unit);
+}
+
+uint32_t sizeofCommitRecord(const LogFlashJournal_t *journal)
+{
+    return sizeofRecordHeader(journal) + logRoundUp_uint32(sizeof(LogFlashJournalSummary_t), journal->info.program_unit);
+}
+
+int32_t flashJournalStrategyLog_format_sanityChecks(ARM_DRIVER_STORAGE *mtd, uint64_t *mtdAddrP, uint32_t *sizeofSectorP)
+{
+    /*
+     * basic parameter checking
+     */
+    if (mtd == NULL) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+
+    ARM_STORAGE_INFO mtdInfo;
+    if (mtd->GetInfo(&mtdInfo) < ARM_DRIVER_OK) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+    if (mtdInfo.total_storage == 0) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+    if ((mtdInfo.program_unit == 0) || (mtdInfo.program_unit > LOG_FLASH_JOURNAL_MAX_PROGRAM_UNIT)) {
+        return JOURNAL_STATUS_PARAMETER; /* metadata couldn't be staged for programming */
+    }
+
+    uint64_t mtdAddr;
+    if (mtdGetStartAddress(mtd, &mtdAddr) < JOURNAL_STATUS_OK) {
+        return JOURNAL_STATUS_STORAGE_API_ERROR;
+    }
+    if ((mtdAddr % mtdInfo.program_unit) != 0) { /* ensure that the journal starts at a programmable unit */
+        return JOURNAL_STATUS_PARAMETER;
+    }
+
+    /* A sector must be erasable on its own in every storage block. */
+    ARM_STORAGE_BLOCK block;
+    uint32_t sizeofSector = 0;
+    for (mtd->GetNextBlock(NULL, &block); ARM_STORAGE_VALID_BLOCK(&block); mtd->GetNextBlock(&block, &block)) {
+        if (!block.attributes.erasable || !block.attributes.programmable) {
+            return JOURNAL_STATUS_PARAMETER;
+        }
+        if (block.attributes.erase_unit > sizeofSector) {
+            sizeofSector = block.attributes.erase_unit;
+        }
+    }
+    for (mtd->GetNextBlock(NULL, &block); ARM_STORAGE_VALID_BLOCK(&block); mtd->GetNextBlock(&block, &block)) {
+        if (((sizeofSector % block.attributes.erase_unit) != 0) ||
+            (((block.addr - mtdAddr) % sizeofSector) != 0)) {
+            return JOURNAL_STATUS_PARAMETER;
+        }
+    }
+    if ((sizeofSector == 0) || (sizeofSector % mtdInfo.program_unit) != 0) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+
+    /* room for the journal header and the log */
+    if (mtdInfo.total_storage / sizeofSector < 1 + LOG_FLASH_JOURNAL_MIN_SECTORS) {
+        return JOURNAL_STATUS_BOUNDED_CAPACITY;
+    }
+
+    /* a sector must hold at least a DATA record and a COMMIT record */
+    uint32_t metadata = logRoundUp_uint32(sizeof(LogFlashJournalSectorHeader_t), mtdInfo.program_unit) +
+                        2 * logRoundUp_uint32(sizeof(LogFlashJournalRecordHeader_t), mtdInfo.program_unit) +
+                        logRoundUp_uint32(sizeof(LogFlashJournalSummary_t), mtdInfo.program_unit);
+    if (sizeofSector <= metadata + mtdInfo.program_unit) {
+        return JOURNAL_STATUS_BOUNDED_CAPACITY;
+    }
+
+    *mtdAddrP      = mtdAddr;
+    *sizeofSectorP = sizeofSector;
+    return JOURNAL_STATUS_OK;
+}
+
+int32_t flashJournalStrategyLog_read_sanityChecks(LogFlashJournal_t *journal, const void *blob, size_t sizeofBlob)
+{
+    if ((journal == NULL) || (blob == NULL) || (sizeofBlob == 0)) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+    if (journal->state == LOG_JOURNAL_STATE_NOT_INITIALIZED) {
+        return JOURNAL_STATUS_NOT_INITIALIZED;
+    }
+    if (journal->state != LOG_JOURNAL_STATE_INITIALIZED) {
+        return JOURNAL_STATUS_ERROR; /* journal is in an un-expected state. */
+    }
+    if ((journal->info.sizeofJournaledBlob == 0) || (journal->read.logicalOffset >= journal->info.sizeofJournaledBlob)) {
+        journal->read.logicalOffset = 0;
+        return JOURNAL_STATUS_EMPTY;
+    }
+
+    return JOURNAL_STATUS_OK;
+}
+
+int32_t flashJournalStrategyLog_log_sanityChecks(LogFlashJournal_t *journal, const void *blob, size_t sizeofBlob)
+{
+    if ((journal == NULL) || (blob == NULL) || (sizeofBlob == 0)) {
+        return JOURNAL_STATUS_PARAMETER;
+    }
+    if (journal->state == LOG_JOURNAL_STATE_NOT_INITIALIZED) {
+        return JOURNAL_STATUS_NOT_INITIALIZED;
+    }
+
+    uint64_t alreadyLogged = (journal->state == LOG_JOURNAL_STATE_LOGGING) ? journal->log.sizeofBlob : 0;
+    if (alreadyLogged + sizeofBlob > journal->info.capacity) {
+        return JOURNAL_STATUS_BOUNDED_CAPACITY; /* adding this log chunk would cause us to exceed capacity. */
+    }
+
+    /* ensure that the request is at least as large as the minimum program unit */
+    if (sizeofBlob < journal->info.program_unit) {
+        return JOURNAL_STATUS_SMALL_LOG_REQUEST;
+    }
+
+    return JOURNAL_STATUS_OK;
+}
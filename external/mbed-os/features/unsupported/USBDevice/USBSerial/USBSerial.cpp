@@ -34,6 +34,23 @@ int USBSerial::_getc() {
 }
 
 
+ssize_t USBSerial::_write_block(const void* buffer, size_t length) {
+    if (!terminal_connected)
+        return length;
+
+    uint8_t * ptr = (uint8_t *)buffer;
+    size_t remaining = length;
+    while (remaining > 0) {
+        uint32_t size = (remaining > MAX_PACKET_SIZE_EPBULK) ? MAX_PACKET_SIZE_EPBULK : remaining;
+        if (!send(ptr, size)) {
+            break;
+        }
+        ptr += size;
+        remaining -= size;
+    }
+    return length - remaining;
+}
+
 bool USBSerial::writeBlock(uint8_t * buf, uint16_t size) {
     if(size > MAX_PACKET_SIZE_EPBULK) {
         return false;
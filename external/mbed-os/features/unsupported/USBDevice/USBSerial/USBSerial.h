@@ -146,6 +146,11 @@ public:
 
 protected:
     virtual bool EPBULK_OUT_callback();
+    /**
+    * Send a block of characters, as many to a packet as fit.
+    * Used by write(), puts and printf.
+    */
+    virtual ssize_t _write_block(const void* buffer, size_t length);
     virtual void lineCodingChanged(int baud, int bits, int parity, int stop){
         if (settingsChangedCallback) {
             settingsChangedCallback(baud, bits, parity, stop);
@@ -116,6 +116,24 @@ void spi_frequency(spi_t *obj, int hz);
  */
 int  spi_master_write(spi_t *obj, int value);
 
+/** Write a block out in master mode and receive a block
+ *
+ *  Sends the larger of tx_length and rx_length 8-bit frames, padding tx_buffer
+ *  with write_fill once it runs out and discarding what is received once
+ *  rx_buffer is full. Targets which can keep their FIFO full across frames
+ *  should implement this; a default built on spi_master_write() is used
+ *  otherwise.
+ *
+ * @param[in] obj        The SPI peripheral to use for sending
+ * @param[in] tx_buffer  The bytes to send, may be NULL if tx_length is zero
+ * @param[in] tx_length  The number of bytes to send
+ * @param[in] rx_buffer  Where to store the bytes received, may be NULL if rx_length is zero
+ * @param[in] rx_length  The number of bytes to receive
+ * @param[in] write_fill The value sent once tx_buffer runs out
+ * @return The number of frames transferred, the larger of tx_length and rx_length
+ */
+int  spi_master_block_write(spi_t *obj, const char *tx_buffer, int tx_length, char *rx_buffer, int rx_length, char write_fill);
+
 /** Check if a value is available to read
  *
  * @param[in] obj The SPI peripheral to check
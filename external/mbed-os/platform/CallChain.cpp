@@ -4,19 +4,6 @@
 
 namespace mbed {
 
-class CallChainLink {
-public:
-    CallChainLink(): cb(), next(NULL) {
-        // No work to do
-    }
-
-    CallChainLink(Callback<void()> &callback): cb(callback), next(NULL) {
-        // No work to do
-    }
-    Callback<void()> cb;
-    CallChainLink * next;
-};
-
 CallChain::CallChain(int size) : _chain(NULL) {
     // No work to do
 }
@@ -26,7 +13,19 @@ CallChain::~CallChain() {
 }
 
 pFunctionPointer_t CallChain::add(Callback<void()> func) {
-    CallChainLink *new_link = new CallChainLink(func);
+    CallChainLink *link = new CallChainLink(func);
+    link->_owned = true;
+    return add(link);
+}
+
+pFunctionPointer_t CallChain::add_front(Callback<void()> func) {
+    CallChainLink *link = new CallChainLink(func);
+    link->_owned = true;
+    return add_front(link);
+}
+
+pFunctionPointer_t CallChain::add(CallChainLink *new_link) {
+    new_link->next = NULL;
     if (NULL == _chain) {
         _chain = new_link;
         return &new_link->cb;
@@ -42,8 +41,7 @@ pFunctionPointer_t CallChain::add(Callback<void()> func) {
     }
 }
 
-pFunctionPointer_t CallChain::add_front(Callback<void()> func) {
-    CallChainLink *link = new CallChainLink(func);
+pFunctionPointer_t CallChain::add_front(CallChainLink *link) {
     link->next = _chain;
     _chain = link;
     return &link->cb;
@@ -67,7 +65,7 @@ pFunctionPointer_t CallChain::get(int idx) const {
         }
         link = link->next;
     }
-    return &link->cb;
+    return link ? &link->cb : NULL;
 }
 
 int CallChain::find(pFunctionPointer_t f) const {
@@ -88,7 +86,10 @@ void CallChain::clear() {
     _chain = NULL;
     while (link != NULL) {
         CallChainLink *temp = link->next;
-        delete link;
+        link->next = NULL;
+        if (link->_owned) {
+            delete link;
+        }
         link = temp;
     }
 }
@@ -97,14 +98,37 @@ bool CallChain::remove(pFunctionPointer_t f) {
     CallChainLink *link = _chain;
     while (link != NULL) {
         if (f == &link->cb) {
-            delete link;
-            return true;
+            return remove(link);
         }
         link = link->next;
     }
     return false;
 }
 
+bool CallChain::remove(CallChainLink *link) {
+    // The chain is walked by call() from interrupts, so it is unlinked with
+    // them masked. Once unmasked no call() can still be on the link, as an
+    // interrupt handler runs to completion before we carry on, and the link
+    // can be freed outside the critical section.
+    bool found = false;
+    core_util_critical_section_enter();
+    CallChainLink **prev = &_chain;
+    while (*prev != NULL) {
+        if (*prev == link) {
+            *prev = link->next;
+            found = true;
+            break;
+        }
+        prev = &(*prev)->next;
+    }
+    core_util_critical_section_exit();
+
+    if (found && link->_owned) {
+        delete link;
+    }
+    return found;
+}
+
 void CallChain::call() {
     CallChainLink *link = _chain;
     while (link != NULL) {
@@ -26,7 +26,8 @@ namespace mbed {
 
 /** Group one or more functions in an instance of a CallChain, then call them in
  * sequence using CallChain::call(). Used mostly by the interrupt chaining code,
- * but can be used for other purposes.
+ * but can be used for other purposes. The chain is a list of CallChainLink,
+ * which can be given to it by the caller to avoid allocating.
  *
  * @Note Synchronization level: Not protected
  *
@@ -63,7 +64,43 @@ namespace mbed {
  */
 
 typedef Callback<void()> *pFunctionPointer_t;
-class CallChainLink;
+
+/** A function in a CallChain, together with the pointer to the next one
+ *
+ *  The add() and add_front() calls which take a function allocate a link for
+ *  it on the heap. A caller which would rather not can give the chain a link
+ *  of its own instead, usually static or a member of the object being called,
+ *  which then stays the caller's and is never deleted by the chain. Such a
+ *  link must outlive its time in the chain and be in only one chain at once.
+ *
+ * Example:
+ * @code
+ * static CallChainLink first_link(first);
+ *
+ * chain.add(&first_link);
+ * @endcode
+ */
+class CallChainLink {
+public:
+    /** Create a link for a function, to be added to a chain
+     *
+     *  @param func (optional) The function to call
+     */
+    CallChainLink(Callback<void()> func = Callback<void()>()) : cb(func), next(NULL), _owned(false) {
+        // No work to do
+    }
+
+    Callback<void()> cb;
+    CallChainLink * next;
+
+private:
+    friend class CallChain;
+    bool _owned;
+
+    /* disallow copy constructor and assignment operators */
+    CallChainLink(const CallChainLink&);
+    CallChainLink & operator = (const CallChainLink&);
+};
 
 class CallChain {
 public:
@@ -132,6 +169,26 @@ public:
         return add_front(callback(obj, method));
     }
 
+    /** Add a link provided by the caller at the end of the chain, without
+     *  allocating
+     *
+     *  @param link the link to add, which must not already be in a chain
+     *
+     *  @returns
+     *  The function object in 'link'
+     */
+    pFunctionPointer_t add(CallChainLink *link);
+
+    /** Add a link provided by the caller at the beginning of the chain,
+     *  without allocating
+     *
+     *  @param link the link to add, which must not already be in a chain
+     *
+     *  @returns
+     *  The function object in 'link'
+     */
+    pFunctionPointer_t add_front(CallChainLink *link);
+
     /** Get the number of functions in the chain
      */
     int size() const;
@@ -158,7 +215,8 @@ public:
      */
     void clear();
 
-    /** Remove a function object from the chain
+    /** Remove a function object from the chain, with the same limits as
+     *  remove(CallChainLink *)
      *
      *  @arg f the function object to remove
      *
@@ -167,6 +225,21 @@ public:
      */
     bool remove(pFunctionPointer_t f);
 
+    /** Remove a link from the chain, which is left to the caller if it was
+     *  added by the caller
+     *
+     *  Safe against call() running from an interrupt, but must not be used
+     *  from one of the chain's own functions or from an interrupt that can
+     *  preempt the one calling the chain, as call() may still be using the
+     *  link when it is freed.
+     *
+     *  @arg link the link to remove
+     *
+     *  @returns
+     *  true if the link was found and removed, false otherwise.
+     */
+    bool remove(CallChainLink *link);
+
     /** Call all the functions in the chain in sequence
      */
     void call();
@@ -22,6 +22,10 @@
 #include "platform/mbed_assert.h"
 #include "platform/mbed_toolchain.h"
 
+#ifndef MBED_CONF_PLATFORM_CALLBACK_INLINE_SIZE
+#define MBED_CONF_PLATFORM_CALLBACK_INLINE_SIZE 0
+#endif
+
 namespace mbed {
 /** \addtogroup platform */
 /** @{*/
@@ -38,7 +42,10 @@ class Callback;
 //
 // These are used to eliminate overloads based on type attributes
 // 1. Does a function object have a call operator
-// 2. Does a function object fit in the available storage
+//
+// Whether a function object fits in the available storage is left to a
+// static assert, which names the setting to raise rather than leaving no
+// matching overload
 //
 // These eliminations are handled cleanly by the compiler and avoid
 // massive and misleading error messages when confronted with an
@@ -56,6 +63,19 @@ namespace detail {
     struct is_type {
         static const bool value = true;
     };
+
+    template <typename T>
+    struct alignment_of {
+        struct test { char c; T t; };
+        static const size_t value = sizeof(test) - sizeof(T);
+    };
+
+    // Words held beside the object pointer of a Callback, so that the two
+    // together take at least MBED_CONF_PLATFORM_CALLBACK_INLINE_SIZE bytes
+    static const size_t callback_storage_words =
+        MBED_CONF_PLATFORM_CALLBACK_INLINE_SIZE > 2 * sizeof(void*)
+            ? (MBED_CONF_PLATFORM_CALLBACK_INLINE_SIZE - 1) / sizeof(void*)
+            : 1;
 }
 
 /** Callback class based on template specialization
@@ -70,7 +90,7 @@ public:
      */
     Callback(R (*func)() = 0) {
         if (!func) {
-            _ops = 0;
+            memset(static_cast<void*>(this), 0, sizeof(Callback));
         } else {
             generate(func);
         }
@@ -80,6 +100,7 @@ public:
      *  @param func     The Callback to attach
      */
     Callback(const Callback<R()> &func) {
+        memset(static_cast<void*>(this), 0, sizeof(Callback));
         if (func._ops) {
             func._ops->move(this, &func);
         }
@@ -160,48 +181,44 @@ public:
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(), &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(const F f, typename detail::enable_if<
-                detail::is_type<R (F::*)() const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)() const, &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)() volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)() volatile, &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(const volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)() const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)() const volatile, &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
@@ -404,7 +421,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -412,8 +429,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(), &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -421,7 +437,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -429,8 +445,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(const F f, typename detail::enable_if<
-                detail::is_type<R (F::*)() const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)() const, &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -438,7 +453,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -446,8 +461,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)() volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)() volatile, &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -455,7 +469,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -463,8 +477,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(const volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)() const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)() const volatile, &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -578,12 +591,14 @@ public:
 private:
     // Stored as pointer to function and pointer to optional object
     // Function pointer is stored as union of possible function types
-    // to garuntee proper size and alignment
+    // to garuntee proper size and alignment, widened by
+    // platform.callback-inline-size to hold larger function objects
     struct _class;
     union {
         void (*_staticfunc)();
         void (*_boundfunc)(_class*);
         void (_class::*_methodfunc)();
+        void *_storage[detail::callback_storage_words];
     } _func;
     void *_obj;
 
@@ -604,7 +619,12 @@ private:
         };
 
         MBED_STATIC_ASSERT(sizeof(Callback) - sizeof(_ops) >= sizeof(F),
-                "Type F must not exceed the size of the Callback class");
+                "Type F must not exceed the size of the Callback class, "
+                "raise platform.callback-inline-size to hold it");
+        MBED_STATIC_ASSERT(detail::alignment_of<F>::value <= detail::alignment_of<Callback>::value,
+                "Type F must not need more alignment than the Callback class");
+        // Cleared so that unused storage compares equal
+        memset(static_cast<void*>(this), 0, sizeof(Callback));
         new (this) F(f);
         _ops = &ops;
     }
@@ -665,7 +685,7 @@ public:
      */
     Callback(R (*func)(A0) = 0) {
         if (!func) {
-            _ops = 0;
+            memset(static_cast<void*>(this), 0, sizeof(Callback));
         } else {
             generate(func);
         }
@@ -675,6 +695,7 @@ public:
      *  @param func     The Callback to attach
      */
     Callback(const Callback<R(A0)> &func) {
+        memset(static_cast<void*>(this), 0, sizeof(Callback));
         if (func._ops) {
             func._ops->move(this, &func);
         }
@@ -755,48 +776,44 @@ public:
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0), &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(const F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0) const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0) const, &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0) volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0) volatile, &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(const volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0) const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0) const volatile, &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
@@ -999,7 +1016,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -1007,8 +1024,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0), &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -1016,7 +1032,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -1024,8 +1040,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(const F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0) const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0) const, &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -1033,7 +1048,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -1041,8 +1056,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0) volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0) volatile, &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -1050,7 +1064,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -1058,8 +1072,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(const volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0) const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0) const volatile, &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -1173,12 +1186,14 @@ public:
 private:
     // Stored as pointer to function and pointer to optional object
     // Function pointer is stored as union of possible function types
-    // to garuntee proper size and alignment
+    // to garuntee proper size and alignment, widened by
+    // platform.callback-inline-size to hold larger function objects
     struct _class;
     union {
         void (*_staticfunc)(A0);
         void (*_boundfunc)(_class*, A0);
         void (_class::*_methodfunc)(A0);
+        void *_storage[detail::callback_storage_words];
     } _func;
     void *_obj;
 
@@ -1199,7 +1214,12 @@ private:
         };
 
         MBED_STATIC_ASSERT(sizeof(Callback) - sizeof(_ops) >= sizeof(F),
-                "Type F must not exceed the size of the Callback class");
+                "Type F must not exceed the size of the Callback class, "
+                "raise platform.callback-inline-size to hold it");
+        MBED_STATIC_ASSERT(detail::alignment_of<F>::value <= detail::alignment_of<Callback>::value,
+                "Type F must not need more alignment than the Callback class");
+        // Cleared so that unused storage compares equal
+        memset(static_cast<void*>(this), 0, sizeof(Callback));
         new (this) F(f);
         _ops = &ops;
     }
@@ -1260,7 +1280,7 @@ public:
      */
     Callback(R (*func)(A0, A1) = 0) {
         if (!func) {
-            _ops = 0;
+            memset(static_cast<void*>(this), 0, sizeof(Callback));
         } else {
             generate(func);
         }
@@ -1270,6 +1290,7 @@ public:
      *  @param func     The Callback to attach
      */
     Callback(const Callback<R(A0, A1)> &func) {
+        memset(static_cast<void*>(this), 0, sizeof(Callback));
         if (func._ops) {
             func._ops->move(this, &func);
         }
@@ -1350,48 +1371,44 @@ public:
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1), &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(const F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1) const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1) const, &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1) volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1) volatile, &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(const volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1) const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1) const volatile, &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
@@ -1594,7 +1611,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -1602,8 +1619,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1), &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -1611,7 +1627,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -1619,8 +1635,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(const F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1) const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1) const, &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -1628,7 +1643,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -1636,8 +1651,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1) volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1) volatile, &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -1645,7 +1659,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -1653,8 +1667,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(const volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1) const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1) const volatile, &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -1768,12 +1781,14 @@ public:
 private:
     // Stored as pointer to function and pointer to optional object
     // Function pointer is stored as union of possible function types
-    // to garuntee proper size and alignment
+    // to garuntee proper size and alignment, widened by
+    // platform.callback-inline-size to hold larger function objects
     struct _class;
     union {
         void (*_staticfunc)(A0, A1);
         void (*_boundfunc)(_class*, A0, A1);
         void (_class::*_methodfunc)(A0, A1);
+        void *_storage[detail::callback_storage_words];
     } _func;
     void *_obj;
 
@@ -1794,7 +1809,12 @@ private:
         };
 
         MBED_STATIC_ASSERT(sizeof(Callback) - sizeof(_ops) >= sizeof(F),
-                "Type F must not exceed the size of the Callback class");
+                "Type F must not exceed the size of the Callback class, "
+                "raise platform.callback-inline-size to hold it");
+        MBED_STATIC_ASSERT(detail::alignment_of<F>::value <= detail::alignment_of<Callback>::value,
+                "Type F must not need more alignment than the Callback class");
+        // Cleared so that unused storage compares equal
+        memset(static_cast<void*>(this), 0, sizeof(Callback));
         new (this) F(f);
         _ops = &ops;
     }
@@ -1855,7 +1875,7 @@ public:
      */
     Callback(R (*func)(A0, A1, A2) = 0) {
         if (!func) {
-            _ops = 0;
+            memset(static_cast<void*>(this), 0, sizeof(Callback));
         } else {
             generate(func);
         }
@@ -1865,6 +1885,7 @@ public:
      *  @param func     The Callback to attach
      */
     Callback(const Callback<R(A0, A1, A2)> &func) {
+        memset(static_cast<void*>(this), 0, sizeof(Callback));
         if (func._ops) {
             func._ops->move(this, &func);
         }
@@ -1945,48 +1966,44 @@ public:
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2), &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(const F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2) const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2) const, &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2) volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2) volatile, &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(const volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2) const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2) const volatile, &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
@@ -2189,7 +2206,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -2197,8 +2214,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2), &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -2206,7 +2222,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -2214,8 +2230,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(const F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2) const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2) const, &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -2223,7 +2238,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -2231,8 +2246,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2) volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2) volatile, &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -2240,7 +2254,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -2248,8 +2262,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(const volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2) const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2) const volatile, &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -2363,12 +2376,14 @@ public:
 private:
     // Stored as pointer to function and pointer to optional object
     // Function pointer is stored as union of possible function types
-    // to garuntee proper size and alignment
+    // to garuntee proper size and alignment, widened by
+    // platform.callback-inline-size to hold larger function objects
     struct _class;
     union {
         void (*_staticfunc)(A0, A1, A2);
         void (*_boundfunc)(_class*, A0, A1, A2);
         void (_class::*_methodfunc)(A0, A1, A2);
+        void *_storage[detail::callback_storage_words];
     } _func;
     void *_obj;
 
@@ -2389,7 +2404,12 @@ private:
         };
 
         MBED_STATIC_ASSERT(sizeof(Callback) - sizeof(_ops) >= sizeof(F),
-                "Type F must not exceed the size of the Callback class");
+                "Type F must not exceed the size of the Callback class, "
+                "raise platform.callback-inline-size to hold it");
+        MBED_STATIC_ASSERT(detail::alignment_of<F>::value <= detail::alignment_of<Callback>::value,
+                "Type F must not need more alignment than the Callback class");
+        // Cleared so that unused storage compares equal
+        memset(static_cast<void*>(this), 0, sizeof(Callback));
         new (this) F(f);
         _ops = &ops;
     }
@@ -2450,7 +2470,7 @@ public:
      */
     Callback(R (*func)(A0, A1, A2, A3) = 0) {
         if (!func) {
-            _ops = 0;
+            memset(static_cast<void*>(this), 0, sizeof(Callback));
         } else {
             generate(func);
         }
@@ -2460,6 +2480,7 @@ public:
      *  @param func     The Callback to attach
      */
     Callback(const Callback<R(A0, A1, A2, A3)> &func) {
+        memset(static_cast<void*>(this), 0, sizeof(Callback));
         if (func._ops) {
             func._ops->move(this, &func);
         }
@@ -2540,48 +2561,44 @@ public:
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2, A3), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2, A3), &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(const F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2, A3) const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2, A3) const, &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2, A3) volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2, A3) volatile, &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(const volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2, A3) const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2, A3) const volatile, &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
@@ -2784,7 +2801,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -2792,8 +2809,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2, A3), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2, A3), &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -2801,7 +2817,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -2809,8 +2825,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(const F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2, A3) const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2, A3) const, &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -2818,7 +2833,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -2826,8 +2841,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2, A3) volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2, A3) volatile, &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -2835,7 +2849,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -2843,8 +2857,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(const volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2, A3) const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2, A3) const volatile, &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -2958,12 +2971,14 @@ public:
 private:
     // Stored as pointer to function and pointer to optional object
     // Function pointer is stored as union of possible function types
-    // to garuntee proper size and alignment
+    // to garuntee proper size and alignment, widened by
+    // platform.callback-inline-size to hold larger function objects
     struct _class;
     union {
         void (*_staticfunc)(A0, A1, A2, A3);
         void (*_boundfunc)(_class*, A0, A1, A2, A3);
         void (_class::*_methodfunc)(A0, A1, A2, A3);
+        void *_storage[detail::callback_storage_words];
     } _func;
     void *_obj;
 
@@ -2984,7 +2999,12 @@ private:
         };
 
         MBED_STATIC_ASSERT(sizeof(Callback) - sizeof(_ops) >= sizeof(F),
-                "Type F must not exceed the size of the Callback class");
+                "Type F must not exceed the size of the Callback class, "
+                "raise platform.callback-inline-size to hold it");
+        MBED_STATIC_ASSERT(detail::alignment_of<F>::value <= detail::alignment_of<Callback>::value,
+                "Type F must not need more alignment than the Callback class");
+        // Cleared so that unused storage compares equal
+        memset(static_cast<void*>(this), 0, sizeof(Callback));
         new (this) F(f);
         _ops = &ops;
     }
@@ -3045,7 +3065,7 @@ public:
      */
     Callback(R (*func)(A0, A1, A2, A3, A4) = 0) {
         if (!func) {
-            _ops = 0;
+            memset(static_cast<void*>(this), 0, sizeof(Callback));
         } else {
             generate(func);
         }
@@ -3055,6 +3075,7 @@ public:
      *  @param func     The Callback to attach
      */
     Callback(const Callback<R(A0, A1, A2, A3, A4)> &func) {
+        memset(static_cast<void*>(this), 0, sizeof(Callback));
         if (func._ops) {
             func._ops->move(this, &func);
         }
@@ -3135,48 +3156,44 @@ public:
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2, A3, A4), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2, A3, A4), &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(const F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2, A3, A4) const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2, A3, A4) const, &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2, A3, A4) volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2, A3, A4) volatile, &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
 
     /** Create a Callback with a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      */
     template <typename F>
     Callback(const volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2, A3, A4) const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2, A3, A4) const volatile, &F::operator()>::value
             >::type = detail::nil()) {
         generate(f);
     }
@@ -3379,7 +3396,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -3387,8 +3404,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2, A3, A4), &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2, A3, A4), &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -3396,7 +3412,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -3404,8 +3420,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(const F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2, A3, A4) const, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2, A3, A4) const, &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -3413,7 +3428,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -3421,8 +3436,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2, A3, A4) volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2, A3, A4) volatile, &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -3430,7 +3444,7 @@ public:
 
     /** Attach a function object
      *  @param func     Function object to attach
-     *  @note The function object is limited to a single word of storage
+     *  @note The function object is limited to the storage in a Callback, see platform.callback-inline-size
      *  @deprecated
      *      Replaced by simple assignment 'Callback cb = func'
      */
@@ -3438,8 +3452,7 @@ public:
     MBED_DEPRECATED_SINCE("mbed-os-5.4",
         "Replaced by simple assignment 'Callback cb = func")
     void attach(const volatile F f, typename detail::enable_if<
-                detail::is_type<R (F::*)(A0, A1, A2, A3, A4) const volatile, &F::operator()>::value &&
-                sizeof(F) <= sizeof(uintptr_t)
+                detail::is_type<R (F::*)(A0, A1, A2, A3, A4) const volatile, &F::operator()>::value
             >::type = detail::nil()) {
         this->~Callback();
         new (this) Callback(f);
@@ -3553,12 +3566,14 @@ public:
 private:
     // Stored as pointer to function and pointer to optional object
     // Function pointer is stored as union of possible function types
-    // to garuntee proper size and alignment
+    // to garuntee proper size and alignment, widened by
+    // platform.callback-inline-size to hold larger function objects
     struct _class;
     union {
         void (*_staticfunc)(A0, A1, A2, A3, A4);
         void (*_boundfunc)(_class*, A0, A1, A2, A3, A4);
         void (_class::*_methodfunc)(A0, A1, A2, A3, A4);
+        void *_storage[detail::callback_storage_words];
     } _func;
     void *_obj;
 
@@ -3579,7 +3594,12 @@ private:
         };
 
         MBED_STATIC_ASSERT(sizeof(Callback) - sizeof(_ops) >= sizeof(F),
-                "Type F must not exceed the size of the Callback class");
+                "Type F must not exceed the size of the Callback class, "
+                "raise platform.callback-inline-size to hold it");
+        MBED_STATIC_ASSERT(detail::alignment_of<F>::value <= detail::alignment_of<Callback>::value,
+                "Type F must not need more alignment than the Callback class");
+        // Cleared so that unused storage compares equal
+        memset(static_cast<void*>(this), 0, sizeof(Callback));
         new (this) F(f);
         _ops = &ops;
     }
@@ -17,12 +17,16 @@
 #define MBED_CIRCULARBUFFER_H
 
 #include "platform/mbed_critical.h"
+#include <string.h>
 
 namespace mbed {
 /** \addtogroup platform */
 /** @{*/
 
 /** Templated Circular buffer class
+ *
+ *  For a single producer and a single consumer, SPSCCircularBuffer does the
+ *  same without critical sections.
  *
  *  @Note Synchronization level: Interrupt safe
  */
@@ -54,6 +58,37 @@ public:
         core_util_critical_section_exit();
     }
 
+    /** Push a block of transactions to the buffer. This overwrites the oldest
+     *  transactions if there isn't room for them all, keeping the last
+     *  BufferSize of data if count is larger than the buffer.
+     *
+     *  The block is copied with memcpy in at most two pieces, with interrupts
+     *  disabled, so T must be trivially copyable.
+     *
+     * @param data  Transactions to be pushed to the buffer
+     * @param count Number of transactions to push
+     */
+    void push(const T *data, uint32_t count) {
+        if (count > BufferSize) {
+            data += count - BufferSize;
+            count = BufferSize;
+        }
+        core_util_critical_section_enter();
+        uint32_t used = _used();
+        uint32_t first = BufferSize - _head;
+        if (first > count) {
+            first = count;
+        }
+        memcpy(&_pool[_head], data, first * sizeof(T));
+        memcpy(&_pool[0], data + first, (count - first) * sizeof(T));
+        _head = (_head + count) % BufferSize;
+        if (count > 0 && used + count >= BufferSize) {
+            _tail = _head;
+            _full = true;
+        }
+        core_util_critical_section_exit();
+    }
+
     /** Pop the transaction from the buffer
      *
      * @param data Data to be pushed to the buffer
@@ -72,6 +107,35 @@ public:
         return data_popped;
     }
 
+    /** Pop a block of transactions from the buffer
+     *
+     *  The block is copied with memcpy in at most two pieces, with interrupts
+     *  disabled, so T must be trivially copyable.
+     *
+     * @param data  Where to store the transactions popped
+     * @param count Most transactions to pop
+     * @return The number of transactions popped, less than count if the buffer runs out
+     */
+    uint32_t pop(T *data, uint32_t count) {
+        core_util_critical_section_enter();
+        uint32_t used = _used();
+        if (count > used) {
+            count = used;
+        }
+        uint32_t first = BufferSize - _tail;
+        if (first > count) {
+            first = count;
+        }
+        memcpy(data, &_pool[_tail], first * sizeof(T));
+        memcpy(data + first, &_pool[0], (count - first) * sizeof(T));
+        _tail = (_tail + count) % BufferSize;
+        if (count > 0) {
+            _full = false;
+        }
+        core_util_critical_section_exit();
+        return count;
+    }
+
     /** Check if the buffer is empty
      *
      * @return True if the buffer is empty, false if not
@@ -94,6 +158,17 @@ public:
         return full;
     }
 
+    /** Get the number of transactions in the buffer
+     *
+     * @return The number of transactions waiting to be popped
+     */
+    uint32_t size() {
+        core_util_critical_section_enter();
+        uint32_t used = _used();
+        core_util_critical_section_exit();
+        return used;
+    }
+
     /** Reset the buffer
      *
      */
@@ -106,6 +181,13 @@ public:
     }
 
 private:
+    uint32_t _used() {
+        if (_full) {
+            return BufferSize;
+        }
+        return (_head >= _tail) ? _head - _tail : BufferSize + _head - _tail;
+    }
+
     T _pool[BufferSize];
     volatile CounterType _head;
     volatile CounterType _tail;
@@ -0,0 +1,229 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_SPSCCIRCULARBUFFER_H
+#define MBED_SPSCCIRCULARBUFFER_H
+
+#include <stdint.h>
+#include <string.h>
+#include "platform/mbed_assert.h"
+#if defined(__ICCARM__)
+#include <intrinsics.h>
+#endif
+
+namespace mbed {
+/** \addtogroup platform */
+/** @{*/
+
+/** Templated circular buffer for a single producer and a single consumer
+ *
+ *  Unlike CircularBuffer, no critical sections are used. The producer only
+ *  writes the head index and the consumer only writes the tail index, each
+ *  published with a memory barrier once the data it covers has been copied.
+ *  This makes it safe for one interrupt handler or thread to push while one
+ *  other pops, but not for two of either at once.
+ *
+ *  Pushing to a full buffer fails rather than overwriting the oldest data, as
+ *  only the consumer may move the tail.
+ *
+ *  T must be trivially copyable, as blocks are copied with memcpy, and
+ *  CounterType must be read and written in a single access (uint8_t,
+ *  uint16_t or uint32_t), and must be able to hold BufferSize, as the
+ *  indexes run from 0 to BufferSize.
+ *
+ *  @Note Synchronization level: Interrupt safe for one producer and one consumer
+ */
+template<typename T, uint32_t BufferSize, typename CounterType = uint32_t>
+class SPSCCircularBuffer {
+public:
+    SPSCCircularBuffer() : _head(0), _tail(0) {
+        MBED_STATIC_ASSERT(Slots - 1 <= (CounterType)-1,
+                "CounterType is too small to index all of the buffer's slots");
+    }
+
+    ~SPSCCircularBuffer() {
+    }
+
+    /** Push the transaction to the buffer. Producer only.
+     *
+     * @param data Data to be pushed to the buffer
+     * @return True if the data was pushed, false if the buffer is full
+     */
+    bool push(const T& data) {
+        CounterType head = _head;
+        CounterType next = _next(head, 1);
+        if (next == _load_acquire(_tail)) {
+            return false;
+        }
+        _pool[head] = data;
+        _store_release(_head, next);
+        return true;
+    }
+
+    /** Push a block of transactions to the buffer, as many as fit. Producer only.
+     *
+     *  The block is copied in at most two pieces.
+     *
+     * @param data  Transactions to be pushed to the buffer
+     * @param count Number of transactions to push
+     * @return The number of transactions pushed, less than count if the buffer fills
+     */
+    uint32_t push(const T *data, uint32_t count) {
+        CounterType head = _head;
+        uint32_t space = BufferSize - _used(head, _load_acquire(_tail));
+        if (count > space) {
+            count = space;
+        }
+        uint32_t first = Slots - head;
+        if (first > count) {
+            first = count;
+        }
+        memcpy(&_pool[head], data, first * sizeof(T));
+        memcpy(&_pool[0], data + first, (count - first) * sizeof(T));
+        _store_release(_head, _next(head, count));
+        return count;
+    }
+
+    /** Pop the transaction from the buffer. Consumer only.
+     *
+     * @param data Data popped from the buffer
+     * @return True if the buffer is not empty and data contains a transaction, false otherwise
+     */
+    bool pop(T& data) {
+        CounterType tail = _tail;
+        if (tail == _load_acquire(_head)) {
+            return false;
+        }
+        data = _pool[tail];
+        _store_release(_tail, _next(tail, 1));
+        return true;
+    }
+
+    /** Pop a block of transactions from the buffer. Consumer only.
+     *
+     *  The block is copied in at most two pieces.
+     *
+     * @param data  Where to store the transactions popped
+     * @param count Most transactions to pop
+     * @return The number of transactions popped, less than count if the buffer runs out
+     */
+    uint32_t pop(T *data, uint32_t count) {
+        CounterType tail = _tail;
+        uint32_t used = _used(_load_acquire(_head), tail);
+        if (count > used) {
+            count = used;
+        }
+        uint32_t first = Slots - tail;
+        if (first > count) {
+            first = count;
+        }
+        memcpy(data, &_pool[tail], first * sizeof(T));
+        memcpy(data + first, &_pool[0], (count - first) * sizeof(T));
+        _store_release(_tail, _next(tail, count));
+        return count;
+    }
+
+    /** Check if the buffer is empty
+     *
+     *  Only certain when called by the consumer, as the producer may push at any time.
+     *
+     * @return True if the buffer is empty, false if not
+     */
+    bool empty() const {
+        return _load_acquire(_head) == _load_acquire(_tail);
+    }
+
+    /** Check if the buffer is full
+     *
+     *  Only certain when called by the producer, as the consumer may pop at any time.
+     *
+     * @return True if the buffer is full, false if not
+     */
+    bool full() const {
+        return size() == BufferSize;
+    }
+
+    /** Get the number of transactions in the buffer
+     *
+     * @return The number of transactions waiting to be popped
+     */
+    uint32_t size() const {
+        return _used(_load_acquire(_head), _load_acquire(_tail));
+    }
+
+    /** Reset the buffer
+     *
+     *  Must not be called while either side may be using the buffer.
+     */
+    void reset() {
+        _store_release(_tail, 0);
+        _store_release(_head, 0);
+    }
+
+private:
+    // One slot is always left empty so that a full buffer can be told from
+    // an empty one using nothing but the two indexes
+    static const uint32_t Slots = BufferSize + 1;
+
+    static CounterType _next(CounterType index, uint32_t count) {
+        uint32_t next = index + count;
+        return (CounterType)((next >= Slots) ? next - Slots : next);
+    }
+
+    static uint32_t _used(CounterType head, CounterType tail) {
+        return (head >= tail) ? head - tail : Slots + head - tail;
+    }
+
+    // The data accesses after an index load must not move ahead of it, and
+    // the data accesses before an index store must not move after it
+#if defined(__GNUC__) && !defined(__CC_ARM)
+    static CounterType _load_acquire(const volatile CounterType &index) {
+        return __atomic_load_n(&index, __ATOMIC_ACQUIRE);
+    }
+
+    static void _store_release(volatile CounterType &index, CounterType value) {
+        __atomic_store_n(&index, value, __ATOMIC_RELEASE);
+    }
+#else
+    static void _barrier() {
+#if defined(__CC_ARM)
+        __dmb(0xF);
+#else
+        __DMB();
+#endif
+    }
+
+    static CounterType _load_acquire(const volatile CounterType &index) {
+        CounterType value = index;
+        _barrier();
+        return value;
+    }
+
+    static void _store_release(volatile CounterType &index, CounterType value) {
+        _barrier();
+        index = value;
+    }
+#endif
+
+    T _pool[Slots];
+    volatile CounterType _head;
+    volatile CounterType _tail;
+};
+
+}
+
+#endif
+
+/** @}*/
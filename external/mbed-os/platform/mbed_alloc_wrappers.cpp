@@ -16,6 +16,7 @@
 
 #include "platform/mbed_mem_trace.h"
 #include "platform/mbed_stats.h"
+#include "platform/mbed_tlsf.h"
 #include "platform/mbed_toolchain.h"
 #include "platform/SingletonPtr.h"
 #include "platform/PlatformMutex.h"
@@ -34,7 +35,141 @@
 
 Both tracers can be activated and deactivated in any combination. If both tracers
 are active, the second one (MBED_MEM_TRACING_ENABLED) will trace the first one's
-(MBED_HEAP_STATS_ENABLED) memory calls.*/
+(MBED_HEAP_STATS_ENABLED) memory calls.
+
+With GCC, the platform.tlsf-heap option replaces newlib's allocator under
+both of them with the TLSF allocator in mbed_tlsf.c.*/
+
+#ifndef MBED_CONF_PLATFORM_TLSF_HEAP
+#define MBED_CONF_PLATFORM_TLSF_HEAP            0
+#endif
+
+#ifndef MBED_CONF_PLATFORM_TLSF_HEAP_GROW_SIZE
+#define MBED_CONF_PLATFORM_TLSF_HEAP_GROW_SIZE  4096
+#endif
+
+#if MBED_CONF_PLATFORM_TLSF_HEAP && !defined(TOOLCHAIN_GCC)
+#warning The TLSF heap is only supported with GCC.
+#undef MBED_CONF_PLATFORM_TLSF_HEAP
+#define MBED_CONF_PLATFORM_TLSF_HEAP            0
+#endif
+
+#if MBED_CONF_PLATFORM_TLSF_HEAP && defined(FEATURE_UVISOR)
+#error "platform.tlsf-heap can't be used with uVisor"
+#endif
+
+/******************************************************************************/
+/* TLSF heap                                                                  */
+/******************************************************************************/
+
+#if MBED_CONF_PLATFORM_TLSF_HEAP
+
+/* The TLSF pools are taken from _sbrk() as they are needed, so the heap grows
+   through the same memory newlib's would. Every pool but the first normally
+   follows on from the last and is joined onto it. Calls are serialised by the
+   same lock that newlib takes around its own allocator. Newlib functions
+   which look inside its heap, like memalign() and malloc_usable_size(), can't
+   be used on blocks from this one. */
+extern "C" {
+    void *_sbrk(int incr);
+    void __malloc_lock(struct _reent * r);
+    void __malloc_unlock(struct _reent * r);
+}
+
+static mbed_tlsf_t tlsf_heap;
+
+static bool tlsf_heap_grow(size_t size)
+{
+    size_t grow = mbed_tlsf_pool_size_for(size);
+    if (grow == 0) {
+        return false;
+    }
+    if (grow < MBED_CONF_PLATFORM_TLSF_HEAP_GROW_SIZE) {
+        grow = MBED_CONF_PLATFORM_TLSF_HEAP_GROW_SIZE;
+    }
+    grow = (grow + MBED_TLSF_ALIGN - 1) & ~(size_t)(MBED_TLSF_ALIGN - 1);
+
+    // Start on an alignment boundary so that the next pool joins onto this one
+    size_t pad = (0 - (uintptr_t)_sbrk(0)) & (MBED_TLSF_ALIGN - 1);
+    if (grow + pad > INT32_MAX) {
+        return false;
+    }
+    char *mem = (char *)_sbrk((int)(grow + pad));
+    if (mem == (char *)-1) {
+        return false;
+    }
+    return mbed_tlsf_add_pool(&tlsf_heap, mem + pad, grow) == 0;
+}
+
+static void *heap_malloc(struct _reent * r, size_t size)
+{
+    __malloc_lock(r);
+    void *ptr = mbed_tlsf_malloc(&tlsf_heap, size);
+    if (ptr == NULL && tlsf_heap_grow(size)) {
+        ptr = mbed_tlsf_malloc(&tlsf_heap, size);
+    }
+    __malloc_unlock(r);
+    return ptr;
+}
+
+static void *heap_realloc(struct _reent * r, void * ptr, size_t size)
+{
+    __malloc_lock(r);
+    void *new_ptr = mbed_tlsf_realloc(&tlsf_heap, ptr, size);
+    if (new_ptr == NULL && size != 0 && tlsf_heap_grow(size)) {
+        new_ptr = mbed_tlsf_realloc(&tlsf_heap, ptr, size);
+    }
+    __malloc_unlock(r);
+    return new_ptr;
+}
+
+static void heap_free(struct _reent * r, void * ptr)
+{
+    __malloc_lock(r);
+    mbed_tlsf_free(&tlsf_heap, ptr);
+    __malloc_unlock(r);
+}
+
+static void *heap_calloc(struct _reent * r, size_t nmemb, size_t size)
+{
+    if (size != 0 && nmemb > SIZE_MAX / size) {
+        return NULL;
+    }
+    void *ptr = heap_malloc(r, nmemb * size);
+    if (ptr != NULL) {
+        memset(ptr, 0, nmemb * size);
+    }
+    return ptr;
+}
+
+static void heap_get_free(mbed_stats_heap_t *stats)
+{
+    mbed_tlsf_stats_t tlsf_stats;
+
+    __malloc_lock(_REENT);
+    mbed_tlsf_get_stats(&tlsf_heap, &tlsf_stats);
+    __malloc_unlock(_REENT);
+
+    stats->free_size = tlsf_stats.free_size;
+    stats->largest_free_size = tlsf_stats.largest_free_size;
+}
+
+int mbed_heap_check(void)
+{
+    __malloc_lock(_REENT);
+    int result = mbed_tlsf_check(&tlsf_heap);
+    __malloc_unlock(_REENT);
+    return result;
+}
+
+#else // #if MBED_CONF_PLATFORM_TLSF_HEAP
+
+int mbed_heap_check(void)
+{
+    return 0;
+}
+
+#endif // #if MBED_CONF_PLATFORM_TLSF_HEAP
 
 /******************************************************************************/
 /* Implementation of the runtime max heap usage checker                       */
@@ -66,6 +201,9 @@ void mbed_stats_heap_get(mbed_stats_heap_t *stats)
 #else
     memset(stats, 0, sizeof(mbed_stats_heap_t));
 #endif
+#if MBED_CONF_PLATFORM_TLSF_HEAP
+    heap_get_free(stats);
+#endif
 }
 
 /******************************************************************************/
@@ -78,6 +216,7 @@ void mbed_stats_heap_get(mbed_stats_heap_t *stats)
 #include "uvisor-lib/uvisor-lib.h"
 #endif/* FEATURE_UVISOR */
 
+#if !MBED_CONF_PLATFORM_TLSF_HEAP
 extern "C" {
     void * __real__malloc_r(struct _reent * r, size_t size);
     void * __real__realloc_r(struct _reent * r, void * ptr, size_t size);
@@ -85,6 +224,12 @@ extern "C" {
     void* __real__calloc_r(struct _reent * r, size_t nmemb, size_t size);
 }
 
+#define heap_malloc     __real__malloc_r
+#define heap_realloc    __real__realloc_r
+#define heap_free       __real__free_r
+#define heap_calloc     __real__calloc_r
+#endif
+
 // TODO: memory tracing doesn't work with uVisor enabled.
 #if !defined(FEATURE_UVISOR)
 
@@ -94,7 +239,7 @@ extern "C" void * __wrap__malloc_r(struct _reent * r, size_t size) {
     malloc_stats_mutex->lock();
     alloc_info_t *alloc_info = NULL;
     if (size <= SIZE_MAX - sizeof(alloc_info_t)) {
-        alloc_info = (alloc_info_t *)__real__malloc_r(r, size + sizeof(alloc_info_t));
+        alloc_info = (alloc_info_t *)heap_malloc(r, size + sizeof(alloc_info_t));
     }
     if (alloc_info != NULL) {
         alloc_info->size = size;
@@ -110,7 +255,7 @@ extern "C" void * __wrap__malloc_r(struct _reent * r, size_t size) {
     }
     malloc_stats_mutex->unlock();
 #else // #ifdef MBED_HEAP_STATS_ENABLED
-    ptr = __real__malloc_r(r, size);
+    ptr = heap_malloc(r, size);
 #endif // #ifdef MBED_HEAP_STATS_ENABLED
 #ifdef MBED_MEM_TRACING_ENABLED
     mem_trace_mutex->lock();
@@ -150,7 +295,7 @@ extern "C" void * __wrap__realloc_r(struct _reent * r, void * ptr, size_t size)
         free(ptr);
     }
 #else // #ifdef MBED_HEAP_STATS_ENABLED
-    new_ptr = __real__realloc_r(r, ptr, size);
+    new_ptr = heap_realloc(r, ptr, size);
 #endif // #ifdef MBED_HEAP_STATS_ENABLED
 #ifdef MBED_MEM_TRACING_ENABLED
     mem_trace_mutex->lock();
@@ -169,10 +314,10 @@ extern "C" void __wrap__free_r(struct _reent * r, void * ptr) {
         heap_stats.current_size -= alloc_info->size;
         heap_stats.alloc_cnt -= 1;
     }
-    __real__free_r(r, (void*)alloc_info);
+    heap_free(r, (void*)alloc_info);
     malloc_stats_mutex->unlock();
 #else // #ifdef MBED_HEAP_STATS_ENABLED
-    __real__free_r(r, ptr);
+    heap_free(r, ptr);
 #endif // #ifdef MBED_HEAP_STATS_ENABLED
 #ifdef MBED_MEM_TRACING_ENABLED
     mem_trace_mutex->lock();
@@ -193,7 +338,7 @@ extern "C" void * __wrap__calloc_r(struct _reent * r, size_t nmemb, size_t size)
         memset(ptr, 0, nmemb * size);
     }
 #else // #ifdef MBED_HEAP_STATS_ENABLED
-    ptr = __real__calloc_r(r, nmemb, size);
+    ptr = heap_calloc(r, nmemb, size);
 #endif // #ifdef MBED_HEAP_STATS_ENABLED
 #ifdef MBED_MEM_TRACING_ENABLED
     mem_trace_mutex->lock();
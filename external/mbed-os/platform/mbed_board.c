@@ -19,6 +19,7 @@
 #include "platform/mbed_toolchain.h"
 #include "platform/mbed_interface.h"
 #include "platform/mbed_critical.h"
+#include "platform/mbed_stdio_tx.h"
 #include "hal/serial_api.h"
 
 #if DEVICE_SERIAL
@@ -83,6 +84,10 @@ void mbed_error_vfprintf(const char * format, va_list arg) {
         if (!stdio_uart_inited) {
             serial_init(&stdio_uart, STDIO_UART_TX, STDIO_UART_RX);
         }
+#if MBED_CONF_PLATFORM_STDIO_BUFFERED_SERIAL
+        // Send what is already queued so the error comes out after it
+        mbed_stdio_tx_flush();
+#endif
 #if MBED_CONF_PLATFORM_STDIO_CONVERT_NEWLINES
         char stdio_out_prev = '\0';
         for (int i = 0; i < size; i++) {
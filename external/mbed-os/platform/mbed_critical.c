@@ -23,7 +23,11 @@
 #include "platform/mbed_assert.h"
 #include "platform/mbed_toolchain.h"
 
-#define EXCLUSIVE_ACCESS (!defined (__CORTEX_M0) && !defined (__CORTEX_M0PLUS))
+#if !defined (__CORTEX_M0) && !defined (__CORTEX_M0PLUS)
+#define EXCLUSIVE_ACCESS 1
+#else
+#define EXCLUSIVE_ACCESS 0
+#endif
 
 static volatile uint32_t interrupt_enable_counter = 0;
 static volatile bool critical_interrupts_disabled = false;
@@ -69,9 +73,8 @@ MBED_WEAK void core_util_critical_section_exit(void)
 
 // FIXME
 #ifndef   FEATURE_UVISOR
-        bool interrupts_disabled = !core_util_are_interrupts_enabled(); /* get the current interrupt disabled state */
-
-        MBED_ASSERT(interrupts_disabled); /* Interrupts must be disabled on invoking an exit from a critical section */
+        /* Interrupts must be disabled on invoking an exit from a critical section */
+        MBED_ASSERT(!core_util_are_interrupts_enabled());
 #else
 #warning "core_util_critical_section_exit needs fixing to work from unprivileged code"
 #endif /* FEATURE_UVISOR */
@@ -305,6 +308,8 @@ uint32_t core_util_atomic_decr_u32(uint32_t *valuePtr, uint32_t delta)
 #endif
 
 
+#if UINTPTR_MAX == UINT32_MAX
+
 bool core_util_atomic_cas_ptr(void **ptr, void **expectedCurrentValue, void *desiredValue) {
     return core_util_atomic_cas_u32(
             (uint32_t *)ptr,
@@ -320,3 +325,22 @@ void *core_util_atomic_decr_ptr(void **valuePtr, ptrdiff_t delta) {
     return (void *)core_util_atomic_decr_u32((uint32_t *)valuePtr, (uint32_t)delta);
 }
 
+#else
+
+/* Pointers are wider than the 32-bit operations on native hosts, so use the
+ * compiler's atomics rather than losing the top half. */
+bool core_util_atomic_cas_ptr(void **ptr, void **expectedCurrentValue, void *desiredValue) {
+    return __atomic_compare_exchange_n(ptr, expectedCurrentValue, desiredValue, false,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+void *core_util_atomic_incr_ptr(void **valuePtr, ptrdiff_t delta) {
+    return (void *)__atomic_add_fetch((uintptr_t *)valuePtr, (uintptr_t)delta, __ATOMIC_SEQ_CST);
+}
+
+void *core_util_atomic_decr_ptr(void **valuePtr, ptrdiff_t delta) {
+    return (void *)__atomic_sub_fetch((uintptr_t *)valuePtr, (uintptr_t)delta, __ATOMIC_SEQ_CST);
+}
+
+#endif
+
@@ -87,19 +87,19 @@ void mbed_mem_trace_default_callback(uint8_t op, void *res, void *caller, ...) {
     switch(op) {
         case MBED_MEM_TRACE_MALLOC:
             temp_s1 = va_arg(va, size_t);
-            printf(MBED_MEM_DEFAULT_TRACER_PREFIX "m:%p;%p-%u\n", res, caller, temp_s1);
+            printf(MBED_MEM_DEFAULT_TRACER_PREFIX "m:%p;%p-%lu\n", res, caller, (unsigned long)temp_s1);
             break;
 
         case MBED_MEM_TRACE_REALLOC:
             temp_ptr = va_arg(va, void*);
             temp_s1 = va_arg(va, size_t);
-            printf(MBED_MEM_DEFAULT_TRACER_PREFIX "r:%p;%p-%p;%u\n", res, caller, temp_ptr, temp_s1);
+            printf(MBED_MEM_DEFAULT_TRACER_PREFIX "r:%p;%p-%p;%lu\n", res, caller, temp_ptr, (unsigned long)temp_s1);
             break;
 
         case MBED_MEM_TRACE_CALLOC:
             temp_s1 = va_arg(va, size_t);
             temp_s2 = va_arg(va, size_t);
-            printf(MBED_MEM_DEFAULT_TRACER_PREFIX "c:%p;%p-%u;%u\n", res, caller, temp_s1, temp_s2);
+            printf(MBED_MEM_DEFAULT_TRACER_PREFIX "c:%p;%p-%lu;%lu\n", res, caller, (unsigned long)temp_s1, (unsigned long)temp_s2);
             break;
 
         case MBED_MEM_TRACE_FREE:
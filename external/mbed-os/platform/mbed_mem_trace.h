@@ -26,6 +26,7 @@ extern "C" {
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdio.h>
 
 /* Operation types for tracer */
 enum {
@@ -133,6 +134,68 @@ void mbed_mem_trace_free(void *ptr, void *caller);
  */
 void mbed_mem_trace_default_callback(uint8_t op, void *res, void *caller, ...);
 
+/**
+ * Record stored by the binary tracer for each memory operation.
+ * A successful 'realloc' that moves or frees a block is stored as a 'free' of
+ * the old block followed by a 'realloc' record for the new one. A failed
+ * allocation is stored with a 'ptr' of 0.
+ */
+typedef struct {
+    uint32_t timestamp;     /**< us_ticker_read() when the operation was traced. */
+    uint32_t caller;        /**< Caller of the memory operation. */
+    uint32_t ptr;           /**< Block allocated, or the block freed for 'free'. */
+    uint32_t size_op;       /**< Bytes allocated in the low 28 bits, the operation in the top 4. */
+} mbed_mem_trace_record_t;
+
+#define MBED_MEM_TRACE_RECORD_OP(record)    ((record)->size_op >> 28)
+#define MBED_MEM_TRACE_RECORD_SIZE(record)  ((record)->size_op & 0x0FFFFFFFUL)
+
+/** "MTR1" read as a little endian word, which starts every packet */
+#define MBED_MEM_TRACE_PACKET_MAGIC         0x3152544DUL
+
+/**
+ * Header written by mbed_mem_trace_binary_drain() before each group of records.
+ */
+typedef struct {
+    uint32_t magic;         /**< MBED_MEM_TRACE_PACKET_MAGIC. */
+    uint16_t count;         /**< Number of records following the header. */
+    uint16_t dropped;       /**< Records lost to a full buffer since the last packet, saturating at 0xFFFF. */
+    uint32_t checksum;      /**< Sum of the words of the header, with this field 0, and of the records. */
+} mbed_mem_trace_packet_t;
+
+/**
+ * Binary memory trace callback. DO NOT CALL DIRECTLY. It is meant to be used
+ * as the argument of 'mbed_mem_trace_set_callback'.
+ * Stores a fixed size mbed_mem_trace_record_t for each memory operation in a
+ * RAM ring buffer of platform.mem-trace-buffer-records records, which costs
+ * a few microseconds, where the default callback formats and prints a line.
+ * Records are dropped, and counted, while the buffer is full. Safe to call
+ * from threads and interrupt handlers.
+ */
+void mbed_mem_trace_binary_callback(uint8_t op, void *res, void *caller, ...);
+
+/**
+ * Take records out of the binary trace buffer, oldest first.
+ * @param records where to store the records.
+ * @param count the most records to take.
+ * @param dropped if not NULL, set to the number of records dropped since the
+ *                last call, which were due after those taken.
+ * @return the number of records taken.
+ */
+size_t mbed_mem_trace_binary_read(mbed_mem_trace_record_t *records, size_t count, uint32_t *dropped);
+
+/**
+ * Write everything in the binary trace buffer to a stream, as packets made of
+ * an mbed_mem_trace_packet_t followed by its records, all little endian.
+ * The stream can be stdout, to capture the packets from the serial port among
+ * the rest of the output, or a file such as one on LocalFileSystem, which
+ * goes over semihosting. Memory operations made by the stream itself are
+ * traced into the buffer for the next drain.
+ * @param stream the stream to write to.
+ * @return the number of records written, or -1 if the stream failed.
+ */
+int mbed_mem_trace_binary_drain(FILE *stream);
+
 #ifdef __cplusplus
 }
 #endif
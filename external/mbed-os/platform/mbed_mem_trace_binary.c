@@ -0,0 +1,153 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdarg.h>
+#include <string.h>
+#include "platform/mbed_mem_trace.h"
+#include "platform/mbed_critical.h"
+#include "hal/us_ticker_api.h"
+
+#ifndef MBED_CONF_PLATFORM_MEM_TRACE_BUFFER_RECORDS
+#define MBED_CONF_PLATFORM_MEM_TRACE_BUFFER_RECORDS 256
+#endif
+
+#define TRACE_BUFFER_SIZE   MBED_CONF_PLATFORM_MEM_TRACE_BUFFER_RECORDS
+#define TRACE_BUFFER_MASK   (TRACE_BUFFER_SIZE - 1)
+#define DRAIN_RECORDS       16
+
+#if TRACE_BUFFER_SIZE < 2 || (TRACE_BUFFER_SIZE & TRACE_BUFFER_MASK)
+#error "platform.mem-trace-buffer-records must be a power of two"
+#endif
+
+/* head and tail run freely and are only reduced to an index on access, so
+ * head - tail is the number of records waiting even when they wrap. */
+static mbed_mem_trace_record_t trace_buffer[TRACE_BUFFER_SIZE];
+static uint32_t trace_head;
+static uint32_t trace_tail;
+static uint32_t trace_dropped;
+
+static void trace_put(uint32_t op, void *ptr, size_t size, void *caller, uint32_t timestamp)
+{
+    core_util_critical_section_enter();
+    if (trace_head - trace_tail < TRACE_BUFFER_SIZE) {
+        mbed_mem_trace_record_t *record = &trace_buffer[trace_head & TRACE_BUFFER_MASK];
+        record->timestamp = timestamp;
+        record->caller = (uint32_t)(uintptr_t)caller;
+        record->ptr = (uint32_t)(uintptr_t)ptr;
+        record->size_op = (op << 28) | (uint32_t)(size & 0x0FFFFFFF);
+        trace_head++;
+    } else {
+        trace_dropped++;
+    }
+    core_util_critical_section_exit();
+}
+
+void mbed_mem_trace_binary_callback(uint8_t op, void *res, void *caller, ...)
+{
+    uint32_t timestamp = us_ticker_read();
+    va_list va;
+    void *ptr;
+    size_t size;
+
+    va_start(va, caller);
+    switch (op) {
+        case MBED_MEM_TRACE_MALLOC:
+            size = va_arg(va, size_t);
+            trace_put(op, res, size, caller, timestamp);
+            break;
+
+        case MBED_MEM_TRACE_REALLOC:
+            ptr = va_arg(va, void *);
+            size = va_arg(va, size_t);
+            // The old block is only gone if the call worked or was a free
+            if (ptr != NULL && (res != NULL || size == 0)) {
+                trace_put(MBED_MEM_TRACE_FREE, ptr, 0, caller, timestamp);
+            }
+            if (size != 0) {
+                trace_put(op, res, size, caller, timestamp);
+            }
+            break;
+
+        case MBED_MEM_TRACE_CALLOC:
+            size = va_arg(va, size_t);
+            size *= va_arg(va, size_t);
+            trace_put(op, res, size, caller, timestamp);
+            break;
+
+        case MBED_MEM_TRACE_FREE:
+            ptr = va_arg(va, void *);
+            if (ptr != NULL) {
+                trace_put(op, ptr, 0, caller, timestamp);
+            }
+            break;
+    }
+    va_end(va);
+}
+
+size_t mbed_mem_trace_binary_read(mbed_mem_trace_record_t *records, size_t count, uint32_t *dropped)
+{
+    size_t taken = 0;
+
+    core_util_critical_section_enter();
+    while (taken < count && trace_tail != trace_head) {
+        records[taken++] = trace_buffer[trace_tail & TRACE_BUFFER_MASK];
+        trace_tail++;
+    }
+    // Drops only belong with these records once the buffer has been emptied
+    if (dropped != NULL) {
+        *dropped = 0;
+        if (trace_tail == trace_head) {
+            *dropped = trace_dropped;
+            trace_dropped = 0;
+        }
+    }
+    core_util_critical_section_exit();
+
+    return taken;
+}
+
+int mbed_mem_trace_binary_drain(FILE *stream)
+{
+    mbed_mem_trace_record_t records[DRAIN_RECORDS];
+    mbed_mem_trace_packet_t packet;
+    uint32_t dropped;
+    int written = 0;
+
+    do {
+        size_t count = mbed_mem_trace_binary_read(records, DRAIN_RECORDS, &dropped);
+        if (count == 0 && dropped == 0) {
+            break;
+        }
+
+        packet.magic = MBED_MEM_TRACE_PACKET_MAGIC;
+        packet.count = (uint16_t)count;
+        packet.dropped = (uint16_t)(dropped > 0xFFFF ? 0xFFFF : dropped);
+        packet.checksum = 0;
+
+        uint32_t checksum = packet.magic + packet.count + ((uint32_t)packet.dropped << 16);
+        for (size_t i = 0; i < count; i++) {
+            checksum += records[i].timestamp + records[i].caller + records[i].ptr + records[i].size_op;
+        }
+        packet.checksum = checksum;
+
+        if (fwrite(&packet, sizeof(packet), 1, stream) != 1 ||
+                (count && fwrite(records, sizeof(records[0]), count, stream) != count)) {
+            return -1;
+        }
+        written += count;
+    } while (dropped == 0);
+
+    return fflush(stream) == 0 ? written : -1;
+}
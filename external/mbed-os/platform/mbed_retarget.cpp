@@ -23,6 +23,7 @@
 #include "platform/PlatformMutex.h"
 #include "platform/mbed_error.h"
 #include "platform/mbed_stats.h"
+#include "platform/mbed_stdio_tx.h"
 #if MBED_CONF_FILESYSTEM_PRESENT
 #include "filesystem/FileSystem.h"
 #include "filesystem/File.h"
@@ -54,6 +55,12 @@
 #   define STDOUT_FILENO    1
 #   define STDERR_FILENO    2
 
+#elif defined(TARGET_HOST_SIM)
+#   include <sys/stat.h>
+#   include <stdio.h>
+#   define PREFIX(x)    x
+#   define OPEN_MAX     16
+
 #else
 #   include <sys/stat.h>
 #   include <sys/syslimits.h>
@@ -108,6 +115,16 @@ extern serial_t stdio_uart;
 static char stdio_in_prev;
 static char stdio_out_prev;
 #endif
+
+static void stdio_write(const unsigned char *buffer, unsigned int length) {
+#if MBED_CONF_PLATFORM_STDIO_BUFFERED_SERIAL
+    mbed_stdio_tx_write(buffer, length);
+#else
+    for (unsigned int i = 0; i < length; i++) {
+        serial_putc(&stdio_uart, buffer[i]);
+    }
+#endif
+}
 #endif
 
 static void init_serial() {
@@ -150,7 +167,7 @@ static inline int openmode_to_posix(int openmode) {
     if (openmode & _LLIO_CREAT ) posix |= O_CREAT;
     if (openmode & _LLIO_APPEND) posix |= O_APPEND;
     if (openmode & _LLIO_TRUNC ) posix |= O_TRUNC;
-#elif defined(TOOLCHAIN_GCC)
+#elif defined(TOOLCHAIN_GCC) && !defined(TARGET_HOST_SIM)
     posix &= ~O_BINARY;
 #endif
     return posix;
@@ -322,17 +339,19 @@ extern "C" int PREFIX(_write)(FILEHANDLE fh, const unsigned char *buffer, unsign
 #if DEVICE_SERIAL
         if (!stdio_uart_inited) init_serial();
 #if MBED_CONF_PLATFORM_STDIO_CONVERT_NEWLINES
+        // Written in runs between the inserted carriage returns
+        unsigned int start = 0;
         for (unsigned int i = 0; i < length; i++) {
             if (buffer[i] == '\n' && stdio_out_prev != '\r') {
-                 serial_putc(&stdio_uart, '\r');
+                stdio_write(buffer + start, i - start);
+                stdio_write((const unsigned char *)"\r", 1);
+                start = i;
             }
-            serial_putc(&stdio_uart, buffer[i]);
             stdio_out_prev = buffer[i];
         }
+        stdio_write(buffer + start, length - start);
 #else
-        for (unsigned int i = 0; i < length; i++) {
-            serial_putc(&stdio_uart, buffer[i]);
-        }
+        stdio_write(buffer, length);
 #endif
 #endif
         n = length;
@@ -488,6 +507,9 @@ extern "C" int _fstat(int fd, struct stat *st) {
 }
 #endif
 
+// The host C library keeps its own path based calls, mbed files are reached
+// through the fopen() wrapper in TARGET_HOST_SIM instead.
+#if !defined(TARGET_HOST_SIM)
 namespace std {
 extern "C" int remove(const char *path) {
 #if MBED_CONF_FILESYSTEM_PRESENT
@@ -668,6 +690,7 @@ extern "C" int stat(const char *path, struct stat *st) {
     return -1;
 #endif
 }
+#endif // !defined(TARGET_HOST_SIM)
 
 #if defined(TOOLCHAIN_GCC)
 /* prevents the exception handling name demangling code getting pulled in */
@@ -733,7 +756,7 @@ extern "C" void _platform_post_stackheap_init (void) {
     mbed_sdk_init();
 }
 
-#elif defined(TOOLCHAIN_GCC)
+#elif defined(TOOLCHAIN_GCC) && !defined(TARGET_HOST_SIM)
 extern "C" int __real_main(void);
 
 extern "C" int __wrap_main(void) {
@@ -754,7 +777,7 @@ extern "C" void __iar_argc_argv() {
 // Provide implementation of _sbrk (low-level dynamic memory allocation
 // routine) for GCC_ARM which compares new heap pointer with MSP instead of
 // SP.  This make it compatible with RTX RTOS thread stacks.
-#if defined(TOOLCHAIN_GCC_ARM) || defined(TOOLCHAIN_GCC_CR)
+#if (defined(TOOLCHAIN_GCC_ARM) || defined(TOOLCHAIN_GCC_CR)) && !defined(TARGET_HOST_SIM)
 // Linker defined symbol used by _sbrk to indicate where heap should start.
 extern "C" int __end__;
 
@@ -808,6 +831,9 @@ extern "C" caddr_t _sbrk(int incr) {
 #endif
 #endif
 
+// The host C library exits the process itself, flushing stdio and running
+// the handlers registered with atexit.
+#if !defined(TARGET_HOST_SIM)
 #if defined(TOOLCHAIN_GCC_ARM) || defined(TOOLCHAIN_GCC_CR)
 extern "C" void _exit(int return_code) {
 #else
@@ -820,6 +846,9 @@ extern "C" void exit(int return_code) {
     fflush(stdout);
     fflush(stderr);
 #endif
+#if DEVICE_SERIAL && MBED_CONF_PLATFORM_STDIO_BUFFERED_SERIAL
+    mbed_stdio_tx_flush();
+#endif
 #endif
 
 #if DEVICE_SEMIHOST
@@ -894,6 +923,7 @@ int __wrap_atexit(void (*func)()) {
 }
 
 #endif
+#endif // !defined(TARGET_HOST_SIM)
 
 
 
@@ -980,6 +1010,7 @@ extern "C" void __env_unlock( struct _reent *_r )
     __rtos_env_unlock(_r);
 }
 
+#if !defined(TARGET_HOST_SIM)
 #define CXA_GUARD_INIT_DONE             (1 << 0)
 #define CXA_GUARD_INIT_IN_PROGRESS      (1 << 1)
 #define CXA_GUARD_MASK                  (CXA_GUARD_INIT_DONE | CXA_GUARD_INIT_IN_PROGRESS)
@@ -1015,6 +1046,7 @@ extern "C" void __cxa_guard_abort(int *guard_object_p)
     *guard_object = *guard_object & ~CXA_GUARD_INIT_IN_PROGRESS;
     singleton_unlock();
 }
+#endif // !defined(TARGET_HOST_SIM)
 
 #endif
 
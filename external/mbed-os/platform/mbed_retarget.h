@@ -42,8 +42,12 @@ typedef int mode_t;     ///< Mode for opening files
 #else
 #include <sys/fcntl.h>
 #include <sys/types.h>
+#if defined(TARGET_HOST_SIM)
+#include <limits.h>
+#else
 #include <sys/syslimits.h>
 #endif
+#endif
 
 
 /* DIR declarations must also be here */
@@ -32,15 +32,32 @@ typedef struct {
     uint32_t reserved_size;     /**< Current number of bytes allocated for the heap. */
     uint32_t alloc_cnt;         /**< Current number of allocations. */
     uint32_t alloc_fail_cnt;    /**< Number of failed allocations. */
+    uint32_t free_size;         /**< Bytes free in the heap pools, TLSF heap only. */
+    uint32_t largest_free_size; /**< Largest block which could be allocated without growing the heap, TLSF heap only. */
 } mbed_stats_heap_t;
 
 /**
  *  Fill the passed in heap stat structure with heap stats.
  *
+ *  The first six fields need MBED_HEAP_STATS_ENABLED. The free sizes are
+ *  filled in whenever the platform.tlsf-heap option is on, and
+ *  1 - largest_free_size / free_size measures how fragmented the heap is.
+ *
  *  @param stats    A pointer to the mbed_stats_heap_t structure to fill
  */
 void mbed_stats_heap_get(mbed_stats_heap_t *stats);
 
+/**
+ *  Check the integrity of the heap.
+ *
+ *  Only the TLSF heap can be checked. Takes time in proportion to the number
+ *  of blocks in the heap.
+ *
+ *  @return         0 if the heap is consistent or can't be checked, otherwise
+ *                  a negative number identifying the problem
+ */
+int mbed_heap_check(void);
+
 typedef struct {
     uint32_t thread_id;         /**< Identifier for thread that owns the stack. */
     uint32_t max_size;          /**< Sum of the maximum number of bytes used in each stack. */
@@ -0,0 +1,218 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "platform/mbed_stdio_tx.h"
+#include "platform/mbed_critical.h"
+#include "hal/serial_api.h"
+#include <string.h>
+
+#if DEVICE_SERIAL
+
+#ifndef MBED_CONF_PLATFORM_STDIO_TX_BUFFER_SIZE
+#define MBED_CONF_PLATFORM_STDIO_TX_BUFFER_SIZE 256
+#endif
+
+#ifndef MBED_CONF_PLATFORM_STDIO_TX_OVERFLOW
+#define MBED_CONF_PLATFORM_STDIO_TX_OVERFLOW    MBED_STDIO_TX_BLOCK
+#endif
+
+#define TX_BUFFER_SIZE  MBED_CONF_PLATFORM_STDIO_TX_BUFFER_SIZE
+#define TX_BUFFER_MASK  (TX_BUFFER_SIZE - 1)
+
+#if TX_BUFFER_SIZE < 2 || (TX_BUFFER_SIZE & TX_BUFFER_MASK)
+#error "platform.stdio-tx-buffer-size must be a power of two"
+#endif
+
+extern int stdio_uart_inited;
+extern serial_t stdio_uart;
+
+/* head and tail run freely and are only reduced to an index on access, so
+ * head - tail is the number of bytes waiting even when they wrap. */
+static uint8_t tx_buffer[TX_BUFFER_SIZE];
+static volatile uint32_t tx_head;
+static volatile uint32_t tx_tail;
+static uint8_t tx_irq_attached;
+static uint8_t tx_irq_enabled;
+static uint8_t tx_polled;
+static mbed_stdio_tx_overflow_t tx_overflow = MBED_CONF_PLATFORM_STDIO_TX_OVERFLOW;
+static mbed_stdio_tx_stats_t tx_stats;
+
+/* Sends as much as the UART takes without waiting. Called from the TX
+ * interrupt or from inside a critical section. */
+static void stdio_tx_drain(void)
+{
+    uint32_t tail = tx_tail;
+    while (tail != tx_head && serial_writable(&stdio_uart)) {
+        serial_putc(&stdio_uart, tx_buffer[tail & TX_BUFFER_MASK]);
+        tail++;
+        tx_stats.sent++;
+    }
+    tx_tail = tail;
+
+    if (tail == tx_head && tx_irq_enabled) {
+        serial_irq_set(&stdio_uart, TxIrq, 0);
+        tx_irq_enabled = 0;
+    }
+}
+
+static void stdio_tx_irq(uint32_t id, SerialIrq event)
+{
+    (void)id;
+    if (event == TxIrq) {
+        stdio_tx_drain();
+    }
+}
+
+/* Fills the UART and leaves the rest to the TX interrupt. Must be called
+ * from inside a critical section. */
+static void stdio_tx_kick(void)
+{
+    if (tx_polled) {
+        return;
+    }
+    if (!tx_irq_attached) {
+        // HALs don't call handlers registered with an id of 0
+        serial_irq_handler(&stdio_uart, stdio_tx_irq, 1);
+        tx_irq_attached = 1;
+    }
+
+    stdio_tx_drain();
+    if (tx_tail != tx_head && !tx_irq_enabled) {
+        tx_irq_enabled = 1;
+        serial_irq_set(&stdio_uart, TxIrq, 1);
+    }
+}
+
+/* Sends the oldest byte by polling if the UART has room for it, so that a
+ * writer waiting on a full buffer makes progress when the TX interrupt can't
+ * run, as in an interrupt handler or with interrupts disabled. */
+static void stdio_tx_poll(void)
+{
+    core_util_critical_section_enter();
+    if (tx_tail != tx_head && serial_writable(&stdio_uart)) {
+        serial_putc(&stdio_uart, tx_buffer[tx_tail & TX_BUFFER_MASK]);
+        tx_tail++;
+        tx_stats.sent++;
+    }
+    if (tx_tail == tx_head && tx_irq_enabled) {
+        serial_irq_set(&stdio_uart, TxIrq, 0);
+        tx_irq_enabled = 0;
+    }
+    core_util_critical_section_exit();
+}
+
+size_t mbed_stdio_tx_write(const void *buffer, size_t length)
+{
+    const uint8_t *data = (const uint8_t *)buffer;
+    size_t queued = 0;
+    int blocked = 0;
+
+    while (length > 0) {
+        core_util_critical_section_enter();
+
+        uint32_t used = tx_head - tx_tail;
+        size_t space = TX_BUFFER_SIZE - used;
+        size_t count = length;
+        if (count > space) {
+            if (tx_overflow == MBED_STDIO_TX_DROP_OLDEST) {
+                // Keep the newest bytes, which may mean dropping some of ours
+                if (count > TX_BUFFER_SIZE) {
+                    tx_stats.dropped += count - TX_BUFFER_SIZE;
+                    data += count - TX_BUFFER_SIZE;
+                    length = count = TX_BUFFER_SIZE;
+                }
+                tx_stats.dropped += count - space;
+                tx_tail += count - space;
+                used -= count - space;
+            } else if (tx_overflow == MBED_STDIO_TX_DROP_NEWEST) {
+                tx_stats.dropped += count - space;
+                length = count = space;
+            } else {
+                count = space;
+            }
+        }
+
+        // Copy in at most two pieces, either side of the wrap
+        uint32_t head = tx_head;
+        size_t index = head & TX_BUFFER_MASK;
+        size_t first = TX_BUFFER_SIZE - index;
+        if (first > count) {
+            first = count;
+        }
+        memcpy(&tx_buffer[index], data, first);
+        memcpy(&tx_buffer[0], data + first, count - first);
+        tx_head = head + count;
+
+        used += count;
+        if (used > tx_stats.max_used) {
+            tx_stats.max_used = used;
+        }
+        tx_stats.queued += count;
+        data += count;
+        length -= count;
+        queued += count;
+
+        if (count > 0) {
+            stdio_tx_kick();
+        }
+        core_util_critical_section_exit();
+
+        if (length > 0) {
+            if (!blocked) {
+                blocked = 1;
+                tx_stats.blocked++;
+            }
+            stdio_tx_poll();
+        }
+    }
+
+    if (tx_polled) {
+        mbed_stdio_tx_flush();
+    }
+    return queued;
+}
+
+void mbed_stdio_tx_release_irq(void)
+{
+    core_util_critical_section_enter();
+    tx_polled = 1;
+    if (tx_irq_enabled) {
+        serial_irq_set(&stdio_uart, TxIrq, 0);
+        tx_irq_enabled = 0;
+    }
+    core_util_critical_section_exit();
+    mbed_stdio_tx_flush();
+}
+
+void mbed_stdio_tx_flush(void)
+{
+    while (tx_tail != tx_head) {
+        stdio_tx_poll();
+    }
+}
+
+void mbed_stdio_tx_set_overflow(mbed_stdio_tx_overflow_t policy)
+{
+    tx_overflow = policy;
+}
+
+void mbed_stdio_tx_get_stats(mbed_stdio_tx_stats_t *stats)
+{
+    core_util_critical_section_enter();
+    memcpy(stats, &tx_stats, sizeof(*stats));
+    core_util_critical_section_exit();
+}
+
+#endif
@@ -0,0 +1,100 @@
+
+/** \addtogroup platform */
+/** @{*/
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_STDIO_TX_H
+#define MBED_STDIO_TX_H
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** What to do with console output that doesn't fit in the TX ring buffer
+ */
+typedef enum {
+    MBED_STDIO_TX_BLOCK,        /**< Wait for room, sending bytes from the caller's context if need be. */
+    MBED_STDIO_TX_DROP_NEWEST,  /**< Discard the bytes which don't fit. */
+    MBED_STDIO_TX_DROP_OLDEST,  /**< Discard the oldest unsent bytes to make room. */
+} mbed_stdio_tx_overflow_t;
+
+typedef struct {
+    uint32_t queued;            /**< Bytes accepted into the buffer. */
+    uint32_t sent;              /**< Bytes handed to the UART. */
+    uint32_t dropped;           /**< Bytes discarded by the overflow policy. */
+    uint32_t blocked;           /**< Writes which had to wait for room. */
+    uint32_t max_used;          /**< Most bytes waiting in the buffer at once. */
+} mbed_stdio_tx_stats_t;
+
+/**
+ *  Queue console output for the UART TX interrupt to send.
+ *
+ *  Used by the retarget layer for stdout and stderr when the
+ *  platform.stdio-buffered-serial option is enabled. Safe to call from
+ *  threads and interrupt handlers.
+ *
+ *  The TX interrupt of the stdio UART is taken over while there is output to
+ *  send. A serial driver opened on the same pins replaces the handler, and
+ *  calls mbed_stdio_tx_release_irq so that writes send by polling instead.
+ *
+ *  @param buffer   Bytes to send
+ *  @param length   Number of bytes to send
+ *  @return         Number of bytes queued, less than length if some were
+ *                  dropped
+ */
+size_t mbed_stdio_tx_write(const void *buffer, size_t length);
+
+/**
+ *  Stop using the stdio UART's interrupt for console output.
+ *
+ *  For drivers which install their own interrupt handler on the stdio UART,
+ *  as SerialBase does when opened on STDIO_UART_TX. Sends whatever is
+ *  buffered, and from then on each write waits until its bytes are sent, as
+ *  with the option off.
+ */
+void mbed_stdio_tx_release_irq(void);
+
+/**
+ *  Send everything in the buffer, polling the UART.
+ *
+ *  Works with interrupts disabled, so it can be used on crash paths before
+ *  printing directly to the UART.
+ */
+void mbed_stdio_tx_flush(void);
+
+/**
+ *  Change the overflow policy, which defaults to platform.stdio-tx-overflow.
+ *
+ *  @param policy   Policy for the following writes
+ */
+void mbed_stdio_tx_set_overflow(mbed_stdio_tx_overflow_t policy);
+
+/**
+ *  Fill the passed in structure with the console output counters.
+ *
+ *  @param stats    A pointer to the mbed_stdio_tx_stats_t structure to fill
+ */
+void mbed_stdio_tx_get_stats(mbed_stdio_tx_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/** @}*/
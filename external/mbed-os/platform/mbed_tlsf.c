@@ -0,0 +1,498 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "platform/mbed_tlsf.h"
+#include "platform/mbed_assert.h"
+#include <string.h>
+#if defined(__ICCARM__)
+#include <intrinsics.h>
+#endif
+
+#if MBED_TLSF_FL_INDEX_COUNT < 1 || MBED_TLSF_FL_INDEX_COUNT > 31
+#error "MBED_TLSF_FL_INDEX_MAX is out of range"
+#endif
+
+/* Layout of a pool:
+ *
+ *   pool header | block header | data ... | block header | data ... | end header
+ *
+ * A block header is the prev_phys and size fields of mbed_tlsf_block_t. The
+ * free list links take the first words of the data of a free block, and the
+ * end header is a used block of size 0 which stops merging at the end of the
+ * pool. */
+#define BLOCK_FREE          ((size_t)1)
+#define BLOCK_PREV_FREE     ((size_t)2)
+#define BLOCK_FLAGS         (BLOCK_FREE | BLOCK_PREV_FREE)
+
+#define ALIGN_UP(X)         (((X) + MBED_TLSF_ALIGN - 1) & ~(size_t)(MBED_TLSF_ALIGN - 1))
+
+#define BLOCK_HEADER        offsetof(mbed_tlsf_block_t, next_free)
+#define BLOCK_SIZE_MIN      ALIGN_UP(sizeof(mbed_tlsf_block_t) - BLOCK_HEADER)
+#define BLOCK_SIZE_MAX      ((size_t)1 << MBED_TLSF_FL_INDEX_MAX)
+#define SMALL_BLOCK_SIZE    ((size_t)1 << MBED_TLSF_FL_INDEX_SHIFT)
+#define POOL_HEADER         ALIGN_UP(sizeof(mbed_tlsf_pool_t))
+#define POOL_OVERHEAD       (POOL_HEADER + 2 * BLOCK_HEADER)
+
+
+static inline int tlsf_fls(uint32_t word)
+{
+#if defined(__CC_ARM)
+    return word ? 31 - __clz(word) : -1;
+#elif defined(__ICCARM__)
+    return word ? 31 - __CLZ(word) : -1;
+#else
+    return word ? 31 - __builtin_clz(word) : -1;
+#endif
+}
+
+static inline int tlsf_ffs(uint32_t word)
+{
+    return tlsf_fls(word & (~word + 1));
+}
+
+static inline size_t block_size(const mbed_tlsf_block_t *block)
+{
+    return block->size & ~BLOCK_FLAGS;
+}
+
+static inline void block_set_size(mbed_tlsf_block_t *block, size_t size)
+{
+    block->size = size | (block->size & BLOCK_FLAGS);
+}
+
+static inline int block_is_free(const mbed_tlsf_block_t *block)
+{
+    return (block->size & BLOCK_FREE) != 0;
+}
+
+static inline int block_is_prev_free(const mbed_tlsf_block_t *block)
+{
+    return (block->size & BLOCK_PREV_FREE) != 0;
+}
+
+static inline void *block_to_ptr(const mbed_tlsf_block_t *block)
+{
+    return (char *)block + BLOCK_HEADER;
+}
+
+static inline mbed_tlsf_block_t *block_from_ptr(const void *ptr)
+{
+    return (mbed_tlsf_block_t *)((char *)ptr - BLOCK_HEADER);
+}
+
+static inline mbed_tlsf_block_t *block_next(const mbed_tlsf_block_t *block)
+{
+    return (mbed_tlsf_block_t *)((char *)block_to_ptr(block) + block_size(block));
+}
+
+static inline void block_mark_free(mbed_tlsf_block_t *block)
+{
+    mbed_tlsf_block_t *next = block_next(block);
+    next->prev_phys = block;
+    next->size |= BLOCK_PREV_FREE;
+    block->size |= BLOCK_FREE;
+}
+
+static inline void block_mark_used(mbed_tlsf_block_t *block)
+{
+    mbed_tlsf_block_t *next = block_next(block);
+    next->size &= ~BLOCK_PREV_FREE;
+    block->size &= ~BLOCK_FREE;
+}
+
+/* Rounds a request up to a block size, or returns 0 if it can't be met */
+static size_t adjust_size(size_t size)
+{
+    if (size >= BLOCK_SIZE_MAX) {
+        return 0;
+    }
+    size = ALIGN_UP(size);
+    return (size < BLOCK_SIZE_MIN) ? BLOCK_SIZE_MIN : size;
+}
+
+/* The list a block of this size belongs on */
+static void mapping_insert(size_t size, int *fl, int *sl)
+{
+    if (size < SMALL_BLOCK_SIZE) {
+        *fl = 0;
+        *sl = (int)(size >> MBED_TLSF_ALIGN_LOG2);
+    } else {
+        int top = tlsf_fls((uint32_t)size);
+        *sl = (int)(size >> (top - MBED_TLSF_SL_INDEX_COUNT_LOG2)) ^ MBED_TLSF_SL_INDEX_COUNT;
+        *fl = top - (MBED_TLSF_FL_INDEX_SHIFT - 1);
+    }
+}
+
+/* The first list whose blocks are all at least this size */
+static void mapping_search(size_t size, int *fl, int *sl)
+{
+    if (size >= SMALL_BLOCK_SIZE) {
+        size += ((size_t)1 << (tlsf_fls((uint32_t)size) - MBED_TLSF_SL_INDEX_COUNT_LOG2)) - 1;
+    }
+    mapping_insert(size, fl, sl);
+}
+
+static mbed_tlsf_block_t *search_suitable_block(mbed_tlsf_t *tlsf, int *fl, int *sl)
+{
+    if (*fl >= MBED_TLSF_FL_INDEX_COUNT) {
+        return NULL;
+    }
+
+    uint32_t sl_map = tlsf->sl_bitmap[*fl] & (~(uint32_t)0 << *sl);
+    if (!sl_map) {
+        uint32_t fl_map = tlsf->fl_bitmap & (~(uint32_t)0 << (*fl + 1));
+        if (!fl_map) {
+            return NULL;
+        }
+        *fl = tlsf_ffs(fl_map);
+        sl_map = tlsf->sl_bitmap[*fl];
+    }
+    *sl = tlsf_ffs(sl_map);
+    return tlsf->blocks[*fl][*sl];
+}
+
+static void insert_free_block(mbed_tlsf_t *tlsf, mbed_tlsf_block_t *block)
+{
+    int fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+
+    mbed_tlsf_block_t *head = tlsf->blocks[fl][sl];
+    block->next_free = head;
+    block->prev_free = NULL;
+    if (head) {
+        head->prev_free = block;
+    }
+    tlsf->blocks[fl][sl] = block;
+    tlsf->sl_bitmap[fl] |= (uint32_t)1 << sl;
+    tlsf->fl_bitmap |= (uint32_t)1 << fl;
+
+    tlsf->free_size += block_size(block);
+    tlsf->free_cnt++;
+}
+
+static void remove_free_block(mbed_tlsf_t *tlsf, mbed_tlsf_block_t *block)
+{
+    int fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+
+    mbed_tlsf_block_t *prev = block->prev_free;
+    mbed_tlsf_block_t *next = block->next_free;
+    if (next) {
+        next->prev_free = prev;
+    }
+    if (prev) {
+        prev->next_free = next;
+    } else {
+        tlsf->blocks[fl][sl] = next;
+        if (!next) {
+            tlsf->sl_bitmap[fl] &= ~((uint32_t)1 << sl);
+            if (!tlsf->sl_bitmap[fl]) {
+                tlsf->fl_bitmap &= ~((uint32_t)1 << fl);
+            }
+        }
+    }
+
+    tlsf->free_size -= block_size(block);
+    tlsf->free_cnt--;
+}
+
+static inline int block_can_split(const mbed_tlsf_block_t *block, size_t size)
+{
+    return block_size(block) >= size + BLOCK_HEADER + BLOCK_SIZE_MIN;
+}
+
+/* Cuts the block down to size and returns the used block made of the rest */
+static mbed_tlsf_block_t *block_split(mbed_tlsf_block_t *block, size_t size)
+{
+    mbed_tlsf_block_t *rest = (mbed_tlsf_block_t *)((char *)block_to_ptr(block) + size);
+    rest->size = block_size(block) - size - BLOCK_HEADER;
+    block_set_size(block, size);
+    return rest;
+}
+
+/* Frees a used block, merging it with free neighbours */
+static void block_release(mbed_tlsf_t *tlsf, mbed_tlsf_block_t *block)
+{
+    block_mark_free(block);
+
+    if (block_is_prev_free(block)) {
+        mbed_tlsf_block_t *prev = block->prev_phys;
+        MBED_ASSERT(block_is_free(prev) && block_next(prev) == block);
+        remove_free_block(tlsf, prev);
+        prev->size += BLOCK_HEADER + block_size(block);
+        block = prev;
+        block_next(block)->prev_phys = block;
+    }
+
+    mbed_tlsf_block_t *next = block_next(block);
+    if (block_is_free(next)) {
+        MBED_ASSERT(block_is_prev_free(block_next(next)));
+        remove_free_block(tlsf, next);
+        block->size += BLOCK_HEADER + block_size(next);
+        block_next(block)->prev_phys = block;
+    }
+
+    insert_free_block(tlsf, block);
+}
+
+/* Marks a block taken off a free list as used, returning any excess */
+static void *block_prepare_used(mbed_tlsf_t *tlsf, mbed_tlsf_block_t *block, size_t size)
+{
+    if (block_can_split(block, size)) {
+        mbed_tlsf_block_t *rest = block_split(block, size);
+        rest->size |= BLOCK_FREE;
+        block_next(rest)->prev_phys = rest;
+        insert_free_block(tlsf, rest);
+    }
+    block_mark_used(block);
+    return block_to_ptr(block);
+}
+
+void mbed_tlsf_init(mbed_tlsf_t *tlsf)
+{
+    memset(tlsf, 0, sizeof(*tlsf));
+}
+
+int mbed_tlsf_add_pool(mbed_tlsf_t *tlsf, void *mem, size_t size)
+{
+    char *start = (char *)ALIGN_UP((uintptr_t)mem);
+    size_t lost = start - (char *)mem;
+    if (size < lost) {
+        return -1;
+    }
+    size = (size - lost) & ~(size_t)(MBED_TLSF_ALIGN - 1);
+
+    // Memory following on from the last pool takes over its end header
+    mbed_tlsf_pool_t *last = tlsf->pools;
+    if (last && (char *)last + last->size == start &&
+            size >= BLOCK_HEADER + BLOCK_SIZE_MIN &&
+            last->size + size - POOL_OVERHEAD < BLOCK_SIZE_MAX) {
+        mbed_tlsf_block_t *block = (mbed_tlsf_block_t *)(start - BLOCK_HEADER);
+        block_set_size(block, size - BLOCK_HEADER);
+        block_next(block)->size = 0;
+        last->size += size;
+        tlsf->pool_size += size;
+        block_release(tlsf, block);
+        return 0;
+    }
+
+    if (size < POOL_OVERHEAD + BLOCK_SIZE_MIN || size - POOL_OVERHEAD >= BLOCK_SIZE_MAX) {
+        return -1;
+    }
+
+    mbed_tlsf_pool_t *pool = (mbed_tlsf_pool_t *)start;
+    pool->next = tlsf->pools;
+    pool->size = size;
+    tlsf->pools = pool;
+    tlsf->pool_size += size;
+
+    mbed_tlsf_block_t *block = (mbed_tlsf_block_t *)(start + POOL_HEADER);
+    block->size = size - POOL_OVERHEAD;
+    block_next(block)->size = 0;
+    block_release(tlsf, block);
+    return 0;
+}
+
+size_t mbed_tlsf_pool_size_for(size_t size)
+{
+    size = adjust_size(size);
+    if (size >= SMALL_BLOCK_SIZE) {
+        // The search skips the list this size would go on unless it is the
+        // smallest size on that list
+        size_t round = ((size_t)1 << (tlsf_fls((uint32_t)size) - MBED_TLSF_SL_INDEX_COUNT_LOG2)) - 1;
+        size = (size + round) & ~round;
+    }
+    if (size == 0 || size + POOL_OVERHEAD >= BLOCK_SIZE_MAX) {
+        return 0;
+    }
+    return size + POOL_OVERHEAD;
+}
+
+void *mbed_tlsf_malloc(mbed_tlsf_t *tlsf, size_t size)
+{
+    size = adjust_size(size);
+    if (size == 0) {
+        return NULL;
+    }
+
+    int fl, sl;
+    mapping_search(size, &fl, &sl);
+    mbed_tlsf_block_t *block = search_suitable_block(tlsf, &fl, &sl);
+    if (!block) {
+        return NULL;
+    }
+    MBED_ASSERT(block_is_free(block) && block_size(block) >= size);
+
+    remove_free_block(tlsf, block);
+    return block_prepare_used(tlsf, block, size);
+}
+
+void mbed_tlsf_free(mbed_tlsf_t *tlsf, void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+
+    mbed_tlsf_block_t *block = block_from_ptr(ptr);
+    MBED_ASSERT(!block_is_free(block));
+    block_release(tlsf, block);
+}
+
+void *mbed_tlsf_realloc(mbed_tlsf_t *tlsf, void *ptr, size_t size)
+{
+    if (!ptr) {
+        return mbed_tlsf_malloc(tlsf, size);
+    }
+    if (size == 0) {
+        mbed_tlsf_free(tlsf, ptr);
+        return NULL;
+    }
+
+    mbed_tlsf_block_t *block = block_from_ptr(ptr);
+    MBED_ASSERT(!block_is_free(block));
+    size_t adjusted = adjust_size(size);
+    if (adjusted == 0) {
+        return NULL;
+    }
+
+    size_t current = block_size(block);
+    if (adjusted > current) {
+        mbed_tlsf_block_t *next = block_next(block);
+        if (!block_is_free(next) || current + BLOCK_HEADER + block_size(next) < adjusted) {
+            void *new_ptr = mbed_tlsf_malloc(tlsf, size);
+            if (new_ptr) {
+                memcpy(new_ptr, ptr, current);
+                mbed_tlsf_free(tlsf, ptr);
+            }
+            return new_ptr;
+        }
+
+        // Grow into the free block after this one
+        remove_free_block(tlsf, next);
+        block->size += BLOCK_HEADER + block_size(next);
+        block_mark_used(block);
+    }
+
+    if (block_can_split(block, adjusted)) {
+        block_release(tlsf, block_split(block, adjusted));
+    }
+    return ptr;
+}
+
+size_t mbed_tlsf_block_size(const void *ptr)
+{
+    return block_size(block_from_ptr(ptr));
+}
+
+void mbed_tlsf_get_stats(mbed_tlsf_t *tlsf, mbed_tlsf_stats_t *stats)
+{
+    stats->pool_size = tlsf->pool_size;
+    stats->free_size = tlsf->free_size;
+    stats->free_cnt = tlsf->free_cnt;
+    stats->largest_free_size = 0;
+
+    // A request is rounded up to the first list whose blocks are all big
+    // enough, so the largest one which succeeds is the smallest size on the
+    // highest list in use, not the size of the largest block on it
+    if (tlsf->fl_bitmap) {
+        int fl = tlsf_fls(tlsf->fl_bitmap);
+        int sl = tlsf_fls(tlsf->sl_bitmap[fl]);
+        if (fl == 0) {
+            stats->largest_free_size = (size_t)sl << MBED_TLSF_ALIGN_LOG2;
+        } else {
+            int top = fl + MBED_TLSF_FL_INDEX_SHIFT - 1;
+            stats->largest_free_size = ((size_t)1 << top) +
+                                       ((size_t)sl << (top - MBED_TLSF_SL_INDEX_COUNT_LOG2));
+        }
+    }
+}
+
+int mbed_tlsf_check(mbed_tlsf_t *tlsf)
+{
+    size_t free_size = 0;
+    size_t free_cnt = 0;
+    size_t list_size = 0;
+    size_t list_cnt = 0;
+
+    for (mbed_tlsf_pool_t *pool = tlsf->pools; pool; pool = pool->next) {
+        mbed_tlsf_block_t *end = (mbed_tlsf_block_t *)((char *)pool + pool->size - BLOCK_HEADER);
+        mbed_tlsf_block_t *prev = NULL;
+        mbed_tlsf_block_t *block = (mbed_tlsf_block_t *)((char *)pool + POOL_HEADER);
+
+        while (block != end) {
+            if (block > end || block_size(block) < BLOCK_SIZE_MIN || block_size(block) % MBED_TLSF_ALIGN) {
+                return -1;
+            }
+            if (block_is_prev_free(block) != (prev && block_is_free(prev))) {
+                return -2;
+            }
+            if (block_is_prev_free(block) && block->prev_phys != prev) {
+                return -3;
+            }
+            if (block_is_prev_free(block) && block_is_free(block)) {
+                return -4;
+            }
+            if (block_is_free(block)) {
+                free_size += block_size(block);
+                free_cnt++;
+            }
+            prev = block;
+            block = block_next(block);
+        }
+
+        if (block_size(end) != 0 || block_is_free(end)) {
+            return -5;
+        }
+        if (block_is_prev_free(end) != (prev && block_is_free(prev))) {
+            return -2;
+        }
+    }
+
+    for (int fl = 0; fl < MBED_TLSF_FL_INDEX_COUNT; fl++) {
+        if (!(tlsf->fl_bitmap & ((uint32_t)1 << fl)) != !tlsf->sl_bitmap[fl]) {
+            return -6;
+        }
+        for (int sl = 0; sl < MBED_TLSF_SL_INDEX_COUNT; sl++) {
+            mbed_tlsf_block_t *block = tlsf->blocks[fl][sl];
+            if (!(tlsf->sl_bitmap[fl] & ((uint32_t)1 << sl)) != !block) {
+                return -7;
+            }
+            if (block && block->prev_free) {
+                return -8;
+            }
+            for (; block; block = block->next_free) {
+                int block_fl, block_sl;
+                mapping_insert(block_size(block), &block_fl, &block_sl);
+                if (!block_is_free(block) || block_fl != fl || block_sl != sl) {
+                    return -9;
+                }
+                if (block->next_free && block->next_free->prev_free != block) {
+                    return -8;
+                }
+                list_size += block_size(block);
+                list_cnt++;
+            }
+        }
+    }
+
+    // Every free block in the pools is on a list and nothing else is
+    if (list_size != free_size || list_cnt != free_cnt) {
+        return -10;
+    }
+    if (tlsf->free_size != free_size || tlsf->free_cnt != free_cnt) {
+        return -11;
+    }
+    return 0;
+}
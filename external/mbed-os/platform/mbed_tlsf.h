@@ -0,0 +1,190 @@
+
+/** \addtogroup platform */
+/** @{*/
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_TLSF_H
+#define MBED_TLSF_H
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Two level segregated fit allocator
+ *
+ *  Free blocks are kept in lists indexed by the position of the top bit of
+ *  their size and by the next MBED_TLSF_SL_INDEX_COUNT_LOG2 bits, with a
+ *  bitmap of the lists which aren't empty. Finding a block big enough for a
+ *  request and merging a freed block with its neighbours are both a fixed
+ *  number of steps, whatever the state of the heap.
+ *
+ *  Allocations are aligned to MBED_TLSF_ALIGN and cost two words each. An
+ *  instance isn't thread safe, so callers lock around it.
+ */
+
+/** Alignment and granularity of allocations */
+#define MBED_TLSF_ALIGN_LOG2            3
+#define MBED_TLSF_ALIGN                 (1 << MBED_TLSF_ALIGN_LOG2)
+
+/** Number of second level lists for each power of two */
+#define MBED_TLSF_SL_INDEX_COUNT_LOG2   4
+#define MBED_TLSF_SL_INDEX_COUNT        (1 << MBED_TLSF_SL_INDEX_COUNT_LOG2)
+
+/** Blocks and pools must be smaller than 1 << MBED_TLSF_FL_INDEX_MAX bytes */
+#ifndef MBED_TLSF_FL_INDEX_MAX
+#define MBED_TLSF_FL_INDEX_MAX          20
+#endif
+
+/* Sizes below 1 << MBED_TLSF_FL_INDEX_SHIFT share the first first level list
+ * and are split linearly across its second level lists. */
+#define MBED_TLSF_FL_INDEX_SHIFT        (MBED_TLSF_SL_INDEX_COUNT_LOG2 + MBED_TLSF_ALIGN_LOG2)
+#define MBED_TLSF_FL_INDEX_COUNT        (MBED_TLSF_FL_INDEX_MAX - MBED_TLSF_FL_INDEX_SHIFT + 1)
+
+typedef struct mbed_tlsf_block mbed_tlsf_block_t;
+typedef struct mbed_tlsf_pool mbed_tlsf_pool_t;
+
+struct mbed_tlsf_block {
+    mbed_tlsf_block_t *prev_phys;   /**< Block before this one in memory, only kept while it is free. */
+    size_t size;                    /**< Bytes after the header, with the free flags in the low bits. */
+    mbed_tlsf_block_t *next_free;   /**< Free list links, overlaid on the data of used blocks. */
+    mbed_tlsf_block_t *prev_free;
+};
+
+struct mbed_tlsf_pool {
+    mbed_tlsf_pool_t *next;         /**< Pool added before this one. */
+    size_t size;                    /**< Bytes from the start of this header to the end of the pool. */
+};
+
+/** Allocator state. A zero filled instance is an empty heap, so a static one
+ *  needs no initialisation.
+ */
+typedef struct {
+    uint32_t fl_bitmap;
+    uint32_t sl_bitmap[MBED_TLSF_FL_INDEX_COUNT];
+    mbed_tlsf_block_t *blocks[MBED_TLSF_FL_INDEX_COUNT][MBED_TLSF_SL_INDEX_COUNT];
+    mbed_tlsf_pool_t *pools;        /**< Most recently added pool first. */
+    size_t pool_size;               /**< Bytes handed to mbed_tlsf_add_pool(). */
+    size_t free_size;               /**< Bytes available in free blocks. */
+    size_t free_cnt;                /**< Number of free blocks. */
+} mbed_tlsf_t;
+
+typedef struct {
+    size_t pool_size;               /**< Bytes handed to mbed_tlsf_add_pool(). */
+    size_t free_size;               /**< Bytes available in free blocks. */
+    size_t largest_free_size;       /**< Largest allocation which would succeed. */
+    size_t free_cnt;                /**< Number of free blocks. */
+} mbed_tlsf_stats_t;
+
+/**
+ *  Empty an allocator, forgetting any pools it had.
+ *
+ *  @param tlsf     Allocator to initialise
+ */
+void mbed_tlsf_init(mbed_tlsf_t *tlsf);
+
+/**
+ *  Give the allocator a region of memory to allocate from.
+ *
+ *  A region which starts where the last one ended is joined onto it, so a
+ *  heap grown a piece at a time doesn't fragment at the joins.
+ *
+ *  @param tlsf     Allocator to add the memory to
+ *  @param mem      Start of the region
+ *  @param size     Size of the region in bytes
+ *  @return         0 on success, -1 if the region is too small or too large
+ */
+int mbed_tlsf_add_pool(mbed_tlsf_t *tlsf, void *mem, size_t size);
+
+/**
+ *  Size of a region which mbed_tlsf_add_pool() must be given for an
+ *  allocation of size bytes to be sure to succeed from it.
+ *
+ *  @param size     Size of the allocation
+ *  @return         Bytes needed, or 0 if the allocation is too large
+ */
+size_t mbed_tlsf_pool_size_for(size_t size);
+
+/**
+ *  Allocate a block of memory.
+ *
+ *  @param tlsf     Allocator to use
+ *  @param size     Bytes needed
+ *  @return         The block, or NULL if there is no free block large enough
+ */
+void *mbed_tlsf_malloc(mbed_tlsf_t *tlsf, size_t size);
+
+/**
+ *  Free a block returned by mbed_tlsf_malloc() or mbed_tlsf_realloc().
+ *
+ *  @param tlsf     Allocator the block came from
+ *  @param ptr      Block to free, or NULL
+ */
+void mbed_tlsf_free(mbed_tlsf_t *tlsf, void *ptr);
+
+/**
+ *  Resize a block, in place if the memory after it is free.
+ *
+ *  @param tlsf     Allocator the block came from
+ *  @param ptr      Block to resize, or NULL to allocate a new one
+ *  @param size     Bytes needed, or 0 to free the block
+ *  @return         The resized block, or NULL if there was no room, in which
+ *                  case the old block is left as it was
+ */
+void *mbed_tlsf_realloc(mbed_tlsf_t *tlsf, void *ptr, size_t size);
+
+/**
+ *  Number of bytes which may be used in an allocated block, which can be more
+ *  than were asked for.
+ *
+ *  @param ptr      Block returned by the allocator
+ *  @return         Usable size of the block
+ */
+size_t mbed_tlsf_block_size(const void *ptr);
+
+/**
+ *  Fill the passed in structure with the pool and free block sizes.
+ *
+ *  free_size - largest_free_size is the free memory that can't be had in one
+ *  piece, so their ratio is a measure of fragmentation. Only the free list
+ *  holding the largest blocks is searched.
+ *
+ *  @param tlsf     Allocator to report on
+ *  @param stats    A pointer to the mbed_tlsf_stats_t structure to fill
+ */
+void mbed_tlsf_get_stats(mbed_tlsf_t *tlsf, mbed_tlsf_stats_t *stats);
+
+/**
+ *  Walk every block of every pool and every free list, checking that the
+ *  block headers, free flags, free lists and bitmaps agree.
+ *
+ *  Takes time in proportion to the number of blocks. Debug builds also make
+ *  cheaper checks of the neighbouring blocks on each free.
+ *
+ *  @param tlsf     Allocator to check
+ *  @return         0 if the heap is consistent, otherwise a negative number
+ *                  identifying the first problem found
+ */
+int mbed_tlsf_check(mbed_tlsf_t *tlsf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/** @}*/
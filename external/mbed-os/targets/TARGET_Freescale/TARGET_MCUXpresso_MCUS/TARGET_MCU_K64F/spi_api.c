@@ -127,6 +127,38 @@ int spi_master_write(spi_t *obj, int value)
     return rx_data & 0xffff;
 }
 
+int spi_master_block_write(spi_t *obj, const char *tx_buffer, int tx_length, char *rx_buffer, int rx_length, char write_fill)
+{
+    SPI_Type *base = spi_address[obj->spi.instance];
+    int total = (tx_length > rx_length) ? tx_length : rx_length;
+    int fifo_size = FSL_FEATURE_DSPI_FIFO_SIZEn(base);
+    int tx_count = 0;
+    int rx_count = 0;
+    dspi_command_data_config_t command;
+    DSPI_GetDefaultDataCommandConfig(&command);
+
+    // Keep the TX FIFO topped up, but never have more frames in flight than
+    // the RX FIFO can hold
+    while (rx_count < total) {
+        if (tx_count < total && tx_count - rx_count < fifo_size) {
+            command.isEndOfQueue = (tx_count == total - 1);
+            DSPI_MasterWriteData(base, &command, (uint8_t)((tx_count < tx_length) ? tx_buffer[tx_count] : write_fill));
+            DSPI_ClearStatusFlags(base, kDSPI_TxFifoFillRequestFlag);
+            tx_count++;
+        }
+        if (base->SR & SPI_SR_RXCTR_MASK) {
+            char in = DSPI_ReadData(base);
+            if (rx_count < rx_length) {
+                rx_buffer[rx_count] = in;
+            }
+            rx_count++;
+        }
+    }
+
+    DSPI_ClearStatusFlags(base, kDSPI_RxFifoDrainRequestFlag | kDSPI_EndOfQueueFlag | kDSPI_TxCompleteFlag);
+    return total;
+}
+
 int spi_slave_receive(spi_t *obj)
 {
     return spi_readable(obj);
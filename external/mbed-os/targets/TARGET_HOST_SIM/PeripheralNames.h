@@ -0,0 +1,57 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_PERIPHERALNAMES_H
+#define MBED_PERIPHERALNAMES_H
+
+#include "cmsis.h"
+#include "PinNames.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    UART_0 = 0,
+    UART_1,
+    UART_2
+} UARTName;
+
+typedef enum {
+    SPI_0 = 0
+} SPIName;
+
+typedef enum {
+    I2C_0 = 0
+} I2CName;
+
+#define STDIO_UART_TX     USBTX
+#define STDIO_UART_RX     USBRX
+#define STDIO_UART        UART_0
+
+// Default peripherals
+#define MBED_SPI0         SPI_MOSI, SPI_MISO, SPI_SCK, SPI_CS
+
+#define MBED_UART1        UART1_TX, UART1_RX
+#define MBED_UART2        UART2_TX, UART2_RX
+#define MBED_UARTUSB      USBTX, USBRX
+
+#define MBED_I2C0         I2C_SDA, I2C_SCL
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
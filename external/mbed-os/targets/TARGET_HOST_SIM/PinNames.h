@@ -0,0 +1,77 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_PINNAMES_H
+#define MBED_PINNAMES_H
+
+#include "cmsis.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    PIN_INPUT,
+    PIN_OUTPUT
+} PinDirection;
+
+/* A single simulated port of 32 pins. */
+typedef enum {
+    p0 = 0,
+          p1,  p2,  p3,  p4,  p5,  p6,  p7,  p8,  p9, p10, p11, p12, p13, p14, p15,
+    p16, p17, p18, p19, p20, p21, p22, p23, p24, p25, p26, p27, p28, p29, p30, p31,
+
+    // UART0 is the host's stdin/stdout
+    USBTX = p0,
+    USBRX = p1,
+
+    UART1_TX = p2,
+    UART1_RX = p3,
+    UART2_TX = p4,
+    UART2_RX = p5,
+
+    SPI_MOSI = p6,
+    SPI_MISO = p7,
+    SPI_SCK  = p8,
+    SPI_CS   = p9,
+
+    I2C_SDA  = p10,
+    I2C_SCL  = p11,
+
+    LED1 = p16,
+    LED2 = p17,
+    LED3 = p18,
+    LED4 = p19,
+
+    SW1 = p20,
+    SW2 = p21,
+
+    // Not connected
+    NC = (int)0xFFFFFFFF
+} PinName;
+
+typedef enum {
+    PullUp = 0,
+    PullDown = 1,
+    PullNone = 2,
+    OpenDrain = 3,
+    PullDefault = PullNone
+} PinMode;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,145 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* The parts of CMSIS-Core that mbed uses, for a host process standing in for
+ * a Cortex-M. Interrupt handlers run one at a time on a dispatch thread and
+ * PRIMASK is a lock which keeps them out while thread code holds it, see
+ * host_sim_core.c. LDREX/STREX are built on a compare and swap of the value
+ * seen by the load, which gives the retry loops in mbed_critical.c the same
+ * outcome as a hardware monitor.
+ */
+#ifndef MBED_CMSIS_H
+#define MBED_CMSIS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define __I     volatile const
+#define __O     volatile
+#define __IO    volatile
+
+#define __ASM           __asm
+#define __INLINE        inline
+#define __STATIC_INLINE static inline
+
+typedef enum IRQn {
+    /* Cortex-M core exceptions */
+    NonMaskableInt_IRQn = -14,
+    HardFault_IRQn      = -13,
+    SVCall_IRQn         = -5,
+    PendSV_IRQn         = -2,
+    SysTick_IRQn        = -1,
+
+    /* Simulated peripherals */
+    US_TICKER_IRQn      = 0,
+    LP_TICKER_IRQn      = 1,
+    UART0_IRQn          = 2,
+    UART1_IRQn          = 3,
+    UART2_IRQn          = 4,
+    GPIO_IRQn           = 5,
+
+    /* Only ever pended by software */
+    SWI0_IRQn           = 6,
+    SWI1_IRQn           = 7,
+    SWI2_IRQn           = 8,
+    SWI3_IRQn           = 9
+} IRQn_Type;
+
+#define __NVIC_PRIO_BITS    3
+
+extern uint32_t SystemCoreClock;
+
+void SystemInit(void);
+void SystemCoreClockUpdate(void);
+
+void NVIC_EnableIRQ(IRQn_Type IRQn);
+void NVIC_DisableIRQ(IRQn_Type IRQn);
+uint32_t NVIC_GetPendingIRQ(IRQn_Type IRQn);
+void NVIC_SetPendingIRQ(IRQn_Type IRQn);
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+uint32_t NVIC_GetActive(IRQn_Type IRQn);
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority);
+uint32_t NVIC_GetPriority(IRQn_Type IRQn);
+void NVIC_SystemReset(void);
+
+void __enable_irq(void);
+void __disable_irq(void);
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t priMask);
+uint32_t __get_IPSR(void);
+void __WFI(void);
+void __WFE(void);
+void __SEV(void);
+
+#define __NOP()     __asm volatile ("nop")
+#define __DMB()     __sync_synchronize()
+#define __DSB()     __sync_synchronize()
+#define __ISB()     __sync_synchronize()
+#define __BKPT(v)   __builtin_trap()
+
+#define __REV(v)    __builtin_bswap32(v)
+#define __CLZ(v)    ((uint8_t)((v) ? __builtin_clz(v) : 32))
+
+/* Value returned by the last exclusive load on this thread */
+extern __thread uint32_t host_sim_exclusive_value;
+
+static inline uint8_t __LDREXB(volatile uint8_t *addr)
+{
+    host_sim_exclusive_value = *addr;
+    return (uint8_t)host_sim_exclusive_value;
+}
+
+static inline uint16_t __LDREXH(volatile uint16_t *addr)
+{
+    host_sim_exclusive_value = *addr;
+    return (uint16_t)host_sim_exclusive_value;
+}
+
+static inline uint32_t __LDREXW(volatile uint32_t *addr)
+{
+    host_sim_exclusive_value = *addr;
+    return host_sim_exclusive_value;
+}
+
+static inline uint32_t __STREXB(uint8_t value, volatile uint8_t *addr)
+{
+    return !__sync_bool_compare_and_swap(addr, (uint8_t)host_sim_exclusive_value, value);
+}
+
+static inline uint32_t __STREXH(uint16_t value, volatile uint16_t *addr)
+{
+    return !__sync_bool_compare_and_swap(addr, (uint16_t)host_sim_exclusive_value, value);
+}
+
+static inline uint32_t __STREXW(uint32_t value, volatile uint32_t *addr)
+{
+    return !__sync_bool_compare_and_swap(addr, host_sim_exclusive_value, value);
+}
+
+static inline void __CLREX(void)
+{
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#include "cmsis_nvic.h"
+
+#endif
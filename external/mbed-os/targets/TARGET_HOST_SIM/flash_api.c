@@ -0,0 +1,190 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* Flash which follows the strictest NOR rules: erases set whole sectors to
+ * 0xFF and each byte can be programmed once between erases, as on flash with
+ * ECC. Requests that real flash would reject or silently corrupt are
+ * reported on stderr and fail.
+ *
+ * FlashIAP reads the flash by address so it is mapped below 4GB. Setting
+ * HOST_SIM_FLASH to a file name backs it with that file, which keeps its
+ * contents from one run to the next.
+ */
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "flash_api.h"
+
+#if DEVICE_FLASH
+
+#ifndef MAP_32BIT
+#define MAP_32BIT 0
+#endif
+
+#ifndef HOST_SIM_FLASH_SIZE
+#define HOST_SIM_FLASH_SIZE         (512 * 1024)
+#endif
+#ifndef HOST_SIM_FLASH_SECTOR_SIZE
+#define HOST_SIM_FLASH_SECTOR_SIZE  4096
+#endif
+#ifndef HOST_SIM_FLASH_PAGE_SIZE
+#define HOST_SIM_FLASH_PAGE_SIZE    256
+#endif
+
+static uint8_t *flash_base;
+
+// One bit for each byte programmed since its sector was last erased
+static uint8_t flash_programmed[HOST_SIM_FLASH_SIZE / 8];
+
+static uint32_t flash_start(void) {
+    return (uint32_t)(uintptr_t)flash_base;
+}
+
+static int flash_contains(uint32_t address, uint32_t size) {
+    return address >= flash_start() && size <= HOST_SIM_FLASH_SIZE &&
+           address - flash_start() <= HOST_SIM_FLASH_SIZE - size;
+}
+
+static int flash_is_programmed(uint32_t offset) {
+    return (flash_programmed[offset / 8] >> (offset % 8)) & 1;
+}
+
+static void flash_set_programmed(uint32_t offset, int programmed) {
+    if (programmed) {
+        flash_programmed[offset / 8] |= 1 << (offset % 8);
+    } else {
+        flash_programmed[offset / 8] &= ~(1 << (offset % 8));
+    }
+}
+
+static uint8_t *flash_map(void) {
+    const char *name = getenv("HOST_SIM_FLASH");
+    int fd = -1;
+    int blank = 1;
+
+    if (name != NULL) {
+        struct stat st;
+
+        fd = open(name, O_RDWR | O_CREAT, 0666);
+        if (fd < 0 || fstat(fd, &st) < 0) {
+            perror("host_sim: HOST_SIM_FLASH");
+            return NULL;
+        }
+        blank = st.st_size < HOST_SIM_FLASH_SIZE;
+        if (blank && ftruncate(fd, HOST_SIM_FLASH_SIZE) < 0) {
+            perror("host_sim: HOST_SIM_FLASH");
+            close(fd);
+            return NULL;
+        }
+    }
+
+    void *map = mmap(NULL, HOST_SIM_FLASH_SIZE, PROT_READ | PROT_WRITE,
+                     (fd < 0 ? MAP_PRIVATE | MAP_ANONYMOUS : MAP_SHARED) | MAP_32BIT, fd, 0);
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (map == MAP_FAILED || (uintptr_t)map + HOST_SIM_FLASH_SIZE > 0xFFFFFFFFUL) {
+        fprintf(stderr, "host_sim: can't map the flash below 4GB\n");
+        return NULL;
+    }
+
+    if (blank) {
+        memset(map, 0xFF, HOST_SIM_FLASH_SIZE);
+    }
+    // Bytes kept from an earlier run count as programmed unless they're 0xFF
+    for (uint32_t i = 0; i < HOST_SIM_FLASH_SIZE; i++) {
+        flash_set_programmed(i, ((uint8_t *)map)[i] != 0xFF);
+    }
+    return (uint8_t *)map;
+}
+
+int32_t flash_init(flash_t *obj) {
+    if (flash_base == NULL) {
+        flash_base = flash_map();
+    }
+    obj->base = flash_base;
+    return flash_base ? 0 : -1;
+}
+
+int32_t flash_free(flash_t *obj) {
+    return 0;
+}
+
+int32_t flash_erase_sector(flash_t *obj, uint32_t address) {
+    if (!flash_contains(address, HOST_SIM_FLASH_SECTOR_SIZE) ||
+        (address - flash_start()) % HOST_SIM_FLASH_SECTOR_SIZE != 0) {
+        fprintf(stderr, "host_sim: bad flash erase at 0x%08lx\n", (unsigned long)address);
+        return -1;
+    }
+
+    uint32_t offset = address - flash_start();
+    memset(flash_base + offset, 0xFF, HOST_SIM_FLASH_SECTOR_SIZE);
+    for (uint32_t i = 0; i < HOST_SIM_FLASH_SECTOR_SIZE; i++) {
+        flash_set_programmed(offset + i, 0);
+    }
+    return 0;
+}
+
+int32_t flash_program_page(flash_t *obj, uint32_t address, const uint8_t *data, uint32_t size) {
+    uint32_t offset = address - flash_start();
+
+    if (!flash_contains(address, size) || size == 0 ||
+        offset % HOST_SIM_FLASH_PAGE_SIZE != 0 || size % HOST_SIM_FLASH_PAGE_SIZE != 0 ||
+        offset / HOST_SIM_FLASH_SECTOR_SIZE != (offset + size - 1) / HOST_SIM_FLASH_SECTOR_SIZE) {
+        fprintf(stderr, "host_sim: bad flash program of %lu bytes at 0x%08lx\n",
+                (unsigned long)size, (unsigned long)address);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < size; i++) {
+        if (flash_is_programmed(offset + i)) {
+            fprintf(stderr, "host_sim: flash program of 0x%08lx, which was programmed since it was erased\n",
+                    (unsigned long)(address + i));
+            return -1;
+        }
+    }
+    memcpy(flash_base + offset, data, size);
+    for (uint32_t i = 0; i < size; i++) {
+        flash_set_programmed(offset + i, 1);
+    }
+    return 0;
+}
+
+uint32_t flash_get_sector_size(const flash_t *obj, uint32_t address) {
+    if (!flash_contains(address, 1)) {
+        return MBED_FLASH_INVALID_SIZE;
+    }
+    return HOST_SIM_FLASH_SECTOR_SIZE;
+}
+
+uint32_t flash_get_page_size(const flash_t *obj) {
+    return HOST_SIM_FLASH_PAGE_SIZE;
+}
+
+uint32_t flash_get_start_address(const flash_t *obj) {
+    return flash_start();
+}
+
+uint32_t flash_get_size(const flash_t *obj) {
+    return HOST_SIM_FLASH_SIZE;
+}
+
+#endif
@@ -0,0 +1,92 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* The 32 pins share one word of levels. By default it lives in the process,
+ * setting HOST_SIM_GPIO to a file name maps it from that file instead so that
+ * another process, such as a test bench, can drive the inputs and watch the
+ * outputs while the application runs.
+ */
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "mbed_assert.h"
+#include "gpio_api.h"
+#include "pinmap.h"
+#include "host_sim.h"
+
+static uint32_t gpio_ram_levels;
+volatile uint32_t *host_sim_gpio_levels = &gpio_ram_levels;
+
+static pthread_once_t gpio_once = PTHREAD_ONCE_INIT;
+
+static void gpio_map_levels(void) {
+    const char *name = getenv("HOST_SIM_GPIO");
+    if (name == NULL) {
+        return;
+    }
+
+    int fd = open(name, O_RDWR | O_CREAT, 0666);
+    if (fd < 0 || ftruncate(fd, sizeof(uint32_t)) < 0) {
+        perror("host_sim: HOST_SIM_GPIO");
+        exit(1);
+    }
+    void *levels = mmap(NULL, sizeof(uint32_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (levels == MAP_FAILED) {
+        perror("host_sim: HOST_SIM_GPIO");
+        exit(1);
+    }
+    host_sim_gpio_levels = (volatile uint32_t *)levels;
+}
+
+uint32_t gpio_set(PinName pin) {
+    MBED_ASSERT(pin != (PinName)NC);
+    MBED_ASSERT((int)pin >= 0 && (int)pin < 32);
+    pthread_once(&gpio_once, gpio_map_levels);
+
+    return 1U << pin;
+}
+
+void gpio_init(gpio_t *obj, PinName pin) {
+    obj->pin = pin;
+    if (pin == (PinName)NC)
+        return;
+
+    obj->mask = gpio_set(pin);
+}
+
+/* Pull resistors set the level of an input which nothing else drives. */
+void gpio_mode(gpio_t *obj, PinMode mode) {
+    if (mode == PullUp) {
+        gpio_write(obj, 1);
+    } else if (mode == PullDown) {
+        gpio_write(obj, 0);
+    }
+}
+
+void gpio_dir(gpio_t *obj, PinDirection direction) {
+    MBED_ASSERT(obj->pin != (PinName)NC);
+}
+
+void host_sim_gpio_set(PinName pin, int value) {
+    gpio_t gpio;
+
+    gpio_init(&gpio, pin);
+    gpio_write(&gpio, value);
+}
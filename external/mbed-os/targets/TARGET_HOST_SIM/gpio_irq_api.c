@@ -0,0 +1,139 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* Edges are found by a thread which compares the pin levels with the ones it
+ * saw on its last pass, every HOST_SIM_GPIO_POLL_US, as they can be changed
+ * by another process through the HOST_SIM_GPIO file.
+ */
+#include <stddef.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "gpio_irq_api.h"
+#include "mbed_error.h"
+#include "cmsis.h"
+#include "host_sim.h"
+
+#if DEVICE_INTERRUPTIN
+
+#ifndef HOST_SIM_GPIO_POLL_US
+#define HOST_SIM_GPIO_POLL_US   1000
+#endif
+
+#define CHANNEL_NUM     32
+
+static uint32_t channel_ids[CHANNEL_NUM] = {0};
+static gpio_irq_handler irq_handler;
+
+static volatile uint32_t rise_enabled;
+static volatile uint32_t fall_enabled;
+static volatile uint32_t rise_status;
+static volatile uint32_t fall_status;
+
+static uint32_t poll_levels;
+static pthread_once_t poll_once = PTHREAD_ONCE_INIT;
+
+static void *poll_thread(void *arg) {
+    uint32_t last = poll_levels;
+
+    while (1) {
+        usleep(HOST_SIM_GPIO_POLL_US);
+
+        uint32_t now = *host_sim_gpio_levels;
+        uint32_t rise = now & ~last & rise_enabled;
+        uint32_t fall = ~now & last & fall_enabled;
+        last = now;
+
+        if (rise | fall) {
+            __sync_fetch_and_or(&rise_status, rise);
+            __sync_fetch_and_or(&fall_status, fall);
+            NVIC_SetPendingIRQ(GPIO_IRQn);
+        }
+    }
+    return NULL;
+}
+
+static void poll_start(void) {
+    pthread_t thread;
+
+    // Edges from here on count, even if they come before the thread runs
+    poll_levels = *host_sim_gpio_levels;
+    host_sim_thread_create(&thread, poll_thread, NULL);
+}
+
+static void handle_interrupt_in(void) {
+    uint32_t rise = __sync_fetch_and_and(&rise_status, 0);
+    uint32_t fall = __sync_fetch_and_and(&fall_status, 0);
+    uint8_t bitloc;
+
+    while (rise > 0) {
+        bitloc = 31 - __CLZ(rise);
+        if (channel_ids[bitloc] != 0)
+            irq_handler(channel_ids[bitloc], IRQ_RISE);
+        rise -= 1U << bitloc;
+    }
+
+    while (fall > 0) {
+        bitloc = 31 - __CLZ(fall);
+        if (channel_ids[bitloc] != 0)
+            irq_handler(channel_ids[bitloc], IRQ_FALL);
+        fall -= 1U << bitloc;
+    }
+}
+
+int gpio_irq_init(gpio_irq_t *obj, PinName pin, gpio_irq_handler handler, uint32_t id) {
+    if (pin == NC) return -1;
+
+    irq_handler = handler;
+
+    obj->ch = pin;
+    channel_ids[obj->ch] = id;
+
+    pthread_once(&poll_once, poll_start);
+
+    NVIC_SetVector(GPIO_IRQn, (uintptr_t)handle_interrupt_in);
+    NVIC_EnableIRQ(GPIO_IRQn);
+    return 0;
+}
+
+void gpio_irq_free(gpio_irq_t *obj) {
+    gpio_irq_set(obj, IRQ_RISE, 0);
+    gpio_irq_set(obj, IRQ_FALL, 0);
+    channel_ids[obj->ch] = 0;
+}
+
+void gpio_irq_set(gpio_irq_t *obj, gpio_irq_event event, uint32_t enable) {
+    uint32_t mask = 1U << obj->ch;
+    volatile uint32_t *enabled = (event == IRQ_RISE) ? &rise_enabled : &fall_enabled;
+
+    if (event != IRQ_RISE && event != IRQ_FALL)
+        return;
+
+    if (enable) {
+        __sync_fetch_and_or(enabled, mask);
+    } else {
+        __sync_fetch_and_and(enabled, ~mask);
+    }
+}
+
+void gpio_irq_enable(gpio_irq_t *obj) {
+    NVIC_EnableIRQ(GPIO_IRQn);
+}
+
+void gpio_irq_disable(gpio_irq_t *obj) {
+    NVIC_DisableIRQ(GPIO_IRQn);
+}
+
+#endif
@@ -0,0 +1,82 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_HOST_SIM_H
+#define MBED_HOST_SIM_H
+
+#include <pthread.h>
+#include "cmsis.h"
+#include "PinNames.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Starts a thread for one of the simulated peripherals. Its stack is mapped
+ * below 4GB like the rest of the process, as mbed keeps addresses of stack
+ * objects in uint32_t handler ids.
+ */
+int host_sim_thread_create(pthread_t *thread, void *(*entry)(void *), void *arg);
+
+/* Microseconds since the process started, from CLOCK_MONOTONIC. */
+uint64_t host_sim_time_us(void);
+
+/* Command line arguments of the executable, which mbed's main() doesn't
+ * take. host_sim_argv()[host_sim_argc()] is NULL.
+ */
+int host_sim_argc(void);
+char **host_sim_argv(void);
+
+/* Ticker channels, see host_sim_ticker.c */
+void host_sim_ticker_init(int channel, IRQn_Type irq, uintptr_t vector);
+void host_sim_ticker_set(int channel, uint32_t timestamp);
+void host_sim_ticker_disable(int channel);
+
+/* Drives an input pin from outside of the application, as a test bench
+ * would. The level is also seen by any other process sharing the pin file
+ * named by HOST_SIM_GPIO.
+ */
+void host_sim_gpio_set(PinName pin, int value);
+
+/* Turns UART pacing on or off, overriding HOST_SIM_UART_PACED, see
+ * serial_api.c
+ */
+void host_sim_uart_set_paced(int paced);
+
+/* Storage driver, see storage_driver.c */
+typedef struct {
+    uint64_t programmed;    /* bytes programmed */
+    uint32_t program_ops;
+    uint64_t erased;        /* bytes erased */
+    uint32_t erase_ops;
+} host_sim_storage_stats_t;
+
+void host_sim_storage_get_stats(host_sim_storage_stats_t *stats);
+void host_sim_storage_reset_stats(void);
+
+/* Cuts the power during the program or erase operation which follows the
+ * next ops ones: it does half of its work and fails, as do all storage
+ * operations after it until host_sim_storage_restore_power(). The contents
+ * of the storage are kept. -1 never cuts the power.
+ */
+void host_sim_storage_cut_power_after(int ops);
+int host_sim_storage_is_powered(void);
+void host_sim_storage_restore_power(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
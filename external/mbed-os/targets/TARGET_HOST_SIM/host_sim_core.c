@@ -0,0 +1,366 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* The Cortex-M core of the host simulation.
+ *
+ * Interrupt handlers run one at a time on a dispatch thread, highest NVIC
+ * priority first. While a handler runs the dispatch thread holds cpu_lock,
+ * and thread mode code takes the same lock when it sets PRIMASK, so a
+ * critical section keeps every handler out just as it does on hardware.
+ * Outside of a critical section handlers run alongside thread mode code
+ * rather than pre-empting it.
+ *
+ * The application's main() runs on a thread of its own whose stack, like the
+ * program image and the heap, is kept below 4GB. The HAL passes handler ids,
+ * which the drivers fill with object addresses, as uint32_t; vectors are
+ * stored at full width.
+ */
+#define _GNU_SOURCE
+#include <malloc.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cmsis.h"
+#include "host_sim.h"
+#include "mbed_interface.h"
+
+#ifndef MAP_32BIT
+#define MAP_32BIT 0
+#endif
+
+#define HOST_SIM_STACK_SIZE     (1024 * 1024)
+#define HOST_SIM_IRQ_COUNT      (NVIC_NUM_VECTORS - NVIC_USER_IRQ_OFFSET)
+
+uint32_t SystemCoreClock = 100000000;
+
+__thread uint32_t host_sim_exclusive_value;
+
+/* Held while a handler runs or thread mode code has interrupts disabled */
+static pthread_mutex_t cpu_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Guards the NVIC state, nvic_cond is signalled whenever any of it changes */
+static pthread_mutex_t nvic_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t nvic_cond = PTHREAD_COND_INITIALIZER;
+static uintptr_t nvic_vectors[NVIC_NUM_VECTORS];
+static uint8_t nvic_priority[HOST_SIM_IRQ_COUNT];
+static uint32_t nvic_enabled;
+static uint32_t nvic_pending;
+static uint32_t nvic_active;
+static uint32_t nvic_events;
+
+static __thread uint32_t primask;
+static __thread uint32_t ipsr;
+
+static uint64_t start_ns;
+static int main_argc;
+static char **main_argv;
+
+extern void mbed_sdk_init(void);
+extern void mbed_main(void);
+extern int __real_main(void);
+
+static uint64_t monotonic_ns(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+uint64_t host_sim_time_us(void) {
+    return (monotonic_ns() - start_ns) / 1000;
+}
+
+int host_sim_argc(void) {
+    return main_argc;
+}
+
+char **host_sim_argv(void) {
+    return main_argv;
+}
+
+int host_sim_thread_create(pthread_t *thread, void *(*entry)(void *), void *arg) {
+    pthread_attr_t attr;
+    int ret;
+
+    void *stack = mmap(NULL, HOST_SIM_STACK_SIZE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK | MAP_32BIT, -1, 0);
+    if (stack == MAP_FAILED) {
+        return -1;
+    }
+    if ((uintptr_t)stack + HOST_SIM_STACK_SIZE > 0xFFFFFFFFUL) {
+        munmap(stack, HOST_SIM_STACK_SIZE);
+        return -1;
+    }
+
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, HOST_SIM_STACK_SIZE);
+    ret = pthread_create(thread, &attr, entry, arg);
+    pthread_attr_destroy(&attr);
+    return ret;
+}
+
+/******************************************************************************
+ * NVIC
+ ******************************************************************************/
+static int nvic_next_irq(void) {
+    uint32_t ready = nvic_pending & nvic_enabled;
+    int next = -1;
+
+    for (int i = 0; ready; i++, ready >>= 1) {
+        if ((ready & 1) && (next < 0 || nvic_priority[i] < nvic_priority[next])) {
+            next = i;
+        }
+    }
+    return next;
+}
+
+static void *dispatch_thread(void *arg) {
+    pthread_mutex_lock(&nvic_lock);
+    while (1) {
+        while (nvic_next_irq() < 0) {
+            pthread_cond_wait(&nvic_cond, &nvic_lock);
+        }
+        pthread_mutex_unlock(&nvic_lock);
+
+        // Wait for thread mode to leave any critical section, then look again
+        // as it may have cleared or disabled the interrupt in the meantime.
+        pthread_mutex_lock(&cpu_lock);
+        pthread_mutex_lock(&nvic_lock);
+        int irq = nvic_next_irq();
+        if (irq >= 0) {
+            void (*handler)(void) = (void (*)(void))nvic_vectors[irq + NVIC_USER_IRQ_OFFSET];
+
+            nvic_pending &= ~(1U << irq);
+            nvic_active |= 1U << irq;
+            pthread_mutex_unlock(&nvic_lock);
+
+            if (handler == NULL) {
+                fprintf(stderr, "host_sim: no handler for IRQ %d\n", irq);
+                mbed_die();
+            }
+            ipsr = irq + NVIC_USER_IRQ_OFFSET;
+            handler();
+            ipsr = 0;
+            primask = 0;
+
+            pthread_mutex_lock(&nvic_lock);
+            nvic_active &= ~(1U << irq);
+            nvic_events++;
+            pthread_cond_broadcast(&nvic_cond);
+        }
+        pthread_mutex_unlock(&cpu_lock);
+    }
+    return NULL;
+}
+
+static void nvic_update(uint32_t *reg, IRQn_Type IRQn, int set) {
+    if ((int)IRQn < 0 || (int)IRQn >= HOST_SIM_IRQ_COUNT) {
+        return;
+    }
+    pthread_mutex_lock(&nvic_lock);
+    if (set) {
+        *reg |= 1U << IRQn;
+    } else {
+        *reg &= ~(1U << IRQn);
+    }
+    nvic_events++;
+    pthread_cond_broadcast(&nvic_cond);
+    pthread_mutex_unlock(&nvic_lock);
+}
+
+static uint32_t nvic_get(const uint32_t *reg, IRQn_Type IRQn) {
+    if ((int)IRQn < 0 || (int)IRQn >= HOST_SIM_IRQ_COUNT) {
+        return 0;
+    }
+    return (__atomic_load_n(reg, __ATOMIC_ACQUIRE) >> IRQn) & 1;
+}
+
+void NVIC_EnableIRQ(IRQn_Type IRQn) {
+    nvic_update(&nvic_enabled, IRQn, 1);
+}
+
+void NVIC_DisableIRQ(IRQn_Type IRQn) {
+    nvic_update(&nvic_enabled, IRQn, 0);
+}
+
+uint32_t NVIC_GetPendingIRQ(IRQn_Type IRQn) {
+    return nvic_get(&nvic_pending, IRQn);
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type IRQn) {
+    nvic_update(&nvic_pending, IRQn, 1);
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn) {
+    nvic_update(&nvic_pending, IRQn, 0);
+}
+
+uint32_t NVIC_GetActive(IRQn_Type IRQn) {
+    return nvic_get(&nvic_active, IRQn);
+}
+
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority) {
+    if ((int)IRQn >= 0 && (int)IRQn < HOST_SIM_IRQ_COUNT) {
+        nvic_priority[IRQn] = priority & ((1 << __NVIC_PRIO_BITS) - 1);
+    }
+}
+
+uint32_t NVIC_GetPriority(IRQn_Type IRQn) {
+    if ((int)IRQn >= 0 && (int)IRQn < HOST_SIM_IRQ_COUNT) {
+        return nvic_priority[IRQn];
+    }
+    return 0;
+}
+
+void NVIC_SetVector(IRQn_Type IRQn, uintptr_t vector) {
+    pthread_mutex_lock(&nvic_lock);
+    nvic_vectors[IRQn + NVIC_USER_IRQ_OFFSET] = vector;
+    pthread_mutex_unlock(&nvic_lock);
+}
+
+uintptr_t NVIC_GetVector(IRQn_Type IRQn) {
+    pthread_mutex_lock(&nvic_lock);
+    uintptr_t vector = nvic_vectors[IRQn + NVIC_USER_IRQ_OFFSET];
+    pthread_mutex_unlock(&nvic_lock);
+    return vector;
+}
+
+/* A reset starts the executable over again with the same arguments. */
+void NVIC_SystemReset(void) {
+    fflush(stdout);
+    fflush(stderr);
+    execv("/proc/self/exe", main_argv);
+    abort();
+}
+
+/******************************************************************************
+ * CORE REGISTERS
+ ******************************************************************************/
+void __disable_irq(void) {
+    if (!primask) {
+        if (!ipsr) {
+            pthread_mutex_lock(&cpu_lock);
+        }
+        primask = 1;
+    }
+}
+
+void __enable_irq(void) {
+    if (primask) {
+        primask = 0;
+        if (!ipsr) {
+            pthread_mutex_unlock(&cpu_lock);
+        }
+    }
+}
+
+uint32_t __get_PRIMASK(void) {
+    return primask;
+}
+
+void __set_PRIMASK(uint32_t priMask) {
+    if (priMask & 1) {
+        __disable_irq();
+    } else {
+        __enable_irq();
+    }
+}
+
+uint32_t __get_IPSR(void) {
+    return ipsr;
+}
+
+/* Returns once an enabled interrupt is pending or a handler has run, whether
+ * or not PRIMASK lets it be taken.
+ */
+void __WFI(void) {
+    pthread_mutex_lock(&nvic_lock);
+    uint32_t events = nvic_events;
+    while (events == nvic_events && !(nvic_pending & nvic_enabled)) {
+        pthread_cond_wait(&nvic_cond, &nvic_lock);
+    }
+    pthread_mutex_unlock(&nvic_lock);
+}
+
+void __WFE(void) {
+    __WFI();
+}
+
+void __SEV(void) {
+    pthread_mutex_lock(&nvic_lock);
+    nvic_events++;
+    pthread_cond_broadcast(&nvic_cond);
+    pthread_mutex_unlock(&nvic_lock);
+}
+
+void SystemInit(void) {
+}
+
+void SystemCoreClockUpdate(void) {
+}
+
+/******************************************************************************
+ * STARTUP
+ ******************************************************************************/
+/* Runs ahead of the C++ constructors, which is where mbed_sdk_init() is
+ * called from on the devices too.
+ */
+__attribute__((constructor(101))) static void host_sim_init(void) {
+    pthread_t thread;
+
+    // All threads allocate from the brk heap which sits just above the
+    // program image, well below 4GB.
+    mallopt(M_ARENA_MAX, 1);
+    mallopt(M_MMAP_MAX, 0);
+
+    start_ns = monotonic_ns();
+    if (host_sim_thread_create(&thread, dispatch_thread, NULL) != 0) {
+        fprintf(stderr, "host_sim: can't start the interrupt dispatch thread\n");
+        abort();
+    }
+    mbed_sdk_init();
+}
+
+static void *main_thread(void *arg) {
+    mbed_main();
+    exit(__real_main());
+}
+
+int __wrap_main(int argc, char *argv[]) {
+    pthread_t thread;
+
+    main_argc = argc;
+    main_argv = argv;
+    if (host_sim_thread_create(&thread, main_thread, NULL) != 0) {
+        fprintf(stderr, "host_sim: can't map a stack for main() below 4GB\n");
+        return 1;
+    }
+    pthread_join(thread, NULL);
+    return 0;
+}
+
+/* Stops with a core dump so that the failure can be looked at in a debugger
+ * instead of flashing the LEDs.
+ */
+void mbed_die(void) {
+    fflush(stdout);
+    fflush(stderr);
+    abort();
+}
@@ -0,0 +1,95 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* The host's C library doesn't call into mbed_retarget.cpp the way newlib
+ * does, so fopen() is wrapped at link time to hand the names which mbed
+ * understands to its _open(): ":<pointer>" for the FileLike objects behind
+ * Stream and Serial, and "/<mount>/..." for mbed file systems. The resulting
+ * handles are turned into FILE streams with fopencookie(). Every other name
+ * is a host path.
+ */
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+
+extern int _open(const char *name, int openmode);
+extern int _close(int fh);
+extern int _read(int fh, unsigned char *buffer, unsigned int length, int mode);
+extern int _write(int fh, const unsigned char *buffer, unsigned int length, int mode);
+extern int _lseek(int fh, int offset, int whence);
+
+extern FILE *__real_fopen(const char *path, const char *mode);
+
+static int mode_to_openmode(const char *mode) {
+    int openmode;
+
+    switch (mode[0]) {
+        case 'w': openmode = O_WRONLY | O_CREAT | O_TRUNC; break;
+        case 'a': openmode = O_WRONLY | O_CREAT | O_APPEND; break;
+        default:  openmode = O_RDONLY; break;
+    }
+    if (strchr(mode, '+') != NULL) {
+        openmode = (openmode & ~O_ACCMODE) | O_RDWR;
+    }
+    return openmode;
+}
+
+static ssize_t handle_read(void *cookie, char *buffer, size_t size) {
+    int n = _read((int)(intptr_t)cookie, (unsigned char *)buffer, size, 0);
+    return n < 0 ? -1 : n;
+}
+
+static ssize_t handle_write(void *cookie, const char *buffer, size_t size) {
+    int n = _write((int)(intptr_t)cookie, (const unsigned char *)buffer, size, 0);
+    return n < 0 ? 0 : n;
+}
+
+static int handle_seek(void *cookie, off64_t *offset, int whence) {
+    int position = _lseek((int)(intptr_t)cookie, *offset, whence);
+    if (position < 0) {
+        return -1;
+    }
+    *offset = position;
+    return 0;
+}
+
+static int handle_close(void *cookie) {
+    return _close((int)(intptr_t)cookie);
+}
+
+FILE *__wrap_fopen(const char *path, const char *mode) {
+    static const cookie_io_functions_t handle_io = {
+        handle_read, handle_write, handle_seek, handle_close
+    };
+
+    if (path[0] == ':' || path[0] == '/') {
+        // Handles below 3 are mbed's names for stdin, stdout and stderr
+        int fh = _open(path, mode_to_openmode(mode));
+        if (fh >= 3) {
+            FILE *file = fopencookie((void *)(intptr_t)fh, mode, handle_io);
+            if (file == NULL) {
+                _close(fh);
+            }
+            return file;
+        }
+        if (path[0] == ':') {
+            return NULL;
+        }
+    }
+    return __real_fopen(path, mode);
+}
@@ -0,0 +1,111 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* Compare channels for the us and lp tickers, timed by one thread which
+ * sleeps on CLOCK_MONOTONIC until the earliest armed match and then pends
+ * that channel's interrupt. Both tickers count microseconds since the
+ * process started.
+ */
+#include <pthread.h>
+#include <time.h>
+
+#include "host_sim.h"
+
+#define HOST_SIM_TICKER_CHANNELS    2
+
+typedef struct {
+    IRQn_Type irq;
+    int armed;
+    uint32_t timestamp;
+} ticker_channel_t;
+
+static ticker_channel_t channels[HOST_SIM_TICKER_CHANNELS];
+static pthread_mutex_t ticker_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ticker_cond;
+static pthread_once_t ticker_once = PTHREAD_ONCE_INIT;
+
+static void *ticker_thread(void *arg) {
+    pthread_mutex_lock(&ticker_lock);
+    while (1) {
+        uint32_t now = (uint32_t)host_sim_time_us();
+        int32_t wait_us = INT32_MAX;
+
+        for (int i = 0; i < HOST_SIM_TICKER_CHANNELS; i++) {
+            if (!channels[i].armed) {
+                continue;
+            }
+            // Matches up to half the counter's range in the past have been missed
+            int32_t delta = (int32_t)(channels[i].timestamp - now);
+            if (delta <= 0) {
+                channels[i].armed = 0;
+                NVIC_SetPendingIRQ(channels[i].irq);
+            } else if (delta < wait_us) {
+                wait_us = delta;
+            }
+        }
+
+        if (wait_us == INT32_MAX) {
+            pthread_cond_wait(&ticker_cond, &ticker_lock);
+        } else {
+            struct timespec until;
+            clock_gettime(CLOCK_MONOTONIC, &until);
+            until.tv_sec += wait_us / 1000000;
+            until.tv_nsec += (wait_us % 1000000) * 1000;
+            if (until.tv_nsec >= 1000000000) {
+                until.tv_sec++;
+                until.tv_nsec -= 1000000000;
+            }
+            pthread_cond_timedwait(&ticker_cond, &ticker_lock, &until);
+        }
+    }
+    return NULL;
+}
+
+static void ticker_start(void) {
+    pthread_condattr_t attr;
+    pthread_t thread;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&ticker_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    host_sim_thread_create(&thread, ticker_thread, NULL);
+}
+
+void host_sim_ticker_init(int channel, IRQn_Type irq, uintptr_t vector) {
+    pthread_once(&ticker_once, ticker_start);
+
+    pthread_mutex_lock(&ticker_lock);
+    channels[channel].irq = irq;
+    channels[channel].armed = 0;
+    pthread_mutex_unlock(&ticker_lock);
+
+    NVIC_SetVector(irq, vector);
+    NVIC_EnableIRQ(irq);
+}
+
+void host_sim_ticker_set(int channel, uint32_t timestamp) {
+    pthread_mutex_lock(&ticker_lock);
+    channels[channel].timestamp = timestamp;
+    channels[channel].armed = 1;
+    pthread_cond_signal(&ticker_cond);
+    pthread_mutex_unlock(&ticker_lock);
+}
+
+void host_sim_ticker_disable(int channel) {
+    pthread_mutex_lock(&ticker_lock);
+    channels[channel].armed = 0;
+    pthread_mutex_unlock(&ticker_lock);
+}
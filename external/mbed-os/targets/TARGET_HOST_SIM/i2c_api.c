@@ -0,0 +1,149 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* Eight 256 byte EEPROMs, in the style of a 24C02, answer at 7-bit addresses
+ * 0x50 to 0x57. The first byte written after the address sets the word
+ * address which later reads and writes then advance. Any other address is
+ * NAKed.
+ */
+#include <string.h>
+
+#include "mbed_assert.h"
+#include "i2c_api.h"
+#include "cmsis.h"
+#include "pinmap.h"
+
+#if DEVICE_I2C
+
+#define EEPROM_FIRST    0x50
+#define EEPROM_COUNT    8
+#define EEPROM_SIZE     256
+
+/* device values other than an EEPROM index */
+#define I2C_IDLE        -1
+#define I2C_NAKED       -2
+
+static const PinMap PinMap_I2C_SDA[] = {
+    {I2C_SDA, I2C_0, 0},
+    {NC,      NC,    0}
+};
+
+static const PinMap PinMap_I2C_SCL[] = {
+    {I2C_SCL, I2C_0, 0},
+    {NC,      NC,    0}
+};
+
+static uint8_t eeprom[EEPROM_COUNT][EEPROM_SIZE];
+static uint8_t eeprom_pointer[EEPROM_COUNT];
+static int eeprom_inited;
+
+void i2c_init(i2c_t *obj, PinName sda, PinName scl) {
+    // determine the I2C to use
+    I2CName i2c_sda = (I2CName)pinmap_peripheral(sda, PinMap_I2C_SDA);
+    I2CName i2c_scl = (I2CName)pinmap_peripheral(scl, PinMap_I2C_SCL);
+    obj->i2c = (I2CName)pinmap_merge(i2c_sda, i2c_scl);
+    MBED_ASSERT((int)obj->i2c != NC);
+
+    if (!eeprom_inited) {
+        eeprom_inited = 1;
+        memset(eeprom, 0xFF, sizeof(eeprom));
+    }
+    obj->device = I2C_IDLE;
+}
+
+void i2c_frequency(i2c_t *obj, int hz) {
+}
+
+int i2c_start(i2c_t *obj) {
+    obj->device = I2C_IDLE;
+    return 0;
+}
+
+int i2c_stop(i2c_t *obj) {
+    obj->device = I2C_IDLE;
+    return 0;
+}
+
+int i2c_byte_write(i2c_t *obj, int data) {
+    if (obj->device == I2C_IDLE) {
+        // address byte
+        int address = (data >> 1) & 0x7F;
+        if (address < EEPROM_FIRST || address >= EEPROM_FIRST + EEPROM_COUNT) {
+            obj->device = I2C_NAKED;
+            return 0;
+        }
+        obj->device = address - EEPROM_FIRST;
+        obj->word_address = !(data & 1);
+        return 1;
+    }
+    if (obj->device == I2C_NAKED) {
+        return 0;
+    }
+
+    if (obj->word_address) {
+        eeprom_pointer[obj->device] = data;
+        obj->word_address = 0;
+    } else {
+        eeprom[obj->device][eeprom_pointer[obj->device]++] = data;
+    }
+    return 1;
+}
+
+int i2c_byte_read(i2c_t *obj, int last) {
+    if (obj->device < 0) {
+        return 0xFF;
+    }
+    return eeprom[obj->device][eeprom_pointer[obj->device]++];
+}
+
+int i2c_read(i2c_t *obj, int address, char *data, int length, int stop) {
+    i2c_start(obj);
+    if (!i2c_byte_write(obj, address | 1)) {
+        i2c_stop(obj);
+        return I2C_ERROR_NO_SLAVE;
+    }
+
+    for (int count = 0; count < length; count++) {
+        data[count] = i2c_byte_read(obj, count == length - 1);
+    }
+
+    if (stop) {
+        i2c_stop(obj);
+    }
+    return length;
+}
+
+int i2c_write(i2c_t *obj, int address, const char *data, int length, int stop) {
+    i2c_start(obj);
+    if (!i2c_byte_write(obj, address & 0xFE)) {
+        i2c_stop(obj);
+        return I2C_ERROR_NO_SLAVE;
+    }
+
+    for (int count = 0; count < length; count++) {
+        i2c_byte_write(obj, data[count]);
+    }
+
+    if (stop) {
+        i2c_stop(obj);
+    }
+    return length;
+}
+
+void i2c_reset(i2c_t *obj) {
+    i2c_stop(obj);
+}
+
+#endif
@@ -0,0 +1,52 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stddef.h>
+#include "lp_ticker_api.h"
+#include "host_sim.h"
+
+#if DEVICE_LOWPOWERTIMER
+
+#define LP_TICKER_CHANNEL   1
+
+int lp_ticker_inited = 0;
+
+void lp_ticker_init(void) {
+    if (lp_ticker_inited) return;
+    lp_ticker_inited = 1;
+
+    host_sim_ticker_init(LP_TICKER_CHANNEL, LP_TICKER_IRQn, (uintptr_t)lp_ticker_irq_handler);
+}
+
+uint32_t lp_ticker_read() {
+    if (!lp_ticker_inited)
+        lp_ticker_init();
+
+    return (uint32_t)host_sim_time_us();
+}
+
+void lp_ticker_set_interrupt(timestamp_t timestamp) {
+    host_sim_ticker_set(LP_TICKER_CHANNEL, timestamp);
+}
+
+void lp_ticker_disable_interrupt(void) {
+    host_sim_ticker_disable(LP_TICKER_CHANNEL);
+}
+
+void lp_ticker_clear_interrupt(void) {
+    NVIC_ClearPendingIRQ(LP_TICKER_IRQn);
+}
+
+#endif
@@ -0,0 +1,444 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* UART0, on USBTX/USBRX, is the process's stdout and stdin. UART1 and UART2
+ * open the files named by HOST_SIM_UART1 and HOST_SIM_UART2, typically a pty
+ * or a FIFO, or loop what they send back to their own receiver when those
+ * aren't set. A thread per UART moves received bytes into a FIFO and pends
+ * the UART's interrupt.
+ *
+ * Transmit doesn't normally block so TxIrq, like RxIrq, is level triggered
+ * and keeps firing for as long as it is enabled. Setting HOST_SIM_UART_PACED,
+ * or calling host_sim_uart_set_paced(), makes each character take as long as
+ * it would on the wire at the rate and format the UART is set to, so that
+ * code relying on output being slower than the CPU can be exercised. A
+ * paced UART is only writable and only raises TxIrq once the character
+ * before has gone.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mbed_assert.h"
+#include "serial_api.h"
+#include "cmsis.h"
+#include "pinmap.h"
+#include "host_sim.h"
+
+#if DEVICE_SERIAL
+
+/******************************************************************************
+ * INITIALIZATION
+ ******************************************************************************/
+#define UART_NUM        3
+#define UART_FIFO_SIZE  1024
+
+static const PinMap PinMap_UART_TX[] = {
+    {USBTX,    UART_0, 0},
+    {UART1_TX, UART_1, 0},
+    {UART2_TX, UART_2, 0},
+    {NC,       NC,     0}
+};
+
+static const PinMap PinMap_UART_RX[] = {
+    {USBRX,    UART_0, 0},
+    {UART1_RX, UART_1, 0},
+    {UART2_RX, UART_2, 0},
+    {NC,       NC,     0}
+};
+
+static uart_irq_handler irq_handler;
+static int uart_paced = -1;
+
+int stdio_uart_inited = 0;
+serial_t stdio_uart;
+
+struct serial_global_data_s {
+    uint32_t serial_irq_id;
+    int started;
+    int rx_fd;
+    int tx_fd;
+    uint8_t rx_irq_enabled;
+    uint8_t tx_irq_enabled;
+    uint8_t tx_thread_started;
+    uint8_t tx_waiting;
+    int baud;
+    int bits_per_char;
+    uint64_t tx_free_us;
+    uint32_t head;
+    uint32_t tail;
+    uint8_t fifo[UART_FIFO_SIZE];
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_cond_t tx_cond;
+};
+
+static struct serial_global_data_s uart_data[UART_NUM] = {
+    [0 ... UART_NUM - 1] = {
+        .rx_fd = -1,
+        .tx_fd = -1,
+        .baud = 9600,
+        .bits_per_char = 10,
+        .lock = PTHREAD_MUTEX_INITIALIZER,
+        .cond = PTHREAD_COND_INITIALIZER,
+        .tx_cond = PTHREAD_COND_INITIALIZER
+    }
+};
+
+static const IRQn_Type uart_irqs[UART_NUM] = {UART0_IRQn, UART1_IRQn, UART2_IRQn};
+
+/* Called with the UART's lock held. Bytes which arrive with the FIFO full are
+ * dropped, as an overrun would on hardware.
+ */
+static void uart_receive(struct serial_global_data_s *data, int index, uint8_t c) {
+    if (data->head - data->tail < UART_FIFO_SIZE) {
+        data->fifo[data->head++ % UART_FIFO_SIZE] = c;
+    }
+    pthread_cond_broadcast(&data->cond);
+    if (data->rx_irq_enabled) {
+        NVIC_SetPendingIRQ(uart_irqs[index]);
+    }
+}
+
+static void *uart_rx_thread(void *arg) {
+    int index = (int)(intptr_t)arg;
+    struct serial_global_data_s *data = &uart_data[index];
+    uint8_t buffer[64];
+
+    while (1) {
+        ssize_t n = read(data->rx_fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            // Nothing more will arrive, just like an unconnected RX line
+            return NULL;
+        }
+        pthread_mutex_lock(&data->lock);
+        for (ssize_t i = 0; i < n; i++) {
+            uart_receive(data, index, buffer[i]);
+        }
+        pthread_mutex_unlock(&data->lock);
+    }
+}
+
+void host_sim_uart_set_paced(int paced) {
+    uart_paced = paced;
+}
+
+static int uart_is_paced(void) {
+    if (uart_paced < 0) {
+        const char *paced = getenv("HOST_SIM_UART_PACED");
+        uart_paced = paced != NULL && strcmp(paced, "0") != 0;
+    }
+    return uart_paced;
+}
+
+static void uart_sleep_us(uint64_t us) {
+    struct timespec delay = {us / 1000000, (us % 1000000) * 1000};
+
+    while (nanosleep(&delay, &delay) < 0 && errno == EINTR) {
+    }
+}
+
+/* Called with the UART's lock held. */
+static int uart_tx_ready(struct serial_global_data_s *data) {
+    return !uart_is_paced() || host_sim_time_us() >= data->tx_free_us;
+}
+
+/* Pends TxIrq once a paced UART has finished sending, if it is still enabled
+ * by then.
+ */
+static void *uart_tx_thread(void *arg) {
+    int index = (int)(intptr_t)arg;
+    struct serial_global_data_s *data = &uart_data[index];
+
+    pthread_mutex_lock(&data->lock);
+    while (1) {
+        while (!data->tx_waiting) {
+            pthread_cond_wait(&data->tx_cond, &data->lock);
+        }
+        uint64_t now = host_sim_time_us();
+        if (now < data->tx_free_us) {
+            uint64_t delay = data->tx_free_us - now;
+            pthread_mutex_unlock(&data->lock);
+            uart_sleep_us(delay);
+            pthread_mutex_lock(&data->lock);
+            continue;
+        }
+        data->tx_waiting = 0;
+        if (data->tx_irq_enabled) {
+            NVIC_SetPendingIRQ(uart_irqs[index]);
+        }
+    }
+    return NULL;
+}
+
+/* Called with the UART's lock held. */
+static void uart_tx_wait(struct serial_global_data_s *data, int index) {
+    if (!data->tx_thread_started) {
+        pthread_t thread;
+
+        if (host_sim_thread_create(&thread, uart_tx_thread, (void *)(intptr_t)index) != 0) {
+            fprintf(stderr, "host_sim: can't start the UART%d TX thread\n", index);
+            abort();
+        }
+        data->tx_thread_started = 1;
+    }
+    data->tx_waiting = 1;
+    pthread_cond_signal(&data->tx_cond);
+}
+
+/* Waits for a paced UART to finish the character before and then keeps it
+ * busy for the time this one takes to send. It polls, as serial_putc() does
+ * on a device, since a sleep overshoots by more than a whole character at
+ * high rates.
+ */
+static void uart_tx_start(struct serial_global_data_s *data) {
+    uint64_t now;
+
+    if (!uart_is_paced()) {
+        return;
+    }
+
+    pthread_mutex_lock(&data->lock);
+    while ((now = host_sim_time_us()) < data->tx_free_us) {
+        pthread_mutex_unlock(&data->lock);
+        sched_yield();
+        pthread_mutex_lock(&data->lock);
+    }
+    data->tx_free_us = now + ((uint64_t)data->bits_per_char * 1000000 + data->baud - 1) / data->baud;
+    pthread_mutex_unlock(&data->lock);
+}
+
+static void uart_start(int index) {
+    struct serial_global_data_s *data = &uart_data[index];
+    pthread_t thread;
+
+    pthread_mutex_lock(&data->lock);
+    if (data->started) {
+        pthread_mutex_unlock(&data->lock);
+        return;
+    }
+    data->started = 1;
+
+    if (index == 0) {
+        data->rx_fd = STDIN_FILENO;
+        data->tx_fd = STDOUT_FILENO;
+    } else {
+        char env[] = "HOST_SIM_UARTn";
+        env[sizeof(env) - 2] = '0' + index;
+        const char *name = getenv(env);
+        if (name != NULL) {
+            int fd = open(name, O_RDWR | O_NOCTTY);
+            if (fd < 0) {
+                perror(env);
+                exit(1);
+            }
+            data->rx_fd = fd;
+            data->tx_fd = fd;
+        }
+    }
+    pthread_mutex_unlock(&data->lock);
+
+    if (data->rx_fd >= 0) {
+        host_sim_thread_create(&thread, uart_rx_thread, (void *)(intptr_t)index);
+    }
+}
+
+void serial_init(serial_t *obj, PinName tx, PinName rx) {
+    int is_stdio_uart = 0;
+
+    // determine the UART to use
+    UARTName uart_tx = (UARTName)pinmap_peripheral(tx, PinMap_UART_TX);
+    UARTName uart_rx = (UARTName)pinmap_peripheral(rx, PinMap_UART_RX);
+    UARTName uart = (UARTName)pinmap_merge(uart_tx, uart_rx);
+    MBED_ASSERT((int)uart != NC);
+
+    obj->index = (int)uart;
+    uart_start(obj->index);
+
+    is_stdio_uart = (uart == STDIO_UART) ? (1) : (0);
+
+    if (is_stdio_uart) {
+        stdio_uart_inited = 1;
+        memcpy(&stdio_uart, obj, sizeof(serial_t));
+    }
+}
+
+void serial_free(serial_t *obj) {
+    uart_data[obj->index].serial_irq_id = 0;
+}
+
+/* There is no line to clock, so the rate and framing only set how long a
+ * paced UART takes to send each character.
+ */
+void serial_baud(serial_t *obj, int baudrate) {
+    struct serial_global_data_s *data = &uart_data[obj->index];
+
+    MBED_ASSERT(baudrate > 0);
+    pthread_mutex_lock(&data->lock);
+    data->baud = baudrate;
+    pthread_mutex_unlock(&data->lock);
+}
+
+void serial_format(serial_t *obj, int data_bits, SerialParity parity, int stop_bits) {
+    struct serial_global_data_s *data = &uart_data[obj->index];
+
+    MBED_ASSERT((stop_bits == 1) || (stop_bits == 2));
+    MBED_ASSERT((data_bits > 4) && (data_bits < 9));
+    pthread_mutex_lock(&data->lock);
+    data->bits_per_char = 1 + data_bits + (parity != ParityNone) + stop_bits;
+    pthread_mutex_unlock(&data->lock);
+}
+
+/******************************************************************************
+ * INTERRUPTS HANDLING
+ ******************************************************************************/
+static void uart_irq(int index) {
+    struct serial_global_data_s *data = &uart_data[index];
+
+    if (data->serial_irq_id == 0)
+        return;
+
+    if (data->rx_irq_enabled && data->head != data->tail)
+        irq_handler(data->serial_irq_id, RxIrq);
+    pthread_mutex_lock(&data->lock);
+    int tx_ready = uart_tx_ready(data);
+    pthread_mutex_unlock(&data->lock);
+    if (data->tx_irq_enabled && tx_ready)
+        irq_handler(data->serial_irq_id, TxIrq);
+
+    // Level triggered: still asserted if the handler left it so. A paced
+    // UART which is still sending asserts TxIrq again when it is done.
+    pthread_mutex_lock(&data->lock);
+    if ((data->rx_irq_enabled && data->head != data->tail) || (data->tx_irq_enabled && uart_tx_ready(data)))
+        NVIC_SetPendingIRQ(uart_irqs[index]);
+    else if (data->tx_irq_enabled)
+        uart_tx_wait(data, index);
+    pthread_mutex_unlock(&data->lock);
+}
+
+static void uart0_irq() {uart_irq(0);}
+static void uart1_irq() {uart_irq(1);}
+static void uart2_irq() {uart_irq(2);}
+
+void serial_irq_handler(serial_t *obj, uart_irq_handler handler, uint32_t id) {
+    irq_handler = handler;
+    uart_data[obj->index].serial_irq_id = id;
+}
+
+void serial_irq_set(serial_t *obj, SerialIrq irq, uint32_t enable) {
+    struct serial_global_data_s *data = &uart_data[obj->index];
+    IRQn_Type irq_n = uart_irqs[obj->index];
+    uintptr_t vector = 0;
+    switch (obj->index) {
+        case UART_0: vector = (uintptr_t)&uart0_irq; break;
+        case UART_1: vector = (uintptr_t)&uart1_irq; break;
+        case UART_2: vector = (uintptr_t)&uart2_irq; break;
+    }
+
+    pthread_mutex_lock(&data->lock);
+    if (irq == RxIrq) {
+        data->rx_irq_enabled = enable;
+    } else {
+        data->tx_irq_enabled = enable;
+    }
+
+    if (enable) {
+        NVIC_SetVector(irq_n, vector);
+        NVIC_EnableIRQ(irq_n);
+        if (irq == TxIrq || data->head != data->tail) {
+            NVIC_SetPendingIRQ(irq_n);
+        }
+    } else if (!data->rx_irq_enabled && !data->tx_irq_enabled) {
+        NVIC_DisableIRQ(irq_n);
+    }
+    pthread_mutex_unlock(&data->lock);
+}
+
+/******************************************************************************
+ * READ/WRITE
+ ******************************************************************************/
+int serial_getc(serial_t *obj) {
+    struct serial_global_data_s *data = &uart_data[obj->index];
+
+    pthread_mutex_lock(&data->lock);
+    while (data->head == data->tail) {
+        pthread_cond_wait(&data->cond, &data->lock);
+    }
+    int c = data->fifo[data->tail++ % UART_FIFO_SIZE];
+    pthread_mutex_unlock(&data->lock);
+    return c;
+}
+
+void serial_putc(serial_t *obj, int c) {
+    struct serial_global_data_s *data = &uart_data[obj->index];
+
+    uart_tx_start(data);
+    if (obj->index == 0) {
+        // Shares the C library's buffer so it stays in order with printf()
+        putchar(c);
+    } else if (data->tx_fd >= 0) {
+        uint8_t byte = c;
+        while (write(data->tx_fd, &byte, 1) < 0 && errno == EINTR) {
+        }
+    } else {
+        pthread_mutex_lock(&data->lock);
+        uart_receive(data, obj->index, c);
+        pthread_mutex_unlock(&data->lock);
+    }
+}
+
+int serial_readable(serial_t *obj) {
+    struct serial_global_data_s *data = &uart_data[obj->index];
+
+    return data->head != data->tail;
+}
+
+int serial_writable(serial_t *obj) {
+    struct serial_global_data_s *data = &uart_data[obj->index];
+
+    pthread_mutex_lock(&data->lock);
+    int writable = uart_tx_ready(data);
+    pthread_mutex_unlock(&data->lock);
+    return writable;
+}
+
+void serial_clear(serial_t *obj) {
+    struct serial_global_data_s *data = &uart_data[obj->index];
+
+    pthread_mutex_lock(&data->lock);
+    data->tail = data->head;
+    pthread_mutex_unlock(&data->lock);
+}
+
+void serial_pinout_tx(PinName tx) {
+    pinmap_pinout(tx, PinMap_UART_TX);
+}
+
+void serial_break_set(serial_t *obj) {
+}
+
+void serial_break_clear(serial_t *obj) {
+}
+
+#endif
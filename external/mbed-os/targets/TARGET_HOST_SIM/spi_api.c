@@ -0,0 +1,97 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* SPI0's MOSI is wired back to its MISO, so every frame reads back what it
+ * sent.
+ */
+#include "mbed_assert.h"
+#include "spi_api.h"
+#include "cmsis.h"
+#include "pinmap.h"
+
+#if DEVICE_SPI
+
+static const PinMap PinMap_SPI_SCLK[] = {
+    {SPI_SCK,  SPI_0, 0},
+    {NC,       NC,    0}
+};
+
+static const PinMap PinMap_SPI_MOSI[] = {
+    {SPI_MOSI, SPI_0, 0},
+    {NC,       NC,    0}
+};
+
+static const PinMap PinMap_SPI_MISO[] = {
+    {SPI_MISO, SPI_0, 0},
+    {NC,       NC,    0}
+};
+
+static const PinMap PinMap_SPI_SSEL[] = {
+    {SPI_CS,   SPI_0, 0},
+    {NC,       NC,    0}
+};
+
+void spi_init(spi_t *obj, PinName mosi, PinName miso, PinName sclk, PinName ssel) {
+    // determine the SPI to use
+    uint32_t spi_mosi = pinmap_peripheral(mosi, PinMap_SPI_MOSI);
+    uint32_t spi_miso = pinmap_peripheral(miso, PinMap_SPI_MISO);
+    uint32_t spi_sclk = pinmap_peripheral(sclk, PinMap_SPI_SCLK);
+    uint32_t spi_ssel = pinmap_peripheral(ssel, PinMap_SPI_SSEL);
+    uint32_t spi_data = pinmap_merge(spi_mosi, spi_miso);
+    uint32_t spi_cntl = pinmap_merge(spi_sclk, spi_ssel);
+    obj->spi = (SPIName)pinmap_merge(spi_data, spi_cntl);
+    MBED_ASSERT((int)obj->spi != NC);
+
+    // set default format and frequency
+    spi_format(obj, 8, 0, 0);
+}
+
+void spi_free(spi_t *obj) {
+}
+
+void spi_format(spi_t *obj, int bits, int mode, int slave) {
+    MBED_ASSERT(((bits >= 4) && (bits <= 16)) && (mode >= 0 && mode <= 3));
+    MBED_ASSERT(slave == 0);
+
+    obj->bits = bits;
+    obj->mode = mode;
+}
+
+void spi_frequency(spi_t *obj, int hz) {
+}
+
+int spi_master_write(spi_t *obj, int value) {
+    return value & ((1 << obj->bits) - 1);
+}
+
+int spi_master_block_write(spi_t *obj, const char *tx_buffer, int tx_length, char *rx_buffer, int rx_length, char write_fill) {
+    int total = (tx_length > rx_length) ? tx_length : rx_length;
+    int common = (tx_length < rx_length) ? tx_length : rx_length;
+
+    for (int i = 0; i < common; i++) {
+        rx_buffer[i] = tx_buffer[i];
+    }
+    for (int i = common; i < rx_length; i++) {
+        rx_buffer[i] = write_fill;
+    }
+
+    return total;
+}
+
+int spi_busy(spi_t *obj) {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,305 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* ARM_DRIVER_STORAGE over a RAM NOR flash, laid out like the K64F's block 1
+ * so that cfstore's default volume fits. It follows the same rules as
+ * flash_api.c: erases set whole erase units to 0xFF and each byte can be
+ * programmed once between erases. All operations complete synchronously.
+ *
+ * Test benches count the bytes programmed and erased and cut the power
+ * part way through an operation with the host_sim_storage_*() functions.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "Driver_Storage.h"
+#include "host_sim.h"
+
+#if DEVICE_STORAGE
+
+#ifndef HOST_SIM_STORAGE_START_ADDR
+#define HOST_SIM_STORAGE_START_ADDR     0x80000
+#endif
+#ifndef HOST_SIM_STORAGE_SIZE
+#define HOST_SIM_STORAGE_SIZE           0x80000
+#endif
+#ifndef HOST_SIM_STORAGE_ERASE_UNIT
+#define HOST_SIM_STORAGE_ERASE_UNIT     4096
+#endif
+#ifndef HOST_SIM_STORAGE_PROGRAM_UNIT
+#define HOST_SIM_STORAGE_PROGRAM_UNIT   8
+#endif
+
+static uint8_t storage_data[HOST_SIM_STORAGE_SIZE];
+
+// One bit for each byte programmed since its erase unit was last erased
+static uint8_t storage_programmed[HOST_SIM_STORAGE_SIZE / 8];
+
+static int storage_initialized;
+static int storage_blank = 1;
+static host_sim_storage_stats_t storage_stats;
+
+// Program and erase operations left before the power is cut, or -1
+static int storage_ops_left = -1;
+static int storage_powered = 1;
+
+static const ARM_STORAGE_BLOCK storage_block = {
+    .addr       = HOST_SIM_STORAGE_START_ADDR,
+    .size       = HOST_SIM_STORAGE_SIZE,
+    .attributes = {
+        .erasable        = 1,
+        .programmable    = 1,
+        .executable      = 0,
+        .protectable     = 0,
+        .erase_unit      = HOST_SIM_STORAGE_ERASE_UNIT,
+        .protection_unit = HOST_SIM_STORAGE_SIZE,
+    }
+};
+
+static const ARM_STORAGE_INFO storage_info = {
+    .total_storage        = HOST_SIM_STORAGE_SIZE,
+    .program_unit         = HOST_SIM_STORAGE_PROGRAM_UNIT,
+    .optimal_program_unit = HOST_SIM_STORAGE_PROGRAM_UNIT,
+    .program_cycles       = ARM_STORAGE_PROGRAM_CYCLES_INFINITE,
+    .erased_value         = 1,
+    .memory_mapped        = 0,
+    .programmability      = ARM_STORAGE_PROGRAMMABILITY_ERASABLE,
+    .retention_level      = ARM_RETENTION_NVM,
+};
+
+static int storage_contains(uint64_t addr, uint32_t size) {
+    return addr >= HOST_SIM_STORAGE_START_ADDR && size != 0 && size <= HOST_SIM_STORAGE_SIZE &&
+           addr - HOST_SIM_STORAGE_START_ADDR <= HOST_SIM_STORAGE_SIZE - size;
+}
+
+static int storage_is_programmed(uint32_t offset) {
+    return (storage_programmed[offset / 8] >> (offset % 8)) & 1;
+}
+
+static void storage_set_programmed(uint32_t offset, int programmed) {
+    if (programmed) {
+        storage_programmed[offset / 8] |= 1 << (offset % 8);
+    } else {
+        storage_programmed[offset / 8] &= ~(1 << (offset % 8));
+    }
+}
+
+// Returns the part of an operation of size bytes that is carried out, which
+// is half of it if the power is cut during the operation.
+static uint32_t storage_start_op(uint32_t size) {
+    if (storage_ops_left < 0) {
+        return size;
+    }
+    if (storage_ops_left-- > 0) {
+        return size;
+    }
+    storage_powered = 0;
+    return size / 2;
+}
+
+static void storage_erase_range(uint32_t offset, uint32_t size) {
+    memset(storage_data + offset, 0xFF, size);
+    for (uint32_t i = 0; i < size; i++) {
+        storage_set_programmed(offset + i, 0);
+    }
+    storage_stats.erased += size;
+    storage_stats.erase_ops++;
+}
+
+static ARM_DRIVER_VERSION storage_get_version(void) {
+    ARM_DRIVER_VERSION version = {
+        .api = ARM_STORAGE_API_VERSION,
+        .drv = ARM_DRIVER_VERSION_MAJOR_MINOR(1, 00)
+    };
+    return version;
+}
+
+static ARM_STORAGE_CAPABILITIES storage_get_capabilities(void) {
+    ARM_STORAGE_CAPABILITIES caps = {
+        .asynchronous_ops = 0,
+        .erase_all        = 1,
+    };
+    return caps;
+}
+
+static int32_t storage_initialize(ARM_Storage_Callback_t callback) {
+    if (storage_blank) {
+        memset(storage_data, 0xFF, sizeof(storage_data));
+        storage_blank = 0;
+    }
+    storage_initialized = 1;
+    return 1;
+}
+
+static int32_t storage_uninitialize(void) {
+    if (!storage_initialized) {
+        return ARM_DRIVER_ERROR;
+    }
+    storage_initialized = 0;
+    return 1;
+}
+
+static int32_t storage_power_control(ARM_POWER_STATE state) {
+    return 1;
+}
+
+static int32_t storage_read_data(uint64_t addr, void *data, uint32_t size) {
+    if (!storage_initialized || !storage_powered) {
+        return ARM_DRIVER_ERROR;
+    }
+    if (data == NULL || !storage_contains(addr, size)) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+
+    memcpy(data, storage_data + (addr - HOST_SIM_STORAGE_START_ADDR), size);
+    return size;
+}
+
+static int32_t storage_program_data(uint64_t addr, const void *data, uint32_t size) {
+    if (!storage_initialized || !storage_powered) {
+        return ARM_DRIVER_ERROR;
+    }
+    if (data == NULL || !storage_contains(addr, size) ||
+        addr % HOST_SIM_STORAGE_PROGRAM_UNIT != 0 || size % HOST_SIM_STORAGE_PROGRAM_UNIT != 0) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+
+    uint32_t offset = addr - HOST_SIM_STORAGE_START_ADDR;
+    for (uint32_t i = 0; i < size; i++) {
+        if (storage_is_programmed(offset + i)) {
+            fprintf(stderr, "host_sim: storage program of 0x%08lx, which was programmed since it was erased\n",
+                    (unsigned long)(addr + i));
+            return ARM_STORAGE_ERROR_NOT_PROGRAMMABLE;
+        }
+    }
+
+    uint32_t done = storage_start_op(size);
+    memcpy(storage_data + offset, data, done);
+    for (uint32_t i = 0; i < done; i++) {
+        storage_set_programmed(offset + i, 1);
+    }
+    storage_stats.programmed += done;
+    storage_stats.program_ops++;
+    return storage_powered ? (int32_t)size : ARM_DRIVER_ERROR;
+}
+
+static int32_t storage_erase(uint64_t addr, uint32_t size) {
+    if (!storage_initialized || !storage_powered) {
+        return ARM_DRIVER_ERROR;
+    }
+    if (!storage_contains(addr, size) ||
+        addr % HOST_SIM_STORAGE_ERASE_UNIT != 0 || size % HOST_SIM_STORAGE_ERASE_UNIT != 0) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+
+    storage_erase_range(addr - HOST_SIM_STORAGE_START_ADDR, storage_start_op(size));
+    return storage_powered ? (int32_t)size : ARM_DRIVER_ERROR;
+}
+
+static int32_t storage_erase_all(void) {
+    if (!storage_initialized || !storage_powered) {
+        return ARM_DRIVER_ERROR;
+    }
+
+    storage_erase_range(0, storage_start_op(HOST_SIM_STORAGE_SIZE));
+    return storage_powered ? 1 : ARM_DRIVER_ERROR;
+}
+
+static ARM_STORAGE_STATUS storage_get_status(void) {
+    ARM_STORAGE_STATUS status = {
+        .busy  = 0,
+        .error = !storage_initialized || !storage_powered,
+    };
+    return status;
+}
+
+static int32_t storage_get_info(ARM_STORAGE_INFO *info) {
+    memcpy(info, &storage_info, sizeof(ARM_STORAGE_INFO));
+    return ARM_DRIVER_OK;
+}
+
+static uint32_t storage_resolve_address(uint64_t addr) {
+    return (uint32_t)addr;
+}
+
+static int32_t storage_get_next_block(const ARM_STORAGE_BLOCK *prev, ARM_STORAGE_BLOCK *next) {
+    if (prev == NULL) {
+        if (next) {
+            memcpy(next, &storage_block, sizeof(ARM_STORAGE_BLOCK));
+        }
+        return ARM_DRIVER_OK;
+    }
+
+    if (next) {
+        next->addr = ARM_STORAGE_INVALID_OFFSET;
+        next->size = 0;
+    }
+    return ARM_DRIVER_ERROR;
+}
+
+static int32_t storage_get_block(uint64_t addr, ARM_STORAGE_BLOCK *block) {
+    if (storage_contains(addr, 1)) {
+        if (block) {
+            memcpy(block, &storage_block, sizeof(ARM_STORAGE_BLOCK));
+        }
+        return ARM_DRIVER_OK;
+    }
+
+    if (block) {
+        block->addr = ARM_STORAGE_INVALID_OFFSET;
+        block->size = 0;
+    }
+    return ARM_DRIVER_ERROR;
+}
+
+void host_sim_storage_get_stats(host_sim_storage_stats_t *stats) {
+    *stats = storage_stats;
+}
+
+void host_sim_storage_reset_stats(void) {
+    memset(&storage_stats, 0, sizeof(storage_stats));
+}
+
+void host_sim_storage_cut_power_after(int ops) {
+    storage_ops_left = ops;
+}
+
+int host_sim_storage_is_powered(void) {
+    return storage_powered;
+}
+
+void host_sim_storage_restore_power(void) {
+    storage_ops_left = -1;
+    storage_powered = 1;
+}
+
+ARM_DRIVER_STORAGE ARM_Driver_Storage_MTD_HOST_SIM = {
+    .GetVersion      = storage_get_version,
+    .GetCapabilities = storage_get_capabilities,
+    .Initialize      = storage_initialize,
+    .Uninitialize    = storage_uninitialize,
+    .PowerControl    = storage_power_control,
+    .ReadData        = storage_read_data,
+    .ProgramData     = storage_program_data,
+    .Erase           = storage_erase,
+    .EraseAll        = storage_erase_all,
+    .GetStatus       = storage_get_status,
+    .GetInfo         = storage_get_info,
+    .ResolveAddress  = storage_resolve_address,
+    .GetNextBlock    = storage_get_next_block,
+    .GetBlock        = storage_get_block
+};
+
+#endif
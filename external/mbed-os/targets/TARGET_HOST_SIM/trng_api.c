@@ -0,0 +1,44 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* Entropy comes from the host's /dev/urandom, so mbed TLS builds with the
+ * same configuration as on devices with a TRNG.
+ */
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "trng_api.h"
+
+#if DEVICE_TRNG
+
+void trng_init(trng_t *obj) {
+    obj->fd = open("/dev/urandom", O_RDONLY);
+}
+
+void trng_free(trng_t *obj) {
+    if (obj->fd >= 0) {
+        close(obj->fd);
+        obj->fd = -1;
+    }
+}
+
+int trng_get_bytes(trng_t *obj, uint8_t *output, size_t length, size_t *output_length) {
+    ssize_t count = obj->fd >= 0 ? read(obj->fd, output, length) : -1;
+
+    *output_length = count > 0 ? (size_t)count : 0;
+    return count < 0 ? -1 : 0;
+}
+
+#endif
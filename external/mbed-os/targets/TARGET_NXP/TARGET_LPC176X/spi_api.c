@@ -190,6 +190,32 @@ int spi_master_write(spi_t *obj, int value) {
     return ssp_read(obj);
 }
 
+#define SSP_FIFO_SIZE   8
+
+int spi_master_block_write(spi_t *obj, const char *tx_buffer, int tx_length, char *rx_buffer, int rx_length, char write_fill) {
+    int total = (tx_length > rx_length) ? tx_length : rx_length;
+    int tx_count = 0;
+    int rx_count = 0;
+
+    // Keep the TX FIFO topped up, but never have more frames in flight than
+    // the RX FIFO can hold
+    while (rx_count < total) {
+        if (tx_count < total && tx_count - rx_count < SSP_FIFO_SIZE && ssp_writeable(obj)) {
+            obj->spi->DR = (uint8_t)((tx_count < tx_length) ? tx_buffer[tx_count] : write_fill);
+            tx_count++;
+        }
+        if (ssp_readable(obj)) {
+            char in = obj->spi->DR;
+            if (rx_count < rx_length) {
+                rx_buffer[rx_count] = in;
+            }
+            rx_count++;
+        }
+    }
+
+    return total;
+}
+
 int spi_slave_receive(spi_t *obj) {
     return (ssp_readable(obj) && !ssp_busy(obj)) ? (1) : (0);
 }
@@ -0,0 +1,374 @@
+/* Copyright 2017 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Measures how long the caller is held up by a line of console output when it
+   is sent a character at a time with serial_putc() and when it is queued for
+   the UART TX interrupt by mbed_stdio_tx_write(). The printf() test goes
+   through the retarget layer and so uses whichever of the two
+   platform.stdio-buffered-serial selected when the mbed libraries were built.
+
+   The serial_* and rawserial_* tests send a larger block through Serial and
+   RawSerial objects on the same pins at SERIAL_BENCH_BAUD, which makes the
+   per character cost of each path show against the time on the wire. The
+   terminal may not be able to show what is sent at that rate. They are
+   skipped when stdio is buffered, as the Serial objects would take over its
+   TX interrupt.
+
+   Before timing anything, the stdio TX buffer is checked against its own
+   counters: that the TX interrupt sends what is queued, and that a write
+   larger than the buffer blocks or drops bytes as the overflow policy says.
+   The checks send a few lines of dashes.
+
+   Each test prints a single line of key=value pairs:
+       RESULT test=<name> pass=<0|1>
+       RESULT test=<name> bytes=<count> us=<elapsed> us_per_byte=<rate> bytes_per_sec=<rate>
+   followed by the stdio TX buffer counters, and the process exits with the
+   number of checks which failed. Output is waited on between tests so that
+   each one starts with an idle UART.
+
+   The HOST_SIM build, made with make HOST_SIM and run with
+   HOST_SIM/ConsoleBench.elf, paces its UART to the baud rate so that output
+   takes as long to send as on a device.
+*/
+#include <mbed.h>
+#include "mbed_stdio_tx.h"
+
+#if defined(TARGET_HOST_SIM)
+#include "host_sim.h"
+#endif
+
+
+#define LINE_LENGTH         100
+#define BURST_LINES         8
+#define SERIAL_BENCH_BYTES  4096
+#ifndef SERIAL_BENCH_BAUD
+#define SERIAL_BENCH_BAUD   921600
+#endif
+#define CHECK_BUFFER_SIZE   MBED_CONF_PLATFORM_STDIO_TX_BUFFER_SIZE
+#define CHECK_DATA_SIZE     (CHECK_BUFFER_SIZE + 100)
+#define CHECK_TIMEOUT_MS    1000
+
+#define CHECK(X) \
+    do \
+    { \
+        if (!(X)) \
+        { \
+            mbed_stdio_tx_flush(); \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #X); \
+            g_checkFailures++; \
+        } \
+    } while (0)
+
+
+extern "C" serial_t stdio_uart;
+
+static Timer g_timer;
+static char  g_line[LINE_LENGTH + 1];
+static char  g_block[SERIAL_BENCH_BYTES + 1];
+static char  g_checkData[CHECK_DATA_SIZE];
+static int   g_checkFailures;
+static int   g_failures;
+
+
+static void waitForIdle()
+{
+    mbed_stdio_tx_flush();
+    // Let the last character leave the UART.
+    wait_ms(20);
+}
+
+static void startTest()
+{
+    waitForIdle();
+    g_timer.reset();
+    g_timer.start();
+}
+
+static void printResult(const char* pTest, uint32_t bytes, uint32_t us)
+{
+    printf("RESULT test=%s bytes=%lu us=%lu us_per_byte=%lu bytes_per_sec=%lu\n",
+           pTest, (unsigned long)bytes, (unsigned long)us, (unsigned long)(us / bytes),
+           us ? (unsigned long)((uint64_t)bytes * 1000000 / us) : 0UL);
+}
+
+static void endTest(const char* pTest, uint32_t bytes)
+{
+    g_timer.stop();
+    uint32_t us = g_timer.read_us();
+    waitForIdle();
+    printResult(pTest, bytes, us);
+}
+
+#if !MBED_CONF_PLATFORM_STDIO_BUFFERED_SERIAL
+static void startSerialTest(SerialBase* pSerial)
+{
+    waitForIdle();
+    pSerial->baud(SERIAL_BENCH_BAUD);
+    g_timer.reset();
+    g_timer.start();
+}
+
+static void endSerialTest(SerialBase* pSerial, const char* pTest, uint32_t bytes)
+{
+    g_timer.stop();
+    uint32_t us = g_timer.read_us();
+    wait_ms(20);
+    pSerial->baud(MBED_CONF_PLATFORM_STDIO_BAUD_RATE);
+    printResult(pTest, bytes, us);
+}
+
+static void benchSerial()
+{
+    for (size_t i = 0 ; i < SERIAL_BENCH_BYTES ; i++)
+    {
+        g_block[i] = (i % 64 == 63) ? '\n' : '.';
+    }
+    g_block[SERIAL_BENCH_BYTES] = '\0';
+
+    {
+        Serial serial(USBTX, USBRX, MBED_CONF_PLATFORM_STDIO_BAUD_RATE);
+
+        startSerialTest(&serial);
+        for (size_t i = 0 ; i < SERIAL_BENCH_BYTES ; i++)
+        {
+            serial.putc(g_block[i]);
+        }
+        endSerialTest(&serial, "serial_putc", SERIAL_BENCH_BYTES);
+
+        startSerialTest(&serial);
+        fwrite(g_block, 1, SERIAL_BENCH_BYTES, (FILE*)serial);
+        endSerialTest(&serial, "serial_fwrite", SERIAL_BENCH_BYTES);
+
+        startSerialTest(&serial);
+        serial.puts(g_block);
+        endSerialTest(&serial, "serial_puts", SERIAL_BENCH_BYTES);
+
+        startSerialTest(&serial);
+        serial.printf("%s", g_block);
+        endSerialTest(&serial, "serial_printf", SERIAL_BENCH_BYTES);
+    }
+
+    {
+        RawSerial serial(USBTX, USBRX, MBED_CONF_PLATFORM_STDIO_BAUD_RATE);
+
+        startSerialTest(&serial);
+        for (size_t i = 0 ; i < SERIAL_BENCH_BYTES ; i++)
+        {
+            serial.putc(g_block[i]);
+        }
+        endSerialTest(&serial, "rawserial_putc", SERIAL_BENCH_BYTES);
+
+        startSerialTest(&serial);
+        serial.puts(g_block);
+        endSerialTest(&serial, "rawserial_puts", SERIAL_BENCH_BYTES);
+    }
+}
+#endif
+
+static void startCheck(mbed_stdio_tx_overflow_t policy, mbed_stdio_tx_stats_t* pStats)
+{
+    waitForIdle();
+    mbed_stdio_tx_set_overflow(policy);
+    mbed_stdio_tx_get_stats(pStats);
+}
+
+static void endCheck(const char* pTest)
+{
+    mbed_stdio_tx_flush();
+    mbed_stdio_tx_set_overflow(MBED_STDIO_TX_BLOCK);
+    printf("\nRESULT test=%s pass=%d\n", pTest, g_checkFailures == 0 ? 1 : 0);
+    g_failures += g_checkFailures;
+    g_checkFailures = 0;
+}
+
+// Output is queued and sent by the TX interrupt
+static void checkInterruptDrain()
+{
+    mbed_stdio_tx_stats_t before;
+    mbed_stdio_tx_stats_t after;
+    Timer                 timer;
+
+    startCheck(MBED_STDIO_TX_BLOCK, &before);
+    CHECK(mbed_stdio_tx_write(g_checkData, 50) == 50);
+    timer.start();
+    do
+    {
+        mbed_stdio_tx_get_stats(&after);
+    } while (after.sent - before.sent < 50 && timer.read_ms() < CHECK_TIMEOUT_MS);
+
+    CHECK(after.queued - before.queued == 50);
+    CHECK(after.sent - before.sent == 50);
+    CHECK(after.blocked == before.blocked);
+    CHECK(after.max_used >= 49);
+    endCheck("stdio_tx_interrupt");
+}
+
+// A write larger than the buffer waits and loses nothing
+static void checkBlock()
+{
+    mbed_stdio_tx_stats_t before;
+    mbed_stdio_tx_stats_t after;
+
+    startCheck(MBED_STDIO_TX_BLOCK, &before);
+    CHECK(mbed_stdio_tx_write(g_checkData, CHECK_DATA_SIZE) == CHECK_DATA_SIZE);
+    mbed_stdio_tx_flush();
+
+    mbed_stdio_tx_get_stats(&after);
+    CHECK(after.sent - before.sent == CHECK_DATA_SIZE);
+    CHECK(after.blocked - before.blocked == 1);
+    CHECK(after.dropped == before.dropped);
+    CHECK(after.max_used <= CHECK_BUFFER_SIZE);
+    endCheck("stdio_tx_block");
+}
+
+// The end of a write which doesn't fit is lost
+static void checkDropNewest()
+{
+    mbed_stdio_tx_stats_t before;
+    mbed_stdio_tx_stats_t after;
+
+    startCheck(MBED_STDIO_TX_DROP_NEWEST, &before);
+    CHECK(mbed_stdio_tx_write(g_checkData, CHECK_DATA_SIZE) == CHECK_BUFFER_SIZE);
+    mbed_stdio_tx_flush();
+
+    mbed_stdio_tx_get_stats(&after);
+    CHECK(after.sent - before.sent == CHECK_BUFFER_SIZE);
+    CHECK(after.dropped - before.dropped == CHECK_DATA_SIZE - CHECK_BUFFER_SIZE);
+    CHECK(after.blocked == before.blocked);
+    endCheck("stdio_tx_drop_newest");
+}
+
+// Unsent output is lost to make room for the newest, and every byte written
+// is either sent or dropped
+static void checkDropOldest()
+{
+    mbed_stdio_tx_stats_t before;
+    mbed_stdio_tx_stats_t after;
+
+    startCheck(MBED_STDIO_TX_DROP_OLDEST, &before);
+    CHECK(mbed_stdio_tx_write(g_checkData, CHECK_DATA_SIZE) == CHECK_BUFFER_SIZE);
+    mbed_stdio_tx_flush();
+    mbed_stdio_tx_get_stats(&after);
+    CHECK(after.sent - before.sent == CHECK_BUFFER_SIZE);
+    CHECK(after.dropped - before.dropped == CHECK_DATA_SIZE - CHECK_BUFFER_SIZE);
+
+    size_t first = CHECK_BUFFER_SIZE / 2 + 8;
+    size_t second = CHECK_BUFFER_SIZE / 2 + 8;
+    before = after;
+    CHECK(mbed_stdio_tx_write(g_checkData, first) == first);
+    CHECK(mbed_stdio_tx_write(&g_checkData[first], second) == second);
+    mbed_stdio_tx_flush();
+    mbed_stdio_tx_get_stats(&after);
+    CHECK(after.dropped - before.dropped > 0);
+    CHECK(after.sent - before.sent + after.dropped - before.dropped == first + second);
+    CHECK(after.blocked == before.blocked);
+    endCheck("stdio_tx_drop_oldest");
+}
+
+// Flushing works without the TX interrupt, as on a crash path
+static void checkFlushInCriticalSection()
+{
+    mbed_stdio_tx_stats_t before;
+    mbed_stdio_tx_stats_t after;
+
+    startCheck(MBED_STDIO_TX_BLOCK, &before);
+    core_util_critical_section_enter();
+    CHECK(mbed_stdio_tx_write(g_checkData, 40) == 40);
+    mbed_stdio_tx_flush();
+    mbed_stdio_tx_get_stats(&after);
+    core_util_critical_section_exit();
+
+    CHECK(after.sent - before.sent == 40);
+    endCheck("stdio_tx_flush_critical");
+}
+
+static void printStats()
+{
+    mbed_stdio_tx_stats_t stats;
+    mbed_stdio_tx_get_stats(&stats);
+    printf("STATS queued=%lu sent=%lu dropped=%lu blocked=%lu max_used=%lu\n",
+           (unsigned long)stats.queued, (unsigned long)stats.sent, (unsigned long)stats.dropped,
+           (unsigned long)stats.blocked, (unsigned long)stats.max_used);
+}
+
+
+int main()
+{
+    memset(g_line, '.', LINE_LENGTH - 2);
+    g_line[LINE_LENGTH - 2] = '\r';
+    g_line[LINE_LENGTH - 1] = '\n';
+    g_line[LINE_LENGTH] = '\0';
+
+    for (size_t i = 0 ; i < CHECK_DATA_SIZE ; i++)
+    {
+        g_checkData[i] = (i % 64 == 63) ? '\n' : '-';
+    }
+
+#if defined(TARGET_HOST_SIM)
+    host_sim_uart_set_paced(1);
+#endif
+
+    printf("ConsoleBench: %u byte lines, %u byte stdio TX buffer, printf() %s\n",
+           LINE_LENGTH, MBED_CONF_PLATFORM_STDIO_TX_BUFFER_SIZE,
+           MBED_CONF_PLATFORM_STDIO_BUFFERED_SERIAL ? "buffered" : "unbuffered");
+
+    // Before benchSerial(), whose Serial objects take the TX interrupt away
+    checkInterruptDrain();
+    checkBlock();
+    checkDropNewest();
+    checkDropOldest();
+    checkFlushInCriticalSection();
+
+    startTest();
+    for (size_t i = 0 ; i < LINE_LENGTH ; i++)
+    {
+        serial_putc(&stdio_uart, g_line[i]);
+    }
+    endTest("serial_putc", LINE_LENGTH);
+
+    startTest();
+    mbed_stdio_tx_write(g_line, LINE_LENGTH);
+    endTest("stdio_tx_write", LINE_LENGTH);
+
+    startTest();
+    printf("%s", g_line);
+    endTest("printf", LINE_LENGTH);
+
+    // Bursts larger than the buffer wait for room or lose output.
+    startTest();
+    for (int i = 0 ; i < BURST_LINES ; i++)
+    {
+        mbed_stdio_tx_write(g_line, LINE_LENGTH);
+    }
+    endTest("burst_block", BURST_LINES * LINE_LENGTH);
+
+    mbed_stdio_tx_set_overflow(MBED_STDIO_TX_DROP_NEWEST);
+    startTest();
+    for (int i = 0 ; i < BURST_LINES ; i++)
+    {
+        mbed_stdio_tx_write(g_line, LINE_LENGTH);
+    }
+    endTest("burst_drop_newest", BURST_LINES * LINE_LENGTH);
+    mbed_stdio_tx_set_overflow(MBED_STDIO_TX_BLOCK);
+
+    printStats();
+
+#if !MBED_CONF_PLATFORM_STDIO_BUFFERED_SERIAL
+    printf("Serial tests at %u baud\n", SERIAL_BENCH_BAUD);
+    benchSerial();
+#endif
+
+    printf("ConsoleBench complete\n");
+    return g_failures;
+}
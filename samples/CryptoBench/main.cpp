@@ -0,0 +1,523 @@
+/* Copyright 2017 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Micro-benchmarks for the mbed TLS build in external/mbed-os/features/mbedtls.
+   Measures symmetric cipher and hash throughput, ECDSA, ECDH and RSA operations
+   per second and the peak mbed TLS heap used by each operation so that config.h
+   changes (ECP window size, MBEDTLS_ECP_NIST_OPTIM, AES tables, *_ALT hardware
+   acceleration) can be compared.
+
+   Built by gcc4mbed for the devices listed in Makefile. The HOST_SIM build,
+   run with HOST_SIM/CryptoBench.elf, uses the full configuration as HOST_SIM
+   has a TRNG. Another configuration can be tried by adding, for example,
+   -DMBEDTLS_USER_CONFIG_FILE=\"myconfig.h\" to DEFINES in Makefile.
+
+   Each benchmark prints a single line of key=value pairs:
+       RESULT test=<name> ops=<count> us=<elapsed> [mbps=<MB/s>] ops_per_sec=<rate> us_per_op=<time> heap_peak=<bytes>
+   heap_peak is the most mbed TLS heap in use at once by one operation. It is
+   only measured when the configuration enables MBEDTLS_PLATFORM_MEMORY (the
+   full configuration used on devices with a TRNG) and reads -1 otherwise.
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mbed.h>
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include "mbedtls/platform.h"
+#include "mbedtls_heap_stats.h"
+#include "mbedtls/aes.h"
+#include "mbedtls/gcm.h"
+#include "mbedtls/ccm.h"
+#include "mbedtls/sha1.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/bignum.h"
+#include "mbedtls/ecp.h"
+#include "mbedtls/ecdsa.h"
+#include "mbedtls/ecdh.h"
+#include "mbedtls/rsa.h"
+
+
+// Each benchmark repeats its operation for at least this long.
+#define BENCH_MIN_US        1000000
+
+// Size of the buffer handed to each cipher and hash call.
+#define BENCH_BUFFER_SIZE   1024
+
+
+static unsigned char g_input[BENCH_BUFFER_SIZE];
+static unsigned char g_output[BENCH_BUFFER_SIZE];
+static unsigned char g_digest[64];
+
+
+// Monotonic microsecond clock.
+static Timer g_timer;
+
+static uint32_t microseconds()
+{
+    return g_timer.read_us();
+}
+
+static void startClock()
+{
+    g_timer.start();
+}
+
+
+// heap_peak comes from the mbedtls_heap_stats counters in mbed-os, which can
+// only be installed when mbed TLS allocates through replaceable pointers.
+#if defined(MBEDTLS_PLATFORM_MEMORY) && !defined(MBEDTLS_PLATFORM_CALLOC_MACRO) && !defined(MBEDTLS_PLATFORM_FREE_MACRO)
+#define HEAP_STATS 1
+#else
+#define HEAP_STATS 0
+#endif
+
+
+// Benchmarks only need repeatable input, not secure random numbers.
+static int benchRandom(void* pContext, unsigned char* pOutput, size_t length)
+{
+    static uint32_t state = 0x12345678;
+
+    while (length--)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        *pOutput++ = (unsigned char)state;
+    }
+    return 0;
+}
+
+
+typedef int (*BenchOperation)(void* pContext);
+
+// Lets scripts tell a benchmark that isn't in this configuration from a missing line.
+static void printSkipped(const char* pName)
+{
+    printf("RESULT test=%s skipped=1\n", pName);
+}
+
+static void runBench(const char* pName, BenchOperation operation, void* pContext, size_t bytesPerOp)
+{
+    uint32_t ops = 0;
+    uint32_t elapsedUs = 0;
+    int      heapPeak = -1;
+
+#if HEAP_STATS
+    size_t heapBase;
+    mbedtls_heap_stats_get(&heapBase, NULL);
+    mbedtls_heap_stats_reset_peak();
+#endif
+
+    uint32_t startUs = microseconds();
+    do
+    {
+        if (operation(pContext) != 0)
+        {
+            printf("RESULT test=%s error=1\n", pName);
+            return;
+        }
+        ops++;
+        elapsedUs = microseconds() - startUs;
+    } while (elapsedUs < BENCH_MIN_US);
+    if (elapsedUs == 0)
+        elapsedUs = 1;
+
+#if HEAP_STATS
+    size_t heapHigh;
+    mbedtls_heap_stats_get(NULL, &heapHigh);
+    heapPeak = (int)(heapHigh - heapBase);
+#endif
+
+    // Rates are printed as fixed point with 3 decimal places so that the
+    // sample works without floating point printf support.
+    uint32_t milliOpsPerSec = (uint32_t)((uint64_t)ops * 1000000000 / elapsedUs);
+    printf("RESULT test=%s ops=%lu us=%lu", pName, (unsigned long)ops, (unsigned long)elapsedUs);
+    if (bytesPerOp)
+    {
+        uint32_t milliMBps = (uint32_t)((uint64_t)ops * bytesPerOp * 1000 / elapsedUs);
+        printf(" mbps=%lu.%03lu", (unsigned long)(milliMBps / 1000), (unsigned long)(milliMBps % 1000));
+    }
+    printf(" ops_per_sec=%lu.%03lu us_per_op=%lu heap_peak=%d\n",
+           (unsigned long)(milliOpsPerSec / 1000), (unsigned long)(milliOpsPerSec % 1000),
+           (unsigned long)(elapsedUs / ops), heapPeak);
+}
+
+
+#if defined(MBEDTLS_AES_C)
+static mbedtls_aes_context g_aes;
+static unsigned char       g_iv[16];
+static unsigned char       g_tag[16];
+
+static int aesCbc(void* pContext)
+{
+    return mbedtls_aes_crypt_cbc(&g_aes, MBEDTLS_AES_ENCRYPT, sizeof(g_input), g_iv, g_input, g_output);
+}
+
+#if defined(MBEDTLS_GCM_C)
+static mbedtls_gcm_context g_gcm;
+
+static int aesGcm(void* pContext)
+{
+    return mbedtls_gcm_crypt_and_tag(&g_gcm, MBEDTLS_GCM_ENCRYPT, sizeof(g_input), g_iv, 12, NULL, 0,
+                                     g_input, g_output, sizeof(g_tag), g_tag);
+}
+#endif
+
+#if defined(MBEDTLS_CCM_C)
+static mbedtls_ccm_context g_ccm;
+
+static int aesCcm(void* pContext)
+{
+    return mbedtls_ccm_encrypt_and_tag(&g_ccm, sizeof(g_input), g_iv, 12, NULL, 0,
+                                       g_input, g_output, g_tag, sizeof(g_tag));
+}
+#endif
+
+static void benchAes()
+{
+    static const unsigned int keyBits[] = { 128, 256 };
+    unsigned char             key[32];
+    char                      name[32];
+
+    benchRandom(NULL, key, sizeof(key));
+    for (size_t i = 0 ; i < sizeof(keyBits) / sizeof(keyBits[0]) ; i++)
+    {
+        mbedtls_aes_init(&g_aes);
+        mbedtls_aes_setkey_enc(&g_aes, key, keyBits[i]);
+        snprintf(name, sizeof(name), "aes-%u-cbc", keyBits[i]);
+        runBench(name, aesCbc, NULL, sizeof(g_input));
+        mbedtls_aes_free(&g_aes);
+
+        snprintf(name, sizeof(name), "aes-%u-gcm", keyBits[i]);
+#if defined(MBEDTLS_GCM_C)
+        mbedtls_gcm_init(&g_gcm);
+        mbedtls_gcm_setkey(&g_gcm, MBEDTLS_CIPHER_ID_AES, key, keyBits[i]);
+        runBench(name, aesGcm, NULL, sizeof(g_input));
+        mbedtls_gcm_free(&g_gcm);
+#else
+        printSkipped(name);
+#endif
+
+        snprintf(name, sizeof(name), "aes-%u-ccm", keyBits[i]);
+#if defined(MBEDTLS_CCM_C)
+        mbedtls_ccm_init(&g_ccm);
+        mbedtls_ccm_setkey(&g_ccm, MBEDTLS_CIPHER_ID_AES, key, keyBits[i]);
+        runBench(name, aesCcm, NULL, sizeof(g_input));
+        mbedtls_ccm_free(&g_ccm);
+#else
+        printSkipped(name);
+#endif
+    }
+}
+#endif
+
+
+#if defined(MBEDTLS_SHA1_C)
+static int sha1(void* pContext)
+{
+    mbedtls_sha1(g_input, sizeof(g_input), g_digest);
+    return 0;
+}
+#endif
+
+#if defined(MBEDTLS_SHA256_C)
+static int sha256(void* pContext)
+{
+    mbedtls_sha256(g_input, sizeof(g_input), g_digest, 0);
+    return 0;
+}
+#endif
+
+
+#if defined(MBEDTLS_ECP_C)
+struct EcpBench
+{
+    mbedtls_ecp_group  group;
+    mbedtls_mpi        d;
+    mbedtls_ecp_point  Q;
+    mbedtls_mpi        r;
+    mbedtls_mpi        s;
+    mbedtls_mpi        peerD;
+    mbedtls_ecp_point  peerQ;
+    mbedtls_mpi        z;
+};
+
+static EcpBench g_ecp;
+
+#if defined(MBEDTLS_ECDSA_C)
+static int ecdsaSign(void* pContext)
+{
+    return mbedtls_ecdsa_sign(&g_ecp.group, &g_ecp.r, &g_ecp.s, &g_ecp.d, g_digest, 32, benchRandom, NULL);
+}
+
+static int ecdsaVerify(void* pContext)
+{
+    return mbedtls_ecdsa_verify(&g_ecp.group, g_digest, 32, &g_ecp.Q, &g_ecp.r, &g_ecp.s);
+}
+#endif
+
+#if defined(MBEDTLS_ECDH_C)
+// An ephemeral key exchange as done by each ECDHE handshake: generate a key
+// pair then combine it with the peer's public key.
+static int ecdh(void* pContext)
+{
+    int result = mbedtls_ecdh_gen_public(&g_ecp.group, &g_ecp.d, &g_ecp.Q, benchRandom, NULL);
+    if (result == 0)
+        result = mbedtls_ecdh_compute_shared(&g_ecp.group, &g_ecp.z, &g_ecp.peerQ, &g_ecp.d, benchRandom, NULL);
+    return result;
+}
+#endif
+
+static void benchCurve(mbedtls_ecp_group_id id, const char* pCurveName)
+{
+    char name[40];
+
+    mbedtls_ecp_group_init(&g_ecp.group);
+    mbedtls_mpi_init(&g_ecp.d);
+    mbedtls_ecp_point_init(&g_ecp.Q);
+    mbedtls_mpi_init(&g_ecp.r);
+    mbedtls_mpi_init(&g_ecp.s);
+    mbedtls_mpi_init(&g_ecp.peerD);
+    mbedtls_ecp_point_init(&g_ecp.peerQ);
+    mbedtls_mpi_init(&g_ecp.z);
+
+    if (mbedtls_ecp_group_load(&g_ecp.group, id) == 0 &&
+        mbedtls_ecp_gen_keypair(&g_ecp.group, &g_ecp.d, &g_ecp.Q, benchRandom, NULL) == 0 &&
+        mbedtls_ecp_gen_keypair(&g_ecp.group, &g_ecp.peerD, &g_ecp.peerQ, benchRandom, NULL) == 0)
+    {
+#if defined(MBEDTLS_ECDSA_C)
+        // Curve25519 can only be used for key exchange.
+        if (id != MBEDTLS_ECP_DP_CURVE25519)
+        {
+            snprintf(name, sizeof(name), "ecdsa-sign-%s", pCurveName);
+            runBench(name, ecdsaSign, NULL, 0);
+            snprintf(name, sizeof(name), "ecdsa-verify-%s", pCurveName);
+            runBench(name, ecdsaVerify, NULL, 0);
+        }
+#endif
+        snprintf(name, sizeof(name), "ecdh-%s", pCurveName);
+#if defined(MBEDTLS_ECDH_C)
+        runBench(name, ecdh, NULL, 0);
+#else
+        printSkipped(name);
+#endif
+    }
+    else
+    {
+        printf("RESULT test=ecp-%s error=1\n", pCurveName);
+    }
+
+    mbedtls_mpi_free(&g_ecp.z);
+    mbedtls_ecp_point_free(&g_ecp.peerQ);
+    mbedtls_mpi_free(&g_ecp.peerD);
+    mbedtls_mpi_free(&g_ecp.s);
+    mbedtls_mpi_free(&g_ecp.r);
+    mbedtls_ecp_point_free(&g_ecp.Q);
+    mbedtls_mpi_free(&g_ecp.d);
+    mbedtls_ecp_group_free(&g_ecp.group);
+}
+
+static void benchEcp()
+{
+    const mbedtls_ecp_curve_info* pCurve;
+
+    for (pCurve = mbedtls_ecp_curve_list() ; pCurve->grp_id != MBEDTLS_ECP_DP_NONE ; pCurve++)
+        benchCurve(pCurve->grp_id, pCurve->name);
+
+    // Montgomery curves aren't in mbedtls_ecp_curve_list() as TLS doesn't use them yet.
+#if defined(MBEDTLS_ECP_DP_CURVE25519_ENABLED)
+    benchCurve(MBEDTLS_ECP_DP_CURVE25519, "x25519");
+#endif
+}
+#endif
+
+
+#if defined(MBEDTLS_RSA_C)
+// Fixed 2048-bit test key, generating one would take minutes on some devices.
+static const char g_rsaN[] =
+    "CF851B7B1D729755454FAA25F2AF6F929714310040688294EAB0386BC39DAF93"
+    "7F3E6DD4523CA24D17388DB8727424CE21860A7970BE277071199E5BD4EF2EA5"
+    "6E33A9CAE0C76E7F45D7F01543BA265D1236C8FB8297C78BB5989ACC6890F5A3"
+    "33354C2FF30479CE4BCB887E9706EDCCC3DB7E8731C807D39627A5DE4E95CFAD"
+    "7B22932046458967630AECF5DDF617C9027D59736DA66AAA33E007AF4B775685"
+    "BC403081C7A3D2A506861CD67A801F5CBA3883F8D685C915E207FD04AD6BC62C"
+    "233DF89C961D36493F8FAA5C4D8F36420BD688BD8BD4F3200C95ACB21DDA08C9"
+    "4215F514F7FD0D75AC4BD578988B56416D31E20868C984D455933D5615C579E7";
+static const char g_rsaE[] =
+    "10001";
+static const char g_rsaD[] =
+    "54B242F110A7C0543121BE941664BBE8DC7885375112569968DFDB6740438F71"
+    "67B19729DD169A37548EE468AF6DEFC7A1AF0F7F592083004568EB5517A73726"
+    "95BFC840E155042835DD5843958CD8338C4787E7FEF8EB9C7DD576F88E84FB7C"
+    "4C5E2866398D4E19809DE56BA54052B60C09FDAE3807280A97723F2468768477"
+    "D16CA300D37DF55CB77E48863C29DCE802D58535382BD0FD138757D27441F893"
+    "D1AA121913A38E67BE263D21A22D81A5DDCDE5E4666BEAC538A2750F4F08EC55"
+    "150BD674E20B787B9D635345DBC7E6C30929AF2110A18B633B7FF4A90A16A069"
+    "0932CD5D3CFA7054C07B3C377E8356168A0F76FC64EB5950BDC72E915F3E8F61";
+static const char g_rsaP[] =
+    "E993FF2E42775988B0018FC1B03EF008D528BF2E29504EE01EB4633B75D3B672"
+    "29C3A8D56B56B5B1C892FB027391A04BFBF62E5D8CCCDFF0F6A0E332BEFD807F"
+    "094B59E5C0648ED756007EA91CA47B39C1D6F568D39687AA70A02D48ED4D791E"
+    "33CE1F880F22F67A2760A92B6C6ED33BCAD44EB16CD59E18DBB2CF98A16EA565";
+static const char g_rsaQ[] =
+    "E370C04D384DA9785C2E75DA6FA364112FD7AF1BD4CEB08CABE3377B2F242C23"
+    "3F33CB4A25BDD6706C40E46C530C03AF3DB4CDDEDAD9DC76298A1D223FAA6206"
+    "5D5B0FB82B82BA22CD1FFD6779D4631B200874555F70A5AE476FF6D8567DAEF2"
+    "E5E4B1C155CF20D43B9B3B211509ABB2FAB43D2095A9927856018A5513B6835B";
+static const char g_rsaDP[] =
+    "2F88AFC0A1441A93678619D447E2B704852492AB793ADFA25A7D49487B750746"
+    "FA5AD80BFE9919C6C153B00352B38B148B8510F076CBE6B2E9EDD9EEA4D18009"
+    "DA415C5D162720AE8FD0EFF5C85F6CB8574B408C01AB3B96A2EEE5E8566A92C0"
+    "63B889D02D8C66EE7AFEFFCE5775C24503C4EAF2CE7C367D46908010C6A176C5";
+static const char g_rsaDQ[] =
+    "CDA3A94B6867D79D8A833B6DA7D8AC6659C2828200746CEE938F5A1F97ACF5F7"
+    "5C72C110A6753148EEA7F19FFBAA763E60E573EA5627FB0C1F5CD020A23DB469"
+    "9AC8F5BA8824A79545AFF1D738310EF67C8D085A1473EE69580FE4B90FE28D66"
+    "F2F346C0CE8BFB5BC914FE6E57EE297F26EC0604CB2CC9D0E1BA7CCF958644D7";
+static const char g_rsaQP[] =
+    "384D71F134B26685CE01B6E7D4CBBA1BA64E04F8F3017908A359AEAA71304C2F"
+    "706CC17E8B92E8EA626441E7C54C7E3E191A555CCF8A9A476124339AFE5AC861"
+    "A66BC503D6D0E16B06C8552A1A1CF78AD8AD034404EB0316745D4E69A07DC1C7"
+    "311251653A95EFFBD0B82A2D3AA49AD166130FC71EDD3A4CBECD98ACF7384393";
+static mbedtls_rsa_context g_rsa;
+
+static int rsaPublic(void* pContext)
+{
+    return mbedtls_rsa_public(&g_rsa, g_input, g_output);
+}
+
+static int rsaPrivate(void* pContext)
+{
+    return mbedtls_rsa_private(&g_rsa, benchRandom, NULL, g_input, g_output);
+}
+
+static void benchRsa()
+{
+    mbedtls_rsa_init(&g_rsa, MBEDTLS_RSA_PKCS_V15, 0);
+    if (mbedtls_mpi_read_string(&g_rsa.N, 16, g_rsaN) != 0 ||
+        mbedtls_mpi_read_string(&g_rsa.E, 16, g_rsaE) != 0 ||
+        mbedtls_mpi_read_string(&g_rsa.D, 16, g_rsaD) != 0 ||
+        mbedtls_mpi_read_string(&g_rsa.P, 16, g_rsaP) != 0 ||
+        mbedtls_mpi_read_string(&g_rsa.Q, 16, g_rsaQ) != 0 ||
+        mbedtls_mpi_read_string(&g_rsa.DP, 16, g_rsaDP) != 0 ||
+        mbedtls_mpi_read_string(&g_rsa.DQ, 16, g_rsaDQ) != 0 ||
+        mbedtls_mpi_read_string(&g_rsa.QP, 16, g_rsaQP) != 0)
+    {
+        printf("RESULT test=rsa-2048 error=1\n");
+        mbedtls_rsa_free(&g_rsa);
+        return;
+    }
+    g_rsa.len = mbedtls_mpi_size(&g_rsa.N);
+
+    // The input has to be less than N.
+    memset(g_input, 0x5A, g_rsa.len);
+    g_input[0] = 0;
+
+    runBench("rsa-2048-public", rsaPublic, NULL, 0);
+    runBench("rsa-2048-private", rsaPrivate, NULL, 0);
+    mbedtls_rsa_free(&g_rsa);
+}
+#endif
+
+
+static void printConfig()
+{
+    printf("CryptoBench: mbed TLS config");
+#if defined(MBEDTLS_ECP_C)
+    printf(" ecp_window_size=%d ecp_fixed_point_optim=%d", MBEDTLS_ECP_WINDOW_SIZE, MBEDTLS_ECP_FIXED_POINT_OPTIM);
+#if defined(MBEDTLS_ECP_FIXED_POINT_TABLES)
+    printf(" ecp_fixed_point_tables=%d", MBEDTLS_ECP_FIXED_POINT_TABLES);
+#endif
+#if defined(MBEDTLS_ECP_NIST_OPTIM)
+    printf(" ecp_nist_optim=1");
+#else
+    printf(" ecp_nist_optim=0");
+#endif
+#endif
+    printf(" mpi_window_size=%d", MBEDTLS_MPI_WINDOW_SIZE);
+#if defined(MBEDTLS_HAVE_ASM)
+    printf(" have_asm=1");
+#else
+    printf(" have_asm=0");
+#endif
+#if defined(MBEDTLS_AES_ROM_TABLES)
+    printf(" aes_rom_tables=1");
+#else
+    printf(" aes_rom_tables=0");
+#endif
+#if defined(MBEDTLS_AES_ALT)
+    printf(" aes_alt=1");
+#else
+    printf(" aes_alt=0");
+#endif
+#if defined(MBEDTLS_SHA1_ALT)
+    printf(" sha1_alt=1");
+#else
+    printf(" sha1_alt=0");
+#endif
+#if defined(MBEDTLS_SHA256_ALT)
+    printf(" sha256_alt=1");
+#else
+    printf(" sha256_alt=0");
+#endif
+    printf(" heap_stats=%d\n", HEAP_STATS);
+}
+
+
+int main()
+{
+#if HEAP_STATS
+    mbedtls_heap_stats_install();
+#endif
+    startClock();
+    benchRandom(NULL, g_input, sizeof(g_input));
+
+    printConfig();
+#if defined(MBEDTLS_AES_C)
+    benchAes();
+#else
+    printSkipped("aes");
+#endif
+#if defined(MBEDTLS_SHA1_C)
+    runBench("sha1", sha1, NULL, sizeof(g_input));
+#else
+    printSkipped("sha1");
+#endif
+#if defined(MBEDTLS_SHA256_C)
+    runBench("sha256", sha256, NULL, sizeof(g_input));
+#else
+    printSkipped("sha256");
+#endif
+#if defined(MBEDTLS_ECP_C)
+    benchEcp();
+#else
+    printSkipped("ecp");
+#endif
+#if defined(MBEDTLS_RSA_C)
+    benchRsa();
+#else
+    printSkipped("rsa");
+#endif
+    printf("CryptoBench: done\n");
+
+    return 0;
+}
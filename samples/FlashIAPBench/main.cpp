@@ -0,0 +1,203 @@
+/* Copyright 2017 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Exercises FlashIAPBlockDevice on the last REGION_SIZE bytes of internal
+   flash and reports how many page programs and sector erases reach the flash
+   when programming whole pages, erasing used and blank sectors and updating
+   small KVStore keys.
+
+   Built by gcc4mbed for the devices listed in Makefile. The HOST_SIM build,
+   run with HOST_SIM/FlashIAPBench.elf, fails any program which is misaligned,
+   crosses a sector or programs a byte a second time before it is erased, like
+   flash with ECC does.
+
+   Each benchmark prints a single line of key=value pairs:
+       RESULT test=<name> ops=<count> us=<elapsed> programs=<pages>
+              erases=<sectors> erases_skipped=<sectors>
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mbed.h>
+
+#include "FlashIAPBlockDevice.h"
+#include "KVStore.h"
+
+
+#define REGION_SIZE     (64 * 1024)
+#define VALUE_SIZE      16
+#define KV_KEY_COUNT    16
+#define KV_UPDATES      4000
+
+
+static Timer g_timer;
+
+static uint32_t microseconds()
+{
+    return g_timer.read_us();
+}
+
+static void startClock()
+{
+    g_timer.start();
+}
+
+
+static void checkResult(int result, const char* pOperation)
+{
+    if (result < 0)
+    {
+        printf("error: %s failed with %d\n", pOperation, result);
+        exit(1);
+    }
+}
+
+static uint8_t pattern(bd_addr_t addr)
+{
+    return (uint8_t)(addr * 7 + (addr >> 8));
+}
+
+static void printResult(FlashIAPBlockDevice* pDevice, const char* pTest, uint32_t ops, uint32_t start)
+{
+    uint32_t us = microseconds() - start;
+    printf("RESULT test=%s ops=%lu us=%lu programs=%lu erases=%lu erases_skipped=%lu\n",
+           pTest, (unsigned long)ops, (unsigned long)us,
+           (unsigned long)pDevice->get_program_count(),
+           (unsigned long)pDevice->get_erase_count(), (unsigned long)pDevice->get_erase_skip_count());
+}
+
+
+// Programs the whole region a page at a time, then reads it back.
+static void benchPagePrograms(FlashIAPBlockDevice* pDevice)
+{
+    bd_size_t pageSize = pDevice->get_program_size();
+    uint32_t  pages = REGION_SIZE / pageSize;
+    uint8_t*  pPage = (uint8_t*)malloc(pageSize);
+    if (!pPage)
+    {
+        printf("error: can't allocate a %lu byte page\n", (unsigned long)pageSize);
+        exit(1);
+    }
+
+    checkResult(pDevice->erase(0, REGION_SIZE), "erase");
+    pDevice->reset_counters();
+
+    uint32_t start = microseconds();
+    for (uint32_t i = 0 ; i < pages ; i++)
+    {
+        bd_addr_t addr = i * pageSize;
+        for (bd_size_t j = 0 ; j < pageSize ; j++)
+        {
+            pPage[j] = pattern(addr + j);
+        }
+        checkResult(pDevice->program(pPage, addr, pageSize), "program");
+    }
+    printResult(pDevice, "program_pages", pages, start);
+
+    for (uint32_t i = 0 ; i < pages ; i++)
+    {
+        bd_addr_t addr = i * pageSize;
+        checkResult(pDevice->read(pPage, addr, pageSize), "read");
+        for (bd_size_t j = 0 ; j < pageSize ; j++)
+        {
+            if (pPage[j] != pattern(addr + j))
+            {
+                printf("error: mismatch at %lu\n", (unsigned long)(addr + j));
+                exit(1);
+            }
+        }
+    }
+    free(pPage);
+}
+
+// Erases the region written by benchPagePrograms() twice, the second time when blank.
+static void benchErases(FlashIAPBlockDevice* pDevice)
+{
+    uint32_t sectors = REGION_SIZE / pDevice->get_erase_size();
+
+    pDevice->reset_counters();
+    uint32_t start = microseconds();
+    checkResult(pDevice->erase(0, REGION_SIZE), "erase");
+    printResult(pDevice, "erase_used", sectors, start);
+
+    pDevice->reset_counters();
+    start = microseconds();
+    checkResult(pDevice->erase(0, REGION_SIZE), "erase");
+    printResult(pDevice, "erase_blank", sectors, start);
+}
+
+// Updates a few small keys of a KVStore, syncing after each one.
+static void benchKVStore(FlashIAPBlockDevice* pDevice)
+{
+    KVStore  kv;
+    uint8_t  value[VALUE_SIZE];
+    char     key[16];
+
+    checkResult(KVStore::format(pDevice), "KVStore::format");
+    checkResult(kv.mount(pDevice), "KVStore::mount");
+
+    pDevice->reset_counters();
+    uint32_t start = microseconds();
+    for (uint32_t i = 0 ; i < KV_UPDATES ; i++)
+    {
+        snprintf(key, sizeof(key), "k%02lu", (unsigned long)(i % KV_KEY_COUNT));
+        memset(value, (int)i, sizeof(value));
+        checkResult(kv.set(key, value, sizeof(value)), "KVStore::set");
+        checkResult(kv.sync(), "KVStore::sync");
+    }
+    printResult(pDevice, "kvstore_set", KV_UPDATES, start);
+
+    checkResult(kv.unmount(), "KVStore::unmount");
+    checkResult(kv.mount(pDevice), "KVStore::mount");
+    for (uint32_t i = KV_UPDATES - KV_KEY_COUNT ; i < KV_UPDATES ; i++)
+    {
+        snprintf(key, sizeof(key), "k%02lu", (unsigned long)(i % KV_KEY_COUNT));
+        checkResult(kv.get(key, value, sizeof(value)), "KVStore::get");
+        if (value[0] != (uint8_t)i)
+        {
+            printf("error: %s has a stale value\n", key);
+            exit(1);
+        }
+    }
+    checkResult(kv.unmount(), "KVStore::unmount");
+}
+
+
+int main()
+{
+    startClock();
+
+    mbed::FlashIAP flash;
+    checkResult(flash.init(), "FlashIAP::init");
+    uint32_t flashEnd = flash.get_flash_start() + flash.get_flash_size();
+    uint32_t pageSize = flash.get_page_size();
+    flash.deinit();
+
+    FlashIAPBlockDevice device(flashEnd - REGION_SIZE, REGION_SIZE);
+    checkResult(device.init(), "FlashIAPBlockDevice::init");
+    printf("FlashIAPBench: %uKB region at 0x%08lx, %lu byte pages, %lu byte sectors\n",
+           REGION_SIZE / 1024, (unsigned long)(flashEnd - REGION_SIZE),
+           (unsigned long)pageSize, (unsigned long)device.get_erase_size());
+
+    benchPagePrograms(&device);
+    benchErases(&device);
+    benchKVStore(&device);
+
+    checkResult(device.erase(0, REGION_SIZE), "erase");
+    checkResult(device.deinit(), "FlashIAPBlockDevice::deinit");
+    printf("FlashIAPBench complete\n");
+    return 0;
+}
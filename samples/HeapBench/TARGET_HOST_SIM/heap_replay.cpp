@@ -0,0 +1,398 @@
+/* Copyright 2017 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Replays allocation traces against mbed_tlsf.c and the host's own malloc,
+   after HeapBench's own run in the HOST_SIM build.
+
+   A trace is either the synthetic workload which HeapBench runs on the
+   device, or the output of mbed_mem_trace_default_callback() captured from a
+   device built with MBED_MEM_TRACING_ENABLED:
+       #m:<result>;<caller>-<size>
+       #r:<result>;<caller>-<old pointer>;<size>
+       #c:<result>;<caller>-<count>;<size>
+       #f:<result>;<caller>-<pointer>
+   Other lines are ignored, so the whole serial log can be passed in on the
+   command line:
+       HOST_SIM/HeapBench.elf capture1.log capture2.log
+
+   TLSF gets a single pool of HEAP_SIZE bytes, like a device's heap. It is
+   first run checking the heap with mbed_tlsf_check() and the contents of
+   every block, sampling the fragmentation every CHECK_INTERVAL operations.
+   mbed_tlsf.c checks its own lists too when the mbed library is built with
+   GCC4MBED_TYPE=Debug.
+       HEAP allocator=tlsf trace=<name> samples=<count> mean_fragmentation_pct=<percent>
+            max_fragmentation_pct=<percent> min_largest_free=<bytes> failed=<count>
+   where fragmentation is the share of the free space outside the largest
+   free block. Then each allocator is timed:
+       RESULT allocator=<tlsf|libc> trace=<name> ops=<count> failed=<count> ns_per_op=<mean>
+              max_malloc_ns=<worst> max_realloc_ns=<worst> max_free_ns=<worst>
+   Worst cases on the host include any time the process spent descheduled.
+   newlib isn't available on the host either, so the comparison with it, and
+   the worst cases that count, come from HeapBench on the device.
+*/
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include "mbed_tlsf.h"
+#include "heap_replay.h"
+#include "workload.h"
+
+
+#ifndef HEAP_SIZE
+#define HEAP_SIZE       (64 * 1024)
+#endif
+#ifndef LIVE_MAX
+#define LIVE_MAX        (HEAP_SIZE / 2)
+#endif
+#ifndef OP_COUNT
+#define OP_COUNT        (1000 * 1000)
+#endif
+#define CHECK_INTERVAL  1000
+
+
+typedef std::vector<HeapOp> Trace;
+
+struct Allocator
+{
+    const char* pName;
+    void*       (*pMalloc)(size_t size);
+    void*       (*pRealloc)(void* pOld, size_t size);
+    void        (*pFree)(void* p);
+};
+
+
+static mbed_tlsf_t g_tlsf;
+static uint64_t    g_pool[HEAP_SIZE / sizeof(uint64_t)];
+
+
+static void* tlsfMalloc(size_t size)
+{
+    return mbed_tlsf_malloc(&g_tlsf, size);
+}
+
+static void* tlsfRealloc(void* pOld, size_t size)
+{
+    return mbed_tlsf_realloc(&g_tlsf, pOld, size);
+}
+
+static void tlsfFree(void* p)
+{
+    mbed_tlsf_free(&g_tlsf, p);
+}
+
+static const Allocator g_tlsfAllocator = { "tlsf", tlsfMalloc, tlsfRealloc, tlsfFree };
+static const Allocator g_libcAllocator = { "libc", malloc, realloc, free };
+
+
+static void syntheticTrace(Trace* pTrace)
+{
+    Workload workload;
+    HeapOp   op;
+
+    workloadInit(&workload, 1, LIVE_MAX);
+    for (uint32_t i = 0 ; i < OP_COUNT ; i++)
+    {
+        workloadNext(&workload, &op);
+        pTrace->push_back(op);
+    }
+    while (workloadDrain(&workload, &op))
+    {
+        pTrace->push_back(op);
+    }
+}
+
+// Numbers the blocks of a recorded trace in place of their device addresses
+static bool loadTrace(const char* pFilename, Trace* pTrace)
+{
+    FILE* pFile = fopen(pFilename, "r");
+    if (!pFile)
+    {
+        perror(pFilename);
+        return false;
+    }
+
+    std::map<unsigned long, uint32_t> slots;
+    uint32_t                          nextSlot = 0;
+    char                              line[256];
+    while (fgets(line, sizeof(line), pFile))
+    {
+        const char*   pRecord = strstr(line, "#");
+        char          type;
+        unsigned long result, caller, arg1, arg2 = 0;
+        HeapOp        op;
+
+        if (!pRecord || sscanf(pRecord, "#%c:%lx;%lx-%lx;%lu", &type, &result, &caller, &arg1, &arg2) < 4)
+        {
+            continue;
+        }
+        switch (type)
+        {
+        case 'm':
+        case 'c':
+            if (result == 0)
+            {
+                continue;
+            }
+            op.type = HEAP_OP_MALLOC;
+            op.size = (type == 'm') ? strtoul(strrchr(pRecord, '-') + 1, NULL, 10) : (uint32_t)(arg1 * arg2);
+            op.slot = slots[result] = nextSlot++;
+            break;
+        case 'r':
+            if (result == 0 || slots.find(arg1) == slots.end())
+            {
+                continue;
+            }
+            op.type = HEAP_OP_REALLOC;
+            op.size = arg2;
+            op.slot = slots[arg1];
+            slots.erase(arg1);
+            slots[result] = op.slot;
+            break;
+        case 'f':
+            if (slots.find(arg1) == slots.end())
+            {
+                continue;
+            }
+            op.type = HEAP_OP_FREE;
+            op.size = 0;
+            op.slot = slots[arg1];
+            slots.erase(arg1);
+            break;
+        default:
+            continue;
+        }
+        pTrace->push_back(op);
+    }
+    fclose(pFile);
+    return true;
+}
+
+static uint32_t slotCount(const Trace& trace)
+{
+    uint32_t count = 0;
+    for (size_t i = 0 ; i < trace.size() ; i++)
+    {
+        if (trace[i].slot >= count)
+        {
+            count = trace[i].slot + 1;
+        }
+    }
+    return count;
+}
+
+static uint64_t readNanoseconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static uint8_t fillByte(uint32_t slot, uint32_t offset)
+{
+    return (uint8_t)(slot * 31 + offset);
+}
+
+static void fillBlock(void* pBlock, uint32_t slot, uint32_t from, uint32_t to)
+{
+    for (uint32_t i = from ; i < to ; i++)
+    {
+        ((uint8_t*)pBlock)[i] = fillByte(slot, i);
+    }
+}
+
+static bool checkBlock(const void* pBlock, uint32_t slot, uint32_t size)
+{
+    for (uint32_t i = 0 ; i < size ; i++)
+    {
+        if (((const uint8_t*)pBlock)[i] != fillByte(slot, i))
+        {
+            printf("error: block %u corrupted at offset %u\n", slot, i);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Runs the trace against the allocator, printing how long it took. When
+// verify is set the heap and the contents of the blocks are checked instead,
+// and the fragmentation of the TLSF heap is sampled as it goes.
+static bool replay(const Allocator* pAllocator, const char* pTraceName, const Trace& trace, bool verify)
+{
+    std::vector<void*>    blocks(slotCount(trace), (void*)NULL);
+    std::vector<uint32_t> sizes(blocks.size(), 0);
+    uint64_t              maxNs[3] = {0, 0, 0};
+    uint64_t              totalNs = 0;
+    uint32_t              failed = 0;
+    uint32_t              samples = 0;
+    uint32_t              fragmentationSum = 0;
+    uint32_t              fragmentationMax = 0;
+    size_t                largestFreeMin = SIZE_MAX;
+    bool                  sample = verify && pAllocator == &g_tlsfAllocator;
+
+    for (size_t i = 0 ; i < trace.size() ; i++)
+    {
+        const HeapOp& op = trace[i];
+        void*         pOld = blocks[op.slot];
+        void*         pNew = NULL;
+
+        if (verify && pOld && !checkBlock(pOld, op.slot, sizes[op.slot]))
+        {
+            return false;
+        }
+
+        uint64_t start = readNanoseconds();
+        switch (op.type)
+        {
+        case HEAP_OP_MALLOC:
+            pNew = pAllocator->pMalloc(op.size);
+            break;
+        case HEAP_OP_REALLOC:
+            pNew = pAllocator->pRealloc(pOld, op.size);
+            break;
+        case HEAP_OP_FREE:
+            pAllocator->pFree(pOld);
+            break;
+        }
+        uint64_t ns = readNanoseconds() - start;
+        totalNs += ns;
+        if (ns > maxNs[op.type])
+        {
+            maxNs[op.type] = ns;
+        }
+
+        if (op.type == HEAP_OP_FREE)
+        {
+            blocks[op.slot] = NULL;
+            sizes[op.slot] = 0;
+        }
+        else if (pNew)
+        {
+            if (verify)
+            {
+                fillBlock(pNew, op.slot, op.type == HEAP_OP_REALLOC ? sizes[op.slot] : 0, op.size);
+            }
+            blocks[op.slot] = pNew;
+            sizes[op.slot] = op.size;
+        }
+        else
+        {
+            failed++;
+        }
+
+        if (sample && i % CHECK_INTERVAL == CHECK_INTERVAL - 1)
+        {
+            mbed_tlsf_stats_t stats;
+            int               result = mbed_tlsf_check(&g_tlsf);
+            if (result != 0)
+            {
+                printf("error: mbed_tlsf_check() returned %d after operation %lu\n", result, (unsigned long)i);
+                return false;
+            }
+
+            mbed_tlsf_get_stats(&g_tlsf, &stats);
+            uint32_t fragmentation = stats.free_size ? 100 - (uint32_t)((uint64_t)stats.largest_free_size * 100 / stats.free_size) : 0;
+            fragmentationSum += fragmentation;
+            if (fragmentation > fragmentationMax)
+            {
+                fragmentationMax = fragmentation;
+            }
+            if (stats.largest_free_size < largestFreeMin)
+            {
+                largestFreeMin = stats.largest_free_size;
+            }
+            samples++;
+        }
+    }
+
+    if (sample)
+    {
+        printf("HEAP allocator=%s trace=%s samples=%lu mean_fragmentation_pct=%lu max_fragmentation_pct=%lu "
+               "min_largest_free=%lu failed=%lu\n",
+               pAllocator->pName, pTraceName, (unsigned long)samples,
+               samples ? (unsigned long)(fragmentationSum / samples) : 0UL, (unsigned long)fragmentationMax,
+               samples ? (unsigned long)largestFreeMin : 0UL, (unsigned long)failed);
+    }
+    else if (!verify)
+    {
+        printf("RESULT allocator=%s trace=%s ops=%lu failed=%lu ns_per_op=%lu "
+               "max_malloc_ns=%lu max_realloc_ns=%lu max_free_ns=%lu\n",
+               pAllocator->pName, pTraceName, (unsigned long)trace.size(), (unsigned long)failed,
+               (unsigned long)(totalNs / trace.size()), (unsigned long)maxNs[HEAP_OP_MALLOC],
+               (unsigned long)maxNs[HEAP_OP_REALLOC], (unsigned long)maxNs[HEAP_OP_FREE]);
+    }
+
+    // Release whatever the trace didn't, which a capture cut short leaves
+    for (size_t slot = 0 ; slot < blocks.size() ; slot++)
+    {
+        pAllocator->pFree(blocks[slot]);
+    }
+    return true;
+}
+
+static void resetTlsf()
+{
+    mbed_tlsf_init(&g_tlsf);
+    mbed_tlsf_add_pool(&g_tlsf, g_pool, sizeof(g_pool));
+}
+
+static bool runTrace(const char* pTraceName, const Trace& trace)
+{
+    mbed_tlsf_stats_t stats;
+
+    if (trace.empty())
+    {
+        printf("error: %s has no allocations\n", pTraceName);
+        return false;
+    }
+
+    resetTlsf();
+    if (!replay(&g_tlsfAllocator, pTraceName, trace, true))
+    {
+        return false;
+    }
+    mbed_tlsf_get_stats(&g_tlsf, &stats);
+    if (mbed_tlsf_check(&g_tlsf) != 0 || stats.free_cnt != 1)
+    {
+        printf("error: heap not back to one free block at the end of %s\n", pTraceName);
+        return false;
+    }
+
+    resetTlsf();
+    replay(&g_tlsfAllocator, pTraceName, trace, false);
+    replay(&g_libcAllocator, pTraceName, trace, false);
+    return true;
+}
+
+
+bool heapReplay(int traceCount, char** ppTraces)
+{
+    bool passed = true;
+
+    if (traceCount == 0)
+    {
+        Trace trace;
+        syntheticTrace(&trace);
+        passed = runTrace("synthetic", trace);
+    }
+    for (int i = 0 ; i < traceCount ; i++)
+    {
+        Trace trace;
+        passed = loadTrace(ppTraces[i], &trace) && runTrace(ppTraces[i], trace) && passed;
+    }
+
+    return passed;
+}
@@ -0,0 +1,27 @@
+/* Copyright 2017 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Allocation trace replay which the HOST_SIM build of HeapBench runs after
+   its own workload, see heap_replay.cpp.
+*/
+#ifndef HEAP_REPLAY_H_
+#define HEAP_REPLAY_H_
+
+
+/* Replays each of the traceCount capture files named by ppTraces, or the
+   synthetic workload if there are none, returning false if any of them
+   couldn't be read or corrupted the heap. */
+bool heapReplay(int traceCount, char** ppTraces);
+
+#endif /* HEAP_REPLAY_H_ */
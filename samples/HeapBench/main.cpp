@@ -0,0 +1,185 @@
+/* Copyright 2017 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Times malloc(), realloc() and free() under the churn generated by
+   workload.cpp, with whichever allocator the mbed libraries were built with:
+   newlib's by default, or TLSF when MBED_CONF_PLATFORM_TLSF_HEAP is set to 1
+   in src/mbed_config.h. Build the libraries both ways to compare them.
+
+   Each operation is timed by the DWT cycle counter and the test prints a
+   single line of key=value pairs:
+       RESULT allocator=<newlib|tlsf|libc> ops=<count> failed=<count> cycles_per_op=<mean>
+              max_malloc_cycles=<worst> max_realloc_cycles=<worst> max_free_cycles=<worst>
+   The worst cases matter more than the mean for code with deadlines. The
+   TLSF build follows it with the free space left behind by the workload and
+   the result of a heap integrity check:
+       HEAP free=<bytes> largest_free=<bytes> fragmentation_pct=<percent> check=<result>
+
+   The HOST_SIM build, made with make HOST_SIM, runs on the host's own
+   malloc and counts nanoseconds in place of cycles, as there is no DWT.
+   It then replays the workload, or the allocation traces named on its
+   command line, against mbed_tlsf.c; see TARGET_HOST_SIM/heap_replay.cpp:
+       HOST_SIM/HeapBench.elf [capture.log ...]
+   and exits with 1 if the TLSF heap was corrupted.
+*/
+#include <mbed.h>
+#include "cmsis.h"
+#include "mbed_stats.h"
+#include "workload.h"
+
+#if defined(TARGET_HOST_SIM)
+#include <time.h>
+#include "host_sim.h"
+#include "heap_replay.h"
+#endif
+
+
+#define OP_COUNT    (50 * 1000)
+#define SEED        1
+#ifndef LIVE_MAX
+#define LIVE_MAX    (16 * 1024)
+#endif
+
+#if defined(TARGET_HOST_SIM)
+#define ALLOCATOR   "libc"
+#elif MBED_CONF_PLATFORM_TLSF_HEAP
+#define ALLOCATOR   "tlsf"
+#else
+#define ALLOCATOR   "newlib"
+#endif
+
+
+static void* g_slots[WORKLOAD_SLOTS];
+
+
+#if defined(TARGET_HOST_SIM)
+static void startCycleCounter()
+{
+}
+
+static uint32_t readCycleCounter()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000000 + now.tv_nsec);
+}
+#else
+static void startCycleCounter()
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static uint32_t readCycleCounter()
+{
+    return DWT->CYCCNT;
+}
+#endif
+
+// Runs the operation, returning the cycles it took
+static uint32_t runOp(const HeapOp* pOp, uint32_t* pFailed)
+{
+    void*    pOld = g_slots[pOp->slot];
+    void*    pNew = NULL;
+    uint32_t start = readCycleCounter();
+
+    switch (pOp->type)
+    {
+    case HEAP_OP_MALLOC:
+        pNew = malloc(pOp->size);
+        break;
+    case HEAP_OP_REALLOC:
+        pNew = realloc(pOld, pOp->size);
+        break;
+    case HEAP_OP_FREE:
+        free(pOld);
+        break;
+    }
+    uint32_t cycles = readCycleCounter() - start;
+
+    if (pOp->type == HEAP_OP_FREE)
+    {
+        g_slots[pOp->slot] = NULL;
+    }
+    else if (pNew)
+    {
+        g_slots[pOp->slot] = pNew;
+    }
+    else
+    {
+        // Leave a failed realloc's block to be freed later, and make the next
+        // free of a failed malloc's slot free nothing
+        (*pFailed)++;
+    }
+    return cycles;
+}
+
+
+int main()
+{
+    static Workload workload;
+    HeapOp          op;
+    uint32_t        maxCycles[3] = {0, 0, 0};
+    uint64_t        totalCycles = 0;
+    uint32_t        failed = 0;
+    const char*     pAllocator = ALLOCATOR;
+
+    printf("HeapBench: %s allocator, %u operations, %u bytes live at most\n",
+           pAllocator, OP_COUNT, LIVE_MAX);
+    startCycleCounter();
+
+    workloadInit(&workload, SEED, LIVE_MAX);
+    for (uint32_t i = 0 ; i < OP_COUNT ; i++)
+    {
+        workloadNext(&workload, &op);
+        uint32_t cycles = runOp(&op, &failed);
+        totalCycles += cycles;
+        if (cycles > maxCycles[op.type])
+        {
+            maxCycles[op.type] = cycles;
+        }
+    }
+
+    printf("RESULT allocator=%s ops=%lu failed=%lu cycles_per_op=%lu "
+           "max_malloc_cycles=%lu max_realloc_cycles=%lu max_free_cycles=%lu\n",
+           pAllocator, (unsigned long)OP_COUNT, (unsigned long)failed,
+           (unsigned long)(totalCycles / OP_COUNT), (unsigned long)maxCycles[HEAP_OP_MALLOC],
+           (unsigned long)maxCycles[HEAP_OP_REALLOC], (unsigned long)maxCycles[HEAP_OP_FREE]);
+
+#if MBED_CONF_PLATFORM_TLSF_HEAP && !defined(TARGET_HOST_SIM)
+    // Fragmentation is measured with the workload's blocks still allocated
+    mbed_stats_heap_t stats;
+    mbed_stats_heap_get(&stats);
+    printf("HEAP free=%lu largest_free=%lu fragmentation_pct=%lu check=%d\n",
+           (unsigned long)stats.free_size, (unsigned long)stats.largest_free_size,
+           stats.free_size ? (unsigned long)(100 - (uint64_t)stats.largest_free_size * 100 / stats.free_size) : 0UL,
+           mbed_heap_check());
+#endif
+
+    while (workloadDrain(&workload, &op))
+    {
+        runOp(&op, &failed);
+    }
+
+#if defined(TARGET_HOST_SIM)
+    if (!heapReplay(host_sim_argc() - 1, host_sim_argv() + 1))
+    {
+        return 1;
+    }
+#endif
+
+    printf("HeapBench complete\n");
+    return 0;
+}
@@ -0,0 +1,120 @@
+/* Copyright 2017 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "workload.h"
+
+
+/* Slots 0 to 7 hold TLS record buffers, 8 to 39 network buffers and the rest
+   JSON strings. */
+#define TLS_SLOT_END    8
+#define PBUF_SLOT_END   40
+
+
+static uint32_t nextRandom(Workload* pWorkload)
+{
+    pWorkload->seed = pWorkload->seed * 1103515245 + 12345;
+    return pWorkload->seed >> 8;
+}
+
+static uint32_t randomRange(Workload* pWorkload, uint32_t min, uint32_t max)
+{
+    return min + nextRandom(pWorkload) % (max - min + 1);
+}
+
+static uint32_t allocationSize(Workload* pWorkload, uint32_t slot)
+{
+    if (slot < TLS_SLOT_END)
+    {
+        return randomRange(pWorkload, 1024, 4096);
+    }
+    if (slot < PBUF_SLOT_END)
+    {
+        return randomRange(pWorkload, 64, 1536);
+    }
+    return randomRange(pWorkload, 16, 384);
+}
+
+void workloadInit(Workload* pWorkload, uint32_t seed, uint32_t liveMax)
+{
+    pWorkload->seed = seed;
+    pWorkload->liveMax = liveMax;
+    pWorkload->liveBytes = 0;
+    for (uint32_t i = 0 ; i < WORKLOAD_SLOTS ; i++)
+    {
+        pWorkload->sizes[i] = 0;
+    }
+}
+
+void workloadNext(Workload* pWorkload, HeapOp* pOp)
+{
+    for (;;)
+    {
+        uint32_t slot = nextRandom(pWorkload) % WORKLOAD_SLOTS;
+        uint32_t size = pWorkload->sizes[slot];
+
+        if (size == 0)
+        {
+            size = allocationSize(pWorkload, slot);
+            if (pWorkload->liveBytes + size > pWorkload->liveMax)
+            {
+                continue;
+            }
+            pOp->type = HEAP_OP_MALLOC;
+        }
+        else if (slot >= PBUF_SLOT_END && size < 2048 && nextRandom(pWorkload) % 2 == 0)
+        {
+            // Strings grow by half again as more is appended
+            uint32_t newSize = size + size / 2;
+            if (pWorkload->liveBytes + newSize - size > pWorkload->liveMax)
+            {
+                continue;
+            }
+            pWorkload->liveBytes -= size;
+            size = newSize;
+            pOp->type = HEAP_OP_REALLOC;
+        }
+        else
+        {
+            pWorkload->liveBytes -= size;
+            pWorkload->sizes[slot] = 0;
+            pOp->type = HEAP_OP_FREE;
+            pOp->slot = slot;
+            pOp->size = 0;
+            return;
+        }
+
+        pWorkload->liveBytes += size;
+        pWorkload->sizes[slot] = size;
+        pOp->slot = slot;
+        pOp->size = size;
+        return;
+    }
+}
+
+bool workloadDrain(Workload* pWorkload, HeapOp* pOp)
+{
+    for (uint32_t slot = 0 ; slot < WORKLOAD_SLOTS ; slot++)
+    {
+        if (pWorkload->sizes[slot])
+        {
+            pWorkload->liveBytes -= pWorkload->sizes[slot];
+            pWorkload->sizes[slot] = 0;
+            pOp->type = HEAP_OP_FREE;
+            pOp->slot = slot;
+            pOp->size = 0;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,58 @@
+/* Copyright 2017 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Synthetic heap workload modelled on a connected device that runs for
+   months: short lived network buffers, JSON strings which grow as they are
+   built and longer lived TLS record buffers, all churning through the heap
+   at once. The same seed always gives the same sequence of operations.
+*/
+#ifndef WORKLOAD_H_
+#define WORKLOAD_H_
+
+#include <stdint.h>
+
+
+#define WORKLOAD_SLOTS  64
+
+typedef enum
+{
+    HEAP_OP_MALLOC,
+    HEAP_OP_REALLOC,
+    HEAP_OP_FREE
+} HeapOpType;
+
+typedef struct HeapOp
+{
+    HeapOpType type;
+    uint32_t   slot;
+    uint32_t   size;
+} HeapOp;
+
+typedef struct Workload
+{
+    uint32_t seed;
+    uint32_t liveMax;
+    uint32_t liveBytes;
+    uint32_t sizes[WORKLOAD_SLOTS];
+} Workload;
+
+
+/* Live allocations are kept under liveMax bytes so that the workload fits the
+   heap of the device it runs on. */
+void workloadInit(Workload* pWorkload, uint32_t seed, uint32_t liveMax);
+void workloadNext(Workload* pWorkload, HeapOp* pOp);
+/* Frees what is left allocated, returning false once all slots are empty. */
+bool workloadDrain(Workload* pWorkload, HeapOp* pOp);
+
+#endif /* WORKLOAD_H_ */
@@ -0,0 +1,312 @@
+/* Copyright 2017 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Runs each of the TARGET_HOST_SIM peripherals through the regular mbed
+   drivers, so that a CI job can check the simulation still works before it
+   relies on it for other tests.
+
+   Each test prints a single line of key=value pairs:
+       RESULT test=<name> pass=<0|1> [<measurement>=<value> ...]
+   and the process exits with the number of tests which failed. The timeout
+   test also reports how many microseconds late its callbacks ran, which
+   is the figure to watch for scheduling regressions in the simulation.
+*/
+#include <mbed.h>
+#include "host_sim.h"
+
+
+#define TIMEOUT_SAMPLES 100
+
+
+static int g_failures;
+
+
+static void result(const char* pTest, bool pass, const char* pFormat = "", ...)
+{
+    va_list args;
+
+    printf("RESULT test=%s pass=%d", pTest, pass ? 1 : 0);
+    va_start(args, pFormat);
+    vprintf(pFormat, args);
+    va_end(args);
+    printf("\n");
+
+    if (!pass)
+    {
+        g_failures++;
+    }
+}
+
+// Waits up to timeoutMs for a flag set from an interrupt handler.
+static bool waitFor(volatile bool* pFlag, int timeoutMs)
+{
+    Timer timer;
+
+    timer.start();
+    while (!*pFlag && timer.read_ms() < timeoutMs)
+    {
+    }
+    return *pFlag;
+}
+
+
+static volatile int g_tickCount;
+
+static void tick()
+{
+    g_tickCount++;
+}
+
+static void testTicker()
+{
+    Ticker ticker;
+
+    ticker.attach_us(tick, 1000);
+    wait_ms(100);
+    ticker.detach();
+
+    int ticks = g_tickCount;
+    result("ticker", ticks >= 50 && ticks <= 101, " ticks=%d", ticks);
+}
+
+
+static volatile bool     g_timedOut;
+static volatile uint32_t g_timedOutAt;
+
+static void timedOut()
+{
+    g_timedOutAt = us_ticker_read();
+    g_timedOut = true;
+}
+
+static void testTimeout()
+{
+    uint32_t minLate = 0xFFFFFFFF;
+    uint32_t maxLate = 0;
+    uint32_t totalLate = 0;
+    bool     pass = true;
+
+    for (int i = 0 ; i < TIMEOUT_SAMPLES && pass ; i++)
+    {
+        Timeout  timeout;
+        uint32_t due;
+
+        g_timedOut = false;
+        due = us_ticker_read() + 500;
+        timeout.attach_us(timedOut, 500);
+        pass = waitFor(&g_timedOut, 100);
+
+        uint32_t late = g_timedOutAt - due;
+        if (late < minLate)
+        {
+            minLate = late;
+        }
+        if (late > maxLate)
+        {
+            maxLate = late;
+        }
+        totalLate += late;
+    }
+
+    result("timeout", pass, " samples=%u min_late_us=%lu avg_late_us=%lu max_late_us=%lu",
+           TIMEOUT_SAMPLES, (unsigned long)minLate, (unsigned long)(totalLate / TIMEOUT_SAMPLES),
+           (unsigned long)maxLate);
+}
+
+
+static void testSleep()
+{
+    Timeout timeout;
+    Timer   timer;
+
+    g_timedOut = false;
+    timer.start();
+    timeout.attach_us(timedOut, 2000);
+    while (!g_timedOut)
+    {
+        sleep();
+    }
+    int elapsed = timer.read_us();
+
+    result("sleep", elapsed >= 2000, " elapsed_us=%d", elapsed);
+}
+
+
+static volatile bool g_rose;
+static volatile bool g_fell;
+
+static void rose()
+{
+    g_rose = true;
+}
+
+static void fell()
+{
+    g_fell = true;
+}
+
+static void testInterruptIn()
+{
+    InterruptIn button(SW1);
+
+    host_sim_gpio_set(SW1, 0);
+    button.rise(rose);
+    button.fall(fell);
+
+    host_sim_gpio_set(SW1, 1);
+    bool rise = waitFor(&g_rose, 100);
+    host_sim_gpio_set(SW1, 0);
+    bool fall = waitFor(&g_fell, 100);
+
+    result("interruptin", rise && fall && button.read() == 0, " rise=%d fall=%d", rise, fall);
+}
+
+
+static volatile int g_received;
+static char         g_receiveBuffer[16];
+static RawSerial*   g_pSerial;
+
+static void received()
+{
+    while (g_pSerial->readable())
+    {
+        int c = g_pSerial->getc();
+        if (g_received < (int)sizeof(g_receiveBuffer))
+        {
+            g_receiveBuffer[g_received] = c;
+        }
+        g_received++;
+    }
+}
+
+static void testSerial()
+{
+    static const char message[] = "host sim serial";
+    RawSerial         uart(UART1_TX, UART1_RX);
+
+    g_pSerial = &uart;
+    uart.attach(received, Serial::RxIrq);
+    for (size_t i = 0 ; i < sizeof(message) ; i++)
+    {
+        uart.putc(message[i]);
+    }
+
+    Timer timer;
+    timer.start();
+    while (g_received < (int)sizeof(message) && timer.read_ms() < 100)
+    {
+    }
+    uart.attach(NULL, Serial::RxIrq);
+
+    result("serial", g_received == sizeof(message) && memcmp(g_receiveBuffer, message, sizeof(message)) == 0,
+           " received=%d", g_received);
+}
+
+
+// Serial's printf() goes through the C library's FILE, which the host opens
+// for it from the fopen() wrapper in TARGET_HOST_SIM.
+static void testStream()
+{
+    Serial uart(UART2_TX, UART2_RX);
+    char   line[16];
+
+    uart.printf("%d\n", 1234);
+    for (size_t i = 0 ; i < sizeof(line) ; i++)
+    {
+        line[i] = uart.getc();
+        if (line[i] == '\n')
+        {
+            line[i] = '\0';
+            break;
+        }
+    }
+
+    result("stream", strcmp(line, "1234") == 0, "");
+}
+
+
+static void testSpi()
+{
+    static const char tx[] = "loopback";
+    char              rx[sizeof(tx) + 4];
+    SPI               spi(SPI_MOSI, SPI_MISO, SPI_SCK);
+
+    int single = spi.write(0x5A);
+    int count = spi.write(tx, sizeof(tx), rx, sizeof(rx), 0x7E);
+
+    result("spi", single == 0x5A && count == sizeof(rx) && memcmp(rx, tx, sizeof(tx)) == 0 && rx[sizeof(rx) - 1] == 0x7E,
+           " transferred=%d", count);
+}
+
+
+static void testI2c()
+{
+    static const char write[] = { 0x10, 'e', 'e', 'p' };
+    static const char address[] = { 0x10 };
+    char              read[3];
+    I2C               i2c(I2C_SDA, I2C_SCL);
+
+    bool written = i2c.write(0xA0, write, sizeof(write)) == 0;
+    bool pointed = i2c.write(0xA0, address, sizeof(address), true) == 0;
+    bool readBack = i2c.read(0xA0, read, sizeof(read)) == 0 && memcmp(read, "eep", 3) == 0;
+    bool naked = i2c.write(0x20, write, sizeof(write)) != 0;
+
+    result("i2c", written && pointed && readBack && naked, "");
+}
+
+
+static void testFlash()
+{
+    FlashIAP flash;
+    uint8_t  page[256];
+    uint8_t  readBack[sizeof(page)];
+
+    bool     inited = flash.init() == 0;
+    uint32_t start = flash.get_flash_start();
+    uint32_t pageSize = flash.get_page_size();
+    bool     pass = inited && pageSize <= sizeof(page);
+
+    if (pass)
+    {
+        memset(page, 0xA5, pageSize);
+        pass = flash.erase(start, flash.get_sector_size(start)) == 0 &&
+               flash.program(page, start, pageSize) == 0 &&
+               flash.read(readBack, start, pageSize) == 0 &&
+               memcmp(page, readBack, pageSize) == 0;
+
+        // Bytes can't be programmed again before an erase, even to clear bits
+        memset(page, 0x00, pageSize);
+        pass = pass && flash.program(page, start, pageSize) != 0;
+    }
+    flash.deinit();
+
+    result("flash", pass, " start=0x%08lx size=%lu", (unsigned long)start, (unsigned long)flash.get_flash_size());
+}
+
+
+int main()
+{
+    testTicker();
+    testTimeout();
+    testSleep();
+    testInterruptIn();
+    testSerial();
+    testStream();
+    testSpi();
+    testI2c();
+    testFlash();
+
+    printf("HostSim: %d failed\n", g_failures);
+    return g_failures;
+}
@@ -0,0 +1,187 @@
+/* Copyright 2017 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Cycles from pending an interrupt to entering its handler, when the handler
+   is in the vector table itself and when InterruptManager has chained another
+   handler onto the interrupt. The chained handler is timed both in a link
+   allocated by InterruptManager and in one provided by the caller, which
+   dispatch the same way. Once every chained handler has been removed the
+   original handler should be entered directly again, which the last test
+   checks.
+
+   Each test prints a single line of key=value pairs:
+       RESULT test=<name> samples=<count> unit=<cycles|ns> min=<count> avg=<count> max=<count>
+   Cycles are counted by the DWT cycle counter from just before the interrupt
+   is pended in software, so they include the exception entry itself.
+
+   The HOST_SIM build runs with HOST_SIM/IrqBench.elf. Its handlers run on
+   the simulated NVIC's dispatch thread, so it times in nanoseconds of
+   CLOCK_MONOTONIC and the results are dominated by the host's thread wake up
+   rather than by the cost of the chain.
+
+   The exit code is 1 if the vector isn't restored once the chained handlers
+   are removed.
+*/
+#include <mbed.h>
+#include "cmsis.h"
+#include "InterruptManager.h"
+#if defined(TARGET_HOST_SIM)
+#include <sched.h>
+#include <time.h>
+#endif
+
+
+#define SAMPLE_COUNT    1000
+
+#if defined(TARGET_LPC176X)
+#define BENCH_IRQn      I2S_IRQn
+#elif defined(TARGET_K64F)
+#define BENCH_IRQn      SWI_IRQn
+#elif defined(TARGET_HOST_SIM)
+#define BENCH_IRQn      SWI0_IRQn
+#else
+#error "Pick an interrupt which nothing else uses for BENCH_IRQn on this target."
+#endif
+
+
+static volatile uint32_t g_start;
+static volatile uint32_t g_originalEntry;
+static volatile uint32_t g_chainedEntry;
+
+
+#if defined(TARGET_HOST_SIM)
+#define COUNTER_UNIT    "ns"
+
+static void startCycleCounter()
+{
+}
+
+static uint32_t readCycleCounter()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(now.tv_sec * 1000000000ULL + now.tv_nsec);
+}
+
+// The handler runs on the dispatch thread, which may need this one's CPU.
+static void waitForHandler(volatile uint32_t* pEntry)
+{
+    while (*pEntry == 0)
+    {
+        sched_yield();
+    }
+}
+#else
+#define COUNTER_UNIT    "cycles"
+
+static void startCycleCounter()
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static uint32_t readCycleCounter()
+{
+    return DWT->CYCCNT;
+}
+
+// The handler has already run by the time the pend returns.
+static void waitForHandler(volatile uint32_t* pEntry)
+{
+    (void)pEntry;
+}
+#endif
+
+static void originalHandler()
+{
+    g_originalEntry = readCycleCounter();
+}
+
+static void chainedHandler()
+{
+    g_chainedEntry = readCycleCounter();
+}
+
+static void trigger()
+{
+    g_originalEntry = 0;
+    g_chainedEntry = 0;
+    g_start = readCycleCounter();
+    NVIC_SetPendingIRQ(BENCH_IRQn);
+    __DSB();
+    __ISB();
+}
+
+static void bench(const char* pTest, volatile uint32_t* pEntry)
+{
+    uint32_t minCycles = UINT32_MAX;
+    uint32_t maxCycles = 0;
+    uint32_t totalCycles = 0;
+
+    for (int i = 0 ; i < SAMPLE_COUNT ; i++)
+    {
+        trigger();
+        waitForHandler(pEntry);
+        uint32_t cycles = *pEntry - g_start;
+        if (cycles < minCycles)
+        {
+            minCycles = cycles;
+        }
+        if (cycles > maxCycles)
+        {
+            maxCycles = cycles;
+        }
+        totalCycles += cycles;
+    }
+
+    printf("RESULT test=%s samples=%u unit=%s min=%lu avg=%lu max=%lu\n",
+           pTest, SAMPLE_COUNT, COUNTER_UNIT, (unsigned long)minCycles,
+           (unsigned long)(totalCycles / SAMPLE_COUNT), (unsigned long)maxCycles);
+}
+
+
+int main()
+{
+    static CallChainLink chainedLink(chainedHandler);
+    InterruptManager*    pManager = InterruptManager::get();
+    bool                 passed = true;
+
+    printf("IrqBench: IRQ %d, %u samples per test\n", (int)BENCH_IRQn, SAMPLE_COUNT);
+    startCycleCounter();
+    NVIC_SetVector(BENCH_IRQn, (uintptr_t)originalHandler);
+    NVIC_EnableIRQ(BENCH_IRQn);
+
+    bench("direct", &g_originalEntry);
+
+    pFunctionPointer_t pHandler = pManager->add_handler(chainedHandler, BENCH_IRQn);
+    bench("chain_first", &g_originalEntry);
+    bench("chain_allocated_link", &g_chainedEntry);
+    pManager->remove_handler(pHandler, BENCH_IRQn);
+
+    pHandler = pManager->add_handler(&chainedLink, BENCH_IRQn);
+    bench("chain_caller_link", &g_chainedEntry);
+    pManager->remove_handler(pHandler, BENCH_IRQn);
+
+    if (NVIC_GetVector(BENCH_IRQn) != (uintptr_t)originalHandler)
+    {
+        printf("IrqBench: vector wasn't restored after the last chained handler was removed\n");
+        passed = false;
+    }
+    bench("direct_restored", &g_originalEntry);
+
+    NVIC_DisableIRQ(BENCH_IRQn);
+    printf("IrqBench complete\n");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,494 @@
+/* Copyright 2017 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Small record benchmark of KVStore against FATFileSystem.
+   Both stores run on the same HeapBlockDevice, wrapped to count the requests
+   which reach the device. The FAT version keeps every key in a file of its
+   own, rewritten and closed on each update, which is what an application has
+   to do today to get the same durability as KVStore::set() followed by sync().
+
+   Built by gcc4mbed for the devices listed in Makefile. The HOST_SIM build
+   runs with HOST_SIM/KVBench.elf.
+
+   Each benchmark prints a single line of key=value pairs:
+       RESULT store=<kvstore|fat> test=<name> ops=<count> us=<elapsed> ops_per_sec=<rate>
+              reads=<count> read_bytes=<bytes> programs=<count> program_bytes=<bytes> erases=<count>
+   The device counts are what matter on real flash or an SD card, where each
+   request costs far more than it does on the heap.
+
+   Before the benchmarks, KVStore is checked against power failures on a RAM
+   flash simulator. Its updates are cut short at every POWER_CUT_STRIDE'th
+   program or erase, and then the store is mounted again and each key checked
+   for its last synced value. It prints:
+       RESULT store=kvstore test=power_cut pass=<0|1> cuts=<count>
+   and the exit code is 1 if it fails.
+*/
+#include <errno.h>
+#include <mbed.h>
+#include "HeapBlockDevice.h"
+#include "FATFileSystem.h"
+#include "KVStore.h"
+
+
+#define DEVICE_SIZE     (128 * 1024)
+#define BLOCK_SIZE      512
+#define KEY_COUNT       32
+#define VALUE_SIZE      16
+#define UPDATE_COUNT    1000
+#define GET_COUNT       1000
+
+#define SIM_SIZE            (32 * 1024)
+#define SIM_PROGRAM_SIZE    16
+#define SIM_ERASE_SIZE      4096
+#define POWER_CUT_KEYS      8
+#define POWER_CUT_UPDATES   1200
+#define POWER_CUT_STRIDE    3
+
+
+// Forwards to another block device, counting every request
+class CountingBlockDevice : public BlockDevice
+{
+public:
+    CountingBlockDevice(BlockDevice* pBlockDevice) : m_pBlockDevice(pBlockDevice)
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        reads = readBytes = programs = programBytes = erases = 0;
+    }
+
+    virtual int init()
+    {
+        return m_pBlockDevice->init();
+    }
+    virtual int deinit()
+    {
+        return m_pBlockDevice->deinit();
+    }
+    virtual int read(void* pBuffer, bd_addr_t addr, bd_size_t size)
+    {
+        reads++;
+        readBytes += size;
+        return m_pBlockDevice->read(pBuffer, addr, size);
+    }
+    virtual int program(const void* pBuffer, bd_addr_t addr, bd_size_t size)
+    {
+        programs++;
+        programBytes += size;
+        return m_pBlockDevice->program(pBuffer, addr, size);
+    }
+    virtual int erase(bd_addr_t addr, bd_size_t size)
+    {
+        erases++;
+        return m_pBlockDevice->erase(addr, size);
+    }
+    virtual bd_size_t get_read_size() const
+    {
+        return m_pBlockDevice->get_read_size();
+    }
+    virtual bd_size_t get_program_size() const
+    {
+        return m_pBlockDevice->get_program_size();
+    }
+    virtual bd_size_t get_erase_size() const
+    {
+        return m_pBlockDevice->get_erase_size();
+    }
+    virtual bd_size_t size() const
+    {
+        return m_pBlockDevice->size();
+    }
+
+    uint32_t reads;
+    uint32_t readBytes;
+    uint32_t programs;
+    uint32_t programBytes;
+    uint32_t erases;
+
+protected:
+    BlockDevice* m_pBlockDevice;
+};
+
+
+// RAM flash which can lose power part way through a program or erase.
+// Erases set bytes to 0xFF and each byte can only be programmed once between
+// erases. After cutAfter(count), the count'th program or erase only does half
+// of its work and every later request fails until restore().
+class PowerCutBlockDevice : public BlockDevice
+{
+public:
+    PowerCutBlockDevice()
+    {
+        restore();
+        memset(m_data, 0xFF, sizeof(m_data));
+        memset(m_programmed, 0, sizeof(m_programmed));
+    }
+
+    void cutAfter(uint32_t count)
+    {
+        m_writesLeft = count;
+    }
+
+    void restore()
+    {
+        m_writesLeft = 0;
+        m_powered = true;
+    }
+
+    bool isPowered() const
+    {
+        return m_powered;
+    }
+
+    virtual int init()
+    {
+        return m_powered ? BD_ERROR_OK : BD_ERROR_DEVICE_ERROR;
+    }
+    virtual int deinit()
+    {
+        return BD_ERROR_OK;
+    }
+    virtual int read(void* pBuffer, bd_addr_t addr, bd_size_t size)
+    {
+        if (!m_powered)
+            return BD_ERROR_DEVICE_ERROR;
+        memcpy(pBuffer, &m_data[addr], size);
+        return BD_ERROR_OK;
+    }
+    virtual int program(const void* pBuffer, bd_addr_t addr, bd_size_t size)
+    {
+        if (!m_powered)
+            return BD_ERROR_DEVICE_ERROR;
+        for (bd_size_t i = 0 ; i < size ; i++)
+        {
+            if (isProgrammed(addr + i))
+            {
+                printf("error: program of %lu, which was programmed since it was erased\n",
+                       (unsigned long)(addr + i));
+                return BD_ERROR_DEVICE_ERROR;
+            }
+        }
+        if (cutPower())
+            size /= 2;
+        for (bd_size_t i = 0 ; i < size ; i++)
+        {
+            m_data[addr + i] = ((const uint8_t*)pBuffer)[i];
+            setProgrammed(addr + i, true);
+        }
+        return m_powered ? BD_ERROR_OK : BD_ERROR_DEVICE_ERROR;
+    }
+    virtual int erase(bd_addr_t addr, bd_size_t size)
+    {
+        if (!m_powered)
+            return BD_ERROR_DEVICE_ERROR;
+        if (cutPower())
+            size /= 2;
+        for (bd_size_t i = 0 ; i < size ; i++)
+        {
+            m_data[addr + i] = 0xFF;
+            setProgrammed(addr + i, false);
+        }
+        return m_powered ? BD_ERROR_OK : BD_ERROR_DEVICE_ERROR;
+    }
+    virtual bd_size_t get_read_size() const
+    {
+        return 1;
+    }
+    virtual bd_size_t get_program_size() const
+    {
+        return SIM_PROGRAM_SIZE;
+    }
+    virtual bd_size_t get_erase_size() const
+    {
+        return SIM_ERASE_SIZE;
+    }
+    virtual bd_size_t size() const
+    {
+        return SIM_SIZE;
+    }
+
+protected:
+    bool cutPower()
+    {
+        if (m_writesLeft == 0 || --m_writesLeft > 0)
+            return false;
+        m_powered = false;
+        return true;
+    }
+
+    bool isProgrammed(bd_addr_t addr) const
+    {
+        return (m_programmed[addr / 8] >> (addr % 8)) & 1;
+    }
+
+    void setProgrammed(bd_addr_t addr, bool programmed)
+    {
+        if (programmed)
+            m_programmed[addr / 8] |= 1 << (addr % 8);
+        else
+            m_programmed[addr / 8] &= ~(1 << (addr % 8));
+    }
+
+    uint8_t  m_data[SIM_SIZE];
+    uint8_t  m_programmed[SIM_SIZE / 8];
+    uint32_t m_writesLeft;
+    bool     m_powered;
+};
+
+
+static Timer g_timer;
+
+
+static void startTest(CountingBlockDevice* pDevice)
+{
+    pDevice->reset();
+    g_timer.reset();
+    g_timer.start();
+}
+
+static void endTest(CountingBlockDevice* pDevice, const char* pStore, const char* pTest, uint32_t ops)
+{
+    g_timer.stop();
+    uint32_t us = g_timer.read_us();
+    printf("RESULT store=%s test=%s ops=%lu us=%lu ops_per_sec=%lu reads=%lu read_bytes=%lu "
+           "programs=%lu program_bytes=%lu erases=%lu\n",
+           pStore, pTest, (unsigned long)ops, (unsigned long)us,
+           us ? (unsigned long)((uint64_t)ops * 1000000 / us) : 0UL,
+           (unsigned long)pDevice->reads, (unsigned long)pDevice->readBytes,
+           (unsigned long)pDevice->programs, (unsigned long)pDevice->programBytes,
+           (unsigned long)pDevice->erases);
+}
+
+static void checkResult(int result, const char* pOperation)
+{
+    if (result < 0)
+    {
+        printf("error: %s failed with %d\n", pOperation, result);
+        exit(1);
+    }
+}
+
+static void fillValue(uint8_t* pValue, uint32_t seed)
+{
+    for (size_t i = 0 ; i < VALUE_SIZE ; i++)
+    {
+        pValue[i] = (uint8_t)(seed + i);
+    }
+}
+
+
+// Runs updates until the power is cut, then checks that the store mounts
+// with the last synced value of each key, or the value being set at the cut.
+// Returns false once the updates finish before the cut.
+static bool checkPowerCut(PowerCutBlockDevice* pDevice, uint32_t cut, bool* pPassed)
+{
+    int32_t synced[POWER_CUT_KEYS];
+    int32_t pending = -1;
+    uint8_t value[VALUE_SIZE];
+    uint8_t expected[VALUE_SIZE];
+    char    key[16];
+
+    memset(synced, 0xFF, sizeof(synced));
+    pDevice->restore();
+    checkResult(KVStore::format(pDevice), "KVStore::format");
+    {
+        KVStore kv;
+        checkResult(kv.mount(pDevice), "KVStore::mount");
+
+        pDevice->cutAfter(cut);
+        for (int32_t i = 0 ; i < POWER_CUT_UPDATES ; i++)
+        {
+            snprintf(key, sizeof(key), "k%lu", (unsigned long)(i % POWER_CUT_KEYS));
+            fillValue(value, i);
+            pending = i;
+            if (kv.set(key, value, sizeof(value)) || kv.sync())
+                break;
+            synced[i % POWER_CUT_KEYS] = i;
+            pending = -1;
+        }
+        if (pDevice->isPowered())
+            return false;
+    }
+
+    pDevice->restore();
+    KVStore kv;
+    int result = kv.mount(pDevice);
+    if (result)
+    {
+        printf("error: cut %lu: KVStore::mount failed with %d\n", (unsigned long)cut, result);
+        *pPassed = false;
+        return true;
+    }
+    for (uint32_t k = 0 ; k < POWER_CUT_KEYS ; k++)
+    {
+        snprintf(key, sizeof(key), "k%lu", (unsigned long)k);
+        result = kv.get(key, value, sizeof(value));
+        bool matches = false;
+        if (result == VALUE_SIZE && synced[k] >= 0)
+        {
+            fillValue(expected, synced[k]);
+            matches = memcmp(value, expected, sizeof(value)) == 0;
+        }
+        if (result == VALUE_SIZE && !matches && pending >= 0 && pending % POWER_CUT_KEYS == (int32_t)k)
+        {
+            fillValue(expected, pending);
+            matches = memcmp(value, expected, sizeof(value)) == 0;
+        }
+        if (result == -ENOENT && synced[k] < 0)
+        {
+            matches = true;
+        }
+        if (!matches)
+        {
+            printf("error: cut %lu: %s read %d with a wrong value\n", (unsigned long)cut, key, result);
+            *pPassed = false;
+        }
+    }
+
+    // The recovered store must take updates again
+    fillValue(value, cut);
+    result = kv.set("k0", value, sizeof(value));
+    if (!result)
+        result = kv.sync();
+    if (!result)
+        result = kv.get("k0", expected, sizeof(expected)) == VALUE_SIZE ? 0 : -1;
+    if (result || memcmp(value, expected, sizeof(value)) != 0)
+    {
+        printf("error: cut %lu: KVStore::set after recovery failed with %d\n", (unsigned long)cut, result);
+        *pPassed = false;
+    }
+    return true;
+}
+
+static bool checkPowerCuts()
+{
+    PowerCutBlockDevice* pDevice = new PowerCutBlockDevice;
+    bool                 passed = true;
+    uint32_t             cuts = 0;
+
+    for (uint32_t cut = 1 ; checkPowerCut(pDevice, cut, &passed) ; cut += POWER_CUT_STRIDE)
+    {
+        cuts++;
+    }
+    delete pDevice;
+
+    printf("RESULT store=kvstore test=power_cut pass=%d cuts=%lu\n", passed, (unsigned long)cuts);
+    return passed;
+}
+
+
+static void benchKVStore(CountingBlockDevice* pDevice)
+{
+    KVStore kv;
+    uint8_t value[VALUE_SIZE];
+    char    key[16];
+
+    checkResult(KVStore::format(pDevice), "KVStore::format");
+    checkResult(kv.mount(pDevice), "KVStore::mount");
+
+    startTest(pDevice);
+    for (uint32_t i = 0 ; i < UPDATE_COUNT ; i++)
+    {
+        snprintf(key, sizeof(key), "k%02lu", (unsigned long)(i % KEY_COUNT));
+        fillValue(value, i);
+        checkResult(kv.set(key, value, sizeof(value)), "KVStore::set");
+        checkResult(kv.sync(), "KVStore::sync");
+    }
+    endTest(pDevice, "kvstore", "set", UPDATE_COUNT);
+
+    startTest(pDevice);
+    for (uint32_t i = 0 ; i < GET_COUNT ; i++)
+    {
+        snprintf(key, sizeof(key), "k%02lu", (unsigned long)((i * 7) % KEY_COUNT));
+        checkResult(kv.get(key, value, sizeof(value)), "KVStore::get");
+    }
+    endTest(pDevice, "kvstore", "get", GET_COUNT);
+
+    startTest(pDevice);
+    checkResult(kv.unmount(), "KVStore::unmount");
+    checkResult(kv.mount(pDevice), "KVStore::mount");
+    endTest(pDevice, "kvstore", "remount", 1);
+
+    checkResult(kv.unmount(), "KVStore::unmount");
+}
+
+static void benchFAT(CountingBlockDevice* pDevice)
+{
+    FATFileSystem fs("kv");
+    uint8_t       value[VALUE_SIZE];
+    char          path[16];
+
+    checkResult(FATFileSystem::format(pDevice), "FATFileSystem::format");
+    checkResult(fs.mount(pDevice), "FATFileSystem::mount");
+
+    startTest(pDevice);
+    for (uint32_t i = 0 ; i < UPDATE_COUNT ; i++)
+    {
+        File file;
+        snprintf(path, sizeof(path), "k%02lu", (unsigned long)(i % KEY_COUNT));
+        fillValue(value, i);
+        checkResult(file.open(&fs, path, O_WRONLY | O_CREAT | O_TRUNC), "File::open");
+        checkResult(file.write(value, sizeof(value)), "File::write");
+        checkResult(file.close(), "File::close");
+    }
+    endTest(pDevice, "fat", "set", UPDATE_COUNT);
+
+    startTest(pDevice);
+    for (uint32_t i = 0 ; i < GET_COUNT ; i++)
+    {
+        File file;
+        snprintf(path, sizeof(path), "k%02lu", (unsigned long)((i * 7) % KEY_COUNT));
+        checkResult(file.open(&fs, path, O_RDONLY), "File::open");
+        checkResult(file.read(value, sizeof(value)), "File::read");
+        checkResult(file.close(), "File::close");
+    }
+    endTest(pDevice, "fat", "get", GET_COUNT);
+
+    startTest(pDevice);
+    checkResult(fs.unmount(), "FATFileSystem::unmount");
+    checkResult(fs.mount(pDevice), "FATFileSystem::mount");
+    endTest(pDevice, "fat", "remount", 1);
+
+    checkResult(fs.unmount(), "FATFileSystem::unmount");
+}
+
+
+int main()
+{
+    bool passed = checkPowerCuts();
+
+    printf("KVBench: %u keys of %u bytes on a %uKB HeapBlockDevice with %u byte blocks\n",
+           KEY_COUNT, VALUE_SIZE, DEVICE_SIZE / 1024, BLOCK_SIZE);
+
+    // A fresh device for each store so that neither pays for the other's heap use.
+    {
+        HeapBlockDevice     heap(DEVICE_SIZE, BLOCK_SIZE);
+        CountingBlockDevice device(&heap);
+        checkResult(device.init(), "BlockDevice::init");
+        benchKVStore(&device);
+        device.deinit();
+    }
+    {
+        HeapBlockDevice     heap(DEVICE_SIZE, BLOCK_SIZE);
+        CountingBlockDevice device(&heap);
+        checkResult(device.init(), "BlockDevice::init");
+        benchFAT(&device);
+        device.deinit();
+    }
+
+    printf("KVBench complete\n");
+    return passed ? 0 : 1;
+}
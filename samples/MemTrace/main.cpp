@@ -0,0 +1,163 @@
+/* Copyright 2017 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Traces every heap operation into the binary memory trace buffer while a few
+   allocation sites run, one of which leaks, and drains the buffer to stdout
+   between rounds. Capture the serial output to a file and run
+       python memtrace_report.py capture.bin LPC1768/MemTrace.elf
+   to see live bytes, peak, churn and leaks for each site. Building with
+   "make DEFINES=-DMEMTRACE_LOCAL=1" on a target with LocalFileSystem writes
+   the packets to /local/memtrace.bin over semihosting instead.
+
+   The sites call malloc() and friends directly, as the caller traced for a
+   C++ new is operator new itself.
+
+   Tracing has to be compiled into the mbed libraries, by adding
+       #define MBED_MEM_TRACING_ENABLED 1
+   to src/mbed_config.h and rebuilding them.
+*/
+#include <mbed.h>
+#include "mbed_mem_trace.h"
+
+
+#define ROUNDS          8
+#define MESSAGE_COUNT   6
+#define MESSAGE_SIZE    48
+#ifndef MEMTRACE_LOCAL
+#define MEMTRACE_LOCAL  0
+#endif
+
+
+struct Message
+{
+    Message* pNext;
+    char     data[MESSAGE_SIZE];
+};
+
+static Message* g_pLeaked;
+
+
+static void churnMessages()
+{
+    Message* pHead = NULL;
+
+    for (int i = 0 ; i < MESSAGE_COUNT ; i++)
+    {
+        Message* pMessage = (Message*)malloc(sizeof(*pMessage));
+        if (!pMessage)
+        {
+            break;
+        }
+        pMessage->pNext = pHead;
+        pHead = pMessage;
+    }
+    while (pHead)
+    {
+        Message* pNext = pHead->pNext;
+        free(pHead);
+        pHead = pNext;
+    }
+}
+
+static void growBuffer()
+{
+    char*  pBuffer = NULL;
+    size_t size = 16;
+
+    for (int i = 0 ; i < 5 ; i++)
+    {
+        char* pNew = (char*)realloc(pBuffer, size);
+        if (!pNew)
+        {
+            break;
+        }
+        pBuffer = pNew;
+        size *= 2;
+    }
+    free(pBuffer);
+}
+
+static void leakMessage(int round)
+{
+    // Every other round loses the previous message.
+    Message* pMessage = (Message*)calloc(1, sizeof(*pMessage));
+    if (pMessage && (round & 1))
+    {
+        pMessage->pNext = g_pLeaked;
+    }
+    g_pLeaked = pMessage;
+}
+
+static void failAllocation()
+{
+    void* pBig = malloc(0x0FFFFFF0);
+    free(pBig);
+}
+
+static int drain(FILE* pFile)
+{
+    // The packets are binary, so keep buffered text from landing inside them.
+    fflush(stdout);
+    return mbed_mem_trace_binary_drain(pFile);
+}
+
+
+int main()
+{
+    FILE* pFile = stdout;
+
+#if MEMTRACE_LOCAL
+    static LocalFileSystem local("local");
+    pFile = fopen("/local/memtrace.bin", "wb");
+    if (!pFile)
+    {
+        printf("MemTrace: failed to open /local/memtrace.bin\n");
+        return 1;
+    }
+#endif
+
+#ifndef MBED_MEM_TRACING_ENABLED
+    printf("MemTrace: MBED_MEM_TRACING_ENABLED isn't set for the mbed libraries, so nothing will be traced\n");
+#endif
+    printf("MemTrace: %u record trace buffer\n", MBED_CONF_PLATFORM_MEM_TRACE_BUFFER_RECORDS);
+
+    mbed_mem_trace_set_callback(mbed_mem_trace_binary_callback);
+    for (int round = 0 ; round < ROUNDS ; round++)
+    {
+        churnMessages();
+        growBuffer();
+        leakMessage(round);
+        if (round == 0)
+        {
+            failAllocation();
+        }
+
+        int records = drain(pFile);
+        if (records < 0)
+        {
+            mbed_mem_trace_set_callback(NULL);
+            printf("\nMemTrace: drain failed\n");
+            return 1;
+        }
+    }
+    mbed_mem_trace_set_callback(NULL);
+    // Drain anything traced before tracing was turned off.
+    drain(pFile);
+
+#if MEMTRACE_LOCAL
+    fclose(pFile);
+#endif
+    printf("\nMemTrace complete\n");
+    return 0;
+}
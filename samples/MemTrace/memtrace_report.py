@@ -0,0 +1,211 @@
+#!/usr/bin/env python
+# Copyright 2017 Adam Green (http://mbed.org/users/AdamGreen/)
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Allocation site report for mbed_mem_trace_binary_drain() output.
+
+Finds the trace packets in a capture, which may be a serial log with text
+around them or a file written over semihosting, replays the heap operations
+and prints one line per allocation site, busiest first:
+
+    SITE addr=<caller> allocs=<n> frees=<n> failed=<n> live_bytes=<n> peak_bytes=<n>
+         churn_bytes=<n> leaks=<n> func=<name> at=<file:line>
+
+leaks counts blocks from the site still allocated at the end of the capture.
+A block is charged to the site which allocated it, whoever frees it. Callers
+are looked up in the .elf with addr2line when one is given.
+
+    python memtrace_report.py <capture> [elf] [--addr2line PATH] [--top N]
+"""
+import argparse
+import struct
+import subprocess
+import sys
+
+PACKET_MAGIC = 0x3152544D
+PACKET_HEADER = struct.Struct('<IHHI')
+RECORD = struct.Struct('<IIII')
+
+# mbed_mem_trace.h operation IDs
+OP_MALLOC = 0
+OP_REALLOC = 1
+OP_CALLOC = 2
+OP_FREE = 3
+
+
+def read_packets(data):
+    """Returns a list of (dropped, records) for each packet with a good
+    checksum, and the number which were cut short or damaged."""
+    packets = []
+    magic = struct.pack('<I', PACKET_MAGIC)
+    bad = 0
+    offset = data.find(magic)
+    while offset >= 0:
+        end = offset + PACKET_HEADER.size
+        if end > len(data):
+            bad += 1
+            break
+        _, count, dropped, checksum = PACKET_HEADER.unpack_from(data, offset)
+        records_end = end + count * RECORD.size
+        if records_end > len(data):
+            bad += 1
+            break
+        records = [RECORD.unpack_from(data, end + i * RECORD.size) for i in range(count)]
+        total = PACKET_MAGIC + count + (dropped << 16)
+        for record in records:
+            total += sum(record)
+        if total & 0xFFFFFFFF == checksum:
+            packets.append((dropped, records))
+            offset = data.find(magic, records_end)
+        else:
+            # The magic may have turned up in text or in another packet.
+            bad += 1
+            offset = data.find(magic, offset + 1)
+    return packets, bad
+
+
+class Site(object):
+    def __init__(self, caller):
+        self.caller = caller
+        self.allocs = 0
+        self.frees = 0
+        self.failed = 0
+        self.live = 0
+        self.peak = 0
+        self.churn = 0
+        self.leaks = 0
+        self.func = '??'
+        self.where = '??'
+
+
+class Replay(object):
+    def __init__(self):
+        self.sites = {}
+        self.blocks = {}
+        self.live = 0
+        self.peak = 0
+        self.records = 0
+        self.dropped = 0
+        self.unknown_frees = 0
+        self.first = None
+        self.last = None
+
+    def site(self, caller):
+        site = self.sites.get(caller)
+        if site is None:
+            site = self.sites[caller] = Site(caller)
+        return site
+
+    def add(self, timestamp, caller, ptr, size_op):
+        op = size_op >> 28
+        size = size_op & 0x0FFFFFFF
+        self.records += 1
+        if self.first is None:
+            self.first = timestamp
+        self.last = timestamp
+
+        if op == OP_FREE:
+            block = self.blocks.pop(ptr, None)
+            if block is None:
+                # Allocated before the capture started or lost to a drop.
+                self.unknown_frees += 1
+                return
+            owner, size = block
+            owner.frees += 1
+            owner.live -= size
+            self.live -= size
+            return
+
+        site = self.site(caller)
+        if ptr == 0:
+            site.failed += 1
+            return
+        if ptr in self.blocks:
+            # Its free was dropped, so retire it before reusing the address.
+            owner, old_size = self.blocks.pop(ptr)
+            owner.live -= old_size
+            self.live -= old_size
+        self.blocks[ptr] = (site, size)
+        site.allocs += 1
+        site.churn += size
+        site.live += size
+        site.peak = max(site.peak, site.live)
+        self.live += size
+        self.peak = max(self.peak, self.live)
+
+    def finish(self):
+        for owner, _ in self.blocks.values():
+            owner.leaks += 1
+
+
+def symbolize(sites, elf, addr2line):
+    if not sites:
+        return
+    # Callers are return addresses, so look up the call instruction before
+    # them, dropping the Thumb bit.
+    addresses = ['0x%x' % max((site.caller & ~1) - 1, 0) for site in sites]
+    try:
+        output = subprocess.check_output([addr2line, '-f', '-C', '-e', elf] + addresses)
+    except (OSError, subprocess.CalledProcessError) as e:
+        sys.stderr.write('memtrace_report: addr2line failed: %s\n' % e)
+        return
+    lines = output.decode('ascii', 'replace').splitlines()
+    for i, site in enumerate(sites):
+        if 2 * i + 1 < len(lines):
+            site.func = lines[2 * i] or '??'
+            site.where = lines[2 * i + 1].split(' ')[0] or '??'
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Per allocation site report for a binary memory trace.')
+    parser.add_argument('capture', help='serial capture or semihosted file holding the trace packets')
+    parser.add_argument('elf', nargs='?', help='image the trace came from, used to name the callers')
+    parser.add_argument('--addr2line', default='arm-none-eabi-addr2line', help='addr2line to run on the elf')
+    parser.add_argument('--top', type=int, default=0, help='only report the N sites with the most churn')
+    args = parser.parse_args()
+
+    with open(args.capture, 'rb') as f:
+        data = f.read()
+
+    packets, bad = read_packets(data)
+    replay = Replay()
+    for dropped, records in packets:
+        # Drops are reported after the records which made it into the buffer.
+        for record in records:
+            replay.add(*record)
+        replay.dropped += dropped
+    replay.finish()
+
+    sites = sorted(replay.sites.values(), key=lambda site: (site.churn, site.allocs), reverse=True)
+    if args.top > 0:
+        sites = sites[:args.top]
+    if args.elf:
+        symbolize(sites, args.elf, args.addr2line)
+
+    elapsed = (replay.last - replay.first) & 0xFFFFFFFF if replay.records else 0
+    print('TRACE packets=%d bad_packets=%d records=%d dropped=%d unknown_frees=%d us=%d'
+          % (len(packets), bad, replay.records, replay.dropped, replay.unknown_frees, elapsed))
+    print('HEAP live_bytes=%d peak_bytes=%d live_blocks=%d'
+          % (replay.live, replay.peak, len(replay.blocks)))
+    for site in sites:
+        print('SITE addr=0x%08x allocs=%d frees=%d failed=%d live_bytes=%d peak_bytes=%d churn_bytes=%d leaks=%d func=%s at=%s'
+              % (site.caller, site.allocs, site.frees, site.failed, site.live, site.peak,
+                 site.churn, site.leaks, site.func, site.where))
+    if replay.dropped:
+        sys.stderr.write('memtrace_report: %d records were dropped, so live bytes and leaks are estimates; '
+                         'drain more often or raise platform.mem-trace-buffer-records\n' % replay.dropped)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
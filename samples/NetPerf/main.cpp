@@ -0,0 +1,316 @@
+/* Copyright 2017 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* iperf style benchmark for the lwIP network stack.  The device listens on a
+   TCP control port and runs whichever test netperf_host.py asks for:
+     TCPTX <bytes>          - Device sends <bytes> of data to the host.
+     TCPRX <bytes>          - Host sends <bytes> of data to the device.
+     RTT <count> <size>     - <count> request/response exchanges of <size> bytes.
+     UDPTX <port> <count> <size> - Device blasts <count> UDP packets at host:<port>.
+     UDPRX <count> <size>   - Host blasts <count> UDP packets at device:NETPERF_PORT.
+   Each test finishes with a single "RESULT ..." line of key=value pairs sent
+   back over the control connection and echoed to stdout.  RTT and UDPRX first
+   answer with a "RESULT ... ready=1" line, or a "RESULT error=..." one if the
+   request can't be run, and the host only starts sending once it has seen it.
+   That keeps the control stream in step when a request is refused.
+*/
+#include <stdarg.h>
+#include <mbed.h>
+#include <EthernetInterface.h>
+#include "lwip/opt.h"
+
+
+#define NETPERF_PORT 5001
+
+// How long UDPRX waits for the next packet before deciding the host is done.
+#define UDP_RX_IDLE_MS 1000
+
+static char g_buffer[1460];
+
+static const char* profileName()
+{
+#if MBED_CONF_LWIP_MEMORY_PROFILE == LWIP_MEMORY_PROFILE_THROUGHPUT
+    return "throughput";
+#elif MBED_CONF_LWIP_MEMORY_PROFILE == LWIP_MEMORY_PROFILE_BALANCED
+    return "balanced";
+#else
+    return "small";
+#endif
+}
+
+static int readLine(TCPSocket* pSocket, char* pLine, size_t lineSize)
+{
+    size_t length = 0;
+
+    while (length < lineSize - 1)
+    {
+        char ch;
+        int result = pSocket->recv(&ch, 1);
+        if (result <= 0)
+            return -1;
+        if (ch == '\n')
+            break;
+        if (ch != '\r')
+            pLine[length++] = ch;
+    }
+    pLine[length] = '\0';
+    return length;
+}
+
+static void sendResult(TCPSocket* pSocket, const char* pFormat, ...)
+{
+    char    result[160];
+    va_list args;
+
+    va_start(args, pFormat);
+    int length = vsnprintf(result, sizeof(result) - 1, pFormat, args);
+    va_end(args);
+    if (length < 0 || length > (int)sizeof(result) - 2)
+        length = sizeof(result) - 2;
+    result[length++] = '\n';
+    result[length] = '\0';
+
+    printf("%s", result);
+    pSocket->send(result, length);
+}
+
+static void tcpTransmit(TCPSocket* pSocket, unsigned int totalBytes)
+{
+    Timer        timer;
+    unsigned int bytesSent = 0;
+
+    memset(g_buffer, 0x55, sizeof(g_buffer));
+    timer.start();
+    while (bytesSent < totalBytes)
+    {
+        unsigned int chunk = totalBytes - bytesSent;
+        if (chunk > sizeof(g_buffer))
+            chunk = sizeof(g_buffer);
+        int result = pSocket->send(g_buffer, chunk);
+        if (result <= 0)
+            break;
+        bytesSent += result;
+    }
+    unsigned int elapsedUs = timer.read_us();
+
+    sendResult(pSocket, "RESULT test=tcptx bytes=%u us=%u kbps=%u",
+               bytesSent, elapsedUs, elapsedUs ? (unsigned int)((uint64_t)bytesSent * 8000 / elapsedUs) : 0);
+}
+
+static void tcpReceive(TCPSocket* pSocket, unsigned int totalBytes)
+{
+    Timer        timer;
+    unsigned int bytesReceived = 0;
+
+    while (bytesReceived < totalBytes)
+    {
+        int result = pSocket->recv(g_buffer, sizeof(g_buffer));
+        if (result <= 0)
+            break;
+        if (bytesReceived == 0)
+            timer.start();
+        bytesReceived += result;
+    }
+    unsigned int elapsedUs = timer.read_us();
+
+    sendResult(pSocket, "RESULT test=tcprx bytes=%u us=%u kbps=%u",
+               bytesReceived, elapsedUs, elapsedUs ? (unsigned int)((uint64_t)bytesReceived * 8000 / elapsedUs) : 0);
+}
+
+static void roundTrip(TCPSocket* pSocket, unsigned int count, unsigned int size)
+{
+    Timer        timer;
+    unsigned int completed = 0;
+    unsigned int minUs = 0xFFFFFFFF;
+    unsigned int maxUs = 0;
+
+    if (size == 0 || size > sizeof(g_buffer))
+    {
+        sendResult(pSocket, "RESULT test=rtt error=size max_size=%u", (unsigned int)sizeof(g_buffer));
+        return;
+    }
+    sendResult(pSocket, "RESULT test=rtt ready=1 size=%u", size);
+
+    timer.start();
+    unsigned int startUs = timer.read_us();
+    for (completed = 0 ; completed < count ; completed++)
+    {
+        unsigned int requestUs = timer.read_us();
+        unsigned int received = 0;
+        while (received < size)
+        {
+            int result = pSocket->recv(g_buffer + received, size - received);
+            if (result <= 0)
+                goto done;
+            received += result;
+        }
+        if (pSocket->send(g_buffer, size) != (int)size)
+            goto done;
+
+        // Time from start of one request to the start of the next includes the host's turn around.
+        unsigned int elapsedUs = timer.read_us() - requestUs;
+        if (elapsedUs < minUs)
+            minUs = elapsedUs;
+        if (elapsedUs > maxUs)
+            maxUs = elapsedUs;
+    }
+done:
+    unsigned int totalUs = timer.read_us() - startUs;
+
+    sendResult(pSocket, "RESULT test=rtt count=%u size=%u us=%u avg_us=%u min_us=%u max_us=%u",
+               completed, size, totalUs, completed ? totalUs / completed : 0,
+               completed ? minUs : 0, maxUs);
+}
+
+static void udpTransmit(NetworkInterface* pInterface, TCPSocket* pSocket, const SocketAddress& peer,
+                        unsigned int port, unsigned int count, unsigned int size)
+{
+    UDPSocket    udp;
+    Timer        timer;
+    unsigned int sent = 0;
+    unsigned int failed = 0;
+    SocketAddress target(peer.get_ip_address(), port);
+
+    if (size < sizeof(unsigned int) || size > sizeof(g_buffer))
+    {
+        sendResult(pSocket, "RESULT test=udptx error=size max_size=%u", (unsigned int)sizeof(g_buffer));
+        return;
+    }
+    memset(g_buffer, 0xAA, sizeof(g_buffer));
+
+    udp.open(pInterface);
+    timer.start();
+    for (unsigned int i = 0 ; i < count ; i++)
+    {
+        // Sequence number lets the host count loss and reordering.
+        memcpy(g_buffer, &i, sizeof(i));
+        if (udp.sendto(target, g_buffer, size) == (int)size)
+            sent++;
+        else
+            failed++;
+    }
+    unsigned int elapsedUs = timer.read_us();
+    udp.close();
+
+    sendResult(pSocket, "RESULT test=udptx sent=%u failed=%u size=%u us=%u pps=%u",
+               sent, failed, size, elapsedUs, elapsedUs ? (unsigned int)((uint64_t)sent * 1000000 / elapsedUs) : 0);
+}
+
+static void udpReceive(NetworkInterface* pInterface, TCPSocket* pSocket, unsigned int count, unsigned int size)
+{
+    UDPSocket    udp;
+    Timer        timer;
+    unsigned int received = 0;
+    unsigned int bytes = 0;
+    unsigned int reordered = 0;
+    unsigned int lastSequence = 0;
+    unsigned int lastUs = 0;
+
+    if (size < sizeof(unsigned int) || size > sizeof(g_buffer))
+    {
+        sendResult(pSocket, "RESULT test=udprx error=size max_size=%u", (unsigned int)sizeof(g_buffer));
+        return;
+    }
+    if (udp.open(pInterface) != 0 || udp.bind(NETPERF_PORT) != 0)
+    {
+        udp.close();
+        sendResult(pSocket, "RESULT test=udprx error=bind");
+        return;
+    }
+    udp.set_timeout(UDP_RX_IDLE_MS);
+    sendResult(pSocket, "RESULT test=udprx ready=1 port=%d", NETPERF_PORT);
+
+    // Packets the stack had to drop for want of pbufs never show up here, which
+    // is what makes this test sensitive to PBUF_POOL_SIZE.
+    while (received < count)
+    {
+        int result = udp.recvfrom(NULL, g_buffer, sizeof(g_buffer));
+        if (result < (int)sizeof(unsigned int))
+            break;
+        if (received == 0)
+            timer.start();
+        lastUs = timer.read_us();
+
+        unsigned int sequence;
+        memcpy(&sequence, g_buffer, sizeof(sequence));
+        if (received > 0 && sequence < lastSequence)
+            reordered++;
+        lastSequence = sequence;
+        received++;
+        bytes += result;
+    }
+    udp.close();
+
+    // Rate is measured from the first to the last packet so the idle timeout isn't counted.
+    sendResult(pSocket, "RESULT test=udprx received=%u lost=%u reordered=%u bytes=%u us=%u pps=%u",
+               received, count - received, reordered, bytes, lastUs,
+               lastUs ? (unsigned int)((uint64_t)(received - 1) * 1000000 / lastUs) : 0);
+}
+
+
+int main()
+{
+    EthernetInterface eth;
+    TCPServer         server;
+    char              command[64];
+
+    printf("NetPerf: lwIP memory profile=%s PBUF_POOL_SIZE=%d MEMP_NUM_PBUF=%d TCP_MSS=%d TCP_WND=%d TCP_SND_BUF=%d\n",
+           profileName(), PBUF_POOL_SIZE, MEMP_NUM_PBUF, TCP_MSS, TCP_WND, TCP_SND_BUF);
+
+    eth.set_dhcp(true);
+    if (eth.connect() != 0)
+    {
+        printf("error: Failed to bring up Ethernet interface.\n");
+        return -1;
+    }
+    printf("NetPerf: listening on %s:%d\n", eth.get_ip_address(), NETPERF_PORT);
+
+    server.open(&eth);
+    server.bind(NETPERF_PORT);
+    server.listen(1);
+
+    for (;;)
+    {
+        TCPSocket     client;
+        SocketAddress peer;
+
+        if (server.accept(&client, &peer) != 0)
+            continue;
+        printf("NetPerf: connection from %s\n", peer.get_ip_address());
+
+        while (readLine(&client, command, sizeof(command)) >= 0)
+        {
+            unsigned int arg1 = 0;
+            unsigned int arg2 = 0;
+            unsigned int arg3 = 0;
+
+            if (sscanf(command, "TCPTX %u", &arg1) == 1)
+                tcpTransmit(&client, arg1);
+            else if (sscanf(command, "TCPRX %u", &arg1) == 1)
+                tcpReceive(&client, arg1);
+            else if (sscanf(command, "RTT %u %u", &arg1, &arg2) == 2)
+                roundTrip(&client, arg1, arg2);
+            else if (sscanf(command, "UDPTX %u %u %u", &arg1, &arg2, &arg3) == 3)
+                udpTransmit(&eth, &client, peer, arg1, arg2, arg3);
+            else if (sscanf(command, "UDPRX %u %u", &arg1, &arg2) == 2)
+                udpReceive(&eth, &client, arg1, arg2);
+            else if (strcmp(command, "PROFILE") == 0)
+                sendResult(&client, "RESULT test=profile name=%s pbuf_pool=%d memp_pbuf=%d mss=%d wnd=%d snd_buf=%d",
+                           profileName(), PBUF_POOL_SIZE, MEMP_NUM_PBUF, TCP_MSS, TCP_WND, TCP_SND_BUF);
+            else
+                sendResult(&client, "RESULT error=unknown_command");
+        }
+        client.close();
+    }
+}
@@ -0,0 +1,206 @@
+#!/usr/bin/env python
+# Copyright 2017 Adam Green (http://mbed.org/users/AdamGreen/)
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Host side of the NetPerf sample.
+
+Connects to the NetPerf control port on the device, runs each benchmark and
+prints one line per test with both the device's and the host's view of it.
+
+    python netperf_host.py <device-ip> [--bytes N] [--rtt-count N] [--rtt-size N]
+                                       [--udp-count N] [--udp-size N] [--udp-gap-us N]
+"""
+import argparse
+import socket
+import struct
+import sys
+import threading
+import time
+
+NETPERF_PORT = 5001
+
+
+def parse_result(line):
+    fields = {}
+    for item in line.split()[1:]:
+        key, _, value = item.partition('=')
+        fields[key] = value
+    return fields
+
+
+class Control(object):
+    def __init__(self, address):
+        self.sock = socket.create_connection((address, NETPERF_PORT), timeout=30)
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.pending = b''
+
+    def command(self, text):
+        self.sock.sendall((text + '\n').encode('ascii'))
+
+    def read_result(self):
+        while b'\n' not in self.pending:
+            data = self.sock.recv(4096)
+            if not data:
+                raise IOError('device closed control connection')
+            self.pending += data
+        line, _, self.pending = self.pending.partition(b'\n')
+        line = line.decode('ascii', 'replace')
+        if not line.startswith('RESULT'):
+            raise IOError('unexpected response: ' + line)
+        result = parse_result(line)
+        if 'error' in result:
+            raise IOError('device refused request: ' + line)
+        return result
+
+    def close(self):
+        self.sock.close()
+
+
+def test_profile(ctl, args):
+    ctl.command('PROFILE')
+    result = ctl.read_result()
+    print('profile   %s pbuf_pool=%s memp_pbuf=%s mss=%s wnd=%s snd_buf=%s' % (
+        result['name'], result['pbuf_pool'], result['memp_pbuf'],
+        result['mss'], result['wnd'], result['snd_buf']))
+
+
+def test_tcp_tx(ctl, args):
+    # Device transmits, host drains the data before the RESULT line.
+    ctl.command('TCPTX %d' % args.bytes)
+    data = ctl.pending
+    received = len(data)
+    ctl.pending = b''
+    start = time.time()
+    while received < args.bytes:
+        data = ctl.sock.recv(65536)
+        if not data:
+            break
+        received += len(data)
+    elapsed = time.time() - start
+    overshoot = received - args.bytes
+    if overshoot > 0:
+        ctl.pending = data[len(data) - overshoot:]
+    result = ctl.read_result()
+    print('tcp_tx    device=%s kbps host=%d kbps bytes=%s' % (
+        result['kbps'], args.bytes * 8 / 1000 / elapsed if elapsed else 0, result['bytes']))
+
+
+def test_tcp_rx(ctl, args):
+    ctl.command('TCPRX %d' % args.bytes)
+    chunk = b'\xaa' * 1460
+    sent = 0
+    start = time.time()
+    while sent < args.bytes:
+        sent += ctl.sock.send(chunk[:min(len(chunk), args.bytes - sent)])
+    result = ctl.read_result()
+    elapsed = time.time() - start
+    print('tcp_rx    device=%s kbps host=%d kbps bytes=%s' % (
+        result['kbps'], sent * 8 / 1000 / elapsed if elapsed else 0, result['bytes']))
+
+
+def test_rtt(ctl, args):
+    ctl.command('RTT %d %d' % (args.rtt_count, args.rtt_size))
+    ctl.read_result()
+    payload = b'\x5a' * args.rtt_size
+    samples = []
+    for _ in range(args.rtt_count):
+        start = time.time()
+        ctl.sock.sendall(payload)
+        received = 0
+        while received < args.rtt_size:
+            data = ctl.sock.recv(args.rtt_size - received)
+            if not data:
+                raise IOError('device closed connection during RTT test')
+            received += len(data)
+        samples.append((time.time() - start) * 1000000)
+    result = ctl.read_result()
+    samples.sort()
+    print('rtt       count=%s size=%s host_min=%dus host_median=%dus host_p99=%dus device_avg=%sus' % (
+        result['count'], result['size'], samples[0], samples[len(samples) // 2],
+        samples[min(len(samples) - 1, int(len(samples) * 0.99))], result['avg_us']))
+
+
+def test_udp_tx(ctl, args):
+    udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    udp.bind(('', 0))
+    udp.settimeout(1.0)
+    port = udp.getsockname()[1]
+    stats = {'received': 0, 'last_seq': -1, 'reordered': 0}
+
+    def receiver():
+        while True:
+            try:
+                data = udp.recv(2048)
+            except socket.timeout:
+                return
+            stats['received'] += 1
+            seq = struct.unpack('<I', data[:4])[0]
+            if seq < stats['last_seq']:
+                stats['reordered'] += 1
+            stats['last_seq'] = seq
+
+    thread = threading.Thread(target=receiver)
+    thread.start()
+    ctl.command('UDPTX %d %d %d' % (port, args.udp_count, args.udp_size))
+    result = ctl.read_result()
+    thread.join()
+    udp.close()
+    sent = int(result['sent'])
+    print('udp_tx    device=%s pps sent=%d received=%d lost=%d reordered=%d size=%s' % (
+        result['pps'], sent, stats['received'], sent - stats['received'],
+        stats['reordered'], result['size']))
+
+
+def test_udp_rx(ctl, args):
+    # Host transmits as fast as it can, or paced by --udp-gap-us, and the device
+    # counts what made it through its pbuf pool.
+    ctl.command('UDPRX %d %d' % (args.udp_count, args.udp_size))
+    ready = ctl.read_result()
+    target = (ctl.sock.getpeername()[0], int(ready['port']))
+    udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    payload = b'\x55' * (args.udp_size - 4)
+    start = time.time()
+    for seq in range(args.udp_count):
+        udp.sendto(struct.pack('<I', seq) + payload, target)
+        if args.udp_gap_us:
+            time.sleep(args.udp_gap_us / 1000000.0)
+    elapsed = time.time() - start
+    udp.close()
+    result = ctl.read_result()
+    print('udp_rx    device=%s pps host=%d pps sent=%d received=%s lost=%s reordered=%s size=%d' % (
+        result['pps'], args.udp_count / elapsed if elapsed else 0, args.udp_count,
+        result['received'], result['lost'], result['reordered'], args.udp_size))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Host side of the gcc4mbed NetPerf sample.')
+    parser.add_argument('address', help='IP address printed by the device')
+    parser.add_argument('--bytes', type=int, default=1024 * 1024, help='bytes per TCP bulk test')
+    parser.add_argument('--rtt-count', type=int, default=200, help='request/response exchanges')
+    parser.add_argument('--rtt-size', type=int, default=64, help='request/response payload size')
+    parser.add_argument('--udp-count', type=int, default=2000, help='UDP packets to request')
+    parser.add_argument('--udp-size', type=int, default=512, help='UDP payload size')
+    parser.add_argument('--udp-gap-us', type=int, default=0, help='pause between UDP packets sent by the host')
+    args = parser.parse_args()
+
+    ctl = Control(args.address)
+    try:
+        for test in (test_profile, test_tcp_tx, test_tcp_rx, test_rtt, test_udp_tx, test_udp_rx):
+            test(ctl, args)
+    finally:
+        ctl.close()
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,353 @@
+/* Copyright 2017 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Cycle counts for moving bytes through CircularBuffer, which enters a
+   critical section for every call, and SPSCCircularBuffer, which only uses
+   memory barriers. Each is timed a byte at a time and in blocks of
+   BLOCK_SIZE, the way a UART interrupt would hand received data to a thread.
+
+   Before timing anything, the buffers are checked for wrapping, overwriting
+   and partial block operations, and then stressed with a Ticker handler
+   pushing bursts of increasing values while main() pops them, to check that
+   every value comes out once and in order. On HOST_SIM the handler runs on
+   its own host thread, so producer and consumer really do run at the same
+   time. Build that with make HOST_SIM and run HOST_SIM/RingBench.elf.
+
+   Each test prints a single line of key=value pairs:
+       RESULT test=<name> pass=<0|1>
+       RESULT test=<name> elements=<count> cycles=<total> cycles_per_element=<rate>
+   and the process exits with the number of checks which failed. Cycles are
+   counted by the DWT cycle counter, so the rate is exact for the core clock
+   whatever it is. HOST_SIM has no DWT and counts nanoseconds instead.
+*/
+#include <mbed.h>
+#include "cmsis.h"
+#include "CircularBuffer.h"
+#include "SPSCCircularBuffer.h"
+
+#if defined(TARGET_HOST_SIM)
+#include <time.h>
+#endif
+
+
+#define BUFFER_SIZE         256
+#define BLOCK_SIZE          32
+#define ELEMENT_COUNT       (64 * 1024)
+
+// Odd sizes so that blocks wrap part way through.
+#define CHECK_BUFFER_SIZE   61
+#define CHECK_BLOCK_SIZE    17
+#define STRESS_COUNT        (100 * 1000)
+#define STRESS_TICK_US      20
+
+#define CHECK(X) \
+    do \
+    { \
+        if (!(X)) \
+        { \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #X); \
+            g_checkFailures++; \
+        } \
+    } while (0)
+
+
+static CircularBuffer<uint8_t, BUFFER_SIZE>     g_circularBuffer;
+static SPSCCircularBuffer<uint8_t, BUFFER_SIZE> g_spscBuffer;
+static uint8_t                                  g_block[BLOCK_SIZE];
+static volatile uint32_t                        g_checksum;
+static int                                      g_checkFailures;
+static int                                      g_failures;
+
+
+#if defined(TARGET_HOST_SIM)
+static void startCycleCounter()
+{
+}
+
+static uint32_t readCycleCounter()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000000 + now.tv_nsec);
+}
+#else
+static void startCycleCounter()
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static uint32_t readCycleCounter()
+{
+    return DWT->CYCCNT;
+}
+#endif
+
+static void printResult(const char* pTest, uint32_t elements, uint32_t cycles)
+{
+    printf("RESULT test=%s elements=%lu cycles=%lu cycles_per_element=%lu\n",
+           pTest, (unsigned long)elements, (unsigned long)cycles, (unsigned long)(cycles / elements));
+}
+
+static void printCheckResult(const char* pTest)
+{
+    printf("RESULT test=%s pass=%d\n", pTest, g_checkFailures == 0 ? 1 : 0);
+    g_failures += g_checkFailures;
+    g_checkFailures = 0;
+}
+
+
+static void checkCircularBuffer()
+{
+    CircularBuffer<uint32_t, CHECK_BUFFER_SIZE> buffer;
+    uint32_t                                    block[CHECK_BUFFER_SIZE * 2];
+    uint32_t                                    value;
+
+    for (uint32_t i = 0 ; i < sizeof(block) / sizeof(block[0]) ; i++)
+    {
+        block[i] = i;
+    }
+
+    // Blocks wrap around the end of the pool
+    for (uint32_t round = 0 ; round < 10 ; round++)
+    {
+        buffer.push(block, CHECK_BLOCK_SIZE);
+        CHECK(buffer.size() == CHECK_BLOCK_SIZE);
+        CHECK(buffer.pop(&block[CHECK_BUFFER_SIZE], CHECK_BUFFER_SIZE) == CHECK_BLOCK_SIZE);
+        for (uint32_t i = 0 ; i < CHECK_BLOCK_SIZE ; i++)
+        {
+            CHECK(block[CHECK_BUFFER_SIZE + i] == i);
+            block[CHECK_BUFFER_SIZE + i] = CHECK_BUFFER_SIZE + i;
+        }
+        CHECK(buffer.empty());
+    }
+
+    // Overflowing keeps the newest values
+    buffer.push(block, CHECK_BUFFER_SIZE - 3);
+    buffer.push(&block[100], 10);
+    CHECK(buffer.full());
+    CHECK(buffer.size() == CHECK_BUFFER_SIZE);
+    CHECK(buffer.pop(value) && value == 7);
+    CHECK(buffer.pop(block, CHECK_BUFFER_SIZE) == CHECK_BUFFER_SIZE - 1);
+    CHECK(block[CHECK_BUFFER_SIZE - 11] == 100 && block[CHECK_BUFFER_SIZE - 2] == 109);
+
+    for (uint32_t i = 0 ; i < sizeof(block) / sizeof(block[0]) ; i++)
+    {
+        block[i] = i;
+    }
+    buffer.push(block, sizeof(block) / sizeof(block[0]));
+    CHECK(buffer.full());
+    CHECK(buffer.pop(value) && value == CHECK_BUFFER_SIZE);
+    buffer.reset();
+    CHECK(buffer.empty() && !buffer.pop(value));
+
+    printCheckResult("circular_check");
+}
+
+static void checkSPSCCircularBuffer()
+{
+    SPSCCircularBuffer<uint32_t, CHECK_BUFFER_SIZE, uint8_t> buffer;
+    uint32_t                                                 block[CHECK_BUFFER_SIZE * 2];
+    uint32_t                                                 value;
+
+    for (uint32_t i = 0 ; i < sizeof(block) / sizeof(block[0]) ; i++)
+    {
+        block[i] = i;
+    }
+
+    for (uint32_t round = 0 ; round < 10 ; round++)
+    {
+        CHECK(buffer.push(block, CHECK_BLOCK_SIZE) == CHECK_BLOCK_SIZE);
+        CHECK(buffer.size() == CHECK_BLOCK_SIZE);
+        CHECK(buffer.pop(&block[CHECK_BUFFER_SIZE], CHECK_BUFFER_SIZE) == CHECK_BLOCK_SIZE);
+        for (uint32_t i = 0 ; i < CHECK_BLOCK_SIZE ; i++)
+        {
+            CHECK(block[CHECK_BUFFER_SIZE + i] == i);
+        }
+        CHECK(buffer.empty());
+    }
+
+    // A full buffer refuses more rather than overwriting
+    CHECK(buffer.push(block, CHECK_BUFFER_SIZE - 3) == CHECK_BUFFER_SIZE - 3);
+    CHECK(buffer.push(&block[100], 10) == 3);
+    CHECK(buffer.full());
+    CHECK(!buffer.push(block[0]));
+    CHECK(buffer.pop(value) && value == 0);
+    CHECK(buffer.push(block[5]));
+    CHECK(buffer.pop(block, CHECK_BUFFER_SIZE * 2) == CHECK_BUFFER_SIZE);
+    CHECK(block[CHECK_BUFFER_SIZE - 4] == 100 && block[CHECK_BUFFER_SIZE - 2] == 102 && block[CHECK_BUFFER_SIZE - 1] == 5);
+    CHECK(buffer.empty() && !buffer.pop(value));
+
+    printCheckResult("spsc_check");
+}
+
+
+template<class Buffer>
+class StressTest
+{
+public:
+    StressTest() : m_next(0), m_seed(1)
+    {
+    }
+
+    // Pops until every value has been pushed and popped, checking that each
+    // one follows the last, while produce() runs from a Ticker.
+    uint32_t run()
+    {
+        Ticker   ticker;
+        uint32_t block[CHECK_BLOCK_SIZE];
+        uint32_t expected = 0;
+        uint32_t errors = 0;
+        uint32_t seed = 2;
+
+        ticker.attach_us(callback(this, &StressTest<Buffer>::produce), STRESS_TICK_US);
+        while (m_next < STRESS_COUNT || !m_buffer.empty())
+        {
+            seed = seed * 1103515245 + 12345;
+            uint32_t count = (seed >> 16) % CHECK_BLOCK_SIZE + 1;
+
+            if (count == 1)
+            {
+                uint32_t value;
+                if (m_buffer.pop(value))
+                {
+                    errors += (value != expected);
+                    expected = value + 1;
+                }
+            }
+            else
+            {
+                count = m_buffer.pop(block, count);
+                for (uint32_t i = 0 ; i < count ; i++)
+                {
+                    errors += (block[i] != expected);
+                    expected = block[i] + 1;
+                }
+            }
+        }
+        ticker.detach();
+
+        return errors + (expected != STRESS_COUNT);
+    }
+
+protected:
+    // Pushes the next burst of up to CHECK_BLOCK_SIZE values, as one block or
+    // a single push, without ever overwriting.
+    void produce()
+    {
+        uint32_t block[CHECK_BLOCK_SIZE];
+        uint32_t next = m_next;
+
+        m_seed = m_seed * 1103515245 + 12345;
+        uint32_t count = (m_seed >> 16) % CHECK_BLOCK_SIZE + 1;
+        if (count > STRESS_COUNT - next)
+        {
+            count = STRESS_COUNT - next;
+        }
+        uint32_t space = CHECK_BUFFER_SIZE - m_buffer.size();
+        if (count > space)
+        {
+            count = space;
+        }
+
+        if (count == 1)
+        {
+            m_buffer.push(next);
+        }
+        else if (count > 1)
+        {
+            for (uint32_t i = 0 ; i < count ; i++)
+            {
+                block[i] = next + i;
+            }
+            m_buffer.push(block, count);
+        }
+        m_next = next + count;
+    }
+
+    Buffer            m_buffer;
+    volatile uint32_t m_next;
+    uint32_t          m_seed;
+};
+
+template<class Buffer>
+static void stressBuffer(const char* pTest)
+{
+    StressTest<Buffer> test;
+
+    CHECK(test.run() == 0);
+    printCheckResult(pTest);
+}
+
+
+template<class Buffer>
+static void benchSingle(Buffer* pBuffer, const char* pTest)
+{
+    uint32_t checksum = 0;
+    uint8_t  value = 0;
+
+    uint32_t start = readCycleCounter();
+    for (uint32_t i = 0 ; i < ELEMENT_COUNT ; i++)
+    {
+        pBuffer->push((uint8_t)i);
+        pBuffer->pop(value);
+        checksum += value;
+    }
+    uint32_t cycles = readCycleCounter() - start;
+
+    g_checksum = checksum;
+    printResult(pTest, ELEMENT_COUNT, cycles);
+}
+
+template<class Buffer>
+static void benchBlock(Buffer* pBuffer, const char* pTest)
+{
+    uint32_t checksum = 0;
+
+    uint32_t start = readCycleCounter();
+    for (uint32_t i = 0 ; i < ELEMENT_COUNT ; i += BLOCK_SIZE)
+    {
+        g_block[0] = (uint8_t)i;
+        pBuffer->push(g_block, BLOCK_SIZE);
+        pBuffer->pop(g_block, BLOCK_SIZE);
+        checksum += g_block[0];
+    }
+    uint32_t cycles = readCycleCounter() - start;
+
+    g_checksum = checksum;
+    printResult(pTest, ELEMENT_COUNT, cycles);
+}
+
+
+int main()
+{
+    printf("RingBench: %u byte buffers, blocks of %u bytes, %u bytes per test\n",
+           BUFFER_SIZE, BLOCK_SIZE, ELEMENT_COUNT);
+
+    checkCircularBuffer();
+    checkSPSCCircularBuffer();
+    stressBuffer<CircularBuffer<uint32_t, CHECK_BUFFER_SIZE> >("circular_stress");
+    stressBuffer<SPSCCircularBuffer<uint32_t, CHECK_BUFFER_SIZE> >("spsc_stress");
+    stressBuffer<SPSCCircularBuffer<uint32_t, CHECK_BUFFER_SIZE, uint8_t> >("spsc_uint8_stress");
+
+    startCycleCounter();
+    benchSingle(&g_circularBuffer, "circular_single");
+    benchSingle(&g_spscBuffer, "spsc_single");
+    benchBlock(&g_circularBuffer, "circular_block");
+    benchBlock(&g_spscBuffer, "spsc_block");
+
+    printf("RingBench complete\n");
+    return g_failures;
+}
@@ -485,9 +485,7 @@ int SDBlockDevice::_read(uint8_t *buffer, uint32_t length) {
     while (_spi.write(0xFF) != 0xFE);
 
     // read data
-    for (uint32_t i = 0; i < length; i++) {
-        buffer[i] = _spi.write(0xFF);
-    }
+    _spi.write(NULL, 0, (char*)buffer, length);
     _spi.write(0xFF); // checksum
     _spi.write(0xFF);
 
@@ -505,9 +503,7 @@ int SDBlockDevice::_write(const uint8_t*buffer, uint32_t length) {
     _spi.write(0xFE);
 
     // write the data
-    for (uint32_t i = 0; i < length; i++) {
-        _spi.write(buffer[i]);
-    }
+    _spi.write((const char*)buffer, length, NULL, 0);
 
     // write the checksum
     _spi.write(0xFF);
@@ -0,0 +1,337 @@
+/* Copyright 2017 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Checks of FEATURE_STORAGE against the simulated NOR flash of the HOST_SIM
+   storage driver, which counts the bytes programmed and erased. It runs with
+   HOST_SIM/StorageBench.elf.
+
+   cfstore is built with its record log backend on HOST_SIM, where Flush()
+   only writes the KVs changed since the previous flush. KV_COUNT KVs are
+   created and flushed, then one of them is written and flushed, then
+   FLUSH_COUNT flushes each write one KV, which is enough to compact the log.
+   Last of all cfstore is initialised again and every KV checked. It prints:
+       RESULT store=cfstore test=<flush_all|flush_one|flush_run> flushes=<count>
+              program_bytes=<bytes> programs=<count> erase_bytes=<bytes> erases=<count>
+       RESULT store=cfstore test=flush pass=<0|1>
+   It fails if flushing one changed KV programs more than FLUSH_ONE_MAX_BYTES.
+
+   The flash journal's log strategy is checked against power failures. A run
+   of JOURNAL_COMMITS blobs, enough to recycle every sector of the storage
+   twice, is cut short at every JOURNAL_CUT_STRIDE'th program or erase. Then
+   the journal is initialised again, which must find the last blob whose
+   commit returned, and must take new commits. It prints:
+       RESULT store=journal test=power_cut pass=<0|1> cuts=<count> programs=<count> erases=<count>
+   where programs and erases are those of a run without a cut.
+
+   The exit code is 1 if any check fails.
+*/
+#include <mbed.h>
+#include "configuration_store.h"
+#include "flash-journal-strategy-log/flash_journal_strategy_log.h"
+#include "host_sim.h"
+
+
+#define KV_COUNT            40
+#define VALUE_SIZE          16
+#define FLUSH_COUNT         4000
+
+// A PUT record for one KV of VALUE_SIZE bytes plus the COMMIT record
+#define FLUSH_ONE_MAX_BYTES 128
+
+#define JOURNAL_COMMITS     500
+#define JOURNAL_BLOB_MAX    4096
+#define JOURNAL_CHUNK       1000
+#define JOURNAL_CUT_STRIDE  3
+
+
+static bool g_passed = true;
+
+static void checkResult(int32_t result, const char* pOperation)
+{
+    if (result < ARM_DRIVER_OK)
+    {
+        printf("error: %s failed with %d\n", pOperation, (int)result);
+        exit(1);
+    }
+}
+
+static void fail(const char* pMessage, uint32_t value)
+{
+    printf("error: %s (%lu)\n", pMessage, (unsigned long)value);
+    g_passed = false;
+}
+
+static void keyName(char* pKey, size_t keySize, uint32_t index)
+{
+    snprintf(pKey, keySize, "com.arm.storagebench.kv%02lu", (unsigned long)index);
+}
+
+static void fillValue(char* pValue, uint32_t seed)
+{
+    snprintf(pValue, VALUE_SIZE + 1, "value%011lu", (unsigned long)seed);
+}
+
+static void createKV(uint32_t index, uint32_t seed)
+{
+    ARM_CFSTORE_DRIVER* pDriver = &cfstore_driver;
+    ARM_CFSTORE_KEYDESC kdesc;
+    ARM_CFSTORE_SIZE    len = VALUE_SIZE;
+    char                key[CFSTORE_KEY_NAME_MAX_LENGTH + 1];
+    char                value[VALUE_SIZE + 1];
+    ARM_CFSTORE_HANDLE_INIT(hkey);
+
+    memset(&kdesc, 0, sizeof(kdesc));
+    kdesc.drl = ARM_RETENTION_NVM;
+    keyName(key, sizeof(key), index);
+    fillValue(value, seed);
+    checkResult(pDriver->Create(key, len, &kdesc, hkey), "Create");
+    checkResult(pDriver->Write(hkey, value, &len), "Write");
+    checkResult(pDriver->Close(hkey), "Close");
+}
+
+static void writeKV(uint32_t index, uint32_t seed)
+{
+    ARM_CFSTORE_DRIVER* pDriver = &cfstore_driver;
+    ARM_CFSTORE_FMODE   flags;
+    ARM_CFSTORE_SIZE    len = VALUE_SIZE;
+    char                key[CFSTORE_KEY_NAME_MAX_LENGTH + 1];
+    char                value[VALUE_SIZE + 1];
+    ARM_CFSTORE_HANDLE_INIT(hkey);
+
+    memset(&flags, 0, sizeof(flags));
+    flags.write = 1;
+    keyName(key, sizeof(key), index);
+    fillValue(value, seed);
+    checkResult(pDriver->Open(key, flags, hkey), "Open");
+    checkResult(pDriver->Write(hkey, value, &len), "Write");
+    checkResult(pDriver->Close(hkey), "Close");
+}
+
+static bool readKV(uint32_t index, uint32_t seed)
+{
+    ARM_CFSTORE_DRIVER* pDriver = &cfstore_driver;
+    ARM_CFSTORE_FMODE   flags;
+    ARM_CFSTORE_SIZE    len = VALUE_SIZE + 1;
+    char                key[CFSTORE_KEY_NAME_MAX_LENGTH + 1];
+    char                value[VALUE_SIZE + 1];
+    char                expected[VALUE_SIZE + 1];
+    ARM_CFSTORE_HANDLE_INIT(hkey);
+
+    memset(&flags, 0, sizeof(flags));
+    flags.read = 1;
+    keyName(key, sizeof(key), index);
+    fillValue(expected, seed);
+    if (pDriver->Open(key, flags, hkey) < ARM_DRIVER_OK)
+        return false;
+    int32_t result = pDriver->Read(hkey, value, &len);
+    pDriver->Close(hkey);
+    return result == VALUE_SIZE && memcmp(value, expected, VALUE_SIZE) == 0;
+}
+
+static void printFlushResult(const char* pTest, uint32_t flushes)
+{
+    host_sim_storage_stats_t stats;
+
+    host_sim_storage_get_stats(&stats);
+    printf("RESULT store=cfstore test=%s flushes=%lu program_bytes=%llu programs=%lu erase_bytes=%llu erases=%lu\n",
+           pTest, (unsigned long)flushes, (unsigned long long)stats.programmed, (unsigned long)stats.program_ops,
+           (unsigned long long)stats.erased, (unsigned long)stats.erase_ops);
+}
+
+static bool checkFlush()
+{
+    ARM_CFSTORE_DRIVER*      pDriver = &cfstore_driver;
+    uint32_t                 seeds[KV_COUNT];
+    host_sim_storage_stats_t stats;
+
+    g_passed = true;
+    checkResult(pDriver->Initialize(NULL, NULL), "Initialize");
+    for (uint32_t i = 0 ; i < KV_COUNT ; i++)
+    {
+        seeds[i] = i;
+        createKV(i, seeds[i]);
+    }
+    host_sim_storage_reset_stats();
+    checkResult(pDriver->Flush(), "Flush");
+    printFlushResult("flush_all", 1);
+
+    host_sim_storage_reset_stats();
+    seeds[7] = KV_COUNT;
+    writeKV(7, seeds[7]);
+    checkResult(pDriver->Flush(), "Flush");
+    printFlushResult("flush_one", 1);
+    host_sim_storage_get_stats(&stats);
+    if (stats.programmed == 0 || stats.programmed > FLUSH_ONE_MAX_BYTES)
+        fail("flushing one KV programmed the wrong number of bytes", stats.programmed);
+
+    host_sim_storage_reset_stats();
+    for (uint32_t i = 0 ; i < FLUSH_COUNT ; i++)
+    {
+        uint32_t index = (i * 7) % KV_COUNT;
+        seeds[index] = KV_COUNT + 1 + i;
+        writeKV(index, seeds[index]);
+        checkResult(pDriver->Flush(), "Flush");
+    }
+    printFlushResult("flush_run", FLUSH_COUNT);
+    host_sim_storage_get_stats(&stats);
+    if (stats.erase_ops == 0)
+        fail("the log was never compacted", FLUSH_COUNT);
+
+    checkResult(pDriver->Uninitialize(), "Uninitialize");
+    checkResult(pDriver->Initialize(NULL, NULL), "Initialize");
+    for (uint32_t i = 0 ; i < KV_COUNT ; i++)
+    {
+        if (!readKV(i, seeds[i]))
+            fail("KV read back with a wrong value after initialisation", i);
+    }
+    checkResult(pDriver->Uninitialize(), "Uninitialize");
+
+    printf("RESULT store=cfstore test=flush pass=%d\n", g_passed);
+    return g_passed;
+}
+
+
+extern "C" ARM_DRIVER_STORAGE ARM_Driver_Storage_MTD_HOST_SIM;
+
+static FlashJournal_t g_journal;
+static uint8_t        g_blob[JOURNAL_BLOB_MAX];
+static uint8_t        g_readBlob[JOURNAL_BLOB_MAX];
+
+// Multiples of the program unit from 8 bytes to a whole sector
+static size_t blobSize(uint32_t seed)
+{
+    return 8 + (seed * 520) % (JOURNAL_BLOB_MAX - 8);
+}
+
+static void fillBlob(uint8_t* pBlob, uint32_t seed)
+{
+    for (size_t i = 0 ; i < blobSize(seed) ; i++)
+        pBlob[i] = (uint8_t)(seed * 31 + i * 7 + (i >> 8));
+}
+
+static int32_t commitBlob(uint32_t seed)
+{
+    size_t size = blobSize(seed);
+
+    fillBlob(g_blob, seed);
+    for (size_t offset = 0 ; offset < size ; )
+    {
+        size_t  xfer = (size - offset < JOURNAL_CHUNK) ? size - offset : JOURNAL_CHUNK;
+        int32_t result = FlashJournal_log(&g_journal, g_blob + offset, xfer);
+        if (result <= 0)
+            return result < 0 ? result : JOURNAL_STATUS_ERROR;
+        offset += result;
+    }
+    return FlashJournal_commit(&g_journal);
+}
+
+static bool journalHolds(uint32_t seed)
+{
+    FlashJournal_Info_t info;
+    size_t              size = blobSize(seed);
+
+    if (FlashJournal_getInfo(&g_journal, &info) != JOURNAL_STATUS_OK || info.sizeofJournaledBlob != size)
+        return false;
+    fillBlob(g_blob, seed);
+    return FlashJournal_readFrom(&g_journal, 0, g_readBlob, sizeof(g_readBlob)) == (int32_t)size &&
+           memcmp(g_readBlob, g_blob, size) == 0;
+}
+
+static int32_t initializeJournal()
+{
+    return FlashJournal_initialize(&g_journal, &ARM_Driver_Storage_MTD_HOST_SIM, &FLASH_JOURNAL_STRATEGY_LOG, NULL);
+}
+
+// Commits blobs until the power is cut, then checks that the journal
+// initialises with the last committed blob. The COMMIT record is the last
+// thing a commit programs so the blob being committed at the cut is never
+// found. Returns false once the commits finish before the cut.
+static bool checkJournalPowerCut(uint32_t cut, bool* pPassed)
+{
+    uint32_t committed = 0;
+
+    host_sim_storage_restore_power();
+    checkResult(flashJournalStrategyLog_format(&ARM_Driver_Storage_MTD_HOST_SIM, NULL), "flashJournalStrategyLog_format");
+    checkResult(initializeJournal(), "FlashJournal_initialize");
+    checkResult(commitBlob(0), "FlashJournal_commit");
+
+    host_sim_storage_cut_power_after(cut);
+    for (uint32_t seed = 1 ; seed <= JOURNAL_COMMITS ; seed++)
+    {
+        if (commitBlob(seed) != 1)
+            break;
+        committed = seed;
+    }
+    if (host_sim_storage_is_powered())
+        return false;
+
+    host_sim_storage_restore_power();
+    int32_t result = initializeJournal();
+    if (result != 1)
+    {
+        printf("error: cut %lu: FlashJournal_initialize failed with %d\n", (unsigned long)cut, (int)result);
+        *pPassed = false;
+        return true;
+    }
+    if (!journalHolds(committed))
+    {
+        printf("error: cut %lu: journal doesn't hold blob %lu\n", (unsigned long)cut, (unsigned long)committed);
+        *pPassed = false;
+    }
+
+    // The recovered journal must take commits again
+    result = commitBlob(JOURNAL_COMMITS + 1);
+    if (result != 1 || !journalHolds(JOURNAL_COMMITS + 1))
+    {
+        printf("error: cut %lu: commit after recovery failed with %d\n", (unsigned long)cut, (int)result);
+        *pPassed = false;
+    }
+    return true;
+}
+
+static bool checkJournalPowerCuts()
+{
+    host_sim_storage_stats_t stats;
+    bool                     passed = true;
+    uint32_t                 cuts = 0;
+
+    checkResult(ARM_Driver_Storage_MTD_HOST_SIM.Initialize(NULL), "ARM_DRIVER_STORAGE::Initialize");
+    for (uint32_t cut = 0 ; checkJournalPowerCut(cut, &passed) ; cut += JOURNAL_CUT_STRIDE)
+    {
+        cuts++;
+    }
+
+    // The last run committed every blob, count the operations it took
+    host_sim_storage_reset_stats();
+    host_sim_storage_restore_power();
+    checkResult(flashJournalStrategyLog_format(&ARM_Driver_Storage_MTD_HOST_SIM, NULL), "flashJournalStrategyLog_format");
+    checkResult(initializeJournal(), "FlashJournal_initialize");
+    for (uint32_t seed = 0 ; seed <= JOURNAL_COMMITS ; seed++)
+        checkResult(commitBlob(seed), "FlashJournal_commit");
+    host_sim_storage_get_stats(&stats);
+
+    printf("RESULT store=journal test=power_cut pass=%d cuts=%lu programs=%lu erases=%lu\n",
+           passed, (unsigned long)cuts, (unsigned long)stats.program_ops, (unsigned long)stats.erase_ops);
+    return passed;
+}
+
+
+int main()
+{
+    bool passed = checkFlush();
+    passed = checkJournalPowerCuts() && passed;
+
+    printf("StorageBench complete\n");
+    return passed ? 0 : 1;
+}
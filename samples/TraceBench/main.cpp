@@ -0,0 +1,120 @@
+/* Copyright 2017 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Cycles spent inside tr_debug() by the thread making the call. With the
+   default build mbed-trace's binary backend is enabled and each call only
+   copies its arguments into a RAM ring, the text being produced afterwards on
+   the host by trace_decode.py. Build with "make TRACE_BINARY=0" to time the
+   existing path which formats every trace with vsnprintf() before handing it
+   to the print function. The print function is a stub here in that mode so
+   that the serial port isn't part of what is measured.
+
+   Each test prints a single line of key=value pairs:
+       RESULT mode=<binary|text> test=<name> samples=<count> min=<cycles> avg=<cycles> max=<cycles>
+   In binary mode the recorded traces are then drained to stdout as packets
+   which can be decoded with:
+       python trace_decode.py <serial capture> LPC1768/TraceBench.elf
+*/
+#include <mbed.h>
+#include "cmsis.h"
+#include "mbed-trace/mbed_trace.h"
+
+
+#define TRACE_GROUP     "bnch"
+#define SAMPLE_COUNT    64
+
+#if MBED_CONF_MBED_TRACE_BINARY
+#define TRACE_MODE      "binary"
+#else
+#define TRACE_MODE      "text"
+#endif
+
+
+static void startCycleCounter()
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static uint32_t readCycleCounter()
+{
+    return DWT->CYCCNT;
+}
+
+static void nullPrint(const char* pString)
+{
+    (void)pString;
+}
+
+static uint32_t traceInt(int i)
+{
+    uint32_t start = readCycleCounter();
+    tr_debug("sample %d", i);
+    return readCycleCounter() - start;
+}
+
+static uint32_t traceMixed(int i)
+{
+    uint32_t start = readCycleCounter();
+    tr_debug("%s: sample %d of %u, status 0x%08lX", "sensor-0", i, SAMPLE_COUNT, (unsigned long)i * 0x01010101UL);
+    return readCycleCounter() - start;
+}
+
+static void bench(const char* pTest, uint32_t (*pTrace)(int))
+{
+    uint32_t minCycles = ~0UL;
+    uint32_t maxCycles = 0;
+    uint32_t totalCycles = 0;
+
+    for (int i = 0 ; i < SAMPLE_COUNT ; i++)
+    {
+        uint32_t cycles = pTrace(i);
+        if (cycles < minCycles)
+        {
+            minCycles = cycles;
+        }
+        if (cycles > maxCycles)
+        {
+            maxCycles = cycles;
+        }
+        totalCycles += cycles;
+    }
+
+    printf("RESULT mode=%s test=%s samples=%u min=%lu avg=%lu max=%lu\n",
+           TRACE_MODE, pTest, SAMPLE_COUNT, (unsigned long)minCycles,
+           (unsigned long)(totalCycles / SAMPLE_COUNT), (unsigned long)maxCycles);
+#if MBED_CONF_MBED_TRACE_BINARY
+    fflush(stdout);
+    mbed_trace_binary_drain(stdout);
+    fflush(stdout);
+    printf("\n");
+#endif
+}
+
+
+int main()
+{
+    printf("TraceBench: %s traces, %u samples per test\n", TRACE_MODE, SAMPLE_COUNT);
+    mbed_trace_init();
+    mbed_trace_print_function_set(nullPrint);
+    startCycleCounter();
+
+    bench("int", traceInt);
+    bench("mixed", traceMixed);
+
+    mbed_trace_free();
+    printf("TraceBench complete\n");
+    return 0;
+}
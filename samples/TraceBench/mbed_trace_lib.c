@@ -0,0 +1,18 @@
+/* Copyright 2017 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* mbed-trace is under FEATURE_COMMON_PAL which isn't part of the mbed-os libraries built for these devices so
+   pull its sources into this project. They are built with the DEFINES from the Makefile. */
+#include "source/mbed_trace.c"
+#include "source/mbed_trace_binary.c"
@@ -0,0 +1,218 @@
+#!/usr/bin/env python
+# Copyright 2017 Adam Green (http://mbed.org/users/AdamGreen/)
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Decoder for mbed_trace_binary_drain() output.
+
+Finds the trace packets in a capture, which may be a serial log with text
+around them or a file written over semihosting, and prints each trace the way
+mbed-trace would have, with the record's timestamp in front:
+
+    [<seconds>][DBG ][<group>]: <message>
+
+The format strings and group names are read from the .elf the traces came
+from, which must be the exact image that ran.
+
+    python trace_decode.py <capture> <elf>
+"""
+import argparse
+import re
+import struct
+import sys
+
+PACKET_MAGIC = 0x3142544D
+RECORD_MARK = 0xB5
+RECORD_TRUNCATED = 0x8000
+HEADER_WORDS = 4
+
+LEVELS = {0x10: 'DBG ', 0x08: 'INFO', 0x04: 'WARN', 0x02: 'ERR ', 0x01: 'CMD '}
+
+CONVERSION = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l|L|j|z|t)?([diuxXocfFeEgGaAspn%])')
+
+
+class Image(object):
+    """Loaded sections of an ELF file, enough to read strings by address."""
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        if self.data[:4] != b'\x7fELF' or self.data[5:6] != b'\x01':
+            raise ValueError('%s is not a little endian ELF file' % path)
+        if self.data[4:5] == b'\x01':
+            shoff, = struct.unpack_from('<I', self.data, 0x20)
+            shentsize, shnum = struct.unpack_from('<HH', self.data, 0x2E)
+            section = struct.Struct('<IIIIIIIIII')
+        else:
+            shoff, = struct.unpack_from('<Q', self.data, 0x28)
+            shentsize, shnum = struct.unpack_from('<HH', self.data, 0x3A)
+            section = struct.Struct('<IIQQQQIIQQ')
+        self.sections = []
+        for i in range(shnum):
+            fields = section.unpack_from(self.data, shoff + i * shentsize)
+            kind, flags, addr, offset, size = fields[1], fields[2], fields[3], fields[4], fields[5]
+            # Allocated and stored in the file, so not .bss
+            if flags & 0x2 and kind != 8 and size:
+                self.sections.append((addr, offset, size))
+
+    def string(self, address):
+        for addr, offset, size in self.sections:
+            if addr <= address < addr + size:
+                start = offset + address - addr
+                end = self.data.find(b'\0', start, offset + size)
+                if end < 0:
+                    end = offset + size
+                return self.data[start:end].decode('latin-1')
+        return '<0x%08x?>' % address
+
+
+def read_packets(data):
+    """Returns a list of (dropped, words) for each packet with a good checksum,
+    and the number which were cut short or damaged."""
+    magic = struct.pack('<I', PACKET_MAGIC)
+    packets = []
+    bad = 0
+    offset = data.find(magic)
+    while offset >= 0:
+        if offset + 16 > len(data):
+            bad += 1
+            break
+        _, count, dropped, checksum = struct.unpack_from('<IIII', data, offset)
+        end = offset + 16 + 4 * count
+        if end > len(data):
+            bad += 1
+            break
+        words = list(struct.unpack_from('<%dI' % count, data, offset + 16))
+        if sum(words) & 0xFFFFFFFF == checksum:
+            packets.append((dropped, words))
+            offset = data.find(magic, end)
+        else:
+            bad += 1
+            offset = data.find(magic, offset + 1)
+    return packets, bad
+
+
+class Args(object):
+    def __init__(self, words):
+        self.words = words
+        self.pos = 0
+
+    def word(self):
+        if self.pos >= len(self.words):
+            raise IndexError
+        self.pos += 1
+        return self.words[self.pos - 1]
+
+    def signed(self):
+        value = self.word()
+        return value - (1 << 32) if value & 0x80000000 else value
+
+    def long_long(self, signed):
+        value = self.word() | (self.word() << 32)
+        if signed and value & (1 << 63):
+            value -= 1 << 64
+        return value
+
+    def double(self):
+        return struct.unpack('<d', struct.pack('<II', self.word(), self.word()))[0]
+
+    def string(self):
+        length = self.word()
+        count = (length + 3) // 4
+        data = struct.pack('<%dI' % count, *[self.word() for _ in range(count)])
+        return data[:length].decode('latin-1')
+
+
+def format_trace(fmt, args):
+    """printf() the record's arguments into fmt, taking them from the record in
+    the same order and sizes as the device stored them."""
+    out = []
+    last = 0
+    for match in CONVERSION.finditer(fmt):
+        out.append(fmt[last:match.start()])
+        last = match.end()
+        flags, width, precision, length, conversion = match.groups()
+        if conversion == '%':
+            out.append('%')
+            continue
+        try:
+            if width == '*':
+                width = str(args.signed())
+            if precision == '*':
+                precision = str(args.signed())
+            spec = '%' + flags + (width or '') + ('.' + precision if precision is not None else '')
+            wide = length in ('ll', 'j')
+            if conversion in 'di':
+                out.append((spec + 'd') % (args.long_long(True) if wide else args.signed()))
+            elif conversion in 'uxXo':
+                value = args.long_long(False) if wide else args.word()
+                out.append((spec + ('d' if conversion == 'u' else conversion)) % value)
+            elif conversion == 'c':
+                out.append((spec + 'c') % chr(args.word() & 0xFF))
+            elif conversion in 'fFeEgGaA':
+                out.append((spec + {'a': 'e', 'A': 'E', 'F': 'f'}.get(conversion, conversion)) % args.double())
+            elif conversion == 's':
+                out.append((spec + 's') % args.string())
+            elif conversion == 'p':
+                out.append((spec + 's') % ('0x%x' % args.word()))
+            else:
+                args.word()
+        except IndexError:
+            out.append('<missing>')
+            last = len(fmt)
+            break
+    out.append(fmt[last:])
+    return ''.join(out)
+
+
+def decode(words, image):
+    pos = 0
+    while pos < len(words):
+        header = words[pos]
+        length = header & 0x7FFF
+        if header >> 24 != RECORD_MARK or length < HEADER_WORDS or pos + length > len(words):
+            yield 'bad record header 0x%08x' % header
+            return
+        level = LEVELS.get((header >> 16) & 0xFF, '    ')
+        timestamp, fmt, grp = words[pos + 1:pos + HEADER_WORDS]
+        text = format_trace(image.string(fmt), Args(words[pos + HEADER_WORDS:pos + length]))
+        if header & RECORD_TRUNCATED:
+            text += ' <truncated>'
+        yield '[%12.6f][%s][%-4s]: %s' % (timestamp / 1e6, level, image.string(grp), text)
+        pos += length
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Turn a binary mbed-trace capture back into text.')
+    parser.add_argument('capture', help='serial capture or semihosted file holding the trace packets')
+    parser.add_argument('elf', help='image the traces came from')
+    args = parser.parse_args()
+
+    image = Image(args.elf)
+    with open(args.capture, 'rb') as f:
+        packets, bad = read_packets(f.read())
+
+    traces = 0
+    dropped = 0
+    for lost, words in packets:
+        for line in decode(words, image):
+            print(line)
+            traces += 1
+        if lost:
+            print('<%d traces dropped>' % lost)
+            dropped += lost
+    sys.stderr.write('trace_decode: %d packets, %d bad, %d traces, %d dropped\n'
+                     % (len(packets), bad, traces, dropped))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
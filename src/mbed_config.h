@@ -17,8 +17,18 @@
 #define MBED_CONF_LWIP_IP_VER_PREF                  4    // set by library:lwip
 #define MBED_CONF_PLATFORM_STDIO_CONVERT_NEWLINES   0    // set by library:platform
 #define MBED_CONF_PLATFORM_STDIO_BAUD_RATE          9600 // set by library:platform
+#define MBED_CONF_PLATFORM_STDIO_BUFFERED_SERIAL    0    // set by library:platform
+#define MBED_CONF_PLATFORM_STDIO_TX_BUFFER_SIZE     256  // set by library:platform
+#define MBED_CONF_PLATFORM_STDIO_TX_OVERFLOW        MBED_STDIO_TX_BLOCK // set by library:platform
+#define MBED_CONF_PLATFORM_TLSF_HEAP                0    // set by library:platform
+#define MBED_CONF_PLATFORM_TLSF_HEAP_GROW_SIZE      4096 // set by library:platform
+#define MBED_CONF_PLATFORM_MEM_TRACE_BUFFER_RECORDS 256  // set by library:platform
+#define MBED_CONF_PLATFORM_CALLBACK_INLINE_SIZE     0    // set by library:platform
 #define MBED_CONF_LWIP_SOCKET_MAX                   4    // set by library:lwip
 #define MBED_CONF_LWIP_IPV6_ENABLED                 0    // set by library:lwip
+#define MBED_CONF_LWIP_TCPIP_CORE_LOCKING           1    // set by library:lwip
+#define MBED_CONF_LWIP_MEMORY_PROFILE               LWIP_MEMORY_PROFILE_SMALL // set by library:lwip
+#define MBED_CONF_LWIP_TCPIP_CORE_LOCKING_INPUT     0    // set by library:lwip
 // Macros
 #define UNITY_INCLUDE_CONFIG_H                           // defined by library:utest
 